@@ -18,11 +18,18 @@
 #include "Wolk.h"
 #include "protocol/json/JsonGatewayDataProtocol.h"
 #include "utilities/ConsoleLogger.h"
+#include "utilities/ReconnectScheduler.h"
 #include "utilities/StringUtils.h"
+#include "utilities/Tracer.h"
 
 #include <chrono>
+#include <cstdint>
+#include <csignal>
+#include <ctime>
+#include <exception>
 #include <stdexcept>
 #include <string>
+#include <sys/stat.h>
 #include <thread>
 
 namespace
@@ -54,6 +61,173 @@ wolkabout::LogLevel parseLogLevel(const std::string& levelStr)
 
     return logLevel;
 }
+
+const std::chrono::seconds CONFIGURATION_POLL_INTERVAL{1};
+
+const std::string EMBEDDED_BROKER_SCHEME = "embedded://";
+
+// "embedded://<address>:<port>" runs local broker inside gateway
+bool parseEmbeddedBrokerUri(const std::string& uri, std::string& address, std::uint16_t& port)
+{
+    if (!wolkabout::StringUtils::startsWith(uri, EMBEDDED_BROKER_SCHEME))
+    {
+        return false;
+    }
+
+    const std::string hostAndPort = uri.substr(EMBEDDED_BROKER_SCHEME.size());
+    const auto separator = hostAndPort.rfind(':');
+    address = hostAndPort.substr(0, separator);
+    port = 1883;
+    if (separator != std::string::npos)
+    {
+        try
+        {
+            port = static_cast<std::uint16_t>(std::stoul(hostAndPort.substr(separator + 1)));
+        }
+        catch (std::logic_error&)
+        {
+            LOG(ERROR) << "WolkGateway Application: Invalid port of embedded broker in '" << uri << "'";
+            return false;
+        }
+    }
+    if (address == "localhost")
+    {
+        address = "127.0.0.1";
+    }
+
+    return true;
+}
+
+volatile std::sig_atomic_t traceDumpRequested = 0;
+
+void requestTraceDump(int)
+{
+    traceDumpRequested = 1;
+}
+
+void applyTracing(const wolkabout::GatewayConfiguration& configuration)
+{
+    if (configuration.hasTracing())
+    {
+        wolkabout::Tracer::getInstance().configure(configuration.getTracingSampleOneIn(),
+                                                   configuration.getTracingCapacity());
+    }
+    else
+    {
+        wolkabout::Tracer::getInstance().configure(0);
+    }
+}
+
+std::time_t modificationTime(const std::string& path)
+{
+    struct stat st;
+    if (path.empty() || stat(path.c_str(), &st) != 0)
+    {
+        return 0;
+    }
+
+    return st.st_mtime;
+}
+
+void applyLogLevel(const wolkabout::GatewayConfiguration& configuration)
+{
+    if (!configuration.getLogLevel())
+    {
+        return;
+    }
+
+    try
+    {
+        wolkabout::Logger::getInstance()->setLogLevel(parseLogLevel(configuration.getLogLevel().value()));
+    }
+    catch (std::logic_error& e)
+    {
+        LOG(ERROR) << "WolkGateway Application: " << e.what();
+    }
+}
+
+bool requiresRestart(const wolkabout::GatewayConfiguration& current, const wolkabout::GatewayConfiguration& updated)
+{
+    const auto trustStore = [](const wolkabout::GatewayConfiguration& configuration) {
+        return configuration.getPlatformTrustStore() ? configuration.getPlatformTrustStore().value() : "";
+    };
+    const auto localSocket = [](const wolkabout::GatewayConfiguration& configuration) {
+        return configuration.getLocalSocket() ? configuration.getLocalSocket().value() : "";
+    };
+    const auto trafficCapture = [](const wolkabout::GatewayConfiguration& configuration) {
+        return configuration.getTrafficCaptureFile() ? configuration.getTrafficCaptureFile().value() : "";
+    };
+    const auto shard = [](const wolkabout::GatewayConfiguration& configuration) {
+        return std::to_string(configuration.getShardIndex()) + "/" + std::to_string(configuration.getShardCount()) +
+               (configuration.isShardRouted() ? "/routed/" : "/") + configuration.getShardStorageDirectory();
+    };
+
+    return current.getKey() != updated.getKey() || current.getPassword() != updated.getPassword() ||
+           current.getPlatformMqttUri() != updated.getPlatformMqttUri() ||
+           current.getLocalMqttUri() != updated.getLocalMqttUri() ||
+           current.getSubdeviceManagement() != updated.getSubdeviceManagement() ||
+           trustStore(current) != trustStore(updated) || localSocket(current) != localSocket(updated) ||
+           trafficCapture(current) != trafficCapture(updated) ||
+           current.hasShard() != updated.hasShard() || shard(current) != shard(updated) ||
+           current.hasSubdeviceRateLimit() != updated.hasSubdeviceRateLimit() ||
+           current.hasReadingDeadband() != updated.hasReadingDeadband() ||
+           current.getReadingDeadbandPercentOfRange() < updated.getReadingDeadbandPercentOfRange() ||
+           current.getReadingDeadbandPercentOfRange() > updated.getReadingDeadbandPercentOfRange() ||
+           current.getReadingDeadbandMaxSilence() != updated.getReadingDeadbandMaxSilence();
+}
+
+// applies settings which can change while gateway is running, the rest is picked up on restart
+void applyConfiguration(wolkabout::Wolk& wolk, const wolkabout::GatewayConfiguration& current,
+                        const wolkabout::GatewayConfiguration& updated, bool applyLogLevelFromFile)
+{
+    if (requiresRestart(current, updated))
+    {
+        LOG(WARN) << "WolkGateway Application: Connection, subdevice management, rate limit or deadband settings "
+                     "changed, restart gateway to apply them";
+    }
+
+    if (applyLogLevelFromFile)
+    {
+        applyLogLevel(updated);
+    }
+
+    if (updated.hasPlatformReconnectBackoff())
+    {
+        wolk.setPlatformReconnectBackoff(updated.getPlatformReconnectInitialDelay(),
+                                         updated.getPlatformReconnectMaximumDelay(),
+                                         updated.getPlatformReconnectStablePeriod());
+    }
+    else if (updated.hasPerformanceProfile())
+    {
+        wolk.setPlatformReconnectBackoff(updated.getPerformanceProfile().reconnectInitialDelay,
+                                         updated.getPerformanceProfile().reconnectMaximumDelay,
+                                         wolkabout::ReconnectScheduler::DEFAULT_STABLE_PERIOD);
+    }
+    else
+    {
+        wolk.setPlatformReconnectBackoff(wolkabout::ReconnectScheduler::DEFAULT_INITIAL_DELAY,
+                                         wolkabout::ReconnectScheduler::DEFAULT_MAXIMUM_DELAY,
+                                         wolkabout::ReconnectScheduler::DEFAULT_STABLE_PERIOD);
+    }
+
+    if (current.hasTracing() != updated.hasTracing() ||
+        current.getTracingSampleOneIn() != updated.getTracingSampleOneIn() ||
+        current.getTracingCapacity() != updated.getTracingCapacity())
+    {
+        applyTracing(updated);
+    }
+
+    if (updated.hasSubdeviceRateLimit())
+    {
+        wolk.setSubdeviceRateLimit(updated.getSubdeviceMessagesPerSecond(), updated.getSubdeviceMessageBurst());
+    }
+
+    if (updated.hasReadingDeadband() && !updated.getReadingDeadbandOverrideFile().empty() &&
+        !wolk.reloadReadingDeadbandOverrides(updated.getReadingDeadbandOverrideFile()))
+    {
+        LOG(ERROR) << "WolkGateway Application: Unable to reload deadband override file, keeping previous overrides";
+    }
+}
 }    // namespace
 
 int main(int argc, char** argv)
@@ -77,6 +251,8 @@ int main(int argc, char** argv)
         return -1;
     }
 
+    applyLogLevel(gatewayConfiguration);
+
     if (argc > 2)
     {
         const std::string logLevelStr{argv[2]};
@@ -97,17 +273,146 @@ int main(int argc, char** argv)
                      .gatewayHost(gatewayConfiguration.getLocalMqttUri())
                      .platformHost(gatewayConfiguration.getPlatformMqttUri());
 
+    // settings configured on their own take precedence over ones from performance profile
+    if (gatewayConfiguration.hasPerformanceProfile())
+    {
+        builder.performanceProfile(gatewayConfiguration.getPerformanceProfile());
+    }
+
+    std::string embeddedBrokerAddress;
+    std::uint16_t embeddedBrokerPort = 0;
+    if (parseEmbeddedBrokerUri(gatewayConfiguration.getLocalMqttUri(), embeddedBrokerAddress, embeddedBrokerPort))
+    {
+        builder.embeddedBroker(embeddedBrokerAddress, embeddedBrokerPort);
+    }
+
+    if (gatewayConfiguration.getLocalSocket())
+    {
+        builder.localSocket(gatewayConfiguration.getLocalSocket().value());
+    }
+
+    if (gatewayConfiguration.hasShard())
+    {
+        builder.shard(gatewayConfiguration.getShardIndex(), gatewayConfiguration.getShardCount(),
+                      gatewayConfiguration.isShardRouted());
+        if (!gatewayConfiguration.getShardStorageDirectory().empty())
+        {
+            builder.storageDirectory(gatewayConfiguration.getShardStorageDirectory());
+        }
+    }
+
     if (gatewayConfiguration.getPlatformTrustStore())
     {
         builder.platformTrustStore(gatewayConfiguration.getPlatformTrustStore().value());
     }
 
+    if (gatewayConfiguration.hasPlatformReconnectBackoff())
+    {
+        builder.platformReconnectBackoff(gatewayConfiguration.getPlatformReconnectInitialDelay(),
+                                         gatewayConfiguration.getPlatformReconnectMaximumDelay(),
+                                         gatewayConfiguration.getPlatformReconnectStablePeriod());
+    }
+
+    if (gatewayConfiguration.hasSubdeviceRateLimit())
+    {
+        builder.subdeviceRateLimit(gatewayConfiguration.getSubdeviceMessagesPerSecond(),
+                                   gatewayConfiguration.getSubdeviceMessageBurst());
+    }
+
+    if (gatewayConfiguration.hasReadingDeadband())
+    {
+        builder.withReadingDeadband(gatewayConfiguration.getReadingDeadbandPercentOfRange(),
+                                    gatewayConfiguration.getReadingDeadbandMaxSilence(),
+                                    gatewayConfiguration.getReadingDeadbandOverrideFile());
+    }
+
+    if (gatewayConfiguration.hasTracing())
+    {
+        builder.traceSampling(gatewayConfiguration.getTracingSampleOneIn(), gatewayConfiguration.getTracingCapacity());
+    }
+
+    if (gatewayConfiguration.getTrafficCaptureFile())
+    {
+        builder.captureTraffic(gatewayConfiguration.getTrafficCaptureFile().value());
+    }
+
     std::unique_ptr<wolkabout::Wolk> wolk = builder.build();
 
+    // spans kept so far are written to trace file on SIGUSR1
+    std::signal(SIGUSR1, requestTraceDump);
+
+    // log level given on command line takes precedence over the one in configuration file
+    const bool applyLogLevelFromFile = argc <= 2;
+    const std::string configurationFile{argv[1]};
+    std::time_t configurationModified = modificationTime(configurationFile);
+    std::time_t overridesModified = modificationTime(gatewayConfiguration.getReadingDeadbandOverrideFile());
+    auto lastPoll = std::chrono::steady_clock::now();
+
     wolk->connect();
     while (true)
     {
         std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+        if (traceDumpRequested)
+        {
+            traceDumpRequested = 0;
+
+            const auto& traceFile = gatewayConfiguration.getTracingFile();
+            if (!gatewayConfiguration.hasTracing())
+            {
+                LOG(WARN) << "WolkGateway Application: Tracing is not enabled, no trace to write";
+            }
+            else if (wolkabout::Tracer::getInstance().dump(traceFile))
+            {
+                LOG(INFO) << "WolkGateway Application: Trace written to '" << traceFile << "'";
+            }
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        if (now - lastPoll < CONFIGURATION_POLL_INTERVAL)
+        {
+            continue;
+        }
+        lastPoll = now;
+
+        const auto modified = modificationTime(configurationFile);
+        if (modified != configurationModified && modified != 0)
+        {
+            configurationModified = modified;
+            try
+            {
+                auto updated = wolkabout::GatewayConfiguration::fromJson(configurationFile);
+                applyConfiguration(*wolk, gatewayConfiguration, updated, applyLogLevelFromFile);
+                gatewayConfiguration = std::move(updated);
+                overridesModified = modificationTime(gatewayConfiguration.getReadingDeadbandOverrideFile());
+
+                LOG(INFO) << "WolkGateway Application: Gateway configuration reloaded";
+            }
+            catch (std::exception& e)
+            {
+                LOG(ERROR) << "WolkGateway Application: Unable to reload gateway configuration file, keeping "
+                              "previous configuration. Reason: "
+                           << e.what();
+            }
+
+            continue;
+        }
+
+        const auto& overrideFile = gatewayConfiguration.getReadingDeadbandOverrideFile();
+        const auto overridesChanged = modificationTime(overrideFile);
+        if (overridesChanged != overridesModified && overridesChanged != 0)
+        {
+            overridesModified = overridesChanged;
+            if (wolk->reloadReadingDeadbandOverrides(overrideFile))
+            {
+                LOG(INFO) << "WolkGateway Application: Deadband overrides reloaded";
+            }
+            else
+            {
+                LOG(ERROR) << "WolkGateway Application: Unable to reload deadband override file, keeping previous "
+                              "overrides";
+            }
+        }
     }
 
     return 0;
@@ -16,12 +16,77 @@
 
 #include "Configuration.h"
 #include "utilities/FileSystemUtils.h"
+#include "utilities/ReconnectScheduler.h"
+#include "utilities/Tracer.h"
 #include "utilities/json.hpp"
 
 #include <algorithm>
 #include <stdexcept>
 #include <utility>
 
+namespace
+{
+using nlohmann::json;
+
+template <class T> void readValue(const json& j, const std::string& key, T& value)
+{
+    if (j.find(key) != j.end())
+    {
+        value = j.at(key).get<T>();
+    }
+}
+
+template <class Duration> void readDuration(const json& j, const std::string& key, Duration& value)
+{
+    if (j.find(key) != j.end())
+    {
+        value = Duration{j.at(key).get<typename Duration::rep>()};
+    }
+}
+
+wolkabout::PerformanceProfile parsePerformanceProfile(const json& j, const std::string& presetKey)
+{
+    wolkabout::PerformanceProfile profile;
+
+    const auto preset = j.value(presetKey, std::string{"default"});
+    if (preset == "constrainedEdge")
+    {
+        profile = wolkabout::PerformanceProfile::constrainedEdge();
+    }
+    else if (preset == "largeFleet")
+    {
+        profile = wolkabout::PerformanceProfile::largeFleet();
+    }
+    else if (preset != "default")
+    {
+        throw std::logic_error("Invalid value for performance preset.");
+    }
+
+    // fields present in configuration override the preset
+    readValue(j, "outboundQueueMaximumMessages", profile.outboundQueueMaximumMessages);
+    readValue(j, "outboundQueueMaximumBytes", profile.outboundQueueMaximumBytes);
+    readValue(j, "publishBatchSize", profile.publishBatchSize);
+    readValue(j, "inboundDeviceMessageWorkers", profile.inboundDeviceMessageWorkers);
+    readDuration(j, "readingAggregationWindowMs", profile.readingAggregationWindow);
+    readValue(j, "readingAggregationMaxReadings", profile.readingAggregationMaxReadings);
+    readDuration(j, "statusUpdateCoalescingWindowMs", profile.statusUpdateCoalescingWindow);
+    readValue(j, "statusPollingBuckets", profile.statusPollingBuckets);
+    readValue(j, "filePacketRequestWindow", profile.filePacketRequestWindow);
+    readValue(j, "concurrentFileTransfers", profile.concurrentFileTransfers);
+    readDuration(j, "keepAliveIntervalSeconds", profile.keepAliveInterval);
+    readDuration(j, "statusResponseTimeoutSeconds", profile.statusResponseTimeout);
+    readValue(j, "registrationRetryCount", profile.registrationRetryCount);
+    readDuration(j, "registrationRetryTimeoutMs", profile.registrationRetryTimeout);
+    readValue(j, "maxFilePacketSize", profile.maxFilePacketSize);
+    readDuration(j, "filePacketRequestTimeoutMs", profile.filePacketRequestTimeout);
+    readDuration(j, "reconnectInitialDelayMs", profile.reconnectInitialDelay);
+    readDuration(j, "reconnectMaximumDelayMs", profile.reconnectMaximumDelay);
+    readValue(j, "memoryBudget", profile.memoryBudget);
+
+    return profile;
+}
+}    // namespace
+
 namespace wolkabout
 {
 using nlohmann::json;
@@ -30,6 +95,31 @@ const std::string GatewayConfiguration::KEY = "key";
 const std::string GatewayConfiguration::PASSWORD = "password";
 const std::string GatewayConfiguration::PLATFORM_URI = "platformMqttUri";
 const std::string GatewayConfiguration::PLATFORM_TRUST_STORE = "platformTrustStore";
+const std::string GatewayConfiguration::PLATFORM_RECONNECT = "platformReconnect";
+const std::string GatewayConfiguration::RECONNECT_INITIAL_DELAY = "initialDelayMs";
+const std::string GatewayConfiguration::RECONNECT_MAXIMUM_DELAY = "maximumDelayMs";
+const std::string GatewayConfiguration::RECONNECT_STABLE_PERIOD = "stablePeriodMs";
+const std::string GatewayConfiguration::LOCAL_SOCKET = "localSocket";
+const std::string GatewayConfiguration::SHARD = "shard";
+const std::string GatewayConfiguration::SHARD_INDEX = "index";
+const std::string GatewayConfiguration::SHARD_COUNT = "count";
+const std::string GatewayConfiguration::SHARD_ROUTED = "routed";
+const std::string GatewayConfiguration::SHARD_STORAGE_DIRECTORY = "storageDirectory";
+const std::string GatewayConfiguration::LOG_LEVEL = "logLevel";
+const std::string GatewayConfiguration::SUBDEVICE_RATE_LIMIT = "subdeviceRateLimit";
+const std::string GatewayConfiguration::RATE_LIMIT_MESSAGES_PER_SECOND = "messagesPerSecond";
+const std::string GatewayConfiguration::RATE_LIMIT_BURST = "burst";
+const std::string GatewayConfiguration::READING_DEADBAND = "readingDeadband";
+const std::string GatewayConfiguration::DEADBAND_PERCENT_OF_RANGE = "percentOfRange";
+const std::string GatewayConfiguration::DEADBAND_MAX_SILENCE = "maxSilenceMs";
+const std::string GatewayConfiguration::DEADBAND_OVERRIDE_FILE = "overrideFile";
+const std::string GatewayConfiguration::PERFORMANCE = "performance";
+const std::string GatewayConfiguration::PERFORMANCE_PRESET = "preset";
+const std::string GatewayConfiguration::TRACING = "tracing";
+const std::string GatewayConfiguration::TRACING_SAMPLE_ONE_IN = "sampleOneIn";
+const std::string GatewayConfiguration::TRACING_CAPACITY = "capacity";
+const std::string GatewayConfiguration::TRACING_FILE = "file";
+const std::string GatewayConfiguration::TRAFFIC_CAPTURE_FILE = "trafficCaptureFile";
 const std::string GatewayConfiguration::LOCAL_URI = "localMqttUri";
 const std::string GatewayConfiguration::SUBDEVICE_MANAGEMENT = "subdeviceManagement";
 
@@ -78,6 +168,196 @@ const WolkOptional<std::string>& GatewayConfiguration::getPlatformTrustStore() c
     return m_platformTrustStore;
 }
 
+void GatewayConfiguration::setPlatformReconnectBackoff(std::chrono::milliseconds initialDelay,
+                                                       std::chrono::milliseconds maximumDelay,
+                                                       std::chrono::milliseconds stablePeriod)
+{
+    m_hasPlatformReconnectBackoff = true;
+    m_platformReconnectInitialDelay = initialDelay;
+    m_platformReconnectMaximumDelay = maximumDelay;
+    m_platformReconnectStablePeriod = stablePeriod;
+}
+
+bool GatewayConfiguration::hasPlatformReconnectBackoff() const
+{
+    return m_hasPlatformReconnectBackoff;
+}
+
+std::chrono::milliseconds GatewayConfiguration::getPlatformReconnectInitialDelay() const
+{
+    return m_platformReconnectInitialDelay;
+}
+
+std::chrono::milliseconds GatewayConfiguration::getPlatformReconnectMaximumDelay() const
+{
+    return m_platformReconnectMaximumDelay;
+}
+
+std::chrono::milliseconds GatewayConfiguration::getPlatformReconnectStablePeriod() const
+{
+    return m_platformReconnectStablePeriod;
+}
+
+void GatewayConfiguration::setLocalSocket(const std::string& value)
+{
+    m_localSocket = value;
+}
+
+const WolkOptional<std::string>& GatewayConfiguration::getLocalSocket() const
+{
+    return m_localSocket;
+}
+
+void GatewayConfiguration::setShard(std::size_t index, std::size_t count, bool routed,
+                                    const std::string& storageDirectory)
+{
+    m_hasShard = true;
+    m_shardIndex = index;
+    m_shardCount = count;
+    m_shardRouted = routed;
+    m_shardStorageDirectory = storageDirectory;
+}
+
+bool GatewayConfiguration::hasShard() const
+{
+    return m_hasShard;
+}
+
+std::size_t GatewayConfiguration::getShardIndex() const
+{
+    return m_shardIndex;
+}
+
+std::size_t GatewayConfiguration::getShardCount() const
+{
+    return m_shardCount;
+}
+
+bool GatewayConfiguration::isShardRouted() const
+{
+    return m_shardRouted;
+}
+
+const std::string& GatewayConfiguration::getShardStorageDirectory() const
+{
+    return m_shardStorageDirectory;
+}
+
+void GatewayConfiguration::setLogLevel(const std::string& value)
+{
+    m_logLevel = value;
+}
+
+const WolkOptional<std::string>& GatewayConfiguration::getLogLevel() const
+{
+    return m_logLevel;
+}
+
+void GatewayConfiguration::setSubdeviceRateLimit(double messagesPerSecond, std::size_t burst)
+{
+    m_hasSubdeviceRateLimit = true;
+    m_subdeviceMessagesPerSecond = messagesPerSecond;
+    m_subdeviceMessageBurst = burst;
+}
+
+bool GatewayConfiguration::hasSubdeviceRateLimit() const
+{
+    return m_hasSubdeviceRateLimit;
+}
+
+double GatewayConfiguration::getSubdeviceMessagesPerSecond() const
+{
+    return m_subdeviceMessagesPerSecond;
+}
+
+std::size_t GatewayConfiguration::getSubdeviceMessageBurst() const
+{
+    return m_subdeviceMessageBurst;
+}
+
+void GatewayConfiguration::setReadingDeadband(double percentOfRange, std::chrono::milliseconds maxSilence,
+                                              const std::string& overrideFile)
+{
+    m_hasReadingDeadband = true;
+    m_readingDeadbandPercentOfRange = percentOfRange;
+    m_readingDeadbandMaxSilence = maxSilence;
+    m_readingDeadbandOverrideFile = overrideFile;
+}
+
+bool GatewayConfiguration::hasReadingDeadband() const
+{
+    return m_hasReadingDeadband;
+}
+
+double GatewayConfiguration::getReadingDeadbandPercentOfRange() const
+{
+    return m_readingDeadbandPercentOfRange;
+}
+
+std::chrono::milliseconds GatewayConfiguration::getReadingDeadbandMaxSilence() const
+{
+    return m_readingDeadbandMaxSilence;
+}
+
+const std::string& GatewayConfiguration::getReadingDeadbandOverrideFile() const
+{
+    return m_readingDeadbandOverrideFile;
+}
+
+void GatewayConfiguration::setPerformanceProfile(const PerformanceProfile& profile)
+{
+    m_hasPerformanceProfile = true;
+    m_performanceProfile = profile;
+}
+
+bool GatewayConfiguration::hasPerformanceProfile() const
+{
+    return m_hasPerformanceProfile;
+}
+
+const PerformanceProfile& GatewayConfiguration::getPerformanceProfile() const
+{
+    return m_performanceProfile;
+}
+
+void GatewayConfiguration::setTracing(std::uint32_t sampleOneIn, std::size_t capacity, const std::string& file)
+{
+    m_hasTracing = true;
+    m_tracingSampleOneIn = sampleOneIn;
+    m_tracingCapacity = capacity;
+    m_tracingFile = file;
+}
+
+bool GatewayConfiguration::hasTracing() const
+{
+    return m_hasTracing;
+}
+
+std::uint32_t GatewayConfiguration::getTracingSampleOneIn() const
+{
+    return m_tracingSampleOneIn;
+}
+
+std::size_t GatewayConfiguration::getTracingCapacity() const
+{
+    return m_tracingCapacity;
+}
+
+const std::string& GatewayConfiguration::getTracingFile() const
+{
+    return m_tracingFile;
+}
+
+void GatewayConfiguration::setTrafficCaptureFile(const std::string& value)
+{
+    m_trafficCaptureFile = value;
+}
+
+const WolkOptional<std::string>& GatewayConfiguration::getTrafficCaptureFile() const
+{
+    return m_trafficCaptureFile;
+}
+
 wolkabout::GatewayConfiguration GatewayConfiguration::fromJson(const std::string& gatewayConfigurationFile)
 {
     if (!FileSystemUtils::isFilePresent(gatewayConfigurationFile))
@@ -122,6 +402,68 @@ wolkabout::GatewayConfiguration GatewayConfiguration::fromJson(const std::string
         configuration.setPlatformTrustStore(j.at(PLATFORM_TRUST_STORE).get<std::string>());
     }
 
+    if (j.find(PLATFORM_RECONNECT) != j.end())
+    {
+        const auto reconnect = j.at(PLATFORM_RECONNECT);
+        configuration.setPlatformReconnectBackoff(
+          std::chrono::milliseconds{reconnect.value(RECONNECT_INITIAL_DELAY,
+                                                    ReconnectScheduler::DEFAULT_INITIAL_DELAY.count())},
+          std::chrono::milliseconds{reconnect.value(RECONNECT_MAXIMUM_DELAY,
+                                                    ReconnectScheduler::DEFAULT_MAXIMUM_DELAY.count())},
+          std::chrono::milliseconds{reconnect.value(RECONNECT_STABLE_PERIOD,
+                                                    ReconnectScheduler::DEFAULT_STABLE_PERIOD.count())});
+    }
+
+    if (j.find(LOCAL_SOCKET) != j.end())
+    {
+        configuration.setLocalSocket(j.at(LOCAL_SOCKET).get<std::string>());
+    }
+
+    if (j.find(SHARD) != j.end())
+    {
+        const auto shard = j.at(SHARD);
+        configuration.setShard(shard.at(SHARD_INDEX).get<std::size_t>(), shard.at(SHARD_COUNT).get<std::size_t>(),
+                               shard.value(SHARD_ROUTED, true), shard.value(SHARD_STORAGE_DIRECTORY, std::string{}));
+    }
+
+    if (j.find(LOG_LEVEL) != j.end())
+    {
+        configuration.setLogLevel(j.at(LOG_LEVEL).get<std::string>());
+    }
+
+    if (j.find(SUBDEVICE_RATE_LIMIT) != j.end())
+    {
+        const auto rateLimit = j.at(SUBDEVICE_RATE_LIMIT);
+        configuration.setSubdeviceRateLimit(rateLimit.at(RATE_LIMIT_MESSAGES_PER_SECOND).get<double>(),
+                                            rateLimit.value(RATE_LIMIT_BURST, std::size_t{100}));
+    }
+
+    if (j.find(READING_DEADBAND) != j.end())
+    {
+        const auto deadband = j.at(READING_DEADBAND);
+        configuration.setReadingDeadband(deadband.at(DEADBAND_PERCENT_OF_RANGE).get<double>(),
+                                         std::chrono::milliseconds{deadband.value(DEADBAND_MAX_SILENCE, 60000)},
+                                         deadband.value(DEADBAND_OVERRIDE_FILE, std::string{}));
+    }
+
+    if (j.find(PERFORMANCE) != j.end())
+    {
+        configuration.setPerformanceProfile(parsePerformanceProfile(j.at(PERFORMANCE), PERFORMANCE_PRESET));
+    }
+
+    if (j.find(TRACING) != j.end())
+    {
+        const auto tracing = j.at(TRACING);
+        configuration.setTracing(tracing.at(TRACING_SAMPLE_ONE_IN).get<std::uint32_t>(),
+                                 tracing.value(TRACING_CAPACITY, Tracer::DEFAULT_CAPACITY),
+                                 tracing.value(TRACING_FILE, std::string{"trace.json"}));
+    }
+
+    if (j.find(TRAFFIC_CAPTURE_FILE) != j.end())
+    {
+        configuration.setTrafficCaptureFile(j.at(TRAFFIC_CAPTURE_FILE).get<std::string>());
+    }
+
     return configuration;
 }
 }    // namespace wolkabout
@@ -14,9 +14,13 @@
  * limitations under the License.
  */
 
+#include "model/PerformanceProfile.h"
 #include "model/SubdeviceManagement.h"
 #include "model/WolkOptional.h"
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace wolkabout
@@ -40,6 +44,51 @@ public:
     void setPlatformTrustStore(const std::string& value);
     const WolkOptional<std::string>& getPlatformTrustStore() const;
 
+    void setPlatformReconnectBackoff(std::chrono::milliseconds initialDelay, std::chrono::milliseconds maximumDelay,
+                                     std::chrono::milliseconds stablePeriod);
+    bool hasPlatformReconnectBackoff() const;
+    std::chrono::milliseconds getPlatformReconnectInitialDelay() const;
+    std::chrono::milliseconds getPlatformReconnectMaximumDelay() const;
+    std::chrono::milliseconds getPlatformReconnectStablePeriod() const;
+
+    void setLocalSocket(const std::string& value);
+    const WolkOptional<std::string>& getLocalSocket() const;
+
+    void setShard(std::size_t index, std::size_t count, bool routed, const std::string& storageDirectory);
+    bool hasShard() const;
+    std::size_t getShardIndex() const;
+    std::size_t getShardCount() const;
+    bool isShardRouted() const;
+    const std::string& getShardStorageDirectory() const;
+
+    void setLogLevel(const std::string& value);
+    const WolkOptional<std::string>& getLogLevel() const;
+
+    void setSubdeviceRateLimit(double messagesPerSecond, std::size_t burst);
+    bool hasSubdeviceRateLimit() const;
+    double getSubdeviceMessagesPerSecond() const;
+    std::size_t getSubdeviceMessageBurst() const;
+
+    void setReadingDeadband(double percentOfRange, std::chrono::milliseconds maxSilence,
+                            const std::string& overrideFile);
+    bool hasReadingDeadband() const;
+    double getReadingDeadbandPercentOfRange() const;
+    std::chrono::milliseconds getReadingDeadbandMaxSilence() const;
+    const std::string& getReadingDeadbandOverrideFile() const;
+
+    void setPerformanceProfile(const PerformanceProfile& profile);
+    bool hasPerformanceProfile() const;
+    const PerformanceProfile& getPerformanceProfile() const;
+
+    void setTracing(std::uint32_t sampleOneIn, std::size_t capacity, const std::string& file);
+    bool hasTracing() const;
+    std::uint32_t getTracingSampleOneIn() const;
+    std::size_t getTracingCapacity() const;
+    const std::string& getTracingFile() const;
+
+    void setTrafficCaptureFile(const std::string& value);
+    const WolkOptional<std::string>& getTrafficCaptureFile() const;
+
     static wolkabout::GatewayConfiguration fromJson(const std::string& gatewayConfigurationFile);
 
 private:
@@ -53,10 +102,69 @@ private:
 
     WolkOptional<std::string> m_platformTrustStore;
 
+    bool m_hasPlatformReconnectBackoff = false;
+    std::chrono::milliseconds m_platformReconnectInitialDelay{0};
+    std::chrono::milliseconds m_platformReconnectMaximumDelay{0};
+    std::chrono::milliseconds m_platformReconnectStablePeriod{0};
+
+    WolkOptional<std::string> m_localSocket;
+
+    bool m_hasShard = false;
+    std::size_t m_shardIndex = 0;
+    std::size_t m_shardCount = 1;
+    bool m_shardRouted = false;
+    std::string m_shardStorageDirectory;
+
+    WolkOptional<std::string> m_logLevel;
+
+    bool m_hasSubdeviceRateLimit = false;
+    double m_subdeviceMessagesPerSecond = 0;
+    std::size_t m_subdeviceMessageBurst = 0;
+
+    bool m_hasReadingDeadband = false;
+    double m_readingDeadbandPercentOfRange = 0;
+    std::chrono::milliseconds m_readingDeadbandMaxSilence{0};
+    std::string m_readingDeadbandOverrideFile;
+
+    bool m_hasPerformanceProfile = false;
+    PerformanceProfile m_performanceProfile;
+
+    bool m_hasTracing = false;
+    std::uint32_t m_tracingSampleOneIn = 0;
+    std::size_t m_tracingCapacity = 0;
+    std::string m_tracingFile;
+
+    WolkOptional<std::string> m_trafficCaptureFile;
+
     static const std::string KEY;
     static const std::string PASSWORD;
     static const std::string PLATFORM_URI;
     static const std::string PLATFORM_TRUST_STORE;
+    static const std::string PLATFORM_RECONNECT;
+    static const std::string RECONNECT_INITIAL_DELAY;
+    static const std::string RECONNECT_MAXIMUM_DELAY;
+    static const std::string RECONNECT_STABLE_PERIOD;
+    static const std::string LOCAL_SOCKET;
+    static const std::string SHARD;
+    static const std::string SHARD_INDEX;
+    static const std::string SHARD_COUNT;
+    static const std::string SHARD_ROUTED;
+    static const std::string SHARD_STORAGE_DIRECTORY;
+    static const std::string LOG_LEVEL;
+    static const std::string SUBDEVICE_RATE_LIMIT;
+    static const std::string RATE_LIMIT_MESSAGES_PER_SECOND;
+    static const std::string RATE_LIMIT_BURST;
+    static const std::string READING_DEADBAND;
+    static const std::string DEADBAND_PERCENT_OF_RANGE;
+    static const std::string DEADBAND_MAX_SILENCE;
+    static const std::string DEADBAND_OVERRIDE_FILE;
+    static const std::string PERFORMANCE;
+    static const std::string PERFORMANCE_PRESET;
+    static const std::string TRACING;
+    static const std::string TRACING_SAMPLE_ONE_IN;
+    static const std::string TRACING_CAPACITY;
+    static const std::string TRACING_FILE;
+    static const std::string TRAFFIC_CAPTURE_FILE;
     static const std::string LOCAL_URI;
     static const std::string SUBDEVICE_MANAGEMENT;
 };
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BENCHMARKHARNESS_H
+#define BENCHMARKHARNESS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace wolkabout
+{
+namespace benchmark
+{
+/**
+ * @brief Collects per-message latencies, possibly from threads other than the one sending messages
+ */
+class LatencyRecorder
+{
+public:
+    explicit LatencyRecorder(std::size_t expected) : m_count{0} { m_samples.reserve(expected); }
+
+    void record(std::chrono::nanoseconds latency)
+    {
+        {
+            std::lock_guard<std::mutex> lg{m_mutex};
+            m_samples.push_back(latency);
+        }
+
+        ++m_count;
+    }
+
+    std::size_t count() const { return m_count; }
+
+    /**
+     * @brief Waits until given number of samples is recorded
+     * @return false if samples did not arrive within timeout
+     */
+    bool waitFor(std::size_t count, std::chrono::milliseconds timeout) const
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        while (m_count < count)
+        {
+            if (std::chrono::steady_clock::now() > deadline)
+            {
+                return false;
+            }
+
+            std::this_thread::sleep_for(std::chrono::microseconds{100});
+        }
+
+        return true;
+    }
+
+    std::vector<std::chrono::nanoseconds> samples() const
+    {
+        std::lock_guard<std::mutex> lg{m_mutex};
+        return m_samples;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<std::chrono::nanoseconds> m_samples;
+    std::atomic<std::size_t> m_count;
+};
+
+struct Result
+{
+    std::string name;
+    std::chrono::nanoseconds duration;
+    std::vector<std::chrono::nanoseconds> latencies;
+};
+
+inline std::int64_t nanosecondsSinceEpoch()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/**
+ * @brief Runs operation given number of times on calling thread, measuring each call
+ */
+inline Result measure(const std::string& name, std::size_t iterations, std::function<void(std::size_t)> operation)
+{
+    Result result{name, std::chrono::nanoseconds{0}, {}};
+    result.latencies.reserve(iterations);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        const auto before = std::chrono::steady_clock::now();
+        operation(i);
+        result.latencies.push_back(std::chrono::steady_clock::now() - before);
+    }
+
+    result.duration = std::chrono::steady_clock::now() - start;
+    return result;
+}
+
+inline double percentileMicroseconds(const std::vector<std::chrono::nanoseconds>& sorted, double percentile)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+
+    const auto index = static_cast<std::size_t>(percentile * static_cast<double>(sorted.size() - 1));
+    return static_cast<double>(sorted[index].count()) / 1000.0;
+}
+
+inline void printHeader()
+{
+    std::cout << std::left << std::setw(56) << "benchmark" << std::right << std::setw(10) << "messages"
+              << std::setw(14) << "msg/s" << std::setw(12) << "p50 us" << std::setw(12) << "p99 us" << std::setw(12)
+              << "p999 us" << std::endl;
+}
+
+inline void report(Result result)
+{
+    std::sort(result.latencies.begin(), result.latencies.end());
+
+    const double seconds = static_cast<double>(result.duration.count()) / 1e9;
+    const double throughput = seconds > 0 ? static_cast<double>(result.latencies.size()) / seconds : 0;
+
+    std::cout << std::left << std::setw(56) << result.name << std::right << std::setw(10) << result.latencies.size()
+              << std::fixed << std::setprecision(0) << std::setw(14) << throughput << std::setprecision(2)
+              << std::setw(12) << percentileMicroseconds(result.latencies, 0.5) << std::setw(12)
+              << percentileMicroseconds(result.latencies, 0.99) << std::setw(12)
+              << percentileMicroseconds(result.latencies, 0.999) << std::endl;
+}
+}    // namespace benchmark
+}    // namespace wolkabout
+
+#endif    // BENCHMARKHARNESS_H
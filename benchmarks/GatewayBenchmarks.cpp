@@ -0,0 +1,295 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BenchmarkHarness.h"
+#include "InMemoryDeviceRepository.h"
+#include "GatewayInboundDeviceMessageHandler.h"
+#include "GatewayInboundPlatformMessageHandler.h"
+#include "OutboundMessageHandler.h"
+#include "connectivity/ConnectivityService.h"
+#include "model/DetailedDevice.h"
+#include "model/DeviceTemplate.h"
+#include "model/GatewayDevice.h"
+#include "model/Message.h"
+#include "model/SensorReading.h"
+#include "model/SensorTemplate.h"
+#include "model/SubdeviceManagement.h"
+#include "model/SubdeviceRegistrationRequest.h"
+#include "persistence/inmemory/GatewayInMemoryPersistence.h"
+#include "protocol/json/JsonGatewayDataProtocol.h"
+#include "protocol/json/JsonGatewayStatusProtocol.h"
+#include "protocol/json/JsonGatewaySubdeviceRegistrationProtocol.h"
+#include "protocol/json/JsonProtocol.h"
+#include "protocol/json/JsonRegistrationProtocol.h"
+#include "protocol/json/JsonStatusProtocol.h"
+#include "protocol/json/JsonStreamingProtocol.h"
+#include "repository/DeviceRepository.h"
+#include "service/DataService.h"
+#include "service/DeviceStatusService.h"
+#include "service/PublishingService.h"
+#include "service/SubdeviceRegistrationService.h"
+#include "utilities/Executor.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace wolkabout;
+using namespace wolkabout::benchmark;
+
+namespace
+{
+const char* GATEWAY_KEY = "GATEWAY_KEY";
+const std::size_t DEVICE_COUNT = 64;
+const std::size_t ITERATIONS = 100000;
+const std::size_t REGISTRATION_ITERATIONS = 10000;
+const std::chrono::milliseconds ASYNC_TIMEOUT{60000};
+
+std::string deviceKey(std::size_t index)
+{
+    return "DEVICE_" + std::to_string(index % DEVICE_COUNT);
+}
+
+class DiscardingOutboundMessageHandler : public OutboundMessageHandler
+{
+public:
+    void addMessage(std::shared_ptr<Message>) override { ++m_count; }
+
+private:
+    std::atomic<std::size_t> m_count{0};
+};
+
+/**
+ * Publishes nowhere, records time since the send timestamp carried in message content
+ */
+class LatencyConnectivityService : public ConnectivityService
+{
+public:
+    explicit LatencyConnectivityService(LatencyRecorder& recorder) : m_recorder(recorder) {}
+
+    bool connect() override { return true; }
+    void disconnect() override {}
+    bool reconnect() override { return true; }
+    bool isConnected() override { return true; }
+
+    bool publish(std::shared_ptr<Message> outboundMessage, bool) override
+    {
+        const auto sentAt = std::stoll(outboundMessage->getContent());
+        m_recorder.record(std::chrono::nanoseconds{nanosecondsSinceEpoch() - sentAt});
+        return true;
+    }
+
+    void setUncontrolledDisonnectMessage(std::shared_ptr<Message>, bool) override {}
+
+private:
+    LatencyRecorder& m_recorder;
+};
+
+void populate(DeviceRepository& repository)
+{
+    repository.save(GatewayDevice{GATEWAY_KEY, "", SubdeviceManagement::GATEWAY, true, true});
+
+    for (std::size_t i = 0; i < DEVICE_COUNT; ++i)
+    {
+        repository.save(DetailedDevice{
+          "", deviceKey(i),
+          DeviceTemplate{{}, {SensorTemplate{"", "T", DataType::NUMERIC, "", {0}, {100}}}, {}, {}, "", {}, {}, {}}});
+    }
+}
+
+Result dataServiceDeviceToPlatform()
+{
+    JsonProtocol protocol{true};
+    JsonGatewayDataProtocol gatewayProtocol;
+    InMemoryDeviceRepository repository;
+    populate(repository);
+    DiscardingOutboundMessageHandler platformHandler;
+    DiscardingOutboundMessageHandler deviceHandler;
+
+    DataService service{GATEWAY_KEY, protocol, gatewayProtocol, &repository, platformHandler, deviceHandler};
+
+    return measure("DataService device->platform sensor reading", ITERATIONS, [&](std::size_t i) {
+        service.deviceMessageReceived(
+          std::make_shared<Message>("25.5", "d2p/sensor_reading/d/" + deviceKey(i) + "/r/T"));
+    });
+}
+
+Result sensorReadingSerialization(const std::string& name, const DataProtocol& protocol)
+{
+    std::vector<std::shared_ptr<SensorReading>> readings;
+    for (unsigned long long i = 0; i < 10; ++i)
+    {
+        readings.push_back(std::make_shared<SensorReading>("25.5", "T", 1546300800000 + i));
+    }
+
+    return measure(name, ITERATIONS, [&](std::size_t) { protocol.makeMessage(GATEWAY_KEY, readings); });
+}
+
+Result dataServicePlatformToDevice()
+{
+    JsonProtocol protocol{true};
+    JsonGatewayDataProtocol gatewayProtocol;
+    InMemoryDeviceRepository repository;
+    populate(repository);
+    DiscardingOutboundMessageHandler platformHandler;
+    DiscardingOutboundMessageHandler deviceHandler;
+
+    DataService service{GATEWAY_KEY, protocol, gatewayProtocol, &repository, platformHandler, deviceHandler};
+
+    const std::string prefix = std::string{"p2d/actuator_set/g/"} + GATEWAY_KEY + "/d/";
+    return measure("DataService platform->device actuator set", ITERATIONS, [&](std::size_t i) {
+        service.platformMessageReceived(
+          std::make_shared<Message>(R"({"value":"true"})", prefix + deviceKey(i) + "/r/SW"));
+    });
+}
+
+Result deviceStatusServiceDeviceToPlatform()
+{
+    JsonStatusProtocol protocol;
+    JsonGatewayStatusProtocol gatewayProtocol;
+    InMemoryDeviceRepository repository;
+    populate(repository);
+    DiscardingOutboundMessageHandler platformHandler;
+    DiscardingOutboundMessageHandler deviceHandler;
+
+    DeviceStatusService service{GATEWAY_KEY,     protocol,      gatewayProtocol,        &repository,
+                                platformHandler, deviceHandler, std::chrono::seconds{60}};
+
+    return measure("DeviceStatusService device->platform status update", ITERATIONS, [&](std::size_t i) {
+        service.deviceMessageReceived(std::make_shared<Message>(R"({"state":"CONNECTED"})",
+                                                                "d2p/subdevice_status_update/d/" + deviceKey(i)));
+    });
+}
+
+Result subdeviceRegistrationServiceDeviceToPlatform()
+{
+    JsonRegistrationProtocol protocol;
+    JsonGatewaySubdeviceRegistrationProtocol gatewayProtocol;
+    InMemoryDeviceRepository repository;
+    populate(repository);
+    DiscardingOutboundMessageHandler platformHandler;
+    DiscardingOutboundMessageHandler deviceHandler;
+    Executor executor;
+
+    SubdeviceRegistrationService service{GATEWAY_KEY,     protocol,      gatewayProtocol, repository,
+                                         platformHandler, deviceHandler, executor};
+
+    // messages are prepared up front, device modules serialize requests themselves
+    std::vector<std::shared_ptr<Message>> requests;
+    requests.reserve(REGISTRATION_ITERATIONS);
+    for (std::size_t i = 0; i < REGISTRATION_ITERATIONS; ++i)
+    {
+        SubdeviceRegistrationRequest request{"Device name", "NEW_DEVICE_" + std::to_string(i), DeviceTemplate{}};
+        requests.emplace_back(protocol.makeMessage(GATEWAY_KEY, request));
+    }
+
+    return measure("SubdeviceRegistrationService registration request", REGISTRATION_ITERATIONS,
+                   [&](std::size_t i) { service.deviceMessageReceived(requests[i]); });
+}
+
+Result inboundDeviceToPlatform(std::size_t workers)
+{
+    JsonProtocol protocol{true};
+    JsonGatewayDataProtocol gatewayProtocol;
+    InMemoryDeviceRepository repository;
+    populate(repository);
+
+    LatencyRecorder recorder{ITERATIONS};
+    LatencyConnectivityService platformConnectivityService{recorder};
+    PublishingService platformPublisher{platformConnectivityService,
+                                        std::unique_ptr<GatewayPersistence>(new GatewayInMemoryPersistence()), 64};
+    platformPublisher.connected();
+    DiscardingOutboundMessageHandler deviceHandler;
+
+    auto service = std::make_shared<DataService>(GATEWAY_KEY, protocol, gatewayProtocol, &repository,
+                                                 platformPublisher, deviceHandler);
+
+    GatewayInboundDeviceMessageHandler handler{workers};
+    handler.addListener(service);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < ITERATIONS; ++i)
+    {
+        handler.messageReceived("d2p/sensor_reading/d/" + deviceKey(i) + "/r/T",
+                                std::to_string(nanosecondsSinceEpoch()));
+    }
+
+    if (!recorder.waitFor(ITERATIONS, ASYNC_TIMEOUT))
+    {
+        std::cerr << "Only " << recorder.count() << " of " << ITERATIONS << " messages were published" << std::endl;
+    }
+
+    return Result{"Inbound device handler (" + std::to_string(workers) + " workers) -> publisher",
+                  std::chrono::steady_clock::now() - start, recorder.samples()};
+}
+
+Result inboundPlatformToDevice()
+{
+    JsonProtocol protocol{true};
+    JsonGatewayDataProtocol gatewayProtocol;
+    InMemoryDeviceRepository repository;
+    populate(repository);
+
+    LatencyRecorder recorder{ITERATIONS};
+    LatencyConnectivityService deviceConnectivityService{recorder};
+    PublishingService devicePublisher{deviceConnectivityService,
+                                      std::unique_ptr<GatewayPersistence>(new GatewayInMemoryPersistence()), 64};
+    devicePublisher.connected();
+    DiscardingOutboundMessageHandler platformHandler;
+
+    auto service = std::make_shared<DataService>(GATEWAY_KEY, protocol, gatewayProtocol, &repository,
+                                                 platformHandler, devicePublisher);
+
+    GatewayInboundPlatformMessageHandler handler{GATEWAY_KEY};
+    handler.addListener(service);
+
+    const std::string prefix = std::string{"p2d/actuator_set/g/"} + GATEWAY_KEY + "/d/";
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < ITERATIONS; ++i)
+    {
+        handler.messageReceived(prefix + deviceKey(i) + "/r/SW", std::to_string(nanosecondsSinceEpoch()));
+    }
+
+    if (!recorder.waitFor(ITERATIONS, ASYNC_TIMEOUT))
+    {
+        std::cerr << "Only " << recorder.count() << " of " << ITERATIONS << " messages were published" << std::endl;
+    }
+
+    return Result{"Inbound platform handler -> publisher", std::chrono::steady_clock::now() - start,
+                  recorder.samples()};
+}
+}    // namespace
+
+int main()
+{
+    printHeader();
+
+    report(dataServiceDeviceToPlatform());
+    report(dataServicePlatformToDevice());
+    report(sensorReadingSerialization("JsonProtocol 10 sensor readings", JsonProtocol{true}));
+    report(sensorReadingSerialization("JsonStreamingProtocol 10 sensor readings", JsonStreamingProtocol{true}));
+    report(deviceStatusServiceDeviceToPlatform());
+    report(subdeviceRegistrationServiceDeviceToPlatform());
+    report(inboundDeviceToPlatform(1));
+    report(inboundDeviceToPlatform(4));
+    report(inboundPlatformToDevice());
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BenchmarkHarness.h"
+#include "utilities/ByteUtils.h"
+#include "utilities/Sha256.h"
+#include "utilities/StringUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace wolkabout;
+using namespace wolkabout::benchmark;
+
+namespace
+{
+const std::size_t DATA_SIZE = 64 * 1024 * 1024;
+
+ByteArray makeData(std::size_t size)
+{
+    ByteArray data(size);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        data[i] = static_cast<std::uint8_t>(i * 31 + 7);
+    }
+
+    return data;
+}
+
+void reportThroughput(const Result& result, std::size_t bytesPerOperation)
+{
+    report(result);
+
+    const double seconds = static_cast<double>(result.duration.count()) / 1e9;
+    const double bytes = static_cast<double>(bytesPerOperation * result.latencies.size());
+    std::cout << std::left << std::setw(56) << "" << std::right << std::fixed << std::setprecision(1)
+              << (seconds > 0 ? bytes / seconds / (1024 * 1024) : 0) << " MiB/s" << std::endl;
+}
+
+Result sha256(const ByteArray& data, std::size_t packetSize)
+{
+    const std::size_t packets = data.size() / packetSize;
+    const std::string name = "Sha256::hash (OpenSSL) " + std::to_string(packetSize / 1024) + " KiB packets";
+
+    return measure(name, packets, [&](std::size_t i) { Sha256::hash(data.data() + i * packetSize, packetSize); });
+}
+
+Result byteUtilsSha256(const ByteArray& data, std::size_t packetSize)
+{
+    const std::size_t packets = data.size() / packetSize;
+    const std::string name = "ByteUtils::hashSHA256 " + std::to_string(packetSize / 1024) + " KiB packets";
+
+    return measure(name, packets, [&](std::size_t i) {
+        const auto begin = data.begin() + static_cast<std::ptrdiff_t>(i * packetSize);
+        ByteUtils::hashSHA256(ByteArray(begin, begin + static_cast<std::ptrdiff_t>(packetSize)));
+    });
+}
+
+Result base64(std::size_t iterations)
+{
+    const auto hash = Sha256::hash(makeData(1024));
+
+    return measure("base64 encode and decode of SHA-256 hash", iterations,
+                   [&](std::size_t) { StringUtils::base64Decode(StringUtils::base64Encode(hash)); });
+}
+}    // namespace
+
+/**
+ * Compares SHA-256 used for file transfer checks, optionally over given number of MiB
+ */
+int main(int argc, char** argv)
+{
+    const std::size_t size = argc > 1 ? std::strtoul(argv[1], nullptr, 10) * 1024 * 1024 : DATA_SIZE;
+    const auto data = makeData(size);
+
+    std::cout << "SHA-256 CPU acceleration: " << Sha256::cpuAcceleration() << std::endl;
+    printHeader();
+
+    for (const auto packetSize : std::vector<std::size_t>{4 * 1024, 64 * 1024, 1024 * 1024})
+    {
+        if (size < packetSize)
+        {
+            continue;
+        }
+
+        reportThroughput(sha256(data, packetSize), packetSize);
+        reportThroughput(byteUtilsSha256(data, packetSize), packetSize);
+    }
+
+    report(base64(100000));
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INMEMORYDEVICEREPOSITORY_H
+#define INMEMORYDEVICEREPOSITORY_H
+
+#include "model/DetailedDevice.h"
+#include "repository/DeviceRepository.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+namespace benchmark
+{
+/**
+ * @brief Map backed DeviceRepository, baseline for persistent repositories and fixture for service benchmarks
+ */
+class InMemoryDeviceRepository : public DeviceRepository
+{
+public:
+    void save(const DetailedDevice& device) override
+    {
+        std::lock_guard<std::mutex> lg{m_mutex};
+        m_devices[device.getKey()] = std::unique_ptr<DetailedDevice>(new DetailedDevice(device));
+    }
+
+    void remove(const std::string& key) override
+    {
+        std::lock_guard<std::mutex> lg{m_mutex};
+        m_devices.erase(key);
+    }
+
+    void removeAll() override
+    {
+        std::lock_guard<std::mutex> lg{m_mutex};
+        m_devices.clear();
+    }
+
+    std::unique_ptr<DetailedDevice> findByDeviceKey(const std::string& key) override
+    {
+        std::lock_guard<std::mutex> lg{m_mutex};
+        auto it = m_devices.find(key);
+        return it != m_devices.end() ? std::unique_ptr<DetailedDevice>(new DetailedDevice(*it->second)) : nullptr;
+    }
+
+    std::unique_ptr<std::vector<std::string>> findAllDeviceKeys() override
+    {
+        std::lock_guard<std::mutex> lg{m_mutex};
+        auto keys = std::unique_ptr<std::vector<std::string>>(new std::vector<std::string>());
+        for (const auto& pair : m_devices)
+        {
+            keys->push_back(pair.first);
+        }
+
+        return keys;
+    }
+
+    bool containsDeviceWithKey(const std::string& key) override
+    {
+        std::lock_guard<std::mutex> lg{m_mutex};
+        return m_devices.find(key) != m_devices.end();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<DetailedDevice>> m_devices;
+};
+}    // namespace benchmark
+}    // namespace wolkabout
+
+#endif    // INMEMORYDEVICEREPOSITORY_H
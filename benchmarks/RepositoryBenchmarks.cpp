@@ -0,0 +1,274 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "BenchmarkHarness.h"
+#include "InMemoryDeviceRepository.h"
+#include "OutboundMessageHandler.h"
+#include "model/ActuatorTemplate.h"
+#include "model/AlarmTemplate.h"
+#include "model/DetailedDevice.h"
+#include "model/DeviceTemplate.h"
+#include "model/Message.h"
+#include "model/SensorTemplate.h"
+#include "protocol/json/JsonGatewayDataProtocol.h"
+#include "protocol/json/JsonProtocol.h"
+#include "repository/CachedDeviceRepository.h"
+#include "repository/DeviceRepository.h"
+#include "repository/SQLiteDeviceRepository.h"
+#include "service/DataService.h"
+
+#include "Poco/File.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace wolkabout;
+using namespace wolkabout::benchmark;
+
+namespace
+{
+const char* GATEWAY_KEY = "GATEWAY_KEY";
+const char* DATABASE_PATH = "repositoryBenchmark.db";
+const std::size_t TEMPLATE_COUNT = 4;
+const std::size_t FIND_ALL_ITERATIONS = 50;
+
+struct Backend
+{
+    std::string name;
+    std::function<std::unique_ptr<DeviceRepository>()> open;
+    bool persistent;
+};
+
+/**
+ * Records when first message is handed over for publishing
+ */
+class FirstMessageHandler : public OutboundMessageHandler
+{
+public:
+    void addMessage(std::shared_ptr<Message>) override
+    {
+        if (!m_received)
+        {
+            m_received = true;
+            m_receivedAt = std::chrono::steady_clock::now();
+        }
+    }
+
+    bool received() const { return m_received; }
+
+    std::chrono::steady_clock::time_point receivedAt() const { return m_receivedAt; }
+
+private:
+    bool m_received = false;
+    std::chrono::steady_clock::time_point m_receivedAt;
+};
+
+// Fleets consist of many devices sharing few templates, here each differs only in sensor count
+DeviceTemplate makeTemplate(std::size_t variant)
+{
+    std::vector<SensorTemplate> sensors{SensorTemplate{"Temperature", "T", DataType::NUMERIC, "", {-40}, {85}},
+                                        SensorTemplate{"Humidity", "H", DataType::NUMERIC, "", {0}, {100}},
+                                        SensorTemplate{"Pressure", "P", DataType::NUMERIC, "", {300}, {1100}},
+                                        SensorTemplate{"Location", "LOC", DataType::STRING, "", {}, {}}};
+    for (std::size_t i = 0; i < variant; ++i)
+    {
+        sensors.push_back(
+          SensorTemplate{"Counter " + std::to_string(i), "C" + std::to_string(i), DataType::NUMERIC, "", {0}, {1000}});
+    }
+
+    return DeviceTemplate{{},
+                          sensors,
+                          {AlarmTemplate{"High temperature", "HT", ""}, AlarmTemplate{"Low battery", "LB", ""}},
+                          {ActuatorTemplate{"Switch", "SW", "SWITCH(ACTUATOR)", "", "", {0}, {1}},
+                           ActuatorTemplate{"Dimmer", "SL", "SLIDER(ACTUATOR)", "", "", {0}, {100}}},
+                          "",
+                          {{"protocol", "JsonProtocol"}},
+                          {},
+                          {{"supportsFirmwareUpdate", false}}};
+}
+
+std::vector<DetailedDevice> makeDevices(std::size_t count)
+{
+    std::vector<DeviceTemplate> templates;
+    for (std::size_t i = 0; i < TEMPLATE_COUNT; ++i)
+    {
+        templates.push_back(makeTemplate(i));
+    }
+
+    std::vector<DetailedDevice> devices;
+    devices.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        devices.emplace_back("Device " + std::to_string(i), "DEVICE_" + std::to_string(i),
+                             templates[i % TEMPLATE_COUNT]);
+    }
+
+    return devices;
+}
+
+// Spreads lookups over the whole key space instead of walking it in insertion order
+std::size_t scatter(std::size_t i, std::size_t count)
+{
+    return (i * 7919) % count;
+}
+
+void deleteDatabase()
+{
+    for (const auto& path : {std::string{DATABASE_PATH}, std::string{DATABASE_PATH} + "-wal",
+                             std::string{DATABASE_PATH} + "-shm"})
+    {
+        Poco::File file{path};
+        if (file.exists())
+        {
+            file.remove();
+        }
+    }
+}
+
+Poco::File::FileSize fileSize(const std::string& path)
+{
+    Poco::File file{path};
+    return file.exists() ? file.getSize() : 0;
+}
+
+void reportDatabaseSize(const std::string& name)
+{
+    std::cout << std::left << std::setw(56) << name << std::right << std::setw(10) << fileSize(DATABASE_PATH) / 1024
+              << " KiB database, " << fileSize(std::string{DATABASE_PATH} + "-wal") / 1024 << " KiB WAL"
+              << std::endl;
+}
+
+Result single(const std::string& name, std::function<void()> operation)
+{
+    return measure(name, 1, [&](std::size_t) { operation(); });
+}
+
+/**
+ * Opens repository filled by previous run, as gateway does on restart, until first reading is routed to platform
+ */
+Result startupToFirstRoutedMessage(const std::string& name, const Backend& backend, const std::string& deviceKey)
+{
+    JsonProtocol protocol{true};
+    JsonGatewayDataProtocol gatewayProtocol;
+    FirstMessageHandler platformHandler;
+    FirstMessageHandler deviceHandler;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    auto repository = backend.open();
+    DataService service{GATEWAY_KEY,     protocol,     gatewayProtocol, repository.get(),
+                        platformHandler, deviceHandler};
+    service.deviceMessageReceived(std::make_shared<Message>("25.5", "d2p/sensor_reading/d/" + deviceKey + "/r/T"));
+
+    if (!platformHandler.received())
+    {
+        std::cerr << "Reading of " << deviceKey << " was not routed to platform" << std::endl;
+        return Result{name, std::chrono::steady_clock::now() - start, {}};
+    }
+
+    const auto elapsed = platformHandler.receivedAt() - start;
+    return Result{name, elapsed, {elapsed}};
+}
+
+void run(const Backend& backend, std::size_t count)
+{
+    const auto devices = makeDevices(count);
+    const auto prefix = backend.name + " " + std::to_string(count) + " ";
+
+    deleteDatabase();
+    auto repository = backend.open();
+
+    report(measure(prefix + "save", count, [&](std::size_t i) { repository->save(devices[i]); }));
+    if (backend.persistent)
+    {
+        reportDatabaseSize(prefix + "size");
+    }
+
+    report(measure(prefix + "findByDeviceKey", count, [&](std::size_t i) {
+        repository->findByDeviceKey(devices[scatter(i, count)].getKey());
+    }));
+    report(measure(prefix + "findReferencesByDeviceKey", count, [&](std::size_t i) {
+        repository->findReferencesByDeviceKey(devices[scatter(i, count)].getKey());
+    }));
+    report(measure(prefix + "findAllDeviceKeys", FIND_ALL_ITERATIONS,
+                   [&](std::size_t) { repository->findAllDeviceKeys(); }));
+
+    if (backend.persistent)
+    {
+        repository.reset();
+        report(startupToFirstRoutedMessage(prefix + "startup to first routed message", backend,
+                                           devices[count / 2].getKey()));
+        repository = backend.open();
+    }
+
+    // Half of the fleet is removed one by one, the rest at once
+    const auto removed = count / 2;
+    report(measure(prefix + "remove", removed, [&](std::size_t i) { repository->remove(devices[i].getKey()); }));
+    report(single(prefix + "removeAll", [&] { repository->removeAll(); }));
+
+    repository.reset();
+    deleteDatabase();
+}
+}    // namespace
+
+/**
+ * Usage: repository_benchmarks [device count...], defaults to fleets of 1000, 10000 and 50000 devices
+ */
+int main(int argc, char** argv)
+{
+    std::vector<std::size_t> fleetSizes;
+    for (int i = 1; i < argc; ++i)
+    {
+        fleetSizes.push_back(static_cast<std::size_t>(std::strtoul(argv[i], nullptr, 10)));
+    }
+
+    if (fleetSizes.empty())
+    {
+        fleetSizes = {1000, 10000, 50000};
+    }
+
+    const std::vector<Backend> backends{
+      {"in-memory", [] { return std::unique_ptr<DeviceRepository>(new InMemoryDeviceRepository()); }, false},
+      {"SQLite", [] { return std::unique_ptr<DeviceRepository>(new SQLiteDeviceRepository(DATABASE_PATH)); }, true},
+      {"SQLite WAL",
+       [] { return std::unique_ptr<DeviceRepository>(new SQLiteDeviceRepository(DATABASE_PATH, true, true, 2)); },
+       true},
+      {"cached SQLite WAL",
+       [] {
+           return std::unique_ptr<DeviceRepository>(new CachedDeviceRepository(
+             std::unique_ptr<DeviceRepository>(new SQLiteDeviceRepository(DATABASE_PATH, true, true, 2))));
+       },
+       true}};
+
+    printHeader();
+
+    for (const auto count : fleetSizes)
+    {
+        for (const auto& backend : backends)
+        {
+            run(backend, count);
+        }
+    }
+
+    return 0;
+}
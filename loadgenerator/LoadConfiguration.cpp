@@ -0,0 +1,187 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LoadConfiguration.h"
+#include "utilities/FileSystemUtils.h"
+#include "utilities/json.hpp"
+
+#include <stdexcept>
+
+namespace wolkabout
+{
+using nlohmann::json;
+
+const std::string LoadConfiguration::GATEWAY_KEY = "gatewayKey";
+const std::string LoadConfiguration::LOCAL_URI = "localMqttUri";
+const std::string LoadConfiguration::PLATFORM_URI = "platformMqttUri";
+const std::string LoadConfiguration::DEVICES = "devices";
+const std::string LoadConfiguration::DEVICE_KEY_PREFIX = "deviceKeyPrefix";
+const std::string LoadConfiguration::CONNECTIONS = "connections";
+const std::string LoadConfiguration::REGISTRATIONS_PER_SECOND = "registrationsPerSecond";
+const std::string LoadConfiguration::READINGS_PER_SECOND = "readingsPerSecond";
+const std::string LoadConfiguration::ALARMS_PER_SECOND = "alarmsPerSecond";
+const std::string LoadConfiguration::STATUS_UPDATES_PER_SECOND = "statusUpdatesPerSecond";
+const std::string LoadConfiguration::ACTUATIONS_PER_SECOND = "actuationsPerSecond";
+const std::string LoadConfiguration::CONFIGURATIONS_PER_SECOND = "configurationsPerSecond";
+const std::string LoadConfiguration::DURATION = "durationSeconds";
+const std::string LoadConfiguration::DRAIN_TIMEOUT = "drainTimeoutSeconds";
+const std::string LoadConfiguration::REGISTRATION_TIMEOUT = "registrationTimeoutSeconds";
+
+LoadConfiguration::LoadConfiguration()
+: m_localMqttUri("tcp://localhost:1883")
+, m_platformMqttUri("tcp://localhost:1884")
+, m_devices(100)
+, m_deviceKeyPrefix("LOAD_DEVICE_")
+, m_connections(1)
+, m_registrationsPerSecond(50)
+, m_readingsPerSecond(1)
+, m_alarmsPerSecond(0.1)
+, m_statusUpdatesPerSecond(0.01)
+, m_actuationsPerSecond(0.1)
+, m_configurationsPerSecond(0.01)
+, m_duration(60)
+, m_drainTimeout(10)
+, m_registrationTimeout(60)
+{
+}
+
+const std::string& LoadConfiguration::getGatewayKey() const
+{
+    return m_gatewayKey;
+}
+
+const std::string& LoadConfiguration::getLocalMqttUri() const
+{
+    return m_localMqttUri;
+}
+
+const std::string& LoadConfiguration::getPlatformMqttUri() const
+{
+    return m_platformMqttUri;
+}
+
+std::size_t LoadConfiguration::getDevices() const
+{
+    return m_devices;
+}
+
+const std::string& LoadConfiguration::getDeviceKeyPrefix() const
+{
+    return m_deviceKeyPrefix;
+}
+
+std::size_t LoadConfiguration::getConnections() const
+{
+    return m_connections;
+}
+
+double LoadConfiguration::getRegistrationsPerSecond() const
+{
+    return m_registrationsPerSecond;
+}
+
+double LoadConfiguration::getReadingsPerSecond() const
+{
+    return m_readingsPerSecond;
+}
+
+double LoadConfiguration::getAlarmsPerSecond() const
+{
+    return m_alarmsPerSecond;
+}
+
+double LoadConfiguration::getStatusUpdatesPerSecond() const
+{
+    return m_statusUpdatesPerSecond;
+}
+
+double LoadConfiguration::getActuationsPerSecond() const
+{
+    return m_actuationsPerSecond;
+}
+
+double LoadConfiguration::getConfigurationsPerSecond() const
+{
+    return m_configurationsPerSecond;
+}
+
+std::chrono::seconds LoadConfiguration::getDuration() const
+{
+    return m_duration;
+}
+
+std::chrono::seconds LoadConfiguration::getDrainTimeout() const
+{
+    return m_drainTimeout;
+}
+
+std::chrono::seconds LoadConfiguration::getRegistrationTimeout() const
+{
+    return m_registrationTimeout;
+}
+
+wolkabout::LoadConfiguration LoadConfiguration::fromJson(const std::string& loadConfigurationFile)
+{
+    if (!FileSystemUtils::isFilePresent(loadConfigurationFile))
+    {
+        throw std::logic_error("Given load configuration file does not exist.");
+    }
+
+    std::string loadConfigurationJson;
+    if (!FileSystemUtils::readFileContent(loadConfigurationFile, loadConfigurationJson))
+    {
+        throw std::logic_error("Unable to read load configuration file.");
+    }
+
+    auto j = json::parse(loadConfigurationJson);
+
+    LoadConfiguration configuration;
+    configuration.m_gatewayKey = j.at(GATEWAY_KEY).get<std::string>();
+    configuration.m_localMqttUri = j.value(LOCAL_URI, configuration.m_localMqttUri);
+    configuration.m_platformMqttUri = j.value(PLATFORM_URI, configuration.m_platformMqttUri);
+    configuration.m_devices = j.value(DEVICES, configuration.m_devices);
+    configuration.m_deviceKeyPrefix = j.value(DEVICE_KEY_PREFIX, configuration.m_deviceKeyPrefix);
+    configuration.m_connections = j.value(CONNECTIONS, configuration.m_connections);
+    configuration.m_registrationsPerSecond = j.value(REGISTRATIONS_PER_SECOND, configuration.m_registrationsPerSecond);
+    configuration.m_readingsPerSecond = j.value(READINGS_PER_SECOND, configuration.m_readingsPerSecond);
+    configuration.m_alarmsPerSecond = j.value(ALARMS_PER_SECOND, configuration.m_alarmsPerSecond);
+    configuration.m_statusUpdatesPerSecond = j.value(STATUS_UPDATES_PER_SECOND, configuration.m_statusUpdatesPerSecond);
+    configuration.m_actuationsPerSecond = j.value(ACTUATIONS_PER_SECOND, configuration.m_actuationsPerSecond);
+    configuration.m_configurationsPerSecond =
+      j.value(CONFIGURATIONS_PER_SECOND, configuration.m_configurationsPerSecond);
+    configuration.m_duration = std::chrono::seconds{j.value(DURATION, configuration.m_duration.count())};
+    configuration.m_drainTimeout = std::chrono::seconds{j.value(DRAIN_TIMEOUT, configuration.m_drainTimeout.count())};
+    configuration.m_registrationTimeout =
+      std::chrono::seconds{j.value(REGISTRATION_TIMEOUT, configuration.m_registrationTimeout.count())};
+
+    if (configuration.m_gatewayKey.empty())
+    {
+        throw std::logic_error("Gateway key must not be empty.");
+    }
+
+    if (configuration.m_devices == 0 || configuration.m_connections == 0)
+    {
+        throw std::logic_error("Number of devices and connections must be greater than zero.");
+    }
+
+    if (configuration.m_registrationsPerSecond <= 0)
+    {
+        throw std::logic_error("Registration rate must be greater than zero.");
+    }
+
+    return configuration;
+}
+}    // namespace wolkabout
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LOADCONFIGURATION_H
+#define LOADCONFIGURATION_H
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * @brief Load generator settings, rates are per simulated subdevice
+ */
+class LoadConfiguration
+{
+public:
+    LoadConfiguration();
+
+    const std::string& getGatewayKey() const;
+
+    const std::string& getLocalMqttUri() const;
+    const std::string& getPlatformMqttUri() const;
+
+    std::size_t getDevices() const;
+    const std::string& getDeviceKeyPrefix() const;
+    std::size_t getConnections() const;
+
+    double getRegistrationsPerSecond() const;
+    double getReadingsPerSecond() const;
+    double getAlarmsPerSecond() const;
+    double getStatusUpdatesPerSecond() const;
+    double getActuationsPerSecond() const;
+    double getConfigurationsPerSecond() const;
+
+    std::chrono::seconds getDuration() const;
+    std::chrono::seconds getDrainTimeout() const;
+    std::chrono::seconds getRegistrationTimeout() const;
+
+    static wolkabout::LoadConfiguration fromJson(const std::string& loadConfigurationFile);
+
+private:
+    std::string m_gatewayKey;
+
+    std::string m_localMqttUri;
+    std::string m_platformMqttUri;
+
+    std::size_t m_devices;
+    std::string m_deviceKeyPrefix;
+    std::size_t m_connections;
+
+    double m_registrationsPerSecond;
+    double m_readingsPerSecond;
+    double m_alarmsPerSecond;
+    double m_statusUpdatesPerSecond;
+    double m_actuationsPerSecond;
+    double m_configurationsPerSecond;
+
+    std::chrono::seconds m_duration;
+    std::chrono::seconds m_drainTimeout;
+    std::chrono::seconds m_registrationTimeout;
+
+    static const std::string GATEWAY_KEY;
+    static const std::string LOCAL_URI;
+    static const std::string PLATFORM_URI;
+    static const std::string DEVICES;
+    static const std::string DEVICE_KEY_PREFIX;
+    static const std::string CONNECTIONS;
+    static const std::string REGISTRATIONS_PER_SECOND;
+    static const std::string READINGS_PER_SECOND;
+    static const std::string ALARMS_PER_SECOND;
+    static const std::string STATUS_UPDATES_PER_SECOND;
+    static const std::string ACTUATIONS_PER_SECOND;
+    static const std::string CONFIGURATIONS_PER_SECOND;
+    static const std::string DURATION;
+    static const std::string DRAIN_TIMEOUT;
+    static const std::string REGISTRATION_TIMEOUT;
+};
+}    // namespace wolkabout
+
+#endif    // LOADCONFIGURATION_H
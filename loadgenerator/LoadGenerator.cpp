@@ -0,0 +1,185 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LoadConfiguration.h"
+#include "LoadStatistics.h"
+#include "MockPlatform.h"
+#include "Pacer.h"
+#include "SimulatedSubdevices.h"
+#include "utilities/ConsoleLogger.h"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const std::chrono::milliseconds POLL_INTERVAL{10};
+
+void setupLogger()
+{
+    auto logger = std::unique_ptr<wolkabout::ConsoleLogger>(new wolkabout::ConsoleLogger());
+    logger->setLogLevel(wolkabout::LogLevel::INFO);
+    wolkabout::Logger::setInstance(std::move(logger));
+}
+
+std::size_t registeredDevices(const std::vector<std::shared_ptr<wolkabout::SimulatedSubdevices>>& groups)
+{
+    std::size_t count = 0;
+    for (const auto& group : groups)
+    {
+        count += group->registeredDevices();
+    }
+
+    return count;
+}
+
+bool waitUntil(std::function<bool()> condition, std::chrono::seconds timeout)
+{
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (!condition())
+    {
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+
+        std::this_thread::sleep_for(POLL_INTERVAL);
+    }
+
+    return true;
+}
+}    // namespace
+
+int main(int argc, char** argv)
+{
+    setupLogger();
+
+    if (argc < 2)
+    {
+        LOG(ERROR) << "WolkGateway Load Generator: Usage -  " << argv[0] << " [loadConfigurationFilePath]";
+        return -1;
+    }
+
+    wolkabout::LoadConfiguration configuration;
+    try
+    {
+        configuration = wolkabout::LoadConfiguration::fromJson(argv[1]);
+    }
+    catch (std::exception& e)
+    {
+        LOG(ERROR) << "WolkGateway Load Generator: Unable to parse load configuration file. Reason: " << e.what();
+        return -1;
+    }
+
+    wolkabout::LoadStatistics statistics;
+
+    auto platform = std::make_shared<wolkabout::MockPlatform>(configuration, statistics);
+    if (!platform->connect())
+    {
+        LOG(ERROR) << "WolkGateway Load Generator: Unable to connect to platform broker "
+                   << configuration.getPlatformMqttUri();
+        return -1;
+    }
+
+    // devices are spread over connections round robin
+    std::vector<std::vector<std::string>> deviceKeys(configuration.getConnections());
+    for (std::size_t i = 0; i < configuration.getDevices(); ++i)
+    {
+        deviceKeys[i % deviceKeys.size()].push_back(configuration.getDeviceKeyPrefix() + std::to_string(i));
+    }
+
+    std::vector<std::shared_ptr<wolkabout::SimulatedSubdevices>> groups;
+    for (std::size_t i = 0; i < deviceKeys.size(); ++i)
+    {
+        groups.push_back(
+          std::make_shared<wolkabout::SimulatedSubdevices>(configuration, i, std::move(deviceKeys[i]), statistics));
+        if (!groups.back()->connect())
+        {
+            LOG(ERROR) << "WolkGateway Load Generator: Unable to connect to local broker "
+                       << configuration.getLocalMqttUri();
+            return -1;
+        }
+    }
+
+    LOG(INFO) << "WolkGateway Load Generator: Registering " << configuration.getDevices() << " devices";
+
+    wolkabout::Pacer registrations{configuration.getRegistrationsPerSecond()};
+    std::size_t requested = 0;
+    while (requested < configuration.getDevices())
+    {
+        for (auto count = registrations.due(); count > 0 && requested < configuration.getDevices(); --count)
+        {
+            groups[requested % groups.size()]->registerDevice(requested / groups.size());
+            ++requested;
+        }
+
+        std::this_thread::sleep_for(POLL_INTERVAL);
+    }
+
+    if (!waitUntil([&] { return registeredDevices(groups) == configuration.getDevices(); },
+                   configuration.getRegistrationTimeout()))
+    {
+        LOG(WARN) << "WolkGateway Load Generator: Only " << registeredDevices(groups) << " of "
+                  << configuration.getDevices() << " devices registered, continuing with registered ones";
+    }
+
+    LOG(INFO) << "WolkGateway Load Generator: Generating load for " << configuration.getDuration().count()
+              << " seconds";
+
+    const auto start = std::chrono::steady_clock::now();
+    platform->start();
+    for (const auto& group : groups)
+    {
+        group->start();
+    }
+
+    std::this_thread::sleep_for(configuration.getDuration());
+
+    for (const auto& group : groups)
+    {
+        group->stop();
+    }
+    platform->stop();
+    const auto loadDuration = std::chrono::steady_clock::now() - start;
+
+    // messages still in flight through gateway queues are given time to arrive before being counted as lost
+    waitUntil(
+      [&] {
+          return statistics.pending(wolkabout::LoadStatistics::Kind::SENSOR_READING) == 0 &&
+                 statistics.pending(wolkabout::LoadStatistics::Kind::ALARM) == 0 &&
+                 statistics.pending(wolkabout::LoadStatistics::Kind::STATUS) == 0 &&
+                 statistics.pending(wolkabout::LoadStatistics::Kind::ACTUATION) == 0 &&
+                 statistics.pending(wolkabout::LoadStatistics::Kind::CONFIGURATION) == 0;
+      },
+      configuration.getDrainTimeout());
+
+    statistics.print(std::cout, loadDuration);
+
+    for (const auto& group : groups)
+    {
+        group->disconnect();
+    }
+    platform->disconnect();
+
+    return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "LoadStatistics.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace wolkabout
+{
+namespace
+{
+double percentileMilliseconds(const std::vector<std::chrono::nanoseconds>& sorted, double percentile)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+
+    const auto index = static_cast<std::size_t>(percentile * static_cast<double>(sorted.size() - 1));
+    return static_cast<double>(sorted[index].count()) / 1e6;
+}
+}    // namespace
+
+constexpr std::size_t LoadStatistics::KINDS;
+
+std::uint64_t LoadStatistics::sent(Kind kind)
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+
+    auto& counters = m_counters[static_cast<std::size_t>(kind)];
+    ++counters.sent;
+
+    const auto sequence = ++m_sequence;
+    counters.pending.emplace(sequence, std::chrono::steady_clock::now());
+    return sequence;
+}
+
+bool LoadStatistics::received(Kind kind, std::uint64_t sequence)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lg{m_mutex};
+
+    auto& counters = m_counters[static_cast<std::size_t>(kind)];
+    auto it = counters.pending.find(sequence);
+    if (it == counters.pending.end())
+    {
+        ++counters.unmatched;
+        return false;
+    }
+
+    ++counters.received;
+    counters.latencies.push_back(now - it->second);
+    counters.pending.erase(it);
+    return true;
+}
+
+void LoadStatistics::sentUntracked(Kind kind)
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+    ++m_counters[static_cast<std::size_t>(kind)].sent;
+}
+
+void LoadStatistics::receivedUntracked(Kind kind)
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+    ++m_counters[static_cast<std::size_t>(kind)].received;
+}
+
+std::size_t LoadStatistics::pending(Kind kind) const
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+
+    const auto& counters = m_counters[static_cast<std::size_t>(kind)];
+    if (!counters.pending.empty())
+    {
+        return counters.pending.size();
+    }
+
+    return counters.received < counters.sent ? static_cast<std::size_t>(counters.sent - counters.received) : 0;
+}
+
+void LoadStatistics::print(std::ostream& stream, std::chrono::steady_clock::duration loadDuration) const
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+
+    const double seconds = std::chrono::duration<double>(loadDuration).count();
+
+    stream << std::left << std::setw(16) << "message" << std::right << std::setw(10) << "sent" << std::setw(10)
+           << "received" << std::setw(10) << "lost" << std::setw(9) << "loss %" << std::setw(10) << "unmatched"
+           << std::setw(10) << "msg/s" << std::setw(11) << "p50 ms" << std::setw(11) << "p99 ms" << std::setw(11)
+           << "p999 ms" << std::setw(11) << "max ms" << std::endl;
+
+    for (std::size_t kind = 0; kind < KINDS; ++kind)
+    {
+        const auto& counters = m_counters[kind];
+        if (counters.sent == 0)
+        {
+            continue;
+        }
+
+        const auto lost = counters.received < counters.sent ? counters.sent - counters.received : 0;
+        const double loss = 100.0 * static_cast<double>(lost) / static_cast<double>(counters.sent);
+        const double throughput = seconds > 0 ? static_cast<double>(counters.received) / seconds : 0;
+
+        auto latencies = counters.latencies;
+        std::sort(latencies.begin(), latencies.end());
+
+        stream << std::left << std::setw(16) << name(kind) << std::right << std::setw(10) << counters.sent
+               << std::setw(10) << counters.received << std::setw(10) << lost << std::fixed << std::setprecision(2)
+               << std::setw(9) << loss << std::setw(10) << counters.unmatched << std::setprecision(0) << std::setw(10)
+               << throughput << std::setprecision(2);
+
+        if (latencies.empty())
+        {
+            stream << std::setw(11) << "-" << std::setw(11) << "-" << std::setw(11) << "-" << std::setw(11) << "-";
+        }
+        else
+        {
+            stream << std::setw(11) << percentileMilliseconds(latencies, 0.5) << std::setw(11)
+                   << percentileMilliseconds(latencies, 0.99) << std::setw(11)
+                   << percentileMilliseconds(latencies, 0.999) << std::setw(11)
+                   << percentileMilliseconds(latencies, 1.0);
+        }
+
+        stream << std::endl;
+    }
+}
+
+const char* LoadStatistics::name(std::size_t kind)
+{
+    switch (static_cast<Kind>(kind))
+    {
+    case Kind::REGISTRATION:
+        return "registration";
+    case Kind::SENSOR_READING:
+        return "sensor reading";
+    case Kind::ALARM:
+        return "alarm";
+    case Kind::STATUS:
+        return "status";
+    case Kind::ACTUATION:
+        return "actuation";
+    case Kind::CONFIGURATION:
+        return "configuration";
+    }
+
+    return "";
+}
+}    // namespace wolkabout
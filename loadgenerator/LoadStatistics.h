@@ -0,0 +1,96 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LOADSTATISTICS_H
+#define LOADSTATISTICS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Matches messages that arrived on the far side of the gateway with the ones that were sent
+ *
+ * Each tracked message carries sequence number returned by sent(), latency is measured from sent() to received()
+ * on the same steady clock, so device and platform side do not need synchronized clocks.
+ * Messages still pending when report is printed are counted as lost.
+ */
+class LoadStatistics
+{
+public:
+    enum class Kind
+    {
+        REGISTRATION = 0,
+        SENSOR_READING,
+        ALARM,
+        STATUS,
+        ACTUATION,
+        CONFIGURATION
+    };
+
+    /**
+     * @brief Records message that is about to be sent
+     * @return Sequence number to embed in message
+     */
+    std::uint64_t sent(Kind kind);
+
+    /**
+     * @brief Records arrival of message carrying sequence number
+     * @return false if sequence number is unknown or message was already received
+     */
+    bool received(Kind kind, std::uint64_t sequence);
+
+    /**
+     * @brief Records message whose payload can not carry sequence number, only counts are compared
+     */
+    void sentUntracked(Kind kind);
+    void receivedUntracked(Kind kind);
+
+    std::size_t pending(Kind kind) const;
+
+    void print(std::ostream& stream, std::chrono::steady_clock::duration loadDuration) const;
+
+private:
+    static constexpr std::size_t KINDS = 6;
+
+    struct Counters
+    {
+        Counters() : sent{0}, received{0}, unmatched{0} {}
+
+        std::uint64_t sent;
+        std::uint64_t received;
+        std::uint64_t unmatched;
+
+        std::unordered_map<std::uint64_t, std::chrono::steady_clock::time_point> pending;
+        std::vector<std::chrono::nanoseconds> latencies;
+    };
+
+    static const char* name(std::size_t kind);
+
+    mutable std::mutex m_mutex;
+    std::uint64_t m_sequence = 0;
+    std::array<Counters, KINDS> m_counters;
+};
+}    // namespace wolkabout
+
+#endif    // LOADSTATISTICS_H
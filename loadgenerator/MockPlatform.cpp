@@ -0,0 +1,291 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MockPlatform.h"
+#include "Pacer.h"
+#include "SimulatedSubdevices.h"
+#include "connectivity/mqtt/MqttConnectivityService.h"
+#include "connectivity/mqtt/PahoMqttClient.h"
+#include "model/Message.h"
+#include "utilities/Logger.h"
+#include "utilities/StringUtils.h"
+#include "utilities/json.hpp"
+
+#include <chrono>
+
+namespace wolkabout
+{
+using nlohmann::json;
+
+namespace
+{
+const std::chrono::milliseconds PUBLISH_INTERVAL{5};
+
+const std::string REGISTRATION_REQUEST_TOPIC_ROOT = "d2p/register_subdevice_request/";
+const std::string SENSOR_READING_TOPIC_ROOT = "d2p/sensor_reading/";
+const std::string EVENTS_TOPIC_ROOT = "d2p/events/";
+const std::string ACTUATION_STATUS_TOPIC_ROOT = "d2p/actuator_status/";
+const std::string CONFIGURATION_TOPIC_ROOT = "d2p/configuration_get/";
+const std::string STATUS_UPDATE_TOPIC_ROOT = "d2p/subdevice_status_update/";
+const std::string STATUS_RESPONSE_TOPIC_ROOT = "d2p/subdevice_status_response/";
+
+const std::string REGISTRATION_RESPONSE_TOPIC_ROOT = "p2d/register_subdevice_response/g/";
+const std::string ACTUATION_SET_TOPIC_ROOT = "p2d/actuator_set/g/";
+const std::string CONFIGURATION_SET_TOPIC_ROOT = "p2d/configuration_set/g/";
+
+bool parseSequence(const json& value, std::uint64_t& sequence)
+{
+    if (!value.is_string())
+    {
+        return false;
+    }
+
+    try
+    {
+        sequence = std::stoull(value.get<std::string>());
+        return true;
+    }
+    catch (std::exception&)
+    {
+        return false;
+    }
+}
+}    // namespace
+
+MockPlatform::MockPlatform(const LoadConfiguration& configuration, LoadStatistics& statistics)
+: m_configuration(configuration), m_statistics(statistics), m_nextDevice(0), m_running(false)
+{
+    m_connectivityService.reset(new MqttConnectivityService(std::make_shared<PahoMqttClient>(),
+                                                            m_configuration.getGatewayKey(), "",
+                                                            m_configuration.getPlatformMqttUri(), "MockPlatform"));
+}
+
+MockPlatform::~MockPlatform()
+{
+    stop();
+}
+
+bool MockPlatform::connect()
+{
+    m_connectivityService->setListener(shared_from_this());
+    return m_connectivityService->connect();
+}
+
+void MockPlatform::disconnect()
+{
+    m_connectivityService->disconnect();
+}
+
+void MockPlatform::start()
+{
+    if (m_running.exchange(true))
+    {
+        return;
+    }
+
+    m_worker = std::thread(&MockPlatform::run, this);
+}
+
+void MockPlatform::stop()
+{
+    m_running = false;
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+}
+
+void MockPlatform::run()
+{
+    const auto devices = [&] {
+        std::lock_guard<std::mutex> lg{m_devicesLock};
+        return static_cast<double>(m_devices.size());
+    }();
+
+    Pacer actuations{m_configuration.getActuationsPerSecond() * devices};
+    Pacer configurations{m_configuration.getConfigurationsPerSecond() * devices};
+
+    const std::string gatewayPath = m_configuration.getGatewayKey() + "/d/";
+    std::string deviceKey;
+
+    while (m_running)
+    {
+        for (auto count = actuations.due(); count > 0 && nextRegisteredDevice(deviceKey); --count)
+        {
+            const auto sequence = m_statistics.sent(LoadStatistics::Kind::ACTUATION);
+            const json payload = {{"value", std::to_string(sequence)}};
+
+            publish(std::make_shared<Message>(payload.dump(), ACTUATION_SET_TOPIC_ROOT + gatewayPath + deviceKey +
+                                                                "/r/" + SimulatedSubdevices::ACTUATOR_REFERENCE));
+        }
+
+        for (auto count = configurations.due(); count > 0 && nextRegisteredDevice(deviceKey); --count)
+        {
+            const auto sequence = m_statistics.sent(LoadStatistics::Kind::CONFIGURATION);
+            const json payload = {
+              {"values", {{SimulatedSubdevices::CONFIGURATION_REFERENCE, std::to_string(sequence)}}}};
+
+            publish(
+              std::make_shared<Message>(payload.dump(), CONFIGURATION_SET_TOPIC_ROOT + gatewayPath + deviceKey));
+        }
+
+        std::this_thread::sleep_for(PUBLISH_INTERVAL);
+    }
+}
+
+bool MockPlatform::nextRegisteredDevice(std::string& deviceKey)
+{
+    std::lock_guard<std::mutex> lg{m_devicesLock};
+    if (m_devices.empty())
+    {
+        return false;
+    }
+
+    deviceKey = m_devices[m_nextDevice];
+    m_nextDevice = (m_nextDevice + 1) % m_devices.size();
+    return true;
+}
+
+void MockPlatform::publish(std::shared_ptr<Message> message)
+{
+    std::lock_guard<std::mutex> lg{m_publishLock};
+    if (!m_connectivityService->publish(message))
+    {
+        LOG(DEBUG) << "MockPlatform: Unable to publish message on channel '" << message->getChannel() << "'";
+    }
+}
+
+void MockPlatform::handleRegistrationRequest(const std::string& payload)
+{
+    std::string deviceKey;
+    try
+    {
+        deviceKey = json::parse(payload).at("deviceKey").get<std::string>();
+    }
+    catch (std::exception&)
+    {
+        LOG(WARN) << "MockPlatform: Unable to parse registration request: " << payload;
+        return;
+    }
+
+    if (deviceKey != m_configuration.getGatewayKey())
+    {
+        std::lock_guard<std::mutex> lg{m_devicesLock};
+        if (m_registered.insert(deviceKey).second)
+        {
+            m_devices.push_back(deviceKey);
+        }
+    }
+
+    const json response = {{"payload", {{"deviceKey", deviceKey}}}, {"result", "OK"}, {"description", ""}};
+    publish(std::make_shared<Message>(response.dump(),
+                                      REGISTRATION_RESPONSE_TOPIC_ROOT + m_configuration.getGatewayKey()));
+}
+
+void MockPlatform::recordSequences(LoadStatistics::Kind kind, const std::string& payload, const std::string& field)
+{
+    json content;
+    try
+    {
+        content = json::parse(payload);
+    }
+    catch (std::exception&)
+    {
+        LOG(WARN) << "MockPlatform: Unable to parse payload: " << payload;
+        return;
+    }
+
+    // gateway may forward several readings of one reference in single message
+    const auto record = [&](const json& item) {
+        std::uint64_t sequence = 0;
+        if (item.is_object() && item.find(field) != item.end() && parseSequence(item.at(field), sequence))
+        {
+            m_statistics.received(kind, sequence);
+        }
+    };
+
+    if (content.is_array())
+    {
+        for (const auto& item : content)
+        {
+            record(item);
+        }
+    }
+    else
+    {
+        record(content);
+    }
+}
+
+void MockPlatform::recordConfiguration(const std::string& payload)
+{
+    try
+    {
+        const auto content = json::parse(payload);
+        std::uint64_t sequence = 0;
+        if (parseSequence(content.at("values").at(SimulatedSubdevices::CONFIGURATION_REFERENCE), sequence))
+        {
+            m_statistics.received(LoadStatistics::Kind::CONFIGURATION, sequence);
+        }
+    }
+    catch (std::exception&)
+    {
+        LOG(WARN) << "MockPlatform: Unable to parse configuration: " << payload;
+    }
+}
+
+void MockPlatform::messageReceived(const std::string& channel, const std::string& payload)
+{
+    if (StringUtils::startsWith(channel, SENSOR_READING_TOPIC_ROOT))
+    {
+        recordSequences(LoadStatistics::Kind::SENSOR_READING, payload, "data");
+    }
+    else if (StringUtils::startsWith(channel, EVENTS_TOPIC_ROOT))
+    {
+        recordSequences(LoadStatistics::Kind::ALARM, payload, "data");
+    }
+    else if (StringUtils::startsWith(channel, ACTUATION_STATUS_TOPIC_ROOT))
+    {
+        recordSequences(LoadStatistics::Kind::ACTUATION, payload, "value");
+    }
+    else if (StringUtils::startsWith(channel, CONFIGURATION_TOPIC_ROOT))
+    {
+        recordConfiguration(payload);
+    }
+    else if (StringUtils::startsWith(channel, STATUS_UPDATE_TOPIC_ROOT))
+    {
+        m_statistics.receivedUntracked(LoadStatistics::Kind::STATUS);
+    }
+    else if (StringUtils::startsWith(channel, REGISTRATION_REQUEST_TOPIC_ROOT))
+    {
+        handleRegistrationRequest(payload);
+    }
+    else if (!StringUtils::startsWith(channel, STATUS_RESPONSE_TOPIC_ROOT))
+    {
+        LOG(DEBUG) << "MockPlatform: Ignoring message on channel '" << channel << "'";
+    }
+}
+
+void MockPlatform::connectionLost()
+{
+    LOG(ERROR) << "MockPlatform: Connection to platform broker lost";
+}
+
+std::vector<std::string> MockPlatform::getChannels() const
+{
+    return {"d2p/#"};
+}
+}    // namespace wolkabout
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MOCKPLATFORM_H
+#define MOCKPLATFORM_H
+
+#include "LoadConfiguration.h"
+#include "LoadStatistics.h"
+#include "connectivity/ConnectivityService.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+namespace wolkabout
+{
+class Message;
+
+/**
+ * @brief Stands in for the platform on the broker gateway uses as platform host
+ *
+ * Accepts every subdevice registration, records forwarded device messages
+ * and sends actuation and configuration requests to registered devices at configured rates.
+ */
+class MockPlatform : public ConnectivityServiceListener, public std::enable_shared_from_this<MockPlatform>
+{
+public:
+    MockPlatform(const LoadConfiguration& configuration, LoadStatistics& statistics);
+    ~MockPlatform();
+
+    bool connect();
+    void disconnect();
+
+    void start();
+    void stop();
+
+    void messageReceived(const std::string& channel, const std::string& payload) override;
+    void connectionLost() override;
+    std::vector<std::string> getChannels() const override;
+
+private:
+    void run();
+
+    bool nextRegisteredDevice(std::string& deviceKey);
+
+    void publish(std::shared_ptr<Message> message);
+
+    void handleRegistrationRequest(const std::string& payload);
+    void recordSequences(LoadStatistics::Kind kind, const std::string& payload, const std::string& field);
+    void recordConfiguration(const std::string& payload);
+
+    const LoadConfiguration& m_configuration;
+    LoadStatistics& m_statistics;
+
+    std::mutex m_devicesLock;
+    std::unordered_set<std::string> m_registered;
+    std::vector<std::string> m_devices;
+    std::size_t m_nextDevice;
+
+    std::unique_ptr<ConnectivityService> m_connectivityService;
+    std::mutex m_publishLock;
+
+    std::atomic<bool> m_running;
+    std::thread m_worker;
+};
+}    // namespace wolkabout
+
+#endif    // MOCKPLATFORM_H
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PACER_H
+#define PACER_H
+
+#include <chrono>
+#include <cstdint>
+
+namespace wolkabout
+{
+/**
+ * @brief Spreads events evenly at given rate, catching up on events missed while caller was busy
+ */
+class Pacer
+{
+public:
+    explicit Pacer(double ratePerSecond) : m_ratePerSecond{ratePerSecond}, m_start{Clock::now()}, m_emitted{0} {}
+
+    /**
+     * @brief Number of events that became due since previous call
+     */
+    std::uint64_t due()
+    {
+        if (m_ratePerSecond <= 0)
+        {
+            return 0;
+        }
+
+        const std::chrono::duration<double> elapsed = Clock::now() - m_start;
+        const auto total = static_cast<std::uint64_t>(elapsed.count() * m_ratePerSecond);
+
+        const auto count = total - m_emitted;
+        m_emitted = total;
+        return count;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    double m_ratePerSecond;
+    Clock::time_point m_start;
+    std::uint64_t m_emitted;
+};
+}    // namespace wolkabout
+
+#endif    // PACER_H
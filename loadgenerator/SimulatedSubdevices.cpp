@@ -0,0 +1,400 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "SimulatedSubdevices.h"
+#include "Pacer.h"
+#include "connectivity/mqtt/MqttConnectivityService.h"
+#include "connectivity/mqtt/PahoMqttClient.h"
+#include "model/ActuatorTemplate.h"
+#include "model/AlarmTemplate.h"
+#include "model/ConfigurationTemplate.h"
+#include "model/DeviceTemplate.h"
+#include "model/Message.h"
+#include "model/SensorTemplate.h"
+#include "model/SubdeviceRegistrationRequest.h"
+#include "model/WolkOptional.h"
+#include "protocol/json/JsonRegistrationProtocol.h"
+#include "utilities/Logger.h"
+#include "utilities/json.hpp"
+
+#include <chrono>
+#include <utility>
+
+namespace wolkabout
+{
+using nlohmann::json;
+
+namespace
+{
+const std::chrono::milliseconds PUBLISH_INTERVAL{5};
+
+const std::string DEVICE_PATH = "/d/";
+const std::string REFERENCE_PATH = "/r/";
+
+const std::string SENSOR_READING_TOPIC_ROOT = "d2p/sensor_reading/d/";
+const std::string EVENTS_TOPIC_ROOT = "d2p/events/d/";
+const std::string ACTUATION_STATUS_TOPIC_ROOT = "d2p/actuator_status/d/";
+const std::string CONFIGURATION_TOPIC_ROOT = "d2p/configuration_get/d/";
+const std::string STATUS_UPDATE_TOPIC_ROOT = "d2p/subdevice_status_update/d/";
+const std::string STATUS_RESPONSE_TOPIC_ROOT = "d2p/subdevice_status_response/d/";
+const std::string REGISTRATION_REQUEST_TOPIC_ROOT = "d2p/register_subdevice_request/d/";
+
+const std::string REGISTRATION_RESPONSE = "register_subdevice_response";
+const std::string ACTUATION_SET = "actuator_set";
+const std::string ACTUATION_GET = "actuator_get";
+const std::string CONFIGURATION_SET = "configuration_set";
+const std::string CONFIGURATION_GET = "configuration_get";
+const std::string STATUS_REQUEST = "subdevice_status_request";
+
+unsigned long long utcMilliseconds()
+{
+    return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                             std::chrono::system_clock::now().time_since_epoch())
+                                             .count());
+}
+
+/**
+ * Splits "p2d/<type>/d/<key>[/r/<reference>]"
+ */
+bool parseChannel(const std::string& channel, std::string& type, std::string& deviceKey, std::string& reference)
+{
+    const auto typeStart = channel.find('/');
+    const auto devicePath = channel.find(DEVICE_PATH, typeStart);
+    if (typeStart == std::string::npos || devicePath == std::string::npos)
+    {
+        return false;
+    }
+
+    type = channel.substr(typeStart + 1, devicePath - typeStart - 1);
+
+    const auto keyStart = devicePath + DEVICE_PATH.size();
+    const auto referencePath = channel.find(REFERENCE_PATH, keyStart);
+    if (referencePath == std::string::npos)
+    {
+        deviceKey = channel.substr(keyStart);
+        reference.clear();
+    }
+    else
+    {
+        deviceKey = channel.substr(keyStart, referencePath - keyStart);
+        reference = channel.substr(referencePath + REFERENCE_PATH.size());
+    }
+
+    return !deviceKey.empty();
+}
+
+DeviceTemplate makeDeviceTemplate()
+{
+    return DeviceTemplate{
+      {ConfigurationTemplate{"Interval", SimulatedSubdevices::CONFIGURATION_REFERENCE, DataType::NUMERIC, "", "1", {},
+                             WolkOptional<double>{}, WolkOptional<double>{}}},
+      {SensorTemplate{"Temperature", SimulatedSubdevices::SENSOR_REFERENCE, DataType::NUMERIC, "", {}, {}}},
+      {AlarmTemplate{"High temperature", SimulatedSubdevices::ALARM_REFERENCE, ""}},
+      {ActuatorTemplate{"Switch", SimulatedSubdevices::ACTUATOR_REFERENCE, "SWITCH(ACTUATOR)", "", "", {0}, {1}}},
+      "",
+      {},
+      {},
+      {}};
+}
+}    // namespace
+
+const std::string SimulatedSubdevices::SENSOR_REFERENCE = "T";
+const std::string SimulatedSubdevices::ALARM_REFERENCE = "HT";
+const std::string SimulatedSubdevices::ACTUATOR_REFERENCE = "SW";
+const std::string SimulatedSubdevices::CONFIGURATION_REFERENCE = "CFG";
+
+SimulatedSubdevices::SimulatedSubdevices(const LoadConfiguration& configuration, std::size_t connectionIndex,
+                                         std::vector<std::string> deviceKeys, LoadStatistics& statistics)
+: m_configuration(configuration), m_statistics(statistics), m_nextDevice(0), m_running(false)
+{
+    for (auto& key : deviceKeys)
+    {
+        m_devices.emplace_back(new Device(std::move(key)));
+        m_devicesByKey[m_devices.back()->key] = m_devices.back().get();
+    }
+
+    const std::string clientId = "LoadGenerator-" + std::to_string(connectionIndex);
+    m_connectivityService.reset(new MqttConnectivityService(std::make_shared<PahoMqttClient>(),
+                                                            m_configuration.getGatewayKey(), "",
+                                                            m_configuration.getLocalMqttUri(), clientId));
+}
+
+SimulatedSubdevices::~SimulatedSubdevices()
+{
+    stop();
+}
+
+bool SimulatedSubdevices::connect()
+{
+    m_connectivityService->setListener(shared_from_this());
+    return m_connectivityService->connect();
+}
+
+void SimulatedSubdevices::disconnect()
+{
+    m_connectivityService->disconnect();
+}
+
+void SimulatedSubdevices::registerDevice(std::size_t index)
+{
+    Device& device = *m_devices.at(index);
+    const SubdeviceRegistrationRequest request{"Load device " + device.key, device.key, makeDeviceTemplate()};
+
+    // response carries only device key, so time is measured from the last request sent for the device
+    device.registration = m_statistics.sent(LoadStatistics::Kind::REGISTRATION);
+
+    JsonRegistrationProtocol protocol;
+    const auto message = protocol.makeMessage(device.key, request);
+    publish(std::make_shared<Message>(message->getContent(), REGISTRATION_REQUEST_TOPIC_ROOT + device.key));
+}
+
+std::size_t SimulatedSubdevices::size() const
+{
+    return m_devices.size();
+}
+
+std::size_t SimulatedSubdevices::registeredDevices() const
+{
+    std::size_t count = 0;
+    for (const auto& device : m_devices)
+    {
+        if (device->registered)
+        {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+void SimulatedSubdevices::start()
+{
+    if (m_running.exchange(true))
+    {
+        return;
+    }
+
+    m_worker = std::thread(&SimulatedSubdevices::run, this);
+}
+
+void SimulatedSubdevices::stop()
+{
+    m_running = false;
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+}
+
+void SimulatedSubdevices::run()
+{
+    const auto devices = static_cast<double>(registeredDevices());
+
+    Pacer readings{m_configuration.getReadingsPerSecond() * devices};
+    Pacer alarms{m_configuration.getAlarmsPerSecond() * devices};
+    Pacer statuses{m_configuration.getStatusUpdatesPerSecond() * devices};
+
+    while (m_running)
+    {
+        for (auto count = readings.due(); count > 0; --count)
+        {
+            if (const auto device = nextRegisteredDevice())
+            {
+                publishSensorReading(*device);
+            }
+        }
+
+        for (auto count = alarms.due(); count > 0; --count)
+        {
+            if (const auto device = nextRegisteredDevice())
+            {
+                publishAlarm(*device);
+            }
+        }
+
+        for (auto count = statuses.due(); count > 0; --count)
+        {
+            if (const auto device = nextRegisteredDevice())
+            {
+                m_statistics.sentUntracked(LoadStatistics::Kind::STATUS);
+                publishStatus(*device, STATUS_UPDATE_TOPIC_ROOT);
+            }
+        }
+
+        std::this_thread::sleep_for(PUBLISH_INTERVAL);
+    }
+}
+
+SimulatedSubdevices::Device* SimulatedSubdevices::nextRegisteredDevice()
+{
+    for (std::size_t i = 0; i < m_devices.size(); ++i)
+    {
+        Device* device = m_devices[m_nextDevice].get();
+        m_nextDevice = (m_nextDevice + 1) % m_devices.size();
+
+        if (device->registered)
+        {
+            return device;
+        }
+    }
+
+    return nullptr;
+}
+
+void SimulatedSubdevices::publish(std::shared_ptr<Message> message)
+{
+    std::lock_guard<std::mutex> lg{m_publishLock};
+    if (!m_connectivityService->publish(message))
+    {
+        LOG(DEBUG) << "SimulatedSubdevices: Unable to publish message on channel '" << message->getChannel() << "'";
+    }
+}
+
+void SimulatedSubdevices::publishSensorReading(const Device& device)
+{
+    const auto sequence = m_statistics.sent(LoadStatistics::Kind::SENSOR_READING);
+    const json payload = {{"utc", utcMilliseconds()}, {"data", std::to_string(sequence)}};
+
+    publish(std::make_shared<Message>(payload.dump(),
+                                      SENSOR_READING_TOPIC_ROOT + device.key + REFERENCE_PATH + SENSOR_REFERENCE));
+}
+
+void SimulatedSubdevices::publishAlarm(const Device& device)
+{
+    const auto sequence = m_statistics.sent(LoadStatistics::Kind::ALARM);
+    const json payload = {{"utc", utcMilliseconds()}, {"data", std::to_string(sequence)}};
+
+    publish(
+      std::make_shared<Message>(payload.dump(), EVENTS_TOPIC_ROOT + device.key + REFERENCE_PATH + ALARM_REFERENCE));
+}
+
+void SimulatedSubdevices::publishStatus(const Device& device, const std::string& topicRoot)
+{
+    publish(std::make_shared<Message>(R"({"state":"CONNECTED"})", topicRoot + device.key));
+}
+
+void SimulatedSubdevices::publishActuatorStatus(const Device& device, const std::string& reference,
+                                                const std::string& value)
+{
+    const json payload = {{"status", "READY"}, {"value", value}};
+    publish(
+      std::make_shared<Message>(payload.dump(), ACTUATION_STATUS_TOPIC_ROOT + device.key + REFERENCE_PATH + reference));
+}
+
+void SimulatedSubdevices::publishConfiguration(const Device& device, const std::string& values)
+{
+    publish(std::make_shared<Message>(values, CONFIGURATION_TOPIC_ROOT + device.key));
+}
+
+void SimulatedSubdevices::handleRegistrationResponse(Device& device, const std::string& payload)
+{
+    std::string result;
+    try
+    {
+        result = json::parse(payload).at("result").get<std::string>();
+    }
+    catch (std::exception&)
+    {
+        LOG(WARN) << "SimulatedSubdevices: Unable to parse registration response for device '" << device.key << "'";
+        return;
+    }
+
+    if (result != "OK")
+    {
+        LOG(WARN) << "SimulatedSubdevices: Registration of device '" << device.key << "' failed: " << result;
+        return;
+    }
+
+    if (!device.registered.exchange(true))
+    {
+        m_statistics.received(LoadStatistics::Kind::REGISTRATION, device.registration);
+    }
+}
+
+void SimulatedSubdevices::messageReceived(const std::string& channel, const std::string& payload)
+{
+    std::string type;
+    std::string deviceKey;
+    std::string reference;
+    if (!parseChannel(channel, type, deviceKey, reference))
+    {
+        return;
+    }
+
+    auto it = m_devicesByKey.find(deviceKey);
+    if (it == m_devicesByKey.end())
+    {
+        return;
+    }
+
+    Device& device = *it->second;
+
+    if (type == REGISTRATION_RESPONSE)
+    {
+        handleRegistrationResponse(device, payload);
+    }
+    else if (type == ACTUATION_SET)
+    {
+        std::string value;
+        try
+        {
+            value = json::parse(payload).at("value").get<std::string>();
+        }
+        catch (std::exception&)
+        {
+            LOG(WARN) << "SimulatedSubdevices: Unable to parse actuation request on channel '" << channel << "'";
+            return;
+        }
+
+        publishActuatorStatus(device, reference, value);
+    }
+    else if (type == ACTUATION_GET)
+    {
+        publishActuatorStatus(device, reference.empty() ? ACTUATOR_REFERENCE : reference, "0");
+    }
+    else if (type == CONFIGURATION_SET)
+    {
+        // device applies configuration and reports it back as current
+        publishConfiguration(device, payload);
+    }
+    else if (type == CONFIGURATION_GET)
+    {
+        publishConfiguration(device, json{{"values", {{CONFIGURATION_REFERENCE, "1"}}}}.dump());
+    }
+    else if (type == STATUS_REQUEST)
+    {
+        publishStatus(device, STATUS_RESPONSE_TOPIC_ROOT);
+    }
+}
+
+void SimulatedSubdevices::connectionLost()
+{
+    LOG(ERROR) << "SimulatedSubdevices: Connection to local broker lost";
+}
+
+std::vector<std::string> SimulatedSubdevices::getChannels() const
+{
+    std::vector<std::string> channels;
+    channels.reserve(m_devices.size());
+
+    for (const auto& device : m_devices)
+    {
+        channels.push_back("p2d/+/d/" + device->key + "/#");
+    }
+
+    return channels;
+}
+}    // namespace wolkabout
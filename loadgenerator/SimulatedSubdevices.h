@@ -0,0 +1,118 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SIMULATEDSUBDEVICES_H
+#define SIMULATEDSUBDEVICES_H
+
+#include "LoadConfiguration.h"
+#include "LoadStatistics.h"
+#include "connectivity/ConnectivityService.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+class Message;
+
+/**
+ * @brief Group of subdevices sharing one connection to the local broker
+ *
+ * Devices register with the gateway, publish sensor readings, alarms and status updates at configured rates
+ * and answer actuation, configuration and status requests the way device modules do.
+ */
+class SimulatedSubdevices : public ConnectivityServiceListener,
+                            public std::enable_shared_from_this<SimulatedSubdevices>
+{
+public:
+    SimulatedSubdevices(const LoadConfiguration& configuration, std::size_t connectionIndex,
+                        std::vector<std::string> deviceKeys, LoadStatistics& statistics);
+    ~SimulatedSubdevices();
+
+    bool connect();
+    void disconnect();
+
+    /**
+     * @brief Publishes registration request for device at given index of this group
+     */
+    void registerDevice(std::size_t index);
+
+    std::size_t size() const;
+    std::size_t registeredDevices() const;
+
+    /**
+     * @brief Starts publishing for registered devices on a dedicated thread
+     */
+    void start();
+    void stop();
+
+    void messageReceived(const std::string& channel, const std::string& payload) override;
+    void connectionLost() override;
+    std::vector<std::string> getChannels() const override;
+
+    static const std::string SENSOR_REFERENCE;
+    static const std::string ALARM_REFERENCE;
+    static const std::string ACTUATOR_REFERENCE;
+    static const std::string CONFIGURATION_REFERENCE;
+
+private:
+    struct Device
+    {
+        explicit Device(std::string deviceKey) : key{std::move(deviceKey)}, registered{false}, registration{0} {}
+
+        const std::string key;
+        std::atomic<bool> registered;
+        std::atomic<std::uint64_t> registration;
+    };
+
+    void run();
+
+    Device* nextRegisteredDevice();
+
+    void publish(std::shared_ptr<Message> message);
+
+    void publishSensorReading(const Device& device);
+    void publishAlarm(const Device& device);
+    void publishStatus(const Device& device, const std::string& topicRoot);
+    void publishActuatorStatus(const Device& device, const std::string& reference, const std::string& value);
+    void publishConfiguration(const Device& device, const std::string& values);
+
+    void handleRegistrationResponse(Device& device, const std::string& payload);
+
+    const LoadConfiguration& m_configuration;
+    LoadStatistics& m_statistics;
+
+    std::vector<std::unique_ptr<Device>> m_devices;
+    std::unordered_map<std::string, Device*> m_devicesByKey;
+    std::size_t m_nextDevice;
+
+    std::unique_ptr<ConnectivityService> m_connectivityService;
+    std::mutex m_publishLock;
+
+    std::atomic<bool> m_running;
+    std::thread m_worker;
+};
+}    // namespace wolkabout
+
+#endif    // SIMULATEDSUBDEVICES_H
@@ -0,0 +1,300 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GatewayInboundDeviceMessageHandler.h"
+#include "GatewayInboundPlatformMessageHandler.h"
+#include "connectivity/ConnectivityService.h"
+#include "model/Message.h"
+#include "persistence/inmemory/GatewayInMemoryPersistence.h"
+#include "protocol/json/JsonGatewayDataProtocol.h"
+#include "protocol/json/JsonGatewayStatusProtocol.h"
+#include "protocol/json/JsonGatewaySubdeviceRegistrationProtocol.h"
+#include "protocol/json/JsonProtocol.h"
+#include "protocol/json/JsonRegistrationProtocol.h"
+#include "protocol/json/JsonStatusProtocol.h"
+#include "repository/SQLiteDeviceRepository.h"
+#include "service/DataService.h"
+#include "service/DeviceStatusService.h"
+#include "service/PublishingService.h"
+#include "service/SubdeviceRegistrationService.h"
+#include "utilities/CommandWatchdog.h"
+#include "utilities/ConsoleLogger.h"
+#include "utilities/Executor.h"
+#include "utilities/Metrics.h"
+#include "utilities/Tracer.h"
+#include "utilities/TrafficCapture.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+
+using namespace wolkabout;
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+// gateway is drained once nothing was published for this long
+const std::chrono::milliseconds DRAIN_IDLE_PERIOD{500};
+const std::chrono::milliseconds DRAIN_POLL_INTERVAL{50};
+
+const std::uint32_t TRACE_SAMPLE_ONE_IN = 100;
+
+/**
+ * Accepts and counts publishes in place of platform and local broker
+ */
+class CountingConnectivityService : public ConnectivityService
+{
+public:
+    bool connect() override { return true; }
+    void disconnect() override {}
+    bool reconnect() override { return true; }
+    bool isConnected() override { return true; }
+
+    bool publish(std::shared_ptr<Message>, bool) override
+    {
+        ++m_published;
+        return true;
+    }
+
+    void setUncontrolledDisonnectMessage(std::shared_ptr<Message>, bool) override {}
+
+    std::uint64_t getPublishedCount() const { return m_published; }
+
+private:
+    std::atomic<std::uint64_t> m_published{0};
+};
+
+void setupLogger()
+{
+    auto logger = std::unique_ptr<wolkabout::ConsoleLogger>(new wolkabout::ConsoleLogger());
+    logger->setLogLevel(wolkabout::LogLevel::WARN);
+    wolkabout::Logger::setInstance(std::move(logger));
+}
+
+// upper bound of bucket holding given quantile of samples, in microseconds
+std::string quantile(const Histogram& histogram, double q)
+{
+    const auto buckets = histogram.buckets();
+    const auto target = static_cast<std::uint64_t>(q * static_cast<double>(histogram.count()));
+
+    std::uint64_t cumulative = 0;
+    for (std::size_t i = 0; i < Histogram::BUCKET_COUNT; ++i)
+    {
+        cumulative += buckets[i];
+        if (cumulative > target)
+        {
+            return "<=" + std::to_string(Histogram::BUCKET_BOUNDS[i]);
+        }
+    }
+
+    return ">" + std::to_string(Histogram::BUCKET_BOUNDS[Histogram::BUCKET_COUNT - 1]);
+}
+
+void reportStages()
+{
+    std::cout << "Stage latency (microseconds):" << std::endl;
+    MetricsRegistry::getInstance().forEachHistogram([](const std::string& name, const Histogram& histogram) {
+        const auto count = histogram.count();
+        if (count == 0)
+        {
+            return;
+        }
+
+        std::cout << "  " << std::left << std::setw(72) << name << " count " << std::setw(10) << count << " mean "
+                  << std::setw(10) << histogram.sumMicroseconds() / count << " p50 " << std::setw(10)
+                  << quantile(histogram, 0.5) << " p99 " << quantile(histogram, 0.99) << std::endl;
+    });
+}
+}    // namespace
+
+int main(int argc, char** argv)
+{
+    setupLogger();
+
+    if (argc < 3)
+    {
+        LOG(ERROR) << "WolkGateway Replay: Usage -  " << argv[0]
+                   << " [captureFile] [gatewayKey] [speed: 1|max|multiplier] [deviceRepository] [traceFile]";
+        return -1;
+    }
+
+    TrafficCaptureReader reader{argv[1]};
+    if (!reader.isValid())
+    {
+        LOG(ERROR) << "WolkGateway Replay: " << argv[1] << " is not a traffic capture";
+        return -1;
+    }
+
+    const std::string gatewayKey = argv[2];
+
+    // 0 replays as fast as the gateway takes messages
+    double speed = 1;
+    if (argc > 3)
+    {
+        speed = std::string(argv[3]) == "max" ? 0 : std::strtod(argv[3], nullptr);
+        if (speed < 0)
+        {
+            LOG(ERROR) << "WolkGateway Replay: Speed must not be negative";
+            return -1;
+        }
+    }
+
+    // copy of production repository makes subdevices known, routing as it did when traffic was captured
+    const std::string repositoryPath = argc > 4 ? argv[4] : ":memory:";
+    const std::string traceFile = argc > 5 ? argv[5] : "";
+
+    // threshold is only there to collect per-command latency histograms, nothing is expected to stall
+    CommandWatchdog::getInstance().configure(std::chrono::hours{1}, false);
+    if (!traceFile.empty())
+    {
+        Tracer::getInstance().configure(TRACE_SAMPLE_ONE_IN);
+    }
+
+    JsonProtocol dataProtocol{true};
+    JsonGatewayDataProtocol gatewayDataProtocol;
+    JsonStatusProtocol statusProtocol;
+    JsonGatewayStatusProtocol gatewayStatusProtocol;
+    JsonRegistrationProtocol registrationProtocol;
+    JsonGatewaySubdeviceRegistrationProtocol gatewayRegistrationProtocol;
+    SQLiteDeviceRepository repository{repositoryPath};
+    Executor executor;
+
+    CountingConnectivityService platformConnectivityService;
+    CountingConnectivityService deviceConnectivityService;
+    PublishingService platformPublisher{platformConnectivityService,
+                                        std::unique_ptr<GatewayPersistence>(new GatewayInMemoryPersistence()), 64,
+                                        "replay_platform_publisher"};
+    PublishingService devicePublisher{deviceConnectivityService,
+                                      std::unique_ptr<GatewayPersistence>(new GatewayInMemoryPersistence()), 64,
+                                      "replay_device_publisher"};
+    platformPublisher.connected();
+    devicePublisher.connected();
+
+    auto dataService = std::make_shared<DataService>(gatewayKey, dataProtocol, gatewayDataProtocol, &repository,
+                                                     platformPublisher, devicePublisher);
+    auto deviceStatusService =
+      std::make_shared<DeviceStatusService>(gatewayKey, statusProtocol, gatewayStatusProtocol, &repository,
+                                            platformPublisher, devicePublisher, std::chrono::seconds{60});
+    auto subdeviceRegistrationService = std::make_shared<SubdeviceRegistrationService>(
+      gatewayKey, registrationProtocol, gatewayRegistrationProtocol, repository, platformPublisher, devicePublisher,
+      executor);
+
+    GatewayInboundPlatformMessageHandler platformHandler{gatewayKey};
+    platformHandler.addListener(dataService);
+    platformHandler.addListener(deviceStatusService);
+    platformHandler.addListener(subdeviceRegistrationService);
+
+    GatewayInboundDeviceMessageHandler deviceHandler;
+    deviceHandler.addListener(dataService);
+    deviceHandler.addListener(deviceStatusService);
+    deviceHandler.addListener(subdeviceRegistrationService);
+
+    std::uint64_t platformRecords = 0;
+    std::uint64_t deviceRecords = 0;
+    Clock::duration maxLag{0};
+
+    const auto start = Clock::now();
+    TrafficCapture::Record record;
+    while (reader.next(record))
+    {
+        if (speed > 0)
+        {
+            const auto due = start + std::chrono::duration_cast<Clock::duration>(
+                                       std::chrono::duration<double, std::micro>(
+                                         static_cast<double>(record.offset.count()) / speed));
+            const auto now = Clock::now();
+            if (due > now)
+            {
+                std::this_thread::sleep_until(due);
+            }
+            else if (now - due > maxLag)
+            {
+                maxLag = now - due;
+            }
+        }
+
+        if (record.side == TrafficCapture::Side::PLATFORM)
+        {
+            platformHandler.messageReceived(record.channel, record.payload);
+            ++platformRecords;
+        }
+        else
+        {
+            deviceHandler.messageReceived(record.channel, record.payload);
+            ++deviceRecords;
+        }
+    }
+
+    const auto injected = Clock::now();
+
+    auto published = [&] {
+        return platformConnectivityService.getPublishedCount() + deviceConnectivityService.getPublishedCount();
+    };
+
+    auto lastPublished = published();
+    auto lastChange = injected;
+    while (Clock::now() - lastChange < DRAIN_IDLE_PERIOD)
+    {
+        std::this_thread::sleep_for(DRAIN_POLL_INTERVAL);
+
+        const auto current = published();
+        if (current != lastPublished)
+        {
+            lastPublished = current;
+            lastChange = Clock::now();
+        }
+    }
+
+    const auto seconds = [](Clock::duration duration) {
+        return std::chrono::duration_cast<std::chrono::duration<double>>(duration).count();
+    };
+
+    const auto records = platformRecords + deviceRecords;
+    const auto replayTime = seconds(injected - start);
+    const auto totalTime = seconds(lastChange - start);
+
+    std::cout << "Replayed " << records << " messages (" << platformRecords << " platform, " << deviceRecords
+              << " device) in " << replayTime << " s" << std::endl;
+    std::cout << "Inbound throughput: " << (replayTime > 0 ? static_cast<double>(records) / replayTime : 0)
+              << " msg/s" << std::endl;
+    std::cout << "Published " << platformConnectivityService.getPublishedCount() << " messages to platform and "
+              << deviceConnectivityService.getPublishedCount() << " to devices, drained "
+              << seconds(lastChange - injected) << " s after last message" << std::endl;
+    std::cout << "Outbound throughput: " << (totalTime > 0 ? static_cast<double>(lastPublished) / totalTime : 0)
+              << " msg/s" << std::endl;
+    if (speed > 0)
+    {
+        std::cout << "Largest lag behind capture timing: " << seconds(maxLag) << " s" << std::endl;
+    }
+
+    reportStages();
+
+    if (!traceFile.empty() && !Tracer::getInstance().dump(traceFile))
+    {
+        LOG(ERROR) << "WolkGateway Replay: Unable to write trace to " << traceFile;
+    }
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "connectivity/ShardRouter.h"
+#include "connectivity/mqtt/MqttConnectivityService.h"
+#include "connectivity/mqtt/PahoMqttClient.h"
+#include "protocol/json/JsonGatewayDFUProtocol.h"
+#include "protocol/json/JsonGatewayDataProtocol.h"
+#include "protocol/json/JsonGatewayStatusProtocol.h"
+#include "protocol/json/JsonGatewaySubdeviceRegistrationProtocol.h"
+#include "utilities/ConsoleLogger.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+const std::chrono::seconds RECONNECT_INTERVAL{1};
+
+volatile std::sig_atomic_t running = 1;
+
+void stop(int)
+{
+    running = 0;
+}
+
+void setupLogger()
+{
+    auto logger = std::unique_ptr<wolkabout::ConsoleLogger>(new wolkabout::ConsoleLogger());
+    logger->setLogLevel(wolkabout::LogLevel::INFO);
+    wolkabout::Logger::setInstance(std::move(logger));
+}
+
+std::vector<std::string> deviceChannels()
+{
+    std::vector<std::string> channels;
+    const auto add = [&](const wolkabout::GatewayProtocol& protocol) {
+        for (const auto& channel : protocol.getInboundChannels())
+        {
+            channels.push_back(channel);
+        }
+    };
+
+    add(wolkabout::JsonGatewayDataProtocol());
+    add(wolkabout::JsonGatewayStatusProtocol());
+    add(wolkabout::JsonGatewaySubdeviceRegistrationProtocol());
+    add(wolkabout::JsonGatewayDFUProtocol());
+    return channels;
+}
+}    // namespace
+
+int main(int argc, char** argv)
+{
+    setupLogger();
+
+    if (argc < 3)
+    {
+        LOG(ERROR) << "WolkGateway ShardRouter: Usage -  " << argv[0] << " [localMqttUri] [shardCount] [clientId]";
+        return -1;
+    }
+
+    const auto shardCount = static_cast<std::size_t>(std::strtoul(argv[2], nullptr, 10));
+    if (shardCount == 0)
+    {
+        LOG(ERROR) << "WolkGateway ShardRouter: Shard count must be greater than 0";
+        return -1;
+    }
+
+    const std::string clientId = argc > 3 ? argv[3] : "GatewayShardRouter";
+    std::unique_ptr<wolkabout::ConnectivityService> connection{new wolkabout::MqttConnectivityService(
+      std::make_shared<wolkabout::PahoMqttClient>(), "", "", argv[1], clientId)};
+    wolkabout::ShardRouter router{std::move(connection), deviceChannels(), shardCount};
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    bool connected = false;
+    while (running)
+    {
+        if (!connected || router.hasLostConnection())
+        {
+            connected = router.connect();
+            if (!connected)
+            {
+                LOG(WARN) << "WolkGateway ShardRouter: Unable to connect to local broker at " << argv[1];
+            }
+        }
+
+        std::this_thread::sleep_for(RECONNECT_INTERVAL);
+    }
+
+    router.disconnect();
+    return 0;
+}
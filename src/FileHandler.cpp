@@ -17,20 +17,147 @@
 #include "FileHandler.h"
 #include "model/BinaryData.h"
 #include "utilities/FileSystemUtils.h"
+#include "utilities/Logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace
+{
+const std::size_t RESUME_READ_BLOCK_SIZE = 64 * 1024;
+}    // namespace
 
 namespace wolkabout
 {
-FileHandler::FileHandler() : m_currentPacketData{}, m_previousPacketHash{} {}
+FileHandler::FileHandler()
+: m_memory{MemoryBudget::getInstance().account("file_packet_buffer")}
+, m_currentPacketData{}, m_previousPacketHash{}, m_fileDescriptor{-1}, m_temporaryFilePath{}, m_writtenSize{0}
+{
+}
+
+FileHandler::~FileHandler()
+{
+    clear();
+}
 
 void FileHandler::clear()
 {
+    m_memory.release(m_currentPacketData.size());
     m_currentPacketData = {};
     m_previousPacketHash = {};
+
+    if (!m_temporaryFilePath.empty())
+    {
+        closeTemporaryFile();
+        std::remove(m_temporaryFilePath.c_str());
+        m_temporaryFilePath.clear();
+    }
+
+    m_writtenSize = 0;
+    m_fileHash.reset();
+    m_fileDigest = {};
+}
+
+FileHandler::StatusCode FileHandler::streamTo(const std::string& temporaryFilePath)
+{
+    clear();
+
+    m_fileDescriptor = ::open(temporaryFilePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (m_fileDescriptor < 0)
+    {
+        LOG(ERROR) << "FileHandler: Unable to create file '" << temporaryFilePath << "': " << std::strerror(errno);
+        return FileHandler::StatusCode::FILE_HANDLING_ERROR;
+    }
+
+    m_temporaryFilePath = temporaryFilePath;
+    return FileHandler::StatusCode::OK;
+}
+
+FileHandler::StatusCode FileHandler::resume(const std::string& temporaryFilePath, std::uint64_t offset,
+                                            const ByteArray& previousPacketHash)
+{
+    clear();
+
+    m_fileDescriptor = ::open(temporaryFilePath.c_str(), O_RDWR);
+    if (m_fileDescriptor < 0)
+    {
+        LOG(ERROR) << "FileHandler: Unable to open file '" << temporaryFilePath << "': " << std::strerror(errno);
+        return FileHandler::StatusCode::FILE_HANDLING_ERROR;
+    }
+
+    m_temporaryFilePath = temporaryFilePath;
+
+    struct stat info;
+    if (::fstat(m_fileDescriptor, &info) != 0 || static_cast<std::uint64_t>(info.st_size) < offset ||
+        ::ftruncate(m_fileDescriptor, static_cast<off_t>(offset)) != 0)
+    {
+        LOG(ERROR) << "FileHandler: Unable to resume file '" << temporaryFilePath << "' at " << offset;
+        clear();
+        return FileHandler::StatusCode::FILE_HANDLING_ERROR;
+    }
+
+    ByteArray buffer(RESUME_READ_BLOCK_SIZE);
+    while (m_writtenSize < offset)
+    {
+        const auto length = static_cast<std::size_t>(std::min<std::uint64_t>(buffer.size(), offset - m_writtenSize));
+        const auto result = ::pread(m_fileDescriptor, buffer.data(), length, static_cast<off_t>(m_writtenSize));
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (result <= 0)
+        {
+            LOG(ERROR) << "FileHandler: Unable to read file '" << temporaryFilePath << "': " << std::strerror(errno);
+            clear();
+            return FileHandler::StatusCode::FILE_HANDLING_ERROR;
+        }
+
+        m_fileHash.update(buffer.data(), static_cast<std::size_t>(result));
+        m_writtenSize += static_cast<std::uint64_t>(result);
+    }
+
+    m_previousPacketHash = previousPacketHash;
+    return FileHandler::StatusCode::OK;
 }
 
-FileHandler::StatusCode FileHandler::handleData(const BinaryData& binaryData)
+FileHandler::StatusCode FileHandler::sync()
 {
-    if (!binaryData.valid())
+    if (m_fileDescriptor >= 0 && ::fdatasync(m_fileDescriptor) != 0)
+    {
+        LOG(ERROR) << "FileHandler: Unable to sync file '" << m_temporaryFilePath << "': " << std::strerror(errno);
+        return FileHandler::StatusCode::FILE_HANDLING_ERROR;
+    }
+
+    return FileHandler::StatusCode::OK;
+}
+
+void FileHandler::detach()
+{
+    closeTemporaryFile();
+    m_temporaryFilePath.clear();
+    clear();
+}
+
+std::uint64_t FileHandler::getWrittenSize() const
+{
+    return m_writtenSize;
+}
+
+const ByteArray& FileHandler::getPreviousPacketHash() const
+{
+    return m_previousPacketHash;
+}
+
+FileHandler::StatusCode FileHandler::handleData(const BinaryData& binaryData, bool hashVerified)
+{
+    if (!hashVerified && Sha256::hash(binaryData.getData()) != binaryData.getHash())
     {
         return FileHandler::StatusCode::PACKAGE_HASH_NOT_VALID;
     }
@@ -50,15 +177,59 @@ FileHandler::StatusCode FileHandler::handleData(const BinaryData& binaryData)
         }
     }
 
-    m_currentPacketData.insert(m_currentPacketData.end(), binaryData.getData().begin(), binaryData.getData().end());
+    const auto& data = binaryData.getData();
+
+    if (m_temporaryFilePath.empty())
+    {
+        if (!MemoryBudget::getInstance().allows(data.size()))
+        {
+            LOG(ERROR) << "FileHandler: Memory budget exceeded, file is too large to be kept in memory";
+            return FileHandler::StatusCode::FILE_HANDLING_ERROR;
+        }
+
+        m_currentPacketData.insert(m_currentPacketData.end(), data.begin(), data.end());
+        m_memory.add(data.size());
+    }
+    else
+    {
+        std::size_t written = 0;
+        while (written < data.size())
+        {
+            // positional write right after previously validated data
+            const auto result = ::pwrite(m_fileDescriptor, data.data() + written, data.size() - written,
+                                         static_cast<off_t>(m_writtenSize + written));
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+
+                LOG(ERROR) << "FileHandler: Unable to write to file '" << m_temporaryFilePath
+                           << "': " << std::strerror(errno);
+                return FileHandler::StatusCode::FILE_HANDLING_ERROR;
+            }
+
+            written += static_cast<std::size_t>(result);
+        }
+
+        m_writtenSize += data.size();
+    }
+
+    m_fileHash.update(data);
     m_previousPacketHash = binaryData.getHash();
 
     return FileHandler::StatusCode::OK;
 }
 
-FileHandler::StatusCode FileHandler::validateFile(const ByteArray& fileHash) const
+FileHandler::StatusCode FileHandler::validateFile(const ByteArray& fileHash)
 {
-    if (fileHash == ByteUtils::hashSHA256(m_currentPacketData))
+    if (m_fileDigest.empty())
+    {
+        m_fileDigest = m_fileHash.digest();
+    }
+
+    if (fileHash == m_fileDigest)
     {
         return FileHandler::StatusCode::OK;
     }
@@ -66,21 +237,50 @@ FileHandler::StatusCode FileHandler::validateFile(const ByteArray& fileHash) con
     return FileHandler::StatusCode::FILE_HASH_NOT_VALID;
 }
 
-FileHandler::StatusCode FileHandler::saveFile(const std::string& filePath) const
+FileHandler::StatusCode FileHandler::saveFile(const std::string& filePath)
 {
-    if (FileSystemUtils::createBinaryFileWithContent(filePath, m_currentPacketData))
+    if (m_temporaryFilePath.empty())
     {
-        return FileHandler::StatusCode::OK;
+        if (FileSystemUtils::createBinaryFileWithContent(filePath, m_currentPacketData))
+        {
+            return FileHandler::StatusCode::OK;
+        }
+
+        return FileHandler::StatusCode::FILE_HANDLING_ERROR;
+    }
+
+    if (::fsync(m_fileDescriptor) != 0)
+    {
+        LOG(ERROR) << "FileHandler: Unable to sync file '" << m_temporaryFilePath << "': " << std::strerror(errno);
+        return FileHandler::StatusCode::FILE_HANDLING_ERROR;
+    }
+
+    closeTemporaryFile();
+
+    // rename replaces target atomically, so a partially written file is never visible under its final name
+    if (std::rename(m_temporaryFilePath.c_str(), filePath.c_str()) != 0)
+    {
+        LOG(ERROR) << "FileHandler: Unable to move file to '" << filePath << "': " << std::strerror(errno);
+        return FileHandler::StatusCode::FILE_HANDLING_ERROR;
     }
 
-    return FileHandler::StatusCode::FILE_HANDLING_ERROR;
+    m_temporaryFilePath.clear();
+    return FileHandler::StatusCode::OK;
 }
 
-FileHandler::StatusCode FileHandler::saveFile(const std::string& fileName, const std::string& directory) const
+FileHandler::StatusCode FileHandler::saveFile(const std::string& fileName, const std::string& directory)
 {
     const std::string path = FileSystemUtils::composePath(fileName, directory);
 
     return saveFile(path);
 }
 
+void FileHandler::closeTemporaryFile()
+{
+    if (m_fileDescriptor >= 0)
+    {
+        ::close(m_fileDescriptor);
+        m_fileDescriptor = -1;
+    }
+}
 }    // namespace wolkabout
@@ -18,6 +18,10 @@
 #define FILEHANDLER_H
 
 #include "utilities/ByteUtils.h"
+#include "utilities/MemoryBudget.h"
+#include "utilities/Sha256.h"
+
+#include <cstdint>
 #include <string>
 
 namespace wolkabout
@@ -38,21 +42,76 @@ public:
 
     FileHandler();
 
-    virtual ~FileHandler() = default;
+    virtual ~FileHandler();
+
+    FileHandler(const FileHandler&) = delete;
+    FileHandler& operator=(const FileHandler&) = delete;
 
     void clear();
 
-    FileHandler::StatusCode handleData(const BinaryData& binaryData);
+    /**
+     * @brief Switches handler to streaming mode until next clear
+     *
+     * Validated packets are written to temporary file instead of being kept in memory, and file hash
+     * is computed as they arrive. Temporary file is renamed to its final path by saveFile,
+     * and removed by clear if file was not saved.
+     * @param temporaryFilePath Path of file packets are written to
+     * @return FILE_HANDLING_ERROR if temporary file could not be created
+     */
+    FileHandler::StatusCode streamTo(const std::string& temporaryFilePath);
+
+    /**
+     * @brief Continues streaming into partially written temporary file
+     *
+     * Data beyond offset is discarded, and data before it is hashed again, so that file hash
+     * covers the whole file once remaining packets are handled.
+     * @param temporaryFilePath Path of partially written file
+     * @param offset Number of bytes already written and validated
+     * @param previousPacketHash Hash of last packet written before offset
+     * @return FILE_HANDLING_ERROR if file is missing, shorter than offset or can not be read
+     */
+    FileHandler::StatusCode resume(const std::string& temporaryFilePath, std::uint64_t offset,
+                                   const ByteArray& previousPacketHash);
+
+    /**
+     * @brief Flushes data written to temporary file to storage
+     */
+    FileHandler::StatusCode sync();
+
+    /**
+     * @brief Closes temporary file without removing it, so that transfer can be resumed later
+     */
+    void detach();
+
+    std::uint64_t getWrittenSize() const;
 
-    FileHandler::StatusCode validateFile(const ByteArray& fileHash) const;
+    const ByteArray& getPreviousPacketHash() const;
 
-    FileHandler::StatusCode saveFile(const std::string& filePath) const;
+    /**
+     * @param hashVerified Set when caller has already checked packet hash, which is then not computed again
+     */
+    FileHandler::StatusCode handleData(const BinaryData& binaryData, bool hashVerified = false);
 
-    FileHandler::StatusCode saveFile(const std::string& fileName, const std::string& directory) const;
+    FileHandler::StatusCode validateFile(const ByteArray& fileHash);
+
+    FileHandler::StatusCode saveFile(const std::string& filePath);
+
+    FileHandler::StatusCode saveFile(const std::string& fileName, const std::string& directory);
 
 private:
+    void closeTemporaryFile();
+
+    MemoryAccount& m_memory;
+
     ByteArray m_currentPacketData;
     ByteArray m_previousPacketHash;
+
+    int m_fileDescriptor;
+    std::string m_temporaryFilePath;
+    std::uint64_t m_writtenSize;
+    // updated as packets arrive, so file hash is known once the last one is handled
+    Sha256 m_fileHash;
+    ByteArray m_fileDigest;
 };
 }    // namespace wolkabout
 
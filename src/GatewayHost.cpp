@@ -0,0 +1,131 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GatewayHost.h"
+#include "Wolk.h"
+#include "WolkBuilder.h"
+#include "utilities/Executor.h"
+#include "utilities/Logger.h"
+#include "utilities/Metrics.h"
+#include "utilities/MetricsFileExporter.h"
+
+#include <cerrno>
+#include <stdexcept>
+#include <sys/stat.h>
+
+namespace wolkabout
+{
+const std::size_t GatewayHost::DEFAULT_WORKERS = 4;
+
+GatewayHost::GatewayHost(std::string storageDirectory, std::size_t workers)
+: m_storageDirectory{std::move(storageDirectory)}, m_executor{std::make_shared<Executor>(workers)}
+{
+}
+
+GatewayHost::~GatewayHost()
+{
+    // gateways cancel their tasks on destruction, which needs the executor to still be running
+    std::lock_guard<std::mutex> lg{m_lock};
+    while (!m_gateways.empty())
+    {
+        m_gateways.pop_back();
+    }
+
+    m_metricsExporter.reset();
+}
+
+Wolk& GatewayHost::addGateway(const GatewayDevice& device, const Configurator& configure)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    for (const auto& gateway : m_gateways)
+    {
+        if (gateway.first == device.getKey())
+        {
+            throw std::logic_error("Gateway with key '" + device.getKey() + "' is already hosted");
+        }
+    }
+
+    const std::string directory = m_storageDirectory + "/" + device.getKey();
+    if (::mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        LOG(ERROR) << "GatewayHost: Unable to create directory '" << directory << "'";
+    }
+
+    WolkBuilder builder = Wolk::newBuilder(device);
+    builder.storageDirectory(directory);
+    if (configure)
+    {
+        configure(builder);
+    }
+    builder.executor(m_executor);
+
+    m_gateways.emplace_back(device.getKey(), builder.build());
+    LOG(INFO) << "GatewayHost: Hosting gateway '" << device.getKey() << "', " << m_gateways.size() << " in total";
+
+    return *m_gateways.back().second;
+}
+
+Wolk* GatewayHost::getGateway(const std::string& key)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    for (const auto& gateway : m_gateways)
+    {
+        if (gateway.first == key)
+        {
+            return gateway.second.get();
+        }
+    }
+
+    return nullptr;
+}
+
+std::size_t GatewayHost::getGatewayCount()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return m_gateways.size();
+}
+
+void GatewayHost::exportMetrics(const std::string& path, std::chrono::milliseconds interval)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    m_metricsExporter.reset();
+    m_metricsExporter.reset(new MetricsFileExporter(MetricsRegistry::getInstance(), path, interval, *m_executor));
+}
+
+void GatewayHost::connect()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    for (const auto& gateway : m_gateways)
+    {
+        gateway.second->connect();
+    }
+}
+
+void GatewayHost::disconnect()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    for (const auto& gateway : m_gateways)
+    {
+        gateway.second->disconnect();
+    }
+}
+}    // namespace wolkabout
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GATEWAYHOST_H
+#define GATEWAYHOST_H
+
+#include "model/GatewayDevice.h"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+class Executor;
+class MetricsFileExporter;
+class Wolk;
+class WolkBuilder;
+
+/**
+ * @brief Runs several gateways in one process on shared resources
+ *
+ * Hosted gateways run their background and delayed work on one wolkabout::Executor instead of
+ * a pool and timer thread each, and the process wide wolkabout::MetricsRegistry they report to is exported
+ * to a single file. Metrics are not labeled per gateway, counters and histograms are totals of all hosted
+ * gateways and gauges hold the value last set by any of them. Each gateway keeps its repositories in
+ * a directory named after its key, below the storage directory of the host.
+ *
+ * Gateways are destroyed before the shared executor, in reverse order of adding.
+ */
+class GatewayHost
+{
+public:
+    using Configurator = std::function<void(WolkBuilder& builder)>;
+
+    static const std::size_t DEFAULT_WORKERS;
+
+    /**
+     * @param storageDirectory Directory below which repositories of gateways are kept, it must exist
+     * @param workers Number of worker threads shared by hosted gateways
+     */
+    explicit GatewayHost(std::string storageDirectory = ".", std::size_t workers = DEFAULT_WORKERS);
+    ~GatewayHost();
+
+    GatewayHost(const GatewayHost&) = delete;
+    GatewayHost& operator=(const GatewayHost&) = delete;
+
+    /**
+     * @brief Builds gateway which runs on resources of this host
+     * @param device Gateway device, its key must differ from keys of gateways already added
+     * @param configure Applies gateway specific settings to builder, executor and storage directory are set by host
+     * @return Built gateway, owned by host
+     * @throws std::logic_error if gateway with same key is already hosted, or builder rejects configuration
+     */
+    Wolk& addGateway(const GatewayDevice& device, const Configurator& configure = nullptr);
+
+    /**
+     * @brief Returns hosted gateway with given key, or nullptr if there is none
+     */
+    Wolk* getGateway(const std::string& key);
+
+    std::size_t getGatewayCount();
+
+    /**
+     * @brief Periodically writes metrics of all hosted gateways to file in Prometheus text format
+     * Gateways report to the same registry, so hosted gateways should not export metrics themselves
+     */
+    void exportMetrics(const std::string& path, std::chrono::milliseconds interval = std::chrono::seconds{10});
+
+    void connect();
+    void disconnect();
+
+private:
+    const std::string m_storageDirectory;
+
+    std::shared_ptr<Executor> m_executor;
+    std::unique_ptr<MetricsFileExporter> m_metricsExporter;
+
+    std::mutex m_lock;
+    std::vector<std::pair<std::string, std::unique_ptr<Wolk>>> m_gateways;
+};
+}    // namespace wolkabout
+
+#endif    // GATEWAYHOST_H
@@ -17,46 +17,138 @@
 #include "GatewayInboundDeviceMessageHandler.h"
 #include "model/Message.h"
 #include "protocol/GatewayProtocol.h"
-#include "utilities/Logger.h"
-#include "utilities/StringUtils.h"
-#include <algorithm>
+#include "utilities/CommandWatchdog.h"
+#include "utilities/GatewayLog.h"
+#include "utilities/MessagePool.h"
+#include "utilities/Tracer.h"
+
+namespace
+{
+const std::string DEVICE_PATH_PREFIX = "/d/";
+
+std::string deviceKeyFromChannel(const std::string& channel)
+{
+    const auto start = channel.find(DEVICE_PATH_PREFIX);
+    if (start == std::string::npos)
+    {
+        return "";
+    }
+
+    const auto keyStart = start + DEVICE_PATH_PREFIX.size();
+    return channel.substr(keyStart, channel.find('/', keyStart) - keyStart);
+}
+}    // namespace
 
 namespace wolkabout
 {
-GatewayInboundDeviceMessageHandler::GatewayInboundDeviceMessageHandler() : m_commandBuffer{new CommandBuffer()} {}
+GatewayInboundDeviceMessageHandler::GatewayInboundDeviceMessageHandler(std::size_t workers)
+: m_commandBuffer{workers <= 1 ? new CommandBuffer() : nullptr}
+, m_dispatcher{workers <= 1 ? nullptr : new ShardedDispatcher(workers)}
+, m_backpressure{false}
+, m_backpressureDelay{0}
+, m_receivedMessages{MetricsRegistry::getInstance().counter("wolkgateway_inbound_device_messages_total")}
+, m_unroutedMessages{MetricsRegistry::getInstance().counter("wolkgateway_inbound_device_unrouted_messages_total")}
+, m_shedMessages{MetricsRegistry::getInstance().counter("wolkgateway_inbound_device_shed_messages_total")}
+, m_queueDepth{MetricsRegistry::getInstance().gauge("wolkgateway_inbound_device_queue_depth")}
+, m_routingLatency{MetricsRegistry::getInstance().histogram("wolkgateway_inbound_device_routing_latency_seconds")}
+{
+}
 
 void GatewayInboundDeviceMessageHandler::messageReceived(const std::string& channel, const std::string& payload)
 {
-    LOG(DEBUG) << "GatewayInboundDeviceMessageHandler: Received message on channel: '" << channel << "'. Payload: '"
-               << payload << "'";
+    GATEWAY_LOG(DEBUG) << "GatewayInboundDeviceMessageHandler: Received message on channel: '" << channel
+                       << "'. Payload: '" << payload << "'";
+
+    m_receivedMessages.increment();
+
+    const auto traceId = Tracer::getInstance().sample();
+    TraceSpan span{"device_message_received", traceId};
+
+    const auto deviceKey = m_rateLimiter || m_statistics ? deviceKeyFromChannel(channel) : std::string{};
+    const auto statistics = deviceKey.empty() ? nullptr : m_statistics;
+    if (statistics)
+    {
+        statistics->messageReceived(deviceKey, channel.size() + payload.size());
+    }
+
+    // flooding device is cut off before its messages take up queue space shared with other devices
+    if (m_rateLimiter && !deviceKey.empty() && !m_rateLimiter->allow(deviceKey))
+    {
+        GATEWAY_LOG(DEBUG) << "GatewayInboundDeviceMessageHandler: Rate limit of device '" << deviceKey
+                           << "' exceeded, dropping message on channel: " << channel;
+        if (statistics)
+        {
+            statistics->messageRejected(deviceKey);
+        }
+        return;
+    }
+
+    if (m_backpressure && shed(channel))
+    {
+        GATEWAY_LOG(DEBUG) << "GatewayInboundDeviceMessageHandler: Platform is not keeping up, dropping message on "
+                           << "channel: " << channel;
+        if (statistics)
+        {
+            statistics->messageRejected(deviceKey);
+        }
+        return;
+    }
 
     std::lock_guard<std::mutex> lg{m_lock};
 
-    auto it = std::find_if(m_channelHandlers.begin(), m_channelHandlers.end(),
-                           [&](const std::pair<std::string, std::weak_ptr<DeviceMessageListener>>& kvp) {
-                               return StringUtils::mqttTopicMatch(kvp.first, channel);
-                           });
+    const auto* listener = m_channelHandlers.match(channel);
 
-    if (it != m_channelHandlers.end())
+    if (listener)
     {
-        auto channelHandler = it->second;
-        addToCommandBuffer([=] {
+        // payload is copied only once, into the message shared with the listener
+        auto channelHandler = *listener;
+        auto message = MessagePool::make(payload, channel);
+        const auto receivedAt = std::chrono::steady_clock::now();
+        m_queueDepth.increment();
+        dispatch(channel, [=] {
+            m_queueDepth.decrement();
+            if (traceId != 0)
+            {
+                Tracer::getInstance().record("inbound_device_queue", traceId, receivedAt,
+                                             std::chrono::steady_clock::now());
+            }
+
+            TraceScope scope{traceId};
+            TraceSpan handling{"device_message_handling", traceId};
             if (auto handler = channelHandler.lock())
             {
-                handler->deviceMessageReceived(std::make_shared<Message>(payload, channel));
+                handler->deviceMessageReceived(message);
+            }
+            const auto latency = std::chrono::steady_clock::now() - receivedAt;
+            m_routingLatency.record(latency);
+            if (statistics)
+            {
+                statistics->messageForwarded(deviceKey, latency);
             }
         });
     }
     else
     {
-        LOG(DEBUG) << "GatewayInboundDeviceMessageHandler: Handler for device channel not found: " << channel;
+        m_unroutedMessages.increment();
+        if (statistics)
+        {
+            statistics->messageRejected(deviceKey);
+        }
+        GATEWAY_LOG(DEBUG) << "GatewayInboundDeviceMessageHandler: Handler for device channel not found: " << channel;
     }
 }
 
 std::vector<std::string> GatewayInboundDeviceMessageHandler::getChannels() const
 {
     std::lock_guard<std::mutex> lg{m_lock};
-    return m_subscriptionList;
+
+    auto channels = m_subscriptionList;
+    for (const auto& device : m_deviceSubscriptions)
+    {
+        channels.insert(channels.end(), device.second.begin(), device.second.end());
+    }
+
+    return channels;
 }
 
 void GatewayInboundDeviceMessageHandler::addListener(std::weak_ptr<DeviceMessageListener> listener)
@@ -67,15 +159,159 @@ void GatewayInboundDeviceMessageHandler::addListener(std::weak_ptr<DeviceMessage
     {
         for (const auto& channel : handler->getGatewayProtocol().getInboundChannels())
         {
-            LOG(DEBUG) << "Adding listener for channel: " << channel;
-            m_channelHandlers[channel] = listener;
+            GATEWAY_LOG(DEBUG) << "Adding listener for channel: " << channel;
+            m_channelHandlers.insert(channel, listener);
             m_subscriptionList.push_back(channel);
         }
     }
 }
 
+void GatewayInboundDeviceMessageHandler::addPerDeviceListener(std::weak_ptr<DeviceMessageListener> listener)
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    if (auto handler = listener.lock())
+    {
+        // wildcard channels still route messages of subscribed devices, they are just not subscribed to
+        for (const auto& channel : handler->getGatewayProtocol().getInboundChannels())
+        {
+            GATEWAY_LOG(DEBUG) << "Adding per device listener for channel: " << channel;
+            m_channelHandlers.insert(channel, listener);
+        }
+
+        m_perDeviceListeners.push_back(listener);
+    }
+}
+
+bool GatewayInboundDeviceMessageHandler::subscribeDevice(const std::string& deviceKey)
+{
+    std::function<void()> subscriptionListener;
+
+    {
+        std::lock_guard<std::mutex> locker{m_lock};
+
+        if (m_perDeviceListeners.empty() || m_deviceSubscriptions.count(deviceKey) != 0)
+        {
+            return false;
+        }
+
+        std::vector<std::string> channels;
+        for (const auto& listener : m_perDeviceListeners)
+        {
+            if (auto handler = listener.lock())
+            {
+                const auto deviceChannels = handler->getGatewayProtocol().getInboundChannelsForDevice(deviceKey);
+                channels.insert(channels.end(), deviceChannels.begin(), deviceChannels.end());
+            }
+        }
+
+        m_deviceSubscriptions.emplace(deviceKey, std::move(channels));
+        subscriptionListener = m_subscriptionListener;
+    }
+
+    if (subscriptionListener)
+    {
+        subscriptionListener();
+    }
+
+    return true;
+}
+
+bool GatewayInboundDeviceMessageHandler::unsubscribeDevice(const std::string& deviceKey)
+{
+    std::function<void()> subscriptionListener;
+
+    {
+        std::lock_guard<std::mutex> locker{m_lock};
+
+        if (m_deviceSubscriptions.erase(deviceKey) == 0)
+        {
+            return false;
+        }
+
+        subscriptionListener = m_subscriptionListener;
+    }
+
+    if (subscriptionListener)
+    {
+        subscriptionListener();
+    }
+
+    return true;
+}
+
+void GatewayInboundDeviceMessageHandler::setSubscriptionListener(std::function<void()> listener)
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+    m_subscriptionListener = std::move(listener);
+}
+
+void GatewayInboundDeviceMessageHandler::setRateLimiter(std::shared_ptr<DeviceRateLimiter> rateLimiter)
+{
+    m_rateLimiter = std::move(rateLimiter);
+}
+
+void GatewayInboundDeviceMessageHandler::setDeviceStatistics(std::shared_ptr<DeviceStatistics> statistics)
+{
+    m_statistics = std::move(statistics);
+}
+
+void GatewayInboundDeviceMessageHandler::addSheddableChannel(const std::string& filter)
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+    m_sheddableChannels.insert(filter, true);
+}
+
+void GatewayInboundDeviceMessageHandler::setBackpressureDelay(std::chrono::milliseconds delay)
+{
+    m_backpressureDelay = delay;
+}
+
+void GatewayInboundDeviceMessageHandler::setBackpressure(bool enabled)
+{
+    {
+        std::lock_guard<std::mutex> locker{m_backpressureLock};
+        m_backpressure = enabled;
+    }
+
+    m_backpressureReleased.notify_all();
+}
+
+bool GatewayInboundDeviceMessageHandler::shed(const std::string& channel)
+{
+    {
+        std::lock_guard<std::mutex> locker{m_lock};
+        if (!m_sheddableChannels.match(channel))
+        {
+            return false;
+        }
+    }
+
+    std::unique_lock<std::mutex> locker{m_backpressureLock};
+    if (m_backpressureReleased.wait_for(locker, m_backpressureDelay, [&] { return !m_backpressure; }))
+    {
+        return false;
+    }
+
+    m_shedMessages.increment();
+    return true;
+}
+
 void GatewayInboundDeviceMessageHandler::addToCommandBuffer(std::function<void()> command)
 {
-    m_commandBuffer->pushCommand(std::make_shared<std::function<void()>>(command));
+    m_commandBuffer->pushCommand(std::make_shared<std::function<void()>>(std::move(command)));
+}
+
+void GatewayInboundDeviceMessageHandler::dispatch(const std::string& channel, std::function<void()> command)
+{
+    auto tracked = CommandWatchdog::getInstance().track("inbound_device", channel, std::move(command));
+    if (m_dispatcher)
+    {
+        m_dispatcher->dispatch(deviceKeyFromChannel(channel), std::move(tracked));
+    }
+    else
+    {
+        addToCommandBuffer(std::move(tracked));
+    }
 }
 }    // namespace wolkabout
@@ -19,7 +19,17 @@
 
 #include "InboundDeviceMessageHandler.h"
 #include "utilities/CommandBuffer.h"
+#include "utilities/DeviceRateLimiter.h"
+#include "utilities/DeviceStatistics.h"
+#include "utilities/Metrics.h"
+#include "utilities/ShardedDispatcher.h"
+#include "utilities/TopicTrie.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -33,7 +43,11 @@ class Message;
 class GatewayInboundDeviceMessageHandler : public InboundDeviceMessageHandler
 {
 public:
-    GatewayInboundDeviceMessageHandler();
+    /**
+     * @param workers Number of threads dispatching messages to listeners. With more than one,
+     * messages are sharded by device key, so messages of a single device are still handled in order
+     */
+    explicit GatewayInboundDeviceMessageHandler(std::size_t workers = 1);
 
     void messageReceived(const std::string& channel, const std::string& message) override;
 
@@ -41,15 +55,94 @@ public:
 
     void addListener(std::weak_ptr<DeviceMessageListener> listener) override;
 
+    /**
+     * @brief Adds listener whose channels are subscribed only for devices given to subscribeDevice
+     *
+     * Messages are routed to listener as with addListener, but instead of wildcard channels of its protocol
+     * getChannels returns channels of each subscribed device, so broker drops messages of other devices
+     */
+    void addPerDeviceListener(std::weak_ptr<DeviceMessageListener> listener);
+
+    /**
+     * @brief Adds channels of device for listeners added with addPerDeviceListener
+     * @return true if channels changed
+     */
+    bool subscribeDevice(const std::string& deviceKey);
+
+    /**
+     * @brief Removes channels of device added with subscribeDevice
+     * @return true if channels changed
+     */
+    bool unsubscribeDevice(const std::string& deviceKey);
+
+    /**
+     * @brief Called after channels returned by getChannels change, on thread that changed them
+     * Connectivity service subscribes only when it connects, so listener is expected to reconnect it
+     */
+    void setSubscriptionListener(std::function<void()> listener);
+
+    /**
+     * @brief Limits rate of messages accepted from each device, checked before messages are queued for listeners
+     * Must be called before messages are received
+     */
+    void setRateLimiter(std::shared_ptr<DeviceRateLimiter> rateLimiter);
+
+    /**
+     * @brief Accounts messages of each device in statistics, including rejected ones and time they took to be handled
+     * Must be called before messages are received
+     */
+    void setDeviceStatistics(std::shared_ptr<DeviceStatistics> statistics);
+
+    /**
+     * @brief Marks channels whose messages are shed first while backpressure is applied
+     * Must be called before messages are received
+     * @param filter MQTT topic filter, may contain '+' and '#' wildcards
+     */
+    void addSheddableChannel(const std::string& filter);
+
+    /**
+     * @brief Sets how long message on sheddable channel waits for backpressure to be released before it is dropped
+     * Waiting blocks thread delivering messages from local broker, which slows down consumption.
+     * Must be called before messages are received
+     */
+    void setBackpressureDelay(std::chrono::milliseconds delay);
+
+    /**
+     * @brief Applies or releases backpressure, messages on channels that are not sheddable are always accepted
+     */
+    void setBackpressure(bool enabled);
+
 private:
     void addToCommandBuffer(std::function<void()> command);
+    void dispatch(const std::string& channel, std::function<void()> command);
+
+    bool shed(const std::string& channel);
 
     std::unique_ptr<CommandBuffer> m_commandBuffer;
+    std::unique_ptr<ShardedDispatcher> m_dispatcher;
+
+    std::shared_ptr<DeviceRateLimiter> m_rateLimiter;
+    std::shared_ptr<DeviceStatistics> m_statistics;
 
     std::vector<std::string> m_subscriptionList;
-    std::map<std::string, std::weak_ptr<DeviceMessageListener>> m_channelHandlers;
+    std::vector<std::weak_ptr<DeviceMessageListener>> m_perDeviceListeners;
+    std::map<std::string, std::vector<std::string>> m_deviceSubscriptions;
+    std::function<void()> m_subscriptionListener;
+    TopicTrie<std::weak_ptr<DeviceMessageListener>> m_channelHandlers;
+    TopicTrie<bool> m_sheddableChannels;
+
+    std::atomic_bool m_backpressure;
+    std::chrono::milliseconds m_backpressureDelay;
+    std::mutex m_backpressureLock;
+    std::condition_variable m_backpressureReleased;
 
     mutable std::mutex m_lock;
+
+    Counter& m_receivedMessages;
+    Counter& m_unroutedMessages;
+    Counter& m_shedMessages;
+    Gauge& m_queueDepth;
+    Histogram& m_routingLatency;
 };
 }    // namespace wolkabout
 
@@ -17,15 +17,23 @@
 #include "GatewayInboundPlatformMessageHandler.h"
 #include "model/Message.h"
 #include "protocol/Protocol.h"
-#include "utilities/Logger.h"
+#include "utilities/CommandWatchdog.h"
+#include "utilities/GatewayLog.h"
+#include "utilities/MessagePool.h"
+#include "utilities/Tracer.h"
 #include "utilities/StringUtils.h"
 
-#include <algorithm>
-
 namespace wolkabout
 {
 GatewayInboundPlatformMessageHandler::GatewayInboundPlatformMessageHandler(const std::string& gatewayKey)
-: m_commandBuffer{new CommandBuffer()}, m_gatewayKey{gatewayKey}
+: m_commandBuffer{new CommandBuffer()}
+, m_priorityCommandBuffer{new CommandBuffer()}
+, m_gatewayKey{gatewayKey}
+, m_routingTable{std::make_shared<RoutingTable>()}
+, m_receivedMessages{MetricsRegistry::getInstance().counter("wolkgateway_inbound_platform_messages_total")}
+, m_unroutedMessages{MetricsRegistry::getInstance().counter("wolkgateway_inbound_platform_unrouted_messages_total")}
+, m_queueDepth{MetricsRegistry::getInstance().gauge("wolkgateway_inbound_platform_queue_depth")}
+, m_routingLatency{MetricsRegistry::getInstance().histogram("wolkgateway_inbound_platform_routing_latency_seconds")}
 {
 }
 
@@ -34,41 +42,58 @@ void GatewayInboundPlatformMessageHandler::messageReceived(const std::string& ch
     // don't log binary payload
     if (!StringUtils::contains(channel, "binary"))
     {
-        LOG(DEBUG) << "GatewayInboundPlatformMessageHandler: Message received on channel: '" << channel << "' : '"
-                   << payload << "'";
+        GATEWAY_LOG(DEBUG) << "GatewayInboundPlatformMessageHandler: Message received on channel: '" << channel
+                           << "' : '" << payload << "'";
     }
     else
     {
-        LOG(DEBUG) << "GatewayInboundPlatformMessageHandler: Message received on channel: '" << channel << "'";
+        GATEWAY_LOG(DEBUG) << "GatewayInboundPlatformMessageHandler: Message received on channel: '" << channel << "'";
     }
 
-    std::lock_guard<std::mutex> lg{m_lock};
+    m_receivedMessages.increment();
+
+    const auto traceId = Tracer::getInstance().sample();
+    TraceSpan span{"platform_message_received", traceId};
+
+    const auto table = routingTable();
 
-    auto it = std::find_if(m_channelHandlers.begin(), m_channelHandlers.end(),
-                           [&](const std::pair<std::string, std::weak_ptr<PlatformMessageListener>>& kvp) {
-                               return StringUtils::mqttTopicMatch(kvp.first, channel);
-                           });
+    const auto* listener = table->channelHandlers.match(channel);
 
-    if (it != m_channelHandlers.end())
+    if (listener)
     {
-        auto channelHandler = it->second;
-        addToCommandBuffer([=] {
+        // payload is copied only once, into the message shared with the listener
+        auto channelHandler = *listener;
+        auto message = MessagePool::make(payload, channel);
+        const auto receivedAt = std::chrono::steady_clock::now();
+        const bool priority = !table->priorityChannels.empty() && table->priorityChannels.match(channel);
+        m_queueDepth.increment();
+        addToCommandBuffer(priority, channel, [=] {
+            m_queueDepth.decrement();
+            if (traceId != 0)
+            {
+                Tracer::getInstance().record("inbound_platform_queue", traceId, receivedAt,
+                                             std::chrono::steady_clock::now());
+            }
+
+            TraceScope scope{traceId};
+            TraceSpan handling{"platform_message_handling", traceId};
             if (auto handler = channelHandler.lock())
             {
-                handler->platformMessageReceived(std::make_shared<Message>(payload, channel));
+                handler->platformMessageReceived(message);
             }
+            m_routingLatency.record(std::chrono::steady_clock::now() - receivedAt);
         });
     }
     else
     {
-        LOG(DEBUG) << "GatewayInboundPlatformMessageHandler: Handler for device channel not found: " << channel;
+        m_unroutedMessages.increment();
+        GATEWAY_LOG(DEBUG) << "GatewayInboundPlatformMessageHandler: Handler for device channel not found: " << channel;
     }
 }
 
 std::vector<std::string> GatewayInboundPlatformMessageHandler::getChannels() const
 {
-    std::lock_guard<std::mutex> lg{m_lock};
-    return m_subscriptionList;
+    return routingTable()->subscriptionList;
 }
 
 void GatewayInboundPlatformMessageHandler::addListener(std::weak_ptr<PlatformMessageListener> listener)
@@ -77,17 +102,41 @@ void GatewayInboundPlatformMessageHandler::addListener(std::weak_ptr<PlatformMes
 
     if (auto handler = listener.lock())
     {
+        auto table = std::make_shared<RoutingTable>(*routingTable());
+
         for (const auto& channel : handler->getProtocol().getInboundChannelsForDevice(m_gatewayKey))
         {
-            LOG(DEBUG) << "Adding listener for channel: " << channel;
-            m_channelHandlers[channel] = listener;
-            m_subscriptionList.push_back(channel);
+            GATEWAY_LOG(DEBUG) << "Adding listener for channel: " << channel;
+            table->channelHandlers.insert(channel, listener);
+            table->subscriptionList.push_back(channel);
         }
+
+        std::atomic_store(&m_routingTable, std::shared_ptr<const RoutingTable>{table});
     }
 }
 
-void GatewayInboundPlatformMessageHandler::addToCommandBuffer(std::function<void()> command)
+void GatewayInboundPlatformMessageHandler::addPriorityChannel(const std::string& filter)
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    auto table = std::make_shared<RoutingTable>(*routingTable());
+    table->priorityChannels.insert(filter, true);
+
+    std::atomic_store(&m_routingTable, std::shared_ptr<const RoutingTable>{table});
+}
+
+std::shared_ptr<const GatewayInboundPlatformMessageHandler::RoutingTable>
+GatewayInboundPlatformMessageHandler::routingTable() const
+{
+    return std::atomic_load(&m_routingTable);
+}
+
+void GatewayInboundPlatformMessageHandler::addToCommandBuffer(bool priority, const std::string& channel,
+                                                              std::function<void()> command)
 {
-    m_commandBuffer->pushCommand(std::make_shared<std::function<void()>>(command));
+    auto tracked = CommandWatchdog::getInstance().track(priority ? "inbound_platform_priority" : "inbound_platform",
+                                                        channel, std::move(command));
+    (priority ? *m_priorityCommandBuffer : *m_commandBuffer)
+      .pushCommand(std::make_shared<std::function<void()>>(std::move(tracked)));
 }
 }    // namespace wolkabout
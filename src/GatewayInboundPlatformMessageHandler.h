@@ -19,8 +19,9 @@
 
 #include "InboundPlatformMessageHandler.h"
 #include "utilities/CommandBuffer.h"
+#include "utilities/Metrics.h"
+#include "utilities/TopicTrie.h"
 
-#include <map>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -41,17 +42,39 @@ public:
 
     void addListener(std::weak_ptr<PlatformMessageListener> listener) override;
 
+    /**
+     * @brief Dispatches messages on channels matching filter from separate queue
+     * Such messages do not wait behind messages queued on other channels, such as file transfer packets
+     * @param filter MQTT topic filter of latency sensitive channels
+     */
+    void addPriorityChannel(const std::string& filter);
+
 private:
-    void addToCommandBuffer(std::function<void()> command);
+    // Immutable once published, replaced as a whole by addListener
+    struct RoutingTable
+    {
+        std::vector<std::string> subscriptionList;
+        TopicTrie<std::weak_ptr<PlatformMessageListener>> channelHandlers;
+        TopicTrie<bool> priorityChannels;
+    };
+
+    std::shared_ptr<const RoutingTable> routingTable() const;
+
+    void addToCommandBuffer(bool priority, const std::string& channel, std::function<void()> command);
 
     std::unique_ptr<CommandBuffer> m_commandBuffer;
+    std::unique_ptr<CommandBuffer> m_priorityCommandBuffer;
     const std::string m_gatewayKey;
 
-    std::vector<std::string> m_subscriptionList;
+    // Read lock-free through std::atomic_load, m_lock only serializes writers
+    std::shared_ptr<const RoutingTable> m_routingTable;
 
-    std::map<std::string, std::weak_ptr<PlatformMessageListener>> m_channelHandlers;
+    std::mutex m_lock;
 
-    mutable std::mutex m_lock;
+    Counter& m_receivedMessages;
+    Counter& m_unroutedMessages;
+    Gauge& m_queueDepth;
+    Histogram& m_routingLatency;
 };
 }    // namespace wolkabout
 
@@ -17,32 +17,54 @@
 #include "OutboundRetryMessageHandler.h"
 #include "OutboundMessageHandler.h"
 #include "model/Message.h"
-#include "utilities/Logger.h"
+#include "utilities/GatewayLog.h"
 #include "utilities/StringUtils.h"
 
+#include <algorithm>
+
 namespace
 {
-static const size_t RETRY_MESSAGE_INDEX = 0;
-static const size_t TIMER_INDEX = 1;
-static const size_t RETRY_COUNT_INDEX = 2;
-static const size_t FLAG_INDEX = 3;
+bool hasWildcard(const std::string& channel)
+{
+    return channel.find_first_of("+#") != std::string::npos;
+}
 }    // namespace
 
 namespace wolkabout
 {
-OutboundRetryMessageHandler::OutboundRetryMessageHandler(OutboundMessageHandler& messageHandler)
-: m_messageHandler{messageHandler}, m_run{true}, m_garbageCollector(&OutboundRetryMessageHandler::clearTimers, this)
+OutboundRetryMessageHandler::OutboundRetryMessageHandler(OutboundMessageHandler& messageHandler, Executor& executor)
+: m_messageHandler{messageHandler}
+, m_executor{executor}
+, m_nextId{0}
+, m_stopped{false}
+, m_pendingMessages{MetricsRegistry::getInstance().gauge("wolkgateway_outbound_retry_pending_messages")}
+, m_retriedMessages{MetricsRegistry::getInstance().counter("wolkgateway_outbound_retry_retried_messages_total")}
+, m_failedMessages{MetricsRegistry::getInstance().counter("wolkgateway_outbound_retry_failed_messages_total")}
+, m_memory{MemoryBudget::getInstance().account("outbound_retry_table")}
 {
 }
 
 OutboundRetryMessageHandler::~OutboundRetryMessageHandler()
 {
-    m_run = false;
-    notifyCleanup();
+    std::vector<Executor::TaskId> timers;
+
+    {
+        std::lock_guard<decltype(m_mutex)> lg{m_mutex};
+        m_stopped = true;
+
+        for (const auto& kvp : m_messages)
+        {
+            timers.push_back(kvp.second.timer);
+            m_memory.release(kvp.second.bytes);
+        }
+
+        m_pendingMessages.decrement(static_cast<std::int64_t>(m_messages.size()));
+    }
 
-    if (m_garbageCollector.joinable())
+    // retry that is already running is waited for, and will not schedule another one
+    for (const auto timer : timers)
     {
-        m_garbageCollector.join();
+        m_executor.cancel(timer);
     }
 }
 
@@ -50,127 +72,168 @@ void OutboundRetryMessageHandler::addMessage(RetryMessageStruct msg)
 {
     std::lock_guard<decltype(m_mutex)> lg{m_mutex};
 
-    LOG(DEBUG) << "Adding message for retry on channel: " << msg.message->getChannel();
+    add(std::move(msg));
+}
+
+void OutboundRetryMessageHandler::addMessages(std::vector<RetryMessageStruct> messages)
+{
+    std::lock_guard<decltype(m_mutex)> lg{m_mutex};
+
+    for (RetryMessageStruct& msg : messages)
+    {
+        add(std::move(msg));
+    }
+}
+
+void OutboundRetryMessageHandler::add(RetryMessageStruct msg)
+{
+    GATEWAY_LOG(DEBUG) << "Adding message for retry on channel: " << msg.message->getChannel();
 
     // send message
     m_messageHandler.addMessage(msg.message);
 
     // setup retry
-    const auto id = getUniqueId();
-    m_messages[id] = std::make_tuple(msg, std::unique_ptr<Timer>(new Timer()), 0, false);
+    const auto id = ++m_nextId;
+    const auto timer = m_executor.schedule(msg.retryInterval, [=] { retry(id); });
 
-    auto& tup = m_messages[id];
-    auto& timer = std::get<TIMER_INDEX>(tup);
-    auto interval = std::get<RETRY_MESSAGE_INDEX>(tup).retryInterval;
+    if (hasWildcard(msg.responseChannel))
+    {
+        m_wildcardMessages.push_back(id);
+    }
+    else
+    {
+        m_messagesByResponseChannel.emplace(msg.responseChannel, id);
+    }
 
-    timer->run(interval, [=] {
-        std::lock_guard<decltype(m_mutex)> l{m_mutex};
-        auto it = m_messages.find(id);
-        if (it == m_messages.end())
-            return;
+    ResponseMetrics* responseMetrics = &ResponseMetrics::forRequestChannel(msg.message->getChannel());
+    const std::uint64_t bytes =
+      msg.message->getChannel().size() + msg.message->getContent().size() + msg.responseChannel.size();
+    m_messages.emplace(
+      id, PendingMessage{std::move(msg), timer, 0, std::chrono::steady_clock::now(), responseMetrics, bytes});
+    m_pendingMessages.increment();
+    m_memory.add(bytes);
+}
 
-        auto& tuple = it->second;
+void OutboundRetryMessageHandler::messageReceived(std::shared_ptr<Message> response)
+{
+    std::vector<Executor::TaskId> timers;
 
-        // skip if message is already flagged
-        if (std::get<FLAG_INDEX>(tuple))
-            return;
+    {
+        std::lock_guard<decltype(m_mutex)> lg{m_mutex};
 
-        auto& retryCount = std::get<RETRY_COUNT_INDEX>(tuple);
-        ++retryCount;
+        std::vector<unsigned long long> answered;
 
-        auto& retryMessage = std::get<RETRY_MESSAGE_INDEX>(tuple);
+        const auto range = m_messagesByResponseChannel.equal_range(response->getChannel());
+        for (auto it = range.first; it != range.second; ++it)
+        {
+            answered.push_back(it->second);
+        }
 
-        if (retryCount > retryMessage.retryCount)
+        for (const auto id : m_wildcardMessages)
         {
-            LOG(INFO) << "Retry count exceeded for message on channel: " << retryMessage.message->getChannel();
+            const auto it = m_messages.find(id);
+            if (it != m_messages.end() &&
+                StringUtils::mqttTopicMatch(it->second.retryMessage.responseChannel, response->getChannel()))
+            {
+                answered.push_back(id);
+            }
+        }
 
-            // flag message struct for deletion
-            auto& clearMessage = std::get<FLAG_INDEX>(tuple);
-            clearMessage = true;
+        for (const auto id : answered)
+        {
+            const auto it = m_messages.find(id);
+            if (it == m_messages.end())
+            {
+                continue;
+            }
 
-            // on fail callback
-            retryMessage.onFail(retryMessage.message);
+            GATEWAY_LOG(DEBUG) << "Response received on channel " << it->second.retryMessage.responseChannel
+                               << ", for message on channel: " << it->second.retryMessage.message->getChannel();
 
-            notifyCleanup();
-        }
-        else
-        {
-            LOG(INFO) << "Retry sending message on channel: " << retryMessage.message->getChannel();
-            // retry message sending
-            m_messageHandler.addMessage(retryMessage.message);
+            const PendingMessage& pending = it->second;
+            pending.responseMetrics->record(std::chrono::steady_clock::now() - pending.sentAt,
+                                            static_cast<unsigned>(pending.retryCount));
+
+            timers.push_back(pending.timer);
+            remove(id);
         }
-    });
+    }
+
+    // stop retry timers outside the lock, cancel waits for a retry that may be blocked on it
+    for (const auto timer : timers)
+    {
+        m_executor.cancel(timer);
+    }
 }
 
-void OutboundRetryMessageHandler::messageReceived(std::shared_ptr<Message> response)
+void OutboundRetryMessageHandler::retry(unsigned long long id)
 {
-    std::lock_guard<decltype(m_mutex)> lg{m_mutex};
+    std::unique_lock<decltype(m_mutex)> lg{m_mutex};
 
-    for (auto& kvp : m_messages)
+    auto it = m_messages.find(id);
+    if (m_stopped || it == m_messages.end())
     {
-        auto& tuple = kvp.second;
-        const auto& retryMessage = std::get<RETRY_MESSAGE_INDEX>(tuple);
-        if (StringUtils::mqttTopicMatch(response->getChannel(), retryMessage.responseChannel))
-        {
-            LOG(DEBUG) << "Response received on channel " << retryMessage.responseChannel
-                       << ", for message on channel: " << retryMessage.message->getChannel();
+        return;
+    }
 
-            // flag message struct for deletion
-            auto& clearMessage = std::get<FLAG_INDEX>(tuple);
-            clearMessage = true;
+    auto& pending = it->second;
+    ++pending.retryCount;
 
-            // stop retry timer
-            auto& timer = std::get<TIMER_INDEX>(tuple);
-            timer->stop();
+    if (pending.retryCount > pending.retryMessage.retryCount)
+    {
+        LOG(INFO) << "Retry count exceeded for message on channel: " << pending.retryMessage.message->getChannel();
 
-            notifyCleanup();
-        }
+        auto retryMessage = std::move(pending.retryMessage);
+        remove(id);
+        m_failedMessages.increment();
+
+        lg.unlock();
+
+        // on fail callback
+        retryMessage.onFail(retryMessage.message);
+        return;
     }
+
+    LOG(INFO) << "Retry sending message on channel: " << pending.retryMessage.message->getChannel();
+
+    // retry message sending
+    m_retriedMessages.increment();
+    m_messageHandler.addMessage(pending.retryMessage.message);
+    pending.sentAt = std::chrono::steady_clock::now();
+    pending.timer = m_executor.schedule(pending.retryMessage.retryInterval, [=] { retry(id); });
 }
 
-void OutboundRetryMessageHandler::clearTimers()
+void OutboundRetryMessageHandler::remove(unsigned long long id)
 {
-    while (m_run)
+    auto it = m_messages.find(id);
+    if (it == m_messages.end())
     {
-        std::unique_lock<decltype(m_mutex)> lg{m_mutex};
+        return;
+    }
 
-        for (auto it = m_messages.begin(); it != m_messages.end();)
-        {
-            auto& tuple = it->second;
-            auto& clearMessage = std::get<FLAG_INDEX>(tuple);
+    GATEWAY_LOG(DEBUG) << "Removing message from retry queue: " << it->second.retryMessage.message->getChannel();
 
-            if (clearMessage)
-            {
-                LOG(DEBUG) << "Removing message from retry queue: "
-                           << std::get<RETRY_MESSAGE_INDEX>(tuple).message->getChannel();
-                // removed flagged messages
-                auto& timer = std::get<TIMER_INDEX>(tuple);
-                timer->stop();
-                it = m_messages.erase(it);
-            }
-            else
+    const auto& responseChannel = it->second.retryMessage.responseChannel;
+    if (hasWildcard(responseChannel))
+    {
+        m_wildcardMessages.erase(std::remove(m_wildcardMessages.begin(), m_wildcardMessages.end(), id),
+                                 m_wildcardMessages.end());
+    }
+    else
+    {
+        const auto range = m_messagesByResponseChannel.equal_range(responseChannel);
+        for (auto channelIt = range.first; channelIt != range.second; ++channelIt)
+        {
+            if (channelIt->second == id)
             {
-                ++it;
+                m_messagesByResponseChannel.erase(channelIt);
+                break;
             }
         }
-
-        lg.unlock();
-
-        static std::mutex cvMutex;
-        std::unique_lock<std::mutex> lock{cvMutex};
-        m_condition.wait(lock);
     }
-}
-
-void OutboundRetryMessageHandler::notifyCleanup()
-{
-    m_condition.notify_one();
-}
 
-unsigned long long OutboundRetryMessageHandler::getUniqueId()
-{
-    static unsigned long long id = 0;
-    return ++id;
+    m_memory.release(it->second.bytes);
+    m_messages.erase(it);
+    m_pendingMessages.decrement();
 }
-
 }    // namespace wolkabout
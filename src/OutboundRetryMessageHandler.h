@@ -17,16 +17,19 @@
 #ifndef OUTBOUNDRETRYMESSAGEHANDLER_H
 #define OUTBOUNDRETRYMESSAGEHANDLER_H
 
-#include "utilities/Timer.h"
+#include "utilities/Executor.h"
+#include "utilities/MemoryBudget.h"
+#include "utilities/Metrics.h"
+#include "utilities/ResponseMetrics.h"
 
-#include <atomic>
-#include <condition_variable>
+#include <chrono>
+#include <cstdint>
 #include <functional>
-#include <map>
 #include <memory>
 #include <mutex>
-#include <thread>
-#include <tuple>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace wolkabout
 {
@@ -45,25 +48,49 @@ struct RetryMessageStruct
 class OutboundRetryMessageHandler
 {
 public:
-    explicit OutboundRetryMessageHandler(OutboundMessageHandler& messageHandler);
+    OutboundRetryMessageHandler(OutboundMessageHandler& messageHandler, Executor& executor);
     ~OutboundRetryMessageHandler();
 
     void addMessage(RetryMessageStruct msg);
+
+    /**
+     * @brief Sends messages and sets up their retries under a single lock acquisition
+     */
+    void addMessages(std::vector<RetryMessageStruct> messages);
     void messageReceived(std::shared_ptr<Message> message);
 
 private:
-    void clearTimers();
-    void notifyCleanup();
-    unsigned long long getUniqueId();
+    struct PendingMessage
+    {
+        RetryMessageStruct retryMessage;
+        Executor::TaskId timer;
+        short retryCount;
+        std::chrono::steady_clock::time_point sentAt;
+        ResponseMetrics* responseMetrics;
+        std::uint64_t bytes;
+    };
+
+    void add(RetryMessageStruct msg);
+    void retry(unsigned long long id);
+    void remove(unsigned long long id);
 
     OutboundMessageHandler& m_messageHandler;
+    Executor& m_executor;
 
-    std::map<unsigned long long, std::tuple<RetryMessageStruct, std::unique_ptr<Timer>, short, bool>> m_messages;
+    std::unordered_map<unsigned long long, PendingMessage> m_messages;
+    std::unordered_multimap<std::string, unsigned long long> m_messagesByResponseChannel;
+    // response channels containing wildcards can not be looked up by value
+    std::vector<unsigned long long> m_wildcardMessages;
+    unsigned long long m_nextId;
+    bool m_stopped;
 
-    std::atomic_bool m_run;
-    std::condition_variable m_condition;
     std::mutex m_mutex;
-    std::thread m_garbageCollector;
+
+    Gauge& m_pendingMessages;
+    Counter& m_retriedMessages;
+    Counter& m_failedMessages;
+    // pending messages are only accounted, dropping them would lose requests awaiting platform response
+    MemoryAccount& m_memory;
 };
 }    // namespace wolkabout
 
@@ -18,7 +18,7 @@
 #include "model/Message.h"
 #include "protocol/GatewaySubdeviceRegistrationProtocol.h"
 #include "protocol/RegistrationProtocol.h"
-#include "utilities/Logger.h"
+#include "utilities/GatewayLog.h"
 
 namespace wolkabout
 {
@@ -34,25 +34,26 @@ RegistrationMessageRouter::RegistrationMessageRouter(
 , m_deviceSubdeviceRegistrationRequestMessageHandler{DeviceSubdeviceRegistrationRequestMessageHandler}
 , m_platformSubdeviceRegistrationResponseMessageHandler{PlatformSubdeviceRegistrationResponseMessageHandler}
 , m_platformSubdeviceDeletionResponseMessageHandler{PlatformSubdeviceDeletionResponseMessageHandler}
+, m_platformRoutes{m_protocol.getInboundChannels(),
+                   {{[this](const Message& message) { return m_protocol.isGatewayUpdateResponse(message); },
+                     m_platformGatewayUpdateResponseMessageHandler},
+                    {[this](const Message& message) { return m_protocol.isSubdeviceDeletionResponse(message); },
+                     m_platformSubdeviceDeletionResponseMessageHandler},
+                    {[this](const Message& message) { return m_protocol.isSubdeviceRegistrationResponse(message); },
+                     m_platformSubdeviceRegistrationResponseMessageHandler}}}
+, m_deviceRoutes{m_gatewayProtocol.getInboundChannels(),
+                 {{[this](const Message& message) { return m_gatewayProtocol.isSubdeviceRegistrationRequest(message); },
+                   m_deviceSubdeviceRegistrationRequestMessageHandler}}}
 {
 }
 
 void RegistrationMessageRouter::platformMessageReceived(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << "Routing platform registration protocol message: " << message->getChannel();
+    GATEWAY_LOG(TRACE) << "Routing platform registration protocol message: " << message->getChannel();
 
-    if (m_protocol.isGatewayUpdateResponse(*message) && m_platformGatewayUpdateResponseMessageHandler)
+    if (PlatformMessageListener* handler = m_platformRoutes.route(*message))
     {
-        m_platformGatewayUpdateResponseMessageHandler->platformMessageReceived(message);
-    }
-    else if (m_protocol.isSubdeviceDeletionResponse(*message) && m_platformSubdeviceDeletionResponseMessageHandler)
-    {
-        m_platformSubdeviceDeletionResponseMessageHandler->platformMessageReceived(message);
-    }
-    else if (m_protocol.isSubdeviceRegistrationResponse(*message) &&
-             m_platformSubdeviceRegistrationResponseMessageHandler)
-    {
-        m_platformSubdeviceRegistrationResponseMessageHandler->platformMessageReceived(message);
+        handler->platformMessageReceived(message);
     }
     else
     {
@@ -62,12 +63,11 @@ void RegistrationMessageRouter::platformMessageReceived(std::shared_ptr<Message>
 
 void RegistrationMessageRouter::deviceMessageReceived(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << "Routing device registration protocol message: " << message->getChannel();
+    GATEWAY_LOG(TRACE) << "Routing device registration protocol message: " << message->getChannel();
 
-    if (m_gatewayProtocol.isSubdeviceRegistrationRequest(*message) &&
-        m_deviceSubdeviceRegistrationRequestMessageHandler)
+    if (DeviceMessageListener* handler = m_deviceRoutes.route(*message))
     {
-        m_deviceSubdeviceRegistrationRequestMessageHandler->deviceMessageReceived(message);
+        handler->deviceMessageReceived(message);
     }
     else
     {
@@ -19,6 +19,7 @@
 
 #include "GatewayInboundDeviceMessageHandler.h"
 #include "GatewayInboundPlatformMessageHandler.h"
+#include "utilities/ChannelRoutingTable.h"
 
 #include <memory>
 
@@ -51,6 +52,9 @@ private:
     DeviceMessageListener* m_deviceSubdeviceRegistrationRequestMessageHandler;
     PlatformMessageListener* m_platformSubdeviceRegistrationResponseMessageHandler;
     PlatformMessageListener* m_platformSubdeviceDeletionResponseMessageHandler;
+
+    const ChannelRoutingTable<PlatformMessageListener> m_platformRoutes;
+    const ChannelRoutingTable<DeviceMessageListener> m_deviceRoutes;
 };
 }    // namespace wolkabout
 
@@ -18,7 +18,7 @@
 #include "model/Message.h"
 #include "protocol/GatewayStatusProtocol.h"
 #include "protocol/StatusProtocol.h"
-#include "utilities/Logger.h"
+#include "utilities/GatewayLog.h"
 
 namespace wolkabout
 {
@@ -33,24 +33,30 @@ StatusMessageRouter::StatusMessageRouter(StatusProtocol& protocol, GatewayStatus
 , m_deviceStatusMessageHandler{deviceStatusMessageHandler}
 , m_lastWillMessageHandler{lastWillMessageHandler}
 , m_platformKeepAliveMessageHandler{platformKeepAliveMessageHandler}
+, m_platformRoutes{m_protocol.getInboundChannels(),
+                   {{[this](const Message& message) { return m_protocol.isStatusRequestMessage(message); },
+                     m_platformStatusMessageHandler},
+                    {[this](const Message& message) { return m_protocol.isStatusConfirmMessage(message); },
+                     m_platformStatusMessageHandler},
+                    {[this](const Message& message) { return m_protocol.isPongMessage(message); },
+                     m_platformKeepAliveMessageHandler}}}
+, m_deviceRoutes{m_gatewayProtocol.getInboundChannels(),
+                 {{[this](const Message& message) { return m_gatewayProtocol.isStatusResponseMessage(message); },
+                   m_deviceStatusMessageHandler},
+                  {[this](const Message& message) { return m_gatewayProtocol.isStatusUpdateMessage(message); },
+                   m_deviceStatusMessageHandler},
+                  {[this](const Message& message) { return m_gatewayProtocol.isLastWillMessage(message); },
+                   m_lastWillMessageHandler}}}
 {
 }
 
 void StatusMessageRouter::platformMessageReceived(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << "Routing platform status protocol message: " << message->getChannel();
+    GATEWAY_LOG(TRACE) << "Routing platform status protocol message: " << message->getChannel();
 
-    if (m_protocol.isStatusRequestMessage(*message) && m_platformStatusMessageHandler)
+    if (PlatformMessageListener* handler = m_platformRoutes.route(*message))
     {
-        m_platformStatusMessageHandler->platformMessageReceived(message);
-    }
-    else if (m_protocol.isStatusConfirmMessage(*message) && m_platformStatusMessageHandler)
-    {
-        m_platformStatusMessageHandler->platformMessageReceived(message);
-    }
-    else if (m_protocol.isPongMessage(*message) && m_platformKeepAliveMessageHandler)
-    {
-        m_platformKeepAliveMessageHandler->platformMessageReceived(message);
+        handler->platformMessageReceived(message);
     }
     else
     {
@@ -60,19 +66,11 @@ void StatusMessageRouter::platformMessageReceived(std::shared_ptr<Message> messa
 
 void StatusMessageRouter::deviceMessageReceived(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << "Routing device status protocol message: " << message->getChannel();
+    GATEWAY_LOG(TRACE) << "Routing device status protocol message: " << message->getChannel();
 
-    if (m_gatewayProtocol.isStatusResponseMessage(*message) && m_deviceStatusMessageHandler)
-    {
-        m_deviceStatusMessageHandler->deviceMessageReceived(message);
-    }
-    else if (m_gatewayProtocol.isStatusUpdateMessage(*message) && m_deviceStatusMessageHandler)
-    {
-        m_deviceStatusMessageHandler->deviceMessageReceived(message);
-    }
-    else if (m_gatewayProtocol.isLastWillMessage(*message) && m_lastWillMessageHandler)
+    if (DeviceMessageListener* handler = m_deviceRoutes.route(*message))
     {
-        m_lastWillMessageHandler->deviceMessageReceived(message);
+        handler->deviceMessageReceived(message);
     }
     else
     {
@@ -18,6 +18,8 @@
 
 #include "GatewayInboundDeviceMessageHandler.h"
 #include "GatewayInboundPlatformMessageHandler.h"
+#include "utilities/ChannelRoutingTable.h"
+
 #include <memory>
 
 namespace wolkabout
@@ -49,6 +51,9 @@ private:
     DeviceMessageListener* m_deviceStatusMessageHandler;
     DeviceMessageListener* m_lastWillMessageHandler;
     PlatformMessageListener* m_platformKeepAliveMessageHandler;
+
+    const ChannelRoutingTable<PlatformMessageListener> m_platformRoutes;
+    const ChannelRoutingTable<DeviceMessageListener> m_deviceRoutes;
 };
 }    // namespace wolkabout
 
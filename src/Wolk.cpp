@@ -15,7 +15,9 @@
  */
 
 #include "Wolk.h"
+#include "GatewayInboundDeviceMessageHandler.h"
 #include "connectivity/ConnectivityService.h"
+#include "connectivity/EmbeddedBrokerConnectivityService.h"
 #include "model/ConfigurationSetCommand.h"
 #include "persistence/Persistence.h"
 #include "protocol/DataProtocol.h"
@@ -30,7 +32,11 @@
 #include "repository/DeviceRepository.h"
 #include "repository/ExistingDevicesRepository.h"
 #include "repository/FileRepository.h"
+#include "repository/FileTransferCheckpointRepository.h"
 #include "service/DataService.h"
+#include "service/DeadbandFilter.h"
+#include "service/ReadingTransformer.h"
+#include "service/WindowedAggregator.h"
 #include "service/DeviceStatusService.h"
 #include "service/FileDownloadService.h"
 #include "service/FirmwareUpdateService.h"
@@ -39,23 +45,23 @@
 #include "service/KeepAliveService.h"
 #include "service/PublishingService.h"
 #include "service/SubdeviceRegistrationService.h"
+#include "utilities/CommandWatchdog.h"
+#include "utilities/DeviceRateLimiter.h"
+#include "utilities/DeviceStatistics.h"
+#include "utilities/DeviceStatisticsReporter.h"
+#include "utilities/Executor.h"
 #include "utilities/Logger.h"
+#include "utilities/MetricsFileExporter.h"
+#include "utilities/ReconnectScheduler.h"
 
 #include <memory>
 #include <sstream>
 #include <string>
-#include <thread>
 #include <utility>
-
-namespace
-{
-const unsigned RECONNECT_DELAY_MSEC = 2000;
-}
+#include <vector>
 
 namespace wolkabout
 {
-const constexpr std::chrono::seconds Wolk::KEEP_ALIVE_INTERVAL;
-
 WolkBuilder Wolk::newBuilder(GatewayDevice device)
 {
     return WolkBuilder(std::move(device));
@@ -63,14 +69,18 @@ WolkBuilder Wolk::newBuilder(GatewayDevice device)
 
 void Wolk::connect()
 {
-    connectToPlatform();
+    // local broker is usually reachable right away, device messages are queued until platform connection is up
     connectToDevices();
+    connectToPlatform();
 }
 
 void Wolk::disconnect()
 {
-    addToCommandBuffer([=]() -> void { m_platformConnectivityService->disconnect(); });
-    addToCommandBuffer([=]() -> void { m_deviceConnectivityService->disconnect(); });
+    m_platformReconnectScheduler->stop();
+    m_deviceReconnectScheduler->stop();
+
+    addToCommandBuffer(__func__, [=]() -> void { m_platformConnectivityService->disconnect(); });
+    addToCommandBuffer(__func__, [=]() -> void { m_deviceConnectivityService->disconnect(); });
 }
 
 void Wolk::addSensorReading(const std::string& reference, const std::string& value, unsigned long long rtc)
@@ -80,12 +90,11 @@ void Wolk::addSensorReading(const std::string& reference, const std::string& val
         rtc = Wolk::currentRtc();
     }
 
-    addToCommandBuffer([=]() -> void {
-        if (m_gatewayDataService)
-        {
-            m_gatewayDataService->addSensorReading(reference, value, rtc);
-        }
-    });
+    // reading and alarm queues of gateway data service take concurrent submissions, only publishing is serialized
+    if (m_gatewayDataService)
+    {
+        m_gatewayDataService->addSensorReading(reference, value, rtc);
+    }
 }
 
 void Wolk::addSensorReading(const std::string& reference, const std::vector<std::string>& values,
@@ -101,12 +110,44 @@ void Wolk::addSensorReading(const std::string& reference, const std::vector<std:
         rtc = Wolk::currentRtc();
     }
 
-    addToCommandBuffer([=]() -> void {
-        if (m_gatewayDataService)
+    if (m_gatewayDataService)
+    {
+        m_gatewayDataService->addSensorReading(reference, values, rtc);
+    }
+}
+
+void Wolk::addSensorReading(const NumericReading& reading)
+{
+    addSensorReadings(&reading, 1);
+}
+
+void Wolk::addSensorReadings(const NumericReading* readings, std::size_t count)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    addSensorReadings(std::vector<NumericReading>(readings, readings + count));
+}
+
+void Wolk::addSensorReadings(std::vector<NumericReading> readings)
+{
+    if (readings.empty() || !m_gatewayDataService)
+    {
+        return;
+    }
+
+    const auto rtc = Wolk::currentRtc();
+    for (auto& reading : readings)
+    {
+        if (reading.getRtc() == 0)
         {
-            m_gatewayDataService->addSensorReading(reference, values, rtc);
+            reading.setRtc(rtc);
         }
-    });
+    }
+
+    m_gatewayDataService->addSensorReadings(std::move(readings));
 }
 
 void Wolk::addAlarm(const std::string& reference, bool active, unsigned long long rtc)
@@ -116,17 +157,15 @@ void Wolk::addAlarm(const std::string& reference, bool active, unsigned long lon
         rtc = Wolk::currentRtc();
     }
 
-    addToCommandBuffer([=]() -> void {
-        if (m_gatewayDataService)
-        {
-            m_gatewayDataService->addAlarm(reference, active, rtc);
-        }
-    });
+    if (m_gatewayDataService)
+    {
+        m_gatewayDataService->addAlarm(reference, active, rtc);
+    }
 }
 
 void Wolk::publishActuatorStatus(const std::string& reference)
 {
-    addToCommandBuffer([=]() -> void {
+    addToCommandBuffer(__func__, [=]() -> void {
         const ActuatorStatus actuatorStatus = [&]() -> ActuatorStatus {
             if (auto provider = m_actuatorStatusProvider.lock())
             {
@@ -150,7 +189,7 @@ void Wolk::publishActuatorStatus(const std::string& reference)
 
 void Wolk::publishConfiguration()
 {
-    addToCommandBuffer([=]() -> void {
+    addToCommandBuffer(__func__, [=]() -> void {
         const auto configuration = [=]() -> std::vector<ConfigurationItem> {
             if (auto provider = m_configurationProvider.lock())
             {
@@ -174,7 +213,7 @@ void Wolk::publishConfiguration()
 
 void Wolk::publish()
 {
-    addToCommandBuffer([=]() -> void {
+    addToCommandBuffer(__func__, [=]() -> void {
         flushActuatorStatuses();
         flushAlarms();
         flushSensorReadings();
@@ -182,16 +221,107 @@ void Wolk::publish()
     });
 }
 
-Wolk::Wolk(GatewayDevice device) : m_device{device}
+std::future<bool> Wolk::publishActuatorStatusAsync(const std::string& reference)
+{
+    publishActuatorStatus(reference);
+    return whenPublished();
+}
+
+std::future<bool> Wolk::publishConfigurationAsync()
+{
+    publishConfiguration();
+    return whenPublished();
+}
+
+std::future<bool> Wolk::publishAsync()
+{
+    publish();
+    return whenPublished();
+}
+
+void Wolk::setPlatformReconnectBackoff(std::chrono::milliseconds initialDelay, std::chrono::milliseconds maximumDelay,
+                                       std::chrono::milliseconds stablePeriod)
+{
+    m_platformReconnectScheduler->setBackoff(initialDelay, maximumDelay, stablePeriod);
+}
+
+bool Wolk::setSubdeviceRateLimit(double messagesPerSecond, std::size_t burst)
+{
+    if (!m_subdeviceRateLimiter)
+    {
+        return false;
+    }
+
+    m_subdeviceRateLimiter->setRate(messagesPerSecond, burst);
+    return true;
+}
+
+bool Wolk::reloadReadingDeadbandOverrides(const std::string& overrideFile)
+{
+    return m_readingDeadbandFilter && m_readingDeadbandFilter->loadOverrides(overrideFile);
+}
+
+bool Wolk::reloadReadingTransformationRules(const std::string& ruleFile)
+{
+    return m_readingTransformer && m_readingTransformer->loadRules(ruleFile);
+}
+
+bool Wolk::reloadWindowedAggregationRules(const std::string& ruleFile)
+{
+    return m_windowedAggregator && m_windowedAggregator->loadRules(ruleFile);
+}
+
+std::string Wolk::getDeviceStatistics(std::size_t count) const
+{
+    return m_deviceStatistics ? m_deviceStatistics->format(count) : "";
+}
+
+Wolk::Wolk(GatewayDevice device)
+: m_device{device}
+, m_embeddedBroker{nullptr}
+, m_readingDeadbandFilter{nullptr}
+, m_readingTransformer{nullptr}
+, m_windowedAggregator{nullptr}
+, m_perDeviceSubscriptions{nullptr}
+, m_resubscriptionPending{false}
+, m_gatewayUpdateDelegated{false}
+, m_gatewayUpdatePending{true}
 {
     m_commandBuffer = std::unique_ptr<CommandBuffer>(new CommandBuffer());
 }
 
-Wolk::~Wolk() = default;
+Wolk::~Wolk()
+{
+    // reporter publishes through services declared after it
+    m_deviceStatisticsReporter.reset();
+
+    // attempts in progress notify through command buffer, which is destroyed first
+    m_platformReconnectScheduler.reset();
+    m_deviceReconnectScheduler.reset();
+
+    if (m_gatewayDataService)
+    {
+        m_gatewayDataService->cancelFlushTimer();
+    }
+}
+
+void Wolk::addToCommandBuffer(const char* origin, std::function<void()> command)
+{
+    auto tracked = CommandWatchdog::getInstance().track("wolk", origin, std::move(command));
+    m_commandBuffer->pushCommand(std::make_shared<std::function<void()>>(std::move(tracked)));
+}
 
-void Wolk::addToCommandBuffer(std::function<void()> command)
+std::future<bool> Wolk::whenPublished()
 {
-    m_commandBuffer->pushCommand(std::make_shared<std::function<void()>>(command));
+    auto promise = std::make_shared<std::promise<bool>>();
+    auto future = promise->get_future();
+
+    // command buffer runs commands in order, so the flush queued before has already added its messages to publisher
+    addToCommandBuffer(__func__, [=] {
+        m_platformPublisher->whenPublished([promise](bool published) { promise->set_value(published); });
+    });
+
+    return future;
 }
 
 unsigned long long Wolk::currentRtc()
@@ -234,7 +364,7 @@ void Wolk::flushConfiguration()
 
 void Wolk::handleActuatorSetCommand(const std::string& reference, const std::string& value)
 {
-    addToCommandBuffer([=] {
+    addToCommandBuffer(__func__, [=] {
         if (auto provider = m_actuationHandler.lock())
         {
             provider->handleActuation(reference, value);
@@ -255,7 +385,7 @@ void Wolk::handleActuatorGetCommand(const std::string& reference)
 
 void Wolk::handleConfigurationSetCommand(const ConfigurationSetCommand& command)
 {
-    addToCommandBuffer([=]() -> void {
+    addToCommandBuffer(__func__, [=]() -> void {
         if (auto handler = m_configurationHandler.lock())
         {
             handler->handleConfiguration(command.getValues());
@@ -274,17 +404,47 @@ void Wolk::handleConfigurationGetCommand()
     publishConfiguration();
 }
 
+void Wolk::platformConnected()
+{
+    addToCommandBuffer(__func__, [=] {
+        notifyPlatformConnected();
+
+        updateGatewayAndDeleteDevices();
+
+        requestActuatorStatusesForDevices();
+
+        publishEverything();
+
+        publish();
+    });
+}
+
 void Wolk::platformDisconnected()
 {
-    addToCommandBuffer([=] {
+    addToCommandBuffer(__func__, [=] {
+        notifyPlatformDisonnected();
+        connectToPlatform();
+    });
+}
+
+void Wolk::platformPongTimedOut()
+{
+    addToCommandBuffer(__func__, [=] {
+        // link is most likely half-open, drop it so that reconnecting starts
+        m_platformConnectivityService->disconnect();
         notifyPlatformDisonnected();
         connectToPlatform();
     });
 }
 
+void Wolk::devicesConnected()
+{
+    addToCommandBuffer(__func__, [=] { notifyDevicesConnected(); });
+}
+
 void Wolk::devicesDisconnected()
 {
-    addToCommandBuffer([=] {
+    addToCommandBuffer(__func__, [=] {
         notifyDevicesDisonnected();
         connectToDevices();
     });
@@ -292,7 +452,7 @@ void Wolk::devicesDisconnected()
 
 void Wolk::gatewayUpdated()
 {
-    addToCommandBuffer([=] {
+    addToCommandBuffer(__func__, [=] {
         if (m_keepAliveService)
         {
             m_keepAliveService->sendPingMessage();
@@ -309,9 +469,57 @@ void Wolk::gatewayUpdated()
 
 void Wolk::deviceRegistered(const std::string& deviceKey)
 {
-    addToCommandBuffer([=] {
+    addToCommandBuffer(__func__, [=] {
+        m_dataService->addDevice(deviceKey);
+        m_deviceStatusService->addDevice(deviceKey);
         m_deviceStatusService->sendLastKnownStatusForDevice(deviceKey);
         m_existingDevicesRepository->addDeviceKey(deviceKey);
+        if (m_perDeviceSubscriptions)
+        {
+            m_perDeviceSubscriptions->subscribeDevice(deviceKey);
+        }
+    });
+}
+
+void Wolk::deviceDeleted(const std::string& deviceKey)
+{
+    addToCommandBuffer(__func__, [=] {
+        m_dataService->removeDevice(deviceKey);
+        m_deviceStatusService->removeDevice(deviceKey);
+        if (m_perDeviceSubscriptions)
+        {
+            m_perDeviceSubscriptions->unsubscribeDevice(deviceKey);
+        }
+    });
+}
+
+void Wolk::resubscribeDevices()
+{
+    // registrations already queued run before the reconnect, so a burst of them costs one reconnect
+    if (m_resubscriptionPending.exchange(true))
+    {
+        return;
+    }
+
+    addToCommandBuffer(__func__, [=] {
+        m_resubscriptionPending = false;
+        if (!m_deviceConnectivityService->isConnected())
+        {
+            // channels are subscribed with the connection being established
+            return;
+        }
+
+        if (m_embeddedBroker)
+        {
+            // embedded broker hands messages over by channel, it does not need to reconnect
+            m_embeddedBroker->refreshChannels();
+            return;
+        }
+
+        LOG(INFO) << "Wolk: Subdevice channels changed, reconnecting to local broker to resubscribe";
+        m_deviceConnectivityService->disconnect();
+        notifyDevicesDisonnected();
+        connectToDevices();
     });
 }
 
@@ -348,13 +556,17 @@ void Wolk::publishFileList()
 
 void Wolk::updateGatewayAndDeleteDevices()
 {
-    static bool shouldUpdate = true;
-
     // update gateway upon first connect
-    if (shouldUpdate)
+    if (m_gatewayUpdatePending.exchange(false))
     {
-        m_gatewayUpdateService->updateGateway(m_device);
-        shouldUpdate = false;
+        if (m_gatewayUpdateDelegated)
+        {
+            m_gatewayUpdateService->assumeGatewayUpdated(m_device);
+        }
+        else
+        {
+            m_gatewayUpdateService->updateGateway(m_device);
+        }
 
         if (m_subdeviceRegistrationService && m_device.getSubdeviceManagement().value() == SubdeviceManagement::GATEWAY)
         {
@@ -399,40 +611,12 @@ void Wolk::notifyDevicesDisonnected()
 
 void Wolk::connectToPlatform()
 {
-    addToCommandBuffer([=]() -> void {
-        if (m_platformConnectivityService->connect())
-        {
-            notifyPlatformConnected();
-
-            updateGatewayAndDeleteDevices();
-
-            requestActuatorStatusesForDevices();
-
-            publishEverything();
-
-            publish();
-        }
-        else
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(RECONNECT_DELAY_MSEC));
-            connectToPlatform();
-        }
-    });
+    m_platformReconnectScheduler->start();
 }
 
 void Wolk::connectToDevices()
 {
-    addToCommandBuffer([=]() -> void {
-        if (m_deviceConnectivityService->connect())
-        {
-            notifyDevicesConnected();
-        }
-        else
-        {
-            std::this_thread::sleep_for(std::chrono::milliseconds(RECONNECT_DELAY_MSEC));
-            connectToDevices();
-        }
-    });
+    m_deviceReconnectScheduler->start();
 }
 
 void Wolk::requestActuatorStatusesForDevices()
@@ -442,14 +626,18 @@ void Wolk::requestActuatorStatusesForDevices()
         auto keys = m_deviceRepository->findAllDeviceKeys();
         if (keys)
         {
+            std::vector<std::string> subdeviceKeys;
             for (const auto& key : *keys)
             {
                 if (key == m_device.getKey())
                 {
                     continue;
                 }
-                requestActuatorStatusesForDevice(key);
+                subdeviceKeys.push_back(key);
             }
+
+            std::lock_guard<decltype(m_lock)> lg{m_lock};
+            m_dataService->requestActuatorStatusesForDevices(subdeviceKeys);
         }
     }
     else
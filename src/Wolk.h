@@ -23,11 +23,16 @@
 #include "ConfigurationProvider.h"
 #include "WolkBuilder.h"
 #include "model/GatewayDevice.h"
+#include "model/NumericReading.h"
 #include "utilities/StringUtils.h"
+#include "utilities/TrafficCapture.h"
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstddef>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <string>
@@ -40,15 +45,23 @@ class ConfigurationSetCommand;
 class ConnectivityService;
 class DataProtocol;
 class DataService;
+class DeadbandFilter;
+class DeviceRateLimiter;
 class DeviceStatusService;
 class DeviceRepository;
+class DeviceStatistics;
+class DeviceStatisticsReporter;
+class EmbeddedBrokerConnectivityService;
+class Executor;
 class ExistingDevicesRepository;
 class FileDownloadService;
 class FileRepository;
+class FileTransferCheckpointRepository;
 class FirmwareUpdateService;
 class GatewayDataProtocol;
 class GatewayDataService;
 class GatewayFirmwareUpdateProtocol;
+class GatewayInboundDeviceMessageHandler;
 class GatewayStatusProtocol;
 class GatewaySubdeviceRegistrationProtocol;
 class GatewayUpdateService;
@@ -57,13 +70,17 @@ class InboundPlatformMessageHandler;
 class JsonDFUProtocol;
 class JsonDownloadProtocol;
 class KeepAliveService;
+class MetricsFileExporter;
 class PublishingService;
 class Persistence;
+class ReadingTransformer;
+class ReconnectScheduler;
 class RegistrationMessageRouter;
 class RegistrationProtocol;
 class StatusMessageRouter;
 class StatusProtocol;
 class SubdeviceRegistrationService;
+class WindowedAggregator;
 
 class Wolk
 {
@@ -80,7 +97,8 @@ public:
     static WolkBuilder newBuilder(GatewayDevice device);
 
     /**
-     * @brief connect Establishes connection with WolkAbout IoT platform
+     * @brief connect Establishes connection with local broker and WolkAbout IoT platform
+     * Local broker is connected first, so device messages are accepted and queued while platform connection is set up
      */
     void connect();
 
@@ -183,6 +201,30 @@ public:
     void addSensorReading(const std::string& reference, const std::vector<std::string>& values,
                           unsigned long long int rtc = 0);
 
+    /**
+     * @brief Publishes numeric sensor reading to WolkAbout IoT Cloud<br>
+     *        This method is thread safe, and can be called from multiple thread simultaneously<br>
+     *        Values stay numbers until reading is serialized, reading with rtc 0 adopts current POSIX time
+     * @param reading Sensor reading
+     */
+    void addSensorReading(const NumericReading& reading);
+
+    /**
+     * @brief Publishes numeric sensor readings to WolkAbout IoT Cloud in one submission<br>
+     *        This method is thread safe, and can be called from multiple thread simultaneously<br>
+     *        Readings with rtc 0 adopt current POSIX time
+     * @param readings Pointer to first reading
+     * @param count Number of readings
+     */
+    void addSensorReadings(const NumericReading* readings, std::size_t count);
+
+    /**
+     * @brief Publishes numeric sensor readings to WolkAbout IoT Cloud in one submission<br>
+     *        This method is thread safe, and can be called from multiple thread simultaneously
+     * @param readings Sensor readings
+     */
+    void addSensorReadings(std::vector<NumericReading> readings);
+
     /**
      * @brief Publishes alarm to WolkAbout IoT Cloud<br>
      *        This method is thread safe, and can be called from multiple thread simultaneously
@@ -211,12 +253,89 @@ public:
      */
     void publish();
 
-private:
-    static const constexpr std::chrono::seconds KEEP_ALIVE_INTERVAL{600};
+    /**
+     * @brief Same as publishActuatorStatus, and reports when published status is handed to platform connection
+     * @param Actuator reference
+     * @return Future holding true once messages queued so far are handed over, or false if gateway was stopped
+     *         first. Future reports broken promise if gateway is destroyed before status is published
+     */
+    std::future<bool> publishActuatorStatusAsync(const std::string& reference);
+
+    /**
+     * @brief Same as publishConfiguration, and reports when published configuration is handed to platform connection
+     * @return Future holding true once messages queued so far are handed over, or false if gateway was stopped
+     *         first. Future reports broken promise if gateway is destroyed before configuration is published
+     */
+    std::future<bool> publishConfigurationAsync();
+
+    /**
+     * @brief Same as publish, and reports when published data is handed to platform connection<br>
+     *        Producers can pipeline on returned future instead of calling publish again to make sure data is sent
+     * @return Future holding true once messages queued so far are handed over, or false if gateway was stopped
+     *         first. Future reports broken promise if gateway is destroyed before data is published
+     */
+    std::future<bool> publishAsync();
 
+    /**
+     * @brief Changes backoff of reconnecting to WolkAbout IoT Cloud without reconnecting<br>
+     *        This method is thread safe, and can be called from multiple thread simultaneously
+     * @param initialDelay Delay after first failed attempt
+     * @param maximumDelay Upper bound of delay between attempts
+     * @param stablePeriod Time connection must stay up for backoff to be reset
+     */
+    void setPlatformReconnectBackoff(std::chrono::milliseconds initialDelay, std::chrono::milliseconds maximumDelay,
+                                     std::chrono::milliseconds stablePeriod);
+
+    /**
+     * @brief Changes rate limit applied to each subdevice<br>
+     *        This method is thread safe, and can be called from multiple thread simultaneously
+     * @param messagesPerSecond Average number of messages allowed per second
+     * @param burst Number of messages allowed at once
+     * @return false if gateway was built without subdevice rate limit
+     */
+    bool setSubdeviceRateLimit(double messagesPerSecond, std::size_t burst);
+
+    /**
+     * @brief Reloads per device deadband overrides of subdevice sensor readings<br>
+     *        This method is thread safe, and can be called from multiple thread simultaneously
+     * @param overrideFile Path of override file
+     * @return false if gateway was built without reading deadband, or if file can not be loaded
+     *         in which case previous overrides stay in use
+     */
+    bool reloadReadingDeadbandOverrides(const std::string& overrideFile);
+
+    /**
+     * @brief Reloads transformation rules of subdevice sensor readings<br>
+     *        This method is thread safe, and can be called from multiple thread simultaneously
+     * @param ruleFile Path of rule file
+     * @return false if gateway was built without reading transformation, or if file can not be loaded
+     *         in which case previous rules stay in use
+     */
+    bool reloadReadingTransformationRules(const std::string& ruleFile);
+
+    /**
+     * @brief Reloads windowed aggregation rules of subdevice sensor readings<br>
+     *        This method is thread safe, and can be called from multiple thread simultaneously
+     * @param ruleFile Path of rule file
+     * @return false if gateway was built without windowed aggregation, or if file can not be loaded
+     *         in which case previous rules stay in use
+     */
+    bool reloadWindowedAggregationRules(const std::string& ruleFile);
+
+    /**
+     * @brief Returns top talkers and slowest subdevices as JSON<br>
+     *        This method is thread safe, and can be called from multiple thread simultaneously
+     * @param count Number of devices in each list
+     * @return Empty string if gateway was built without device statistics
+     */
+    std::string getDeviceStatistics(std::size_t count = 10) const;
+
+private:
     explicit Wolk(GatewayDevice device);
 
-    void addToCommandBuffer(std::function<void()> command);
+    void addToCommandBuffer(const char* origin, std::function<void()> command);
+
+    std::future<bool> whenPublished();
 
     static unsigned long long int currentRtc();
 
@@ -232,11 +351,16 @@ private:
     void handleConfigurationSetCommand(const ConfigurationSetCommand& command);
     void handleConfigurationGetCommand();
 
+    void platformConnected();
     void platformDisconnected();
+    void platformPongTimedOut();
+    void devicesConnected();
     void devicesDisconnected();
 
     void gatewayUpdated();
     void deviceRegistered(const std::string& deviceKey);
+    void deviceDeleted(const std::string& deviceKey);
+    void resubscribeDevices();
     //
 
     void publishEverything();
@@ -257,17 +381,41 @@ private:
 
     GatewayDevice m_device;
 
+    // declared first so that it outlives every service scheduling work on it, may be shared with other gateways
+    std::shared_ptr<Executor> m_executor;
+
+    std::unique_ptr<MetricsFileExporter> m_metricsExporter;
+
     std::unique_ptr<DeviceRepository> m_deviceRepository;
     std::unique_ptr<ExistingDevicesRepository> m_existingDevicesRepository;
     std::unique_ptr<FileRepository> m_fileRepository;
+    std::unique_ptr<FileTransferCheckpointRepository> m_fileTransferCheckpointRepository;
 
     std::unique_ptr<Persistence> m_gatewayPersistence;
 
     std::unique_ptr<ConnectivityService> m_platformConnectivityService;
     std::unique_ptr<ConnectivityService> m_deviceConnectivityService;
+    // owned by m_deviceConnectivityService, set when subdevices connect to embedded broker
+    EmbeddedBrokerConnectivityService* m_embeddedBroker;
+
+    std::unique_ptr<ReconnectScheduler> m_platformReconnectScheduler;
+    std::unique_ptr<ReconnectScheduler> m_deviceReconnectScheduler;
+
+    std::shared_ptr<DeviceRateLimiter> m_subdeviceRateLimiter;
+    std::shared_ptr<DeviceStatistics> m_deviceStatistics;
+    std::unique_ptr<DeviceStatisticsReporter> m_deviceStatisticsReporter;
+    // owned by m_dataService
+    DeadbandFilter* m_readingDeadbandFilter;
+    // owned by m_dataService
+    ReadingTransformer* m_readingTransformer;
+    // owned by m_dataService
+    WindowedAggregator* m_windowedAggregator;
 
     std::unique_ptr<InboundPlatformMessageHandler> m_inboundPlatformMessageHandler;
     std::unique_ptr<InboundDeviceMessageHandler> m_inboundDeviceMessageHandler;
+    // owned by m_inboundDeviceMessageHandler, set when data channels are subscribed to per device
+    GatewayInboundDeviceMessageHandler* m_perDeviceSubscriptions;
+    std::atomic_bool m_resubscriptionPending;
 
     std::unique_ptr<PublishingService> m_platformPublisher;
     std::unique_ptr<PublishingService> m_devicePublisher;
@@ -280,6 +428,10 @@ private:
     std::unique_ptr<RegistrationProtocol> m_registrationProtocol;
     std::unique_ptr<GatewaySubdeviceRegistrationProtocol> m_gatewayRegistrationProtocol;
     std::unique_ptr<GatewayUpdateService> m_gatewayUpdateService;
+    // set on shard workers other than primary, gateway is updated on platform by the primary one
+    bool m_gatewayUpdateDelegated;
+    // gateway is updated and stale subdevices deleted once, on first connect of this instance
+    std::atomic_bool m_gatewayUpdatePending;
     std::unique_ptr<SubdeviceRegistrationService> m_subdeviceRegistrationService;
     std::shared_ptr<RegistrationMessageRouter> m_registrationMessageRouter;
 
@@ -314,7 +466,9 @@ private:
     template <class MessageHandler> class ConnectivityFacade : public ConnectivityServiceListener
     {
     public:
-        ConnectivityFacade(MessageHandler& handler, std::function<void()> connectionLostHandler);
+        ConnectivityFacade(MessageHandler& handler, std::function<void()> connectionLostHandler,
+                           std::shared_ptr<TrafficCaptureWriter> capture = nullptr,
+                           TrafficCapture::Side side = TrafficCapture::Side::PLATFORM);
 
         void messageReceived(const std::string& channel, const std::string& message) override;
         void connectionLost() override;
@@ -323,6 +477,9 @@ private:
     private:
         MessageHandler& m_messageHandler;
         std::function<void()> m_connectionLostHandler;
+
+        std::shared_ptr<TrafficCaptureWriter> m_capture;
+        const TrafficCapture::Side m_side;
     };
 
     std::shared_ptr<ConnectivityFacade<InboundPlatformMessageHandler>> m_platformConnectivityManager;
@@ -353,14 +510,24 @@ void Wolk::addSensorReading(const std::string& reference, const std::vector<T>&
 
 template <class MessageHandler>
 Wolk::ConnectivityFacade<MessageHandler>::ConnectivityFacade(MessageHandler& handler,
-                                                             std::function<void()> connectionLostHandler)
-: m_messageHandler{handler}, m_connectionLostHandler{std::move(connectionLostHandler)}
+                                                             std::function<void()> connectionLostHandler,
+                                                             std::shared_ptr<TrafficCaptureWriter> capture,
+                                                             TrafficCapture::Side side)
+: m_messageHandler{handler}
+, m_connectionLostHandler{std::move(connectionLostHandler)}
+, m_capture{std::move(capture)}
+, m_side{side}
 {
 }
 
 template <class MessageHandler>
 void Wolk::ConnectivityFacade<MessageHandler>::messageReceived(const std::string& channel, const std::string& message)
 {
+    if (m_capture)
+    {
+        m_capture->record(m_side, channel, message);
+    }
+
     m_messageHandler.messageReceived(channel, message);
 }
 
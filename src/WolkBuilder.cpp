@@ -21,11 +21,21 @@
 #include "StatusMessageRouter.h"
 #include "Wolk.h"
 #include "connectivity/ConnectivityService.h"
+#include "connectivity/EmbeddedBrokerConnectivityService.h"
+#include "connectivity/LocalSocketConnectivityService.h"
+#include "connectivity/ShardConnectivityService.h"
+#include "connectivity/SharedSubscriptionConnectivityService.h"
+#include "connectivity/UplinkConnectivityService.h"
 #include "connectivity/mqtt/MqttConnectivityService.h"
 #include "connectivity/mqtt/PahoMqttClient.h"
 #include "model/GatewayDevice.h"
 #include "model/Message.h"
+#include "persistence/CompressedReadingPersistence.h"
+#include "persistence/PriorityLanePersistence.h"
+#include "persistence/StoreAndForwardPersistence.h"
+#include "persistence/filesystem/JournalPersistence.h"
 #include "persistence/inmemory/GatewayInMemoryPersistence.h"
+#include "persistence/inmemory/GatewayRingBufferPersistence.h"
 #include "persistence/inmemory/InMemoryPersistence.h"
 #include "protocol/json/JsonDFUProtocol.h"
 #include "protocol/json/JsonDownloadProtocol.h"
@@ -35,12 +45,20 @@
 #include "protocol/json/JsonGatewaySubdeviceRegistrationProtocol.h"
 #include "protocol/json/JsonProtocol.h"
 #include "protocol/json/JsonRegistrationProtocol.h"
+#include "protocol/json/JsonStreamingProtocol.h"
 #include "protocol/json/JsonStatusProtocol.h"
+#include "repository/CachedDeviceRepository.h"
 #include "repository/ExistingDevicesRepository.h"
-#include "repository/JsonFileExistingDevicesRepository.h"
+#include "repository/JournalExistingDevicesRepository.h"
 #include "repository/SQLiteDeviceRepository.h"
 #include "repository/SQLiteFileRepository.h"
+#include "repository/SQLiteFileTransferCheckpointRepository.h"
+#include "repository/WriteBehindDeviceRepository.h"
+#include "repository/WriteBehindFileRepository.h"
 #include "service/DataService.h"
+#include "service/DeadbandFilter.h"
+#include "service/ReadingTransformer.h"
+#include "service/WindowedAggregator.h"
 #include "service/DeviceStatusService.h"
 #include "service/FileDownloadService.h"
 #include "service/FirmwareUpdateService.h"
@@ -49,9 +67,39 @@
 #include "service/KeepAliveService.h"
 #include "service/PublishingService.h"
 #include "service/SubdeviceRegistrationService.h"
+#include "utilities/BandwidthScheduler.h"
+#include "utilities/ByteUtils.h"
+#include "utilities/CommandWatchdog.h"
+#include "utilities/Deflate.h"
+#include "utilities/DeviceRateLimiter.h"
+#include "utilities/DeviceShard.h"
+#include "utilities/DeviceStatisticsReporter.h"
+#include "utilities/Executor.h"
+#include "utilities/MemoryBudget.h"
+#include "utilities/Metrics.h"
+#include "utilities/MetricsFileExporter.h"
+#include "utilities/ReconnectScheduler.h"
+#include "utilities/Tracer.h"
+#include "utilities/TrafficCapture.h"
 
+#include <algorithm>
+#include <atomic>
+#include <future>
 #include <stdexcept>
 
+namespace
+{
+// platform actuation commands, for gateway and subdevices alike
+const char* const ACTUATION_SET_CHANNEL_FILTER = "p2d/actuator_set/#";
+// subdevice readings, shed first when platform does not keep up
+const char* const SENSOR_READING_CHANNEL_FILTER = "d2p/sensor_reading/#";
+// appended to device key, with connection index, for client ids of additional platform connections
+const char* const PLATFORM_UPLINK_CLIENT_ID_SUFFIX = "-uplink-";
+const char* const PLATFORM_SHARD_CLIENT_ID_SUFFIX = "-shard-";
+// top talkers and slowest devices in each device statistics report
+const std::size_t DEVICE_STATISTICS_COUNT = 10;
+}    // namespace
+
 namespace wolkabout
 {
 WolkBuilder& WolkBuilder::platformHost(const std::string& host)
@@ -144,12 +192,416 @@ WolkBuilder& WolkBuilder::withUrlFileDownload(std::shared_ptr<UrlFileDownloader>
     return *this;
 }
 
+WolkBuilder& WolkBuilder::maxConcurrentFirmwareInstallations(std::size_t count, std::chrono::milliseconds timeout)
+{
+    m_maxConcurrentFirmwareInstallations = count;
+    m_firmwareInstallationTimeout = timeout;
+    return *this;
+}
+
 WolkBuilder& WolkBuilder::fileDownloadDirectory(const std::string& path)
 {
     m_fileDownloadDirectory = path;
     return *this;
 }
 
+WolkBuilder& WolkBuilder::storageDirectory(const std::string& path)
+{
+    m_storageDirectory = path;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withMetricsFile(const std::string& path, std::chrono::milliseconds interval)
+{
+    m_metricsFilePath = path;
+    m_metricsExportInterval = interval;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::executor(std::shared_ptr<Executor> executor)
+{
+    m_executor = std::move(executor);
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withDeviceStatistics(const std::string& path, std::chrono::milliseconds interval,
+                                               const std::string& reference, std::size_t trackedDevices)
+{
+    m_deviceStatisticsEnabled = true;
+    m_deviceStatisticsFilePath = path;
+    m_deviceStatisticsInterval = interval;
+    m_deviceStatisticsReference = reference;
+    m_deviceStatisticsCapacity = trackedDevices;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::filePacketRequestWindow(unsigned window)
+{
+    m_filePacketRequestWindow = window;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::concurrentFileTransfers(std::size_t transfers)
+{
+    m_concurrentFileTransfers = transfers;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::fileCacheQuota(std::uint64_t bytes)
+{
+    m_fileCacheQuota = bytes;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::fileTransferBandwidth(std::uint64_t linkBytesPerSecond, double maximumShare)
+{
+    m_linkBandwidth = linkBytesPerSecond;
+    m_fileTransferBandwidthShare = maximumShare;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withPersistentOutboundQueue(const std::string& directory, std::uint64_t maximumSize)
+{
+    m_outboundQueueDirectory = directory;
+    m_outboundQueueMaximumSize = maximumSize;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::publishBatchSize(std::size_t size)
+{
+    m_publishBatchSize = size;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::limitOutboundQueue(std::size_t maximumMessages, std::uint64_t maximumBytes,
+                                             GatewayInMemoryPersistence::OverflowPolicy policy)
+{
+    m_outboundQueueMaximumMessages = maximumMessages;
+    m_outboundQueueMaximumBytes = maximumBytes;
+    m_outboundQueueOverflowPolicy = policy;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::prioritizeOutboundMessages(std::size_t laneLimit)
+{
+    m_outboundPriorityLanesEnabled = true;
+    m_outboundPriorityLaneLimit = laneLimit;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::storeAndForward(std::size_t liveCapacity, std::size_t liveWeight,
+                                          std::chrono::milliseconds deduplicationWindow)
+{
+    m_storeAndForwardEnabled = true;
+    m_storeAndForwardLiveCapacity = liveCapacity;
+    m_storeAndForwardLiveWeight = liveWeight;
+    m_deduplicationWindow = deduplicationWindow;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::compressBufferedReadings(std::size_t maximumBytes, std::size_t readingsPerMessage)
+{
+    m_compressedReadingsEnabled = true;
+    m_compressedReadingsMaximumBytes = maximumBytes;
+    m_compressedReadingsPerMessage = readingsPerMessage;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::compressPlatformPayloads(std::size_t threshold)
+{
+    m_compressionThreshold = threshold;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::publishReadingsAtMostOnce()
+{
+    m_readingsAtMostOnce = true;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::inboundDeviceMessageWorkers(std::size_t workers)
+{
+    m_inboundDeviceMessageWorkers = workers;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::platformReconnectBackoff(std::chrono::milliseconds initialDelay,
+                                                   std::chrono::milliseconds maximumDelay,
+                                                   std::chrono::milliseconds stablePeriod)
+{
+    m_platformReconnectInitialDelay = initialDelay;
+    m_platformReconnectMaximumDelay = maximumDelay;
+    m_platformReconnectStablePeriod = stablePeriod;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::platformConnections(std::size_t connections)
+{
+    m_platformConnections = connections;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::localBrokerConnections(std::size_t connections, const std::string& shareGroup)
+{
+    m_localBrokerConnections = connections;
+    m_localBrokerShareGroup = shareGroup;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::embeddedBroker(const std::string& address, std::uint16_t port)
+{
+    m_embeddedBrokerAddress = address;
+    m_embeddedBrokerPort = port;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::localSocket(const std::string& path)
+{
+    m_localSocketPath = path;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::shard(std::size_t index, std::size_t count, bool routed)
+{
+    m_shardIndex = index;
+    m_shardCount = count;
+    m_shardRouted = routed;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::subscribePerDevice()
+{
+    m_perDeviceSubscriptions = true;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::subdeviceRateLimit(double messagesPerSecond, std::size_t burst,
+                                             std::chrono::milliseconds quarantineAfter,
+                                             std::chrono::milliseconds quarantineDuration)
+{
+    m_subdeviceMessagesPerSecond = messagesPerSecond;
+    m_subdeviceMessageBurst = burst;
+    m_subdeviceQuarantineAfter = quarantineAfter;
+    m_subdeviceQuarantineDuration = quarantineDuration;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::subdeviceQuarantineAlarm(const std::string& alarmReference)
+{
+    m_subdeviceQuarantineAlarmReference = alarmReference;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::subdeviceQuarantineHandler(std::function<void(const std::string&, bool)> handler)
+{
+    m_subdeviceQuarantineHandler = std::move(handler);
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::platformBackpressure(std::size_t highWatermark, std::size_t lowWatermark,
+                                               std::chrono::milliseconds consumerDelay)
+{
+    m_backpressureHighWatermark = highWatermark;
+    m_backpressureLowWatermark = lowWatermark;
+    m_backpressureConsumerDelay = consumerDelay;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::databaseWriteAheadLogging(bool enabled)
+{
+    m_databaseWriteAheadLogging = enabled;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::databaseReaderSessions(std::size_t sessions)
+{
+    m_databaseReaderSessions = sessions;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::databaseWriteBehind(std::chrono::milliseconds commitDelay)
+{
+    m_databaseWriteBehindDelay = commitDelay;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::routingSnapshot(const std::string& snapshotFile)
+{
+    m_routingSnapshotFile = snapshotFile;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::aggregateSensorReadings(std::chrono::milliseconds window, std::size_t maxReadings)
+{
+    m_readingAggregationWindow = window;
+    m_readingAggregationMaxReadings = maxReadings;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::coalesceActuations(std::chrono::milliseconds interval)
+{
+    m_actuationCoalescingInterval = interval;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::coalesceConfigurations(std::chrono::milliseconds window, std::chrono::milliseconds pacing)
+{
+    m_configurationCoalescingWindow = window;
+    m_configurationPacing = pacing;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::cacheDeviceState(std::chrono::milliseconds maxAge)
+{
+    m_deviceStateMaxAge = maxAge;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withPersistentGatewayData(const std::string& file)
+{
+    m_gatewayDataJournalFile = file;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::autoFlushGatewayData(std::size_t maxItems, std::size_t maxBytes,
+                                               std::chrono::milliseconds maxAge)
+{
+    m_gatewayDataFlushMaxItems = maxItems;
+    m_gatewayDataFlushMaxBytes = maxBytes;
+    m_gatewayDataFlushMaxAge = maxAge;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::bulkActuatorStatusRequests(bool enabled)
+{
+    m_bulkActuatorStatusRequests = enabled;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withReadingDeadband(double percentOfRange, std::chrono::milliseconds maxSilence,
+                                              const std::string& overrideFile)
+{
+    m_readingDeadbandEnabled = true;
+    m_readingDeadbandPercentOfRange = percentOfRange;
+    m_readingDeadbandMaxSilence = maxSilence;
+    m_readingDeadbandOverrideFile = overrideFile;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withReadingTransformation(const std::string& ruleFile)
+{
+    m_readingTransformationRuleFile = ruleFile;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::withWindowedAggregation(const std::string& ruleFile)
+{
+    m_windowedAggregationRuleFile = ruleFile;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::staggerStatusPolling(std::size_t buckets)
+{
+    m_statusPollingBuckets = buckets;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::coalesceStatusUpdates(std::chrono::milliseconds window)
+{
+    m_statusUpdateCoalescingWindow = window;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::adaptiveKeepAlive(std::chrono::milliseconds pongTimeout)
+{
+    m_adaptiveKeepAliveEnabled = true;
+    m_keepAlivePongTimeout = pongTimeout;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::keepAliveInterval(std::chrono::seconds interval)
+{
+    m_keepAliveInterval = interval;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::statusResponseTimeout(std::chrono::seconds timeout)
+{
+    m_statusResponseTimeout = timeout;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::registrationRetry(short count, std::chrono::milliseconds timeout)
+{
+    m_registrationRetryCount = count;
+    m_registrationRetryTimeout = timeout;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::filePacketLimits(std::uint64_t maxPacketSize, std::chrono::milliseconds packetRequestTimeout)
+{
+    m_maxFilePacketSize = maxPacketSize;
+    m_filePacketRequestTimeout = packetRequestTimeout;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::performanceProfile(const PerformanceProfile& profile)
+{
+    m_outboundQueueMaximumMessages = profile.outboundQueueMaximumMessages;
+    m_outboundQueueMaximumBytes = profile.outboundQueueMaximumBytes;
+    m_publishBatchSize = profile.publishBatchSize;
+
+    m_inboundDeviceMessageWorkers = profile.inboundDeviceMessageWorkers;
+
+    m_readingAggregationWindow = profile.readingAggregationWindow;
+    m_readingAggregationMaxReadings = profile.readingAggregationMaxReadings;
+    m_statusUpdateCoalescingWindow = profile.statusUpdateCoalescingWindow;
+    m_statusPollingBuckets = profile.statusPollingBuckets;
+    m_filePacketRequestWindow = profile.filePacketRequestWindow;
+    m_concurrentFileTransfers = profile.concurrentFileTransfers;
+
+    m_keepAliveInterval = profile.keepAliveInterval;
+    m_statusResponseTimeout = profile.statusResponseTimeout;
+    m_registrationRetryCount = profile.registrationRetryCount;
+    m_registrationRetryTimeout = profile.registrationRetryTimeout;
+    m_maxFilePacketSize = profile.maxFilePacketSize;
+    m_filePacketRequestTimeout = profile.filePacketRequestTimeout;
+    m_platformReconnectInitialDelay = profile.reconnectInitialDelay;
+    m_platformReconnectMaximumDelay = profile.reconnectMaximumDelay;
+    m_memoryBudget = profile.memoryBudget;
+    m_memoryBudgetSet = true;
+
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::memoryBudget(std::uint64_t bytes)
+{
+    m_memoryBudget = bytes;
+    m_memoryBudgetSet = true;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::traceSampling(std::uint32_t sampleOneIn, std::size_t capacity)
+{
+    m_traceSampleOneIn = sampleOneIn;
+    m_traceCapacity = capacity;
+    m_traceSamplingSet = true;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::commandWatchdog(std::chrono::milliseconds threshold, bool dumpOrigins)
+{
+    m_commandWatchdogThreshold = threshold;
+    m_commandWatchdogDumpOrigins = dumpOrigins;
+    return *this;
+}
+
+WolkBuilder& WolkBuilder::captureTraffic(const std::string& path)
+{
+    m_trafficCapturePath = path;
+    return *this;
+}
+
 std::unique_ptr<Wolk> WolkBuilder::build()
 {
     if (m_device.getKey().empty())
@@ -196,10 +648,106 @@ std::unique_ptr<Wolk> WolkBuilder::build()
         throw std::logic_error("Url downloader must be provided when url download is enabled");
     }
 
+    if (m_outboundQueueOverflowPolicy == GatewayInMemoryPersistence::OverflowPolicy::SPILL &&
+        m_outboundQueueDirectory.empty())
+    {
+        throw std::logic_error("Persistent outbound queue must be set when spilling outbound messages");
+    }
+
+    if (m_databaseReaderSessions != 0 && !m_databaseWriteAheadLogging)
+    {
+        throw std::logic_error("Database write ahead logging must be enabled when using reader sessions");
+    }
+
+    if (m_linkBandwidth != 0 && (m_fileTransferBandwidthShare <= 0 || m_fileTransferBandwidthShare > 1))
+    {
+        throw std::logic_error("File transfer bandwidth share must be greater than 0 and at most 1");
+    }
+
+    if (m_subdeviceMessagesPerSecond <= 0 &&
+        (!m_subdeviceQuarantineAlarmReference.empty() || m_subdeviceQuarantineHandler))
+    {
+        throw std::logic_error("Subdevice rate limit must be set when using quarantine alarm or handler");
+    }
+
+    if (m_platformReconnectInitialDelay.count() <= 0)
+    {
+        throw std::logic_error("Platform reconnect initial delay must be greater than 0");
+    }
+
+    if (m_localBrokerConnections > 1 && m_localBrokerShareGroup.empty())
+    {
+        throw std::logic_error("Share group must be set when using several local broker connections");
+    }
+
+    if (m_backpressureHighWatermark != 0 && m_backpressureLowWatermark >= m_backpressureHighWatermark)
+    {
+        throw std::logic_error("Backpressure low watermark must be lower than high watermark");
+    }
+
+    if (m_keepAliveInterval.count() <= 0 || m_statusResponseTimeout.count() <= 0)
+    {
+        throw std::logic_error("Keep alive interval and status response timeout must be greater than 0");
+    }
+
+    if (m_registrationRetryTimeout.count() <= 0 || m_filePacketRequestTimeout.count() <= 0)
+    {
+        throw std::logic_error("Registration retry and file packet request timeouts must be greater than 0");
+    }
+
+    if (m_maxFilePacketSize <= 2 * ByteUtils::SHA_256_HASH_BYTE_LENGTH)
+    {
+        throw std::logic_error("Maximum file packet size must be greater than size of packet hashes");
+    }
+
+    if (m_shardIndex >= std::max<std::size_t>(m_shardCount, 1))
+    {
+        throw std::logic_error("Shard index must be lower than shard count");
+    }
+
+    // budget, tracer and watchdog are shared by all gateways in process, one that does not set them keeps them as is
+    if (m_memoryBudgetSet)
+    {
+        MemoryBudget::getInstance().setLimit(m_memoryBudget);
+    }
+
+    if (m_traceSamplingSet)
+    {
+        Tracer::getInstance().configure(m_traceSampleOneIn, m_traceCapacity);
+    }
+
+    if (m_commandWatchdogThreshold.count() > 0)
+    {
+        CommandWatchdog::getInstance().configure(m_commandWatchdogThreshold, m_commandWatchdogDumpOrigins);
+    }
+
+    std::shared_ptr<TrafficCaptureWriter> trafficCapture;
+    if (!m_trafficCapturePath.empty())
+    {
+        trafficCapture = std::make_shared<TrafficCaptureWriter>(m_trafficCapturePath);
+        if (!trafficCapture->isOpen())
+        {
+            throw std::logic_error("Unable to create traffic capture file " + m_trafficCapturePath);
+        }
+    }
+
     auto wolk = std::unique_ptr<Wolk>(new Wolk(m_device));
 
+    // Setup executor shared by services for background and delayed work
+    wolk->m_executor = m_executor ? m_executor : std::make_shared<Executor>();
+
+    if (!m_metricsFilePath.empty())
+    {
+        wolk->m_metricsExporter.reset(new MetricsFileExporter(MetricsRegistry::getInstance(), m_metricsFilePath,
+                                                              m_metricsExportInterval, *wolk->m_executor));
+    }
+
     // Setup protocols
+#ifdef WOLKGATEWAY_STREAMING_JSON
+    wolk->m_dataProtocol.reset(new wolkabout::JsonStreamingProtocol(true));
+#else
     wolk->m_dataProtocol.reset(new wolkabout::JsonProtocol(true));
+#endif
     wolk->m_gatewayDataProtocol.reset(new wolkabout::JsonGatewayDataProtocol());
 
     wolk->m_registrationProtocol.reset(new JsonRegistrationProtocol());
@@ -213,39 +761,227 @@ std::unique_ptr<Wolk> WolkBuilder::build()
 
     wolk->m_fileDownloadProtocol.reset(new JsonDownloadProtocol(true));
 
-    // Setup device repository
-    wolk->m_deviceRepository.reset(new SQLiteDeviceRepository());
+    // Repositories create their schemas and read files on startup, so they are opened concurrently.
+    // SQLite repositories share database file and are opened one after another to avoid lock contention.
+    const std::string storagePrefix = m_storageDirectory.empty() ? "" : m_storageDirectory + "/";
+    const std::string database = storagePrefix + DATABASE;
+    auto sqliteRepositories = std::async(std::launch::async, [&] {
+        std::unique_ptr<DeviceRepository> deviceRepository{new SQLiteDeviceRepository(
+          database, m_databaseWriteAheadLogging, m_databaseWriteAheadLogging, m_databaseReaderSessions)};
+        std::unique_ptr<FileRepository> fileRepository{new SQLiteFileRepository(database)};
+        if (m_databaseWriteBehindDelay.count() > 0)
+        {
+            deviceRepository.reset(
+              new WriteBehindDeviceRepository(std::move(deviceRepository), m_databaseWriteBehindDelay));
+            fileRepository.reset(new WriteBehindFileRepository(std::move(fileRepository), m_databaseWriteBehindDelay));
+        }
 
-    // Setup existing devices repository
-    wolk->m_existingDevicesRepository.reset(new JsonFileExistingDevicesRepository());
+        std::unique_ptr<CachedDeviceRepository> cachedDeviceRepository{
+          new CachedDeviceRepository(std::move(deviceRepository))};
+        if (!m_routingSnapshotFile.empty())
+        {
+            cachedDeviceRepository->loadSnapshot(m_routingSnapshotFile, database);
+        }
+
+        wolk->m_deviceRepository = std::move(cachedDeviceRepository);
+        wolk->m_fileRepository = std::move(fileRepository);
+        wolk->m_fileTransferCheckpointRepository.reset(new SQLiteFileTransferCheckpointRepository(database));
+    });
 
-    // Setup file repository
-    wolk->m_fileRepository.reset(new SQLiteFileRepository(DATABASE));
+    auto existingDevicesRepository = std::async(std::launch::async, [&] {
+        wolk->m_existingDevicesRepository.reset(new JournalExistingDevicesRepository(
+          storagePrefix + "existingDevices.journal", storagePrefix + "existingDevices.json"));
+    });
 
     // Setup connectivity services
-    wolk->m_platformConnectivityService.reset(new MqttConnectivityService(std::make_shared<PahoMqttClient>(),
-                                                                          m_device.getKey(), m_device.getPassword(),
-                                                                          m_platformHost, m_platformTrustStore));
-    wolk->m_platformConnectivityService->setUncontrolledDisonnectMessage(
-      wolk->m_statusProtocol->makeLastWillMessage(m_device.getKey()));
+    const DeviceShard shard{m_shardIndex, m_shardCount};
+    const std::string platformClientId =
+      shard.isPrimary() ? m_device.getKey()
+                        : m_device.getKey() + PLATFORM_SHARD_CLIENT_ID_SUFFIX + std::to_string(shard.getIndex());
+    if (shard.isPrimary())
+    {
+        wolk->m_platformConnectivityService.reset(new MqttConnectivityService(
+          std::make_shared<PahoMqttClient>(), m_device.getKey(), m_device.getPassword(), m_platformHost,
+          m_platformTrustStore));
+    }
+    else
+    {
+        wolk->m_platformConnectivityService.reset(
+          new MqttConnectivityService(std::make_shared<PahoMqttClient>(), m_device.getKey(), m_device.getPassword(),
+                                      m_platformHost, m_platformTrustStore, platformClientId));
+    }
+    UplinkConnectivityService* uplinks = nullptr;
+    if (m_platformConnections > 1)
+    {
+        std::vector<std::unique_ptr<ConnectivityService>> connections;
+        connections.push_back(std::move(wolk->m_platformConnectivityService));
+        for (std::size_t i = 1; i < m_platformConnections; ++i)
+        {
+            connections.emplace_back(new MqttConnectivityService(
+              std::make_shared<PahoMqttClient>(), m_device.getKey(), m_device.getPassword(), m_platformHost,
+              m_platformTrustStore, platformClientId + PLATFORM_UPLINK_CLIENT_ID_SUFFIX + std::to_string(i)));
+        }
+
+        uplinks = new UplinkConnectivityService(std::move(connections));
+        wolk->m_platformConnectivityService.reset(uplinks);
+    }
+    if (shard.getCount() > 1)
+    {
+        wolk->m_platformConnectivityService.reset(
+          new ShardConnectivityService(std::move(wolk->m_platformConnectivityService), shard, false));
+    }
+    // other workers going offline does not take gateway offline
+    if (shard.isPrimary())
+    {
+        wolk->m_platformConnectivityService->setUncontrolledDisonnectMessage(
+          wolk->m_statusProtocol->makeLastWillMessage(m_device.getKey()));
+    }
 
     const std::string localMqttClientId = std::string("Gateway-").append(m_device.getKey());
-    wolk->m_deviceConnectivityService.reset(new MqttConnectivityService(
-      std::make_shared<PahoMqttClient>(), m_device.getKey(), m_device.getPassword(), m_gatewayHost, localMqttClientId));
+    if (!m_embeddedBrokerAddress.empty())
+    {
+        wolk->m_embeddedBroker = new EmbeddedBrokerConnectivityService(m_embeddedBrokerAddress, m_embeddedBrokerPort);
+        wolk->m_deviceConnectivityService.reset(wolk->m_embeddedBroker);
+    }
+    else if (m_localBrokerConnections > 1)
+    {
+        std::vector<std::unique_ptr<ConnectivityService>> connections;
+        for (std::size_t i = 0; i < m_localBrokerConnections; ++i)
+        {
+            connections.emplace_back(new MqttConnectivityService(std::make_shared<PahoMqttClient>(), m_device.getKey(),
+                                                                 m_device.getPassword(), m_gatewayHost,
+                                                                 localMqttClientId + "-" + std::to_string(i)));
+        }
 
-    wolk->m_platformPublisher.reset(new PublishingService(
-      *wolk->m_platformConnectivityService, std::unique_ptr<GatewayPersistence>(new GatewayInMemoryPersistence())));
+        wolk->m_deviceConnectivityService.reset(
+          new SharedSubscriptionConnectivityService(std::move(connections), m_localBrokerShareGroup));
+    }
+    else
+    {
+        wolk->m_deviceConnectivityService.reset(new MqttConnectivityService(std::make_shared<PahoMqttClient>(),
+                                                                            m_device.getKey(), m_device.getPassword(),
+                                                                            m_gatewayHost, localMqttClientId));
+    }
+
+    if (shard.getCount() > 1)
+    {
+        wolk->m_deviceConnectivityService.reset(
+          new ShardConnectivityService(std::move(wolk->m_deviceConnectivityService), shard, m_shardRouted));
+    }
+
+    if (!m_localSocketPath.empty())
+    {
+        wolk->m_deviceConnectivityService.reset(
+          new LocalSocketConnectivityService(m_localSocketPath, std::move(wolk->m_deviceConnectivityService)));
+    }
+
+    std::unique_ptr<GatewayPersistence> platformPersistence =
+      makePlatformPersistence(m_outboundQueueDirectory, *wolk->m_gatewayDataProtocol);
+
+    // rethrows exceptions thrown while opening repositories
+    sqliteRepositories.get();
+    existingDevicesRepository.get();
+
+    wolk->m_platformPublisher.reset(new PublishingService(*wolk->m_platformConnectivityService,
+                                                          std::move(platformPersistence), m_publishBatchSize,
+                                                          "platform_publisher"));
+    wolk->m_platformPublisher->setCompression(m_compressionThreshold, Deflate::READING_DICTIONARY);
+    if (m_readingsAtMostOnce)
+    {
+        GatewayDataProtocol* dataProtocol = wolk->m_gatewayDataProtocol.get();
+        wolk->m_platformPublisher->setDeliveryClassifier(
+          [dataProtocol](const Message& message) { return dataProtocol->getDeliveryClass(message); });
+    }
+    for (std::size_t i = 1; uplinks && i < uplinks->getConnectionCount(); ++i)
+    {
+        const auto queueDirectory =
+          m_outboundQueueDirectory.empty() ? "" : m_outboundQueueDirectory + "/uplink" + std::to_string(i);
+        wolk->m_platformPublisher->addPartition(uplinks->getConnection(i),
+                                                makePlatformPersistence(queueDirectory, *wolk->m_gatewayDataProtocol));
+    }
+
+    std::shared_ptr<BandwidthScheduler> platformBandwidthScheduler;
+    if (m_linkBandwidth != 0)
+    {
+        platformBandwidthScheduler =
+          std::make_shared<BandwidthScheduler>(m_linkBandwidth, m_fileTransferBandwidthShare);
+        wolk->m_platformPublisher->setBandwidthScheduler(platformBandwidthScheduler);
+    }
     wolk->m_devicePublisher.reset(new PublishingService(
-      *wolk->m_deviceConnectivityService, std::unique_ptr<GatewayPersistence>(new GatewayInMemoryPersistence())));
+      *wolk->m_deviceConnectivityService,
+      std::unique_ptr<GatewayPersistence>(
+        new GatewayRingBufferPersistence(GatewayRingBufferPersistence::DEFAULT_CAPACITY, "device_outbound_queue")),
+      m_publishBatchSize, "device_publisher"));
+
+    Wolk* gateway = wolk.get();
+    wolk->m_platformReconnectScheduler.reset(new ReconnectScheduler(
+      *wolk->m_executor, [gateway] { return gateway->m_platformConnectivityService->connect(); },
+      [gateway] { gateway->platformConnected(); }, "platform", m_platformReconnectInitialDelay,
+      m_platformReconnectMaximumDelay, m_platformReconnectStablePeriod));
+    wolk->m_deviceReconnectScheduler.reset(new ReconnectScheduler(
+      *wolk->m_executor, [gateway] { return gateway->m_deviceConnectivityService->connect(); },
+      [gateway] { gateway->devicesConnected(); }, "devices"));
 
-    wolk->m_inboundPlatformMessageHandler.reset(new GatewayInboundPlatformMessageHandler(m_device.getKey()));
-    wolk->m_inboundDeviceMessageHandler.reset(new GatewayInboundDeviceMessageHandler());
+    std::unique_ptr<GatewayInboundPlatformMessageHandler> inboundPlatformMessageHandler{
+      new GatewayInboundPlatformMessageHandler(m_device.getKey())};
+    inboundPlatformMessageHandler->addPriorityChannel(ACTUATION_SET_CHANNEL_FILTER);
+    wolk->m_inboundPlatformMessageHandler = std::move(inboundPlatformMessageHandler);
+    std::unique_ptr<GatewayInboundDeviceMessageHandler> inboundDeviceMessageHandler{
+      new GatewayInboundDeviceMessageHandler(m_inboundDeviceMessageWorkers)};
+    if (m_subdeviceMessagesPerSecond > 0)
+    {
+        auto rateLimiter =
+          std::make_shared<DeviceRateLimiter>(m_subdeviceMessagesPerSecond, m_subdeviceMessageBurst,
+                                              m_subdeviceQuarantineAfter, m_subdeviceQuarantineDuration);
+
+        if (!m_subdeviceQuarantineAlarmReference.empty() || m_subdeviceQuarantineHandler)
+        {
+            const auto alarmReference = m_subdeviceQuarantineAlarmReference;
+            const auto handler = m_subdeviceQuarantineHandler;
+            auto quarantinedDevices = std::make_shared<std::atomic<std::size_t>>(0);
+            rateLimiter->setQuarantineListener([=](const std::string& deviceKey, bool quarantined) {
+                // alarm is raised by the first quarantined device and cleared by the last one released
+                const auto previous = quarantined ? quarantinedDevices->fetch_add(1) : quarantinedDevices->fetch_sub(1);
+                if (!alarmReference.empty() && previous == (quarantined ? 0 : 1))
+                {
+                    gateway->addAlarm(alarmReference, quarantined);
+                }
+
+                if (handler)
+                {
+                    handler(deviceKey, quarantined);
+                }
+            });
+        }
+
+        inboundDeviceMessageHandler->setRateLimiter(rateLimiter);
+        wolk->m_subdeviceRateLimiter = rateLimiter;
+    }
+    if (m_backpressureHighWatermark != 0)
+    {
+        inboundDeviceMessageHandler->addSheddableChannel(SENSOR_READING_CHANNEL_FILTER);
+        inboundDeviceMessageHandler->setBackpressureDelay(m_backpressureConsumerDelay);
+
+        // platform publisher is destroyed before inbound handler, so listener never outlives it
+        GatewayInboundDeviceMessageHandler* deviceMessageHandler = inboundDeviceMessageHandler.get();
+        wolk->m_platformPublisher->setBackpressureListener(
+          m_backpressureHighWatermark, m_backpressureLowWatermark,
+          [deviceMessageHandler](bool enabled) { deviceMessageHandler->setBackpressure(enabled); });
+    }
+    if (m_deviceStatisticsEnabled)
+    {
+        wolk->m_deviceStatistics = std::make_shared<DeviceStatistics>(m_deviceStatisticsCapacity);
+        inboundDeviceMessageHandler->setDeviceStatistics(wolk->m_deviceStatistics);
+    }
+    wolk->m_inboundDeviceMessageHandler = std::move(inboundDeviceMessageHandler);
 
     wolk->m_platformConnectivityManager = std::make_shared<Wolk::ConnectivityFacade<InboundPlatformMessageHandler>>(
-      *wolk->m_inboundPlatformMessageHandler, [&] { wolk->platformDisconnected(); });
+      *wolk->m_inboundPlatformMessageHandler, [&] { wolk->platformDisconnected(); }, trafficCapture,
+      TrafficCapture::Side::PLATFORM);
 
     wolk->m_deviceConnectivityManager = std::make_shared<Wolk::ConnectivityFacade<InboundDeviceMessageHandler>>(
-      *wolk->m_inboundDeviceMessageHandler, [&] { wolk->devicesDisconnected(); });
+      *wolk->m_inboundDeviceMessageHandler, [&] { wolk->devicesDisconnected(); }, trafficCapture,
+      TrafficCapture::Side::DEVICE);
 
     wolk->m_platformConnectivityService->setListener(wolk->m_platformConnectivityManager);
     wolk->m_deviceConnectivityService->setListener(wolk->m_deviceConnectivityManager);
@@ -265,19 +1001,24 @@ std::unique_ptr<Wolk> WolkBuilder::build()
 
     // Setup gateway update service
     wolk->m_gatewayUpdateService.reset(new GatewayUpdateService(m_device.getKey(), *wolk->m_registrationProtocol,
-                                                                *wolk->m_deviceRepository, *wolk->m_platformPublisher));
+                                                                *wolk->m_deviceRepository, *wolk->m_platformPublisher,
+                                                                *wolk->m_executor));
 
     wolk->m_gatewayUpdateService->onGatewayUpdated([&] { wolk->gatewayUpdated(); });
+    wolk->m_gatewayUpdateDelegated = !shard.isPrimary();
 
     if (m_device.getSubdeviceManagement().value() == SubdeviceManagement::GATEWAY)
     {
         // Setup registration service
         wolk->m_subdeviceRegistrationService.reset(new SubdeviceRegistrationService(
           m_device.getKey(), *wolk->m_registrationProtocol, *wolk->m_gatewayRegistrationProtocol,
-          *wolk->m_deviceRepository, *wolk->m_platformPublisher, *wolk->m_devicePublisher));
+          *wolk->m_deviceRepository, *wolk->m_platformPublisher, *wolk->m_devicePublisher, *wolk->m_executor,
+          m_registrationRetryCount, m_registrationRetryTimeout));
 
         wolk->m_subdeviceRegistrationService->onDeviceRegistered(
           [&](const std::string& deviceKey) { wolk->deviceRegistered(deviceKey); });
+        wolk->m_subdeviceRegistrationService->onDeviceDeleted(
+          [gateway](const std::string& deviceKey) { gateway->deviceDeleted(deviceKey); });
     }
 
     wolk->m_registrationMessageRouter = std::make_shared<RegistrationMessageRouter>(
@@ -293,19 +1034,32 @@ std::unique_ptr<Wolk> WolkBuilder::build()
     {
         wolk->m_deviceStatusService.reset(new DeviceStatusService(
           m_device.getKey(), *wolk->m_statusProtocol, *wolk->m_gatewayStatusProtocol, wolk->m_deviceRepository.get(),
-          *wolk->m_platformPublisher, *wolk->m_devicePublisher, Wolk::KEEP_ALIVE_INTERVAL));
+          *wolk->m_platformPublisher, *wolk->m_devicePublisher, m_keepAliveInterval, m_statusResponseTimeout));
+        wolk->m_deviceStatusService->setStaggeredPolling(m_statusPollingBuckets, wolk->m_executor.get());
     }
     else
     {
         wolk->m_deviceStatusService.reset(
           new DeviceStatusService(m_device.getKey(), *wolk->m_statusProtocol, *wolk->m_gatewayStatusProtocol, nullptr,
-                                  *wolk->m_platformPublisher, *wolk->m_devicePublisher, Wolk::KEEP_ALIVE_INTERVAL));
+                                  *wolk->m_platformPublisher, *wolk->m_devicePublisher, m_keepAliveInterval,
+                                  m_statusResponseTimeout));
     }
 
-    if (m_keepAliveEnabled)
+    wolk->m_deviceStatusService->setStatusUpdateCoalescing(m_statusUpdateCoalescingWindow, wolk->m_executor.get());
+
+    if (m_keepAliveEnabled && shard.isPrimary())
     {
         wolk->m_keepAliveService.reset(new KeepAliveService(m_device.getKey(), *wolk->m_statusProtocol,
-                                                            *wolk->m_platformPublisher, Wolk::KEEP_ALIVE_INTERVAL));
+                                                            *wolk->m_platformPublisher, m_keepAliveInterval));
+
+        if (m_adaptiveKeepAliveEnabled)
+        {
+            PublishingService* platformPublisher = wolk->m_platformPublisher.get();
+            wolk->m_keepAliveService->setOutboundTrafficCounter(
+              [platformPublisher] { return platformPublisher->getPublishedMessageCount(); });
+            wolk->m_keepAliveService->setPongTimeout(m_keepAlivePongTimeout, wolk->m_executor.get(),
+                                                     [gateway] { gateway->platformPongTimedOut(); });
+        }
     }
 
     wolk->m_statusMessageRouter = std::make_shared<StatusMessageRouter>(
@@ -320,6 +1074,57 @@ std::unique_ptr<Wolk> WolkBuilder::build()
         wolk->m_dataService = std::make_shared<DataService>(
           m_device.getKey(), *wolk->m_dataProtocol, *wolk->m_gatewayDataProtocol, wolk->m_deviceRepository.get(),
           *wolk->m_platformPublisher, *wolk->m_devicePublisher);
+        wolk->m_dataService->setReadingAggregation(m_readingAggregationWindow, m_readingAggregationMaxReadings,
+                                                   wolk->m_executor.get());
+        wolk->m_dataService->setActuationCoalescing(m_actuationCoalescingInterval, wolk->m_executor.get());
+        wolk->m_dataService->setConfigurationCoalescing(m_configurationCoalescingWindow, m_configurationPacing,
+                                                        wolk->m_executor.get());
+        wolk->m_dataService->setDeviceStateCache(m_deviceStateMaxAge);
+        wolk->m_dataService->setBulkActuatorStatusRequests(m_bulkActuatorStatusRequests);
+
+        if (m_readingDeadbandEnabled)
+        {
+            std::unique_ptr<DeadbandFilter> deadbandFilter{
+              new DeadbandFilter(m_readingDeadbandPercentOfRange, m_readingDeadbandMaxSilence)};
+            if (!m_readingDeadbandOverrideFile.empty() && !deadbandFilter->loadOverrides(m_readingDeadbandOverrideFile))
+            {
+                throw std::logic_error("Unable to load deadband override file.");
+            }
+
+            wolk->m_readingDeadbandFilter = deadbandFilter.get();
+            wolk->m_dataService->setDeadbandFilter(std::move(deadbandFilter));
+        }
+
+        if (!m_readingTransformationRuleFile.empty())
+        {
+            std::unique_ptr<ReadingTransformer> readingTransformer{new ReadingTransformer()};
+            if (!readingTransformer->loadRules(m_readingTransformationRuleFile))
+            {
+                throw std::logic_error("Unable to load reading transformation rule file.");
+            }
+
+            wolk->m_readingTransformer = readingTransformer.get();
+            wolk->m_dataService->setReadingTransformer(std::move(readingTransformer));
+        }
+
+        if (!m_windowedAggregationRuleFile.empty())
+        {
+            std::unique_ptr<WindowedAggregator> windowedAggregator{new WindowedAggregator(*wolk->m_executor)};
+            if (!windowedAggregator->loadRules(m_windowedAggregationRuleFile))
+            {
+                throw std::logic_error("Unable to load windowed aggregation rule file.");
+            }
+
+            wolk->m_windowedAggregator = windowedAggregator.get();
+            wolk->m_dataService->setWindowedAggregator(std::move(windowedAggregator));
+        }
+
+        if (m_statusPollingBuckets > 1)
+        {
+            DeviceStatusService* deviceStatusService = wolk->m_deviceStatusService.get();
+            wolk->m_dataService->setDeviceActivityListener(
+              [deviceStatusService](const std::string& deviceKey) { deviceStatusService->deviceActivity(deviceKey); });
+        }
     }
     else
     {
@@ -328,7 +1133,28 @@ std::unique_ptr<Wolk> WolkBuilder::build()
                                         *wolk->m_platformPublisher, *wolk->m_devicePublisher);
     }
 
-    wolk->m_inboundDeviceMessageHandler->addListener(wolk->m_dataService);
+    if (m_perDeviceSubscriptions && m_device.getSubdeviceManagement().value() == SubdeviceManagement::GATEWAY)
+    {
+        auto deviceMessageHandler =
+          static_cast<GatewayInboundDeviceMessageHandler*>(wolk->m_inboundDeviceMessageHandler.get());
+        deviceMessageHandler->addPerDeviceListener(wolk->m_dataService);
+
+        if (const auto deviceKeys = wolk->m_deviceRepository->findAllDeviceKeys())
+        {
+            for (const auto& deviceKey : *deviceKeys)
+            {
+                deviceMessageHandler->subscribeDevice(deviceKey);
+            }
+        }
+
+        // set once devices known at startup are subscribed, they are part of the first connection
+        deviceMessageHandler->setSubscriptionListener([gateway] { gateway->resubscribeDevices(); });
+        wolk->m_perDeviceSubscriptions = deviceMessageHandler;
+    }
+    else
+    {
+        wolk->m_inboundDeviceMessageHandler->addListener(wolk->m_dataService);
+    }
     wolk->m_inboundPlatformMessageHandler->addListener(wolk->m_dataService);
 
     // setup gateway data service if gateway template is not empty
@@ -336,7 +1162,15 @@ std::unique_ptr<Wolk> WolkBuilder::build()
     if (!gwTemplate.getSensors().empty() || !gwTemplate.getActuators().empty() || !gwTemplate.getAlarms().empty() ||
         !gwTemplate.getConfigurations().empty())
     {
-        wolk->m_gatewayPersistence.reset(new InMemoryPersistence());
+        if (!m_gatewayDataJournalFile.empty())
+        {
+            wolk->m_gatewayPersistence.reset(new JournalPersistence(m_gatewayDataJournalFile));
+        }
+        else
+        {
+            wolk->m_gatewayPersistence.reset(new InMemoryPersistence());
+        }
+
         wolk->m_gatewayDataService.reset(new GatewayDataService(
           m_device.getKey(), *wolk->m_dataProtocol, *wolk->m_gatewayPersistence, *wolk->m_dataService,
           [&](const std::string& reference, const std::string& value) {
@@ -347,25 +1181,150 @@ std::unique_ptr<Wolk> WolkBuilder::build()
           [&] { wolk->handleConfigurationGetCommand(); }));
 
         wolk->m_dataService->setGatewayMessageListener(wolk->m_gatewayDataService.get());
+
+        // items held in memory until publish would not survive restart, so they go to journal right away
+        if (!m_gatewayDataJournalFile.empty())
+        {
+            wolk->m_gatewayDataService->setPersistOnIngest(true);
+        }
+
+        if (m_gatewayDataFlushMaxItems > 0 || m_gatewayDataFlushMaxBytes > 0 || m_gatewayDataFlushMaxAge.count() > 0)
+        {
+            wolk->m_gatewayDataService->setFlushPolicy(
+              m_gatewayDataFlushMaxItems, m_gatewayDataFlushMaxBytes, m_gatewayDataFlushMaxAge,
+              wolk->m_executor.get(), [gateway] {
+                  gateway->addToCommandBuffer("flushPolicy", [gateway] {
+                      gateway->flushAlarms();
+                      gateway->flushSensorReadings();
+                  });
+              });
+        }
     }
 
     // setup file download service
     wolk->m_fileDownloadService =
       std::make_shared<FileDownloadService>(m_device.getKey(), *wolk->m_fileDownloadProtocol, m_fileDownloadDirectory,
-                                            *wolk->m_platformPublisher, *wolk->m_fileRepository, m_urlFileDownloader);
+                                            *wolk->m_platformPublisher, *wolk->m_fileRepository, *wolk->m_executor,
+                                            m_urlFileDownloader, m_filePacketRequestWindow,
+                                            wolk->m_fileTransferCheckpointRepository.get(), m_fileCacheQuota,
+                                            platformBandwidthScheduler, m_concurrentFileTransfers);
+    wolk->m_fileDownloadService->setPacketLimits(m_maxFilePacketSize, m_filePacketRequestTimeout);
     wolk->m_inboundPlatformMessageHandler->addListener(wolk->m_fileDownloadService);
 
     // setup firmware update service
     wolk->m_firmwareUpdateService = std::make_shared<FirmwareUpdateService>(
       m_device.getKey(), *wolk->m_firmwareUpdateProtocol, *wolk->m_gatewayFirmwareUpdateProtocol,
-      *wolk->m_fileRepository, *wolk->m_platformPublisher, *wolk->m_devicePublisher, m_firmwareInstaller,
-      m_firmwareVersion);
+      *wolk->m_fileRepository, *wolk->m_platformPublisher, *wolk->m_devicePublisher, *wolk->m_executor,
+      m_firmwareInstaller, m_firmwareVersion, m_maxConcurrentFirmwareInstallations, m_firmwareInstallationTimeout);
     wolk->m_inboundDeviceMessageHandler->addListener(wolk->m_firmwareUpdateService);
     wolk->m_inboundPlatformMessageHandler->addListener(wolk->m_firmwareUpdateService);
 
+    if (m_deviceStatisticsEnabled)
+    {
+        std::function<void(const std::string&)> publisher;
+        if (!m_deviceStatisticsReference.empty())
+        {
+            const auto reference = m_deviceStatisticsReference;
+            publisher = [gateway, reference](const std::string& statistics) {
+                gateway->addSensorReading(reference, statistics);
+            };
+        }
+
+        wolk->m_deviceStatisticsReporter.reset(
+          new DeviceStatisticsReporter(*wolk->m_deviceStatistics, DEVICE_STATISTICS_COUNT, m_deviceStatisticsFilePath,
+                                       std::move(publisher), m_deviceStatisticsInterval, *wolk->m_executor));
+    }
+
     return wolk;
 }
 
+std::unique_ptr<GatewayPersistence> WolkBuilder::makePlatformPersistence(const std::string& queueDirectory,
+                                                                        GatewayDataProtocol& gatewayDataProtocol) const
+{
+    std::unique_ptr<GatewayPersistence> platformPersistence;
+    if (!queueDirectory.empty())
+    {
+        platformPersistence.reset(new GatewayFilePersistence(
+          queueDirectory, GatewayFilePersistence::DEFAULT_SEGMENT_SIZE, m_outboundQueueMaximumSize));
+    }
+
+    if (m_outboundQueueMaximumMessages != 0 || m_outboundQueueMaximumBytes != 0)
+    {
+        platformPersistence.reset(new GatewayInMemoryPersistence(
+          m_outboundQueueMaximumMessages, m_outboundQueueMaximumBytes, m_outboundQueueOverflowPolicy,
+          std::move(platformPersistence), "platform_outbound_queue"));
+    }
+    else if (!platformPersistence)
+    {
+        platformPersistence.reset(
+          new GatewayRingBufferPersistence(GatewayRingBufferPersistence::DEFAULT_CAPACITY, "platform_outbound_queue"));
+    }
+
+    if (m_compressedReadingsEnabled)
+    {
+        GatewayDataProtocol* dataProtocol = &gatewayDataProtocol;
+        platformPersistence.reset(new CompressedReadingPersistence(
+          std::move(platformPersistence),
+          [dataProtocol](const Message& message) { return dataProtocol->isSensorReadingMessage(message); },
+          m_compressedReadingsMaximumBytes, m_compressedReadingsPerMessage, "platform_compressed_readings"));
+    }
+
+    if (m_outboundPriorityLanesEnabled)
+    {
+        enum Lane : std::size_t
+        {
+            CONTROL,
+            ALARMS,
+            ACTUATOR_STATUS,
+            READINGS
+        };
+
+        GatewayDataProtocol* dataProtocol = &gatewayDataProtocol;
+        std::unique_ptr<PriorityLanePersistence> lanes{
+          new PriorityLanePersistence([dataProtocol](const Message& message) -> std::size_t {
+              if (dataProtocol->isSensorReadingMessage(message))
+              {
+                  return READINGS;
+              }
+
+              if (dataProtocol->isAlarmMessage(message))
+              {
+                  return ALARMS;
+              }
+
+              if (dataProtocol->isActuatorStatusMessage(message) ||
+                  dataProtocol->isConfigurationCurrentMessage(message))
+              {
+                  return ACTUATOR_STATUS;
+              }
+
+              return CONTROL;
+          })};
+
+        lanes->addLane(std::unique_ptr<GatewayPersistence>(new GatewayInMemoryPersistence()), 8,
+                       m_outboundPriorityLaneLimit);
+        lanes->addLane(std::unique_ptr<GatewayPersistence>(new GatewayInMemoryPersistence()), 4,
+                       m_outboundPriorityLaneLimit);
+        lanes->addLane(std::unique_ptr<GatewayPersistence>(new GatewayInMemoryPersistence()), 2,
+                       m_outboundPriorityLaneLimit);
+        lanes->addLane(std::move(platformPersistence), 1);
+
+        platformPersistence = std::move(lanes);
+    }
+
+    if (m_storeAndForwardEnabled)
+    {
+        GatewayDataProtocol* dataProtocol = &gatewayDataProtocol;
+        platformPersistence.reset(new StoreAndForwardPersistence(
+          std::move(platformPersistence), m_storeAndForwardLiveCapacity, m_storeAndForwardLiveWeight,
+          m_deduplicationWindow,
+          [dataProtocol](const Message& message) { return dataProtocol->isSensorReadingMessage(message); },
+          "platform_store_and_forward"));
+    }
+
+    return platformPersistence;
+}
+
 wolkabout::WolkBuilder::operator std::unique_ptr<Wolk>()
 {
     return build();
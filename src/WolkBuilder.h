@@ -24,8 +24,15 @@
 #include "FirmwareInstaller.h"
 #include "connectivity/ConnectivityService.h"
 #include "model/GatewayDevice.h"
+#include "model/PerformanceProfile.h"
+#include "persistence/filesystem/GatewayFilePersistence.h"
+#include "persistence/inmemory/GatewayInMemoryPersistence.h"
 #include "service/UrlFileDownloader.h"
+#include "utilities/DeviceStatistics.h"
+#include "utilities/ReconnectScheduler.h"
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -33,6 +40,9 @@
 
 namespace wolkabout
 {
+class Executor;
+class GatewayDataProtocol;
+class GatewayPersistence;
 class Wolk;
 
 class WolkBuilder final
@@ -140,6 +150,17 @@ public:
      */
     WolkBuilder& withUrlFileDownload(std::shared_ptr<UrlFileDownloader> urlDownloader);
 
+    /**
+     * @brief maxConcurrentFirmwareInstallations Limits number of subdevices installing firmware at the same time
+     * Remaining devices are queued until installation on one of the devices finishes, by default there is no limit
+     * @param count Number of devices, 0 for no limit
+     * @param timeout Time after which device that has not finished installation is reported as failed,
+     * freeing its slot for next device. 0 waits indefinitely
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& maxConcurrentFirmwareInstallations(std::size_t count,
+                                                    std::chrono::milliseconds timeout = std::chrono::milliseconds{0});
+
     /**
      * @brief fileDownloadDirectory specifies directory where to download files
      * By default files are stored in the working directory of gateway
@@ -148,6 +169,525 @@ public:
      */
     WolkBuilder& fileDownloadDirectory(const std::string& path);
 
+    /**
+     * @brief storageDirectory specifies directory where device database and existing devices journal are kept
+     * By default they are stored in the working directory of gateway. Gateways running in the same process
+     * must each use their own directory, as repositories hold devices of a single gateway
+     * @param path Path to directory where repositories will be stored
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& storageDirectory(const std::string& path);
+
+    /**
+     * @brief withMetricsFile Enables periodic export of gateway metrics in Prometheus text format
+     * File is replaced atomically on every export, so it can be collected by node_exporter textfile collector
+     * @param path Path of the metrics file
+     * @param interval Interval between exports
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withMetricsFile(const std::string& path,
+                                 std::chrono::milliseconds interval = std::chrono::milliseconds{10000});
+
+    /**
+     * @brief executor Runs background and delayed work of gateway on given executor instead of its own
+     * Allows several gateways in one process to share worker threads, see wolkabout::GatewayHost.
+     * Executor must outlive built wolkabout::Wolk instance
+     * @param executor Executor shared with other gateways
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& executor(std::shared_ptr<Executor> executor);
+
+    /**
+     * @brief withDeviceStatistics Tracks message and byte rates, rejected messages, last seen time and forwarding
+     * latency of the busiest subdevices, and periodically reports top talkers and slowest devices
+     * Statistics are written as JSON to a file replaced atomically on every report, and are available through
+     * wolkabout::Wolk::getDeviceStatistics. Statistics are approximate, see wolkabout::DeviceStatistics
+     * @param path Path of the statistics file, empty for none
+     * @param interval Interval between reports
+     * @param reference Reference of gateway sensor under which statistics are published to platform, empty for none
+     * @param trackedDevices Maximum number of devices tracked
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withDeviceStatistics(const std::string& path,
+                                      std::chrono::milliseconds interval = std::chrono::milliseconds{10000},
+                                      const std::string& reference = "",
+                                      std::size_t trackedDevices = DeviceStatistics::DEFAULT_CAPACITY);
+
+    /**
+     * @brief filePacketRequestWindow Sets number of file packets requested from platform ahead of received ones
+     * Larger window hides round trip time on slow links, by default next packet is requested once previous arrives
+     * @param window Number of packet requests in flight
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& filePacketRequestWindow(unsigned window);
+
+    /**
+     * @brief concurrentFileTransfers Sets number of files downloaded from platform at the same time
+     * Packet requests of concurrent transfers take turns, further downloads wait until a transfer finishes
+     * @param transfers Number of concurrent transfers, by default files are downloaded one at a time
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& concurrentFileTransfers(std::size_t transfers);
+
+    /**
+     * @brief fileCacheQuota Limits disk space taken by downloaded files
+     * Least recently used files are deleted once quota is exceeded, by default files are kept until deleted by platform
+     * @param bytes Maximum size of all downloaded files, 0 for no limit
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& fileCacheQuota(std::uint64_t bytes);
+
+    /**
+     * @brief fileTransferBandwidth Limits file transfers to part of platform link left over by other messages
+     * File packets are requested only as fast as bandwidth allows, so telemetry latency does not suffer during
+     * transfers. By default file packets are requested as soon as previous ones arrive
+     * @param linkBytesPerSecond Bandwidth of platform link
+     * @param maximumShare Maximum part of bandwidth taken by file transfers, greater than 0 and at most 1
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& fileTransferBandwidth(std::uint64_t linkBytesPerSecond, double maximumShare = 0.5);
+
+    /**
+     * @brief withPersistentOutboundQueue Stores messages for platform on disk until they are published
+     * Messages survive platform outages and gateway restarts, by default they are kept in a bounded ring in memory
+     * @param directory Directory where queue segments are stored
+     * @param maximumSize Maximum number of bytes queue may occupy on disk
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withPersistentOutboundQueue(
+      const std::string& directory, std::uint64_t maximumSize = GatewayFilePersistence::DEFAULT_MAXIMUM_SIZE);
+
+    /**
+     * @brief publishBatchSize Sets maximum number of queued messages taken for publishing at once
+     * Larger batches reduce locking of outbound queues while large backlog is published after reconnect
+     * @param size Number of messages in batch
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& publishBatchSize(std::size_t size);
+
+    /**
+     * @brief withPersistentGatewayData Stores sensor readings, alarms, actuator statuses and configuration
+     * of the gateway itself in journal file until they are published, by default they are kept in memory
+     * Readings and alarms are written to journal as they are added, rather than when they are published
+     * @param file Path of journal file
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withPersistentGatewayData(const std::string& file);
+
+    /**
+     * @brief autoFlushGatewayData Publishes sensor readings and alarms of the gateway itself without waiting
+     * for wolkabout::Wolk::publish once any of the limits is reached
+     * @param maxItems Number of readings and alarms added since last publish, 0 for no limit
+     * @param maxBytes Approximate size of readings and alarms added since last publish, 0 for no limit
+     * @param maxAge Time after first reading or alarm is added, 0 for no limit
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& autoFlushGatewayData(std::size_t maxItems, std::size_t maxBytes = 0,
+                                      std::chrono::milliseconds maxAge = std::chrono::milliseconds{0});
+
+    /**
+     * @brief limitOutboundQueue Bounds in memory queue of messages for platform
+     * With OverflowPolicy::SPILL overflow goes to queue set with withPersistentOutboundQueue, which is then required.
+     * With other policies persistent queue only drains messages left from previous runs
+     * @param maximumMessages Maximum number of queued messages, 0 for no limit
+     * @param maximumBytes Maximum size of queued channels and payloads, 0 for no limit
+     * @param policy What happens with messages which do not fit
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& limitOutboundQueue(std::size_t maximumMessages, std::uint64_t maximumBytes,
+                                    GatewayInMemoryPersistence::OverflowPolicy policy);
+
+    /**
+     * @brief prioritizeOutboundMessages Splits messages for platform into lanes drained by weighted round robin
+     * Status and other control messages, alarms, actuator statuses and sensor readings get a lane each,
+     * so a backlog of readings does not delay more important messages.
+     * Readings are kept in outbound queue, other lanes are kept in memory
+     * @param laneLimit Maximum number of messages in each in memory lane, 0 for no limit
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& prioritizeOutboundMessages(std::size_t laneLimit = PRIORITY_LANE_LIMIT);
+
+    /**
+     * @brief storeAndForward Publishes fresh messages for platform ahead of backlog replayed after an outage
+     * Newest liveCapacity messages are published first, older ones wait in outbound queue and are replayed
+     * in order in which they were added, one for every liveWeight fresh messages.
+     * Sensor readings carrying time and equal to one added within deduplication window are dropped
+     * @param liveCapacity Number of newest messages published ahead of backlog
+     * @param liveWeight Number of fresh messages published for each backlog message
+     * @param deduplicationWindow Time for which duplicate readings are dropped, 0 disables deduplication
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& storeAndForward(std::size_t liveCapacity = 1000, std::size_t liveWeight = 4,
+                                 std::chrono::milliseconds deduplicationWindow = std::chrono::seconds{10});
+
+    /**
+     * @brief compressBufferedReadings Keeps numeric sensor readings for platform compressed per device reference
+     * Timestamps and values are compressed as in Gorilla, taking a few bytes per reading instead of a message each,
+     * and are replayed as messages carrying up to readingsPerMessage readings. Other messages and readings
+     * over the limit are kept in outbound queue, and are published first. Compressed readings are kept in memory
+     * @param maximumBytes Maximum size of compressed readings, 0 for no limit
+     * @param readingsPerMessage Maximum number of readings in a replayed message
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& compressBufferedReadings(std::size_t maximumBytes = 16 * 1024 * 1024,
+                                          std::size_t readingsPerMessage = 100);
+
+    /**
+     * @brief compressPlatformPayloads Deflates payloads of messages for platform whose size reaches threshold
+     * Payloads are compressed with Deflate::READING_DICTIONARY, platform must be able to inflate them
+     * @param threshold Minimum payload size in bytes
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& compressPlatformPayloads(std::size_t threshold = 512);
+
+    /**
+     * @brief publishReadingsAtMostOnce Drops sensor readings for platform whose publish fails instead of retrying them
+     * Delivery class of each message is selected by data protocol, so only periodic readings a later one supersedes
+     * are given up, while control messages, alarms and statuses are retried until published.
+     * Readings are still queued while platform is disconnected
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& publishReadingsAtMostOnce();
+
+    /**
+     * @brief inboundDeviceMessageWorkers Sets number of threads handling messages received from devices
+     * Messages are distributed by device key, so messages of one device keep their order
+     * @param workers Number of threads, 1 handles all messages on a single thread
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& inboundDeviceMessageWorkers(std::size_t workers);
+
+    /**
+     * @brief platformReconnectBackoff Sets backoff of reconnecting to platform
+     * Connection lost before it stayed up for stable period is not reconnected right away, backoff continues instead,
+     * so a flapping link does not cost a TLS handshake every time it comes up
+     * @param initialDelay Delay after first failed attempt
+     * @param maximumDelay Upper bound of delay between attempts
+     * @param stablePeriod Time connection must stay up for backoff to be reset, 0 always reconnects right away
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& platformReconnectBackoff(
+      std::chrono::milliseconds initialDelay, std::chrono::milliseconds maximumDelay,
+      std::chrono::milliseconds stablePeriod = ReconnectScheduler::DEFAULT_STABLE_PERIOD);
+
+    /**
+     * @brief platformConnections Publishes messages for platform over several connections
+     * Messages are partitioned by device key, each connection has its own publishing worker and outbound queue,
+     * so messages of a device stay in order and a connection that is backing off does not stall the others.
+     * Gateway messages and subscriptions stay on the first connection. Additional connections use
+     * "<key>-uplink-<index>" client ids, which platform must accept. With persistent outbound queue,
+     * queues of additional connections are kept in "uplink<index>" subdirectories
+     * @param connections Number of connections, 1 publishes over single connection
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& platformConnections(std::size_t connections);
+
+    /**
+     * @brief localBrokerConnections Receives device messages over several local broker connections
+     * Connections use MQTT shared subscriptions, so broker must support them ("$share/<group>/<filter>").
+     * Connections deliver in parallel into dispatch threads set by inboundDeviceMessageWorkers.
+     * Broker may deliver messages of one device over different connections, so their order is not guaranteed
+     * @param connections Number of connections, 1 uses plain subscriptions
+     * @param shareGroup Name of shared subscription group
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& localBrokerConnections(std::size_t connections, const std::string& shareGroup = "wolkgateway");
+
+    /**
+     * @brief subscribePerDevice Subscribes to data channels of registered subdevices instead of wildcard channels
+     * Broker then drops data messages of unregistered devices before they reach the gateway.
+     * Connectivity service subscribes only when it connects, so local broker connection is reestablished
+     * whenever subdevices are registered or deleted, once for a burst of changes.
+     * Has no effect unless subdevices are managed by gateway
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& subscribePerDevice();
+
+    /**
+     * @brief embeddedBroker Runs MQTT broker for subdevices inside gateway instead of connecting to external one
+     * Device messages are handed to gateway by function call, without loopback connection and second parsing.
+     * Broker supports QoS 0, 1 and 2 from devices and last will, delivers to devices with QoS 0,
+     * does not retain messages and does not authenticate clients. Overrides gatewayHost and localBrokerConnections
+     * @param address IPv4 address to listen on
+     * @param port Port to listen on
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& embeddedBroker(const std::string& address = "127.0.0.1", std::uint16_t port = 1883);
+
+    /**
+     * @brief localSocket Accepts device messages from adapters on the same host over Unix socket
+     * Adapters write length prefixed frames (see wolkabout::LocalSocketConnectivityService) which reach
+     * gateway without MQTT encoding. Local broker connection is kept alongside the socket
+     * @param path Path of socket file, readable and writable by owner and group
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& localSocket(const std::string& path);
+
+    /**
+     * @brief shard Runs gateway as one of several worker processes, each handling subdevices of one shard
+     * Subdevices are assigned to shards by hash of their key (see wolkabout::DeviceShard). Every worker connects
+     * to platform with the gateway key, workers other than primary under "<key>-shard-<index>" client id, which
+     * platform must accept, and receives only platform messages of its subdevices. Primary worker, index 0,
+     * handles the gateway itself: it updates gateway, keeps connection alive and carries last will.
+     * When routed, local broker messages are received from wolkabout::ShardRouter, otherwise every worker
+     * subscribes to all device channels and drops messages of other shards.
+     * Each worker should use its own storage directory
+     * @param index Index of this worker, lower than count
+     * @param count Number of workers
+     * @param routed Whether local broker messages are republished by wolkabout::ShardRouter
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& shard(std::size_t index, std::size_t count, bool routed = true);
+
+    /**
+     * @brief subdeviceRateLimit Limits messages accepted from each subdevice with a token bucket per device
+     * Messages over the limit are dropped before they are queued, so a flooding device does not delay others.
+     * Device that keeps exceeding the limit is quarantined, dropped messages are counted per device in metrics
+     * @param messagesPerSecond Average number of messages accepted from a device
+     * @param burst Number of messages a device may send at once
+     * @param quarantineAfter Time for which device may keep exceeding the limit before it is quarantined
+     * @param quarantineDuration Time for which all messages of quarantined device are dropped, 0 disables quarantine
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& subdeviceRateLimit(double messagesPerSecond, std::size_t burst = 100,
+                                    std::chrono::milliseconds quarantineAfter = std::chrono::seconds{10},
+                                    std::chrono::milliseconds quarantineDuration = std::chrono::seconds{60});
+
+    /**
+     * @brief subdeviceQuarantineAlarm Keeps gateway alarm active while at least one subdevice is quarantined
+     * Alarm is published along with other gateway alarms, requires subdeviceRateLimit
+     * @param alarmReference Reference of alarm in gateway template
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& subdeviceQuarantineAlarm(const std::string& alarmReference);
+
+    /**
+     * @brief subdeviceQuarantineHandler Sets handler called when subdevice enters or leaves quarantine
+     * Handler is called on thread receiving device messages and must not block, requires subdeviceRateLimit
+     * @param handler Called with device key and true when device is quarantined, false when it is released
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& subdeviceQuarantineHandler(std::function<void(const std::string&, bool)> handler);
+
+    /**
+     * @brief platformBackpressure Slows down and sheds subdevice messages while platform queue is backed up
+     * Once highWatermark messages are queued for platform, subdevice sensor readings wait up to consumerDelay
+     * for queue to drain to lowWatermark, which slows consumption from local broker, and are dropped if it does not.
+     * Alarms, registrations, statuses and actuator statuses are always accepted
+     * @param highWatermark Number of queued platform messages at which backpressure is applied
+     * @param lowWatermark Number of queued platform messages at which backpressure is released
+     * @param consumerDelay Maximum time sensor reading waits for backpressure to be released
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& platformBackpressure(std::size_t highWatermark, std::size_t lowWatermark,
+                                      std::chrono::milliseconds consumerDelay = std::chrono::milliseconds{100});
+
+    /**
+     * @brief databaseWriteAheadLogging Switches device database to WAL journal mode with synchronous=NORMAL
+     * Reduces number of disk syncs per write, last transactions may be lost on power failure
+     * @param enabled true to enable WAL journal mode
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& databaseWriteAheadLogging(bool enabled);
+
+    /**
+     * @brief databaseReaderSessions Opens read-only device database sessions serving lookups in parallel
+     * Lookups of several services no longer wait for each other or for writes, requires WAL journal mode
+     * @param sessions Number of read-only sessions, 0 serializes lookups with writes on single session
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& databaseReaderSessions(std::size_t sessions);
+
+    /**
+     * @brief databaseWriteBehind Queues device and file database writes and commits them in batches on a writer thread
+     * Registration and file transfers no longer wait for disk syncs, queued writes are lost on power failure
+     * @param commitDelay Time writes are collected for before they are committed, 0 disables write-behind
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& databaseWriteBehind(std::chrono::milliseconds commitDelay);
+
+    /**
+     * @brief routingSnapshot Keeps subdevice keys and template references in snapshot file written on clean shutdown
+     * On start devices are loaded from snapshot instead of device database, which is read only when snapshot
+     * is missing, or stale because gateway changed devices without writing it or database file was replaced
+     * @param snapshotFile Path of snapshot file, empty disables snapshot
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& routingSnapshot(const std::string& snapshotFile);
+
+    /**
+     * @brief aggregateSensorReadings Coalesces sensor readings of each subdevice into multi-reading messages
+     * Reduces number of publishes on metered uplinks, alarms are still published immediately
+     * @param window Time for which readings of a subdevice are collected, 0 for no limit
+     * @param maxReadings Number of readings of a subdevice at which they are published, 0 for no limit
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& aggregateSensorReadings(std::chrono::milliseconds window, std::size_t maxReadings = 0);
+
+    /**
+     * @brief coalesceActuations Limits rate of actuator set commands forwarded to each subdevice actuator
+     * Commands arriving faster, as from a slider, replace each other and only the latest one is forwarded
+     * @param interval Minimum time between commands forwarded to the same actuator
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& coalesceActuations(std::chrono::milliseconds interval);
+
+    /**
+     * @brief coalesceConfigurations Merges configuration set requests for each subdevice and paces their delivery
+     * Bulk configuration pushes reach each subdevice as one request, without bursts on the local broker
+     * @param window Time for which later requests for a subdevice are merged into the first one
+     * @param pacing Minimum time between configuration set requests forwarded to subdevices
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& coalesceConfigurations(std::chrono::milliseconds window,
+                                        std::chrono::milliseconds pacing = std::chrono::milliseconds{0});
+
+    /**
+     * @brief cacheDeviceState Answers actuator status and configuration requests for subdevices from last received
+     * Statuses are resent on platform reconnect without querying subdevices, only stale actuators are queried
+     * @param maxAge Time for which received actuator status or configuration is considered current
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& cacheDeviceState(std::chrono::milliseconds maxAge);
+
+    /**
+     * @brief bulkActuatorStatusRequests Requests all actuator statuses of a subdevice with a single request
+     * Subdevices must reply with a batch of statuses on actuator status channel without reference,
+     * as in [{"reference":"SW","status":"READY","value":"true"}]
+     * @param enabled true if subdevices support batched actuator statuses
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& bulkActuatorStatusRequests(bool enabled = true);
+
+    /**
+     * @brief withReadingDeadband Drops subdevice sensor readings which did not change enough since last forwarded one
+     * Band is percentage of sensor range from device template, or is taken from override file
+     * @param percentOfRange Band as percentage of sensor range, 0 to use only bands from override file
+     * @param maxSilence Time after which unchanged reading is forwarded anyway, 0 for no limit
+     * @param overrideFile Path of file with bands per device and reference, empty for none
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withReadingDeadband(double percentOfRange,
+                                     std::chrono::milliseconds maxSilence = std::chrono::milliseconds{60000},
+                                     const std::string& overrideFile = "");
+
+    /**
+     * @brief withReadingTransformation Rescales, renames or drops subdevice sensor readings before they reach platform
+     * Rules are given per device and reference, as in "* T unit=F:C round=1 rename=TEMP"
+     * @param ruleFile Path of file with transformation rules
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withReadingTransformation(const std::string& ruleFile);
+
+    /**
+     * @brief withWindowedAggregation Publishes statistics of subdevice sensor readings over time window instead of them
+     * Rules are given per device and reference, as in "* VIB 1000 min=VIB_MIN max=VIB_MAX avg=VIB rms=VIB_RMS"
+     * @param ruleFile Path of file with aggregation rules
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& withWindowedAggregation(const std::string& ruleFile);
+
+    /**
+     * @brief staggerStatusPolling Spreads subdevice status requests over status request interval
+     * Subdevices which are connected and sent data within the interval are not polled
+     * @param buckets Number of slots interval is divided into, each polling subset of subdevices
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& staggerStatusPolling(std::size_t buckets);
+
+    /**
+     * @brief coalesceStatusUpdates Collects subdevice status updates for window and publishes only final ones
+     * @param window Time for which status updates are collected
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& coalesceStatusUpdates(std::chrono::milliseconds window);
+
+    /**
+     * @brief adaptiveKeepAlive Skips keep alive pings while messages are being published to platform
+     * and reconnects if pong does not arrive in time. Ping round trip time is reported as metric
+     * @param pongTimeout Time within which pong is expected after ping
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& adaptiveKeepAlive(std::chrono::milliseconds pongTimeout = std::chrono::milliseconds{10000});
+
+    /**
+     * @brief keepAliveInterval Sets interval of keep alive pings and of subdevice status polling
+     * @param interval Interval between pings
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& keepAliveInterval(std::chrono::seconds interval);
+
+    /**
+     * @brief statusResponseTimeout Sets time within which polled subdevice must report its status
+     * Subdevices which do not respond in time are reported offline
+     * @param timeout Status response timeout
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& statusResponseTimeout(std::chrono::seconds timeout);
+
+    /**
+     * @brief registrationRetry Sets how subdevice registration and deletion requests are resent to platform
+     * @param count Number of times request is resent when platform does not respond
+     * @param timeout Time to wait for response before request is resent
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& registrationRetry(short count, std::chrono::milliseconds timeout);
+
+    /**
+     * @brief filePacketLimits Sets size of file packets requested from platform and time to wait for each of them
+     * @param maxPacketSize Maximum size of single packet in bytes
+     * @param packetRequestTimeout Time after which packet which did not arrive is requested again
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& filePacketLimits(std::uint64_t maxPacketSize, std::chrono::milliseconds packetRequestTimeout);
+
+    /**
+     * @brief performanceProfile Applies queue caps, worker counts, batch sizes, windows and timeouts of profile
+     * Settings of profile replace ones set earlier, and are replaced by ones set later
+     * @param profile Profile to apply, e.g. wolkabout::PerformanceProfile::constrainedEdge()
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& performanceProfile(const PerformanceProfile& profile);
+
+    /**
+     * @brief memoryBudget Sets how many bytes all gateway queues and buffers together may hold
+     * Once budget is reached queues apply their overflow policy, and files are no longer kept in memory
+     * Budget is shared by all gateways in process, building a gateway that does not set it keeps the current one
+     * @param bytes Budget in bytes, 0 for no limit
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& memoryBudget(std::uint64_t bytes);
+
+    /**
+     * @brief traceSampling Enables trace spans of sampled messages across routing stages
+     * Spans are kept in memory and written to file by wolkabout::Tracer::dump
+     * Tracer is shared by all gateways in process, building a gateway that does not set it keeps the current sampling
+     * @param sampleOneIn Trace one in this many received messages, 0 disables tracing
+     * @param capacity Number of most recent spans kept
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& traceSampling(std::uint32_t sampleOneIn, std::size_t capacity);
+
+    /**
+     * @brief commandWatchdog Reports commands that are queued or running in a command buffer for too long
+     * Stalled commands are logged and counted in wolkgateway_command_buffer_<buffer>_stalls_total, latency and
+     * running time of all commands are recorded as histograms
+     * @param threshold Time after which a command is reported as stalled
+     * @param dumpOrigins Whether origin of stalled command (message channel or function that queued it) is logged
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& commandWatchdog(std::chrono::milliseconds threshold = std::chrono::seconds{1},
+                                 bool dumpOrigins = true);
+
+    /**
+     * @brief captureTraffic Records every message received from platform and local broker to a capture file
+     * Capture keeps channel, payload and arrival time of messages, and is fed back through the gateway
+     * by WolkGatewayReplay to reproduce load offline
+     * @param path Capture file, overwritten if it exists
+     * @return Reference to current wolkabout::WolkBuilder instance (Provides fluent interface)
+     */
+    WolkBuilder& captureTraffic(const std::string& path);
+
     /**
      * @brief Builds Wolk instance
      * @return Wolk instance as std::unique_ptr<Wolk>
@@ -155,6 +695,10 @@ public:
      * @throws std::logic_error if device key is not present in wolkabout::Device
      * @throws std::logic_error if actuator status provider is not set, and wolkabout::Device has actuator references
      * @throws std::logic_error if actuation handler is not set, and wolkabout::Device has actuator references
+     * @throws std::logic_error if deadband override file can not be loaded
+     * @throws std::logic_error if reading transformation rule file can not be loaded
+     * @throws std::logic_error if windowed aggregation rule file can not be loaded
+     * @throws std::logic_error if traffic capture file can not be created
      */
     std::unique_ptr<Wolk> build();
 
@@ -165,6 +709,9 @@ public:
     operator std::unique_ptr<Wolk>();
 
 private:
+    std::unique_ptr<GatewayPersistence> makePlatformPersistence(const std::string& queueDirectory,
+                                                                GatewayDataProtocol& gatewayDataProtocol) const;
+
     std::string m_platformHost;
     std::string m_platformTrustStore = TRUST_STORE;
     std::string m_gatewayHost;
@@ -183,19 +730,147 @@ private:
     std::shared_ptr<ConfigurationProvider> m_configurationProvider;
 
     std::string m_fileDownloadDirectory = ".";
+    std::string m_storageDirectory;
+    unsigned m_filePacketRequestWindow = 1;
+    std::size_t m_concurrentFileTransfers = 1;
+    std::uint64_t m_fileCacheQuota = 0;
+    std::uint64_t m_linkBandwidth = 0;
+    double m_fileTransferBandwidthShare = 0.5;
 
     std::string m_firmwareVersion;
     std::shared_ptr<FirmwareInstaller> m_firmwareInstaller;
+    std::size_t m_maxConcurrentFirmwareInstallations = 0;
+    std::chrono::milliseconds m_firmwareInstallationTimeout{0};
 
     std::shared_ptr<UrlFileDownloader> m_urlFileDownloader;
 
+    std::size_t m_publishBatchSize = PUBLISH_BATCH_SIZE;
+
+    bool m_outboundPriorityLanesEnabled = false;
+    std::size_t m_outboundPriorityLaneLimit = PRIORITY_LANE_LIMIT;
+
+    bool m_storeAndForwardEnabled = false;
+    std::size_t m_storeAndForwardLiveCapacity = 0;
+    std::size_t m_storeAndForwardLiveWeight = 0;
+    std::chrono::milliseconds m_deduplicationWindow{0};
+
+    bool m_compressedReadingsEnabled = false;
+    std::size_t m_compressedReadingsMaximumBytes = 0;
+    std::size_t m_compressedReadingsPerMessage = 0;
+
+    std::size_t m_compressionThreshold = 0;
+
+    bool m_readingsAtMostOnce = false;
+
+    std::size_t m_inboundDeviceMessageWorkers = 1;
+
+    std::chrono::milliseconds m_platformReconnectInitialDelay = ReconnectScheduler::DEFAULT_INITIAL_DELAY;
+    std::chrono::milliseconds m_platformReconnectMaximumDelay = ReconnectScheduler::DEFAULT_MAXIMUM_DELAY;
+    std::chrono::milliseconds m_platformReconnectStablePeriod = ReconnectScheduler::DEFAULT_STABLE_PERIOD;
+
+    std::size_t m_platformConnections = 1;
+    std::size_t m_localBrokerConnections = 1;
+    std::string m_localBrokerShareGroup;
+    bool m_perDeviceSubscriptions = false;
+    std::string m_embeddedBrokerAddress;
+    std::uint16_t m_embeddedBrokerPort = 1883;
+    std::string m_localSocketPath;
+
+    std::size_t m_shardIndex = 0;
+    std::size_t m_shardCount = 1;
+    bool m_shardRouted = false;
+
+    double m_subdeviceMessagesPerSecond = 0;
+    std::size_t m_subdeviceMessageBurst = 0;
+    std::chrono::milliseconds m_subdeviceQuarantineAfter{0};
+    std::chrono::milliseconds m_subdeviceQuarantineDuration{0};
+    std::string m_subdeviceQuarantineAlarmReference;
+    std::function<void(const std::string&, bool)> m_subdeviceQuarantineHandler;
+
+    std::size_t m_backpressureHighWatermark = 0;
+    std::size_t m_backpressureLowWatermark = 0;
+    std::chrono::milliseconds m_backpressureConsumerDelay{0};
+
+    std::string m_metricsFilePath;
+    std::chrono::milliseconds m_metricsExportInterval{10000};
+
+    std::shared_ptr<Executor> m_executor;
+
+    bool m_deviceStatisticsEnabled = false;
+    std::string m_deviceStatisticsFilePath;
+    std::chrono::milliseconds m_deviceStatisticsInterval{10000};
+    std::string m_deviceStatisticsReference;
+    std::size_t m_deviceStatisticsCapacity = DeviceStatistics::DEFAULT_CAPACITY;
+
+    bool m_databaseWriteAheadLogging = false;
+    std::size_t m_databaseReaderSessions = 0;
+    std::chrono::milliseconds m_databaseWriteBehindDelay{0};
+    std::string m_routingSnapshotFile;
+
+    std::chrono::milliseconds m_readingAggregationWindow{0};
+    std::size_t m_readingAggregationMaxReadings = 0;
+
+    std::chrono::milliseconds m_actuationCoalescingInterval{0};
+    std::chrono::milliseconds m_configurationCoalescingWindow{0};
+    std::chrono::milliseconds m_configurationPacing{0};
+    std::chrono::milliseconds m_deviceStateMaxAge{0};
+    bool m_bulkActuatorStatusRequests = false;
+
+    std::string m_gatewayDataJournalFile;
+    std::size_t m_gatewayDataFlushMaxItems = 0;
+    std::size_t m_gatewayDataFlushMaxBytes = 0;
+    std::chrono::milliseconds m_gatewayDataFlushMaxAge{0};
+
+    bool m_readingDeadbandEnabled = false;
+    double m_readingDeadbandPercentOfRange = 0;
+    std::chrono::milliseconds m_readingDeadbandMaxSilence{60000};
+    std::string m_readingDeadbandOverrideFile;
+
+    std::string m_readingTransformationRuleFile;
+    std::string m_windowedAggregationRuleFile;
+
+    std::size_t m_statusPollingBuckets = 1;
+    std::chrono::milliseconds m_statusUpdateCoalescingWindow{0};
+
+    std::string m_outboundQueueDirectory;
+    std::uint64_t m_outboundQueueMaximumSize = GatewayFilePersistence::DEFAULT_MAXIMUM_SIZE;
+
+    std::size_t m_outboundQueueMaximumMessages = 0;
+    std::uint64_t m_outboundQueueMaximumBytes = 0;
+    GatewayInMemoryPersistence::OverflowPolicy m_outboundQueueOverflowPolicy =
+      GatewayInMemoryPersistence::OverflowPolicy::DROP_NEWEST;
+
     // json protocol does not currently support ping messages
     bool m_keepAliveEnabled = false;
+    bool m_adaptiveKeepAliveEnabled = false;
+    std::chrono::milliseconds m_keepAlivePongTimeout{10000};
+    std::chrono::seconds m_keepAliveInterval{600};
+
+    std::chrono::seconds m_statusResponseTimeout{5};
+    short m_registrationRetryCount = 3;
+    std::chrono::milliseconds m_registrationRetryTimeout{5000};
+
+    std::uint64_t m_maxFilePacketSize = 10 * 1024 * 1024;
+    std::chrono::milliseconds m_filePacketRequestTimeout{6000};
+
+    std::uint64_t m_memoryBudget = 0;
+    bool m_memoryBudgetSet = false;
+
+    std::uint32_t m_traceSampleOneIn = 0;
+    std::size_t m_traceCapacity = 10000;
+    bool m_traceSamplingSet = false;
+
+    std::chrono::milliseconds m_commandWatchdogThreshold{0};
+    bool m_commandWatchdogDumpOrigins = true;
+
+    std::string m_trafficCapturePath;
 
     static const constexpr char* WOLK_DEMO_HOST = "ssl://api-demo.wolkabout.com:8883";
     static const constexpr char* MESSAGE_BUS_HOST = "tcp://localhost:1883";
     static const constexpr char* TRUST_STORE = "ca.crt";
     static const constexpr char* DATABASE = "deviceRepository.db";
+    static const constexpr std::size_t PUBLISH_BATCH_SIZE = 16;
+    static const constexpr std::size_t PRIORITY_LANE_LIMIT = 10000;
 };
 }    // namespace wolkabout
 
@@ -0,0 +1,951 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "connectivity/EmbeddedBrokerConnectivityService.h"
+#include "model/Message.h"
+#include "utilities/GatewayLog.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+const std::uint8_t CONNECT = 1;
+const std::uint8_t PUBLISH = 3;
+const std::uint8_t PUBACK = 4;
+const std::uint8_t PUBREC = 5;
+const std::uint8_t PUBREL = 6;
+const std::uint8_t PUBCOMP = 7;
+const std::uint8_t SUBSCRIBE = 8;
+const std::uint8_t UNSUBSCRIBE = 10;
+const std::uint8_t PINGREQ = 12;
+const std::uint8_t DISCONNECT = 14;
+
+const std::uint8_t CONNACK_ACCEPTED = 0;
+const std::uint8_t CONNACK_UNACCEPTABLE_PROTOCOL = 1;
+const std::uint8_t CONNACK_IDENTIFIER_REJECTED = 2;
+const std::uint8_t SUBACK_FAILURE = 0x80;
+
+const std::chrono::seconds CONNECT_TIMEOUT{10};
+const int POLL_INTERVAL_MS = 1000;
+const std::size_t RECEIVE_BUFFER_SIZE = 4096;
+
+// fixed header of MQTT packet is type byte followed by up to four bytes of remaining length
+const std::size_t MAXIMUM_FIXED_HEADER_SIZE = 5;
+
+std::string encodeLength(std::size_t length)
+{
+    std::string encoded;
+    do
+    {
+        auto digit = static_cast<std::uint8_t>(length % 128);
+        length /= 128;
+        if (length > 0)
+        {
+            digit = static_cast<std::uint8_t>(digit | 0x80);
+        }
+        encoded.push_back(static_cast<char>(digit));
+    } while (length > 0);
+
+    return encoded;
+}
+
+std::string encodeUint16(std::uint16_t value)
+{
+    return std::string{static_cast<char>(value >> 8), static_cast<char>(value & 0xFF)};
+}
+
+std::string encodeString(const std::string& value)
+{
+    return encodeUint16(static_cast<std::uint16_t>(value.size())) + value;
+}
+
+std::string packet(std::uint8_t header, const std::string& body)
+{
+    return static_cast<char>(header) + encodeLength(body.size()) + body;
+}
+
+std::string acknowledgement(std::uint8_t type, std::uint16_t packetId)
+{
+    const std::uint8_t flags = type == PUBREL ? 0x02 : 0x00;
+    return packet(static_cast<std::uint8_t>(type << 4 | flags), encodeUint16(packetId));
+}
+
+bool readByte(const std::string& body, std::size_t& position, std::uint8_t& value)
+{
+    if (position + 1 > body.size())
+    {
+        return false;
+    }
+
+    value = static_cast<std::uint8_t>(body[position++]);
+    return true;
+}
+
+bool readUint16(const std::string& body, std::size_t& position, std::uint16_t& value)
+{
+    if (position + 2 > body.size())
+    {
+        return false;
+    }
+
+    value = static_cast<std::uint16_t>(static_cast<std::uint8_t>(body[position]) << 8 |
+                                       static_cast<std::uint8_t>(body[position + 1]));
+    position += 2;
+    return true;
+}
+
+bool readString(const std::string& body, std::size_t& position, std::string& value)
+{
+    std::uint16_t length = 0;
+    if (!readUint16(body, position, length) || position + length > body.size())
+    {
+        return false;
+    }
+
+    value = body.substr(position, length);
+    position += length;
+    return true;
+}
+
+bool isValidTopic(const std::string& topic)
+{
+    return !topic.empty() && topic.find_first_of("+#") == std::string::npos &&
+           topic.find('\0') == std::string::npos;
+}
+
+bool isValidFilter(const std::string& filter)
+{
+    if (filter.empty() || filter.find('\0') != std::string::npos)
+    {
+        return false;
+    }
+
+    std::string::size_type start = 0;
+    while (true)
+    {
+        const auto end = filter.find('/', start);
+        const auto level = filter.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+        if (level.size() > 1 && level.find_first_of("+#") != std::string::npos)
+        {
+            return false;
+        }
+
+        if (level == "#" && end != std::string::npos)
+        {
+            return false;
+        }
+
+        if (end == std::string::npos)
+        {
+            return true;
+        }
+
+        start = end + 1;
+    }
+}
+
+bool setNonBlocking(int socket)
+{
+    const int flags = fcntl(socket, F_GETFL, 0);
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+}    // namespace
+
+namespace wolkabout
+{
+const std::size_t EmbeddedBrokerConnectivityService::MAXIMUM_PACKET_SIZE = 1024 * 1024;
+const std::size_t EmbeddedBrokerConnectivityService::MAXIMUM_PENDING_BYTES = 4 * 1024 * 1024;
+
+EmbeddedBrokerConnectivityService::Session::Session(int fd)
+: socket{fd}
+, connected{false}
+, closing{false}
+, broken{false}
+, keepAlive{0}
+, lastActivity{std::chrono::steady_clock::now()}
+, hasWill{false}
+{
+}
+
+EmbeddedBrokerConnectivityService::EmbeddedBrokerConnectivityService(std::string address, std::uint16_t port)
+: m_address{std::move(address)}
+, m_port{port}
+, m_listenSocket{-1}
+, m_wakePipe{-1, -1}
+, m_running{false}
+, m_generatedClientIds{0}
+, m_receivedMessages{MetricsRegistry::getInstance().counter("wolkgateway_embedded_broker_received_messages_total")}
+, m_deliveredMessages{MetricsRegistry::getInstance().counter("wolkgateway_embedded_broker_delivered_messages_total")}
+, m_droppedMessages{MetricsRegistry::getInstance().counter("wolkgateway_embedded_broker_dropped_messages_total")}
+, m_clients{MetricsRegistry::getInstance().gauge("wolkgateway_embedded_broker_clients")}
+{
+}
+
+EmbeddedBrokerConnectivityService::~EmbeddedBrokerConnectivityService()
+{
+    disconnect();
+}
+
+bool EmbeddedBrokerConnectivityService::connect()
+{
+    if (m_running)
+    {
+        refreshChannels();
+        return true;
+    }
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(m_port);
+    if (inet_pton(AF_INET, m_address.c_str(), &address.sin_addr) != 1)
+    {
+        GATEWAY_LOG(ERROR) << "EmbeddedBrokerConnectivityService: Invalid address " << m_address;
+        return false;
+    }
+
+    m_listenSocket = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listenSocket == -1)
+    {
+        GATEWAY_LOG(ERROR) << "EmbeddedBrokerConnectivityService: Unable to create socket: " << std::strerror(errno);
+        return false;
+    }
+
+    const int reuse = 1;
+    setsockopt(m_listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    socklen_t addressLength = sizeof(address);
+    if (bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 ||
+        listen(m_listenSocket, SOMAXCONN) == -1 || !setNonBlocking(m_listenSocket) ||
+        getsockname(m_listenSocket, reinterpret_cast<sockaddr*>(&address), &addressLength) == -1 ||
+        pipe(m_wakePipe) == -1)
+    {
+        GATEWAY_LOG(ERROR) << "EmbeddedBrokerConnectivityService: Unable to listen on " << m_address << ":" << m_port
+                           << ": " << std::strerror(errno);
+        closeAll();
+        return false;
+    }
+
+    setNonBlocking(m_wakePipe[0]);
+    setNonBlocking(m_wakePipe[1]);
+    m_port = ntohs(address.sin_port);
+
+    refreshChannels();
+
+    m_running = true;
+    m_thread = std::thread(&EmbeddedBrokerConnectivityService::run, this);
+
+    GATEWAY_LOG(INFO) << "EmbeddedBrokerConnectivityService: Listening on " << m_address << ":" << m_port;
+    return true;
+}
+
+void EmbeddedBrokerConnectivityService::disconnect()
+{
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+
+    wake();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    std::lock_guard<std::mutex> locker{m_lock};
+    closeAll();
+}
+
+bool EmbeddedBrokerConnectivityService::isConnected()
+{
+    return m_running;
+}
+
+bool EmbeddedBrokerConnectivityService::publish(std::shared_ptr<Message> outboundMessage, bool)
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+    if (!m_running)
+    {
+        return false;
+    }
+
+    if (deliver(outboundMessage->getChannel(), outboundMessage->getContent()))
+    {
+        wake();
+    }
+
+    return true;
+}
+
+void EmbeddedBrokerConnectivityService::setUncontrolledDisonnectMessage(std::shared_ptr<Message>, bool) {}
+
+void EmbeddedBrokerConnectivityService::refreshChannels()
+{
+    TopicTrie<bool> channels;
+    if (auto listener = m_listener.lock())
+    {
+        for (const auto& channel : listener->getChannels())
+        {
+            channels.insert(channel, true);
+        }
+    }
+
+    std::lock_guard<std::mutex> locker{m_lock};
+    m_listenerChannels = channels;
+}
+
+std::uint16_t EmbeddedBrokerConnectivityService::getPort() const
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+    return m_port;
+}
+
+std::size_t EmbeddedBrokerConnectivityService::getClientCount() const
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    std::size_t count = 0;
+    for (const auto& session : m_sessions)
+    {
+        if (session.second.connected && !session.second.closing)
+        {
+            ++count;
+        }
+    }
+
+    return count;
+}
+
+void EmbeddedBrokerConnectivityService::run()
+{
+    std::vector<pollfd> descriptors;
+
+    while (m_running)
+    {
+        descriptors.clear();
+        descriptors.push_back(pollfd{m_listenSocket, POLLIN, 0});
+        descriptors.push_back(pollfd{m_wakePipe[0], POLLIN, 0});
+        {
+            std::lock_guard<std::mutex> locker{m_lock};
+            for (const auto& session : m_sessions)
+            {
+                const short events = static_cast<short>(POLLIN | (session.second.output.empty() ? 0 : POLLOUT));
+                descriptors.push_back(pollfd{session.first, events, 0});
+            }
+        }
+
+        if (poll(descriptors.data(), descriptors.size(), POLL_INTERVAL_MS) == -1 && errno != EINTR)
+        {
+            GATEWAY_LOG(ERROR) << "EmbeddedBrokerConnectivityService: Poll failed: " << std::strerror(errno);
+            break;
+        }
+
+        Messages forListener;
+        {
+            std::lock_guard<std::mutex> locker{m_lock};
+
+            if (descriptors[1].revents & POLLIN)
+            {
+                char drain[64];
+                while (read(m_wakePipe[0], drain, sizeof(drain)) > 0)
+                {
+                }
+            }
+
+            if (descriptors[0].revents & POLLIN)
+            {
+                acceptClients();
+            }
+
+            for (std::size_t i = 2; i < descriptors.size(); ++i)
+            {
+                auto it = m_sessions.find(descriptors[i].fd);
+                if (it == m_sessions.end() || it->second.closing)
+                {
+                    continue;
+                }
+
+                Session& session = it->second;
+                if (descriptors[i].revents & POLLOUT)
+                {
+                    flush(session);
+                }
+
+                if (descriptors[i].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL))
+                {
+                    receive(session, forListener);
+                }
+            }
+
+            const auto now = std::chrono::steady_clock::now();
+            for (auto& session : m_sessions)
+            {
+                const auto idle = now - session.second.lastActivity;
+                const auto keepAlive = session.second.keepAlive;
+                if ((!session.second.connected && idle > CONNECT_TIMEOUT) ||
+                    (keepAlive.count() > 0 && idle > keepAlive + keepAlive / 2))
+                {
+                    GATEWAY_LOG(DEBUG) << "EmbeddedBrokerConnectivityService: Client '" << session.second.clientId
+                                       << "' timed out";
+                    session.second.broken = true;
+                }
+            }
+
+            sweep(forListener);
+        }
+
+        if (auto listener = m_listener.lock())
+        {
+            for (const auto& message : forListener)
+            {
+                listener->messageReceived(message.first, message.second);
+            }
+        }
+    }
+}
+
+void EmbeddedBrokerConnectivityService::acceptClients()
+{
+    while (true)
+    {
+        const int client = accept(m_listenSocket, nullptr, nullptr);
+        if (client == -1)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                GATEWAY_LOG(WARN) << "EmbeddedBrokerConnectivityService: Accept failed: " << std::strerror(errno);
+            }
+            return;
+        }
+
+        if (!setNonBlocking(client))
+        {
+            ::close(client);
+            continue;
+        }
+
+        const int noDelay = 1;
+        setsockopt(client, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        m_sessions.emplace(client, Session{client});
+    }
+}
+
+void EmbeddedBrokerConnectivityService::receive(Session& session, Messages& forListener)
+{
+    char buffer[RECEIVE_BUFFER_SIZE];
+
+    // once input holds a whole packet of maximum size it is parsed, the rest is left in socket for next poll
+    // instead of buffering whatever a client that writes continuously sends
+    while (session.input.size() <= MAXIMUM_PACKET_SIZE + MAXIMUM_FIXED_HEADER_SIZE)
+    {
+        const auto received = recv(session.socket, buffer, sizeof(buffer), 0);
+        if (received > 0)
+        {
+            session.input.append(buffer, static_cast<std::size_t>(received));
+            continue;
+        }
+
+        if (received == -1 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            close(session, forListener);
+            return;
+        }
+
+        break;
+    }
+
+    session.lastActivity = std::chrono::steady_clock::now();
+
+    std::size_t consumed = 0;
+    while (!session.closing && session.input.size() - consumed >= 2)
+    {
+        std::size_t length = 0;
+        std::size_t multiplier = 1;
+        std::size_t position = consumed + 1;
+        bool complete = false;
+        for (int i = 0; i < 4 && position < session.input.size(); ++i)
+        {
+            const auto digit = static_cast<std::uint8_t>(session.input[position++]);
+            length += (digit & 0x7Fu) * multiplier;
+            multiplier *= 128;
+            if ((digit & 0x80) == 0)
+            {
+                complete = true;
+                break;
+            }
+        }
+
+        if (!complete)
+        {
+            if (position - consumed > 4)
+            {
+                close(session, forListener);
+            }
+            break;
+        }
+
+        if (length > MAXIMUM_PACKET_SIZE)
+        {
+            GATEWAY_LOG(WARN) << "EmbeddedBrokerConnectivityService: Packet of " << length << " bytes from '"
+                              << session.clientId << "' exceeds maximum size";
+            close(session, forListener);
+            break;
+        }
+
+        if (session.input.size() - position < length)
+        {
+            break;
+        }
+
+        const auto header = static_cast<std::uint8_t>(session.input[consumed]);
+        const auto body = session.input.substr(position, length);
+        consumed = position + length;
+
+        if (!handlePacket(session, header, body, forListener))
+        {
+            close(session, forListener);
+        }
+    }
+
+    session.input.erase(0, consumed);
+}
+
+bool EmbeddedBrokerConnectivityService::handlePacket(Session& session, std::uint8_t header, const std::string& body,
+                                                     Messages& forListener)
+{
+    const std::uint8_t type = static_cast<std::uint8_t>(header >> 4);
+    if (type == CONNECT)
+    {
+        return !session.connected && handleConnect(session, body, forListener);
+    }
+
+    if (!session.connected)
+    {
+        return false;
+    }
+
+    std::size_t position = 0;
+    std::uint16_t packetId = 0;
+    switch (type)
+    {
+    case PUBLISH:
+        return handlePublish(session, header, body, forListener);
+    case PUBREL:
+        if (!readUint16(body, position, packetId))
+        {
+            return false;
+        }
+        session.pendingReleases.erase(packetId);
+        send(session, acknowledgement(PUBCOMP, packetId));
+        return true;
+    case SUBSCRIBE:
+        return header == (SUBSCRIBE << 4 | 0x02) && handleSubscribe(session, body);
+    case UNSUBSCRIBE:
+        return header == (UNSUBSCRIBE << 4 | 0x02) && handleUnsubscribe(session, body);
+    case PINGREQ:
+        send(session, packet(0xD0, ""));
+        return true;
+    case DISCONNECT:
+        session.hasWill = false;
+        return false;
+    case PUBACK:
+    case PUBREC:
+    case PUBCOMP:
+        // broker only delivers with QoS 0, acknowledgements are not expected
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool EmbeddedBrokerConnectivityService::handleConnect(Session& session, const std::string& body,
+                                                      Messages& forListener)
+{
+    std::size_t position = 0;
+    std::string protocolName;
+    std::uint8_t protocolLevel = 0;
+    std::uint8_t flags = 0;
+    std::uint16_t keepAlive = 0;
+    std::string clientId;
+    if (!readString(body, position, protocolName) || !readByte(body, position, protocolLevel) ||
+        !readByte(body, position, flags) || !readUint16(body, position, keepAlive) ||
+        !readString(body, position, clientId))
+    {
+        return false;
+    }
+
+    if (!((protocolName == "MQTT" && protocolLevel == 4) || (protocolName == "MQIsdp" && protocolLevel == 3)))
+    {
+        send(session, packet(0x20, std::string{'\0', static_cast<char>(CONNACK_UNACCEPTABLE_PROTOCOL)}));
+        return false;
+    }
+
+    if (flags & 0x01)
+    {
+        return false;
+    }
+
+    std::string willTopic;
+    std::string willPayload;
+    const bool hasWill = (flags & 0x04) != 0;
+    if (hasWill && (!readString(body, position, willTopic) || !readString(body, position, willPayload) ||
+                    !isValidTopic(willTopic)))
+    {
+        return false;
+    }
+
+    std::string ignored;
+    if (((flags & 0x80) && !readString(body, position, ignored)) ||
+        ((flags & 0x40) && !readString(body, position, ignored)))
+    {
+        return false;
+    }
+
+    if (clientId.empty())
+    {
+        if ((flags & 0x02) == 0)
+        {
+            send(session, packet(0x20, std::string{'\0', static_cast<char>(CONNACK_IDENTIFIER_REJECTED)}));
+            return false;
+        }
+
+        clientId = "wolkgateway-" + std::to_string(++m_generatedClientIds);
+    }
+
+    for (auto& other : m_sessions)
+    {
+        if (&other.second != &session && other.second.connected && !other.second.closing &&
+            other.second.clientId == clientId)
+        {
+            GATEWAY_LOG(DEBUG) << "EmbeddedBrokerConnectivityService: Client '" << clientId << "' reconnected";
+            close(other.second, forListener);
+        }
+    }
+
+    session.connected = true;
+    session.clientId = clientId;
+    session.keepAlive = std::chrono::seconds{keepAlive};
+    session.hasWill = hasWill;
+    session.willTopic = willTopic;
+    session.willPayload = willPayload;
+    m_clients.increment();
+
+    send(session, packet(0x20, std::string{'\0', static_cast<char>(CONNACK_ACCEPTED)}));
+    return true;
+}
+
+bool EmbeddedBrokerConnectivityService::handlePublish(Session& session, std::uint8_t header,
+                                                      const std::string& body, Messages& forListener)
+{
+    const std::uint8_t qos = static_cast<std::uint8_t>((header >> 1) & 0x03);
+    if (qos > 2)
+    {
+        return false;
+    }
+
+    std::size_t position = 0;
+    std::string topic;
+    std::uint16_t packetId = 0;
+    if (!readString(body, position, topic) || !isValidTopic(topic) ||
+        (qos > 0 && !readUint16(body, position, packetId)))
+    {
+        return false;
+    }
+
+    if (qos == 1)
+    {
+        send(session, acknowledgement(PUBACK, packetId));
+    }
+    else if (qos == 2)
+    {
+        send(session, acknowledgement(PUBREC, packetId));
+        if (!session.pendingReleases.insert(packetId).second)
+        {
+            // retransmission of message that was already routed
+            return true;
+        }
+    }
+
+    m_receivedMessages.increment();
+    route(topic, body.substr(position), forListener);
+    return true;
+}
+
+bool EmbeddedBrokerConnectivityService::handleSubscribe(Session& session, const std::string& body)
+{
+    std::size_t position = 0;
+    std::uint16_t packetId = 0;
+    if (!readUint16(body, position, packetId) || position == body.size())
+    {
+        return false;
+    }
+
+    std::string codes;
+    while (position < body.size())
+    {
+        std::string filter;
+        std::uint8_t requestedQos = 0;
+        if (!readString(body, position, filter) || !readByte(body, position, requestedQos) || requestedQos > 2)
+        {
+            return false;
+        }
+
+        if (!isValidFilter(filter))
+        {
+            codes.push_back(static_cast<char>(SUBACK_FAILURE));
+            continue;
+        }
+
+        auto& subscribers = m_subscribers[filter];
+        if (subscribers.empty())
+        {
+            m_filters.insert(filter, filter);
+        }
+
+        subscribers.insert(session.socket);
+        session.filters.insert(filter);
+        codes.push_back('\0');
+    }
+
+    send(session, packet(0x90, encodeUint16(packetId) + codes));
+    return true;
+}
+
+bool EmbeddedBrokerConnectivityService::handleUnsubscribe(Session& session, const std::string& body)
+{
+    std::size_t position = 0;
+    std::uint16_t packetId = 0;
+    if (!readUint16(body, position, packetId) || position == body.size())
+    {
+        return false;
+    }
+
+    while (position < body.size())
+    {
+        std::string filter;
+        if (!readString(body, position, filter))
+        {
+            return false;
+        }
+
+        if (session.filters.erase(filter) == 0)
+        {
+            continue;
+        }
+
+        auto it = m_subscribers.find(filter);
+        it->second.erase(session.socket);
+        if (it->second.empty())
+        {
+            m_subscribers.erase(it);
+            m_filters.remove(filter);
+        }
+    }
+
+    send(session, packet(0xB0, encodeUint16(packetId)));
+    return true;
+}
+
+void EmbeddedBrokerConnectivityService::route(const std::string& topic, const std::string& payload,
+                                              Messages& forListener)
+{
+    if (m_listenerChannels.match(topic) != nullptr)
+    {
+        forListener.emplace_back(topic, payload);
+    }
+
+    deliver(topic, payload);
+}
+
+bool EmbeddedBrokerConnectivityService::deliver(const std::string& topic, const std::string& payload)
+{
+    std::set<int> targets;
+    for (const auto& filter : m_filters.matchAll(topic))
+    {
+        const auto& subscribers = m_subscribers[filter];
+        targets.insert(subscribers.begin(), subscribers.end());
+    }
+
+    if (targets.empty())
+    {
+        return false;
+    }
+
+    const std::string message = packet(PUBLISH << 4, encodeString(topic) + payload);
+
+    bool pending = false;
+    for (int target : targets)
+    {
+        Session& session = m_sessions.at(target);
+        if (session.closing)
+        {
+            continue;
+        }
+
+        if (session.output.size() + message.size() > MAXIMUM_PENDING_BYTES)
+        {
+            m_droppedMessages.increment();
+            continue;
+        }
+
+        send(session, message);
+        m_deliveredMessages.increment();
+        pending = pending || !session.output.empty();
+    }
+
+    return pending;
+}
+
+void EmbeddedBrokerConnectivityService::send(Session& session, const std::string& packet)
+{
+    session.output += packet;
+    flush(session);
+}
+
+void EmbeddedBrokerConnectivityService::flush(Session& session)
+{
+    while (!session.output.empty() && !session.broken)
+    {
+        const auto sent = ::send(session.socket, session.output.data(), session.output.size(), MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            session.output.erase(0, static_cast<std::size_t>(sent));
+        }
+        else if (sent == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            session.broken = sent == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+            return;
+        }
+    }
+}
+
+void EmbeddedBrokerConnectivityService::close(Session& session, Messages& forListener)
+{
+    if (session.closing)
+    {
+        return;
+    }
+
+    session.closing = true;
+    if (session.connected)
+    {
+        m_clients.decrement();
+    }
+
+    if (session.hasWill)
+    {
+        session.hasWill = false;
+        route(session.willTopic, session.willPayload, forListener);
+    }
+}
+
+void EmbeddedBrokerConnectivityService::sweep(Messages& forListener)
+{
+    // closing may publish wills, which may break other sessions in turn
+    bool closed = true;
+    while (closed)
+    {
+        closed = false;
+        for (auto& session : m_sessions)
+        {
+            if (session.second.broken && !session.second.closing)
+            {
+                close(session.second, forListener);
+                closed = true;
+            }
+        }
+    }
+
+    for (auto it = m_sessions.begin(); it != m_sessions.end();)
+    {
+        if (!it->second.closing)
+        {
+            ++it;
+            continue;
+        }
+
+        for (const auto& filter : it->second.filters)
+        {
+            auto subscribers = m_subscribers.find(filter);
+            subscribers->second.erase(it->first);
+            if (subscribers->second.empty())
+            {
+                m_subscribers.erase(subscribers);
+                m_filters.remove(filter);
+            }
+        }
+
+        // lets rejected clients read their CONNACK
+        flush(it->second);
+        ::close(it->first);
+        it = m_sessions.erase(it);
+    }
+}
+
+void EmbeddedBrokerConnectivityService::closeAll()
+{
+    for (auto& session : m_sessions)
+    {
+        if (session.second.connected && !session.second.closing)
+        {
+            m_clients.decrement();
+        }
+
+        ::close(session.first);
+    }
+
+    m_sessions.clear();
+    m_subscribers.clear();
+    m_filters.clear();
+
+    for (int* socket : {&m_listenSocket, &m_wakePipe[0], &m_wakePipe[1]})
+    {
+        if (*socket != -1)
+        {
+            ::close(*socket);
+            *socket = -1;
+        }
+    }
+}
+
+void EmbeddedBrokerConnectivityService::wake()
+{
+    const char byte = 0;
+    if (m_wakePipe[1] != -1 && write(m_wakePipe[1], &byte, 1) == -1)
+    {
+        // pipe full, loop is already due to wake up
+    }
+}
+}    // namespace wolkabout
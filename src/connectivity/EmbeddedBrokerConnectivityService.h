@@ -0,0 +1,165 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EMBEDDEDBROKERCONNECTIVITYSERVICE_H
+#define EMBEDDEDBROKERCONNECTIVITYSERVICE_H
+
+#include "connectivity/ConnectivityService.h"
+#include "utilities/Metrics.h"
+#include "utilities/TopicTrie.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief wolkabout::ConnectivityService acting as the local MQTT broker subdevices connect to
+ *
+ * Implements the part of MQTT 3.1.1 subdevices use: sessions with keep alive and last will, subscriptions
+ * with wildcards and publishing with QoS 0, 1 and 2. Messages are delivered to subscribers with QoS 0,
+ * retained messages and persistent sessions are not supported, and clients are not authenticated.
+ * Messages on channels of the listener are handed to it by function call on the broker thread,
+ * so they skip the loopback connection and parsing of an external broker.
+ * connect() starts accepting clients, disconnect() closes all of them.
+ */
+class EmbeddedBrokerConnectivityService : public ConnectivityService
+{
+public:
+    static const std::size_t MAXIMUM_PACKET_SIZE;
+    static const std::size_t MAXIMUM_PENDING_BYTES;
+
+    /**
+     * @param address IPv4 address to listen on, "0.0.0.0" for all interfaces
+     * @param port Port to listen on, 0 picks a free one
+     */
+    EmbeddedBrokerConnectivityService(std::string address, std::uint16_t port);
+    ~EmbeddedBrokerConnectivityService();
+
+    EmbeddedBrokerConnectivityService(const EmbeddedBrokerConnectivityService&) = delete;
+    EmbeddedBrokerConnectivityService& operator=(const EmbeddedBrokerConnectivityService&) = delete;
+
+    /**
+     * @brief Starts accepting clients, or reloads channels of the listener if already started
+     */
+    bool connect() override;
+    void disconnect() override;
+    bool isConnected() override;
+
+    /**
+     * @brief Delivers message to clients subscribed to its channel, never blocks on a slow client
+     * @return false if broker is not started
+     */
+    bool publish(std::shared_ptr<Message> outboundMessage, bool persistent = false) override;
+
+    /**
+     * @brief Has no effect, clients see broker going away as their connection closing
+     */
+    void setUncontrolledDisonnectMessage(std::shared_ptr<Message> outboundMessage, bool persistent = false) override;
+
+    /**
+     * @brief Reloads channels handed to the listener, to be called when its channels change
+     */
+    void refreshChannels();
+
+    /**
+     * @brief Port broker listens on, known once started
+     */
+    std::uint16_t getPort() const;
+
+    std::size_t getClientCount() const;
+
+private:
+    struct Session
+    {
+        explicit Session(int fd);
+
+        int socket;
+        bool connected;
+        bool closing;
+        bool broken;
+        std::string clientId;
+
+        std::string input;
+        std::string output;
+
+        std::chrono::steady_clock::duration keepAlive;
+        std::chrono::steady_clock::time_point lastActivity;
+
+        bool hasWill;
+        std::string willTopic;
+        std::string willPayload;
+
+        std::set<std::string> filters;
+        std::set<std::uint16_t> pendingReleases;
+    };
+
+    using Messages = std::vector<std::pair<std::string, std::string>>;
+
+    void run();
+
+    void acceptClients();
+    void receive(Session& session, Messages& forListener);
+    bool handlePacket(Session& session, std::uint8_t header, const std::string& body, Messages& forListener);
+    bool handleConnect(Session& session, const std::string& body, Messages& forListener);
+    bool handlePublish(Session& session, std::uint8_t header, const std::string& body, Messages& forListener);
+    bool handleSubscribe(Session& session, const std::string& body);
+    bool handleUnsubscribe(Session& session, const std::string& body);
+
+    void route(const std::string& topic, const std::string& payload, Messages& forListener);
+    bool deliver(const std::string& topic, const std::string& payload);
+    void send(Session& session, const std::string& packet);
+    void flush(Session& session);
+    void close(Session& session, Messages& forListener);
+    void sweep(Messages& forListener);
+    void closeAll();
+
+    void wake();
+
+    const std::string m_address;
+    std::uint16_t m_port;
+
+    int m_listenSocket;
+    int m_wakePipe[2];
+
+    std::atomic_bool m_running;
+    std::thread m_thread;
+
+    mutable std::mutex m_lock;
+    std::map<int, Session> m_sessions;
+    std::map<std::string, std::set<int>> m_subscribers;
+    TopicTrie<std::string> m_filters;
+    TopicTrie<bool> m_listenerChannels;
+    std::uint64_t m_generatedClientIds;
+
+    Counter& m_receivedMessages;
+    Counter& m_deliveredMessages;
+    Counter& m_droppedMessages;
+    Gauge& m_clients;
+};
+}    // namespace wolkabout
+
+#endif    // EMBEDDEDBROKERCONNECTIVITYSERVICE_H
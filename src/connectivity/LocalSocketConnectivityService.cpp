@@ -0,0 +1,499 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "connectivity/LocalSocketConnectivityService.h"
+#include "model/Message.h"
+#include "utilities/GatewayLog.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace
+{
+const int POLL_INTERVAL_MS = 1000;
+const std::size_t RECEIVE_BUFFER_SIZE = 16384;
+const std::size_t LENGTH_SIZE = 4;
+const std::size_t HEADER_SIZE = 3;
+
+bool setNonBlocking(int socket)
+{
+    const int flags = fcntl(socket, F_GETFL, 0);
+    return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+std::size_t readLength(const std::string& input, std::size_t position)
+{
+    std::size_t length = 0;
+    for (std::size_t i = 0; i < LENGTH_SIZE; ++i)
+    {
+        length = length << 8 | static_cast<std::uint8_t>(input[position + i]);
+    }
+
+    return length;
+}
+
+std::size_t readChannelLength(const std::string& input, std::size_t position)
+{
+    return static_cast<std::size_t>(static_cast<std::uint8_t>(input[position])) << 8 |
+           static_cast<std::uint8_t>(input[position + 1]);
+}
+}    // namespace
+
+namespace wolkabout
+{
+const std::size_t LocalSocketConnectivityService::MAXIMUM_FRAME_SIZE = 1024 * 1024;
+const std::size_t LocalSocketConnectivityService::MAXIMUM_PENDING_BYTES = 4 * 1024 * 1024;
+
+LocalSocketConnectivityService::LocalSocketConnectivityService(std::string socketPath,
+                                                               std::unique_ptr<ConnectivityService> broker)
+: m_socketPath{std::move(socketPath)}
+, m_broker{std::move(broker)}
+, m_brokerListener{std::make_shared<BrokerListener>(*this)}
+, m_listenSocket{-1}
+, m_wakePipe{-1, -1}
+, m_running{false}
+, m_receivedMessages{MetricsRegistry::getInstance().counter("wolkgateway_local_socket_received_messages_total")}
+, m_droppedMessages{MetricsRegistry::getInstance().counter("wolkgateway_local_socket_dropped_messages_total")}
+{
+    if (m_broker)
+    {
+        m_broker->setListener(m_brokerListener);
+    }
+}
+
+LocalSocketConnectivityService::~LocalSocketConnectivityService()
+{
+    disconnect();
+}
+
+bool LocalSocketConnectivityService::connect()
+{
+    const bool listening = m_running || listen();
+    if (!m_broker)
+    {
+        return listening;
+    }
+
+    return (m_broker->isConnected() || m_broker->connect()) && listening;
+}
+
+void LocalSocketConnectivityService::disconnect()
+{
+    if (m_broker)
+    {
+        m_broker->disconnect();
+    }
+
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+
+    wake();
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    std::lock_guard<std::mutex> locker{m_lock};
+    closeAll();
+    unlink(m_socketPath.c_str());
+}
+
+bool LocalSocketConnectivityService::isConnected()
+{
+    return m_running && (!m_broker || m_broker->isConnected());
+}
+
+bool LocalSocketConnectivityService::publish(std::shared_ptr<Message> outboundMessage, bool persistent)
+{
+    {
+        std::lock_guard<std::mutex> locker{m_lock};
+
+        std::string frame;
+        bool pending = false;
+        for (auto& adapter : m_adapters)
+        {
+            if (adapter.second.filters.match(outboundMessage->getChannel()) == nullptr)
+            {
+                continue;
+            }
+
+            if (frame.empty())
+            {
+                frame = makeFrame(MESSAGE, outboundMessage->getChannel(), outboundMessage->getContent());
+            }
+
+            if (adapter.second.output.size() + frame.size() > MAXIMUM_PENDING_BYTES)
+            {
+                m_droppedMessages.increment();
+                continue;
+            }
+
+            adapter.second.output += frame;
+            flush(adapter.first, adapter.second);
+            pending = pending || !adapter.second.output.empty();
+        }
+
+        if (pending)
+        {
+            wake();
+        }
+    }
+
+    return m_broker ? m_broker->publish(outboundMessage, persistent) : m_running.load();
+}
+
+void LocalSocketConnectivityService::setUncontrolledDisonnectMessage(std::shared_ptr<Message> outboundMessage,
+                                                                     bool persistent)
+{
+    if (m_broker)
+    {
+        m_broker->setUncontrolledDisonnectMessage(outboundMessage, persistent);
+    }
+}
+
+ConnectivityService* LocalSocketConnectivityService::getBroker() const
+{
+    return m_broker.get();
+}
+
+std::size_t LocalSocketConnectivityService::getAdapterCount() const
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+    return m_adapters.size();
+}
+
+std::string LocalSocketConnectivityService::makeFrame(FrameType type, const std::string& channel,
+                                                      const std::string& payload)
+{
+    const std::size_t length = HEADER_SIZE + channel.size() + payload.size();
+
+    std::string frame;
+    frame.reserve(LENGTH_SIZE + length);
+    for (std::size_t i = LENGTH_SIZE; i > 0; --i)
+    {
+        frame.push_back(static_cast<char>((length >> (8 * (i - 1))) & 0xFF));
+    }
+
+    frame.push_back(static_cast<char>(type));
+    frame.push_back(static_cast<char>((channel.size() >> 8) & 0xFF));
+    frame.push_back(static_cast<char>(channel.size() & 0xFF));
+    frame += channel;
+    frame += payload;
+    return frame;
+}
+
+bool LocalSocketConnectivityService::listen()
+{
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (m_socketPath.empty() || m_socketPath.size() >= sizeof(address.sun_path))
+    {
+        GATEWAY_LOG(ERROR) << "LocalSocketConnectivityService: Invalid socket path '" << m_socketPath << "'";
+        return false;
+    }
+    std::memcpy(address.sun_path, m_socketPath.c_str(), m_socketPath.size());
+
+    // socket left behind by previous run would make bind fail
+    unlink(m_socketPath.c_str());
+
+    m_listenSocket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (m_listenSocket == -1 || bind(m_listenSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 ||
+        chmod(m_socketPath.c_str(), S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP) == -1 ||
+        ::listen(m_listenSocket, SOMAXCONN) == -1 || !setNonBlocking(m_listenSocket) || pipe(m_wakePipe) == -1)
+    {
+        GATEWAY_LOG(ERROR) << "LocalSocketConnectivityService: Unable to listen on '" << m_socketPath
+                           << "': " << std::strerror(errno);
+        closeAll();
+        return false;
+    }
+
+    setNonBlocking(m_wakePipe[0]);
+    setNonBlocking(m_wakePipe[1]);
+
+    m_running = true;
+    m_thread = std::thread(&LocalSocketConnectivityService::run, this);
+
+    GATEWAY_LOG(INFO) << "LocalSocketConnectivityService: Listening on '" << m_socketPath << "'";
+    return true;
+}
+
+void LocalSocketConnectivityService::run()
+{
+    std::vector<pollfd> descriptors;
+
+    while (m_running)
+    {
+        descriptors.clear();
+        descriptors.push_back(pollfd{m_listenSocket, POLLIN, 0});
+        descriptors.push_back(pollfd{m_wakePipe[0], POLLIN, 0});
+        {
+            std::lock_guard<std::mutex> locker{m_lock};
+            for (const auto& adapter : m_adapters)
+            {
+                const short events = static_cast<short>(POLLIN | (adapter.second.output.empty() ? 0 : POLLOUT));
+                descriptors.push_back(pollfd{adapter.first, events, 0});
+            }
+        }
+
+        if (poll(descriptors.data(), descriptors.size(), POLL_INTERVAL_MS) == -1 && errno != EINTR)
+        {
+            GATEWAY_LOG(ERROR) << "LocalSocketConnectivityService: Poll failed: " << std::strerror(errno);
+            break;
+        }
+
+        Messages forListener;
+        {
+            std::lock_guard<std::mutex> locker{m_lock};
+
+            if (descriptors[1].revents & POLLIN)
+            {
+                char drain[64];
+                while (read(m_wakePipe[0], drain, sizeof(drain)) > 0)
+                {
+                }
+            }
+
+            if (descriptors[0].revents & POLLIN)
+            {
+                acceptAdapters();
+            }
+
+            for (std::size_t i = 2; i < descriptors.size(); ++i)
+            {
+                auto it = m_adapters.find(descriptors[i].fd);
+                if (it == m_adapters.end())
+                {
+                    continue;
+                }
+
+                bool open = true;
+                if (descriptors[i].revents & POLLOUT)
+                {
+                    open = flush(it->first, it->second);
+                }
+
+                if (open && (descriptors[i].revents & (POLLIN | POLLHUP | POLLERR | POLLNVAL)))
+                {
+                    open = receive(it->first, it->second, forListener);
+                }
+
+                if (!open)
+                {
+                    ::close(it->first);
+                    m_adapters.erase(it);
+                }
+            }
+        }
+
+        if (auto listener = m_listener.lock())
+        {
+            for (const auto& message : forListener)
+            {
+                listener->messageReceived(message.first, message.second);
+            }
+        }
+    }
+}
+
+void LocalSocketConnectivityService::acceptAdapters()
+{
+    while (true)
+    {
+        const int adapter = accept(m_listenSocket, nullptr, nullptr);
+        if (adapter == -1)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+            {
+                GATEWAY_LOG(WARN) << "LocalSocketConnectivityService: Accept failed: " << std::strerror(errno);
+            }
+            return;
+        }
+
+        if (!setNonBlocking(adapter))
+        {
+            ::close(adapter);
+            continue;
+        }
+
+        m_adapters.emplace(adapter, Adapter{});
+    }
+}
+
+bool LocalSocketConnectivityService::receive(int socket, Adapter& adapter, Messages& forListener)
+{
+    char buffer[RECEIVE_BUFFER_SIZE];
+    // reading stops once input holds a whole frame of maximum size, the rest is read on next poll
+    while (adapter.input.size() <= LENGTH_SIZE + MAXIMUM_FRAME_SIZE)
+    {
+        const auto received = recv(socket, buffer, sizeof(buffer), 0);
+        if (received > 0)
+        {
+            adapter.input.append(buffer, static_cast<std::size_t>(received));
+            continue;
+        }
+
+        if (received == -1 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+        {
+            return false;
+        }
+
+        break;
+    }
+
+    std::size_t consumed = 0;
+    while (adapter.input.size() - consumed >= LENGTH_SIZE)
+    {
+        const std::size_t length = readLength(adapter.input, consumed);
+        if (length < HEADER_SIZE || length > MAXIMUM_FRAME_SIZE)
+        {
+            GATEWAY_LOG(WARN) << "LocalSocketConnectivityService: Invalid frame length " << length
+                              << ", closing adapter connection";
+            return false;
+        }
+
+        if (adapter.input.size() - consumed - LENGTH_SIZE < length)
+        {
+            break;
+        }
+
+        const std::size_t frame = consumed + LENGTH_SIZE;
+        const auto type = static_cast<std::uint8_t>(adapter.input[frame]);
+        const std::size_t channelLength = readChannelLength(adapter.input, frame + 1);
+        if (HEADER_SIZE + channelLength > length || channelLength == 0)
+        {
+            GATEWAY_LOG(WARN) << "LocalSocketConnectivityService: Invalid channel length " << channelLength
+                              << ", closing adapter connection";
+            return false;
+        }
+
+        std::string channel = adapter.input.substr(frame + HEADER_SIZE, channelLength);
+        consumed = frame + length;
+
+        if (type == MESSAGE)
+        {
+            const std::size_t payload = frame + HEADER_SIZE + channelLength;
+            forListener.emplace_back(std::move(channel), adapter.input.substr(payload, consumed - payload));
+            m_receivedMessages.increment();
+        }
+        else if (type == SUBSCRIBE)
+        {
+            adapter.filters.insert(channel, true);
+        }
+        else
+        {
+            GATEWAY_LOG(WARN) << "LocalSocketConnectivityService: Unknown frame type " << static_cast<int>(type);
+        }
+    }
+
+    adapter.input.erase(0, consumed);
+    return true;
+}
+
+bool LocalSocketConnectivityService::flush(int socket, Adapter& adapter)
+{
+    while (!adapter.output.empty())
+    {
+        const auto sent = ::send(socket, adapter.output.data(), adapter.output.size(), MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            adapter.output.erase(0, static_cast<std::size_t>(sent));
+        }
+        else if (sent == -1 && errno == EINTR)
+        {
+            continue;
+        }
+        else
+        {
+            return sent == -1 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        }
+    }
+
+    return true;
+}
+
+void LocalSocketConnectivityService::closeAll()
+{
+    for (const auto& adapter : m_adapters)
+    {
+        ::close(adapter.first);
+    }
+    m_adapters.clear();
+
+    for (int* descriptor : {&m_listenSocket, &m_wakePipe[0], &m_wakePipe[1]})
+    {
+        if (*descriptor != -1)
+        {
+            ::close(*descriptor);
+            *descriptor = -1;
+        }
+    }
+}
+
+void LocalSocketConnectivityService::wake()
+{
+    const char byte = 0;
+    if (m_wakePipe[1] != -1 && write(m_wakePipe[1], &byte, 1) == -1)
+    {
+        // pipe full, loop is already due to wake up
+    }
+}
+
+LocalSocketConnectivityService::BrokerListener::BrokerListener(LocalSocketConnectivityService& service)
+: m_service{service}
+{
+}
+
+void LocalSocketConnectivityService::BrokerListener::messageReceived(const std::string& channel,
+                                                                     const std::string& message)
+{
+    if (auto listener = m_service.m_listener.lock())
+    {
+        listener->messageReceived(channel, message);
+    }
+}
+
+void LocalSocketConnectivityService::BrokerListener::connectionLost()
+{
+    if (auto listener = m_service.m_listener.lock())
+    {
+        listener->connectionLost();
+    }
+}
+
+std::vector<std::string> LocalSocketConnectivityService::BrokerListener::getChannels() const
+{
+    if (auto listener = m_service.m_listener.lock())
+    {
+        return listener->getChannels();
+    }
+
+    return {};
+}
+}    // namespace wolkabout
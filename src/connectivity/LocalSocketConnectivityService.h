@@ -0,0 +1,143 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef LOCALSOCKETCONNECTIVITYSERVICE_H
+#define LOCALSOCKETCONNECTIVITYSERVICE_H
+
+#include "connectivity/ConnectivityService.h"
+#include "utilities/Metrics.h"
+#include "utilities/TopicTrie.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief wolkabout::ConnectivityService taking messages from adapters running on the same host over Unix socket
+ *
+ * Adapters write frames of 4 byte big endian length followed by frame type, 2 byte big endian channel length,
+ * channel and payload. MESSAGE frames are handed to the listener as they are, without MQTT encoding;
+ * SUBSCRIBE frames carry a topic filter in the channel, and messages published on matching channels are
+ * written back to the adapter as MESSAGE frames.
+ *
+ * Wraps broker connection, if given, so both paths feed the same listener: it is connected, disconnected
+ * and published to along with the socket, and its lost connection is reported to the listener.
+ */
+class LocalSocketConnectivityService : public ConnectivityService
+{
+public:
+    enum FrameType : std::uint8_t
+    {
+        MESSAGE = 0,
+        SUBSCRIBE = 1
+    };
+
+    static const std::size_t MAXIMUM_FRAME_SIZE;
+    static const std::size_t MAXIMUM_PENDING_BYTES;
+
+    /**
+     * @param socketPath Path of socket file, replaced if it exists
+     * @param broker Broker connection used alongside socket, may be null
+     */
+    LocalSocketConnectivityService(std::string socketPath, std::unique_ptr<ConnectivityService> broker = nullptr);
+    ~LocalSocketConnectivityService();
+
+    LocalSocketConnectivityService(const LocalSocketConnectivityService&) = delete;
+    LocalSocketConnectivityService& operator=(const LocalSocketConnectivityService&) = delete;
+
+    /**
+     * @brief Starts accepting adapters if not started, and connects broker connection
+     * @return true if socket is listening and broker connection, if any, is connected
+     */
+    bool connect() override;
+    void disconnect() override;
+    bool isConnected() override;
+
+    bool publish(std::shared_ptr<Message> outboundMessage, bool persistent = false) override;
+
+    void setUncontrolledDisonnectMessage(std::shared_ptr<Message> outboundMessage, bool persistent = false) override;
+
+    /**
+     * @brief Broker connection given at construction, or nullptr
+     */
+    ConnectivityService* getBroker() const;
+
+    std::size_t getAdapterCount() const;
+
+    /**
+     * @brief Builds frame as adapters write it, for adapters linking the gateway library
+     */
+    static std::string makeFrame(FrameType type, const std::string& channel, const std::string& payload = "");
+
+private:
+    class BrokerListener : public ConnectivityServiceListener
+    {
+    public:
+        explicit BrokerListener(LocalSocketConnectivityService& service);
+
+        void messageReceived(const std::string& channel, const std::string& message) override;
+        void connectionLost() override;
+        std::vector<std::string> getChannels() const override;
+
+    private:
+        LocalSocketConnectivityService& m_service;
+    };
+
+    struct Adapter
+    {
+        std::string input;
+        std::string output;
+        TopicTrie<bool> filters;
+    };
+
+    using Messages = std::vector<std::pair<std::string, std::string>>;
+
+    bool listen();
+    void run();
+    void acceptAdapters();
+    bool receive(int socket, Adapter& adapter, Messages& forListener);
+    bool flush(int socket, Adapter& adapter);
+    void closeAll();
+    void wake();
+
+    const std::string m_socketPath;
+    std::unique_ptr<ConnectivityService> m_broker;
+    std::shared_ptr<BrokerListener> m_brokerListener;
+
+    int m_listenSocket;
+    int m_wakePipe[2];
+
+    std::atomic_bool m_running;
+    std::thread m_thread;
+
+    mutable std::mutex m_lock;
+    std::map<int, Adapter> m_adapters;
+
+    Counter& m_receivedMessages;
+    Counter& m_droppedMessages;
+};
+}    // namespace wolkabout
+
+#endif    // LOCALSOCKETCONNECTIVITYSERVICE_H
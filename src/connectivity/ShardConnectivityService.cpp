@@ -0,0 +1,124 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "connectivity/ShardConnectivityService.h"
+#include "utilities/GatewayLog.h"
+
+#include <utility>
+
+namespace wolkabout
+{
+ShardConnectivityService::ShardConnectivityService(std::unique_ptr<ConnectivityService> connection,
+                                                   DeviceShard shard, bool routed)
+: m_connection{std::move(connection)}
+, m_shard{shard}
+, m_prefix{routed ? shard.getChannelPrefix() : ""}
+, m_connectionListener{std::make_shared<ConnectionListener>(*this)}
+, m_droppedMessages{MetricsRegistry::getInstance().counter("wolkgateway_shard_dropped_messages_total")}
+{
+    m_connection->setListener(m_connectionListener);
+}
+
+bool ShardConnectivityService::connect()
+{
+    return m_connection->connect();
+}
+
+void ShardConnectivityService::disconnect()
+{
+    m_connection->disconnect();
+}
+
+bool ShardConnectivityService::isConnected()
+{
+    return m_connection->isConnected();
+}
+
+bool ShardConnectivityService::publish(std::shared_ptr<Message> outboundMessage, bool persistent)
+{
+    return m_connection->publish(std::move(outboundMessage), persistent);
+}
+
+void ShardConnectivityService::setUncontrolledDisonnectMessage(std::shared_ptr<Message> outboundMessage,
+                                                               bool persistent)
+{
+    m_connection->setUncontrolledDisonnectMessage(std::move(outboundMessage), persistent);
+}
+
+ConnectivityService& ShardConnectivityService::getConnection() const
+{
+    return *m_connection;
+}
+
+const DeviceShard& ShardConnectivityService::getShard() const
+{
+    return m_shard;
+}
+
+ShardConnectivityService::ConnectionListener::ConnectionListener(ShardConnectivityService& service)
+: m_service{service}
+{
+}
+
+void ShardConnectivityService::ConnectionListener::messageReceived(const std::string& channel,
+                                                                   const std::string& message)
+{
+    if (channel.compare(0, m_service.m_prefix.size(), m_service.m_prefix) != 0)
+    {
+        GATEWAY_LOG(DEBUG) << "ShardConnectivityService: Dropping message on channel outside of shard '" << channel
+                           << "'";
+        m_service.m_droppedMessages.increment();
+        return;
+    }
+
+    const std::string originalChannel = channel.substr(m_service.m_prefix.size());
+    // router already sorted routed messages, checking them too catches router and worker disagreeing on shard count
+    if (!m_service.m_shard.ownsChannel(originalChannel))
+    {
+        GATEWAY_LOG(TRACE) << "ShardConnectivityService: Dropping message of another shard on channel '"
+                           << originalChannel << "'";
+        m_service.m_droppedMessages.increment();
+        return;
+    }
+
+    if (auto listener = m_service.m_listener.lock())
+    {
+        listener->messageReceived(originalChannel, message);
+    }
+}
+
+void ShardConnectivityService::ConnectionListener::connectionLost()
+{
+    if (auto listener = m_service.m_listener.lock())
+    {
+        listener->connectionLost();
+    }
+}
+
+std::vector<std::string> ShardConnectivityService::ConnectionListener::getChannels() const
+{
+    std::vector<std::string> channels;
+    if (auto listener = m_service.m_listener.lock())
+    {
+        for (const auto& channel : listener->getChannels())
+        {
+            channels.push_back(m_service.m_prefix + channel);
+        }
+    }
+
+    return channels;
+}
+}    // namespace wolkabout
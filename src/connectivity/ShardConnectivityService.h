@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHARDCONNECTIVITYSERVICE_H
+#define SHARDCONNECTIVITYSERVICE_H
+
+#include "connectivity/ConnectivityService.h"
+#include "utilities/DeviceShard.h"
+#include "utilities/Metrics.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief wolkabout::ConnectivityService passing to the listener only messages of devices in one shard
+ *
+ * When routed, listener channels are subscribed below the prefix of the shard, on which wolkabout::ShardRouter
+ * republishes messages of shard devices, and the prefix is removed before messages reach the listener.
+ * Otherwise channels are subscribed as they are and messages of other shards are dropped on arrival,
+ * which is how platform connections of workers receive commands for their devices.
+ * Messages are published unchanged.
+ */
+class ShardConnectivityService : public ConnectivityService
+{
+public:
+    /**
+     * @param connection Wrapped connection
+     * @param shard Shard whose messages are passed to the listener
+     * @param routed Whether messages are republished by router below prefix of the shard
+     */
+    ShardConnectivityService(std::unique_ptr<ConnectivityService> connection, DeviceShard shard, bool routed);
+
+    bool connect() override;
+    void disconnect() override;
+    bool isConnected() override;
+
+    bool publish(std::shared_ptr<Message> outboundMessage, bool persistent = false) override;
+
+    void setUncontrolledDisonnectMessage(std::shared_ptr<Message> outboundMessage, bool persistent = false) override;
+
+    ConnectivityService& getConnection() const;
+    const DeviceShard& getShard() const;
+
+private:
+    class ConnectionListener : public ConnectivityServiceListener
+    {
+    public:
+        explicit ConnectionListener(ShardConnectivityService& service);
+
+        void messageReceived(const std::string& channel, const std::string& message) override;
+        void connectionLost() override;
+        std::vector<std::string> getChannels() const override;
+
+    private:
+        ShardConnectivityService& m_service;
+    };
+
+    const std::unique_ptr<ConnectivityService> m_connection;
+    const DeviceShard m_shard;
+    const std::string m_prefix;
+
+    std::shared_ptr<ConnectionListener> m_connectionListener;
+
+    Counter& m_droppedMessages;
+};
+}    // namespace wolkabout
+
+#endif    // SHARDCONNECTIVITYSERVICE_H
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "connectivity/ShardRouter.h"
+#include "model/Message.h"
+#include "utilities/DeviceShard.h"
+#include "utilities/GatewayLog.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace wolkabout
+{
+ShardRouter::ShardRouter(std::unique_ptr<ConnectivityService> connection, std::vector<std::string> channels,
+                         std::size_t shardCount)
+: m_connection{std::move(connection)}
+, m_channels{std::move(channels)}
+, m_shardCount{std::max<std::size_t>(shardCount, 1)}
+, m_connectionLost{false}
+, m_connectionListener{std::make_shared<ConnectionListener>(*this)}
+, m_routedMessages{MetricsRegistry::getInstance().counter("wolkgateway_shard_router_routed_messages_total")}
+, m_failedMessages{MetricsRegistry::getInstance().counter("wolkgateway_shard_router_failed_messages_total")}
+, m_executor{1}
+{
+    m_connection->setListener(m_connectionListener);
+}
+
+ShardRouter::~ShardRouter()
+{
+    m_connection->disconnect();
+}
+
+bool ShardRouter::connect()
+{
+    if (!m_connection->connect())
+    {
+        return false;
+    }
+
+    m_connectionLost = false;
+    LOG(INFO) << "ShardRouter: Routing " << m_channels.size() << " channels to " << m_shardCount << " shards";
+    return true;
+}
+
+void ShardRouter::disconnect()
+{
+    m_connection->disconnect();
+}
+
+bool ShardRouter::isConnected()
+{
+    return m_connection->isConnected();
+}
+
+bool ShardRouter::hasLostConnection() const
+{
+    return m_connectionLost;
+}
+
+std::size_t ShardRouter::getShardCount() const
+{
+    return m_shardCount;
+}
+
+void ShardRouter::route(const std::string& channel, const std::string& message)
+{
+    const auto deviceKey = DeviceShard::deviceKeyOf(channel);
+    const auto shard = deviceKey.empty() ? 0 : DeviceShard::of(deviceKey, m_shardCount);
+
+    if (!m_connection->publish(std::make_shared<Message>(message, DeviceShard::channelPrefix(shard) + channel)))
+    {
+        GATEWAY_LOG(WARN) << "ShardRouter: Unable to route message on channel '" << channel << "' to shard " << shard;
+        m_failedMessages.increment();
+        return;
+    }
+
+    m_routedMessages.increment();
+}
+
+ShardRouter::ConnectionListener::ConnectionListener(ShardRouter& router) : m_router{router} {}
+
+void ShardRouter::ConnectionListener::messageReceived(const std::string& channel, const std::string& message)
+{
+    // broad filters would also match messages router has already republished
+    if (channel.compare(0, DeviceShard::CHANNEL_PREFIX.size(), DeviceShard::CHANNEL_PREFIX) == 0)
+    {
+        return;
+    }
+
+    ShardRouter& router = m_router;
+    router.m_executor.post([&router, channel, message] { router.route(channel, message); });
+}
+
+void ShardRouter::ConnectionListener::connectionLost()
+{
+    LOG(WARN) << "ShardRouter: Connection to local broker lost";
+    m_router.m_connectionLost = true;
+}
+
+std::vector<std::string> ShardRouter::ConnectionListener::getChannels() const
+{
+    return m_router.m_channels;
+}
+}    // namespace wolkabout
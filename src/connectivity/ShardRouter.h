@@ -0,0 +1,98 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHARDROUTER_H
+#define SHARDROUTER_H
+
+#include "connectivity/ConnectivityService.h"
+#include "utilities/Executor.h"
+#include "utilities/Metrics.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Front of sharded gateway, republishing messages of subdevices to the worker owning them
+ *
+ * Subscribes to device channels on local broker and republishes every message below prefix
+ * of the shard owning its device, see wolkabout::DeviceShard, where wolkabout::ShardConnectivityService
+ * of that worker receives it. Messages are republished in order in which they arrived, from a single thread,
+ * since publishing from broker callbacks is not allowed.
+ * Messages to devices are published by workers directly, router does not handle them.
+ */
+class ShardRouter
+{
+public:
+    /**
+     * @param connection Local broker connection of router, with its own client id
+     * @param channels Device channels to route, as subscribed by a gateway that is not sharded
+     * @param shardCount Number of worker processes
+     */
+    ShardRouter(std::unique_ptr<ConnectivityService> connection, std::vector<std::string> channels,
+                std::size_t shardCount);
+    ~ShardRouter();
+
+    ShardRouter(const ShardRouter&) = delete;
+    ShardRouter& operator=(const ShardRouter&) = delete;
+
+    bool connect();
+    void disconnect();
+    bool isConnected();
+
+    /**
+     * @brief Whether connection was lost since last successful connect
+     */
+    bool hasLostConnection() const;
+
+    std::size_t getShardCount() const;
+
+private:
+    class ConnectionListener : public ConnectivityServiceListener
+    {
+    public:
+        explicit ConnectionListener(ShardRouter& router);
+
+        void messageReceived(const std::string& channel, const std::string& message) override;
+        void connectionLost() override;
+        std::vector<std::string> getChannels() const override;
+
+    private:
+        ShardRouter& m_router;
+    };
+
+    void route(const std::string& channel, const std::string& message);
+
+    const std::unique_ptr<ConnectivityService> m_connection;
+    const std::vector<std::string> m_channels;
+    const std::size_t m_shardCount;
+
+    std::atomic_bool m_connectionLost;
+    std::shared_ptr<ConnectionListener> m_connectionListener;
+
+    Counter& m_routedMessages;
+    Counter& m_failedMessages;
+
+    // declared last so that queued routing is dropped before members it uses are destroyed
+    Executor m_executor;
+};
+}    // namespace wolkabout
+
+#endif    // SHARDROUTER_H
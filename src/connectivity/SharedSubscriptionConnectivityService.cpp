@@ -0,0 +1,151 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "connectivity/SharedSubscriptionConnectivityService.h"
+#include "utilities/GatewayLog.h"
+
+#include <utility>
+
+namespace wolkabout
+{
+const std::string SharedSubscriptionConnectivityService::SHARED_SUBSCRIPTION_PREFIX = "$share/";
+
+SharedSubscriptionConnectivityService::SharedSubscriptionConnectivityService(
+  std::vector<std::unique_ptr<ConnectivityService>> connections, std::string shareGroup)
+: m_connections{std::move(connections)}
+, m_shareGroup{std::move(shareGroup)}
+, m_connectionListener{std::make_shared<ConnectionListener>(*this)}
+{
+    for (const auto& connection : m_connections)
+    {
+        connection->setListener(m_connectionListener);
+    }
+}
+
+bool SharedSubscriptionConnectivityService::connect()
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    bool connected = true;
+    for (std::size_t i = 0; i < m_connections.size(); ++i)
+    {
+        if (!m_connections[i]->isConnected() && !m_connections[i]->connect())
+        {
+            GATEWAY_LOG(DEBUG) << "SharedSubscriptionConnectivityService: Connection " << i << " failed";
+            connected = false;
+        }
+    }
+
+    return connected;
+}
+
+void SharedSubscriptionConnectivityService::disconnect()
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    for (const auto& connection : m_connections)
+    {
+        connection->disconnect();
+    }
+}
+
+bool SharedSubscriptionConnectivityService::reconnect()
+{
+    disconnect();
+    return connect();
+}
+
+bool SharedSubscriptionConnectivityService::isConnected()
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    for (const auto& connection : m_connections)
+    {
+        if (!connection->isConnected())
+        {
+            return false;
+        }
+    }
+
+    return !m_connections.empty();
+}
+
+bool SharedSubscriptionConnectivityService::publish(std::shared_ptr<Message> outboundMessage, bool persistent)
+{
+    // publishers are not serialized with connect, connections are never added or removed after construction
+    for (const auto& connection : m_connections)
+    {
+        if (connection->isConnected())
+        {
+            return connection->publish(outboundMessage, persistent);
+        }
+    }
+
+    return false;
+}
+
+void SharedSubscriptionConnectivityService::setUncontrolledDisonnectMessage(std::shared_ptr<Message> outboundMessage,
+                                                                            bool persistent)
+{
+    for (const auto& connection : m_connections)
+    {
+        connection->setUncontrolledDisonnectMessage(outboundMessage, persistent);
+    }
+}
+
+std::size_t SharedSubscriptionConnectivityService::getConnectionCount() const
+{
+    return m_connections.size();
+}
+
+SharedSubscriptionConnectivityService::ConnectionListener::ConnectionListener(
+  SharedSubscriptionConnectivityService& service)
+: m_service{service}
+{
+}
+
+void SharedSubscriptionConnectivityService::ConnectionListener::messageReceived(const std::string& channel,
+                                                                                const std::string& message)
+{
+    // broker delivers shared subscription messages on their original topic
+    if (auto listener = m_service.m_listener.lock())
+    {
+        listener->messageReceived(channel, message);
+    }
+}
+
+void SharedSubscriptionConnectivityService::ConnectionListener::connectionLost()
+{
+    if (auto listener = m_service.m_listener.lock())
+    {
+        listener->connectionLost();
+    }
+}
+
+std::vector<std::string> SharedSubscriptionConnectivityService::ConnectionListener::getChannels() const
+{
+    std::vector<std::string> channels;
+    if (auto listener = m_service.m_listener.lock())
+    {
+        for (const auto& channel : listener->getChannels())
+        {
+            channels.push_back(SHARED_SUBSCRIPTION_PREFIX + m_service.m_shareGroup + "/" + channel);
+        }
+    }
+
+    return channels;
+}
+}    // namespace wolkabout
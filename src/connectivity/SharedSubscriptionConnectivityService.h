@@ -0,0 +1,89 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHAREDSUBSCRIPTIONCONNECTIVITYSERVICE_H
+#define SHAREDSUBSCRIPTIONCONNECTIVITYSERVICE_H
+
+#include "connectivity/ConnectivityService.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief wolkabout::ConnectivityService spreading subscriptions over several broker connections
+ *
+ * Every connection subscribes to channels of the listener as MQTT shared subscriptions
+ * ("$share/<group>/<channel>"), so broker delivers each message to only one of them and
+ * connections receive messages in parallel. Broker does not keep messages of one device on the same connection,
+ * so messages arriving on different connections are not ordered with respect to each other.
+ * Messages are published over the first connected connection.
+ */
+class SharedSubscriptionConnectivityService : public ConnectivityService
+{
+public:
+    /**
+     * @param connections Broker connections, each with its own client id
+     * @param shareGroup Name of shared subscription group, same for all connections
+     */
+    SharedSubscriptionConnectivityService(std::vector<std::unique_ptr<ConnectivityService>> connections,
+                                          std::string shareGroup);
+
+    /**
+     * @brief Connects connections that are not connected
+     * @return true if all connections are connected
+     */
+    bool connect() override;
+    void disconnect() override;
+    bool reconnect();
+    bool isConnected() override;
+
+    bool publish(std::shared_ptr<Message> outboundMessage, bool persistent = false) override;
+
+    void setUncontrolledDisonnectMessage(std::shared_ptr<Message> outboundMessage, bool persistent = false) override;
+
+    std::size_t getConnectionCount() const;
+
+    static const std::string SHARED_SUBSCRIPTION_PREFIX;
+
+private:
+    class ConnectionListener : public ConnectivityServiceListener
+    {
+    public:
+        explicit ConnectionListener(SharedSubscriptionConnectivityService& service);
+
+        void messageReceived(const std::string& channel, const std::string& message) override;
+        void connectionLost() override;
+        std::vector<std::string> getChannels() const override;
+
+    private:
+        SharedSubscriptionConnectivityService& m_service;
+    };
+
+    std::vector<std::unique_ptr<ConnectivityService>> m_connections;
+    const std::string m_shareGroup;
+
+    std::shared_ptr<ConnectionListener> m_connectionListener;
+
+    std::mutex m_lock;
+};
+}    // namespace wolkabout
+
+#endif    // SHAREDSUBSCRIPTIONCONNECTIVITYSERVICE_H
@@ -0,0 +1,147 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "connectivity/UplinkConnectivityService.h"
+#include "utilities/GatewayLog.h"
+
+#include <stdexcept>
+#include <utility>
+
+namespace wolkabout
+{
+UplinkConnectivityService::UplinkConnectivityService(std::vector<std::unique_ptr<ConnectivityService>> connections)
+: m_connections{std::move(connections)}
+, m_primaryListener{std::make_shared<ConnectionListener>(*this, true)}
+, m_secondaryListener{std::make_shared<ConnectionListener>(*this, false)}
+{
+    if (m_connections.empty())
+    {
+        throw std::invalid_argument("At least one connection is required");
+    }
+
+    for (std::size_t i = 0; i < m_connections.size(); ++i)
+    {
+        m_connections[i]->setListener(i == 0 ? m_primaryListener : m_secondaryListener);
+    }
+}
+
+bool UplinkConnectivityService::connect()
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    bool connected = true;
+    for (std::size_t i = 0; i < m_connections.size(); ++i)
+    {
+        if (!m_connections[i]->isConnected() && !m_connections[i]->connect())
+        {
+            GATEWAY_LOG(DEBUG) << "UplinkConnectivityService: Connection " << i << " failed";
+            connected = false;
+        }
+    }
+
+    return connected;
+}
+
+void UplinkConnectivityService::disconnect()
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    for (const auto& connection : m_connections)
+    {
+        connection->disconnect();
+    }
+}
+
+bool UplinkConnectivityService::reconnect()
+{
+    disconnect();
+    return connect();
+}
+
+bool UplinkConnectivityService::isConnected()
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    for (const auto& connection : m_connections)
+    {
+        if (!connection->isConnected())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool UplinkConnectivityService::publish(std::shared_ptr<Message> outboundMessage, bool persistent)
+{
+    return m_connections.front()->publish(outboundMessage, persistent);
+}
+
+void UplinkConnectivityService::setUncontrolledDisonnectMessage(std::shared_ptr<Message> outboundMessage,
+                                                                bool persistent)
+{
+    m_connections.front()->setUncontrolledDisonnectMessage(outboundMessage, persistent);
+}
+
+ConnectivityService& UplinkConnectivityService::getConnection(std::size_t index)
+{
+    return *m_connections.at(index);
+}
+
+std::size_t UplinkConnectivityService::getConnectionCount() const
+{
+    return m_connections.size();
+}
+
+UplinkConnectivityService::ConnectionListener::ConnectionListener(UplinkConnectivityService& service, bool primary)
+: m_service{service}, m_primary{primary}
+{
+}
+
+void UplinkConnectivityService::ConnectionListener::messageReceived(const std::string& channel,
+                                                                    const std::string& message)
+{
+    if (auto listener = m_service.m_listener.lock())
+    {
+        listener->messageReceived(channel, message);
+    }
+}
+
+void UplinkConnectivityService::ConnectionListener::connectionLost()
+{
+    if (auto listener = m_service.m_listener.lock())
+    {
+        listener->connectionLost();
+    }
+}
+
+std::vector<std::string> UplinkConnectivityService::ConnectionListener::getChannels() const
+{
+    // subscribing on every connection would deliver each platform message once per connection
+    if (!m_primary)
+    {
+        return {};
+    }
+
+    if (auto listener = m_service.m_listener.lock())
+    {
+        return listener->getChannels();
+    }
+
+    return {};
+}
+}    // namespace wolkabout
@@ -0,0 +1,86 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UPLINKCONNECTIVITYSERVICE_H
+#define UPLINKCONNECTIVITYSERVICE_H
+
+#include "connectivity/ConnectivityService.h"
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief wolkabout::ConnectivityService managing several connections to the same broker as one
+ *
+ * First connection is primary: it subscribes to channels of the listener, carries last will
+ * and is used by publish(). Other connections only publish, through wolkabout::PublishingService partitions
+ * given them by getConnection(). Losing any connection is reported to the listener as lost connection,
+ * and connect() reconnects connections that are down.
+ */
+class UplinkConnectivityService : public ConnectivityService
+{
+public:
+    /**
+     * @param connections Broker connections, each with its own client id, at least one
+     */
+    explicit UplinkConnectivityService(std::vector<std::unique_ptr<ConnectivityService>> connections);
+
+    /**
+     * @brief Connects connections that are not connected
+     * @return true if all connections are connected
+     */
+    bool connect() override;
+    void disconnect() override;
+    bool reconnect();
+    bool isConnected() override;
+
+    bool publish(std::shared_ptr<Message> outboundMessage, bool persistent = false) override;
+
+    void setUncontrolledDisonnectMessage(std::shared_ptr<Message> outboundMessage, bool persistent = false) override;
+
+    ConnectivityService& getConnection(std::size_t index);
+    std::size_t getConnectionCount() const;
+
+private:
+    class ConnectionListener : public ConnectivityServiceListener
+    {
+    public:
+        ConnectionListener(UplinkConnectivityService& service, bool primary);
+
+        void messageReceived(const std::string& channel, const std::string& message) override;
+        void connectionLost() override;
+        std::vector<std::string> getChannels() const override;
+
+    private:
+        UplinkConnectivityService& m_service;
+        const bool m_primary;
+    };
+
+    std::vector<std::unique_ptr<ConnectivityService>> m_connections;
+
+    std::shared_ptr<ConnectionListener> m_primaryListener;
+    std::shared_ptr<ConnectionListener> m_secondaryListener;
+
+    std::mutex m_lock;
+};
+}    // namespace wolkabout
+
+#endif    // UPLINKCONNECTIVITYSERVICE_H
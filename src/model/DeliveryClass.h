@@ -0,0 +1,35 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DELIVERYCLASS_H
+#define DELIVERYCLASS_H
+
+namespace wolkabout
+{
+/**
+ * @brief Guarantee with which outbound message is delivered
+ *
+ * AT_MOST_ONCE messages, such as periodic sensor readings superseded by the next one, are published once
+ * and dropped if publish fails. AT_LEAST_ONCE messages stay queued and are retried until they are published.
+ */
+enum class DeliveryClass
+{
+    AT_MOST_ONCE,
+    AT_LEAST_ONCE
+};
+}    // namespace wolkabout
+
+#endif    // DELIVERYCLASS_H
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/DeviceReferences.h"
+#include "model/DetailedDevice.h"
+
+#include <utility>
+
+namespace wolkabout
+{
+const std::string DeviceReferences::PAYLOAD_ENCODING_PARAMETER = "payload_encoding";
+const std::string DeviceReferences::MESSAGE_PACK_ENCODING = "msgpack";
+
+DeviceReferences::DeviceReferences(const DetailedDevice& device) : DeviceReferences(device.getTemplate()) {}
+
+DeviceReferences::DeviceReferences(const DeviceTemplate& deviceTemplate)
+{
+    for (const auto& sensorTemplate : deviceTemplate.getSensors())
+    {
+        const auto& minimum = sensorTemplate.getMinimum();
+        const auto& maximum = sensorTemplate.getMaximum();
+        m_sensors[sensorTemplate.getReference()] = minimum && maximum ? maximum.value() - minimum.value() : 0;
+    }
+
+    for (const auto& alarmTemplate : deviceTemplate.getAlarms())
+    {
+        m_alarms.insert(alarmTemplate.getReference());
+    }
+
+    for (const auto& actuatorTemplate : deviceTemplate.getActuators())
+    {
+        m_actuators.insert(actuatorTemplate.getReference());
+    }
+
+    for (const auto& parameter : deviceTemplate.getConnectivityParameters())
+    {
+        if (parameter.first == PAYLOAD_ENCODING_PARAMETER && parameter.second == MESSAGE_PACK_ENCODING)
+        {
+            m_payloadEncoding = PayloadEncoding::MESSAGE_PACK;
+        }
+    }
+}
+
+DeviceReferences::DeviceReferences(std::unordered_map<std::string, double> sensorRanges,
+                                   std::unordered_set<std::string> alarms, std::unordered_set<std::string> actuators,
+                                   PayloadEncoding payloadEncoding)
+: m_sensors{std::move(sensorRanges)}
+, m_alarms{std::move(alarms)}
+, m_actuators{std::move(actuators)}
+, m_payloadEncoding{payloadEncoding}
+{
+}
+
+bool DeviceReferences::hasSensor(const std::string& reference) const
+{
+    return m_sensors.find(reference) != m_sensors.end();
+}
+
+bool DeviceReferences::hasAlarm(const std::string& reference) const
+{
+    return m_alarms.find(reference) != m_alarms.end();
+}
+
+bool DeviceReferences::hasActuator(const std::string& reference) const
+{
+    return m_actuators.find(reference) != m_actuators.end();
+}
+
+const std::unordered_map<std::string, double>& DeviceReferences::getSensorRanges() const
+{
+    return m_sensors;
+}
+
+const std::unordered_set<std::string>& DeviceReferences::getAlarms() const
+{
+    return m_alarms;
+}
+
+const std::unordered_set<std::string>& DeviceReferences::getActuators() const
+{
+    return m_actuators;
+}
+
+double DeviceReferences::getSensorRange(const std::string& reference) const
+{
+    auto it = m_sensors.find(reference);
+    return it != m_sensors.end() ? it->second : 0;
+}
+
+DeviceReferences::PayloadEncoding DeviceReferences::getPayloadEncoding() const
+{
+    return m_payloadEncoding;
+}
+}    // namespace wolkabout
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DEVICEREFERENCES_H
+#define DEVICEREFERENCES_H
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace wolkabout
+{
+class DetailedDevice;
+class DeviceTemplate;
+
+/**
+ * @brief Compact view of device template, used for validation and decoding of device messages
+ */
+class DeviceReferences
+{
+public:
+    /**
+     * @brief Encoding of payloads device publishes on the local bus,
+     * taken from "payload_encoding" connectivity parameter of device template
+     */
+    enum class PayloadEncoding
+    {
+        JSON,
+        MESSAGE_PACK
+    };
+
+    static const std::string PAYLOAD_ENCODING_PARAMETER;
+    static const std::string MESSAGE_PACK_ENCODING;
+
+    DeviceReferences() = default;
+    explicit DeviceReferences(const DetailedDevice& device);
+    explicit DeviceReferences(const DeviceTemplate& deviceTemplate);
+    DeviceReferences(std::unordered_map<std::string, double> sensorRanges, std::unordered_set<std::string> alarms,
+                     std::unordered_set<std::string> actuators, PayloadEncoding payloadEncoding);
+
+    bool hasSensor(const std::string& reference) const;
+    bool hasAlarm(const std::string& reference) const;
+    bool hasActuator(const std::string& reference) const;
+
+    const std::unordered_map<std::string, double>& getSensorRanges() const;
+    const std::unordered_set<std::string>& getAlarms() const;
+    const std::unordered_set<std::string>& getActuators() const;
+
+    /**
+     * @brief Returns difference between sensor maximum and minimum, 0 if template does not define both
+     */
+    double getSensorRange(const std::string& reference) const;
+
+    PayloadEncoding getPayloadEncoding() const;
+
+private:
+    // reference to range
+    std::unordered_map<std::string, double> m_sensors;
+    std::unordered_set<std::string> m_alarms;
+    std::unordered_set<std::string> m_actuators;
+
+    PayloadEncoding m_payloadEncoding = PayloadEncoding::JSON;
+};
+}    // namespace wolkabout
+
+#endif    // DEVICEREFERENCES_H
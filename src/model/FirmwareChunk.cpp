@@ -0,0 +1,63 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/FirmwareChunk.h"
+
+#include <utility>
+
+namespace wolkabout
+{
+FirmwareChunk::FirmwareChunk(std::string deviceKey, std::uint64_t index, const std::uint8_t* data, std::size_t size,
+                             const ByteArray& previousHash, const ByteArray& hash)
+: m_deviceKey{std::move(deviceKey)}
+, m_index{index}
+, m_data{data}
+, m_size{size}
+, m_previousHash{previousHash}
+, m_hash{hash}
+{
+}
+
+const std::string& FirmwareChunk::getDeviceKey() const
+{
+    return m_deviceKey;
+}
+
+std::uint64_t FirmwareChunk::getIndex() const
+{
+    return m_index;
+}
+
+const std::uint8_t* FirmwareChunk::getData() const
+{
+    return m_data;
+}
+
+std::size_t FirmwareChunk::getSize() const
+{
+    return m_size;
+}
+
+const ByteArray& FirmwareChunk::getPreviousHash() const
+{
+    return m_previousHash;
+}
+
+const ByteArray& FirmwareChunk::getHash() const
+{
+    return m_hash;
+}
+}    // namespace wolkabout
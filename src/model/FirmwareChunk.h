@@ -0,0 +1,67 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRMWARECHUNK_H
+#define FIRMWARECHUNK_H
+
+#include "utilities/ByteUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * @brief View of one chunk of firmware file being sent to subdevice
+ *
+ * Does not own chunk data nor hashes, they must outlive the chunk.
+ * Chunk shorter than chunk size of file is the last one.
+ */
+class FirmwareChunk
+{
+public:
+    /**
+     * @param previousHash Hash of preceding chunk, empty for the first chunk
+     */
+    FirmwareChunk(std::string deviceKey, std::uint64_t index, const std::uint8_t* data, std::size_t size,
+                  const ByteArray& previousHash, const ByteArray& hash);
+
+    const std::string& getDeviceKey() const;
+
+    std::uint64_t getIndex() const;
+
+    const std::uint8_t* getData() const;
+
+    std::size_t getSize() const;
+
+    const ByteArray& getPreviousHash() const;
+
+    const ByteArray& getHash() const;
+
+private:
+    std::string m_deviceKey;
+    std::uint64_t m_index;
+
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+
+    const ByteArray& m_previousHash;
+    const ByteArray& m_hash;
+};
+}    // namespace wolkabout
+
+#endif    // FIRMWARECHUNK_H
@@ -0,0 +1,42 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/FirmwareChunkRequest.h"
+
+#include <utility>
+
+namespace wolkabout
+{
+FirmwareChunkRequest::FirmwareChunkRequest(std::string deviceKey, std::string fileName, std::uint64_t chunkIndex)
+: m_deviceKey{std::move(deviceKey)}, m_fileName{std::move(fileName)}, m_chunkIndex{chunkIndex}
+{
+}
+
+const std::string& FirmwareChunkRequest::getDeviceKey() const
+{
+    return m_deviceKey;
+}
+
+const std::string& FirmwareChunkRequest::getFileName() const
+{
+    return m_fileName;
+}
+
+std::uint64_t FirmwareChunkRequest::getChunkIndex() const
+{
+    return m_chunkIndex;
+}
+}    // namespace wolkabout
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRMWARECHUNKREQUEST_H
+#define FIRMWARECHUNKREQUEST_H
+
+#include <cstdint>
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * @brief Request of subdevice for one chunk of firmware file it was commanded to install
+ */
+class FirmwareChunkRequest
+{
+public:
+    FirmwareChunkRequest(std::string deviceKey, std::string fileName, std::uint64_t chunkIndex);
+
+    const std::string& getDeviceKey() const;
+
+    /**
+     * @brief Name of file as sent to device in install command
+     */
+    const std::string& getFileName() const;
+
+    std::uint64_t getChunkIndex() const;
+
+private:
+    std::string m_deviceKey;
+    std::string m_fileName;
+    std::uint64_t m_chunkIndex;
+};
+}    // namespace wolkabout
+
+#endif    // FIRMWARECHUNKREQUEST_H
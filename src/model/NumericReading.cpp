@@ -0,0 +1,83 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/NumericReading.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace wolkabout
+{
+constexpr std::size_t NumericReading::INLINE_VALUES;
+
+NumericReading::NumericReading() : m_inlineValues{}, m_size{0}, m_rtc{0} {}
+
+NumericReading::NumericReading(std::string reference, double value, unsigned long long int rtc)
+: m_reference{std::move(reference)}, m_inlineValues{}, m_size{0}, m_rtc{rtc}
+{
+    assign(&value, 1);
+}
+
+NumericReading::NumericReading(std::string reference, std::initializer_list<double> values, unsigned long long int rtc)
+: m_reference{std::move(reference)}, m_inlineValues{}, m_size{0}, m_rtc{rtc}
+{
+    assign(values.begin(), values.size());
+}
+
+NumericReading::NumericReading(std::string reference, const double* values, std::size_t count,
+                               unsigned long long int rtc)
+: m_reference{std::move(reference)}, m_inlineValues{}, m_size{0}, m_rtc{rtc}
+{
+    assign(values, count);
+}
+
+const std::string& NumericReading::getReference() const
+{
+    return m_reference;
+}
+
+std::size_t NumericReading::getSize() const
+{
+    return m_size;
+}
+
+const double* NumericReading::getValues() const
+{
+    return m_size > INLINE_VALUES ? m_values.data() : m_inlineValues.data();
+}
+
+unsigned long long int NumericReading::getRtc() const
+{
+    return m_rtc;
+}
+
+void NumericReading::setRtc(unsigned long long int rtc)
+{
+    m_rtc = rtc;
+}
+
+void NumericReading::assign(const double* values, std::size_t count)
+{
+    m_size = count;
+    if (count > INLINE_VALUES)
+    {
+        m_values.assign(values, values + count);
+        return;
+    }
+
+    std::copy(values, values + count, m_inlineValues.begin());
+}
+}    // namespace wolkabout
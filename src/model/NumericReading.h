@@ -0,0 +1,69 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef NUMERICREADING_H
+#define NUMERICREADING_H
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Sensor reading with numeric values, kept as numbers until the reading is serialized
+ *
+ * Up to INLINE_VALUES values are stored in the reading itself, so single and few-value readings
+ * do not allocate beyond reference.
+ */
+class NumericReading
+{
+public:
+    static constexpr std::size_t INLINE_VALUES = 4;
+
+    NumericReading();
+    NumericReading(std::string reference, double value, unsigned long long int rtc = 0);
+    NumericReading(std::string reference, std::initializer_list<double> values, unsigned long long int rtc = 0);
+    NumericReading(std::string reference, const double* values, std::size_t count, unsigned long long int rtc = 0);
+
+    const std::string& getReference() const;
+
+    std::size_t getSize() const;
+    const double* getValues() const;
+
+    /**
+     * @brief Returns reading POSIX time in milliseconds, 0 if time is taken when reading is submitted
+     */
+    unsigned long long int getRtc() const;
+    void setRtc(unsigned long long int rtc);
+
+private:
+    void assign(const double* values, std::size_t count);
+
+    std::string m_reference;
+
+    std::array<double, INLINE_VALUES> m_inlineValues;
+    // holds values only when there are more than INLINE_VALUES of them
+    std::vector<double> m_values;
+    std::size_t m_size;
+
+    unsigned long long int m_rtc;
+};
+}    // namespace wolkabout
+
+#endif    // NUMERICREADING_H
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/PerformanceProfile.h"
+
+namespace wolkabout
+{
+PerformanceProfile PerformanceProfile::constrainedEdge()
+{
+    PerformanceProfile profile;
+
+    profile.outboundQueueMaximumMessages = 2000;
+    profile.outboundQueueMaximumBytes = 2 * 1024 * 1024;
+    profile.publishBatchSize = 8;
+
+    profile.readingAggregationWindow = std::chrono::milliseconds{1000};
+    profile.readingAggregationMaxReadings = 100;
+    profile.statusUpdateCoalescingWindow = std::chrono::milliseconds{1000};
+    profile.statusPollingBuckets = 4;
+
+    profile.registrationRetryTimeout = std::chrono::milliseconds{10000};
+    profile.maxFilePacketSize = 256 * 1024;
+    profile.filePacketRequestTimeout = std::chrono::milliseconds{10000};
+    profile.reconnectInitialDelay = std::chrono::milliseconds{5000};
+    profile.reconnectMaximumDelay = std::chrono::milliseconds{300000};
+
+    profile.memoryBudget = 32 * 1024 * 1024;
+
+    return profile;
+}
+
+PerformanceProfile PerformanceProfile::largeFleet()
+{
+    PerformanceProfile profile;
+
+    profile.outboundQueueMaximumMessages = 500000;
+    profile.outboundQueueMaximumBytes = 512 * 1024 * 1024;
+    profile.publishBatchSize = 128;
+
+    profile.inboundDeviceMessageWorkers = 8;
+
+    profile.readingAggregationWindow = std::chrono::milliseconds{200};
+    profile.readingAggregationMaxReadings = 500;
+    profile.statusUpdateCoalescingWindow = std::chrono::milliseconds{500};
+    profile.statusPollingBuckets = 32;
+    profile.filePacketRequestWindow = 8;
+    profile.concurrentFileTransfers = 4;
+
+    profile.statusResponseTimeout = std::chrono::seconds{10};
+    profile.registrationRetryCount = 5;
+    profile.registrationRetryTimeout = std::chrono::milliseconds{10000};
+
+    return profile;
+}
+}    // namespace wolkabout
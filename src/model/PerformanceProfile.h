@@ -0,0 +1,77 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PERFORMANCEPROFILE_H
+#define PERFORMANCEPROFILE_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace wolkabout
+{
+/**
+ * @brief Sizes, windows and timeouts which trade memory and latency for throughput
+ *
+ * Default constructed profile holds values wolkabout::WolkBuilder uses when nothing is set.
+ * Presets are starting points, fields can be adjusted before profile is passed to
+ * wolkabout::WolkBuilder::performanceProfile.
+ */
+struct PerformanceProfile
+{
+    // outbound queue, 0 for no limit
+    std::size_t outboundQueueMaximumMessages = 0;
+    std::uint64_t outboundQueueMaximumBytes = 0;
+    std::size_t publishBatchSize = 16;
+
+    std::size_t inboundDeviceMessageWorkers = 1;
+
+    // windows, 0 handles each item immediately
+    std::chrono::milliseconds readingAggregationWindow{0};
+    std::size_t readingAggregationMaxReadings = 0;
+    std::chrono::milliseconds statusUpdateCoalescingWindow{0};
+    std::size_t statusPollingBuckets = 1;
+    unsigned filePacketRequestWindow = 1;
+    std::size_t concurrentFileTransfers = 1;
+
+    // timeouts
+    std::chrono::seconds keepAliveInterval{600};
+    std::chrono::seconds statusResponseTimeout{5};
+    short registrationRetryCount = 3;
+    std::chrono::milliseconds registrationRetryTimeout{5000};
+    std::uint64_t maxFilePacketSize = 10 * 1024 * 1024;
+    std::chrono::milliseconds filePacketRequestTimeout{6000};
+    std::chrono::milliseconds reconnectInitialDelay{2000};
+    std::chrono::milliseconds reconnectMaximumDelay{60000};
+
+    // bytes held by all queues and buffers together, 0 for no limit
+    std::uint64_t memoryBudget = 0;
+
+    /**
+     * @brief Small bounded queues and packets, and batching of readings and status updates,
+     * for gateways with little memory behind slow or metered links
+     */
+    static PerformanceProfile constrainedEdge();
+
+    /**
+     * @brief Large queues and batches, parallel handling of device messages and staggered status polling,
+     * for gateways serving thousands of subdevices
+     */
+    static PerformanceProfile largeFleet();
+};
+}    // namespace wolkabout
+
+#endif    // PERFORMANCEPROFILE_H
@@ -0,0 +1,616 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "persistence/CompressedReadingPersistence.h"
+#include "model/Message.h"
+#include "utilities/JsonReader.h"
+#include "utilities/JsonWriter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+const std::string UTC_KEY = "utc";
+const std::string DATA_KEY = "data";
+
+const unsigned NO_WINDOW = 64;
+
+class BitReader
+{
+public:
+    explicit BitReader(const std::vector<std::uint8_t>& data) : m_data{data}, m_position{0} {}
+
+    std::uint64_t read(unsigned count)
+    {
+        std::uint64_t value = 0;
+        for (unsigned i = 0; i < count; ++i)
+        {
+            const bool bit = (m_data[m_position / 8] & (0x80 >> (m_position % 8))) != 0;
+            value = value << 1 | (bit ? 1u : 0u);
+            ++m_position;
+        }
+
+        return value;
+    }
+
+    bool readBit() { return read(1) != 0; }
+
+private:
+    const std::vector<std::uint8_t>& m_data;
+    std::size_t m_position;
+};
+
+unsigned leadingZeros(std::uint64_t value)
+{
+    unsigned count = 0;
+    for (std::uint64_t mask = 1ull << 63; mask != 0 && (value & mask) == 0; mask >>= 1)
+    {
+        ++count;
+    }
+
+    return count;
+}
+
+unsigned trailingZeros(std::uint64_t value)
+{
+    unsigned count = 0;
+    for (std::uint64_t mask = 1; mask != 0 && (value & mask) == 0; mask <<= 1)
+    {
+        ++count;
+    }
+
+    return count;
+}
+
+std::uint64_t toBits(double value)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+double fromBits(std::uint64_t bits)
+{
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::string trim(const std::string& text)
+{
+    const auto begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string::npos)
+    {
+        return "";
+    }
+
+    return text.substr(begin, text.find_last_not_of(" \t\r\n") - begin + 1);
+}
+
+bool parseUtc(const std::string& text, std::uint64_t& utc)
+{
+    if (text.empty() || text.size() > 19 || text.find_first_not_of("0123456789") != std::string::npos)
+    {
+        return false;
+    }
+
+    utc = std::strtoull(text.c_str(), nullptr, 10);
+    return true;
+}
+
+bool parseValue(const std::string& text, double& value)
+{
+    if (text.empty())
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    if (end != text.c_str() + text.size() || !std::isfinite(value))
+    {
+        return false;
+    }
+
+    // replayed payload writes value in shortest form, other forms would not come back as sent
+    std::string shortest;
+    wolkabout::JsonWriter::appendNumber(shortest, value);
+    return shortest == text;
+}
+}    // namespace
+
+namespace wolkabout
+{
+const std::size_t CompressedReadingPersistence::DEFAULT_READINGS_PER_MESSAGE = 100;
+
+CompressedReadingPersistence::Block::Block()
+: m_bitCount{0}
+, m_size{0}
+, m_lastUtc{0}
+, m_lastDelta{0}
+, m_lastValue{0}
+, m_leadingZeros{NO_WINDOW}
+, m_trailingZeros{0}
+{
+}
+
+void CompressedReadingPersistence::Block::append(const Reading& reading)
+{
+    const std::uint64_t bits = toBits(reading.value);
+    if (m_size == 0)
+    {
+        writeBits(reading.utc, 64);
+        writeBits(bits, 64);
+    }
+    else
+    {
+        writeTimestamp(reading.utc);
+        writeValue(bits);
+    }
+
+    m_lastUtc = reading.utc;
+    m_lastValue = bits;
+    ++m_size;
+}
+
+std::vector<CompressedReadingPersistence::Reading> CompressedReadingPersistence::Block::decode() const
+{
+    std::vector<Reading> readings;
+    readings.reserve(m_size);
+
+    BitReader reader{m_data};
+    std::uint64_t utc = 0;
+    std::uint64_t delta = 0;
+    std::uint64_t value = 0;
+    unsigned leading = 0;
+    unsigned trailing = 0;
+    for (std::size_t i = 0; i < m_size; ++i)
+    {
+        if (i == 0)
+        {
+            utc = reader.read(64);
+            value = reader.read(64);
+            readings.push_back(Reading{utc, fromBits(value)});
+            continue;
+        }
+
+        std::uint64_t deltaOfDelta = 0;
+        if (reader.readBit())
+        {
+            if (!reader.readBit())
+            {
+                deltaOfDelta = reader.read(7) - 63;
+            }
+            else if (!reader.readBit())
+            {
+                deltaOfDelta = reader.read(9) - 255;
+            }
+            else if (!reader.readBit())
+            {
+                deltaOfDelta = reader.read(12) - 2047;
+            }
+            else
+            {
+                deltaOfDelta = reader.read(64);
+            }
+        }
+        delta += deltaOfDelta;
+        utc += delta;
+
+        if (reader.readBit())
+        {
+            if (reader.readBit())
+            {
+                leading = static_cast<unsigned>(reader.read(5));
+                const auto meaningful = static_cast<unsigned>(reader.read(6));
+                trailing = 64 - leading - (meaningful == 0 ? 64 : meaningful);
+            }
+
+            value ^= reader.read(64 - leading - trailing) << trailing;
+        }
+
+        readings.push_back(Reading{utc, fromBits(value)});
+    }
+
+    return readings;
+}
+
+std::size_t CompressedReadingPersistence::Block::size() const
+{
+    return m_size;
+}
+
+std::size_t CompressedReadingPersistence::Block::bytes() const
+{
+    return sizeof(Block) + m_data.capacity();
+}
+
+void CompressedReadingPersistence::Block::writeBits(std::uint64_t value, unsigned count)
+{
+    for (unsigned i = count; i > 0; --i)
+    {
+        if (m_bitCount % 8 == 0)
+        {
+            m_data.push_back(0);
+        }
+
+        if ((value >> (i - 1)) & 1)
+        {
+            m_data.back() = static_cast<std::uint8_t>(m_data.back() | (0x80 >> (m_bitCount % 8)));
+        }
+
+        ++m_bitCount;
+    }
+}
+
+void CompressedReadingPersistence::Block::writeTimestamp(std::uint64_t utc)
+{
+    // unsigned arithmetic wraps, so readings going back in time are encoded as negative deltas
+    const std::uint64_t delta = utc - m_lastUtc;
+    const auto deltaOfDelta = static_cast<std::int64_t>(delta - static_cast<std::uint64_t>(m_lastDelta));
+    m_lastDelta = static_cast<std::int64_t>(delta);
+
+    if (deltaOfDelta == 0)
+    {
+        writeBits(0, 1);
+    }
+    else if (deltaOfDelta >= -63 && deltaOfDelta <= 64)
+    {
+        writeBits(0x2, 2);
+        writeBits(static_cast<std::uint64_t>(deltaOfDelta + 63), 7);
+    }
+    else if (deltaOfDelta >= -255 && deltaOfDelta <= 256)
+    {
+        writeBits(0x6, 3);
+        writeBits(static_cast<std::uint64_t>(deltaOfDelta + 255), 9);
+    }
+    else if (deltaOfDelta >= -2047 && deltaOfDelta <= 2048)
+    {
+        writeBits(0xE, 4);
+        writeBits(static_cast<std::uint64_t>(deltaOfDelta + 2047), 12);
+    }
+    else
+    {
+        writeBits(0xF, 4);
+        writeBits(static_cast<std::uint64_t>(deltaOfDelta), 64);
+    }
+}
+
+void CompressedReadingPersistence::Block::writeValue(std::uint64_t bits)
+{
+    const std::uint64_t difference = bits ^ m_lastValue;
+    if (difference == 0)
+    {
+        writeBits(0, 1);
+        return;
+    }
+
+    writeBits(1, 1);
+
+    // leading zero count has 5 bits to be stored in
+    const unsigned leading = std::min(leadingZeros(difference), 31u);
+    const unsigned trailing = trailingZeros(difference);
+    if (m_leadingZeros != NO_WINDOW && leading >= m_leadingZeros && trailing >= m_trailingZeros)
+    {
+        writeBits(0, 1);
+        writeBits(difference >> m_trailingZeros, 64 - m_leadingZeros - m_trailingZeros);
+        return;
+    }
+
+    const unsigned meaningful = 64 - leading - trailing;
+    writeBits(1, 1);
+    writeBits(leading, 5);
+    // 64 meaningful bits do not fit in 6 bits and are written as 0
+    writeBits(meaningful == 64 ? 0 : meaningful, 6);
+    writeBits(difference >> trailing, meaningful);
+
+    m_leadingZeros = leading;
+    m_trailingZeros = trailing;
+}
+
+CompressedReadingPersistence::CompressedReadingPersistence(std::unique_ptr<GatewayPersistence> fallback,
+                                                           Classifier isSensorReading, std::size_t maximumBytes,
+                                                           std::size_t readingsPerMessage, const std::string& name)
+: m_fallback{std::move(fallback)}
+, m_isSensorReading{std::move(isSensorReading)}
+, m_maximumBytes{maximumBytes}
+, m_readingsPerMessage{std::max<std::size_t>(readingsPerMessage, 1)}
+, m_readingCount{0}
+, m_compressedBytes{0}
+, m_plannedFallback{0}
+, m_plannedMaterialized{0}
+, m_readings{MetricsRegistry::getInstance().gauge("wolkgateway_" + name + "_readings")}
+, m_bytes{MetricsRegistry::getInstance().gauge("wolkgateway_" + name + "_bytes")}
+, m_overflowReadings{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_overflow_total")}
+{
+}
+
+bool CompressedReadingPersistence::push(std::shared_ptr<Message> message)
+{
+    std::vector<Reading> readings;
+    if (!parse(*message, readings))
+    {
+        return m_fallback->push(std::move(message));
+    }
+
+    std::lock_guard<std::mutex> lg{m_lock};
+    if (m_maximumBytes != 0 && m_compressedBytes >= m_maximumBytes)
+    {
+        m_overflowReadings.increment(readings.size());
+        return m_fallback->push(std::move(message));
+    }
+
+    auto it = m_series.find(message->getChannel());
+    if (it == m_series.end())
+    {
+        it = m_series.emplace(message->getChannel(), Series{}).first;
+        m_order.push_back(message->getChannel());
+        m_compressedBytes += sizeof(Series) + message->getChannel().size();
+    }
+
+    auto& blocks = it->second.blocks;
+    for (const auto& reading : readings)
+    {
+        if (blocks.empty() || blocks.back().size() >= m_readingsPerMessage)
+        {
+            blocks.emplace_back();
+            m_compressedBytes += blocks.back().bytes();
+        }
+
+        const auto before = blocks.back().bytes();
+        blocks.back().append(reading);
+        m_compressedBytes += blocks.back().bytes() - before;
+    }
+
+    m_readingCount += readings.size();
+    m_readings.set(static_cast<std::int64_t>(m_readingCount));
+    m_bytes.set(static_cast<std::int64_t>(m_compressedBytes));
+    return true;
+}
+
+std::shared_ptr<Message> CompressedReadingPersistence::pop()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    const auto messages = plan(1);
+    if (messages.empty())
+    {
+        return nullptr;
+    }
+
+    drain(1);
+    return messages.front();
+}
+
+std::shared_ptr<Message> CompressedReadingPersistence::front()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    const auto messages = plan(1);
+    return messages.empty() ? nullptr : messages.front();
+}
+
+bool CompressedReadingPersistence::empty() const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return m_fallback->empty() && m_materialized.empty() && m_series.empty();
+}
+
+std::vector<std::shared_ptr<Message>> CompressedReadingPersistence::frontBatch(std::size_t count)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return plan(count);
+}
+
+std::size_t CompressedReadingPersistence::popBatch(std::size_t count)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    // messages already handed out by frontBatch must be the ones removed
+    if (m_plannedFallback + m_plannedMaterialized < count)
+    {
+        plan(count);
+    }
+
+    return drain(count);
+}
+
+std::size_t CompressedReadingPersistence::getReadingCount() const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return m_readingCount;
+}
+
+std::size_t CompressedReadingPersistence::getCompressedBytes() const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return m_compressedBytes;
+}
+
+bool CompressedReadingPersistence::parse(const Message& message, std::vector<Reading>& readings) const
+{
+    if (!m_isSensorReading(message))
+    {
+        return false;
+    }
+
+    const std::string& content = message.getContent();
+    const auto start = content.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos)
+    {
+        return false;
+    }
+
+    const auto now = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                                  std::chrono::system_clock::now().time_since_epoch())
+                                                  .count());
+
+    JsonReader reader{content};
+    const auto readReading = [&]() -> bool {
+        if (!reader.beginObject())
+        {
+            return false;
+        }
+
+        Reading reading{now, 0};
+        bool hasData = false;
+        std::string name;
+        std::string text;
+        while (reader.nextMember(name))
+        {
+            if (name == UTC_KEY)
+            {
+                const auto position = reader.getPosition();
+                if (!reader.skipValue() ||
+                    !parseUtc(trim(content.substr(position, reader.getPosition() - position)), reading.utc))
+                {
+                    return false;
+                }
+            }
+            else if (name == DATA_KEY)
+            {
+                if (!reader.readString(text) || !parseValue(text, reading.value))
+                {
+                    return false;
+                }
+                hasData = true;
+            }
+            else
+            {
+                return false;
+            }
+        }
+
+        if (reader.failed() || !hasData)
+        {
+            return false;
+        }
+
+        readings.push_back(reading);
+        return true;
+    };
+
+    if (content[start] == '[')
+    {
+        if (!reader.beginArray())
+        {
+            return false;
+        }
+
+        while (reader.nextElement())
+        {
+            if (!readReading())
+            {
+                return false;
+            }
+        }
+    }
+    else if (!readReading())
+    {
+        return false;
+    }
+
+    return reader.finish() && !readings.empty();
+}
+
+std::shared_ptr<Message> CompressedReadingPersistence::materialize()
+{
+    if (m_order.empty())
+    {
+        return nullptr;
+    }
+
+    const std::string channel = m_order.front();
+    m_order.pop_front();
+
+    auto it = m_series.find(channel);
+    auto& blocks = it->second.blocks;
+    const auto readings = blocks.front().decode();
+    m_compressedBytes -= blocks.front().bytes();
+    blocks.pop_front();
+
+    if (blocks.empty())
+    {
+        m_compressedBytes -= sizeof(Series) + channel.size();
+        m_series.erase(it);
+    }
+    else
+    {
+        // channels take turns, so a long backlog of one channel does not hold back the rest
+        m_order.push_back(channel);
+    }
+
+    m_readingCount -= readings.size();
+    m_readings.set(static_cast<std::int64_t>(m_readingCount));
+    m_bytes.set(static_cast<std::int64_t>(m_compressedBytes));
+
+    JsonWriter writer;
+    std::string value;
+    writer.beginArray();
+    for (const auto& reading : readings)
+    {
+        value.clear();
+        JsonWriter::appendNumber(value, reading.value);
+        writer.beginObject().key(UTC_KEY).value(reading.utc).key(DATA_KEY).value(value).endObject();
+    }
+    writer.endArray();
+
+    return std::make_shared<Message>(writer.str(), channel);
+}
+
+std::vector<std::shared_ptr<Message>> CompressedReadingPersistence::plan(std::size_t count)
+{
+    auto messages = m_fallback->frontBatch(count);
+    m_plannedFallback = messages.size();
+
+    while (m_materialized.size() < count - messages.size())
+    {
+        auto message = materialize();
+        if (!message)
+        {
+            break;
+        }
+
+        m_materialized.push_back(std::move(message));
+    }
+
+    m_plannedMaterialized = std::min(count - messages.size(), m_materialized.size());
+    messages.insert(messages.end(), m_materialized.begin(),
+                    m_materialized.begin() + static_cast<std::ptrdiff_t>(m_plannedMaterialized));
+    return messages;
+}
+
+std::size_t CompressedReadingPersistence::drain(std::size_t count)
+{
+    const std::size_t fromFallback = m_fallback->popBatch(std::min(count, m_plannedFallback));
+    const std::size_t fromMaterialized = std::min(count - fromFallback, m_plannedMaterialized);
+    m_materialized.erase(m_materialized.begin(),
+                         m_materialized.begin() + static_cast<std::ptrdiff_t>(fromMaterialized));
+
+    m_plannedFallback = 0;
+    m_plannedMaterialized = 0;
+    return fromFallback + fromMaterialized;
+}
+}    // namespace wolkabout
@@ -0,0 +1,150 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMPRESSEDREADINGPERSISTENCE_H
+#define COMPRESSEDREADINGPERSISTENCE_H
+
+#include "persistence/GatewayPersistence.h"
+#include "utilities/Metrics.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief wolkabout::GatewayPersistence keeping numeric sensor readings compressed per channel
+ *
+ * Readings of each channel, that is of one device reference, are appended to blocks holding timestamps
+ * as delta-of-delta and values XORed with the previous value, as in Facebook's Gorilla, which takes
+ * a few bytes per reading for regularly sampled sensors instead of a message per reading.
+ * Blocks are turned back into messages of up to readingsPerMessage readings when drained,
+ * in the payload format of wolkabout::JsonStreamingProtocol.
+ *
+ * Only readings whose "data" is a number written in shortest form and which have no other members besides
+ * "utc" are compressed, so replayed payloads carry the same readings. Readings without "utc" are stamped with
+ * time they were added, so they keep their time when replayed after an outage.
+ * Other messages, and readings arriving while compressed readings exceed maximumBytes, go to fallback persistence,
+ * which is drained first. Readings of one channel stay in order, order across channels is not kept.
+ * Compressed readings are kept in memory.
+ */
+class CompressedReadingPersistence : public GatewayPersistence
+{
+public:
+    using Classifier = std::function<bool(const Message&)>;
+
+    static const std::size_t DEFAULT_READINGS_PER_MESSAGE;
+
+    /**
+     * @param fallback Persistence holding messages that are not compressed
+     * @param isSensorReading Returns whether message carries sensor readings
+     * @param maximumBytes Maximum size of compressed readings, 0 for no limit
+     * @param readingsPerMessage Maximum number of readings in a replayed message, 0 is treated as 1
+     * @param name Prefix of metrics reported by this instance
+     */
+    CompressedReadingPersistence(std::unique_ptr<GatewayPersistence> fallback, Classifier isSensorReading,
+                                 std::size_t maximumBytes,
+                                 std::size_t readingsPerMessage = DEFAULT_READINGS_PER_MESSAGE,
+                                 const std::string& name = "compressed_readings");
+
+    bool push(std::shared_ptr<Message> message) override;
+    std::shared_ptr<Message> pop() override;
+    std::shared_ptr<Message> front() override;
+    bool empty() const override;
+    bool isFifo() const override { return false; }
+
+    std::vector<std::shared_ptr<Message>> frontBatch(std::size_t count) override;
+    std::size_t popBatch(std::size_t count) override;
+
+    std::size_t getReadingCount() const;
+    std::size_t getCompressedBytes() const;
+
+private:
+    struct Reading
+    {
+        std::uint64_t utc;
+        double value;
+    };
+
+    class Block
+    {
+    public:
+        Block();
+
+        void append(const Reading& reading);
+        std::vector<Reading> decode() const;
+
+        std::size_t size() const;
+        std::size_t bytes() const;
+
+    private:
+        void writeBits(std::uint64_t value, unsigned count);
+        void writeTimestamp(std::uint64_t utc);
+        void writeValue(std::uint64_t bits);
+
+        std::vector<std::uint8_t> m_data;
+        std::size_t m_bitCount;
+        std::size_t m_size;
+
+        std::uint64_t m_lastUtc;
+        std::int64_t m_lastDelta;
+        std::uint64_t m_lastValue;
+        unsigned m_leadingZeros;
+        unsigned m_trailingZeros;
+    };
+
+    struct Series
+    {
+        std::deque<Block> blocks;
+    };
+
+    bool parse(const Message& message, std::vector<Reading>& readings) const;
+    std::shared_ptr<Message> materialize();
+
+    std::vector<std::shared_ptr<Message>> plan(std::size_t count);
+    std::size_t drain(std::size_t count);
+
+    const std::unique_ptr<GatewayPersistence> m_fallback;
+    const Classifier m_isSensorReading;
+    const std::size_t m_maximumBytes;
+    const std::size_t m_readingsPerMessage;
+
+    mutable std::mutex m_lock;
+    std::unordered_map<std::string, Series> m_series;
+    // channels with readings, in order in which their oldest block is drained
+    std::deque<std::string> m_order;
+    std::deque<std::shared_ptr<Message>> m_materialized;
+
+    std::size_t m_readingCount;
+    std::size_t m_compressedBytes;
+
+    std::size_t m_plannedFallback;
+    std::size_t m_plannedMaterialized;
+
+    Gauge& m_readings;
+    Gauge& m_bytes;
+    Counter& m_overflowReadings;
+};
+}    // namespace wolkabout
+
+#endif    // COMPRESSEDREADINGPERSISTENCE_H
@@ -17,7 +17,9 @@
 #ifndef GATEWAYPERSISTENCE_H
 #define GATEWAYPERSISTENCE_H
 
+#include <cstddef>
 #include <memory>
+#include <vector>
 
 namespace wolkabout
 {
@@ -26,7 +28,7 @@ class Message;
 /**
  * @brief A storage designed for holding messages in persistent store prior to publishing.
  *
- * Implementation storing/retrieving strategy must be FIFO.
+ * Implementation storing/retrieving strategy must be FIFO, unless it reports otherwise through isFifo.
  *
  * All methods must be implemented in a thread safe manner.
  */
@@ -63,12 +65,56 @@ public:
      */
     virtual std::shared_ptr<Message> front() = 0;
 
+    /**
+     * @brief Retrieves up to count first wolkabout::Message instances of this storage without removing them.
+     *
+     * Default implementation returns only the first message.
+     *
+     * @param count maximum number of messages to retrieve
+     * @return Messages in storage order, empty if this storage is empty.
+     */
+    virtual std::vector<std::shared_ptr<Message>> frontBatch(std::size_t count)
+    {
+        std::vector<std::shared_ptr<Message>> messages;
+        if (count != 0 && !empty())
+        {
+            messages.push_back(front());
+        }
+
+        return messages;
+    }
+
+    /**
+     * @brief Removes up to count first wolkabout::Message instances from this storage.
+     *
+     * @param count number of messages to remove
+     * @return Number of removed messages
+     */
+    virtual std::size_t popBatch(std::size_t count)
+    {
+        std::size_t removed = 0;
+        while (removed < count && !empty())
+        {
+            pop();
+            ++removed;
+        }
+
+        return removed;
+    }
+
     /**
      * Returns whether this storage contains any messages.
      *
      * @return {@code true} if this storage contains no wolkabout::Message
      */
     virtual bool empty() const = 0;
+
+    /**
+     * Returns whether messages are retrieved in order in which they were inserted, one for each inserted message.
+     *
+     * @return {@code false} if storage reorders or merges messages
+     */
+    virtual bool isFifo() const { return true; }
 };
 }    // namespace wolkabout
 
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "persistence/PriorityLanePersistence.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace wolkabout
+{
+PriorityLanePersistence::PriorityLanePersistence(Classifier classifier)
+: m_classifier{std::move(classifier)}, m_currentLane{0}, m_remainingWeight{0}
+{
+}
+
+void PriorityLanePersistence::addLane(std::unique_ptr<GatewayPersistence> persistence, std::size_t weight,
+                                      std::size_t limit)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    m_lanes.push_back(Lane{std::move(persistence), std::max<std::size_t>(weight, 1), limit, 0});
+    m_plannedDrains.clear();
+
+    if (m_lanes.size() == 1)
+    {
+        m_remainingWeight = m_lanes.front().weight;
+    }
+}
+
+bool PriorityLanePersistence::push(std::shared_ptr<Message> message)
+{
+    const std::size_t index = m_classifier(*message);
+
+    std::lock_guard<std::mutex> lg{m_lock};
+    if (m_lanes.empty())
+    {
+        return false;
+    }
+
+    Lane& lane = m_lanes[std::min(index, m_lanes.size() - 1)];
+    if (lane.limit != 0 && lane.size >= lane.limit)
+    {
+        return false;
+    }
+
+    if (!lane.persistence->push(message))
+    {
+        return false;
+    }
+
+    ++lane.size;
+    return true;
+}
+
+std::shared_ptr<Message> PriorityLanePersistence::pop()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    const auto messages = plan(1);
+    if (messages.empty())
+    {
+        return nullptr;
+    }
+
+    drain(1);
+    return messages.front();
+}
+
+std::shared_ptr<Message> PriorityLanePersistence::front()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    const auto messages = plan(1);
+    return messages.empty() ? nullptr : messages.front();
+}
+
+bool PriorityLanePersistence::empty() const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return std::all_of(m_lanes.begin(), m_lanes.end(), [](const Lane& lane) { return lane.persistence->empty(); });
+}
+
+std::vector<std::shared_ptr<Message>> PriorityLanePersistence::frontBatch(std::size_t count)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return plan(count);
+}
+
+std::size_t PriorityLanePersistence::popBatch(std::size_t count)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    std::size_t planned = 0;
+    for (const auto& plannedDrain : m_plannedDrains)
+    {
+        planned += plannedDrain.count;
+    }
+
+    // messages already handed out by frontBatch must be the ones removed, even if other lanes were pushed to since
+    if (planned < count)
+    {
+        plan(count);
+    }
+
+    return drain(count);
+}
+
+std::vector<std::shared_ptr<Message>> PriorityLanePersistence::plan(std::size_t count)
+{
+    m_plannedDrains.clear();
+
+    std::vector<std::shared_ptr<Message>> messages;
+    if (m_lanes.empty())
+    {
+        return messages;
+    }
+
+    // lanes can be visited more than once per plan, offsets skip messages already planned from them
+    std::vector<std::size_t> offsets(m_lanes.size(), 0);
+    std::size_t lane = m_currentLane;
+    std::size_t weight = m_remainingWeight;
+    std::size_t idleLanes = 0;
+
+    while (messages.size() < count && idleLanes < m_lanes.size())
+    {
+        const std::size_t wanted = std::min(weight, count - messages.size());
+        const auto laneMessages = m_lanes[lane].persistence->frontBatch(offsets[lane] + wanted);
+        const std::size_t taken = laneMessages.size() > offsets[lane] ? laneMessages.size() - offsets[lane] : 0;
+
+        if (taken != 0)
+        {
+            messages.insert(messages.end(), laneMessages.begin() + static_cast<std::ptrdiff_t>(offsets[lane]),
+                            laneMessages.end());
+            m_plannedDrains.push_back(Drain{lane, taken});
+            offsets[lane] += taken;
+            weight -= taken;
+            idleLanes = 0;
+        }
+        else
+        {
+            ++idleLanes;
+        }
+
+        if (weight == 0 || taken < wanted)
+        {
+            lane = (lane + 1) % m_lanes.size();
+            weight = m_lanes[lane].weight;
+        }
+    }
+
+    return messages;
+}
+
+std::size_t PriorityLanePersistence::drain(std::size_t count)
+{
+    std::size_t removed = 0;
+    for (const auto& plannedDrain : m_plannedDrains)
+    {
+        if (removed == count)
+        {
+            break;
+        }
+
+        Lane& lane = m_lanes[plannedDrain.lane];
+        if (m_currentLane != plannedDrain.lane)
+        {
+            m_currentLane = plannedDrain.lane;
+            m_remainingWeight = lane.weight;
+        }
+
+        const std::size_t popped = lane.persistence->popBatch(std::min(plannedDrain.count, count - removed));
+        removed += popped;
+        lane.size -= std::min(lane.size, popped);
+        m_remainingWeight -= std::min(m_remainingWeight, popped);
+
+        if (m_remainingWeight == 0)
+        {
+            m_currentLane = (m_currentLane + 1) % m_lanes.size();
+            m_remainingWeight = m_lanes[m_currentLane].weight;
+        }
+
+        if (popped < plannedDrain.count)
+        {
+            break;
+        }
+    }
+
+    m_plannedDrains.clear();
+    return removed;
+}
+}    // namespace wolkabout
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef PRIORITYLANEPERSISTENCE_H
+#define PRIORITYLANEPERSISTENCE_H
+
+#include "persistence/GatewayPersistence.h"
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief wolkabout::GatewayPersistence splitting messages into lanes drained by weighted round robin
+ *
+ * Lane of each message is chosen by classifier when it is pushed, messages inside a lane stay FIFO.
+ * While draining, a lane gives up to its weight of messages before the next non empty lane takes over,
+ * so a backlog in one lane delays messages of other lanes by at most the sum of weights.
+ * A lane with a limit rejects messages once it holds that many messages.
+ * Messages present in lane storage before it was added are drained, but not counted against its limit.
+ */
+class PriorityLanePersistence : public GatewayPersistence
+{
+public:
+    using Classifier = std::function<std::size_t(const Message&)>;
+
+    /**
+     * @param classifier Returns index of lane for message, out of range indices select the last lane
+     */
+    explicit PriorityLanePersistence(Classifier classifier);
+
+    /**
+     * @brief Appends lane, lanes get indices in order in which they are added
+     * @param persistence Storage of lane messages
+     * @param weight Number of messages drained from lane in one round, 0 is treated as 1
+     * @param limit Maximum number of messages in lane, 0 for no limit
+     */
+    void addLane(std::unique_ptr<GatewayPersistence> persistence, std::size_t weight, std::size_t limit = 0);
+
+    bool push(std::shared_ptr<Message> message) override;
+    std::shared_ptr<Message> pop() override;
+    std::shared_ptr<Message> front() override;
+    bool empty() const override;
+    bool isFifo() const override { return false; }
+
+    std::vector<std::shared_ptr<Message>> frontBatch(std::size_t count) override;
+    std::size_t popBatch(std::size_t count) override;
+
+private:
+    struct Lane
+    {
+        std::unique_ptr<GatewayPersistence> persistence;
+        std::size_t weight;
+        std::size_t limit;
+        std::size_t size;
+    };
+
+    struct Drain
+    {
+        std::size_t lane;
+        std::size_t count;
+    };
+
+    std::vector<std::shared_ptr<Message>> plan(std::size_t count);
+    std::size_t drain(std::size_t count);
+
+    const Classifier m_classifier;
+
+    mutable std::mutex m_lock;
+    std::vector<Lane> m_lanes;
+
+    std::size_t m_currentLane;
+    std::size_t m_remainingWeight;
+
+    std::vector<Drain> m_plannedDrains;
+};
+}    // namespace wolkabout
+
+#endif    // PRIORITYLANEPERSISTENCE_H
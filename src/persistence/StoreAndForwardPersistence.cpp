@@ -0,0 +1,327 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "persistence/StoreAndForwardPersistence.h"
+#include "model/Message.h"
+#include "utilities/JsonReader.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+const std::string UTC_KEY = "utc";
+
+bool hasTimeOfEachReading(const std::string& content)
+{
+    const auto start = content.find_first_not_of(" \t\r\n");
+    if (start == std::string::npos)
+    {
+        return false;
+    }
+
+    wolkabout::JsonReader reader{content};
+    const auto readReading = [&]() -> bool {
+        if (!reader.beginObject())
+        {
+            return false;
+        }
+
+        bool hasUtc = false;
+        std::string name;
+        while (reader.nextMember(name))
+        {
+            hasUtc = hasUtc || name == UTC_KEY;
+            if (!reader.skipValue())
+            {
+                return false;
+            }
+        }
+
+        return !reader.failed() && hasUtc;
+    };
+
+    if (content[start] == '[')
+    {
+        if (!reader.beginArray())
+        {
+            return false;
+        }
+
+        bool any = false;
+        while (reader.nextElement())
+        {
+            if (!readReading())
+            {
+                return false;
+            }
+            any = true;
+        }
+
+        return reader.finish() && any;
+    }
+
+    return readReading() && reader.finish();
+}
+}    // namespace
+
+namespace wolkabout
+{
+StoreAndForwardPersistence::StoreAndForwardPersistence(std::unique_ptr<GatewayPersistence> backfill,
+                                                       std::size_t liveCapacity, std::size_t liveWeight,
+                                                       std::chrono::milliseconds dedupWindow,
+                                                       Classifier isSensorReading, const std::string& name)
+: m_backfill{std::move(backfill)}
+, m_liveCapacity{std::max<std::size_t>(liveCapacity, 1)}
+, m_liveWeight{std::max<std::size_t>(liveWeight, 1)}
+, m_dedupWindow{dedupWindow}
+, m_isSensorReading{std::move(isSensorReading)}
+, m_liveDrained{0}
+, m_plannedLive{0}
+, m_backfilledMessages{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_backfilled_total")}
+, m_droppedMessages{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_dropped_total")}
+, m_duplicateMessages{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_duplicates_total")}
+{
+}
+
+bool StoreAndForwardPersistence::push(std::shared_ptr<Message> message)
+{
+    const auto now = Clock::now();
+
+    std::lock_guard<std::mutex> lg{m_lock};
+    if (m_dedupWindow.count() > 0 && m_isSensorReading && isDuplicate(*message, now))
+    {
+        m_duplicateMessages.increment();
+        return false;
+    }
+
+    m_live.push_back(std::move(message));
+    moveToBackfill();
+    return true;
+}
+
+std::shared_ptr<Message> StoreAndForwardPersistence::pop()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    const auto messages = plan(1);
+    if (messages.empty())
+    {
+        return nullptr;
+    }
+
+    drain(1);
+    return messages.front();
+}
+
+std::shared_ptr<Message> StoreAndForwardPersistence::front()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    const auto messages = plan(1);
+    return messages.empty() ? nullptr : messages.front();
+}
+
+bool StoreAndForwardPersistence::empty() const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return m_live.empty() && m_backfill->empty();
+}
+
+std::vector<std::shared_ptr<Message>> StoreAndForwardPersistence::frontBatch(std::size_t count)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return plan(count);
+}
+
+std::size_t StoreAndForwardPersistence::popBatch(std::size_t count)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    std::size_t planned = 0;
+    for (const auto& plannedDrain : m_plannedDrains)
+    {
+        planned += plannedDrain.count;
+    }
+
+    // messages already handed out by frontBatch must be the ones removed
+    if (planned < count)
+    {
+        plan(count);
+    }
+
+    return drain(count);
+}
+
+bool StoreAndForwardPersistence::isDuplicate(const Message& message, Clock::time_point now)
+{
+    while (!m_fingerprints.empty() && now - m_fingerprints.front().addedAt >= m_dedupWindow)
+    {
+        m_recentKeys.erase(m_recentKeys.find(m_fingerprints.front().key));
+        m_fingerprints.pop_front();
+    }
+
+    if (!m_isSensorReading(message) || !hasTimeOfEachReading(message.getContent()))
+    {
+        return false;
+    }
+
+    // channel never contains NUL, so key is unique for each pair of channel and payload
+    std::string key = message.getChannel();
+    key += '\0';
+    key += message.getContent();
+
+    if (m_recentKeys.count(key) != 0)
+    {
+        return true;
+    }
+
+    m_recentKeys.insert(key);
+    m_fingerprints.push_back(Fingerprint{std::move(key), now});
+    return false;
+}
+
+void StoreAndForwardPersistence::moveToBackfill()
+{
+    // oldest live messages not handed out yet go first, so backfill stays in order in which messages were added
+    while (m_live.size() > m_liveCapacity && m_live.size() > m_plannedLive)
+    {
+        const auto it = m_live.begin() + static_cast<std::ptrdiff_t>(m_plannedLive);
+        if (m_backfill->push(*it))
+        {
+            m_backfilledMessages.increment();
+        }
+        else
+        {
+            m_droppedMessages.increment();
+        }
+
+        m_live.erase(it);
+    }
+}
+
+std::vector<std::shared_ptr<Message>> StoreAndForwardPersistence::plan(std::size_t count)
+{
+    m_plannedDrains.clear();
+    m_plannedLive = 0;
+
+    const auto addDrain = [&](bool live, std::size_t drained) {
+        if (!m_plannedDrains.empty() && m_plannedDrains.back().live == live)
+        {
+            m_plannedDrains.back().count += drained;
+        }
+        else
+        {
+            m_plannedDrains.push_back(Drain{live, drained});
+        }
+    };
+
+    std::vector<std::shared_ptr<Message>> messages;
+    std::size_t liveDrained = m_liveDrained;
+    std::size_t backfillOffset = 0;
+    bool backfillEmpty = false;
+
+    while (messages.size() < count)
+    {
+        const std::size_t liveAvailable = m_live.size() - m_plannedLive;
+
+        if (!backfillEmpty && (liveAvailable == 0 || liveDrained >= m_liveWeight))
+        {
+            // without live messages the rest of batch comes from backfill
+            const std::size_t wanted = liveAvailable == 0 ? count - messages.size() : 1;
+            const auto backfillMessages = m_backfill->frontBatch(backfillOffset + wanted);
+            const std::size_t taken =
+              backfillMessages.size() > backfillOffset ? backfillMessages.size() - backfillOffset : 0;
+
+            if (taken != 0)
+            {
+                messages.insert(messages.end(),
+                                backfillMessages.begin() + static_cast<std::ptrdiff_t>(backfillOffset),
+                                backfillMessages.end());
+                addDrain(false, taken);
+                backfillOffset += taken;
+                liveDrained = 0;
+                continue;
+            }
+
+            backfillEmpty = true;
+        }
+
+        if (liveAvailable == 0)
+        {
+            break;
+        }
+
+        std::size_t taken = std::min(count - messages.size(), liveAvailable);
+        if (!backfillEmpty)
+        {
+            taken = std::min(taken, m_liveWeight - liveDrained);
+        }
+
+        const auto first = m_live.begin() + static_cast<std::ptrdiff_t>(m_plannedLive);
+        messages.insert(messages.end(), first, first + static_cast<std::ptrdiff_t>(taken));
+        addDrain(true, taken);
+        m_plannedLive += taken;
+        liveDrained += taken;
+    }
+
+    return messages;
+}
+
+std::size_t StoreAndForwardPersistence::drain(std::size_t count)
+{
+    std::size_t removed = 0;
+    for (const auto& plannedDrain : m_plannedDrains)
+    {
+        if (removed == count)
+        {
+            break;
+        }
+
+        const std::size_t wanted = std::min(plannedDrain.count, count - removed);
+        std::size_t popped = 0;
+        if (plannedDrain.live)
+        {
+            popped = std::min(wanted, m_live.size());
+            m_live.erase(m_live.begin(), m_live.begin() + static_cast<std::ptrdiff_t>(popped));
+            m_liveDrained = std::min(m_liveDrained + popped, m_liveWeight);
+        }
+        else
+        {
+            popped = m_backfill->popBatch(wanted);
+            if (popped != 0)
+            {
+                m_liveDrained = 0;
+            }
+        }
+
+        removed += popped;
+        if (popped < wanted)
+        {
+            break;
+        }
+    }
+
+    m_plannedDrains.clear();
+    m_plannedLive = 0;
+
+    // live messages over capacity are not moved while they are handed out
+    moveToBackfill();
+    return removed;
+}
+}    // namespace wolkabout
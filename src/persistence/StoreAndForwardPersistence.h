@@ -0,0 +1,117 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef STOREANDFORWARDPERSISTENCE_H
+#define STOREANDFORWARDPERSISTENCE_H
+
+#include "persistence/GatewayPersistence.h"
+#include "utilities/Metrics.h"
+
+#include <chrono>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief wolkabout::GatewayPersistence publishing fresh messages ahead of backlog replayed after an outage
+ *
+ * Newest messages are kept in memory as live messages, and once there are more than liveCapacity of them
+ * the oldest are moved to backfill persistence. While both hold messages, liveWeight live messages are drained
+ * for each backfill message, so replay of backlog keeps going without holding back fresh data.
+ * Both parts are FIFO, so backlog is replayed in order in which messages were added.
+ *
+ * Sensor reading whose channel and payload equal those of a reading added within dedup window is rejected,
+ * which drops duplicates resent by devices whose acknowledgement was lost. Only readings that all carry "utc"
+ * are compared, as a repeated value without time may be a new reading; other messages are never rejected.
+ */
+class StoreAndForwardPersistence : public GatewayPersistence
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Classifier = std::function<bool(const Message&)>;
+
+    /**
+     * @param backfill Persistence holding messages which did not fit among live messages
+     * @param liveCapacity Maximum number of live messages, 0 is treated as 1
+     * @param liveWeight Number of live messages drained for each backfill message, 0 is treated as 1
+     * @param dedupWindow Time for which duplicates of added reading are rejected, 0 disables deduplication
+     * @param isSensorReading Returns whether message carries sensor readings, deduplication is disabled without it
+     * @param name Prefix of metrics reported by this instance
+     */
+    StoreAndForwardPersistence(std::unique_ptr<GatewayPersistence> backfill, std::size_t liveCapacity,
+                               std::size_t liveWeight, std::chrono::milliseconds dedupWindow,
+                               Classifier isSensorReading = nullptr, const std::string& name = "store_and_forward");
+
+    bool push(std::shared_ptr<Message> message) override;
+    std::shared_ptr<Message> pop() override;
+    std::shared_ptr<Message> front() override;
+    bool empty() const override;
+    bool isFifo() const override { return false; }
+
+    std::vector<std::shared_ptr<Message>> frontBatch(std::size_t count) override;
+    std::size_t popBatch(std::size_t count) override;
+
+private:
+    struct Drain
+    {
+        bool live;
+        std::size_t count;
+    };
+
+    struct Fingerprint
+    {
+        std::string key;
+        Clock::time_point addedAt;
+    };
+
+    bool isDuplicate(const Message& message, Clock::time_point now);
+    void moveToBackfill();
+
+    std::vector<std::shared_ptr<Message>> plan(std::size_t count);
+    std::size_t drain(std::size_t count);
+
+    const std::unique_ptr<GatewayPersistence> m_backfill;
+    const std::size_t m_liveCapacity;
+    const std::size_t m_liveWeight;
+    const std::chrono::milliseconds m_dedupWindow;
+    const Classifier m_isSensorReading;
+
+    mutable std::mutex m_lock;
+    std::deque<std::shared_ptr<Message>> m_live;
+    // live messages drained since last backfill message
+    std::size_t m_liveDrained;
+
+    std::vector<Drain> m_plannedDrains;
+    // live messages handed out by frontBatch, they stay live until popped
+    std::size_t m_plannedLive;
+
+    std::deque<Fingerprint> m_fingerprints;
+    std::unordered_multiset<std::string> m_recentKeys;
+
+    Counter& m_backfilledMessages;
+    Counter& m_droppedMessages;
+    Counter& m_duplicateMessages;
+};
+}    // namespace wolkabout
+
+#endif    // STOREANDFORWARDPERSISTENCE_H
@@ -0,0 +1,574 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "persistence/filesystem/GatewayFilePersistence.h"
+#include "model/Message.h"
+#include "utilities/Logger.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+const char* SEGMENT_PREFIX = "segment_";
+const char* SEGMENT_SUFFIX = ".log";
+const char* CURSOR_FILE = "cursor";
+
+const std::uint32_t RECORD_MAGIC = 0x574B4D47;
+
+struct RecordHeader
+{
+    std::uint32_t magic;
+    std::uint32_t channelSize;
+    std::uint32_t contentSize;
+    std::uint32_t checksum;
+};
+
+struct Cursor
+{
+    std::uint64_t segmentId;
+    std::uint64_t offset;
+};
+
+std::uint32_t checksum(const char* data, std::uint64_t size, std::uint32_t hash = 2166136261u)
+{
+    for (std::uint64_t i = 0; i < size; ++i)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+}    // namespace
+
+namespace wolkabout
+{
+constexpr std::uint64_t GatewayFilePersistence::DEFAULT_SEGMENT_SIZE;
+constexpr std::uint64_t GatewayFilePersistence::DEFAULT_MAXIMUM_SIZE;
+constexpr std::uint32_t GatewayFilePersistence::DEFAULT_SYNC_BATCH_SIZE;
+
+GatewayFilePersistence::GatewayFilePersistence(const std::string& directory, std::uint64_t segmentSize,
+                                               std::uint64_t maximumSize, std::uint32_t syncBatchSize)
+: m_directory{directory}
+, m_segmentSize{std::max<std::uint64_t>(segmentSize, sizeof(RecordHeader))}
+, m_maximumSegments{std::max<std::uint64_t>(maximumSize / m_segmentSize, 1)}
+, m_syncBatchSize{std::max<std::uint32_t>(syncBatchSize, 1)}
+, m_readOffset{0}
+, m_cursorFd{-1}
+, m_unsyncedOperations{0}
+, m_frontNext{0}
+{
+    if (::mkdir(m_directory.c_str(), 0755) != 0 && errno != EEXIST)
+    {
+        LOG(ERROR) << "GatewayFilePersistence: Unable to create directory '" << m_directory << "'";
+    }
+
+    recover();
+}
+
+GatewayFilePersistence::~GatewayFilePersistence()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    sync(true);
+
+    for (auto& segment : m_segments)
+    {
+        closeSegment(*segment, false);
+    }
+
+    if (m_cursorFd >= 0)
+    {
+        ::close(m_cursorFd);
+    }
+}
+
+bool GatewayFilePersistence::push(std::shared_ptr<Message> message)
+{
+    const std::string& channel = message->getChannel();
+    const std::string& content = message->getContent();
+
+    const std::uint64_t recordSize = sizeof(RecordHeader) + channel.size() + content.size();
+    if (recordSize > m_segmentSize)
+    {
+        LOG(ERROR) << "GatewayFilePersistence: Message on channel '" << channel << "' exceeds segment size";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    if (!m_segments.empty() && m_segments.back()->end + recordSize > m_segmentSize)
+    {
+        rewindConsumedSegment();
+    }
+
+    if (m_segments.empty() || m_segments.back()->end + recordSize > m_segmentSize)
+    {
+        if (m_segments.size() >= m_maximumSegments)
+        {
+            LOG(WARN) << "GatewayFilePersistence: Storage full, dropping message on channel '" << channel << "'";
+            return false;
+        }
+
+        sync(true);
+
+        const std::uint64_t id = m_segments.empty() ? 0 : m_segments.back()->id + 1;
+        auto segment = openSegment(id, true);
+        if (!segment)
+        {
+            return false;
+        }
+
+        m_segments.push_back(std::move(segment));
+        if (m_segments.size() == 1)
+        {
+            m_readOffset = 0;
+            writeCursor();
+        }
+
+        skipConsumedSegments();
+    }
+
+    Segment& segment = *m_segments.back();
+    char* record = segment.data + segment.end;
+
+    RecordHeader header;
+    header.magic = RECORD_MAGIC;
+    header.channelSize = static_cast<std::uint32_t>(channel.size());
+    header.contentSize = static_cast<std::uint32_t>(content.size());
+    header.checksum = checksum(content.data(), content.size(), checksum(channel.data(), channel.size()));
+
+    // header is written last so partially written record is never recognized as valid
+    std::memcpy(record + sizeof(RecordHeader), channel.data(), channel.size());
+    std::memcpy(record + sizeof(RecordHeader) + channel.size(), content.data(), content.size());
+    std::memcpy(record, &header, sizeof(RecordHeader));
+
+    segment.end += recordSize;
+
+    ++m_unsyncedOperations;
+    sync(false);
+
+    return true;
+}
+
+std::shared_ptr<Message> GatewayFilePersistence::pop()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return popFront();
+}
+
+std::shared_ptr<Message> GatewayFilePersistence::front()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return readFront();
+}
+
+std::vector<std::shared_ptr<Message>> GatewayFilePersistence::frontBatch(std::size_t count)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    std::vector<std::shared_ptr<Message>> messages;
+    if (count == 0 || !readFront())
+    {
+        return messages;
+    }
+
+    messages.push_back(m_front);
+
+    std::size_t segmentIndex = 0;
+    std::uint64_t offset = m_frontNext;
+    while (messages.size() < count)
+    {
+        std::shared_ptr<Message> message;
+        std::uint64_t next = 0;
+        if (readRecord(*m_segments[segmentIndex], offset, message, next))
+        {
+            messages.push_back(message);
+            offset = next;
+            continue;
+        }
+
+        // corrupted records are skipped by readFront once they reach the front
+        if (next != 0 || segmentIndex + 1 >= m_segments.size())
+        {
+            break;
+        }
+
+        ++segmentIndex;
+        offset = 0;
+    }
+
+    return messages;
+}
+
+std::size_t GatewayFilePersistence::popBatch(std::size_t count)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    std::size_t removed = 0;
+    while (removed < count && popFront())
+    {
+        ++removed;
+    }
+
+    return removed;
+}
+
+bool GatewayFilePersistence::empty() const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    return m_segments.empty() || (m_segments.size() == 1 && m_readOffset >= m_segments.front()->end);
+}
+
+std::shared_ptr<Message> GatewayFilePersistence::popFront()
+{
+    auto message = readFront();
+    if (!message)
+    {
+        return nullptr;
+    }
+
+    m_readOffset = m_frontNext;
+    m_front.reset();
+
+    skipConsumedSegments();
+    writeCursor();
+
+    ++m_unsyncedOperations;
+    sync(false);
+
+    return message;
+}
+
+std::shared_ptr<Message> GatewayFilePersistence::readFront()
+{
+    while (!m_front && !m_segments.empty())
+    {
+        const Segment& head = *m_segments.front();
+        if (m_readOffset >= head.end)
+        {
+            return nullptr;
+        }
+
+        std::uint64_t next = 0;
+        if (readRecord(head, m_readOffset, m_front, next))
+        {
+            m_frontNext = next;
+            break;
+        }
+
+        if (next == 0)
+        {
+            // no valid record header at read position
+            if (m_segments.size() == 1)
+            {
+                return nullptr;
+            }
+
+            closeSegment(*m_segments.front(), true);
+            m_segments.pop_front();
+            m_readOffset = 0;
+        }
+        else
+        {
+            LOG(ERROR) << "GatewayFilePersistence: Skipping corrupted message in segment " << head.id;
+            m_readOffset = next;
+        }
+
+        writeCursor();
+    }
+
+    return m_front;
+}
+
+void GatewayFilePersistence::recover()
+{
+    std::vector<std::uint64_t> ids;
+
+    if (DIR* dir = ::opendir(m_directory.c_str()))
+    {
+        const std::string prefix{SEGMENT_PREFIX};
+        const std::string suffix{SEGMENT_SUFFIX};
+
+        while (struct dirent* entry = ::readdir(dir))
+        {
+            const std::string name{entry->d_name};
+            if (name.size() <= prefix.size() + suffix.size() || name.compare(0, prefix.size(), prefix) != 0 ||
+                name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+            {
+                continue;
+            }
+
+            const std::string number = name.substr(prefix.size(), name.size() - prefix.size() - suffix.size());
+            if (number.find_first_not_of("0123456789") != std::string::npos)
+            {
+                continue;
+            }
+
+            ids.push_back(std::stoull(number));
+        }
+
+        ::closedir(dir);
+    }
+
+    std::sort(ids.begin(), ids.end());
+
+    const std::string cursorPath = m_directory + "/" + CURSOR_FILE;
+    m_cursorFd = ::open(cursorPath.c_str(), O_RDWR | O_CREAT, 0644);
+    if (m_cursorFd < 0)
+    {
+        LOG(ERROR) << "GatewayFilePersistence: Unable to open cursor file '" << cursorPath << "'";
+    }
+
+    Cursor cursor{ids.empty() ? 0 : ids.front(), 0};
+    if (m_cursorFd >= 0)
+    {
+        Cursor stored;
+        if (::pread(m_cursorFd, &stored, sizeof(Cursor), 0) == static_cast<ssize_t>(sizeof(Cursor)))
+        {
+            cursor = stored;
+        }
+    }
+
+    for (const auto id : ids)
+    {
+        if (id < cursor.segmentId)
+        {
+            std::remove(segmentPath(id).c_str());
+            continue;
+        }
+
+        auto segment = openSegment(id, false);
+        if (segment)
+        {
+            segment->end = m_segmentSize;
+            m_segments.push_back(std::move(segment));
+        }
+    }
+
+    if (m_segments.empty())
+    {
+        return;
+    }
+
+    // only the last segment is scanned, earlier ones end at first invalid record header
+    Segment& tail = *m_segments.back();
+    tail.end = scanSegment(tail);
+    std::memset(tail.data + tail.end, 0, static_cast<std::size_t>(m_segmentSize - tail.end));
+
+    m_readOffset = m_segments.front()->id == cursor.segmentId ? cursor.offset : 0;
+    if (m_readOffset > m_segments.front()->end)
+    {
+        m_readOffset = m_segments.front()->end;
+    }
+
+    skipConsumedSegments();
+    writeCursor();
+
+    LOG(INFO) << "GatewayFilePersistence: Recovered " << m_segments.size() << " segment(s) from '" << m_directory
+              << "'";
+}
+
+std::unique_ptr<GatewayFilePersistence::Segment> GatewayFilePersistence::openSegment(std::uint64_t id, bool create)
+{
+    const std::string path = segmentPath(id);
+
+    const int fd = ::open(path.c_str(), O_RDWR | (create ? O_CREAT | O_TRUNC : 0), 0644);
+    if (fd < 0)
+    {
+        LOG(ERROR) << "GatewayFilePersistence: Unable to open segment '" << path << "'";
+        return nullptr;
+    }
+
+    struct stat fileStat;
+    if (::fstat(fd, &fileStat) != 0 ||
+        (static_cast<std::uint64_t>(fileStat.st_size) < m_segmentSize &&
+         ::ftruncate(fd, static_cast<off_t>(m_segmentSize)) != 0))
+    {
+        LOG(ERROR) << "GatewayFilePersistence: Unable to allocate segment '" << path << "'";
+        ::close(fd);
+        return nullptr;
+    }
+
+    void* data = ::mmap(nullptr, static_cast<std::size_t>(m_segmentSize), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+    {
+        LOG(ERROR) << "GatewayFilePersistence: Unable to map segment '" << path << "'";
+        ::close(fd);
+        return nullptr;
+    }
+
+    return std::unique_ptr<Segment>(new Segment{id, fd, static_cast<char*>(data), 0});
+}
+
+void GatewayFilePersistence::closeSegment(Segment& segment, bool remove)
+{
+    ::munmap(segment.data, static_cast<std::size_t>(m_segmentSize));
+    ::close(segment.fd);
+
+    if (remove)
+    {
+        std::remove(segmentPath(segment.id).c_str());
+    }
+}
+
+std::uint64_t GatewayFilePersistence::scanSegment(const Segment& segment) const
+{
+    std::uint64_t offset = 0;
+    while (true)
+    {
+        std::shared_ptr<Message> message;
+        std::uint64_t next = 0;
+        if (!readRecord(segment, offset, message, next))
+        {
+            return offset;
+        }
+
+        offset = next;
+    }
+}
+
+bool GatewayFilePersistence::readRecord(const Segment& segment, std::uint64_t offset,
+                                        std::shared_ptr<Message>& message, std::uint64_t& next) const
+{
+    next = 0;
+
+    if (offset + sizeof(RecordHeader) > segment.end)
+    {
+        return false;
+    }
+
+    RecordHeader header;
+    std::memcpy(&header, segment.data + offset, sizeof(RecordHeader));
+
+    const std::uint64_t recordSize = sizeof(RecordHeader) + std::uint64_t{header.channelSize} + header.contentSize;
+    if (header.magic != RECORD_MAGIC || offset + recordSize > segment.end)
+    {
+        return false;
+    }
+
+    next = offset + recordSize;
+
+    const char* channel = segment.data + offset + sizeof(RecordHeader);
+    const char* content = channel + header.channelSize;
+    if (checksum(content, header.contentSize, checksum(channel, header.channelSize)) != header.checksum)
+    {
+        return false;
+    }
+
+    message = std::make_shared<Message>(std::string(content, header.contentSize),
+                                        std::string(channel, header.channelSize));
+    return true;
+}
+
+void GatewayFilePersistence::skipConsumedSegments()
+{
+    while (m_segments.size() > 1 && !hasRecordHeader(*m_segments.front(), m_readOffset))
+    {
+        closeSegment(*m_segments.front(), true);
+        m_segments.pop_front();
+        m_readOffset = 0;
+    }
+}
+
+void GatewayFilePersistence::rewindConsumedSegment()
+{
+    if (m_segments.size() != 1 || hasRecordHeader(*m_segments.front(), m_readOffset))
+    {
+        return;
+    }
+
+    // read records are cleared and synced before cursor moves back, so recovery cannot take them for unread ones
+    Segment& segment = *m_segments.front();
+    std::memset(segment.data, 0, static_cast<std::size_t>(segment.end));
+    ::msync(segment.data, static_cast<std::size_t>(m_segmentSize), MS_SYNC);
+
+    segment.end = 0;
+    m_readOffset = 0;
+    m_front.reset();
+
+    writeCursor();
+    sync(true);
+}
+
+bool GatewayFilePersistence::hasRecordHeader(const Segment& segment, std::uint64_t offset) const
+{
+    if (offset + sizeof(RecordHeader) > segment.end)
+    {
+        return false;
+    }
+
+    RecordHeader header;
+    std::memcpy(&header, segment.data + offset, sizeof(RecordHeader));
+    return header.magic == RECORD_MAGIC;
+}
+
+void GatewayFilePersistence::writeCursor()
+{
+    if (m_cursorFd < 0 || m_segments.empty())
+    {
+        return;
+    }
+
+    const Cursor cursor{m_segments.front()->id, m_readOffset};
+    if (::pwrite(m_cursorFd, &cursor, sizeof(Cursor), 0) != static_cast<ssize_t>(sizeof(Cursor)))
+    {
+        LOG(ERROR) << "GatewayFilePersistence: Unable to store read position";
+    }
+}
+
+void GatewayFilePersistence::sync(bool force)
+{
+    if (!force && m_unsyncedOperations < m_syncBatchSize)
+    {
+        return;
+    }
+
+    if (!m_segments.empty())
+    {
+        ::msync(m_segments.back()->data, static_cast<std::size_t>(m_segmentSize), MS_SYNC);
+    }
+
+    if (m_cursorFd >= 0)
+    {
+        ::fdatasync(m_cursorFd);
+    }
+
+    m_unsyncedOperations = 0;
+}
+
+std::string GatewayFilePersistence::segmentPath(std::uint64_t id) const
+{
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s%020llu%s", SEGMENT_PREFIX, static_cast<unsigned long long>(id),
+                  SEGMENT_SUFFIX);
+
+    return m_directory + "/" + name;
+}
+}    // namespace wolkabout
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GATEWAYFILEPERSISTENCE_H
+#define GATEWAYFILEPERSISTENCE_H
+
+#include "persistence/GatewayPersistence.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Disk backed wolkabout::GatewayPersistence
+ *
+ * Messages are appended to memory mapped segment files of fixed size inside given directory.
+ * Position of first unread message is kept in a separate cursor file, so on startup only the
+ * last segment is scanned to find its end and no message is loaded into memory.
+ * Fully consumed segments are deleted, or rewound when it is the only one left. Pushing fails once maximum number
+ * of bytes on disk is reached.
+ *
+ * Delivery is at least once: messages popped after last sync may be delivered again after a crash.
+ */
+class GatewayFilePersistence : public GatewayPersistence
+{
+public:
+    /**
+     * @brief Opens persistence in given directory, recovering messages stored by previous instance
+     * @param directory Directory holding segment files, created if it does not exist
+     * @param segmentSize Size of single segment file in bytes, also the maximum size of single message
+     * @param maximumSize Maximum number of bytes occupied by segment files
+     * @param syncBatchSize Number of push/pop operations after which changes are synced to disk
+     */
+    GatewayFilePersistence(const std::string& directory, std::uint64_t segmentSize = DEFAULT_SEGMENT_SIZE,
+                           std::uint64_t maximumSize = DEFAULT_MAXIMUM_SIZE,
+                           std::uint32_t syncBatchSize = DEFAULT_SYNC_BATCH_SIZE);
+    ~GatewayFilePersistence();
+
+    bool push(std::shared_ptr<Message> message) override;
+    std::shared_ptr<Message> pop() override;
+    std::shared_ptr<Message> front() override;
+    bool empty() const override;
+
+    std::vector<std::shared_ptr<Message>> frontBatch(std::size_t count) override;
+    std::size_t popBatch(std::size_t count) override;
+
+    static constexpr std::uint64_t DEFAULT_SEGMENT_SIZE = 4 * 1024 * 1024;
+    static constexpr std::uint64_t DEFAULT_MAXIMUM_SIZE = 64 * 1024 * 1024;
+    static constexpr std::uint32_t DEFAULT_SYNC_BATCH_SIZE = 64;
+
+private:
+    struct Segment
+    {
+        std::uint64_t id;
+        int fd;
+        char* data;
+        std::uint64_t end;
+    };
+
+    void recover();
+
+    std::shared_ptr<Message> readFront();
+    std::shared_ptr<Message> popFront();
+
+    std::unique_ptr<Segment> openSegment(std::uint64_t id, bool create);
+    void closeSegment(Segment& segment, bool remove);
+
+    std::uint64_t scanSegment(const Segment& segment) const;
+    bool readRecord(const Segment& segment, std::uint64_t offset, std::shared_ptr<Message>& message,
+                    std::uint64_t& next) const;
+
+    bool hasRecordHeader(const Segment& segment, std::uint64_t offset) const;
+    void skipConsumedSegments();
+    void rewindConsumedSegment();
+    void writeCursor();
+    void sync(bool force);
+
+    std::string segmentPath(std::uint64_t id) const;
+
+    const std::string m_directory;
+    const std::uint64_t m_segmentSize;
+    const std::uint64_t m_maximumSegments;
+    const std::uint32_t m_syncBatchSize;
+
+    mutable std::mutex m_lock;
+
+    std::deque<std::unique_ptr<Segment>> m_segments;
+    std::uint64_t m_readOffset;
+
+    int m_cursorFd;
+    std::uint32_t m_unsyncedOperations;
+
+    std::shared_ptr<Message> m_front;
+    std::uint64_t m_frontNext;
+};
+}    // namespace wolkabout
+
+#endif
@@ -0,0 +1,452 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "persistence/filesystem/JournalPersistence.h"
+#include "model/ActuatorStatus.h"
+#include "model/Alarm.h"
+#include "model/ConfigurationItem.h"
+#include "model/SensorReading.h"
+#include "persistence/inmemory/InMemoryPersistence.h"
+#include "utilities/GatewayLog.h"
+#include "utilities/json.hpp"
+
+#include <cstdio>
+#include <iterator>
+#include <limits>
+#include <utility>
+
+namespace
+{
+using nlohmann::json;
+
+const std::string TYPE = "type";
+const std::string KEY = "key";
+const std::string REFERENCE = "reference";
+const std::string VALUES = "values";
+const std::string VALUE = "value";
+const std::string RTC = "rtc";
+const std::string ACTIVE = "active";
+const std::string STATE = "state";
+const std::string ITEMS = "items";
+const std::string COUNT = "count";
+
+const std::string SENSOR_READING = "sensor_reading";
+const std::string ALARM = "alarm";
+const std::string ACTUATOR_STATUS = "actuator_status";
+const std::string CONFIGURATION = "configuration";
+
+const std::string REMOVE_SENSOR_READINGS = "remove_sensor_readings";
+const std::string REMOVE_ALARMS = "remove_alarms";
+const std::string REMOVE_ACTUATOR_STATUS = "remove_actuator_status";
+const std::string REMOVE_CONFIGURATION = "remove_configuration";
+
+const std::uint_fast64_t ALL_ITEMS = std::numeric_limits<std::uint_fast64_t>::max();
+
+json makeRecord(const std::string& key, const wolkabout::SensorReading& sensorReading)
+{
+    return {{TYPE, SENSOR_READING},
+            {KEY, key},
+            {REFERENCE, sensorReading.getReference()},
+            {VALUES, sensorReading.getValues()},
+            {RTC, sensorReading.getRtc()}};
+}
+
+json makeRecord(const std::string& key, const wolkabout::Alarm& alarm)
+{
+    return {{TYPE, ALARM},
+            {KEY, key},
+            {REFERENCE, alarm.getReference()},
+            {ACTIVE, alarm.getActive()},
+            {RTC, alarm.getRtc()}};
+}
+
+json makeRecord(const std::string& key, const wolkabout::ActuatorStatus& actuatorStatus)
+{
+    return {{TYPE, ACTUATOR_STATUS},
+            {KEY, key},
+            {REFERENCE, actuatorStatus.getReference()},
+            {VALUE, actuatorStatus.getValue()},
+            {STATE, static_cast<int>(actuatorStatus.getState())}};
+}
+
+json makeRecord(const std::string& key, const std::vector<wolkabout::ConfigurationItem>& configuration)
+{
+    json items = json::array();
+    for (const auto& item : configuration)
+    {
+        items.push_back({{REFERENCE, item.getReference()}, {VALUES, item.getValues()}});
+    }
+
+    return {{TYPE, CONFIGURATION}, {KEY, key}, {ITEMS, items}};
+}
+
+json makeRemoveRecord(const std::string& type, const std::string& key, std::uint_fast64_t count = 1)
+{
+    return {{TYPE, type}, {KEY, key}, {COUNT, count}};
+}
+}    // namespace
+
+namespace wolkabout
+{
+constexpr std::size_t JournalPersistence::DEFAULT_COMPACTION_LINES;
+
+JournalPersistence::JournalPersistence(const std::string& file, std::size_t compactionLines)
+: m_file{file}, m_compactionLines{compactionLines}, m_items{new InMemoryPersistence()}, m_journalLines{0}
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    readJournal();
+
+    // replayed removals and torn entries are not carried over
+    writeJournal();
+    openJournal(std::ios::app);
+}
+
+bool JournalPersistence::putSensorReading(const std::string& key, std::shared_ptr<SensorReading> sensorReading)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    if (!sensorReading || !m_items->putSensorReading(key, sensorReading))
+    {
+        return false;
+    }
+
+    append(makeRecord(key, *sensorReading).dump());
+    return true;
+}
+
+std::vector<std::shared_ptr<SensorReading>> JournalPersistence::getSensorReadings(const std::string& key,
+                                                                                  std::uint_fast64_t count)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    return m_items->getSensorReadings(key, count);
+}
+
+void JournalPersistence::removeSensorReadings(const std::string& key, std::uint_fast64_t count)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    m_items->removeSensorReadings(key, count);
+    afterRemove(makeRemoveRecord(REMOVE_SENSOR_READINGS, key, count).dump());
+}
+
+std::vector<std::string> JournalPersistence::getSensorReadingsKeys()
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    return m_items->getSensorReadingsKeys();
+}
+
+bool JournalPersistence::putAlarm(const std::string& key, std::shared_ptr<Alarm> alarm)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    if (!alarm || !m_items->putAlarm(key, alarm))
+    {
+        return false;
+    }
+
+    append(makeRecord(key, *alarm).dump());
+    return true;
+}
+
+std::vector<std::shared_ptr<Alarm>> JournalPersistence::getAlarms(const std::string& key, std::uint_fast64_t count)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    return m_items->getAlarms(key, count);
+}
+
+void JournalPersistence::removeAlarms(const std::string& key, std::uint_fast64_t count)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    m_items->removeAlarms(key, count);
+    afterRemove(makeRemoveRecord(REMOVE_ALARMS, key, count).dump());
+}
+
+std::vector<std::string> JournalPersistence::getAlarmsKeys()
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    return m_items->getAlarmsKeys();
+}
+
+bool JournalPersistence::putActuatorStatus(const std::string& key, std::shared_ptr<ActuatorStatus> actuatorStatus)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    if (!actuatorStatus || !m_items->putActuatorStatus(key, actuatorStatus))
+    {
+        return false;
+    }
+
+    append(makeRecord(key, *actuatorStatus).dump());
+    return true;
+}
+
+std::shared_ptr<ActuatorStatus> JournalPersistence::getActuatorStatus(const std::string& key)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    return m_items->getActuatorStatus(key);
+}
+
+void JournalPersistence::removeActuatorStatus(const std::string& key)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    m_items->removeActuatorStatus(key);
+    afterRemove(makeRemoveRecord(REMOVE_ACTUATOR_STATUS, key).dump());
+}
+
+std::vector<std::string> JournalPersistence::getActuatorStatusesKeys()
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    return m_items->getActuatorStatusesKeys();
+}
+
+bool JournalPersistence::putConfiguration(const std::string& key,
+                                          std::shared_ptr<std::vector<ConfigurationItem>> configuration)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    if (!configuration || !m_items->putConfiguration(key, configuration))
+    {
+        return false;
+    }
+
+    append(makeRecord(key, *configuration).dump());
+    return true;
+}
+
+std::shared_ptr<std::vector<ConfigurationItem>> JournalPersistence::getConfiguration(const std::string& key)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    return m_items->getConfiguration(key);
+}
+
+void JournalPersistence::removeConfiguration(const std::string& key)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    m_items->removeConfiguration(key);
+    afterRemove(makeRemoveRecord(REMOVE_CONFIGURATION, key).dump());
+}
+
+std::vector<std::string> JournalPersistence::getConfigurationKeys()
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    return m_items->getConfigurationKeys();
+}
+
+bool JournalPersistence::isEmpty()
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    return m_items->isEmpty();
+}
+
+void JournalPersistence::readJournal()
+{
+    std::ifstream journal{m_file, std::ios::binary};
+    const std::string content{std::istreambuf_iterator<char>{journal}, std::istreambuf_iterator<char>{}};
+
+    std::string::size_type start = 0;
+    while (true)
+    {
+        const auto end = content.find('\n', start);
+        if (end == std::string::npos)
+        {
+            // line without terminator was cut short while being appended
+            if (start != content.size())
+            {
+                LOG(WARN) << "JournalPersistence: Discarding partially written entry in '" << m_file << "'";
+            }
+            break;
+        }
+
+        if (end != start)
+        {
+            replay(content.substr(start, end - start));
+        }
+
+        start = end + 1;
+    }
+}
+
+void JournalPersistence::replay(const std::string& line)
+{
+    try
+    {
+        const json record = json::parse(line);
+        const std::string type = record.at(TYPE).get<std::string>();
+        const std::string key = record.at(KEY).get<std::string>();
+
+        if (type == SENSOR_READING)
+        {
+            m_items->putSensorReading(key, std::make_shared<SensorReading>(
+                                             record.at(VALUES).get<std::vector<std::string>>(),
+                                             record.at(REFERENCE).get<std::string>(),
+                                             record.at(RTC).get<unsigned long long>()));
+        }
+        else if (type == ALARM)
+        {
+            m_items->putAlarm(key, std::make_shared<Alarm>(record.at(ACTIVE).get<bool>(),
+                                                           record.at(REFERENCE).get<std::string>(),
+                                                           record.at(RTC).get<unsigned long long>()));
+        }
+        else if (type == ACTUATOR_STATUS)
+        {
+            m_items->putActuatorStatus(
+              key, std::make_shared<ActuatorStatus>(record.at(VALUE).get<std::string>(),
+                                                    record.at(REFERENCE).get<std::string>(),
+                                                    static_cast<ActuatorStatus::State>(record.at(STATE).get<int>())));
+        }
+        else if (type == CONFIGURATION)
+        {
+            auto configuration = std::make_shared<std::vector<ConfigurationItem>>();
+            for (const auto& item : record.at(ITEMS))
+            {
+                configuration->emplace_back(item.at(VALUES).get<std::vector<std::string>>(),
+                                            item.at(REFERENCE).get<std::string>());
+            }
+
+            m_items->putConfiguration(key, configuration);
+        }
+        else if (type == REMOVE_SENSOR_READINGS)
+        {
+            m_items->removeSensorReadings(key, record.at(COUNT).get<std::uint_fast64_t>());
+        }
+        else if (type == REMOVE_ALARMS)
+        {
+            m_items->removeAlarms(key, record.at(COUNT).get<std::uint_fast64_t>());
+        }
+        else if (type == REMOVE_ACTUATOR_STATUS)
+        {
+            m_items->removeActuatorStatus(key);
+        }
+        else if (type == REMOVE_CONFIGURATION)
+        {
+            m_items->removeConfiguration(key);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        LOG(WARN) << "JournalPersistence: Discarding invalid entry in '" << m_file << "': " << e.what();
+    }
+}
+
+void JournalPersistence::append(const std::string& line)
+{
+    m_journal << line << '\n';
+    m_journal.flush();
+    ++m_journalLines;
+
+    if (!m_journal.good())
+    {
+        LOG(ERROR) << "JournalPersistence: Unable to append to '" << m_file << "'";
+    }
+
+    if (m_journalLines >= m_compactionLines)
+    {
+        m_journal.close();
+        writeJournal();
+        openJournal(std::ios::app);
+    }
+}
+
+void JournalPersistence::afterRemove(const std::string& line)
+{
+    if (!m_items->isEmpty())
+    {
+        append(line);
+        return;
+    }
+
+    // nothing left to recover, journal starts over
+    m_journal.close();
+    openJournal(std::ios::trunc);
+    m_journalLines = 0;
+}
+
+bool JournalPersistence::writeJournal()
+{
+    const std::string temporaryFilePath = m_file + ".tmp";
+    std::size_t lines = 0;
+
+    {
+        std::ofstream file{temporaryFilePath, std::ios::binary | std::ios::trunc};
+
+        for (const auto& key : m_items->getSensorReadingsKeys())
+        {
+            for (const auto& sensorReading : m_items->getSensorReadings(key, ALL_ITEMS))
+            {
+                file << makeRecord(key, *sensorReading).dump() << '\n';
+                ++lines;
+            }
+        }
+
+        for (const auto& key : m_items->getAlarmsKeys())
+        {
+            for (const auto& alarm : m_items->getAlarms(key, ALL_ITEMS))
+            {
+                file << makeRecord(key, *alarm).dump() << '\n';
+                ++lines;
+            }
+        }
+
+        for (const auto& key : m_items->getActuatorStatusesKeys())
+        {
+            if (const auto actuatorStatus = m_items->getActuatorStatus(key))
+            {
+                file << makeRecord(key, *actuatorStatus).dump() << '\n';
+                ++lines;
+            }
+        }
+
+        for (const auto& key : m_items->getConfigurationKeys())
+        {
+            if (const auto configuration = m_items->getConfiguration(key))
+            {
+                file << makeRecord(key, *configuration).dump() << '\n';
+                ++lines;
+            }
+        }
+
+        if (!file.good())
+        {
+            LOG(ERROR) << "JournalPersistence: Unable to write '" << temporaryFilePath << "'";
+            return false;
+        }
+    }
+
+    // rename replaces journal atomically, so a crash during compaction leaves the previous journal intact
+    if (std::rename(temporaryFilePath.c_str(), m_file.c_str()) != 0)
+    {
+        LOG(ERROR) << "JournalPersistence: Unable to replace '" << m_file << "'";
+        std::remove(temporaryFilePath.c_str());
+        return false;
+    }
+
+    m_journalLines = lines;
+    return true;
+}
+
+void JournalPersistence::openJournal(std::ios::openmode mode)
+{
+    m_journal.open(m_file, std::ios::binary | std::ios::out | mode);
+    if (!m_journal.is_open())
+    {
+        LOG(ERROR) << "JournalPersistence: Unable to open '" << m_file << "'";
+    }
+}
+}    // namespace wolkabout
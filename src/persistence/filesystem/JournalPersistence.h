@@ -0,0 +1,98 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef JOURNALPERSISTENCE_H
+#define JOURNALPERSISTENCE_H
+
+#include "persistence/Persistence.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Disk backed wolkabout::Persistence for data of the gateway itself
+ *
+ * Items are kept in memory by wolkabout::InMemoryPersistence, and every put and remove is appended to journal file
+ * as single line, which is replayed on opening. Journal is truncated whenever persistence becomes empty,
+ * which is the usual state after publishing, and is rewritten from current content on opening and
+ * once it grows past compactionLines lines.
+ */
+class JournalPersistence : public Persistence
+{
+public:
+    /**
+     * @brief Opens persistence, recovering items stored by previous instance
+     * @param file Path of journal file, created if it does not exist
+     * @param compactionLines Number of journal lines after which journal is rewritten from current content
+     */
+    explicit JournalPersistence(const std::string& file, std::size_t compactionLines = DEFAULT_COMPACTION_LINES);
+
+    bool putSensorReading(const std::string& key, std::shared_ptr<SensorReading> sensorReading) override;
+    std::vector<std::shared_ptr<SensorReading>> getSensorReadings(const std::string& key,
+                                                                  std::uint_fast64_t count) override;
+    void removeSensorReadings(const std::string& key, std::uint_fast64_t count) override;
+    std::vector<std::string> getSensorReadingsKeys() override;
+
+    bool putAlarm(const std::string& key, std::shared_ptr<Alarm> alarm) override;
+    std::vector<std::shared_ptr<Alarm>> getAlarms(const std::string& key, std::uint_fast64_t count) override;
+    void removeAlarms(const std::string& key, std::uint_fast64_t count) override;
+    std::vector<std::string> getAlarmsKeys() override;
+
+    bool putActuatorStatus(const std::string& key, std::shared_ptr<ActuatorStatus> actuatorStatus) override;
+    std::shared_ptr<ActuatorStatus> getActuatorStatus(const std::string& key) override;
+    void removeActuatorStatus(const std::string& key) override;
+    std::vector<std::string> getActuatorStatusesKeys() override;
+
+    bool putConfiguration(const std::string& key,
+                          std::shared_ptr<std::vector<ConfigurationItem>> configuration) override;
+    std::shared_ptr<std::vector<ConfigurationItem>> getConfiguration(const std::string& key) override;
+    void removeConfiguration(const std::string& key) override;
+    std::vector<std::string> getConfigurationKeys() override;
+
+    bool isEmpty() override;
+
+    static constexpr std::size_t DEFAULT_COMPACTION_LINES = 10000;
+
+private:
+    void readJournal();
+    void replay(const std::string& line);
+
+    void append(const std::string& line);
+    void afterRemove(const std::string& line);
+
+    bool writeJournal();
+    void openJournal(std::ios::openmode mode);
+
+    std::mutex m_mutex;
+
+    const std::string m_file;
+    const std::size_t m_compactionLines;
+
+    std::unique_ptr<Persistence> m_items;
+
+    std::ofstream m_journal;
+    std::size_t m_journalLines;
+};
+}    // namespace wolkabout
+
+#endif    // JOURNALPERSISTENCE_H
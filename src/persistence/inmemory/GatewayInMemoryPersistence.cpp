@@ -15,21 +15,75 @@
  */
 
 #include "persistence/inmemory/GatewayInMemoryPersistence.h"
+#include "model/Message.h"
+
+#include <algorithm>
+#include <utility>
 
 namespace wolkabout
 {
+GatewayInMemoryPersistence::GatewayInMemoryPersistence()
+: GatewayInMemoryPersistence(0, 0, OverflowPolicy::DROP_NEWEST)
+{
+}
+
+GatewayInMemoryPersistence::GatewayInMemoryPersistence(std::size_t maximumMessages, std::uint64_t maximumBytes,
+                                                       OverflowPolicy policy,
+                                                       std::unique_ptr<GatewayPersistence> spill,
+                                                       const std::string& name)
+: m_maximumMessages{maximumMessages}
+, m_maximumBytes{maximumBytes}
+, m_policy{policy}
+, m_spill{std::move(spill)}
+, m_bytes{0}
+, m_memory{MemoryBudget::getInstance().account(name)}
+, m_droppedOldestMessages{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_dropped_oldest_total")}
+, m_droppedNewestMessages{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_dropped_newest_total")}
+, m_downsampledMessages{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_downsampled_total")}
+, m_spilledMessages{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_spilled_total")}
+{
+}
+
+GatewayInMemoryPersistence::~GatewayInMemoryPersistence()
+{
+    m_memory.release(m_bytes);
+}
+
 bool GatewayInMemoryPersistence::push(std::shared_ptr<Message> message)
 {
     std::lock_guard<std::mutex> lg{m_lock};
-    m_queue.push(message);
+
+    const bool spilling = m_policy == OverflowPolicy::SPILL && m_spill && !m_spill->empty();
+    const auto size = sizeOf(*message);
+    if (spilling || !makeRoom(*message, size))
+    {
+        // messages after the first spilled one follow it to keep FIFO order
+        if (m_policy == OverflowPolicy::SPILL && m_spill && m_spill->push(message))
+        {
+            m_spilledMessages.increment();
+            return true;
+        }
+
+        m_droppedNewestMessages.increment();
+        return false;
+    }
+
+    m_queue.push_back(message);
+    m_bytes += size;
+    m_memory.add(size);
     return true;
 }
 
 std::shared_ptr<Message> GatewayInMemoryPersistence::pop()
 {
     std::lock_guard<std::mutex> lg{m_lock};
+    if (m_queue.empty())
+    {
+        return m_spill && !m_spill->empty() ? m_spill->pop() : nullptr;
+    }
+
     auto message = m_queue.front();
-    m_queue.pop();
+    popFront();
 
     return message;
 }
@@ -37,12 +91,118 @@ std::shared_ptr<Message> GatewayInMemoryPersistence::pop()
 std::shared_ptr<Message> GatewayInMemoryPersistence::front()
 {
     std::lock_guard<std::mutex> lg{m_lock};
+    if (m_queue.empty())
+    {
+        return m_spill && !m_spill->empty() ? m_spill->front() : nullptr;
+    }
+
     return m_queue.front();
 }
 
 bool GatewayInMemoryPersistence::empty() const
 {
     std::lock_guard<std::mutex> lg{m_lock};
-    return m_queue.empty();
+    return m_queue.empty() && (!m_spill || m_spill->empty());
+}
+
+std::vector<std::shared_ptr<Message>> GatewayInMemoryPersistence::frontBatch(std::size_t count)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    const auto end = m_queue.begin() + static_cast<std::ptrdiff_t>(std::min(count, m_queue.size()));
+    std::vector<std::shared_ptr<Message>> messages(m_queue.begin(), end);
+
+    if (m_spill && messages.size() < count)
+    {
+        const auto spilled = m_spill->frontBatch(count - messages.size());
+        messages.insert(messages.end(), spilled.begin(), spilled.end());
+    }
+
+    return messages;
+}
+
+std::size_t GatewayInMemoryPersistence::popBatch(std::size_t count)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    std::size_t removed = 0;
+    while (removed < count && !m_queue.empty())
+    {
+        popFront();
+        ++removed;
+    }
+
+    if (m_spill && removed < count)
+    {
+        removed += m_spill->popBatch(count - removed);
+    }
+
+    return removed;
+}
+
+bool GatewayInMemoryPersistence::fits(std::uint64_t size) const
+{
+    return (m_maximumMessages == 0 || m_queue.size() < m_maximumMessages) &&
+           (m_maximumBytes == 0 || m_bytes + size <= m_maximumBytes) && MemoryBudget::getInstance().allows(size);
+}
+
+bool GatewayInMemoryPersistence::makeRoom(const Message& message, std::uint64_t size)
+{
+    if (fits(size))
+    {
+        return true;
+    }
+
+    // nothing is dropped when even empty queue would exceed global budget taken by other buffers
+    if (m_policy == OverflowPolicy::DROP_OLDEST && (m_maximumBytes == 0 || size <= m_maximumBytes) &&
+        MemoryBudget::getInstance().allows(size > m_bytes ? size - m_bytes : 0))
+    {
+        while (!fits(size) && !m_queue.empty())
+        {
+            popFront();
+            m_droppedOldestMessages.increment();
+        }
+
+        return fits(size);
+    }
+
+    if (m_policy == OverflowPolicy::DOWNSAMPLE)
+    {
+        auto it = m_queue.begin();
+        while (!fits(size))
+        {
+            it = std::find_if(it, m_queue.end(), [&](const std::shared_ptr<Message>& queued) {
+                return queued->getChannel() == message.getChannel();
+            });
+
+            if (it == m_queue.end())
+            {
+                return false;
+            }
+
+            const auto erasedSize = sizeOf(**it);
+            m_bytes -= erasedSize;
+            m_memory.release(erasedSize);
+            it = m_queue.erase(it);
+            m_downsampledMessages.increment();
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+void GatewayInMemoryPersistence::popFront()
+{
+    const auto size = sizeOf(*m_queue.front());
+    m_bytes -= size;
+    m_memory.release(size);
+    m_queue.pop_front();
+}
+
+std::uint64_t GatewayInMemoryPersistence::sizeOf(const Message& message)
+{
+    return message.getChannel().size() + message.getContent().size();
 }
 }    // namespace wolkabout
@@ -18,22 +18,87 @@
 #define GATEWAYINMEMORYPERSISTENCE_H
 
 #include "persistence/GatewayPersistence.h"
+#include "utilities/MemoryBudget.h"
+#include "utilities/Metrics.h"
+
+#include <cstdint>
+#include <deque>
+#include <memory>
 #include <mutex>
-#include <queue>
+#include <string>
 
 namespace wolkabout
 {
+/**
+ * @brief wolkabout::GatewayPersistence keeping messages in memory
+ *
+ * Queue can be bounded by number of messages and by bytes of channels and payloads held.
+ * What happens to a message which does not fit is decided by overflow policy.
+ * Held bytes are accounted in wolkabout::MemoryBudget under name of the instance, and message which
+ * would exceed global budget does not fit either.
+ */
 class GatewayInMemoryPersistence : public GatewayPersistence
 {
 public:
+    enum class OverflowPolicy
+    {
+        DROP_OLDEST,
+        DROP_NEWEST,
+        DOWNSAMPLE,
+        SPILL
+    };
+
+    /**
+     * @brief Creates unbounded persistence
+     */
+    GatewayInMemoryPersistence();
+
+    /**
+     * @param maximumMessages Maximum number of messages in memory, 0 for no limit
+     * @param maximumBytes Maximum size of messages in memory, 0 for no limit
+     * @param policy Applied to message which does not fit:
+     * DROP_OLDEST removes oldest messages until it fits,
+     * DROP_NEWEST rejects it,
+     * DOWNSAMPLE removes oldest messages on its channel until it fits and rejects it if that is not enough,
+     * SPILL pushes it and all messages after it to spill persistence until spill persistence is drained
+     * @param spill Persistence receiving overflow when policy is SPILL, messages are rejected without it
+     * @param name Prefix of metrics reported by this instance
+     */
+    GatewayInMemoryPersistence(std::size_t maximumMessages, std::uint64_t maximumBytes, OverflowPolicy policy,
+                               std::unique_ptr<GatewayPersistence> spill = nullptr,
+                               const std::string& name = "in_memory_queue");
+
+    ~GatewayInMemoryPersistence() override;
+
     bool push(std::shared_ptr<Message> message) override;
     std::shared_ptr<Message> pop() override;
     std::shared_ptr<Message> front() override;
     bool empty() const override;
 
+    std::vector<std::shared_ptr<Message>> frontBatch(std::size_t count) override;
+    std::size_t popBatch(std::size_t count) override;
+
 private:
+    bool fits(std::uint64_t size) const;
+    bool makeRoom(const Message& message, std::uint64_t size);
+    void popFront();
+
+    static std::uint64_t sizeOf(const Message& message);
+
+    const std::size_t m_maximumMessages;
+    const std::uint64_t m_maximumBytes;
+    const OverflowPolicy m_policy;
+    const std::unique_ptr<GatewayPersistence> m_spill;
+
     mutable std::mutex m_lock;
-    std::queue<std::shared_ptr<Message>> m_queue;
+    std::deque<std::shared_ptr<Message>> m_queue;
+    std::uint64_t m_bytes;
+    MemoryAccount& m_memory;
+
+    Counter& m_droppedOldestMessages;
+    Counter& m_droppedNewestMessages;
+    Counter& m_downsampledMessages;
+    Counter& m_spilledMessages;
 };
 }    // namespace wolkabout
 
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "persistence/inmemory/GatewayRingBufferPersistence.h"
+#include "model/Message.h"
+
+#include <cstdint>
+#include <utility>
+
+namespace wolkabout
+{
+constexpr std::size_t GatewayRingBufferPersistence::DEFAULT_CAPACITY;
+constexpr std::size_t GatewayRingBufferPersistence::CACHE_LINE_SIZE;
+
+GatewayRingBufferPersistence::GatewayRingBufferPersistence(std::size_t capacity, const std::string& name)
+: m_mask{roundUpToPowerOfTwo(capacity) - 1}
+, m_cells{new Cell[m_mask + 1]}
+, m_memory{MemoryBudget::getInstance().account(name)}
+, m_headPadding{}
+, m_head{0}
+, m_tailPadding{}
+, m_tail{0}
+, m_endPadding{}
+{
+    for (std::size_t i = 0; i <= m_mask; ++i)
+    {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+GatewayRingBufferPersistence::~GatewayRingBufferPersistence()
+{
+    while (pop())
+    {
+    }
+}
+
+bool GatewayRingBufferPersistence::push(std::shared_ptr<Message> message)
+{
+    const auto size = sizeOf(*message);
+    if (!MemoryBudget::getInstance().allows(size))
+    {
+        return false;
+    }
+
+    std::size_t position = m_tail.load(std::memory_order_relaxed);
+    while (true)
+    {
+        Cell& cell = m_cells[position & m_mask];
+        const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+
+        if (difference == 0)
+        {
+            if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+            {
+                m_memory.add(size);
+                cell.message = std::move(message);
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (difference < 0)
+        {
+            // cell still holds message from previous lap
+            return false;
+        }
+        else
+        {
+            position = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+std::shared_ptr<Message> GatewayRingBufferPersistence::pop()
+{
+    const std::size_t position = m_head.load(std::memory_order_relaxed);
+    if (!isReady(position))
+    {
+        return nullptr;
+    }
+
+    Cell& cell = m_cells[position & m_mask];
+    auto message = std::move(cell.message);
+    cell.message.reset();
+    cell.sequence.store(position + m_mask + 1, std::memory_order_release);
+    m_head.store(position + 1, std::memory_order_relaxed);
+
+    m_memory.release(sizeOf(*message));
+    return message;
+}
+
+std::shared_ptr<Message> GatewayRingBufferPersistence::front()
+{
+    const std::size_t position = m_head.load(std::memory_order_relaxed);
+    return isReady(position) ? m_cells[position & m_mask].message : nullptr;
+}
+
+bool GatewayRingBufferPersistence::empty() const
+{
+    return !isReady(m_head.load(std::memory_order_relaxed));
+}
+
+std::vector<std::shared_ptr<Message>> GatewayRingBufferPersistence::frontBatch(std::size_t count)
+{
+    std::vector<std::shared_ptr<Message>> messages;
+
+    std::size_t position = m_head.load(std::memory_order_relaxed);
+    while (messages.size() < count && isReady(position))
+    {
+        messages.push_back(m_cells[position & m_mask].message);
+        ++position;
+    }
+
+    return messages;
+}
+
+std::size_t GatewayRingBufferPersistence::popBatch(std::size_t count)
+{
+    std::size_t removed = 0;
+    while (removed < count && isReady(m_head.load(std::memory_order_relaxed)))
+    {
+        pop();
+        ++removed;
+    }
+
+    return removed;
+}
+
+std::size_t GatewayRingBufferPersistence::capacity() const
+{
+    return m_mask + 1;
+}
+
+bool GatewayRingBufferPersistence::isReady(std::size_t position) const
+{
+    return m_cells[position & m_mask].sequence.load(std::memory_order_acquire) == position + 1;
+}
+
+std::size_t GatewayRingBufferPersistence::roundUpToPowerOfTwo(std::size_t value)
+{
+    // a single cell could not tell a free cell from one holding message of the current lap
+    std::size_t power = 2;
+    while (power < value)
+    {
+        power <<= 1;
+    }
+
+    return power;
+}
+
+std::uint64_t GatewayRingBufferPersistence::sizeOf(const Message& message)
+{
+    return message.getChannel().size() + message.getContent().size();
+}
+}    // namespace wolkabout
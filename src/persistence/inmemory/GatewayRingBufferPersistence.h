@@ -0,0 +1,91 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GATEWAYRINGBUFFERPERSISTENCE_H
+#define GATEWAYRINGBUFFERPERSISTENCE_H
+
+#include "persistence/GatewayPersistence.h"
+#include "utilities/MemoryBudget.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Bounded lock free wolkabout::GatewayPersistence for many producers and a single consumer
+ *
+ * Messages are kept in a ring of cells, each with a sequence number telling whether it is free or holds a message,
+ * so producers only compete for the tail index and never wait on the consumer.
+ * Head and tail indices are kept on separate cache lines to avoid false sharing between producers and consumer.
+ *
+ * push may be called from any thread, all other methods must be called from a single consumer thread.
+ * Pushing fails when the ring is full, or when message would exceed wolkabout::MemoryBudget.
+ */
+class GatewayRingBufferPersistence : public GatewayPersistence
+{
+public:
+    /**
+     * @param capacity Maximum number of messages, rounded up to a power of two not smaller than 2
+     * @param name Component under which held bytes are accounted in wolkabout::MemoryBudget
+     */
+    explicit GatewayRingBufferPersistence(std::size_t capacity = DEFAULT_CAPACITY,
+                                          const std::string& name = "ring_buffer_queue");
+    ~GatewayRingBufferPersistence() override;
+
+    bool push(std::shared_ptr<Message> message) override;
+    std::shared_ptr<Message> pop() override;
+    std::shared_ptr<Message> front() override;
+    bool empty() const override;
+
+    std::vector<std::shared_ptr<Message>> frontBatch(std::size_t count) override;
+    std::size_t popBatch(std::size_t count) override;
+
+    std::size_t capacity() const;
+
+    static constexpr std::size_t DEFAULT_CAPACITY = 65536;
+
+private:
+    static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+    struct Cell
+    {
+        std::atomic<std::size_t> sequence;
+        std::shared_ptr<Message> message;
+    };
+
+    bool isReady(std::size_t position) const;
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t value);
+    static std::uint64_t sizeOf(const Message& message);
+
+    const std::size_t m_mask;
+    const std::unique_ptr<Cell[]> m_cells;
+    MemoryAccount& m_memory;
+
+    char m_headPadding[CACHE_LINE_SIZE];
+    std::atomic<std::size_t> m_head;
+    char m_tailPadding[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+    std::atomic<std::size_t> m_tail;
+    char m_endPadding[CACHE_LINE_SIZE - sizeof(std::atomic<std::size_t>)];
+};
+}    // namespace wolkabout
+
+#endif    // GATEWAYRINGBUFFERPERSISTENCE_H
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DATACHANNELVIEW_H
+#define DATACHANNELVIEW_H
+
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * @brief Result of parsing device data channel in a single pass
+ *
+ * Device key and reference are kept as positions into the parsed channel instead of copies,
+ * so the channel must outlive the view.
+ */
+class DataChannelView
+{
+public:
+    enum class Type
+    {
+        UNKNOWN,
+        SENSOR_READING,
+        ALARM,
+        ACTUATOR_STATUS,
+        CONFIGURATION_CURRENT
+    };
+
+    DataChannelView()
+    : m_channel{nullptr}
+    , m_type{Type::UNKNOWN}
+    , m_deviceKeyPosition{0}
+    , m_deviceKeyLength{0}
+    , m_referencePosition{0}
+    , m_referenceLength{0}
+    {
+    }
+
+    DataChannelView(const std::string& channel, Type type, std::string::size_type deviceKeyPosition,
+                    std::string::size_type deviceKeyLength, std::string::size_type referencePosition,
+                    std::string::size_type referenceLength)
+    : m_channel{&channel}
+    , m_type{type}
+    , m_deviceKeyPosition{deviceKeyPosition}
+    , m_deviceKeyLength{deviceKeyLength}
+    , m_referencePosition{referencePosition}
+    , m_referenceLength{referenceLength}
+    {
+    }
+
+    Type getType() const { return m_type; }
+
+    bool hasDeviceKey() const { return m_deviceKeyLength != 0; }
+    bool hasReference() const { return m_referenceLength != 0; }
+
+    std::string getDeviceKey() const
+    {
+        return hasDeviceKey() ? m_channel->substr(m_deviceKeyPosition, m_deviceKeyLength) : "";
+    }
+
+    /**
+     * @brief Returns position just past device key in channel, 0 if channel has no device key
+     */
+    std::string::size_type getDeviceKeyEnd() const
+    {
+        return hasDeviceKey() ? m_deviceKeyPosition + m_deviceKeyLength : 0;
+    }
+
+    std::string getReference() const
+    {
+        return hasReference() ? m_channel->substr(m_referencePosition, m_referenceLength) : "";
+    }
+
+private:
+    const std::string* m_channel;
+    Type m_type;
+
+    std::string::size_type m_deviceKeyPosition;
+    std::string::size_type m_deviceKeyLength;
+    std::string::size_type m_referencePosition;
+    std::string::size_type m_referenceLength;
+};
+}    // namespace wolkabout
+
+#endif    // DATACHANNELVIEW_H
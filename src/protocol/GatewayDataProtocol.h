@@ -17,6 +17,8 @@
 #ifndef GATEWAYDATAPROTOCOL_H
 #define GATEWAYDATAPROTOCOL_H
 
+#include "model/DeliveryClass.h"
+#include "protocol/DataChannelView.h"
 #include "protocol/GatewayProtocol.h"
 
 #include <memory>
@@ -33,6 +35,11 @@ class ActuatorGetCommand;
 class GatewayDataProtocol : public GatewayProtocol
 {
 public:
+    /**
+     * @brief Makes actuator get request for subdevice
+     * Command with empty reference requests statuses of all actuators of device in one batch,
+     * empty device key requests them from all devices
+     */
     virtual std::unique_ptr<Message> makeMessage(const std::string& deviceKey,
                                                  const ActuatorGetCommand& command) const = 0;
 
@@ -41,10 +48,42 @@ public:
     virtual bool isActuatorStatusMessage(const Message& message) const = 0;
     virtual bool isConfigurationCurrentMessage(const Message& message) const = 0;
 
+    /**
+     * @brief Selects delivery guarantee of message published to platform
+     * @param message Message on platform channel
+     * @return DeliveryClass::AT_MOST_ONCE for telemetry superseded by later messages, DeliveryClass::AT_LEAST_ONCE
+     * for everything else
+     */
+    virtual DeliveryClass getDeliveryClass(const Message& message) const = 0;
+
+    /**
+     * @brief Classifies device data channel and locates device key and reference in it
+     * @param channel Channel on which device published, must outlive returned view
+     * @return View with type DataChannelView::Type::UNKNOWN if channel is not a device data channel
+     */
+    virtual DataChannelView parseDeviceChannel(const std::string& channel) const = 0;
+
     virtual std::string routePlatformToDeviceMessage(const std::string& topic, const std::string& gatewayKey) const = 0;
     virtual std::string routeDeviceToPlatformMessage(const std::string& topic, const std::string& gatewayKey) const = 0;
 
     virtual std::string extractReferenceFromChannel(const std::string& topic) const = 0;
+
+    /**
+     * @brief Splits batch of actuator statuses device published on actuator status channel without reference
+     * @param channel Device channel batch was published on
+     * @param payload Batch content
+     * @return One actuator status message per reference, on device channel with reference, empty if batch is invalid
+     */
+    virtual std::vector<std::unique_ptr<Message>> splitActuatorStatusBatch(const std::string& channel,
+                                                                           const std::string& payload) const = 0;
+
+    /**
+     * @brief Merges two configuration set requests for the same device into one
+     * @param payload Content of earlier request
+     * @param laterPayload Content of later request, its values replace values of the same references
+     * @return Content of merged request, empty if either request is invalid
+     */
+    virtual std::string mergeConfigurationSet(const std::string& payload, const std::string& laterPayload) const = 0;
 };
 }    // namespace wolkabout
 
@@ -24,6 +24,8 @@
 
 namespace wolkabout
 {
+class FirmwareChunk;
+class FirmwareChunkRequest;
 class FirmwareUpdateAbort;
 class FirmwareUpdateInstall;
 class FirmwareUpdateStatus;
@@ -42,6 +44,13 @@ public:
     virtual std::unique_ptr<FirmwareVersion> makeFirmwareVersion(const Message& message) const = 0;
 
     virtual std::unique_ptr<FirmwareUpdateStatus> makeFirmwareUpdateStatus(const Message& message) const = 0;
+
+    /**
+     * @brief Makes message carrying firmware chunk to the device that requested it
+     */
+    virtual std::unique_ptr<Message> makeMessage(const std::string& gatewayKey, const FirmwareChunk& chunk) const = 0;
+
+    virtual std::unique_ptr<FirmwareChunkRequest> makeFirmwareChunkRequest(const Message& message) const = 0;
 };
 }    // namespace wolkabout
 
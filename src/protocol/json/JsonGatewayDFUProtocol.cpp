@@ -15,13 +15,15 @@
  */
 
 #include "protocol/json/JsonGatewayDFUProtocol.h"
+#include "model/FirmwareChunk.h"
+#include "model/FirmwareChunkRequest.h"
 #include "model/FirmwareUpdateAbort.h"
 #include "model/FirmwareUpdateInstall.h"
 #include "model/FirmwareUpdateStatus.h"
 #include "model/FirmwareVersion.h"
 #include "model/Message.h"
 #include "protocol/json/Json.h"
-#include "utilities/Logger.h"
+#include "utilities/GatewayLog.h"
 #include "utilities/StringUtils.h"
 #include "utilities/json.hpp"
 
@@ -31,9 +33,11 @@ namespace wolkabout
 {
 const std::string JsonGatewayDFUProtocol::FIRMWARE_UPDATE_STATUS_TOPIC_ROOT = "d2p/firmware_update_status/";
 const std::string JsonGatewayDFUProtocol::FIRMWARE_VERSION_TOPIC_ROOT = "d2p/firmware_version_update/";
+const std::string JsonGatewayDFUProtocol::FIRMWARE_CHUNK_REQUEST_TOPIC_ROOT = "d2p/firmware_chunk_request/";
 
 const std::string JsonGatewayDFUProtocol::FIRMWARE_UPDATE_INSTALL_TOPIC_ROOT = "p2d/firmware_update_install/";
 const std::string JsonGatewayDFUProtocol::FIRMWARE_UPDATE_ABORT_TOPIC_ROOT = "p2d/firmware_update_abort/";
+const std::string JsonGatewayDFUProtocol::FIRMWARE_CHUNK_TOPIC_ROOT = "p2d/firmware_chunk/";
 
 /*** FIRMWARE UPDATE ABORT ***/
 void to_json(json& j, const FirmwareUpdateAbort& command)
@@ -108,19 +112,21 @@ static FirmwareUpdateStatus firmware_update_status_from_json(const json& j)
 std::vector<std::string> JsonGatewayDFUProtocol::getInboundChannels() const
 {
     return {FIRMWARE_UPDATE_STATUS_TOPIC_ROOT + DEVICE_PATH_PREFIX + CHANNEL_MULTI_LEVEL_WILDCARD,
-            FIRMWARE_VERSION_TOPIC_ROOT + DEVICE_PATH_PREFIX + CHANNEL_MULTI_LEVEL_WILDCARD};
+            FIRMWARE_VERSION_TOPIC_ROOT + DEVICE_PATH_PREFIX + CHANNEL_MULTI_LEVEL_WILDCARD,
+            FIRMWARE_CHUNK_REQUEST_TOPIC_ROOT + DEVICE_PATH_PREFIX + CHANNEL_MULTI_LEVEL_WILDCARD};
 }
 
 std::vector<std::string> JsonGatewayDFUProtocol::getInboundChannelsForDevice(const std::string& deviceKey) const
 {
     return {FIRMWARE_UPDATE_STATUS_TOPIC_ROOT + DEVICE_PATH_PREFIX + deviceKey,
-            FIRMWARE_VERSION_TOPIC_ROOT + DEVICE_PATH_PREFIX + deviceKey};
+            FIRMWARE_VERSION_TOPIC_ROOT + DEVICE_PATH_PREFIX + deviceKey,
+            FIRMWARE_CHUNK_REQUEST_TOPIC_ROOT + DEVICE_PATH_PREFIX + deviceKey};
 }
 
 std::unique_ptr<Message> JsonGatewayDFUProtocol::makeMessage(const std::string& gatewayKey,
                                                              const FirmwareUpdateAbort& command) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (command.getDeviceKeys().size() != 1)
     {
@@ -138,12 +144,13 @@ std::unique_ptr<Message> JsonGatewayDFUProtocol::makeMessage(const std::string&
     }
     catch (const std::exception& e)
     {
-        LOG(DEBUG) << "Gateway firmware update protocol: Unable to serialize firmware abort command: " << e.what();
+        GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to serialize firmware abort command: "
+                           << e.what();
         return nullptr;
     }
     catch (...)
     {
-        LOG(DEBUG) << "Gateway firmware update protocol: Unable to serialize firmware abort command";
+        GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to serialize firmware abort command";
         return nullptr;
     }
 }
@@ -151,7 +158,7 @@ std::unique_ptr<Message> JsonGatewayDFUProtocol::makeMessage(const std::string&
 std::unique_ptr<Message> JsonGatewayDFUProtocol::makeMessage(const std::string& gatewayKey,
                                                              const FirmwareUpdateInstall& command) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (command.getDeviceKeys().size() != 1)
     {
@@ -169,19 +176,20 @@ std::unique_ptr<Message> JsonGatewayDFUProtocol::makeMessage(const std::string&
     }
     catch (const std::exception& e)
     {
-        LOG(DEBUG) << "Gateway firmware update protocol: Unable to serialize firmware install command: " << e.what();
+        GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to serialize firmware install command: "
+                           << e.what();
         return nullptr;
     }
     catch (...)
     {
-        LOG(DEBUG) << "Gateway firmware update protocol: Unable to serialize firmware install command";
+        GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to serialize firmware install command";
         return nullptr;
     }
 }
 
 std::unique_ptr<FirmwareVersion> JsonGatewayDFUProtocol::makeFirmwareVersion(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (!StringUtils::startsWith(message.getChannel(), FIRMWARE_VERSION_TOPIC_ROOT))
     {
@@ -193,7 +201,8 @@ std::unique_ptr<FirmwareVersion> JsonGatewayDFUProtocol::makeFirmwareVersion(con
         const auto key = extractDeviceKeyFromChannel(message.getChannel());
         if (key.empty())
         {
-            LOG(DEBUG) << "Gateway firmware update protocol: Unable to extract device key: " << message.getChannel();
+            GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to extract device key: "
+                               << message.getChannel();
             return nullptr;
         }
 
@@ -203,12 +212,12 @@ std::unique_ptr<FirmwareVersion> JsonGatewayDFUProtocol::makeFirmwareVersion(con
     }
     catch (const std::exception& e)
     {
-        LOG(DEBUG) << "Gateway firmware update protocol: Unable to deserialize firmware version: " << e.what();
+        GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to deserialize firmware version: " << e.what();
         return nullptr;
     }
     catch (...)
     {
-        LOG(DEBUG) << "Gateway firmware update protocol: Unable to deserialize firmware version";
+        GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to deserialize firmware version";
         return nullptr;
     }
 }
@@ -216,7 +225,7 @@ std::unique_ptr<FirmwareVersion> JsonGatewayDFUProtocol::makeFirmwareVersion(con
 std::unique_ptr<FirmwareUpdateStatus> JsonGatewayDFUProtocol::makeFirmwareUpdateStatus(
   const wolkabout::Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (!StringUtils::startsWith(message.getChannel(), FIRMWARE_UPDATE_STATUS_TOPIC_ROOT))
     {
@@ -228,7 +237,8 @@ std::unique_ptr<FirmwareUpdateStatus> JsonGatewayDFUProtocol::makeFirmwareUpdate
         const auto key = extractDeviceKeyFromChannel(message.getChannel());
         if (key.empty())
         {
-            LOG(DEBUG) << "Gateway firmware update protocol: Unable to extract device key: " << message.getChannel();
+            GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to extract device key: "
+                               << message.getChannel();
             return nullptr;
         }
 
@@ -244,12 +254,88 @@ std::unique_ptr<FirmwareUpdateStatus> JsonGatewayDFUProtocol::makeFirmwareUpdate
     }
     catch (const std::exception& e)
     {
-        LOG(DEBUG) << "Gateway firmware update protocol: Unable to deserialize firmware update status: " << e.what();
+        GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to deserialize firmware update status: "
+                           << e.what();
         return nullptr;
     }
     catch (...)
     {
-        LOG(DEBUG) << "Gateway firmware update protocol: Unable to deserialize firmware update status";
+        GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to deserialize firmware update status";
+        return nullptr;
+    }
+}
+
+std::unique_ptr<Message> JsonGatewayDFUProtocol::makeMessage(const std::string& gatewayKey,
+                                                             const FirmwareChunk& chunk) const
+{
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
+
+    if (chunk.getDeviceKey().empty())
+    {
+        return nullptr;
+    }
+
+    const std::size_t hashSize = chunk.getHash().size();
+    if (!chunk.getPreviousHash().empty() && chunk.getPreviousHash().size() != hashSize)
+    {
+        GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Firmware chunk hashes differ in size";
+        return nullptr;
+    }
+
+    std::string payload;
+    payload.reserve(hashSize + chunk.getSize() + hashSize);
+
+    if (chunk.getPreviousHash().empty())
+    {
+        payload.append(hashSize, '\0');
+    }
+    else
+    {
+        payload.append(chunk.getPreviousHash().begin(), chunk.getPreviousHash().end());
+    }
+
+    payload.append(reinterpret_cast<const char*>(chunk.getData()), chunk.getSize());
+    payload.append(chunk.getHash().begin(), chunk.getHash().end());
+
+    const std::string topic = FIRMWARE_CHUNK_TOPIC_ROOT + DEVICE_PATH_PREFIX + chunk.getDeviceKey();
+
+    return std::unique_ptr<Message>(new Message(std::move(payload), topic));
+}
+
+std::unique_ptr<FirmwareChunkRequest> JsonGatewayDFUProtocol::makeFirmwareChunkRequest(const Message& message) const
+{
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
+
+    if (!StringUtils::startsWith(message.getChannel(), FIRMWARE_CHUNK_REQUEST_TOPIC_ROOT))
+    {
+        return nullptr;
+    }
+
+    try
+    {
+        const auto key = extractDeviceKeyFromChannel(message.getChannel());
+        if (key.empty())
+        {
+            GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to extract device key: "
+                               << message.getChannel();
+            return nullptr;
+        }
+
+        const json j = json::parse(message.getContent());
+        const auto fileName = j.at("fileName").get<std::string>();
+        const auto chunkIndex = j.at("chunkIndex").get<std::uint64_t>();
+
+        return std::unique_ptr<FirmwareChunkRequest>(new FirmwareChunkRequest(key, fileName, chunkIndex));
+    }
+    catch (const std::exception& e)
+    {
+        GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to deserialize firmware chunk request: "
+                           << e.what();
+        return nullptr;
+    }
+    catch (...)
+    {
+        GATEWAY_LOG(DEBUG) << "Gateway firmware update protocol: Unable to deserialize firmware chunk request";
         return nullptr;
     }
 }
@@ -37,12 +37,22 @@ public:
 
     std::unique_ptr<FirmwareUpdateStatus> makeFirmwareUpdateStatus(const Message& message) const override;
 
+    /**
+     * @brief Chunk content is hash of previous chunk, zeros for the first one, followed by chunk data and its hash.
+     * Same layout as file packets sent by platform
+     */
+    std::unique_ptr<Message> makeMessage(const std::string& gatewayKey, const FirmwareChunk& chunk) const override;
+
+    std::unique_ptr<FirmwareChunkRequest> makeFirmwareChunkRequest(const Message& message) const override;
+
 private:
     static const std::string FIRMWARE_UPDATE_STATUS_TOPIC_ROOT;
     static const std::string FIRMWARE_VERSION_TOPIC_ROOT;
+    static const std::string FIRMWARE_CHUNK_REQUEST_TOPIC_ROOT;
 
     static const std::string FIRMWARE_UPDATE_INSTALL_TOPIC_ROOT;
     static const std::string FIRMWARE_UPDATE_ABORT_TOPIC_ROOT;
+    static const std::string FIRMWARE_CHUNK_TOPIC_ROOT;
 };
 }    // namespace wolkabout
 
@@ -21,7 +21,7 @@
 #include "model/Alarm.h"
 #include "model/Message.h"
 #include "protocol/json/Json.h"
-#include "utilities/Logger.h"
+#include "utilities/GatewayLog.h"
 #include "utilities/StringUtils.h"
 #include "utilities/json.hpp"
 
@@ -41,6 +41,9 @@ const std::string JsonGatewayDataProtocol::ACTUATION_GET_TOPIC_ROOT = "p2d/actua
 const std::string JsonGatewayDataProtocol::CONFIGURATION_SET_REQUEST_TOPIC_ROOT = "p2d/configuration_set/";
 const std::string JsonGatewayDataProtocol::CONFIGURATION_GET_REQUEST_TOPIC_ROOT = "p2d/configuration_get/";
 
+const std::string JsonGatewayDataProtocol::ACTUATOR_STATUS_REFERENCE_FIELD = "reference";
+const std::string JsonGatewayDataProtocol::CONFIGURATION_VALUES_FIELD = "values";
+
 static void to_json(json& j, const ActuatorStatus& p)
 {
     const std::string status = [&]() -> std::string {
@@ -81,6 +84,7 @@ std::vector<std::string> JsonGatewayDataProtocol::getInboundChannels() const
               REFERENCE_PATH_PREFIX + CHANNEL_MULTI_LEVEL_WILDCARD,
             ACTUATION_STATUS_TOPIC_ROOT + DEVICE_PATH_PREFIX + CHANNEL_SINGLE_LEVEL_WILDCARD + CHANNEL_DELIMITER +
               REFERENCE_PATH_PREFIX + CHANNEL_MULTI_LEVEL_WILDCARD,
+            ACTUATION_STATUS_TOPIC_ROOT + DEVICE_PATH_PREFIX + CHANNEL_SINGLE_LEVEL_WILDCARD,
             CONFIGURATION_RESPONSE_TOPIC_ROOT + DEVICE_PATH_PREFIX + CHANNEL_MULTI_LEVEL_WILDCARD};
 }
 
@@ -92,20 +96,25 @@ std::vector<std::string> JsonGatewayDataProtocol::getInboundChannelsForDevice(co
               CHANNEL_MULTI_LEVEL_WILDCARD,
             ACTUATION_STATUS_TOPIC_ROOT + DEVICE_PATH_PREFIX + deviceKey + CHANNEL_DELIMITER + REFERENCE_PATH_PREFIX +
               CHANNEL_MULTI_LEVEL_WILDCARD,
+            ACTUATION_STATUS_TOPIC_ROOT + DEVICE_PATH_PREFIX + deviceKey,
             CONFIGURATION_RESPONSE_TOPIC_ROOT + DEVICE_PATH_PREFIX + deviceKey};
 }
 
 std::unique_ptr<Message> JsonGatewayDataProtocol::makeMessage(const std::string& deviceKey,
                                                               const ActuatorGetCommand& command) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     std::string topic;
-    if (!deviceKey.empty())
+    if (!deviceKey.empty() && !command.getReference().empty())
     {
         topic = ACTUATION_GET_TOPIC_ROOT + DEVICE_PATH_PREFIX + deviceKey + CHANNEL_DELIMITER + REFERENCE_PATH_PREFIX +
                 command.getReference();
     }
+    else if (!deviceKey.empty())
+    {
+        topic = ACTUATION_GET_TOPIC_ROOT + DEVICE_PATH_PREFIX + deviceKey;
+    }
     else
     {
         topic = ACTUATION_GET_TOPIC_ROOT + DEVICE_PATH_PREFIX;
@@ -116,41 +125,119 @@ std::unique_ptr<Message> JsonGatewayDataProtocol::makeMessage(const std::string&
 
 bool JsonGatewayDataProtocol::isSensorReadingMessage(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     return StringUtils::startsWith(message.getChannel(), SENSOR_READING_TOPIC_ROOT);
 }
 
 bool JsonGatewayDataProtocol::isAlarmMessage(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     return StringUtils::startsWith(message.getChannel(), EVENTS_TOPIC_ROOT);
 }
 
 bool JsonGatewayDataProtocol::isActuatorStatusMessage(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     return StringUtils::startsWith(message.getChannel(), ACTUATION_STATUS_TOPIC_ROOT);
 }
 
 bool JsonGatewayDataProtocol::isConfigurationCurrentMessage(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     return StringUtils::startsWith(message.getChannel(), CONFIGURATION_RESPONSE_TOPIC_ROOT);
 }
 
+DeliveryClass JsonGatewayDataProtocol::getDeliveryClass(const Message& message) const
+{
+    // alarms, actuator statuses and configuration report state changes, only readings are resent periodically
+    return isSensorReadingMessage(message) ? DeliveryClass::AT_MOST_ONCE : DeliveryClass::AT_LEAST_ONCE;
+}
+
+DataChannelView JsonGatewayDataProtocol::parseDeviceChannel(const std::string& channel) const
+{
+    const auto startsWith = [&](std::string::size_type position, const std::string& part) {
+        return channel.compare(position, part.size(), part) == 0;
+    };
+
+    std::string::size_type position;
+    DataChannelView::Type type;
+    if (startsWith(0, SENSOR_READING_TOPIC_ROOT))
+    {
+        position = SENSOR_READING_TOPIC_ROOT.size();
+        type = DataChannelView::Type::SENSOR_READING;
+    }
+    else if (startsWith(0, EVENTS_TOPIC_ROOT))
+    {
+        position = EVENTS_TOPIC_ROOT.size();
+        type = DataChannelView::Type::ALARM;
+    }
+    else if (startsWith(0, ACTUATION_STATUS_TOPIC_ROOT))
+    {
+        position = ACTUATION_STATUS_TOPIC_ROOT.size();
+        type = DataChannelView::Type::ACTUATOR_STATUS;
+    }
+    else if (startsWith(0, CONFIGURATION_RESPONSE_TOPIC_ROOT))
+    {
+        position = CONFIGURATION_RESPONSE_TOPIC_ROOT.size();
+        type = DataChannelView::Type::CONFIGURATION_CURRENT;
+    }
+    else
+    {
+        return {};
+    }
+
+    if (!startsWith(position, DEVICE_PATH_PREFIX))
+    {
+        return {channel, type, 0, 0, 0, 0};
+    }
+
+    const auto deviceKeyPosition = position + DEVICE_PATH_PREFIX.size();
+    const auto deviceKeyEnd = std::min(channel.find(CHANNEL_DELIMITER, deviceKeyPosition), channel.size());
+
+    auto referencePosition = deviceKeyEnd + CHANNEL_DELIMITER.size();
+    if (deviceKeyEnd == channel.size() || !startsWith(referencePosition, REFERENCE_PATH_PREFIX))
+    {
+        return {channel, type, deviceKeyPosition, deviceKeyEnd - deviceKeyPosition, 0, 0};
+    }
+
+    referencePosition += REFERENCE_PATH_PREFIX.size();
+    auto referenceEnd = channel.size();
+    if (referenceEnd > referencePosition && startsWith(referenceEnd - CHANNEL_DELIMITER.size(), CHANNEL_DELIMITER))
+    {
+        referenceEnd -= CHANNEL_DELIMITER.size();
+    }
+
+    const auto referenceLength = referenceEnd > referencePosition ? referenceEnd - referencePosition : 0;
+    return {channel, type, deviceKeyPosition, deviceKeyEnd - deviceKeyPosition, referencePosition, referenceLength};
+}
+
 std::string JsonGatewayDataProtocol::routePlatformToDeviceMessage(const std::string& topic,
                                                                   const std::string& gatewayKey) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
-    const std::string gwTopicPart = GATEWAY_PATH_PREFIX + gatewayKey + CHANNEL_DELIMITER;
-    if (topic.find(gwTopicPart) != std::string::npos)
+    // gateway part is located in place instead of building "g/<key>/" for every message
+    std::string::size_type position = 0;
+    while ((position = topic.find(GATEWAY_PATH_PREFIX, position)) != std::string::npos)
     {
-        return StringUtils::removeSubstring(topic, gwTopicPart);
+        const auto keyPosition = position + GATEWAY_PATH_PREFIX.size();
+        const auto end = keyPosition + gatewayKey.size();
+        if ((position == 0 || topic.compare(position - CHANNEL_DELIMITER.size(), CHANNEL_DELIMITER.size(),
+                                            CHANNEL_DELIMITER) == 0) &&
+            topic.compare(keyPosition, gatewayKey.size(), gatewayKey) == 0 &&
+            topic.compare(end, CHANNEL_DELIMITER.size(), CHANNEL_DELIMITER) == 0)
+        {
+            std::string routedTopic;
+            routedTopic.reserve(topic.size() - (end + CHANNEL_DELIMITER.size() - position));
+            routedTopic.append(topic, 0, position).append(topic, end + CHANNEL_DELIMITER.size(), std::string::npos);
+            return routedTopic;
+        }
+
+        ++position;
     }
 
     return "";
@@ -159,16 +246,21 @@ std::string JsonGatewayDataProtocol::routePlatformToDeviceMessage(const std::str
 std::string JsonGatewayDataProtocol::routeDeviceToPlatformMessage(const std::string& topic,
                                                                   const std::string& gatewayKey) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
-    const std::string deviceTopicPart = CHANNEL_DELIMITER + DEVICE_PATH_PREFIX;
-    const std::string gatewayTopicPart = CHANNEL_DELIMITER + GATEWAY_PATH_PREFIX + gatewayKey;
+    static const std::string deviceTopicPart = CHANNEL_DELIMITER + DEVICE_PATH_PREFIX;
 
     const auto position = topic.find(deviceTopicPart);
     if (position != std::string::npos)
     {
-        std::string routedTopic = topic;
-        return routedTopic.insert(position, gatewayTopicPart);
+        std::string routedTopic;
+        routedTopic.reserve(topic.size() + CHANNEL_DELIMITER.size() + GATEWAY_PATH_PREFIX.size() + gatewayKey.size());
+        routedTopic.append(topic, 0, position)
+          .append(CHANNEL_DELIMITER)
+          .append(GATEWAY_PATH_PREFIX)
+          .append(gatewayKey)
+          .append(topic, position, std::string::npos);
+        return routedTopic;
     }
 
     return "";
@@ -176,7 +268,7 @@ std::string JsonGatewayDataProtocol::routeDeviceToPlatformMessage(const std::str
 
 std::string JsonGatewayDataProtocol::extractReferenceFromChannel(const std::string& topic) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     std::string top{topic};
 
@@ -199,7 +291,7 @@ std::string JsonGatewayDataProtocol::extractReferenceFromChannel(const std::stri
 
 std::string JsonGatewayDataProtocol::extractDeviceKeyFromChannel(const std::string& topic) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     const std::string devicePathPrefix = CHANNEL_DELIMITER + DEVICE_PATH_PREFIX;
 
@@ -227,4 +319,83 @@ std::string JsonGatewayDataProtocol::extractDeviceKeyFromChannel(const std::stri
 
     return topic.substr(pos, keyEndPosition - pos);
 }
+
+std::vector<std::unique_ptr<Message>> JsonGatewayDataProtocol::splitActuatorStatusBatch(
+  const std::string& channel, const std::string& payload) const
+{
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
+
+    const std::string deviceKey = extractDeviceKeyFromChannel(channel);
+    if (deviceKey.empty())
+    {
+        return {};
+    }
+
+    std::vector<std::unique_ptr<Message>> statuses;
+
+    try
+    {
+        // [{"reference":"SW","status":"READY","value":"true"}, ...]
+        const json batch = json::parse(payload);
+        if (!batch.is_array())
+        {
+            return {};
+        }
+
+        for (json status : batch)
+        {
+            const auto reference = status.find(ACTUATOR_STATUS_REFERENCE_FIELD);
+            if (reference == status.end() || !reference->is_string() || reference->get<std::string>().empty())
+            {
+                return {};
+            }
+
+            const std::string topic = ACTUATION_STATUS_TOPIC_ROOT + DEVICE_PATH_PREFIX + deviceKey + CHANNEL_DELIMITER +
+                                      REFERENCE_PATH_PREFIX + reference->get<std::string>();
+            status.erase(reference);
+
+            statuses.emplace_back(new Message(status.dump(), topic));
+        }
+    }
+    catch (const std::exception& e)
+    {
+        GATEWAY_LOG(DEBUG) << "Gateway data protocol: Unable to deserialize actuator status batch: " << e.what();
+        return {};
+    }
+
+    return statuses;
+}
+
+std::string JsonGatewayDataProtocol::mergeConfigurationSet(const std::string& payload,
+                                                           const std::string& laterPayload) const
+{
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
+
+    try
+    {
+        // {"values":{"REF1":"value1","REF2":"value2"}}
+        json merged = json::parse(payload);
+        const json later = json::parse(laterPayload);
+
+        const auto values = merged.find(CONFIGURATION_VALUES_FIELD);
+        const auto laterValues = later.find(CONFIGURATION_VALUES_FIELD);
+        if (!merged.is_object() || !later.is_object() || values == merged.end() || laterValues == later.end() ||
+            !values->is_object() || !laterValues->is_object())
+        {
+            return "";
+        }
+
+        for (auto it = laterValues->begin(); it != laterValues->end(); ++it)
+        {
+            (*values)[it.key()] = it.value();
+        }
+
+        return merged.dump();
+    }
+    catch (const std::exception& e)
+    {
+        GATEWAY_LOG(DEBUG) << "Gateway data protocol: Unable to merge configuration set requests: " << e.what();
+        return "";
+    }
+}
 }    // namespace wolkabout
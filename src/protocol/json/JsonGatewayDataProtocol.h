@@ -46,10 +46,19 @@ public:
     bool isActuatorStatusMessage(const Message& message) const override;
     bool isConfigurationCurrentMessage(const Message& message) const override;
 
+    DeliveryClass getDeliveryClass(const Message& message) const override;
+
+    DataChannelView parseDeviceChannel(const std::string& channel) const override;
+
     std::string routePlatformToDeviceMessage(const std::string& topic, const std::string& gatewayKey) const override;
     std::string routeDeviceToPlatformMessage(const std::string& topic, const std::string& gatewayKey) const override;
     std::string extractReferenceFromChannel(const std::string& topic) const override;
 
+    std::vector<std::unique_ptr<Message>> splitActuatorStatusBatch(const std::string& channel,
+                                                                   const std::string& payload) const override;
+
+    std::string mergeConfigurationSet(const std::string& payload, const std::string& laterPayload) const override;
+
 private:
     static const std::string SENSOR_READING_TOPIC_ROOT;
     static const std::string EVENTS_TOPIC_ROOT;
@@ -60,6 +69,9 @@ private:
     static const std::string ACTUATION_GET_TOPIC_ROOT;
     static const std::string CONFIGURATION_SET_REQUEST_TOPIC_ROOT;
     static const std::string CONFIGURATION_GET_REQUEST_TOPIC_ROOT;
+
+    static const std::string ACTUATOR_STATUS_REFERENCE_FIELD;
+    static const std::string CONFIGURATION_VALUES_FIELD;
 };
 }    // namespace wolkabout
 
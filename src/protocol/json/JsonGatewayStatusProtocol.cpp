@@ -18,13 +18,12 @@
 #include "model/DeviceStatus.h"
 #include "model/Message.h"
 #include "protocol/json/Json.h"
-#include "utilities/Logger.h"
+#include "utilities/GatewayLog.h"
+#include "utilities/JsonReader.h"
 #include "utilities/StringUtils.h"
-#include "utilities/json.hpp"
 
 #include <algorithm>
-
-using nlohmann::json;
+#include <stdexcept>
 
 namespace wolkabout
 {
@@ -39,9 +38,32 @@ const std::string JsonGatewayStatusProtocol::STATUS_RESPONSE_STATUS_SLEEP = "SLE
 const std::string JsonGatewayStatusProtocol::STATUS_RESPONSE_STATUS_SERVICE = "SERVICE";
 const std::string JsonGatewayStatusProtocol::STATUS_RESPONSE_STATUS_OFFLINE = "OFFLINE";
 
-static DeviceStatus::Status device_status_state_from_json(const json& j)
+static DeviceStatus::Status device_status_state_from_content(const std::string& content)
 {
-    const std::string statusStr = j.at(JsonGatewayStatusProtocol::STATUS_RESPONSE_STATE_FIELD).get<std::string>();
+    JsonReader reader{content};
+
+    std::string field;
+    std::string statusStr;
+    bool hasState = false;
+    if (reader.beginObject())
+    {
+        while (reader.nextMember(field))
+        {
+            if (field == JsonGatewayStatusProtocol::STATUS_RESPONSE_STATE_FIELD)
+            {
+                hasState = reader.readString(statusStr);
+            }
+            else
+            {
+                reader.skipValue();
+            }
+        }
+    }
+
+    if (!reader.finish() || !hasState)
+    {
+        throw std::logic_error("Invalid device status content");
+    }
 
     if (statusStr == JsonGatewayStatusProtocol::STATUS_RESPONSE_STATUS_CONNECTED)
     {
@@ -79,7 +101,7 @@ std::vector<std::string> JsonGatewayStatusProtocol::getInboundChannelsForDevice(
 
 std::unique_ptr<Message> JsonGatewayStatusProtocol::makeDeviceStatusRequestMessage(const std::string& deviceKey) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     const std::string topic = DEVICE_STATUS_REQUEST_TOPIC_ROOT + DEVICE_PATH_PREFIX + deviceKey;
 
@@ -88,7 +110,7 @@ std::unique_ptr<Message> JsonGatewayStatusProtocol::makeDeviceStatusRequestMessa
 
 std::unique_ptr<DeviceStatus> JsonGatewayStatusProtocol::makeDeviceStatusResponse(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (!StringUtils::startsWith(message.getChannel(), DEVICE_STATUS_RESPONSE_TOPIC_ROOT))
     {
@@ -100,30 +122,30 @@ std::unique_ptr<DeviceStatus> JsonGatewayStatusProtocol::makeDeviceStatusRespons
         const auto key = extractDeviceKeyFromChannel(message.getChannel());
         if (key.empty())
         {
-            LOG(DEBUG) << "Gateway status protocol: Unable to extract device key: " << message.getChannel();
+            GATEWAY_LOG(DEBUG) << "Gateway status protocol: Unable to extract device key: " << message.getChannel();
             return nullptr;
         }
 
-        const json j = json::parse(message.getContent());
-        DeviceStatus::Status state = device_status_state_from_json(j);
+        const std::string content = message.getContent();
+        DeviceStatus::Status state = device_status_state_from_content(content);
 
         return std::unique_ptr<DeviceStatus>(new DeviceStatus{key, state});
     }
     catch (const std::exception& e)
     {
-        LOG(DEBUG) << "Gateway Status protocol: Unable to deserialize device status response: " << e.what();
+        GATEWAY_LOG(DEBUG) << "Gateway Status protocol: Unable to deserialize device status response: " << e.what();
         return nullptr;
     }
     catch (...)
     {
-        LOG(DEBUG) << "Gateway Status protocol: Unable to deserialize device status response";
+        GATEWAY_LOG(DEBUG) << "Gateway Status protocol: Unable to deserialize device status response";
         return nullptr;
     }
 }
 
 std::unique_ptr<DeviceStatus> JsonGatewayStatusProtocol::makeDeviceStatusUpdate(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (!StringUtils::startsWith(message.getChannel(), DEVICE_STATUS_UPDATE_TOPIC_ROOT))
     {
@@ -135,44 +157,44 @@ std::unique_ptr<DeviceStatus> JsonGatewayStatusProtocol::makeDeviceStatusUpdate(
         const auto key = extractDeviceKeyFromChannel(message.getChannel());
         if (key.empty())
         {
-            LOG(DEBUG) << "Gateway status protocol: Unable to extract device key: " << message.getChannel();
+            GATEWAY_LOG(DEBUG) << "Gateway status protocol: Unable to extract device key: " << message.getChannel();
             return nullptr;
         }
 
-        const json j = json::parse(message.getContent());
-        DeviceStatus::Status state = device_status_state_from_json(j);
+        const std::string content = message.getContent();
+        DeviceStatus::Status state = device_status_state_from_content(content);
 
         return std::unique_ptr<DeviceStatus>(new DeviceStatus{key, state});
     }
     catch (const std::exception& e)
     {
-        LOG(DEBUG) << "Gateway Status protocol: Unable to deserialize device status update: " << e.what();
+        GATEWAY_LOG(DEBUG) << "Gateway Status protocol: Unable to deserialize device status update: " << e.what();
         return nullptr;
     }
     catch (...)
     {
-        LOG(DEBUG) << "Gateway Status protocol: Unable to deserialize device status update";
+        GATEWAY_LOG(DEBUG) << "Gateway Status protocol: Unable to deserialize device status update";
         return nullptr;
     }
 }
 
 bool JsonGatewayStatusProtocol::isStatusUpdateMessage(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     return StringUtils::startsWith(message.getChannel(), DEVICE_STATUS_UPDATE_TOPIC_ROOT);
 }
 
 bool JsonGatewayStatusProtocol::isStatusResponseMessage(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     return StringUtils::startsWith(message.getChannel(), DEVICE_STATUS_RESPONSE_TOPIC_ROOT);
 }
 
 bool JsonGatewayStatusProtocol::isLastWillMessage(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     std::string top = message.getChannel();
 
@@ -186,7 +208,7 @@ bool JsonGatewayStatusProtocol::isLastWillMessage(const Message& message) const
 
 std::string JsonGatewayStatusProtocol::extractDeviceKeyFromChannel(const std::string& topic) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     std::string top = topic;
     if (StringUtils::endsWith(top, CHANNEL_DELIMITER))
@@ -210,33 +232,37 @@ std::string JsonGatewayStatusProtocol::extractDeviceKeyFromChannel(const std::st
 
 std::vector<std::string> JsonGatewayStatusProtocol::extractDeviceKeysFromContent(const std::string& content) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     try
     {
-        const json j = json::parse(content);
-        if (!j.is_array())
-        {
-            throw std::logic_error("");
-        }
+        JsonReader reader{content};
 
         std::vector<std::string> keys;
+        std::string key;
+        if (reader.beginArray())
+        {
+            while (reader.nextElement() && reader.readString(key))
+            {
+                keys.push_back(key);
+            }
+        }
 
-        for (const auto& key : j)
+        if (!reader.finish())
         {
-            keys.push_back(key);
+            throw std::logic_error("Content is not an array of keys");
         }
 
         return keys;
     }
     catch (std::exception& e)
     {
-        LOG(TRACE) << "Gateway status protocol: Unable extract file keys from content: " << e.what();
+        GATEWAY_LOG(TRACE) << "Gateway status protocol: Unable extract file keys from content: " << e.what();
         return {};
     }
     catch (...)
     {
-        LOG(TRACE) << "Gateway status protocol: Unable extract file keys from content";
+        GATEWAY_LOG(TRACE) << "Gateway status protocol: Unable extract file keys from content";
         return {};
     }
 }
@@ -20,7 +20,7 @@
 #include "model/SubdeviceRegistrationResponse.h"
 #include "protocol/json/Json.h"
 #include "protocol/json/JsonDto.h"
-#include "utilities/Logger.h"
+#include "utilities/GatewayLog.h"
 #include "utilities/StringUtils.h"
 #include "utilities/json.hpp"
 
@@ -49,7 +49,7 @@ std::vector<std::string> JsonGatewaySubdeviceRegistrationProtocol::getInboundCha
 std::unique_ptr<SubdeviceRegistrationRequest>
 JsonGatewaySubdeviceRegistrationProtocol::makeSubdeviceRegistrationRequest(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (!StringUtils::startsWith(message.getChannel(), SUBDEVICE_REGISTRATION_REQUEST_TOPIC_ROOT))
     {
@@ -65,13 +65,15 @@ JsonGatewaySubdeviceRegistrationProtocol::makeSubdeviceRegistrationRequest(const
     }
     catch (std::exception& e)
     {
-        LOG(DEBUG) << "Gateway subdevice registration protocol: Unable to deserialize subdevice registration request: "
-                   << e.what();
+        GATEWAY_LOG(DEBUG)
+            << "Gateway subdevice registration protocol: Unable to deserialize subdevice registration request: "
+            << e.what();
         return nullptr;
     }
     catch (...)
     {
-        LOG(DEBUG) << "Gateway subdevice registration protocol: Unable to deserialize subdevice registration request";
+        GATEWAY_LOG(DEBUG)
+            << "Gateway subdevice registration protocol: Unable to deserialize subdevice registration request";
         return nullptr;
     }
 }
@@ -79,7 +81,7 @@ JsonGatewaySubdeviceRegistrationProtocol::makeSubdeviceRegistrationRequest(const
 std::unique_ptr<Message> JsonGatewaySubdeviceRegistrationProtocol::makeMessage(
   const wolkabout::SubdeviceRegistrationResponse& response) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     try
     {
@@ -93,20 +95,22 @@ std::unique_ptr<Message> JsonGatewaySubdeviceRegistrationProtocol::makeMessage(
     }
     catch (std::exception& e)
     {
-        LOG(DEBUG) << "Gateway subdevice registration protocol: Unable to serialize device registration response: "
-                   << e.what();
+        GATEWAY_LOG(DEBUG)
+            << "Gateway subdevice registration protocol: Unable to serialize device registration response: "
+            << e.what();
         return nullptr;
     }
     catch (...)
     {
-        LOG(DEBUG) << "Gateway subdevice registration protocol: Unable to serialize device registration response";
+        GATEWAY_LOG(DEBUG)
+            << "Gateway subdevice registration protocol: Unable to serialize device registration response";
         return nullptr;
     }
 }
 
 bool JsonGatewaySubdeviceRegistrationProtocol::isSubdeviceRegistrationRequest(const Message& message) const
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     return StringUtils::startsWith(message.getChannel(), SUBDEVICE_REGISTRATION_REQUEST_TOPIC_ROOT);
 }
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "protocol/json/JsonStreamingProtocol.h"
+#include "model/ActuatorStatus.h"
+#include "model/Alarm.h"
+#include "model/Message.h"
+#include "model/SensorReading.h"
+#include "protocol/json/Json.h"
+#include "utilities/JsonWriter.h"
+
+#include <cstdint>
+
+namespace
+{
+const std::string UTC_KEY = "utc";
+const std::string DATA_KEY = "data";
+const std::string ACTIVE_KEY = "active";
+const std::string STATUS_KEY = "status";
+const std::string VALUE_KEY = "value";
+
+const std::string MULTI_VALUE_DELIMITER = ",";
+
+const std::string READY_STATE = "READY";
+const std::string BUSY_STATE = "BUSY";
+const std::string ERROR_STATE = "ERROR";
+
+wolkabout::JsonWriter& threadWriter()
+{
+    // one writer per thread, so its buffer is reused by every message serialized on that thread
+    static thread_local wolkabout::JsonWriter writer;
+
+    writer.clear();
+    return writer;
+}
+}    // namespace
+
+namespace wolkabout
+{
+const std::string JsonStreamingProtocol::SENSOR_READING_TOPIC_ROOT = "d2p/sensor_reading/";
+const std::string JsonStreamingProtocol::EVENTS_TOPIC_ROOT = "d2p/events/";
+const std::string JsonStreamingProtocol::ACTUATION_STATUS_TOPIC_ROOT = "d2p/actuator_status/";
+
+JsonStreamingProtocol::JsonStreamingProtocol(bool isGateway) : JsonProtocol(isGateway), m_isGateway{isGateway} {}
+
+std::unique_ptr<Message> JsonStreamingProtocol::makeMessage(
+  const std::string& deviceKey, const std::vector<std::shared_ptr<SensorReading>>& sensorReadings) const
+{
+    if (sensorReadings.empty())
+    {
+        return nullptr;
+    }
+
+    JsonWriter& writer = threadWriter();
+    writer.beginArray();
+    for (const auto& sensorReading : sensorReadings)
+    {
+        writer.beginObject();
+
+        if (sensorReading->getRtc() != 0)
+        {
+            writer.key(UTC_KEY).value(static_cast<std::uint64_t>(sensorReading->getRtc()));
+        }
+
+        const auto& values = sensorReading->getValues();
+        if (values.size() == 1)
+        {
+            writer.key(DATA_KEY).value(values.front());
+        }
+        else
+        {
+            std::string data;
+            for (const auto& value : values)
+            {
+                if (!data.empty())
+                {
+                    data += MULTI_VALUE_DELIMITER;
+                }
+
+                data += value;
+            }
+
+            writer.key(DATA_KEY).value(data);
+        }
+
+        writer.endObject();
+    }
+    writer.endArray();
+
+    return std::unique_ptr<Message>(new Message(
+      writer.str(), makeTopic(SENSOR_READING_TOPIC_ROOT, deviceKey, sensorReadings.front()->getReference())));
+}
+
+std::unique_ptr<Message> JsonStreamingProtocol::makeMessage(const std::string& deviceKey,
+                                                            const std::vector<std::shared_ptr<Alarm>>& alarms) const
+{
+    if (alarms.empty())
+    {
+        return nullptr;
+    }
+
+    JsonWriter& writer = threadWriter();
+    writer.beginArray();
+    for (const auto& alarm : alarms)
+    {
+        writer.beginObject();
+
+        if (alarm->getRtc() != 0)
+        {
+            writer.key(UTC_KEY).value(static_cast<std::uint64_t>(alarm->getRtc()));
+        }
+
+        writer.key(ACTIVE_KEY).value(alarm->getActive());
+        writer.endObject();
+    }
+    writer.endArray();
+
+    return std::unique_ptr<Message>(
+      new Message(writer.str(), makeTopic(EVENTS_TOPIC_ROOT, deviceKey, alarms.front()->getReference())));
+}
+
+std::unique_ptr<Message> JsonStreamingProtocol::makeMessage(
+  const std::string& deviceKey, const std::vector<std::shared_ptr<ActuatorStatus>>& statuses) const
+{
+    if (statuses.empty())
+    {
+        return nullptr;
+    }
+
+    const ActuatorStatus& status = *statuses.front();
+    const std::string& state = [&]() -> const std::string& {
+        if (status.getState() == ActuatorStatus::State::READY)
+        {
+            return READY_STATE;
+        }
+        else if (status.getState() == ActuatorStatus::State::BUSY)
+        {
+            return BUSY_STATE;
+        }
+
+        return ERROR_STATE;
+    }();
+
+    JsonWriter& writer = threadWriter();
+    writer.beginObject().key(STATUS_KEY).value(state).key(VALUE_KEY).value(status.getValue()).endObject();
+
+    return std::unique_ptr<Message>(
+      new Message(writer.str(), makeTopic(ACTUATION_STATUS_TOPIC_ROOT, deviceKey, status.getReference())));
+}
+
+std::string JsonStreamingProtocol::makeTopic(const std::string& root, const std::string& deviceKey,
+                                             const std::string& reference) const
+{
+    return root + (m_isGateway ? GATEWAY_PATH_PREFIX : DEVICE_PATH_PREFIX) + deviceKey + CHANNEL_DELIMITER +
+           REFERENCE_PATH_PREFIX + reference;
+}
+}    // namespace wolkabout
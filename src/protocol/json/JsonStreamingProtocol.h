@@ -0,0 +1,59 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef JSONSTREAMINGPROTOCOL_H
+#define JSONSTREAMINGPROTOCOL_H
+
+#include "protocol/json/JsonProtocol.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief JsonProtocol that serializes sensor readings, alarms and actuator statuses with JsonWriter
+ *
+ * Produces the same payloads as JsonProtocol without building a nlohmann::json tree per message.
+ * Selected at build time with WOLKGATEWAY_STREAMING_JSON CMake option.
+ */
+class JsonStreamingProtocol : public JsonProtocol
+{
+public:
+    explicit JsonStreamingProtocol(bool isGateway = false);
+
+    using JsonProtocol::makeMessage;
+
+    std::unique_ptr<Message> makeMessage(
+      const std::string& deviceKey, const std::vector<std::shared_ptr<SensorReading>>& sensorReadings) const override;
+    std::unique_ptr<Message> makeMessage(const std::string& deviceKey,
+                                         const std::vector<std::shared_ptr<Alarm>>& alarms) const override;
+    std::unique_ptr<Message> makeMessage(const std::string& deviceKey,
+                                         const std::vector<std::shared_ptr<ActuatorStatus>>& statuses) const override;
+
+private:
+    std::string makeTopic(const std::string& root, const std::string& deviceKey, const std::string& reference) const;
+
+    const bool m_isGateway;
+
+    static const std::string SENSOR_READING_TOPIC_ROOT;
+    static const std::string EVENTS_TOPIC_ROOT;
+    static const std::string ACTUATION_STATUS_TOPIC_ROOT;
+};
+}    // namespace wolkabout
+
+#endif    // JSONSTREAMINGPROTOCOL_H
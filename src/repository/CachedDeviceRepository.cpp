@@ -0,0 +1,330 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "repository/CachedDeviceRepository.h"
+#include "model/DetailedDevice.h"
+#include "model/DeviceReferences.h"
+#include "repository/RoutingSnapshot.h"
+#include "utilities/Logger.h"
+
+#include <cstdio>
+#include <exception>
+#include <iterator>
+
+namespace wolkabout
+{
+const std::chrono::milliseconds CachedDeviceRepository::DEFAULT_UNKNOWN_DEVICE_TTL{60000};
+const std::size_t CachedDeviceRepository::MAXIMUM_UNKNOWN_DEVICES = 10000;
+
+CachedDeviceRepository::CachedDeviceRepository(std::unique_ptr<DeviceRepository> repository,
+                                               std::chrono::milliseconds unknownDeviceTtl)
+: m_repository{std::move(repository)}
+, m_isSnapshotCurrent{false}
+, m_hasDeviceKeys{false}
+, m_unknownDeviceTtl{unknownDeviceTtl}
+{
+}
+
+CachedDeviceRepository::~CachedDeviceRepository()
+{
+    // snapshot that was loaded and never invalidated still matches repository
+    if (m_snapshotPath.empty() || m_isSnapshotCurrent)
+    {
+        return;
+    }
+
+    try
+    {
+        writeSnapshot();
+    }
+    catch (const std::exception& e)
+    {
+        LOG(ERROR) << "CachedDeviceRepository: Unable to write routing snapshot: " << e.what();
+    }
+}
+
+bool CachedDeviceRepository::loadSnapshot(const std::string& snapshotPath, const std::string& databasePath)
+{
+    std::lock_guard<std::mutex> guard{m_writeMutex};
+
+    m_snapshotPath = snapshotPath;
+    m_databasePath = databasePath;
+
+    RoutingSnapshot::Devices devices;
+    if (!RoutingSnapshot::load(snapshotPath, databasePath, devices))
+    {
+        return false;
+    }
+
+    for (auto& device : devices)
+    {
+        m_deviceKeys.insert(device.first);
+        cache(device.first, std::move(device.second));
+    }
+
+    m_hasDeviceKeys = true;
+    m_isSnapshotCurrent = true;
+    LOG(INFO) << "CachedDeviceRepository: Loaded " << m_deviceKeys.size() << " devices from routing snapshot";
+    return true;
+}
+
+void CachedDeviceRepository::save(const DetailedDevice& device)
+{
+    std::lock_guard<std::mutex> guard{m_writeMutex};
+
+    invalidateSnapshot();
+    m_repository->save(device);
+    cache(device.getKey(), std::make_shared<DeviceReferences>(device));
+    forgetUnknown(device.getKey());
+    if (m_hasDeviceKeys)
+    {
+        m_deviceKeys.insert(device.getKey());
+    }
+}
+
+void CachedDeviceRepository::saveAll(const std::vector<DetailedDevice>& devices)
+{
+    std::lock_guard<std::mutex> guard{m_writeMutex};
+
+    invalidateSnapshot();
+    m_repository->saveAll(devices);
+    for (const DetailedDevice& device : devices)
+    {
+        cache(device.getKey(), std::make_shared<DeviceReferences>(device));
+        forgetUnknown(device.getKey());
+        if (m_hasDeviceKeys)
+        {
+            m_deviceKeys.insert(device.getKey());
+        }
+    }
+}
+
+void CachedDeviceRepository::remove(const std::string& deviceKey)
+{
+    std::lock_guard<std::mutex> guard{m_writeMutex};
+
+    invalidateSnapshot();
+    m_repository->remove(deviceKey);
+    m_references.release(deviceKey);
+    m_deviceKeys.erase(deviceKey);
+}
+
+void CachedDeviceRepository::removeMany(const std::vector<std::string>& deviceKeys)
+{
+    std::lock_guard<std::mutex> guard{m_writeMutex};
+
+    invalidateSnapshot();
+    m_repository->removeMany(deviceKeys);
+    for (const std::string& deviceKey : deviceKeys)
+    {
+        m_references.release(deviceKey);
+        m_deviceKeys.erase(deviceKey);
+    }
+}
+
+void CachedDeviceRepository::removeAll()
+{
+    std::lock_guard<std::mutex> guard{m_writeMutex};
+
+    invalidateSnapshot();
+    m_repository->removeAll();
+    m_references.clear();
+    m_deviceKeys.clear();
+}
+
+std::unique_ptr<DetailedDevice> CachedDeviceRepository::findByDeviceKey(const std::string& deviceKey)
+{
+    return m_repository->findByDeviceKey(deviceKey);
+}
+
+std::unique_ptr<std::vector<std::string>> CachedDeviceRepository::findAllDeviceKeys()
+{
+    {
+        std::lock_guard<std::mutex> guard{m_writeMutex};
+        if (m_hasDeviceKeys)
+        {
+            return std::unique_ptr<std::vector<std::string>>(
+              new std::vector<std::string>(m_deviceKeys.begin(), m_deviceKeys.end()));
+        }
+    }
+
+    return m_repository->findAllDeviceKeys();
+}
+
+bool CachedDeviceRepository::containsDeviceWithKey(const std::string& deviceKey)
+{
+    if (m_references.find(deviceKey) != DeviceRegistry<std::shared_ptr<const DeviceReferences>>::INVALID_HANDLE)
+    {
+        return true;
+    }
+
+    if (isUnknown(deviceKey))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> guard{m_writeMutex};
+    if (m_hasDeviceKeys)
+    {
+        return false;
+    }
+
+    if (!m_repository->containsDeviceWithKey(deviceKey))
+    {
+        rememberUnknown(deviceKey);
+        return false;
+    }
+
+    return true;
+}
+
+std::shared_ptr<const DeviceReferences> CachedDeviceRepository::findReferencesByDeviceKey(const std::string& deviceKey)
+{
+    std::shared_ptr<const DeviceReferences> references;
+    if (m_references.with(deviceKey, [&](std::shared_ptr<const DeviceReferences>& cached) { references = cached; }))
+    {
+        return references;
+    }
+
+    if (isUnknown(deviceKey))
+    {
+        return nullptr;
+    }
+
+    // device may have been saved or removed while cache was checked, so it is checked again under write lock
+    std::lock_guard<std::mutex> guard{m_writeMutex};
+
+    if (m_references.with(deviceKey, [&](std::shared_ptr<const DeviceReferences>& cached) { references = cached; }))
+    {
+        return references;
+    }
+
+    // every device is cached when keys are known from snapshot
+    if (m_hasDeviceKeys)
+    {
+        return nullptr;
+    }
+
+    references = m_repository->findReferencesByDeviceKey(deviceKey);
+    if (references)
+    {
+        cache(deviceKey, references);
+    }
+    else
+    {
+        rememberUnknown(deviceKey);
+    }
+
+    return references;
+}
+
+std::string CachedDeviceRepository::findTemplateHash(const std::string& deviceKey)
+{
+    return m_repository->findTemplateHash(deviceKey);
+}
+
+void CachedDeviceRepository::cache(const std::string& deviceKey, std::shared_ptr<const DeviceReferences> references)
+{
+    m_references.with(m_references.acquire(deviceKey),
+                      [&](std::shared_ptr<const DeviceReferences>& cached) { cached = std::move(references); });
+}
+
+bool CachedDeviceRepository::isUnknown(const std::string& deviceKey)
+{
+    std::lock_guard<std::mutex> guard{m_unknownMutex};
+
+    auto it = m_unknownDevices.find(deviceKey);
+    if (it == m_unknownDevices.end())
+    {
+        return false;
+    }
+
+    if (it->second <= std::chrono::steady_clock::now())
+    {
+        m_unknownDevices.erase(it);
+        return false;
+    }
+
+    return true;
+}
+
+void CachedDeviceRepository::rememberUnknown(const std::string& deviceKey)
+{
+    if (m_unknownDeviceTtl == std::chrono::steady_clock::duration::zero())
+    {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> guard{m_unknownMutex};
+
+    // keys are spoofable, so expired ones are dropped once too many are remembered, and all of them if none expired
+    if (m_unknownDevices.size() >= MAXIMUM_UNKNOWN_DEVICES)
+    {
+        for (auto it = m_unknownDevices.begin(); it != m_unknownDevices.end();)
+        {
+            it = it->second <= now ? m_unknownDevices.erase(it) : std::next(it);
+        }
+
+        if (m_unknownDevices.size() >= MAXIMUM_UNKNOWN_DEVICES)
+        {
+            m_unknownDevices.clear();
+        }
+    }
+
+    m_unknownDevices[deviceKey] = now + m_unknownDeviceTtl;
+}
+
+void CachedDeviceRepository::forgetUnknown(const std::string& deviceKey)
+{
+    std::lock_guard<std::mutex> guard{m_unknownMutex};
+    m_unknownDevices.erase(deviceKey);
+}
+
+void CachedDeviceRepository::invalidateSnapshot()
+{
+    if (m_isSnapshotCurrent)
+    {
+        std::remove(m_snapshotPath.c_str());
+        m_isSnapshotCurrent = false;
+    }
+}
+
+void CachedDeviceRepository::writeSnapshot()
+{
+    std::unique_ptr<std::vector<std::string>> deviceKeys = findAllDeviceKeys();
+    if (!deviceKeys)
+    {
+        return;
+    }
+
+    RoutingSnapshot::Devices devices;
+    devices.reserve(deviceKeys->size());
+    for (const auto& deviceKey : *deviceKeys)
+    {
+        devices.emplace_back(deviceKey, findReferencesByDeviceKey(deviceKey));
+    }
+
+    // pending writes of wrapped repository are completed before snapshot claims them
+    m_repository.reset();
+
+    if (RoutingSnapshot::write(m_snapshotPath, m_databasePath, devices))
+    {
+        LOG(INFO) << "CachedDeviceRepository: Wrote " << devices.size() << " devices to routing snapshot";
+    }
+}
+}    // namespace wolkabout
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CACHEDDEVICEREPOSITORY_H
+#define CACHEDDEVICEREPOSITORY_H
+
+#include "repository/DeviceRepository.h"
+#include "utilities/DeviceRegistry.h"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Write-through cache of device template references in front of another DeviceRepository
+ *
+ * findReferencesByDeviceKey is served from memory once device has been saved or looked up,
+ * all other calls are forwarded to wrapped repository.
+ * Cached references are sharded by device, so services looking up different devices do not contend,
+ * writes and cache misses are serialized so wrapped repository and cache stay consistent.
+ * Keys wrapped repository does not know are remembered for a while, so devices that publish without being
+ * registered are rejected without a query. Saving device forgets it was unknown.
+ */
+class CachedDeviceRepository : public DeviceRepository
+{
+public:
+    static const std::chrono::milliseconds DEFAULT_UNKNOWN_DEVICE_TTL;
+    static const std::size_t MAXIMUM_UNKNOWN_DEVICES;
+
+    /**
+     * @param repository Repository being cached
+     * @param unknownDeviceTtl Time for which key not found in wrapped repository is not looked up again,
+     * 0 disables negative caching
+     */
+    explicit CachedDeviceRepository(std::unique_ptr<DeviceRepository> repository,
+                                    std::chrono::milliseconds unknownDeviceTtl = DEFAULT_UNKNOWN_DEVICE_TTL);
+
+    /**
+     * @brief Writes routing snapshot if one was loaded
+     */
+    ~CachedDeviceRepository();
+
+    /**
+     * @brief Fills cache from routing snapshot, so device keys and references are not read from wrapped repository
+     *
+     * Snapshot is removed on first write, and written again once repository is destroyed, so snapshot left after
+     * unclean shutdown never misses a change. Must be called before repository is used.
+     * @param snapshotPath Path of snapshot file
+     * @param databasePath Path of database wrapped repository stores devices in
+     * @return true if snapshot was loaded, false if it is missing or stale, in which case it is written on destruction
+     */
+    bool loadSnapshot(const std::string& snapshotPath, const std::string& databasePath);
+
+    void save(const DetailedDevice& device) override;
+
+    void saveAll(const std::vector<DetailedDevice>& devices) override;
+
+    void remove(const std::string& deviceKey) override;
+
+    void removeMany(const std::vector<std::string>& deviceKeys) override;
+
+    void removeAll() override;
+
+    std::unique_ptr<DetailedDevice> findByDeviceKey(const std::string& deviceKey) override;
+
+    std::unique_ptr<std::vector<std::string>> findAllDeviceKeys() override;
+
+    bool containsDeviceWithKey(const std::string& deviceKey) override;
+
+    std::shared_ptr<const DeviceReferences> findReferencesByDeviceKey(const std::string& deviceKey) override;
+
+    std::string findTemplateHash(const std::string& deviceKey) override;
+
+private:
+    void cache(const std::string& deviceKey, std::shared_ptr<const DeviceReferences> references);
+
+    bool isUnknown(const std::string& deviceKey);
+    void rememberUnknown(const std::string& deviceKey);
+    void forgetUnknown(const std::string& deviceKey);
+    void invalidateSnapshot();
+    void writeSnapshot();
+
+    std::unique_ptr<DeviceRepository> m_repository;
+
+    std::mutex m_writeMutex;
+    DeviceRegistry<std::shared_ptr<const DeviceReferences>> m_references;
+
+    std::string m_snapshotPath;
+    std::string m_databasePath;
+    // snapshot file matches repository, cleared on first write
+    bool m_isSnapshotCurrent;
+
+    // all device keys, kept only while they are known from snapshot
+    bool m_hasDeviceKeys;
+    std::set<std::string> m_deviceKeys;
+
+    // keys wrapped repository did not find, with time until which they are not looked up again
+    const std::chrono::steady_clock::duration m_unknownDeviceTtl;
+    std::mutex m_unknownMutex;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_unknownDevices;
+};
+}    // namespace wolkabout
+
+#endif    // CACHEDDEVICEREPOSITORY_H
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "repository/DeviceRepository.h"
+#include "model/DetailedDevice.h"
+#include "model/DeviceReferences.h"
+#include "repository/SQLiteDeviceRepository.h"
+
+namespace wolkabout
+{
+void DeviceRepository::saveAll(const std::vector<DetailedDevice>& devices)
+{
+    for (const DetailedDevice& device : devices)
+    {
+        save(device);
+    }
+}
+
+void DeviceRepository::removeMany(const std::vector<std::string>& deviceKeys)
+{
+    for (const std::string& deviceKey : deviceKeys)
+    {
+        remove(deviceKey);
+    }
+}
+
+std::shared_ptr<const DeviceReferences> DeviceRepository::findReferencesByDeviceKey(const std::string& deviceKey)
+{
+    const std::unique_ptr<DetailedDevice> device = findByDeviceKey(deviceKey);
+    if (!device)
+    {
+        return nullptr;
+    }
+
+    return std::make_shared<DeviceReferences>(*device);
+}
+
+std::string DeviceRepository::findTemplateHash(const std::string& deviceKey)
+{
+    const std::unique_ptr<DetailedDevice> device = findByDeviceKey(deviceKey);
+    if (!device)
+    {
+        return "";
+    }
+
+    return SQLiteDeviceRepository::calculateSha256(device->getTemplate());
+}
+}    // namespace wolkabout
@@ -24,6 +24,8 @@
 namespace wolkabout
 {
 class DetailedDevice;
+class DeviceReferences;
+
 class DeviceRepository
 {
 public:
@@ -31,8 +33,22 @@ public:
 
     virtual void save(const DetailedDevice& device) = 0;
 
+    /**
+     * @brief Saves multiple devices at once
+     * @param devices Devices to save
+     * Default implementation saves devices one by one
+     */
+    virtual void saveAll(const std::vector<DetailedDevice>& devices);
+
     virtual void remove(const std::string& devicekey) = 0;
 
+    /**
+     * @brief Removes multiple devices at once
+     * @param deviceKeys Keys of devices to remove
+     * Default implementation removes devices one by one
+     */
+    virtual void removeMany(const std::vector<std::string>& deviceKeys);
+
     virtual void removeAll() = 0;
 
     virtual std::unique_ptr<DetailedDevice> findByDeviceKey(const std::string& key) = 0;
@@ -40,6 +56,21 @@ public:
     virtual std::unique_ptr<std::vector<std::string>> findAllDeviceKeys() = 0;
 
     virtual bool containsDeviceWithKey(const std::string& deviceKey) = 0;
+
+    /**
+     * @brief Returns references declared in template of device with given key
+     * @param deviceKey Key of device
+     * @return References, or nullptr if device is not found. Default implementation is built from findByDeviceKey
+     */
+    virtual std::shared_ptr<const DeviceReferences> findReferencesByDeviceKey(const std::string& deviceKey);
+
+    /**
+     * @brief Returns digest of template of device with given key, equal digests mean equal templates
+     * @param deviceKey Key of device
+     * @return Digest as calculated by SQLiteDeviceRepository::calculateSha256, or empty string if device is not
+     * found. Default implementation hashes template returned by findByDeviceKey
+     */
+    virtual std::string findTemplateHash(const std::string& deviceKey);
 };
 }    // namespace wolkabout
 
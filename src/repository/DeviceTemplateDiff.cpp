@@ -0,0 +1,164 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "repository/DeviceTemplateDiff.h"
+#include "model/ActuatorTemplate.h"
+#include "model/AlarmTemplate.h"
+#include "model/ConfigurationTemplate.h"
+#include "model/DeviceTemplate.h"
+#include "model/SensorTemplate.h"
+#include "repository/SQLiteDeviceRepository.h"
+
+#include <map>
+#include <sstream>
+
+namespace
+{
+void describe(std::ostream& stream, const std::string& kind, const wolkabout::DeviceTemplateDiff::Changes& changes)
+{
+    const auto list = [&](const char* action, const std::vector<std::string>& references) {
+        if (references.empty())
+        {
+            return;
+        }
+
+        if (stream.tellp() != 0)
+        {
+            stream << "; ";
+        }
+
+        stream << kind << " " << action << ":";
+        for (const auto& reference : references)
+        {
+            stream << " '" << reference << "'";
+        }
+    };
+
+    list("added", changes.added);
+    list("removed", changes.removed);
+    list("changed", changes.changed);
+}
+}    // namespace
+
+namespace wolkabout
+{
+bool DeviceTemplateDiff::Changes::empty() const
+{
+    return added.empty() && removed.empty() && changed.empty();
+}
+
+DeviceTemplateDiff::DeviceTemplateDiff(const DeviceTemplate& previous, const DeviceTemplate& current)
+: m_parametersChanged{false}
+{
+    if (SQLiteDeviceRepository::calculateSha256(previous) == SQLiteDeviceRepository::calculateSha256(current))
+    {
+        return;
+    }
+
+    m_sensors = diff(previous.getSensors(), current.getSensors());
+    m_actuators = diff(previous.getActuators(), current.getActuators());
+    m_alarms = diff(previous.getAlarms(), current.getAlarms());
+    m_configurations = diff(previous.getConfigurations(), current.getConfigurations());
+
+    m_parametersChanged = previous.getFirmwareUpdateType() != current.getFirmwareUpdateType() ||
+                          previous.getTypeParameters() != current.getTypeParameters() ||
+                          previous.getConnectivityParameters() != current.getConnectivityParameters() ||
+                          previous.getFirmwareUpdateParameters() != current.getFirmwareUpdateParameters();
+}
+
+bool DeviceTemplateDiff::empty() const
+{
+    return m_sensors.empty() && m_actuators.empty() && m_alarms.empty() && m_configurations.empty() &&
+           !m_parametersChanged;
+}
+
+const DeviceTemplateDiff::Changes& DeviceTemplateDiff::getSensors() const
+{
+    return m_sensors;
+}
+
+const DeviceTemplateDiff::Changes& DeviceTemplateDiff::getActuators() const
+{
+    return m_actuators;
+}
+
+const DeviceTemplateDiff::Changes& DeviceTemplateDiff::getAlarms() const
+{
+    return m_alarms;
+}
+
+const DeviceTemplateDiff::Changes& DeviceTemplateDiff::getConfigurations() const
+{
+    return m_configurations;
+}
+
+bool DeviceTemplateDiff::parametersChanged() const
+{
+    return m_parametersChanged;
+}
+
+std::string DeviceTemplateDiff::toString() const
+{
+    std::ostringstream stream;
+    describe(stream, "sensors", m_sensors);
+    describe(stream, "actuators", m_actuators);
+    describe(stream, "alarms", m_alarms);
+    describe(stream, "configurations", m_configurations);
+
+    if (m_parametersChanged)
+    {
+        stream << (stream.tellp() != 0 ? "; " : "") << "parameters changed";
+    }
+
+    return stream.str();
+}
+
+template <class T>
+DeviceTemplateDiff::Changes DeviceTemplateDiff::diff(const std::vector<T>& previous, const std::vector<T>& current)
+{
+    // ordered by reference so descriptions do not depend on template order
+    std::map<std::string, std::string> previousDigests;
+    for (const auto& item : previous)
+    {
+        previousDigests.emplace(item.getReference(), SQLiteDeviceRepository::calculateSha256(item));
+    }
+
+    Changes changes;
+    for (const auto& item : current)
+    {
+        auto it = previousDigests.find(item.getReference());
+        if (it == previousDigests.end())
+        {
+            changes.added.push_back(item.getReference());
+            continue;
+        }
+
+        if (it->second != SQLiteDeviceRepository::calculateSha256(item))
+        {
+            changes.changed.push_back(item.getReference());
+        }
+
+        previousDigests.erase(it);
+    }
+
+    for (const auto& previousDigest : previousDigests)
+    {
+        changes.removed.push_back(previousDigest.first);
+    }
+
+    return changes;
+}
+}    // namespace wolkabout
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DEVICETEMPLATEDIFF_H
+#define DEVICETEMPLATEDIFF_H
+
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+class DeviceTemplate;
+
+/**
+ * @brief Structural difference between two device templates
+ *
+ * Sensors, actuators, alarms and configurations are matched by reference and compared by the same
+ * sha256 digests wolkabout::SQLiteDeviceRepository stores, templates with equal digests are not compared item by item.
+ */
+class DeviceTemplateDiff
+{
+public:
+    struct Changes
+    {
+        std::vector<std::string> added;
+        std::vector<std::string> removed;
+        std::vector<std::string> changed;
+
+        bool empty() const;
+    };
+
+    /**
+     * @param previous Template last acknowledged by platform
+     * @param current New template
+     */
+    DeviceTemplateDiff(const DeviceTemplate& previous, const DeviceTemplate& current);
+
+    bool empty() const;
+
+    const Changes& getSensors() const;
+    const Changes& getActuators() const;
+    const Changes& getAlarms() const;
+    const Changes& getConfigurations() const;
+
+    /**
+     * @brief Returns whether type, connectivity or firmware update parameters or firmware update type differ
+     */
+    bool parametersChanged() const;
+
+    /**
+     * @brief Describes changes in human readable form, for logging
+     */
+    std::string toString() const;
+
+private:
+    template <class T> static Changes diff(const std::vector<T>& previous, const std::vector<T>& current);
+
+    Changes m_sensors;
+    Changes m_actuators;
+    Changes m_alarms;
+    Changes m_configurations;
+    bool m_parametersChanged;
+};
+}    // namespace wolkabout
+
+#endif    // DEVICETEMPLATEDIFF_H
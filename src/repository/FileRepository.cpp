@@ -0,0 +1,63 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "repository/FileRepository.h"
+
+namespace wolkabout
+{
+void FileRepository::storeAll(const std::vector<FileInfo>& infos)
+{
+    for (const FileInfo& info : infos)
+    {
+        store(info);
+    }
+}
+
+void FileRepository::removeMany(const std::vector<std::string>& fileNames)
+{
+    for (const std::string& fileName : fileNames)
+    {
+        remove(fileName);
+    }
+}
+
+std::unique_ptr<FileInfo> FileRepository::getFileInfoByHash(const std::string& hash)
+{
+    const auto fileNames = getAllFileNames();
+    if (!fileNames)
+    {
+        return nullptr;
+    }
+
+    for (const std::string& fileName : *fileNames)
+    {
+        auto fileInfo = getFileInfo(fileName);
+        if (fileInfo && fileInfo->hash == hash)
+        {
+            return fileInfo;
+        }
+    }
+
+    return nullptr;
+}
+
+void FileRepository::touch(const std::string& /* fileName */) {}
+
+std::unique_ptr<std::vector<std::string>> FileRepository::getFileNamesByLastUse()
+{
+    return getAllFileNames();
+}
+}    // namespace wolkabout
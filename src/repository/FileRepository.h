@@ -35,10 +35,43 @@ public:
 
     virtual void store(const FileInfo& info) = 0;
 
+    /**
+     * @brief Stores info of multiple files at once
+     * @param infos Infos to store
+     * Default implementation stores infos one by one
+     */
+    virtual void storeAll(const std::vector<FileInfo>& infos);
+
     virtual void remove(const std::string& fileName) = 0;
+
+    /**
+     * @brief Removes info of multiple files at once
+     * @param fileNames Names of files to remove
+     * Default implementation removes infos one by one
+     */
+    virtual void removeMany(const std::vector<std::string>& fileNames);
     virtual void removeAll() = 0;
 
     virtual bool containsInfoForFile(const std::string& fileName) = 0;
+
+    /**
+     * @brief Finds file with given content
+     * @param hash Base64 encoded SHA-256 of file content
+     * @return Info of file, or nullptr if no file has that content. Default implementation scans all files
+     */
+    virtual std::unique_ptr<FileInfo> getFileInfoByHash(const std::string& hash);
+
+    /**
+     * @brief Marks file as used, moving it to the end of least recently used order
+     * Default implementation does not track usage
+     */
+    virtual void touch(const std::string& fileName);
+
+    /**
+     * @brief Returns names of all files, least recently stored or used first
+     * Default implementation returns files in order of getAllFileNames
+     */
+    virtual std::unique_ptr<std::vector<std::string>> getFileNamesByLastUse();
 };
 }    // namespace wolkabout
 
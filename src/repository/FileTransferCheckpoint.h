@@ -0,0 +1,50 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FILETRANSFERCHECKPOINT_H
+#define FILETRANSFERCHECKPOINT_H
+
+#include "utilities/ByteUtils.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace wolkabout
+{
+struct FileTransferCheckpoint
+{
+    FileTransferCheckpoint(std::string name_, ByteArray hash_, unsigned packetIndex_, ByteArray previousPacketHash_,
+                           std::uint64_t offset_)
+    : name{std::move(name_)}
+    , hash{std::move(hash_)}
+    , packetIndex{packetIndex_}
+    , previousPacketHash{std::move(previousPacketHash_)}
+    , offset{offset_}
+    {
+    }
+
+    std::string name;
+    ByteArray hash;
+
+    // Index of the next packet to request, all packets before it are in the partial file
+    unsigned packetIndex;
+    ByteArray previousPacketHash;
+    std::uint64_t offset;
+};
+}    // namespace wolkabout
+
+#endif    // FILETRANSFERCHECKPOINT_H
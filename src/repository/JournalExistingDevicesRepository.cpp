@@ -0,0 +1,213 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "repository/JournalExistingDevicesRepository.h"
+#include "utilities/GatewayLog.h"
+#include "utilities/json.hpp"
+
+#include <cstdio>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+bool isFilePresent(const std::string& path)
+{
+    return std::ifstream{path}.good();
+}
+}    // namespace
+
+namespace wolkabout
+{
+JournalExistingDevicesRepository::JournalExistingDevicesRepository(const std::string& file,
+                                                                   const std::string& legacyJsonFile)
+: m_file{file}, m_journalLines{0}
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    if (isFilePresent(m_file))
+    {
+        readJournal();
+    }
+    else if (!legacyJsonFile.empty() && isFilePresent(legacyJsonFile))
+    {
+        importLegacyJsonFile(legacyJsonFile);
+    }
+
+    if (m_journalLines != m_deviceKeys.size() || !isFilePresent(m_file))
+    {
+        writeJournal();
+    }
+
+    openJournalForAppend();
+}
+
+void JournalExistingDevicesRepository::addDeviceKey(const std::string& deviceKey)
+{
+    if (deviceKey.empty() || deviceKey.find('\n') != std::string::npos)
+    {
+        LOG(ERROR) << "JournalExistingDevicesRepository: Invalid device key '" << deviceKey << "'";
+        return;
+    }
+
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    if (!insert(deviceKey))
+    {
+        return;
+    }
+
+    m_journal << deviceKey << '\n';
+    m_journal.flush();
+    ++m_journalLines;
+
+    if (!m_journal.good())
+    {
+        LOG(ERROR) << "JournalExistingDevicesRepository: Unable to append to '" << m_file << "'";
+    }
+}
+
+std::vector<std::string> JournalExistingDevicesRepository::getDeviceKeys()
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    return m_deviceKeys;
+}
+
+bool JournalExistingDevicesRepository::compact()
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+
+    m_journal.close();
+    const bool compacted = writeJournal();
+    openJournalForAppend();
+
+    return compacted;
+}
+
+void JournalExistingDevicesRepository::readJournal()
+{
+    std::ifstream journal{m_file, std::ios::binary};
+    const std::string content{std::istreambuf_iterator<char>{journal}, std::istreambuf_iterator<char>{}};
+
+    std::string::size_type start = 0;
+    while (true)
+    {
+        const auto end = content.find('\n', start);
+        if (end == std::string::npos)
+        {
+            // line without terminator was cut short while being appended
+            if (start != content.size())
+            {
+                LOG(WARN) << "JournalExistingDevicesRepository: Discarding partially written entry in '" << m_file
+                          << "'";
+            }
+            break;
+        }
+
+        ++m_journalLines;
+        if (end != start)
+        {
+            insert(content.substr(start, end - start));
+        }
+
+        start = end + 1;
+    }
+
+    if (start != content.size())
+    {
+        // counted as redundant so the torn tail is compacted away
+        ++m_journalLines;
+    }
+}
+
+void JournalExistingDevicesRepository::importLegacyJsonFile(const std::string& legacyJsonFile)
+{
+    try
+    {
+        std::ifstream inputFileStream(legacyJsonFile);
+        const nlohmann::json json = nlohmann::json::parse(inputFileStream);
+
+        if (json.find("deviceKeys") != json.end())
+        {
+            for (const std::string& deviceKey : json.at("deviceKeys").get<std::vector<std::string>>())
+            {
+                insert(deviceKey);
+            }
+        }
+
+        LOG(INFO) << "JournalExistingDevicesRepository: Imported " << m_deviceKeys.size() << " device keys from '"
+                  << legacyJsonFile << "'";
+    }
+    catch (const std::exception& e)
+    {
+        LOG(ERROR) << "JournalExistingDevicesRepository: Unable to import '" << legacyJsonFile << "': " << e.what();
+    }
+}
+
+bool JournalExistingDevicesRepository::insert(const std::string& deviceKey)
+{
+    if (!m_index.insert(deviceKey).second)
+    {
+        return false;
+    }
+
+    m_deviceKeys.push_back(deviceKey);
+    return true;
+}
+
+bool JournalExistingDevicesRepository::writeJournal()
+{
+    const std::string temporaryFilePath = m_file + ".tmp";
+
+    {
+        std::ofstream file{temporaryFilePath, std::ios::binary | std::ios::trunc};
+        for (const std::string& deviceKey : m_deviceKeys)
+        {
+            file << deviceKey << '\n';
+        }
+
+        if (!file.good())
+        {
+            LOG(ERROR) << "JournalExistingDevicesRepository: Unable to write '" << temporaryFilePath << "'";
+            return false;
+        }
+    }
+
+    // rename replaces journal atomically, so a crash during compaction leaves the previous journal intact
+    if (std::rename(temporaryFilePath.c_str(), m_file.c_str()) != 0)
+    {
+        LOG(ERROR) << "JournalExistingDevicesRepository: Unable to replace '" << m_file << "'";
+        std::remove(temporaryFilePath.c_str());
+        return false;
+    }
+
+    m_journalLines = m_deviceKeys.size();
+    return true;
+}
+
+void JournalExistingDevicesRepository::openJournalForAppend()
+{
+    m_journal.open(m_file, std::ios::binary | std::ios::app);
+    if (!m_journal.is_open())
+    {
+        LOG(ERROR) << "JournalExistingDevicesRepository: Unable to open '" << m_file << "'";
+    }
+}
+}    // namespace wolkabout
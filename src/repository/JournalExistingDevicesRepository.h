@@ -0,0 +1,74 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef JOURNALEXISTINGDEVICESREPOSITORY_H
+#define JOURNALEXISTINGDEVICESREPOSITORY_H
+
+#include "repository/ExistingDevicesRepository.h"
+
+#include <cstddef>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Existing devices repository backed by append-only journal file
+ *
+ * Keys are kept in memory, indexed by hash set, and each new key is appended to journal as single line,
+ * so registration costs one short write instead of rewriting whole file.
+ * Journal is compacted on opening when it contains duplicate, empty or partially written lines.
+ * Keys from file written by JsonFileExistingDevicesRepository are imported when journal does not exist yet.
+ */
+class JournalExistingDevicesRepository : public ExistingDevicesRepository
+{
+public:
+    JournalExistingDevicesRepository(const std::string& file = "existingDevices.journal",
+                                     const std::string& legacyJsonFile = "existingDevices.json");
+
+    void addDeviceKey(const std::string& deviceKey) override;
+
+    std::vector<std::string> getDeviceKeys() override;
+
+    /**
+     * @brief Rewrites journal to contain every key exactly once
+     * @return true if journal was replaced
+     */
+    bool compact();
+
+private:
+    void readJournal();
+    void importLegacyJsonFile(const std::string& legacyJsonFile);
+
+    bool insert(const std::string& deviceKey);
+    bool writeJournal();
+    void openJournalForAppend();
+
+    std::mutex m_mutex;
+    const std::string m_file;
+
+    std::unordered_set<std::string> m_index;
+    std::vector<std::string> m_deviceKeys;
+
+    std::ofstream m_journal;
+    std::size_t m_journalLines;
+};
+}    // namespace wolkabout
+
+#endif    // JOURNALEXISTINGDEVICESREPOSITORY_H
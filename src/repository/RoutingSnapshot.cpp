@@ -0,0 +1,315 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "repository/RoutingSnapshot.h"
+#include "model/DeviceReferences.h"
+#include "utilities/Logger.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace wolkabout
+{
+namespace
+{
+const char MAGIC[4] = {'W', 'G', 'R', 'S'};
+const std::uint32_t VERSION = 1;
+
+// values are stored in host byte order, snapshot is only read by the gateway that wrote it
+template <class T> void append(std::string& buffer, T value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendString(std::string& buffer, const std::string& text)
+{
+    append(buffer, static_cast<std::uint32_t>(text.size()));
+    buffer.append(text);
+}
+
+class Cursor
+{
+public:
+    Cursor(const char* data, std::size_t size) : m_position{data}, m_end{data + size} {}
+
+    template <class T> bool read(T& value)
+    {
+        if (static_cast<std::size_t>(m_end - m_position) < sizeof(value))
+        {
+            return false;
+        }
+
+        std::memcpy(&value, m_position, sizeof(value));
+        m_position += sizeof(value);
+        return true;
+    }
+
+    bool readString(std::string& text)
+    {
+        std::uint32_t size;
+        if (!read(size) || static_cast<std::size_t>(m_end - m_position) < size)
+        {
+            return false;
+        }
+
+        text.assign(m_position, size);
+        m_position += size;
+        return true;
+    }
+
+    bool atEnd() const { return m_position == m_end; }
+
+private:
+    const char* m_position;
+    const char* const m_end;
+};
+
+bool readReferences(Cursor& cursor, std::shared_ptr<const DeviceReferences>& references)
+{
+    std::uint8_t encoding;
+    std::uint32_t count;
+    const auto maximumEncoding = static_cast<std::uint8_t>(DeviceReferences::PayloadEncoding::MESSAGE_PACK);
+    if (!cursor.read(encoding) || encoding > maximumEncoding || !cursor.read(count))
+    {
+        return false;
+    }
+
+    std::unordered_map<std::string, double> sensorRanges;
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        std::string reference;
+        double range;
+        if (!cursor.readString(reference) || !cursor.read(range))
+        {
+            return false;
+        }
+
+        sensorRanges.emplace(std::move(reference), range);
+    }
+
+    std::unordered_set<std::string> alarms;
+    std::unordered_set<std::string> actuators;
+    for (auto* set : {&alarms, &actuators})
+    {
+        if (!cursor.read(count))
+        {
+            return false;
+        }
+
+        for (std::uint32_t i = 0; i < count; ++i)
+        {
+            std::string reference;
+            if (!cursor.readString(reference))
+            {
+                return false;
+            }
+
+            set->insert(std::move(reference));
+        }
+    }
+
+    references = std::make_shared<const DeviceReferences>(std::move(sensorRanges), std::move(alarms),
+                                                          std::move(actuators),
+                                                          static_cast<DeviceReferences::PayloadEncoding>(encoding));
+    return true;
+}
+}    // namespace
+
+bool RoutingSnapshot::write(const std::string& path, const std::string& databasePath, const Devices& devices)
+{
+    std::uint64_t databaseDevice;
+    std::uint64_t databaseInode;
+    if (!databaseIdentity(databasePath, databaseDevice, databaseInode))
+    {
+        LOG(ERROR) << "RoutingSnapshot: Unable to stat database '" << databasePath << "'";
+        return false;
+    }
+
+    // devices of the same template share references object, which is written once
+    std::unordered_map<const DeviceReferences*, std::uint32_t> indexes;
+    std::vector<const DeviceReferences*> referenceSets;
+    for (const auto& device : devices)
+    {
+        if (device.second && indexes.emplace(device.second.get(), referenceSets.size()).second)
+        {
+            referenceSets.push_back(device.second.get());
+        }
+    }
+
+    std::string buffer;
+    buffer.append(MAGIC, sizeof(MAGIC));
+    append(buffer, VERSION);
+    append(buffer, databaseDevice);
+    append(buffer, databaseInode);
+    append(buffer, static_cast<std::uint32_t>(referenceSets.size()));
+
+    for (const DeviceReferences* references : referenceSets)
+    {
+        append(buffer, static_cast<std::uint8_t>(references->getPayloadEncoding()));
+
+        append(buffer, static_cast<std::uint32_t>(references->getSensorRanges().size()));
+        for (const auto& sensor : references->getSensorRanges())
+        {
+            appendString(buffer, sensor.first);
+            append(buffer, sensor.second);
+        }
+
+        for (const auto* set : {&references->getAlarms(), &references->getActuators()})
+        {
+            append(buffer, static_cast<std::uint32_t>(set->size()));
+            for (const auto& reference : *set)
+            {
+                appendString(buffer, reference);
+            }
+        }
+    }
+
+    std::uint32_t deviceCount = 0;
+    for (const auto& device : devices)
+    {
+        deviceCount += device.second ? 1 : 0;
+    }
+
+    append(buffer, deviceCount);
+    for (const auto& device : devices)
+    {
+        if (device.second)
+        {
+            appendString(buffer, device.first);
+            append(buffer, indexes[device.second.get()]);
+        }
+    }
+
+    const std::string temporaryFilePath = path + ".tmp";
+    {
+        std::ofstream file{temporaryFilePath, std::ios::binary | std::ios::trunc};
+        file.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        if (!file.good())
+        {
+            LOG(ERROR) << "RoutingSnapshot: Unable to write '" << temporaryFilePath << "'";
+            file.close();
+            std::remove(temporaryFilePath.c_str());
+            return false;
+        }
+    }
+
+    if (std::rename(temporaryFilePath.c_str(), path.c_str()) != 0)
+    {
+        LOG(ERROR) << "RoutingSnapshot: Unable to replace '" << path << "'";
+        std::remove(temporaryFilePath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+bool RoutingSnapshot::load(const std::string& path, const std::string& databasePath, Devices& devices)
+{
+    devices.clear();
+
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    const auto size = static_cast<std::size_t>(info.st_size);
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED)
+    {
+        LOG(ERROR) << "RoutingSnapshot: Unable to map '" << path << "'";
+        return false;
+    }
+
+    Cursor cursor{static_cast<const char*>(mapping), size};
+
+    char magic[sizeof(MAGIC)];
+    std::uint32_t version = 0;
+    std::uint64_t snapshotDevice = 0;
+    std::uint64_t snapshotInode = 0;
+    std::uint64_t databaseDevice = 0;
+    std::uint64_t databaseInode = 0;
+    const bool hasHeader = cursor.read(magic) && std::memcmp(magic, MAGIC, sizeof(MAGIC)) == 0 &&
+                           cursor.read(version) && version == VERSION && cursor.read(snapshotDevice) &&
+                           cursor.read(snapshotInode);
+
+    // database replaced since snapshot was written may hold other devices
+    const bool isStale = hasHeader && (!databaseIdentity(databasePath, databaseDevice, databaseInode) ||
+                                       databaseDevice != snapshotDevice || databaseInode != snapshotInode);
+
+    std::vector<std::shared_ptr<const DeviceReferences>> referenceSets;
+    std::uint32_t count = 0;
+    bool valid = hasHeader && !isStale && cursor.read(count);
+    for (std::uint32_t i = 0; valid && i < count; ++i)
+    {
+        std::shared_ptr<const DeviceReferences> references;
+        valid = readReferences(cursor, references);
+        referenceSets.push_back(std::move(references));
+    }
+
+    valid = valid && cursor.read(count);
+    for (std::uint32_t i = 0; valid && i < count; ++i)
+    {
+        std::string deviceKey;
+        std::uint32_t index;
+        valid = cursor.readString(deviceKey) && cursor.read(index) && index < referenceSets.size();
+        if (valid)
+        {
+            devices.emplace_back(std::move(deviceKey), referenceSets[index]);
+        }
+    }
+
+    valid = valid && cursor.atEnd();
+    ::munmap(mapping, size);
+
+    if (!valid)
+    {
+        LOG(WARN) << "RoutingSnapshot: Ignoring " << (isStale ? "stale" : "invalid") << " snapshot '" << path << "'";
+        devices.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool RoutingSnapshot::databaseIdentity(const std::string& databasePath, std::uint64_t& device, std::uint64_t& inode)
+{
+    struct stat info;
+    if (::stat(databasePath.c_str(), &info) != 0)
+    {
+        return false;
+    }
+
+    device = static_cast<std::uint64_t>(info.st_dev);
+    inode = static_cast<std::uint64_t>(info.st_ino);
+    return true;
+}
+}    // namespace wolkabout
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ROUTINGSNAPSHOT_H
+#define ROUTINGSNAPSHOT_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+class DeviceReferences;
+
+/**
+ * @brief Compact binary image of registered devices and their template references
+ *
+ * Lets gateway start routing subdevice messages without reading device repository. Devices sharing
+ * the same references object also share one entry in the image, and share one object once loaded.
+ * Image is bound to identity of database file it was taken from, and is stale once that file is replaced.
+ */
+class RoutingSnapshot
+{
+public:
+    using Devices = std::vector<std::pair<std::string, std::shared_ptr<const DeviceReferences>>>;
+
+    /**
+     * @brief Writes devices to snapshot file, replacing it atomically
+     * @param path Path of snapshot file
+     * @param databasePath Path of database devices are stored in
+     * @param devices Device keys with their references
+     * @return false if file can not be written
+     */
+    static bool write(const std::string& path, const std::string& databasePath, const Devices& devices);
+
+    /**
+     * @brief Maps snapshot file and reads devices from it
+     * @param path Path of snapshot file
+     * @param databasePath Path of database devices are stored in
+     * @param devices Receives device keys with their references
+     * @return false if file is missing, invalid, or was taken from another database file
+     */
+    static bool load(const std::string& path, const std::string& databasePath, Devices& devices);
+
+private:
+    static bool databaseIdentity(const std::string& databasePath, std::uint64_t& device, std::uint64_t& inode);
+};
+}    // namespace wolkabout
+
+#endif    // ROUTINGSNAPSHOT_H
@@ -20,22 +20,26 @@
 #include "model/ConfigurationTemplate.h"
 #include "model/DataType.h"
 #include "model/DetailedDevice.h"
+#include "model/DeviceReferences.h"
 #include "model/DeviceTemplate.h"
 
-#include "utilities/Logger.h"
+#include "utilities/GatewayLog.h"
 
 #include "Poco/Crypto/DigestEngine.h"
 #include "Poco/Data/SQLite/Connector.h"
 #include "Poco/Data/SQLite/SQLiteException.h"
 #include "Poco/Data/Session.h"
 #include "Poco/Data/Statement.h"
+#include "Poco/RWLock.h"
 #include "Poco/String.h"
 #include "Poco/Types.h"
 
+#include <condition_variable>
 #include <memory>
 #include <mutex>
 #include <regex>
 #include <string>
+#include <vector>
 
 namespace wolkabout
 {
@@ -57,11 +61,136 @@ template <class T> Poco::Nullable<T> fromOptional(const WolkOptional<T>& wrapper
     return Poco::Nullable<T>(wrapper.value());
 }
 
-SQLiteDeviceRepository::SQLiteDeviceRepository(const std::string& connectionString)
+struct SQLiteDeviceRepository::PreparedStatements
+{
+    explicit PreparedStatements(Session& session)
+    : findDeviceTemplateId{0}
+    , containsDeviceCount{0}
+    , findDevice{session}
+    , containsDevice{session}
+    , findDeviceKeys{session}
+    , findTemplateHash{session}
+    {
+        findDevice << "SELECT name, device_template_id FROM device WHERE device.key=?;", useRef(findDeviceKey),
+          into(findDeviceName), into(findDeviceTemplateId);
+
+        findTemplateHash << "SELECT device_template.sha256 FROM device INNER JOIN device_template ON "
+                            "device.device_template_id=device_template.id WHERE device.key=?;",
+          useRef(findTemplateHashKey), into(templateHash);
+
+        containsDevice << "SELECT count(*) FROM device WHERE device.key=?;", useRef(containsDeviceKey),
+          into(containsDeviceCount);
+
+        findDeviceKeys << "SELECT key FROM device;", into(deviceKeys);
+    }
+
+    // Buffers are declared before statements bound to them, so they outlive the statements
+    std::string findDeviceKey;
+    std::string findDeviceName;
+    Poco::UInt64 findDeviceTemplateId;
+
+    std::string containsDeviceKey;
+    Poco::UInt64 containsDeviceCount;
+
+    std::vector<std::string> deviceKeys;
+
+    std::string findTemplateHashKey;
+    std::string templateHash;
+
+    Statement findDevice;
+    Statement containsDevice;
+    Statement findDeviceKeys;
+    Statement findTemplateHash;
+};
+
+class SQLiteDeviceRepository::ReaderLease
+{
+public:
+    explicit ReaderLease(SQLiteDeviceRepository& repository) : m_repository{repository}, m_writerLock{}
+    {
+        if (!m_repository.m_pooledReaders)
+        {
+            m_writerLock = std::unique_lock<std::recursive_mutex>{m_repository.m_mutex};
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock{m_repository.m_readersMutex};
+        m_repository.m_readerReleased.wait(lock, [&] { return !m_repository.m_idleReaders.empty(); });
+
+        m_reader = std::move(m_repository.m_idleReaders.back());
+        m_repository.m_idleReaders.pop_back();
+    }
+
+    ~ReaderLease()
+    {
+        if (!m_reader)
+        {
+            return;
+        }
+
+        try
+        {
+            if (m_reader->session->isTransaction())
+            {
+                m_reader->session->commit();
+            }
+        }
+        catch (...)
+        {
+            LOG(ERROR) << "SQLiteDeviceRepository: Error ending read transaction";
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{m_repository.m_readersMutex};
+            m_repository.m_idleReaders.push_back(std::move(m_reader));
+        }
+
+        m_repository.m_readerReleased.notify_one();
+    }
+
+    ReaderLease(const ReaderLease&) = delete;
+    ReaderLease& operator=(const ReaderLease&) = delete;
+
+    /**
+     * @brief Makes following queries read from single snapshot, writer session already sees its own state
+     */
+    void beginSnapshot()
+    {
+        if (m_reader)
+        {
+            m_reader->session->begin();
+        }
+    }
+
+    Session& session() { return m_reader ? *m_reader->session : *m_repository.m_session; }
+
+    PreparedStatements& statements() { return m_reader ? *m_reader->statements : *m_repository.m_statements; }
+
+private:
+    SQLiteDeviceRepository& m_repository;
+    std::unique_lock<std::recursive_mutex> m_writerLock;
+    std::unique_ptr<ReaderSession> m_reader;
+};
+
+SQLiteDeviceRepository::SQLiteDeviceRepository(const std::string& connectionString, bool writeAheadLogging,
+                                               bool synchronousNormal, std::size_t readerSessions)
+: m_pooledReaders{false}
 {
     Poco::Data::SQLite::Connector::registerConnector();
     m_session = std::unique_ptr<Session>(new Session(Poco::Data::SQLite::Connector::KEY, connectionString));
 
+    if (writeAheadLogging)
+    {
+        std::string journalMode;
+        *m_session << "PRAGMA journal_mode=WAL;", into(journalMode), now;
+        GATEWAY_LOG(DEBUG) << "SQLiteDeviceRepository: Journal mode set to " << journalMode;
+    }
+
+    if (synchronousNormal)
+    {
+        *m_session << "PRAGMA synchronous=NORMAL;", now;
+    }
+
     Statement statement(*m_session);
 
     // Alarm template
@@ -122,6 +251,79 @@ SQLiteDeviceRepository::SQLiteDeviceRepository(const std::string& connectionStri
     statement << "PRAGMA foreign_keys=on;";
 
     statement.execute();
+
+    // duplicates can not be created once unique index exists, so they are looked for on first open only
+    Poco::UInt64 templateHashIndexCount = 0;
+    *m_session << "SELECT COUNT(*) FROM sqlite_master WHERE type='index' AND name='device_template_sha256';",
+      into(templateHashIndexCount), now;
+    if (templateHashIndexCount == 0)
+    {
+        removeDuplicateTemplates();
+    }
+
+    *m_session << "CREATE UNIQUE INDEX IF NOT EXISTS device_template_sha256 ON device_template(sha256);", now;
+
+    // Foreign key columns are not indexed by SQLite, without these removing a template scans every child table
+    Statement indices(*m_session);
+    indices << "CREATE INDEX IF NOT EXISTS alarm_template_device_template_id ON alarm_template(device_template_id);";
+    indices << "CREATE INDEX IF NOT EXISTS actuator_template_device_template_id "
+               "ON actuator_template(device_template_id);";
+    indices << "CREATE INDEX IF NOT EXISTS sensor_template_device_template_id ON sensor_template(device_template_id);";
+    indices << "CREATE INDEX IF NOT EXISTS configuration_template_device_template_id "
+               "ON configuration_template(device_template_id);";
+    indices << "CREATE INDEX IF NOT EXISTS configuration_label_configuration_template_id "
+               "ON configuration_label(configuration_template_id);";
+    indices << "CREATE INDEX IF NOT EXISTS type_parameters_device_template_id ON type_parameters(device_template_id);";
+    indices << "CREATE INDEX IF NOT EXISTS connectivity_parameters_device_template_id "
+               "ON connectivity_parameters(device_template_id);";
+    indices << "CREATE INDEX IF NOT EXISTS firmware_update_parameters_device_template_id "
+               "ON firmware_update_parameters(device_template_id);";
+    indices << "CREATE INDEX IF NOT EXISTS device_device_template_id ON device(device_template_id);";
+    indices.execute();
+
+    m_statements.reset(new PreparedStatements(*m_session));
+
+    if (readerSessions != 0 && !writeAheadLogging)
+    {
+        LOG(WARN) << "SQLiteDeviceRepository: Reader sessions require WAL journal mode, reads are serialized";
+        return;
+    }
+
+    for (std::size_t i = 0; i < readerSessions; ++i)
+    {
+        std::unique_ptr<ReaderSession> reader{new ReaderSession()};
+        reader->session.reset(new Session(Poco::Data::SQLite::Connector::KEY, connectionString));
+        *reader->session << "PRAGMA query_only=1;", now;
+        reader->statements.reset(new PreparedStatements(*reader->session));
+
+        m_idleReaders.push_back(std::move(reader));
+    }
+
+    m_pooledReaders = !m_idleReaders.empty();
+}
+
+SQLiteDeviceRepository::~SQLiteDeviceRepository() = default;
+
+void SQLiteDeviceRepository::removeDuplicateTemplates()
+{
+    // Databases created before templates were looked up by hash can hold several copies of the same template
+    try
+    {
+        m_session->begin();
+
+        Statement statement(*m_session);
+        statement << "UPDATE device SET device_template_id=COALESCE((SELECT MIN(duplicate.id) FROM device_template "
+                     "AS duplicate INNER JOIN device_template AS original ON duplicate.sha256=original.sha256 "
+                     "WHERE original.id=device.device_template_id), device_template_id);";
+        statement << "DELETE FROM device_template WHERE id NOT IN (SELECT device_template_id FROM device);", now;
+
+        m_session->commit();
+    }
+    catch (...)
+    {
+        rollback();
+        LOG(ERROR) << "SQLiteDeviceRepository: Error removing duplicate device templates";
+    }
 }
 
 void SQLiteDeviceRepository::save(const DetailedDevice& device)
@@ -130,149 +332,205 @@ void SQLiteDeviceRepository::save(const DetailedDevice& device)
 
     try
     {
-        Statement statement(*m_session);
+        m_session->begin();
+        saveDevice(device);
+        m_session->commit();
+    }
+    catch (...)
+    {
+        rollback();
+        LOG(ERROR) << "SQLiteDeviceRepository: Error saving device with key " << device.getKey();
+    }
+}
 
-        Poco::UInt64 devicesWithGivenKeyCount;
-        statement << "SELECT count(*) FROM device WHERE device.key=?;", useRef(device.getKey()),
-          into(devicesWithGivenKeyCount), now;
+void SQLiteDeviceRepository::saveAll(const std::vector<DetailedDevice>& devices)
+{
+    std::lock_guard<decltype(m_mutex)> l(m_mutex);
 
-        if (devicesWithGivenKeyCount != 0)
+    try
+    {
+        m_session->begin();
+        for (const DetailedDevice& device : devices)
         {
-            update(device);
-            return;
+            saveDevice(device);
         }
+        m_session->commit();
+        return;
+    }
+    catch (...)
+    {
+        rollback();
+        LOG(WARN) << "SQLiteDeviceRepository: Error saving " << devices.size() << " devices, saving them one by one";
+    }
 
-        const std::string deviceTemplateSha256 = calculateSha256(device.getTemplate());
-        statement.reset(*m_session);
-        Poco::UInt64 matchingDeviceTemplatesCount;
-        statement << "SELECT count(*) FROM device_template WHERE sha256=?;", useRef(deviceTemplateSha256),
-          into(matchingDeviceTemplatesCount), now;
-        if (matchingDeviceTemplatesCount != 0)
+    // one device that can not be saved must not keep the others from being saved
+    for (const DetailedDevice& device : devices)
+    {
+        try
+        {
+            m_session->begin();
+            saveDevice(device);
+            m_session->commit();
+        }
+        catch (...)
+        {
+            rollback();
+            LOG(ERROR) << "SQLiteDeviceRepository: Error saving device with key " << device.getKey();
+        }
+    }
+}
+
+void SQLiteDeviceRepository::saveDevice(const DetailedDevice& device)
+{
+    Statement statement(*m_session);
+
+    const std::string deviceTemplateSha256 = calculateSha256(device.getTemplate());
+    Poco::Nullable<Poco::UInt64> matchingDeviceTemplateId;
+    statement << "SELECT id FROM device_template WHERE sha256=?;", useRef(deviceTemplateSha256),
+      into(matchingDeviceTemplateId), now;
+
+    statement.reset(*m_session);
+    Poco::Nullable<Poco::UInt64> currentDeviceTemplateId;
+    statement << "SELECT device_template_id FROM device WHERE device.key=?;", useRef(device.getKey()),
+      into(currentDeviceTemplateId), now;
+
+    if (!currentDeviceTemplateId.isNull())
+    {
+        if (!matchingDeviceTemplateId.isNull() && currentDeviceTemplateId.value() == matchingDeviceTemplateId.value())
         {
-            // Equivalent template exists
+            // Same template, only name can differ
             statement.reset(*m_session);
-            statement << "INSERT INTO device SELECT ?, ?, id FROM device_template WHERE device_template.sha256=?;",
-              useRef(device.getKey()), useRef(device.getName()), useRef(deviceTemplateSha256), now;
+            statement << "UPDATE device SET name=? WHERE device.key=?;", useRef(device.getName()),
+              useRef(device.getKey()), now;
             return;
         }
 
-        // Create new device template
+        removeDevice(device.getKey());
+    }
+
+    if (!matchingDeviceTemplateId.isNull())
+    {
+        // Equivalent template exists
         statement.reset(*m_session);
-        statement << "BEGIN TRANSACTION;";
-        statement << "INSERT INTO device_template(firmware_update_protocol, sha256) VALUES(?, ?);",
-          useRef(device.getTemplate().getFirmwareUpdateType()), useRef(deviceTemplateSha256);
+        statement << "INSERT INTO device(key, name, device_template_id) VALUES(?, ?, ?);", useRef(device.getKey()),
+          useRef(device.getName()), bind(matchingDeviceTemplateId.value()), now;
+        return;
+    }
 
-        Poco::UInt64 deviceTemplateId;
-        statement << "SELECT last_insert_rowid();", into(deviceTemplateId);
+    // Create new device template
+    statement.reset(*m_session);
+    statement << "INSERT INTO device_template(firmware_update_protocol, sha256) VALUES(?, ?);",
+      useRef(device.getTemplate().getFirmwareUpdateType()), useRef(deviceTemplateSha256);
 
-        // Alarm templates
-        for (const wolkabout::AlarmTemplate& alarmTemplate : device.getTemplate().getAlarms())
-        {
-            statement << "INSERT INTO alarm_template(reference, name, description, device_template_id) "
-                         "VALUES(?, ?, ?, ?);",
-              useRef(alarmTemplate.getReference()), useRef(alarmTemplate.getName()),
-              useRef(alarmTemplate.getDescription()), useRef(deviceTemplateId);
-        }
+    Poco::UInt64 deviceTemplateId;
+    statement << "SELECT last_insert_rowid();", into(deviceTemplateId);
 
-        // Actuator templates
-        for (const wolkabout::ActuatorTemplate& actuatorTemplate : device.getTemplate().getActuators())
-        {
-            Poco::Nullable<double> minimum = fromOptional(actuatorTemplate.getMinimum());
-            Poco::Nullable<double> maximum = fromOptional(actuatorTemplate.getMaximum());
-
-            statement << "INSERT INTO actuator_template(reference, name, description, unit_symbol, reading_type, "
-                         "minimum, maximum, device_template_id) "
-                         "VALUES(?, ?, ?, ?, ?, ?, ?, ?);",
-              useRef(actuatorTemplate.getReference()), useRef(actuatorTemplate.getName()),
-              useRef(actuatorTemplate.getDescription()), useRef(actuatorTemplate.getUnitSymbol()),
-              useRef(actuatorTemplate.getReadingTypeName()), bind(minimum), bind(maximum), useRef(deviceTemplateId);
-        }
+    // Alarm templates
+    for (const wolkabout::AlarmTemplate& alarmTemplate : device.getTemplate().getAlarms())
+    {
+        statement << "INSERT INTO alarm_template(reference, name, description, device_template_id) "
+                     "VALUES(?, ?, ?, ?);",
+          useRef(alarmTemplate.getReference()), useRef(alarmTemplate.getName()),
+          useRef(alarmTemplate.getDescription()), useRef(deviceTemplateId);
+    }
 
-        // Sensor templates
-        for (const wolkabout::SensorTemplate& sensorTemplate : device.getTemplate().getSensors())
-        {
-            Poco::Nullable<double> minimum = fromOptional(sensorTemplate.getMinimum());
-            Poco::Nullable<double> maximum = fromOptional(sensorTemplate.getMaximum());
-
-            statement << "INSERT INTO sensor_template(reference, name, description, unit_symbol, reading_type, "
-                         "minimum, maximum, device_template_id) "
-                         "VALUES(?, ?, ?, ?, ?, ?, ?, ?);",
-              useRef(sensorTemplate.getReference()), useRef(sensorTemplate.getName()),
-              useRef(sensorTemplate.getDescription()), useRef(sensorTemplate.getUnitSymbol()),
-              useRef(sensorTemplate.getReadingTypeName()), bind(minimum), bind(maximum), useRef(deviceTemplateId);
-        }
+    // Actuator templates
+    for (const wolkabout::ActuatorTemplate& actuatorTemplate : device.getTemplate().getActuators())
+    {
+        Poco::Nullable<double> minimum = fromOptional(actuatorTemplate.getMinimum());
+        Poco::Nullable<double> maximum = fromOptional(actuatorTemplate.getMaximum());
+
+        statement << "INSERT INTO actuator_template(reference, name, description, unit_symbol, reading_type, "
+                     "minimum, maximum, device_template_id) "
+                     "VALUES(?, ?, ?, ?, ?, ?, ?, ?);",
+          useRef(actuatorTemplate.getReference()), useRef(actuatorTemplate.getName()),
+          useRef(actuatorTemplate.getDescription()), useRef(actuatorTemplate.getUnitSymbol()),
+          useRef(actuatorTemplate.getReadingTypeName()), bind(minimum), bind(maximum), useRef(deviceTemplateId);
+    }
 
-        // Configuration templates
-        for (const wolkabout::ConfigurationTemplate& configurationTemplate : device.getTemplate().getConfigurations())
-        {
-            const auto dataType = [&]() -> std::string {
-                if (configurationTemplate.getDataType() == DataType::BOOLEAN)
-                {
-                    return "BOOLEAN";
-                }
-                else if (configurationTemplate.getDataType() == DataType::NUMERIC)
-                {
-                    return "NUMERIC";
-                }
-                else if (configurationTemplate.getDataType() == DataType::STRING)
-                {
-                    return "STRING";
-                }
-
-                return "";
-            }();
-
-            Poco::Nullable<double> minimum = fromOptional(configurationTemplate.getMinimum());
-            Poco::Nullable<double> maximum = fromOptional(configurationTemplate.getMaximum());
-
-            statement << "INSERT INTO configuration_template(reference, name, description, data_type, minimum, "
-                         "maximum, default_value, device_template_id)"
-                         "VALUES(?, ?, ?, ?, ?, ?, ?, ?);",
-              useRef(configurationTemplate.getReference()), useRef(configurationTemplate.getName()),
-              useRef(configurationTemplate.getDescription()), bind(dataType), bind(minimum), bind(maximum),
-              useRef(configurationTemplate.getDefaultValue()), useRef(deviceTemplateId);
-
-            for (const std::string& label : configurationTemplate.getLabels())
+    // Sensor templates
+    for (const wolkabout::SensorTemplate& sensorTemplate : device.getTemplate().getSensors())
+    {
+        Poco::Nullable<double> minimum = fromOptional(sensorTemplate.getMinimum());
+        Poco::Nullable<double> maximum = fromOptional(sensorTemplate.getMaximum());
+
+        statement << "INSERT INTO sensor_template(reference, name, description, unit_symbol, reading_type, "
+                     "minimum, maximum, device_template_id) "
+                     "VALUES(?, ?, ?, ?, ?, ?, ?, ?);",
+          useRef(sensorTemplate.getReference()), useRef(sensorTemplate.getName()),
+          useRef(sensorTemplate.getDescription()), useRef(sensorTemplate.getUnitSymbol()),
+          useRef(sensorTemplate.getReadingTypeName()), bind(minimum), bind(maximum), useRef(deviceTemplateId);
+    }
+
+    // Configuration templates
+    for (const wolkabout::ConfigurationTemplate& configurationTemplate : device.getTemplate().getConfigurations())
+    {
+        const auto dataType = [&]() -> std::string {
+            if (configurationTemplate.getDataType() == DataType::BOOLEAN)
             {
-                statement << "INSERT INTO configuration_label SELECT NULL, ?, id FROM configuration_template WHERE "
-                             "configuration_template.reference=? AND configuration_template.device_template_id=?;",
-                  useRef(label), useRef(configurationTemplate.getReference()), useRef(deviceTemplateId);
+                return "BOOLEAN";
+            }
+            else if (configurationTemplate.getDataType() == DataType::NUMERIC)
+            {
+                return "NUMERIC";
+            }
+            else if (configurationTemplate.getDataType() == DataType::STRING)
+            {
+                return "STRING";
             }
-        }
 
-        // Type parameters
-        for (auto const& parameter : device.getTemplate().getTypeParameters())
-        {
-            statement << "INSERT INTO type_parameters(key, value, device_template_id)"
-                         "VALUES(?, ?, ?);",
-              useRef(parameter.first), useRef(parameter.second), useRef(deviceTemplateId);
-        }
+            return "";
+        }();
 
-        // Connectivity parameters
-        for (auto const& parameter : device.getTemplate().getConnectivityParameters())
-        {
-            statement << "INSERT INTO connectivity_parameters(key, value, device_template_id)"
-                         "VALUES(?, ?, ?);",
-              useRef(parameter.first), useRef(parameter.second), useRef(deviceTemplateId);
-        }
+        Poco::Nullable<double> minimum = fromOptional(configurationTemplate.getMinimum());
+        Poco::Nullable<double> maximum = fromOptional(configurationTemplate.getMaximum());
 
-        // Firmware update parameters
-        for (auto const& parameter : device.getTemplate().getFirmwareUpdateParameters())
+        statement << "INSERT INTO configuration_template(reference, name, description, data_type, minimum, "
+                     "maximum, default_value, device_template_id)"
+                     "VALUES(?, ?, ?, ?, ?, ?, ?, ?);",
+          useRef(configurationTemplate.getReference()), useRef(configurationTemplate.getName()),
+          useRef(configurationTemplate.getDescription()), bind(dataType), bind(minimum), bind(maximum),
+          useRef(configurationTemplate.getDefaultValue()), useRef(deviceTemplateId);
+
+        for (const std::string& label : configurationTemplate.getLabels())
         {
-            statement << "INSERT INTO firmware_update_parameters(key, value, device_template_id)"
-                         "VALUES(?, ?, ?);",
-              useRef(parameter.first), useRef(parameter.second), useRef(deviceTemplateId);
+            statement << "INSERT INTO configuration_label SELECT NULL, ?, id FROM configuration_template WHERE "
+                         "configuration_template.reference=? AND configuration_template.device_template_id=?;",
+              useRef(label), useRef(configurationTemplate.getReference()), useRef(deviceTemplateId);
         }
+    }
 
-        // Device
-        statement << "INSERT INTO device(key, name, device_template_id) VALUES(?, ?, ?);", useRef(device.getKey()),
-          useRef(device.getName()), useRef(deviceTemplateId);
-        statement << "COMMIT;", now;
+    // Type parameters
+    for (auto const& parameter : device.getTemplate().getTypeParameters())
+    {
+        statement << "INSERT INTO type_parameters(key, value, device_template_id)"
+                     "VALUES(?, ?, ?);",
+          useRef(parameter.first), useRef(parameter.second), useRef(deviceTemplateId);
     }
-    catch (...)
+
+    // Connectivity parameters
+    for (auto const& parameter : device.getTemplate().getConnectivityParameters())
     {
-        LOG(ERROR) << "SQLiteDeviceRepository: Error saving device with key " << device.getKey();
+        statement << "INSERT INTO connectivity_parameters(key, value, device_template_id)"
+                     "VALUES(?, ?, ?);",
+          useRef(parameter.first), useRef(parameter.second), useRef(deviceTemplateId);
+    }
+
+    // Firmware update parameters
+    for (auto const& parameter : device.getTemplate().getFirmwareUpdateParameters())
+    {
+        statement << "INSERT INTO firmware_update_parameters(key, value, device_template_id)"
+                     "VALUES(?, ?, ?);",
+          useRef(parameter.first), useRef(parameter.second), useRef(deviceTemplateId);
     }
+
+    // Device
+    statement << "INSERT INTO device(key, name, device_template_id) VALUES(?, ?, ?);", useRef(device.getKey()),
+      useRef(device.getName()), useRef(deviceTemplateId), now;
+
+    Poco::ScopedWriteRWLock deviceTemplatesLock{m_deviceTemplatesLock};
+    m_deviceTemplates[deviceTemplateId] = std::make_shared<const DeviceTemplate>(device.getTemplate());
+    m_deviceReferences.erase(deviceTemplateId);
 }
 
 void SQLiteDeviceRepository::remove(const std::string& deviceKey)
@@ -281,39 +539,65 @@ void SQLiteDeviceRepository::remove(const std::string& deviceKey)
 
     try
     {
-        Statement statement(*m_session);
+        m_session->begin();
+        removeDevice(deviceKey);
+        m_session->commit();
+    }
+    catch (...)
+    {
+        rollback();
+        LOG(ERROR) << "SQLiteDeviceRepository: Error removing device with key " << deviceKey;
+    }
+}
 
-        Poco::UInt64 deviceTemplateId;
-        statement << "SELECT device_template_id FROM device WHERE device.key=?;", useRef(deviceKey),
-          into(deviceTemplateId);
-        if (statement.execute() == 0)
-        {
-            return;
-        }
+void SQLiteDeviceRepository::removeMany(const std::vector<std::string>& deviceKeys)
+{
+    std::lock_guard<decltype(m_mutex)> l(m_mutex);
 
-        statement.reset(*m_session);
-        Poco::UInt64 numberOfDevicesReferencingTemplate;
-        statement << "SELECT count(*) FROM device WHERE device_template_id=?;", useRef(deviceTemplateId),
-          into(numberOfDevicesReferencingTemplate), now;
-        if (numberOfDevicesReferencingTemplate != 1)
+    try
+    {
+        m_session->begin();
+        for (const std::string& deviceKey : deviceKeys)
         {
-            statement.reset(*m_session);
-            statement << "DELETE FROM device WHERE device.key=?;", useRef(deviceKey), now;
-            return;
+            removeDevice(deviceKey);
         }
+        m_session->commit();
+    }
+    catch (...)
+    {
+        rollback();
+        LOG(ERROR) << "SQLiteDeviceRepository: Error removing " << deviceKeys.size() << " devices";
+    }
+}
 
-        statement.reset(*m_session);
-        statement << "BEGIN TRANSACTION;";
-
-        statement << "DELETE FROM device          WHERE device.key=?;", useRef(deviceKey);
-        statement << "DELETE FROM device_template WHERE device_template.id=?;", useRef(deviceTemplateId);
+void SQLiteDeviceRepository::removeDevice(const std::string& deviceKey)
+{
+    Statement statement(*m_session);
 
-        statement << "COMMIT;", now;
+    Poco::UInt64 deviceTemplateId;
+    statement << "SELECT device_template_id FROM device WHERE device.key=?;", useRef(deviceKey),
+      into(deviceTemplateId);
+    if (statement.execute() == 0)
+    {
+        return;
     }
-    catch (...)
+
+    statement.reset(*m_session);
+    Poco::UInt64 numberOfDevicesReferencingTemplate;
+    statement << "SELECT count(*) FROM device WHERE device_template_id=?;", useRef(deviceTemplateId),
+      into(numberOfDevicesReferencingTemplate), now;
+    if (numberOfDevicesReferencingTemplate != 1)
     {
-        LOG(ERROR) << "SQLiteDeviceRepository: Error removing device with key " << deviceKey;
+        statement.reset(*m_session);
+        statement << "DELETE FROM device WHERE device.key=?;", useRef(deviceKey), now;
+        return;
     }
+
+    statement.reset(*m_session);
+    statement << "DELETE FROM device          WHERE device.key=?;", useRef(deviceKey);
+    statement << "DELETE FROM device_template WHERE device_template.id=?;", useRef(deviceTemplateId), now;
+
+    forgetDeviceTemplate(deviceTemplateId);
 }
 
 void SQLiteDeviceRepository::removeAll()
@@ -321,28 +605,44 @@ void SQLiteDeviceRepository::removeAll()
     std::lock_guard<decltype(m_mutex)> l(m_mutex);
 
     const auto deviceKeysFromRepository = findAllDeviceKeys();
-    for (const std::string& deviceKey : *deviceKeysFromRepository)
+
+    try
     {
-        remove(deviceKey);
+        m_session->begin();
+        for (const std::string& deviceKey : *deviceKeysFromRepository)
+        {
+            removeDevice(deviceKey);
+        }
+        m_session->commit();
+    }
+    catch (...)
+    {
+        rollback();
+        LOG(ERROR) << "SQLiteDeviceRepository: Error removing devices";
     }
 }
 
 std::unique_ptr<DetailedDevice> SQLiteDeviceRepository::findByDeviceKey(const std::string& deviceKey)
 {
-    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+    ReaderLease reader{*this};
 
     Poco::UInt64 deviceTemplateId;
     std::string deviceName;
 
     try
     {
-        Statement statement(*m_session);
-        statement << "SELECT name, device_template_id FROM device WHERE device.key=?;", useRef(deviceKey),
-          into(deviceName), into(deviceTemplateId);
-        if (statement.execute() == 0)
+        // template of found device must not be removed before it is read
+        reader.beginSnapshot();
+
+        PreparedStatements& statements = reader.statements();
+        statements.findDeviceKey = deviceKey;
+        if (statements.findDevice.execute() == 0)
         {
             return nullptr;
         }
+
+        deviceName = statements.findDeviceName;
+        deviceTemplateId = statements.findDeviceTemplateId;
     }
     catch (...)
     {
@@ -352,216 +652,322 @@ std::unique_ptr<DetailedDevice> SQLiteDeviceRepository::findByDeviceKey(const st
 
     try
     {
-        // Device template
-        std::string firmwareUpdateProtocol;
+        const auto deviceTemplate = findDeviceTemplate(reader.session(), deviceTemplateId);
+        return std::unique_ptr<DetailedDevice>(new DetailedDevice(deviceName, deviceKey, *deviceTemplate));
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteDeviceRepository: Error deserializing device with key " << deviceKey;
+        return nullptr;
+    }
+}
 
-        Statement statement(*m_session);
-        statement << "SELECT firmware_update_protocol FROM device_template WHERE id=?;", useRef(deviceTemplateId),
-          into(firmwareUpdateProtocol), now;
+std::shared_ptr<const DeviceReferences> SQLiteDeviceRepository::findReferencesByDeviceKey(
+  const std::string& deviceKey)
+{
+    ReaderLease reader{*this};
 
-        auto deviceTemplate =
-          std::unique_ptr<DeviceTemplate>(new DeviceTemplate({}, {}, {}, {}, firmwareUpdateProtocol));
+    Poco::UInt64 deviceTemplateId;
 
-        // Alarm templates
-        std::string alarmReference;
-        std::string alarmName;
-        std::string alarmDescription;
-        statement.reset(*m_session);
-        statement << "SELECT reference, name, description FROM alarm_template WHERE device_template_id=?;",
-          useRef(deviceTemplateId), into(alarmReference), into(alarmName), into(alarmDescription), range(0, 1);
+    try
+    {
+        reader.beginSnapshot();
 
-        while (!statement.done())
+        PreparedStatements& statements = reader.statements();
+        statements.findDeviceKey = deviceKey;
+        if (statements.findDevice.execute() == 0)
         {
-            if (statement.execute() == 0)
-            {
-                break;
-            }
-
-            deviceTemplate->addAlarm(AlarmTemplate(alarmName, alarmReference, alarmDescription));
+            return nullptr;
         }
 
-        // Actuator templates
-        std::string actuatorReference;
-        std::string actuatorName;
-        std::string actuatorDescription;
-        std::string actuatorUnitSymbol;
-        std::string actuatorReadingType;
-        Poco::Nullable<double> actuatorMinimum;
-        Poco::Nullable<double> actuatorMaximum;
-        statement.reset(*m_session);
-        statement << "SELECT reference, name, description, unit_symbol, reading_type, "
-                     "minimum, maximum "
-                     "FROM actuator_template WHERE device_template_id=?;",
-          useRef(deviceTemplateId), into(actuatorReference), into(actuatorName), into(actuatorDescription),
-          into(actuatorUnitSymbol), into(actuatorReadingType), into(actuatorMinimum), into(actuatorMaximum),
-          range(0, 1);
-
-        while (!statement.done())
+        deviceTemplateId = statements.findDeviceTemplateId;
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteDeviceRepository: Error finding device with key " << deviceKey;
+        return nullptr;
+    }
+
+    try
+    {
         {
-            if (statement.execute() == 0)
+            Poco::ScopedReadRWLock deviceTemplatesLock{m_deviceTemplatesLock};
+            auto it = m_deviceReferences.find(deviceTemplateId);
+            if (it != m_deviceReferences.end())
             {
-                break;
+                return it->second;
             }
-
-            deviceTemplate->addActuator(ActuatorTemplate(actuatorName, actuatorReference, actuatorReadingType,
-                                                         actuatorUnitSymbol, actuatorDescription,
-                                                         toOptional(actuatorMinimum), toOptional(actuatorMaximum)));
         }
 
-        // Sensor templates
-        std::string sensorReference;
-        std::string sensorName;
-        std::string sensorDescription;
-        std::string sensorUnitSymbol;
-        std::string sensorReadingType;
-        Poco::Nullable<double> sensorMinimum;
-        Poco::Nullable<double> sensorMaximum;
-        statement.reset(*m_session);
-        statement << "SELECT reference, name, description, unit_symbol, reading_type, "
-                     "minimum, maximum "
-                     "FROM sensor_template WHERE device_template_id=?;",
-          useRef(deviceTemplateId), into(sensorReference), into(sensorName), into(sensorDescription),
-          into(sensorUnitSymbol), into(sensorReadingType), into(sensorMinimum), into(sensorMaximum), range(0, 1);
+        const auto deviceTemplate = findDeviceTemplate(reader.session(), deviceTemplateId);
+        std::shared_ptr<const DeviceReferences> references = std::make_shared<DeviceReferences>(*deviceTemplate);
 
-        while (!statement.done())
-        {
-            if (statement.execute() == 0)
-            {
-                break;
-            }
+        Poco::ScopedWriteRWLock deviceTemplatesLock{m_deviceTemplatesLock};
+        return m_deviceReferences.emplace(deviceTemplateId, references).first->second;
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteDeviceRepository: Error deserializing device with key " << deviceKey;
+        return nullptr;
+    }
+}
 
-            deviceTemplate->addSensor(SensorTemplate(sensorName, sensorReference, sensorReadingType, sensorUnitSymbol,
-                                                     sensorDescription, toOptional(sensorMinimum),
-                                                     toOptional(sensorMaximum)));
+std::string SQLiteDeviceRepository::findTemplateHash(const std::string& deviceKey)
+{
+    ReaderLease reader{*this};
+
+    try
+    {
+        PreparedStatements& statements = reader.statements();
+        statements.findTemplateHashKey = deviceKey;
+        if (statements.findTemplateHash.execute() == 0)
+        {
+            return "";
         }
 
-        // Configuration templates
-        Poco::UInt64 configurationTemplateId;
-        std::string configurationReference;
-        std::string configurationName;
-        std::string configurationDescription;
-        std::string configurationDataTypeStr;
-        Poco::Nullable<double> configurationMinimum;
-        Poco::Nullable<double> configurationMaximum;
-        std::string configurationDefaultValue;
-        statement.reset(*m_session);
-        statement << "SELECT id, reference, name, description, data_type, minimum, maximum, default_value"
-                     " FROM configuration_template WHERE device_template_id=?;",
-          useRef(deviceTemplateId), into(configurationTemplateId), into(configurationReference),
-          into(configurationName), into(configurationDescription), into(configurationDataTypeStr),
-          into(configurationMinimum), into(configurationMaximum), into(configurationDefaultValue), range(0, 1);
+        return statements.templateHash;
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteDeviceRepository: Error finding template of device with key " << deviceKey;
+        return "";
+    }
+}
 
-        while (!statement.done())
+std::shared_ptr<const DeviceTemplate> SQLiteDeviceRepository::findDeviceTemplate(Session& session,
+                                                                                 Poco::UInt64 deviceTemplateId)
+{
+    {
+        Poco::ScopedReadRWLock deviceTemplatesLock{m_deviceTemplatesLock};
+        auto it = m_deviceTemplates.find(deviceTemplateId);
+        if (it != m_deviceTemplates.end())
         {
-            if (statement.execute() == 0)
-            {
-                break;
-            }
+            return it->second;
+        }
+    }
 
-            const auto configurationDataType = [&]() -> DataType {
-                if (configurationDataTypeStr == "STRING")
-                {
-                    return DataType::STRING;
-                }
-                else if (configurationDataTypeStr == "BOOLEAN")
-                {
-                    return DataType::BOOLEAN;
-                }
-                else if (configurationDataTypeStr == "NUMERIC")
-                {
-                    return DataType::NUMERIC;
-                }
+    const auto deviceTemplate = loadDeviceTemplate(session, deviceTemplateId);
 
-                return DataType::STRING;
-            }();
+    Poco::ScopedWriteRWLock deviceTemplatesLock{m_deviceTemplatesLock};
+    return m_deviceTemplates.emplace(deviceTemplateId, deviceTemplate).first->second;
+}
 
-            std::vector<std::string> labels;
-            Statement selectLabelsStatement(*m_session);
-            selectLabelsStatement << "SELECT label FROM configuration_label WHERE configuration_template_id=?;",
-              bind(configurationTemplateId), into(labels), now;
+void SQLiteDeviceRepository::forgetDeviceTemplate(Poco::UInt64 deviceTemplateId)
+{
+    Poco::ScopedWriteRWLock deviceTemplatesLock{m_deviceTemplatesLock};
+    m_deviceTemplates.erase(deviceTemplateId);
+    m_deviceReferences.erase(deviceTemplateId);
+}
 
-            deviceTemplate->addConfiguration(ConfigurationTemplate(
-              configurationName, configurationReference, configurationDataType, configurationDescription,
-              configurationDefaultValue, labels, toOptional(configurationMinimum), toOptional(configurationMaximum)));
-        }
+std::shared_ptr<const DeviceTemplate> SQLiteDeviceRepository::loadDeviceTemplate(Session& session,
+                                                                                 Poco::UInt64 deviceTemplateId)
+{
+    // Device template
+    std::string firmwareUpdateProtocol;
 
-        // Type parameters
+    Statement statement(session);
+    statement << "SELECT firmware_update_protocol FROM device_template WHERE id=?;", useRef(deviceTemplateId),
+      into(firmwareUpdateProtocol), now;
 
-        std::string typeParameterKey;
-        std::string typeParameterValue;
-        statement.reset(*m_session);
-        statement << "SELECT key, value FROM type_parameters WHERE device_template_id=?;", useRef(deviceTemplateId),
-          into(typeParameterKey), into(typeParameterValue), range(0, 1);
+    auto deviceTemplate = std::unique_ptr<DeviceTemplate>(new DeviceTemplate({}, {}, {}, {}, firmwareUpdateProtocol));
+
+    // Alarm templates
+    std::string alarmReference;
+    std::string alarmName;
+    std::string alarmDescription;
+    statement.reset(session);
+    statement << "SELECT reference, name, description FROM alarm_template WHERE device_template_id=?;",
+      useRef(deviceTemplateId), into(alarmReference), into(alarmName), into(alarmDescription), range(0, 1);
 
-        while (!statement.done())
+    while (!statement.done())
+    {
+        if (statement.execute() == 0)
         {
-            if (statement.execute() == 0)
-            {
-                break;
-            }
+            break;
+        }
 
-            deviceTemplate->addTypeParameter(std::pair<std::string, std::string>(typeParameterKey, typeParameterValue));
+        deviceTemplate->addAlarm(AlarmTemplate(alarmName, alarmReference, alarmDescription));
+    }
+
+    // Actuator templates
+    std::string actuatorReference;
+    std::string actuatorName;
+    std::string actuatorDescription;
+    std::string actuatorUnitSymbol;
+    std::string actuatorReadingType;
+    Poco::Nullable<double> actuatorMinimum;
+    Poco::Nullable<double> actuatorMaximum;
+    statement.reset(session);
+    statement << "SELECT reference, name, description, unit_symbol, reading_type, "
+                 "minimum, maximum "
+                 "FROM actuator_template WHERE device_template_id=?;",
+      useRef(deviceTemplateId), into(actuatorReference), into(actuatorName), into(actuatorDescription),
+      into(actuatorUnitSymbol), into(actuatorReadingType), into(actuatorMinimum), into(actuatorMaximum),
+      range(0, 1);
+
+    while (!statement.done())
+    {
+        if (statement.execute() == 0)
+        {
+            break;
         }
 
-        // Connectivity parameters
+        deviceTemplate->addActuator(ActuatorTemplate(actuatorName, actuatorReference, actuatorReadingType,
+                                                     actuatorUnitSymbol, actuatorDescription,
+                                                     toOptional(actuatorMinimum), toOptional(actuatorMaximum)));
+    }
 
-        std::string connectivityParameterKey;
-        std::string connectivityParameterValue;
-        statement.reset(*m_session);
-        statement << "SELECT key, value FROM connectivity_parameters WHERE device_template_id=?;",
-          useRef(deviceTemplateId), into(connectivityParameterKey), into(connectivityParameterValue), range(0, 1);
+    // Sensor templates
+    std::string sensorReference;
+    std::string sensorName;
+    std::string sensorDescription;
+    std::string sensorUnitSymbol;
+    std::string sensorReadingType;
+    Poco::Nullable<double> sensorMinimum;
+    Poco::Nullable<double> sensorMaximum;
+    statement.reset(session);
+    statement << "SELECT reference, name, description, unit_symbol, reading_type, "
+                 "minimum, maximum "
+                 "FROM sensor_template WHERE device_template_id=?;",
+      useRef(deviceTemplateId), into(sensorReference), into(sensorName), into(sensorDescription),
+      into(sensorUnitSymbol), into(sensorReadingType), into(sensorMinimum), into(sensorMaximum), range(0, 1);
+
+    while (!statement.done())
+    {
+        if (statement.execute() == 0)
+        {
+            break;
+        }
 
-        while (!statement.done())
+        deviceTemplate->addSensor(SensorTemplate(sensorName, sensorReference, sensorReadingType, sensorUnitSymbol,
+                                                 sensorDescription, toOptional(sensorMinimum),
+                                                 toOptional(sensorMaximum)));
+    }
+
+    // Configuration templates
+    Poco::UInt64 configurationTemplateId;
+    std::string configurationReference;
+    std::string configurationName;
+    std::string configurationDescription;
+    std::string configurationDataTypeStr;
+    Poco::Nullable<double> configurationMinimum;
+    Poco::Nullable<double> configurationMaximum;
+    std::string configurationDefaultValue;
+    statement.reset(session);
+    statement << "SELECT id, reference, name, description, data_type, minimum, maximum, default_value"
+                 " FROM configuration_template WHERE device_template_id=?;",
+      useRef(deviceTemplateId), into(configurationTemplateId), into(configurationReference),
+      into(configurationName), into(configurationDescription), into(configurationDataTypeStr),
+      into(configurationMinimum), into(configurationMaximum), into(configurationDefaultValue), range(0, 1);
+
+    while (!statement.done())
+    {
+        if (statement.execute() == 0)
         {
-            if (statement.execute() == 0)
+            break;
+        }
+
+        const auto configurationDataType = [&]() -> DataType {
+            if (configurationDataTypeStr == "STRING")
             {
-                break;
+                return DataType::STRING;
+            }
+            else if (configurationDataTypeStr == "BOOLEAN")
+            {
+                return DataType::BOOLEAN;
+            }
+            else if (configurationDataTypeStr == "NUMERIC")
+            {
+                return DataType::NUMERIC;
             }
 
-            deviceTemplate->addConnectivityParameter(
-              std::pair<std::string, std::string>(connectivityParameterKey, connectivityParameterValue));
-        }
+            return DataType::STRING;
+        }();
 
-        // Firmware update parameters
+        std::vector<std::string> labels;
+        Statement selectLabelsStatement(session);
+        selectLabelsStatement << "SELECT label FROM configuration_label WHERE configuration_template_id=?;",
+          bind(configurationTemplateId), into(labels), now;
 
-        std::string firmwareUpdateParameterKey;
-        int firmwareUpdateParameterValue;
-        statement.reset(*m_session);
-        statement << "SELECT key, value FROM firmware_update_parameters WHERE device_template_id=?;",
-          useRef(deviceTemplateId), into(firmwareUpdateParameterKey), into(firmwareUpdateParameterValue), range(0, 1);
+        deviceTemplate->addConfiguration(ConfigurationTemplate(
+          configurationName, configurationReference, configurationDataType, configurationDescription,
+          configurationDefaultValue, labels, toOptional(configurationMinimum), toOptional(configurationMaximum)));
+    }
+
+    // Type parameters
 
-        while (!statement.done())
+    std::string typeParameterKey;
+    std::string typeParameterValue;
+    statement.reset(session);
+    statement << "SELECT key, value FROM type_parameters WHERE device_template_id=?;", useRef(deviceTemplateId),
+      into(typeParameterKey), into(typeParameterValue), range(0, 1);
+
+    while (!statement.done())
+    {
+        if (statement.execute() == 0)
         {
-            if (statement.execute() == 0)
-            {
-                break;
-            }
+            break;
+        }
+
+        deviceTemplate->addTypeParameter(std::pair<std::string, std::string>(typeParameterKey, typeParameterValue));
+    }
+
+    // Connectivity parameters
+
+    std::string connectivityParameterKey;
+    std::string connectivityParameterValue;
+    statement.reset(session);
+    statement << "SELECT key, value FROM connectivity_parameters WHERE device_template_id=?;",
+      useRef(deviceTemplateId), into(connectivityParameterKey), into(connectivityParameterValue), range(0, 1);
 
-            std::pair<std::string, bool> firmwareUpdateParameterPair;
-            firmwareUpdateParameterPair =
-              std::make_pair(firmwareUpdateParameterKey, static_cast<bool>(firmwareUpdateParameterValue));
-            deviceTemplate->addFirmwareUpdateParameter(firmwareUpdateParameterPair);
+    while (!statement.done())
+    {
+        if (statement.execute() == 0)
+        {
+            break;
         }
 
-        return std::unique_ptr<DetailedDevice>(new DetailedDevice(deviceName, deviceKey, *deviceTemplate));
+        deviceTemplate->addConnectivityParameter(
+          std::pair<std::string, std::string>(connectivityParameterKey, connectivityParameterValue));
     }
-    catch (...)
+
+    // Firmware update parameters
+
+    std::string firmwareUpdateParameterKey;
+    int firmwareUpdateParameterValue;
+    statement.reset(session);
+    statement << "SELECT key, value FROM firmware_update_parameters WHERE device_template_id=?;",
+      useRef(deviceTemplateId), into(firmwareUpdateParameterKey), into(firmwareUpdateParameterValue), range(0, 1);
+
+    while (!statement.done())
     {
-        LOG(ERROR) << "SQLiteDeviceRepository: Error deserializing device with key " << deviceKey;
-        return nullptr;
+        if (statement.execute() == 0)
+        {
+            break;
+        }
+
+        std::pair<std::string, bool> firmwareUpdateParameterPair;
+        firmwareUpdateParameterPair =
+          std::make_pair(firmwareUpdateParameterKey, static_cast<bool>(firmwareUpdateParameterValue));
+        deviceTemplate->addFirmwareUpdateParameter(firmwareUpdateParameterPair);
     }
+
+    return std::move(deviceTemplate);
 }
 
 std::unique_ptr<std::vector<std::string>> SQLiteDeviceRepository::findAllDeviceKeys()
 {
-    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+    ReaderLease reader{*this};
 
     auto deviceKeys = std::unique_ptr<std::vector<std::string>>(new std::vector<std::string>());
 
     try
     {
-        Statement statement(*m_session);
-        statement << "SELECT key FROM device;", into(*deviceKeys), now;
+        // extraction into vector appends, so results of previous execution are cleared first
+        PreparedStatements& statements = reader.statements();
+        statements.deviceKeys.clear();
+        statements.findDeviceKeys.execute();
+        deviceKeys->swap(statements.deviceKeys);
     }
     catch (...)
     {
@@ -573,14 +979,14 @@ std::unique_ptr<std::vector<std::string>> SQLiteDeviceRepository::findAllDeviceK
 
 bool SQLiteDeviceRepository::containsDeviceWithKey(const std::string& deviceKey)
 {
-    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+    ReaderLease reader{*this};
 
     try
     {
-        Poco::UInt64 deviceCount;
-        Statement statement(*m_session);
-        statement << "SELECT count(*) FROM device WHERE device.key=?;", useRef(deviceKey), into(deviceCount), now;
-        return deviceCount != 0 ? true : false;
+        PreparedStatements& statements = reader.statements();
+        statements.containsDeviceKey = deviceKey;
+        statements.containsDevice.execute();
+        return statements.containsDeviceCount != 0 ? true : false;
     }
     catch (...)
     {
@@ -589,12 +995,26 @@ bool SQLiteDeviceRepository::containsDeviceWithKey(const std::string& deviceKey)
     }
 }
 
-void SQLiteDeviceRepository::update(const DetailedDevice& device)
+void SQLiteDeviceRepository::rollback()
 {
-    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+    // Rolled back template rows may have been cached, and their ids can be reused
+    {
+        Poco::ScopedWriteRWLock deviceTemplatesLock{m_deviceTemplatesLock};
+        m_deviceTemplates.clear();
+        m_deviceReferences.clear();
+    }
 
-    remove(device.getKey());
-    save(device);
+    try
+    {
+        if (m_session->isTransaction())
+        {
+            m_session->rollback();
+        }
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteDeviceRepository: Error rolling back transaction";
+    }
 }
 
 std::string SQLiteDeviceRepository::calculateSha256(const AlarmTemplate& alarmTemplate)
@@ -18,12 +18,17 @@
 #define DEVICEREPOSITORYIMPL_H
 
 #include "Poco/Data/Session.h"
+#include "Poco/RWLock.h"
+#include "Poco/Types.h"
 #include "repository/DeviceRepository.h"
 
+#include <condition_variable>
+#include <cstddef>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 namespace wolkabout
 {
@@ -31,18 +36,32 @@ class AlarmTemplate;
 class ActuatorTemplate;
 class SensorTemplate;
 class ConfigurationTemplate;
+class DeviceReferences;
 class DeviceTemplate;
 
 class SQLiteDeviceRepository : public DeviceRepository
 {
 public:
-    SQLiteDeviceRepository(const std::string& connectionString = "deviceRepository.db");
-    virtual ~SQLiteDeviceRepository() = default;
+    /**
+     * @brief Opens device repository
+     * @param connectionString Path to SQLite database file
+     * @param writeAheadLogging Switches database to WAL journal mode
+     * @param synchronousNormal Sets synchronous=NORMAL, syncing only at checkpoints when used with WAL
+     * @param readerSessions Number of read-only sessions serving find and contains calls in parallel with each other
+     * and with writes. Requires writeAheadLogging, 0 serializes all calls on single session
+     */
+    SQLiteDeviceRepository(const std::string& connectionString = "deviceRepository.db", bool writeAheadLogging = false,
+                           bool synchronousNormal = false, std::size_t readerSessions = 0);
+    virtual ~SQLiteDeviceRepository();
 
     void save(const DetailedDevice& device) override;
 
+    void saveAll(const std::vector<DetailedDevice>& devices) override;
+
     void remove(const std::string& deviceKey) override;
 
+    void removeMany(const std::vector<std::string>& deviceKeys) override;
+
     void removeAll() override;
 
     std::unique_ptr<DetailedDevice> findByDeviceKey(const std::string& deviceKey) override;
@@ -51,7 +70,19 @@ public:
 
     bool containsDeviceWithKey(const std::string& deviceKey) override;
 
-private:
+    /**
+     * @brief Reads only device row, references are built once per template and shared by devices using it
+     */
+    std::shared_ptr<const DeviceReferences> findReferencesByDeviceKey(const std::string& deviceKey) override;
+
+    /**
+     * @brief Reads stored digest, without loading template
+     */
+    std::string findTemplateHash(const std::string& deviceKey) override;
+
+    /**
+     * @brief Digests stored in sha256 columns, equal digests mean equal templates
+     */
     static std::string calculateSha256(const AlarmTemplate& alarmTemplate);
     static std::string calculateSha256(const ActuatorTemplate& actuatorTemplate);
     static std::string calculateSha256(const SensorTemplate& sensorTemplate);
@@ -60,10 +91,49 @@ private:
     static std::string calculateSha256(const std::pair<std::string, bool>& firmwareUpdateParameter);
     static std::string calculateSha256(const DeviceTemplate& deviceTemplate);
 
-    void update(const DetailedDevice& device);
+private:
+    void removeDuplicateTemplates();
+
+    void saveDevice(const DetailedDevice& device);
+    void removeDevice(const std::string& deviceKey);
+    void rollback();
+
+    static std::shared_ptr<const DeviceTemplate> loadDeviceTemplate(Poco::Data::Session& session,
+                                                                    Poco::UInt64 deviceTemplateId);
+
+    /**
+     * @brief Returns cached template, loading it on first access
+     */
+    std::shared_ptr<const DeviceTemplate> findDeviceTemplate(Poco::Data::Session& session,
+                                                             Poco::UInt64 deviceTemplateId);
+
+    void forgetDeviceTemplate(Poco::UInt64 deviceTemplateId);
+
+    // Hot lookups are built and bound once per session, then re-executed with new parameter values
+    struct PreparedStatements;
+
+    // Session used by find and contains calls, either writer session under m_mutex or one taken from reader pool
+    class ReaderLease;
+
+    struct ReaderSession
+    {
+        std::unique_ptr<Poco::Data::Session> session;
+        std::unique_ptr<PreparedStatements> statements;
+    };
 
     std::recursive_mutex m_mutex;
     std::unique_ptr<Poco::Data::Session> m_session;
+    std::unique_ptr<PreparedStatements> m_statements;
+
+    std::mutex m_readersMutex;
+    std::condition_variable m_readerReleased;
+    std::vector<std::unique_ptr<ReaderSession>> m_idleReaders;
+    bool m_pooledReaders;
+
+    // Templates are stored once per sha256 and shared by devices, so each is deserialized only once
+    Poco::RWLock m_deviceTemplatesLock;
+    std::map<Poco::UInt64, std::shared_ptr<const DeviceTemplate>> m_deviceTemplates;
+    std::map<Poco::UInt64, std::shared_ptr<const DeviceReferences>> m_deviceReferences;
 };
 }    // namespace wolkabout
 
@@ -22,6 +22,9 @@
 #include <Poco/Data/SQLite/SQLiteException.h>
 #include <Poco/Data/Session.h>
 #include <Poco/Data/Statement.h>
+#include <Poco/Nullable.h>
+
+#include <string>
 
 using namespace Poco::Data::Keywords;
 using Poco::Data::Statement;
@@ -33,6 +36,76 @@ const std::string SQLiteFileRepository::ID_COLUMN = "id";
 const std::string SQLiteFileRepository::NAME_COLUMN = "name";
 const std::string SQLiteFileRepository::HASH_COLUMN = "hash";
 const std::string SQLiteFileRepository::PATH_COLUMN = "path";
+const std::string SQLiteFileRepository::LAST_USED_COLUMN = "last_used";
+
+struct SQLiteFileRepository::PreparedStatements
+{
+    explicit PreparedStatements(Poco::Data::Session& session)
+    : count{0}
+    , lastUse{0}
+    , findFileInfo{session}
+    , findFileInfoByHash{session}
+    , countFileInfo{session}
+    , insertFileInfo{session}
+    , touchFileInfo{session}
+    , deleteFileInfo{session}
+    {
+        findFileInfo << "SELECT " << HASH_COLUMN << ", " << PATH_COLUMN << " FROM " << FILE_INFO_TABLE << " WHERE "
+                     << FILE_INFO_TABLE << "." << NAME_COLUMN << "=?;",
+          useRef(findName), into(hash), into(path);
+
+        findFileInfoByHash << "SELECT " << NAME_COLUMN << ", " << PATH_COLUMN << " FROM " << FILE_INFO_TABLE
+                           << " WHERE " << FILE_INFO_TABLE << "." << HASH_COLUMN << "=? LIMIT 1;",
+          useRef(findHash), into(hashName), into(hashPath);
+
+        countFileInfo << "SELECT COUNT(*) FROM " << FILE_INFO_TABLE << " WHERE " << FILE_INFO_TABLE << "."
+                      << NAME_COLUMN << "=?;",
+          useRef(countName), into(count);
+
+        insertFileInfo << "INSERT INTO " << FILE_INFO_TABLE << " (" << NAME_COLUMN << ", " << HASH_COLUMN << ", "
+                       << PATH_COLUMN << ", " << LAST_USED_COLUMN << ")"
+                       << " VALUES(?, ?, ?, ?);",
+          useRef(insertName), useRef(insertHash), useRef(insertPath), useRef(lastUse);
+
+        touchFileInfo << "UPDATE " << FILE_INFO_TABLE << " SET " << LAST_USED_COLUMN << "=? WHERE " << FILE_INFO_TABLE
+                      << "." << NAME_COLUMN << "=?;",
+          useRef(lastUse), useRef(touchName);
+
+        deleteFileInfo << "DELETE FROM " << FILE_INFO_TABLE << " WHERE " << FILE_INFO_TABLE << "." << NAME_COLUMN
+                       << "=?;",
+          useRef(deleteName);
+    }
+
+    // Buffers are declared before statements bound to them, so they outlive the statements
+    std::string findName;
+    std::string hash;
+    std::string path;
+
+    std::string findHash;
+    std::string hashName;
+    std::string hashPath;
+
+    std::string countName;
+    Poco::UInt64 count;
+
+    // files are ordered by use counter instead of time, so order does not depend on clock adjustments
+    Poco::Int64 lastUse;
+
+    std::string insertName;
+    std::string insertHash;
+    std::string insertPath;
+
+    std::string touchName;
+
+    std::string deleteName;
+
+    Statement findFileInfo;
+    Statement findFileInfoByHash;
+    Statement countFileInfo;
+    Statement insertFileInfo;
+    Statement touchFileInfo;
+    Statement deleteFileInfo;
+};
 
 SQLiteFileRepository::SQLiteFileRepository(const std::string& connectionString)
 {
@@ -48,26 +121,44 @@ SQLiteFileRepository::SQLiteFileRepository(const std::string& connectionString)
     statement << "PRAGMA foreign_keys=on;";
 
     statement.execute();
+
+    try
+    {
+        // databases created before files were ordered by use
+        *m_session << "ALTER TABLE " << FILE_INFO_TABLE << " ADD COLUMN " << LAST_USED_COLUMN
+                   << " INTEGER NOT NULL DEFAULT 0;",
+          now;
+    }
+    catch (...)
+    {
+        // column already exists
+    }
+
+    *m_session << "CREATE INDEX IF NOT EXISTS file_info_hash ON " << FILE_INFO_TABLE << "(" << HASH_COLUMN << ");",
+      now;
+
+    m_statements.reset(new PreparedStatements(*m_session));
+
+    Poco::Nullable<Poco::Int64> lastUse;
+    *m_session << "SELECT MAX(" << LAST_USED_COLUMN << ") FROM " << FILE_INFO_TABLE << ";", into(lastUse), now;
+    m_statements->lastUse = lastUse.isNull() ? 0 : lastUse.value();
 }
 
+SQLiteFileRepository::~SQLiteFileRepository() = default;
+
 std::unique_ptr<FileInfo> SQLiteFileRepository::getFileInfo(const std::string& fileName)
 {
     std::lock_guard<decltype(m_mutex)> l(m_mutex);
 
     try
     {
-        std::string hash, path;
-
-        Statement statement(*m_session);
-        statement << "SELECT " << HASH_COLUMN << ", " << PATH_COLUMN << " FROM " << FILE_INFO_TABLE << " WHERE "
-                  << FILE_INFO_TABLE << "." << NAME_COLUMN << "=?;",
-          useRef(fileName), into(hash), into(path);
-        if (statement.execute() == 0)
+        m_statements->findName = fileName;
+        if (m_statements->findFileInfo.execute() == 0)
         {
             return nullptr;
         }
 
-        return std::unique_ptr<FileInfo>(new FileInfo{fileName, hash, path});
+        return std::unique_ptr<FileInfo>(new FileInfo{fileName, m_statements->hash, m_statements->path});
     }
     catch (...)
     {
@@ -107,11 +198,11 @@ void SQLiteFileRepository::store(const FileInfo& info)
 
     try
     {
-        Statement statement(*m_session);
-        statement << "INSERT INTO " << FILE_INFO_TABLE << " (" << NAME_COLUMN << ", " << HASH_COLUMN << ", "
-                  << PATH_COLUMN << ")"
-                  << " VALUES(?, ?, ?);",
-          useRef(info.name), useRef(info.hash), useRef(info.path), now;
+        m_statements->insertName = info.name;
+        m_statements->insertHash = info.hash;
+        m_statements->insertPath = info.path;
+        ++m_statements->lastUse;
+        m_statements->insertFileInfo.execute();
     }
     catch (...)
     {
@@ -119,6 +210,26 @@ void SQLiteFileRepository::store(const FileInfo& info)
     }
 }
 
+void SQLiteFileRepository::storeAll(const std::vector<FileInfo>& infos)
+{
+    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+
+    try
+    {
+        m_session->begin();
+        for (const FileInfo& info : infos)
+        {
+            store(info);
+        }
+        m_session->commit();
+    }
+    catch (...)
+    {
+        rollback();
+        LOG(ERROR) << "SQLiteFileRepository: Error saving info for " << infos.size() << " files";
+    }
+}
+
 void SQLiteFileRepository::remove(const std::string& fileName)
 {
     std::lock_guard<decltype(m_mutex)> l(m_mutex);
@@ -130,9 +241,8 @@ void SQLiteFileRepository::remove(const std::string& fileName)
 
     try
     {
-        Statement statement(*m_session);
-        statement << "DELETE FROM " << FILE_INFO_TABLE << " WHERE " << FILE_INFO_TABLE << "." << NAME_COLUMN << "=?;",
-          useRef(fileName), now;
+        m_statements->deleteName = fileName;
+        m_statements->deleteFileInfo.execute();
     }
     catch (...)
     {
@@ -140,6 +250,26 @@ void SQLiteFileRepository::remove(const std::string& fileName)
     }
 }
 
+void SQLiteFileRepository::removeMany(const std::vector<std::string>& fileNames)
+{
+    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+
+    try
+    {
+        m_session->begin();
+        for (const std::string& fileName : fileNames)
+        {
+            remove(fileName);
+        }
+        m_session->commit();
+    }
+    catch (...)
+    {
+        rollback();
+        LOG(ERROR) << "SQLiteFileRepository: Error removing info for " << fileNames.size() << " files";
+    }
+}
+
 void SQLiteFileRepository::removeAll()
 {
     std::lock_guard<decltype(m_mutex)> l(m_mutex);
@@ -161,13 +291,10 @@ bool SQLiteFileRepository::containsInfoForFile(const std::string& fileName)
 
     try
     {
-        Poco::UInt64 count;
-        Statement statement(*m_session);
-        statement << "SELECT COUNT(*) FROM " << FILE_INFO_TABLE << " WHERE " << FILE_INFO_TABLE << "." << NAME_COLUMN
-                  << "=?;",
-          useRef(fileName), into(count), now;
+        m_statements->countName = fileName;
+        m_statements->countFileInfo.execute();
 
-        return count != 0;
+        return m_statements->count != 0;
     }
     catch (...)
     {
@@ -176,6 +303,64 @@ bool SQLiteFileRepository::containsInfoForFile(const std::string& fileName)
     }
 }
 
+std::unique_ptr<FileInfo> SQLiteFileRepository::getFileInfoByHash(const std::string& hash)
+{
+    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+
+    try
+    {
+        m_statements->findHash = hash;
+        if (m_statements->findFileInfoByHash.execute() == 0)
+        {
+            return nullptr;
+        }
+
+        return std::unique_ptr<FileInfo>(new FileInfo{m_statements->hashName, hash, m_statements->hashPath});
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteFileRepository: Error finding file info for hash " << hash;
+        return nullptr;
+    }
+}
+
+void SQLiteFileRepository::touch(const std::string& fileName)
+{
+    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+
+    try
+    {
+        m_statements->touchName = fileName;
+        ++m_statements->lastUse;
+        m_statements->touchFileInfo.execute();
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteFileRepository: Error updating use of file " << fileName;
+    }
+}
+
+std::unique_ptr<std::vector<std::string>> SQLiteFileRepository::getFileNamesByLastUse()
+{
+    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+
+    auto fileNames = std::unique_ptr<std::vector<std::string>>(new std::vector<std::string>());
+
+    try
+    {
+        Statement statement(*m_session);
+        statement << "SELECT " << NAME_COLUMN << " FROM " << FILE_INFO_TABLE << " ORDER BY " << LAST_USED_COLUMN
+                  << ", " << ID_COLUMN << ";",
+          into(*fileNames), now;
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteFileRepository: Error finding file names";
+    }
+
+    return fileNames;
+}
+
 void SQLiteFileRepository::update(const FileInfo& info)
 {
     std::lock_guard<decltype(m_mutex)> l(m_mutex);
@@ -183,4 +368,19 @@ void SQLiteFileRepository::update(const FileInfo& info)
     remove(info.name);
     store(info);
 }
-}    // namespace wolkabout
\ No newline at end of file
+
+void SQLiteFileRepository::rollback()
+{
+    try
+    {
+        if (m_session->isTransaction())
+        {
+            m_session->rollback();
+        }
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteFileRepository: Error rolling back transaction";
+    }
+}
+}    // namespace wolkabout
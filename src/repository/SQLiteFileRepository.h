@@ -19,7 +19,10 @@
 
 #include "repository/FileRepository.h"
 
+#include <memory>
 #include <mutex>
+#include <string>
+#include <vector>
 
 namespace Poco
 {
@@ -35,28 +38,43 @@ class SQLiteFileRepository : public FileRepository
 {
 public:
     explicit SQLiteFileRepository(const std::string& connectionString);
+    ~SQLiteFileRepository();
 
     std::unique_ptr<FileInfo> getFileInfo(const std::string& fileName) override;
     std::unique_ptr<std::vector<std::string>> getAllFileNames() override;
 
     void store(const FileInfo& info) override;
+    void storeAll(const std::vector<FileInfo>& infos) override;
 
     void remove(const std::string& fileName) override;
+    void removeMany(const std::vector<std::string>& fileNames) override;
     void removeAll() override;
 
     bool containsInfoForFile(const std::string& fileName) override;
 
+    std::unique_ptr<FileInfo> getFileInfoByHash(const std::string& hash) override;
+
+    void touch(const std::string& fileName) override;
+
+    std::unique_ptr<std::vector<std::string>> getFileNamesByLastUse() override;
+
 private:
     void update(const FileInfo& info);
+    void rollback();
 
     std::recursive_mutex m_mutex;
     std::unique_ptr<Poco::Data::Session> m_session;
 
+    // Statements are built and bound once per session, then re-executed with new parameter values
+    struct PreparedStatements;
+    std::unique_ptr<PreparedStatements> m_statements;
+
     static const std::string FILE_INFO_TABLE;
     static const std::string ID_COLUMN;
     static const std::string NAME_COLUMN;
     static const std::string HASH_COLUMN;
     static const std::string PATH_COLUMN;
+    static const std::string LAST_USED_COLUMN;
 };
 }    // namespace wolkabout
 
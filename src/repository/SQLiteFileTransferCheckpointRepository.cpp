@@ -0,0 +1,124 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "repository/SQLiteFileTransferCheckpointRepository.h"
+#include "utilities/Logger.h"
+#include "utilities/StringUtils.h"
+
+#include <Poco/Data/Binding.h>
+#include <Poco/Data/SQLite/Connector.h>
+#include <Poco/Data/SQLite/SQLiteException.h>
+#include <Poco/Data/Session.h>
+#include <Poco/Data/Statement.h>
+
+using namespace Poco::Data::Keywords;
+using Poco::Data::Statement;
+
+namespace wolkabout
+{
+const std::string SQLiteFileTransferCheckpointRepository::FILE_TRANSFER_CHECKPOINT_TABLE = "file_transfer_checkpoint";
+const std::string SQLiteFileTransferCheckpointRepository::NAME_COLUMN = "name";
+const std::string SQLiteFileTransferCheckpointRepository::HASH_COLUMN = "hash";
+const std::string SQLiteFileTransferCheckpointRepository::PACKET_INDEX_COLUMN = "packet_index";
+const std::string SQLiteFileTransferCheckpointRepository::PREVIOUS_PACKET_HASH_COLUMN = "previous_packet_hash";
+const std::string SQLiteFileTransferCheckpointRepository::OFFSET_COLUMN = "offset";
+
+SQLiteFileTransferCheckpointRepository::SQLiteFileTransferCheckpointRepository(const std::string& connectionString)
+{
+    Poco::Data::SQLite::Connector::registerConnector();
+    m_session = std::unique_ptr<Poco::Data::Session>(
+      new Poco::Data::Session(Poco::Data::SQLite::Connector::KEY, connectionString));
+    Statement statement(*m_session);
+
+    statement << "CREATE TABLE IF NOT EXISTS " << FILE_TRANSFER_CHECKPOINT_TABLE << " (" << NAME_COLUMN
+              << " TEXT NOT NULL PRIMARY KEY, " << HASH_COLUMN << " TEXT NOT NULL, " << PACKET_INDEX_COLUMN
+              << " INTEGER NOT NULL, " << PREVIOUS_PACKET_HASH_COLUMN << " TEXT NOT NULL, " << OFFSET_COLUMN
+              << " INTEGER NOT NULL);";
+
+    statement.execute();
+}
+
+std::unique_ptr<FileTransferCheckpoint> SQLiteFileTransferCheckpointRepository::getCheckpoint(
+  const std::string& fileName)
+{
+    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+
+    try
+    {
+        std::string hash, previousPacketHash;
+        Poco::UInt32 packetIndex;
+        Poco::UInt64 offset;
+
+        Statement statement(*m_session);
+        statement << "SELECT " << HASH_COLUMN << ", " << PACKET_INDEX_COLUMN << ", " << PREVIOUS_PACKET_HASH_COLUMN
+                  << ", " << OFFSET_COLUMN << " FROM " << FILE_TRANSFER_CHECKPOINT_TABLE << " WHERE " << NAME_COLUMN
+                  << "=?;",
+          useRef(fileName), into(hash), into(packetIndex), into(previousPacketHash), into(offset);
+        if (statement.execute() == 0)
+        {
+            return nullptr;
+        }
+
+        return std::unique_ptr<FileTransferCheckpoint>(new FileTransferCheckpoint{
+          fileName, ByteUtils::toByteArray(StringUtils::base64Decode(hash)), packetIndex,
+          ByteUtils::toByteArray(StringUtils::base64Decode(previousPacketHash)), offset});
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteFileTransferCheckpointRepository: Error finding checkpoint for file " << fileName;
+        return nullptr;
+    }
+}
+
+void SQLiteFileTransferCheckpointRepository::store(const FileTransferCheckpoint& checkpoint)
+{
+    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+
+    try
+    {
+        const std::string hash = StringUtils::base64Encode(checkpoint.hash);
+        const std::string previousPacketHash = StringUtils::base64Encode(checkpoint.previousPacketHash);
+        const Poco::UInt32 packetIndex = checkpoint.packetIndex;
+        const Poco::UInt64 offset = checkpoint.offset;
+
+        Statement statement(*m_session);
+        statement << "INSERT OR REPLACE INTO " << FILE_TRANSFER_CHECKPOINT_TABLE << " (" << NAME_COLUMN << ", "
+                  << HASH_COLUMN << ", " << PACKET_INDEX_COLUMN << ", " << PREVIOUS_PACKET_HASH_COLUMN << ", "
+                  << OFFSET_COLUMN << ") VALUES(?, ?, ?, ?, ?);",
+          useRef(checkpoint.name), useRef(hash), useRef(packetIndex), useRef(previousPacketHash), useRef(offset), now;
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteFileTransferCheckpointRepository: Error saving checkpoint for file " << checkpoint.name;
+    }
+}
+
+void SQLiteFileTransferCheckpointRepository::remove(const std::string& fileName)
+{
+    std::lock_guard<decltype(m_mutex)> l(m_mutex);
+
+    try
+    {
+        Statement statement(*m_session);
+        statement << "DELETE FROM " << FILE_TRANSFER_CHECKPOINT_TABLE << " WHERE " << NAME_COLUMN << "=?;",
+          useRef(fileName), now;
+    }
+    catch (...)
+    {
+        LOG(ERROR) << "SQLiteFileTransferCheckpointRepository: Error removing checkpoint for file " << fileName;
+    }
+}
+}    // namespace wolkabout
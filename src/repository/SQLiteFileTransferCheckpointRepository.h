@@ -0,0 +1,58 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SQLITEFILETRANSFERCHECKPOINTREPOSITORY_H
+#define SQLITEFILETRANSFERCHECKPOINTREPOSITORY_H
+
+#include "repository/FileTransferCheckpointRepository.h"
+
+#include <mutex>
+
+namespace Poco
+{
+namespace Data
+{
+    class Session;
+}
+}    // namespace Poco
+
+namespace wolkabout
+{
+class SQLiteFileTransferCheckpointRepository : public FileTransferCheckpointRepository
+{
+public:
+    explicit SQLiteFileTransferCheckpointRepository(const std::string& connectionString);
+
+    std::unique_ptr<FileTransferCheckpoint> getCheckpoint(const std::string& fileName) override;
+
+    void store(const FileTransferCheckpoint& checkpoint) override;
+
+    void remove(const std::string& fileName) override;
+
+private:
+    std::mutex m_mutex;
+    std::unique_ptr<Poco::Data::Session> m_session;
+
+    static const std::string FILE_TRANSFER_CHECKPOINT_TABLE;
+    static const std::string NAME_COLUMN;
+    static const std::string HASH_COLUMN;
+    static const std::string PACKET_INDEX_COLUMN;
+    static const std::string PREVIOUS_PACKET_HASH_COLUMN;
+    static const std::string OFFSET_COLUMN;
+};
+}    // namespace wolkabout
+
+#endif    // SQLITEFILETRANSFERCHECKPOINTREPOSITORY_H
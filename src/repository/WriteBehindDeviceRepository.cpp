@@ -0,0 +1,186 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "repository/WriteBehindDeviceRepository.h"
+#include "model/DetailedDevice.h"
+#include "model/DeviceReferences.h"
+#include "repository/SQLiteDeviceRepository.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+
+namespace wolkabout
+{
+WriteBehindDeviceRepository::WriteBehindDeviceRepository(std::unique_ptr<DeviceRepository> repository,
+                                                         std::chrono::milliseconds commitDelay,
+                                                         std::size_t batchSize)
+: m_repository{std::move(repository)}
+, m_queue{[this](const std::vector<std::shared_ptr<const DetailedDevice>>& saved,
+                 const std::vector<std::string>& removed) { commit(saved, removed); },
+          "device_repository", commitDelay, batchSize}
+{
+}
+
+void WriteBehindDeviceRepository::save(const DetailedDevice& device)
+{
+    m_queue.save(device.getKey(), device);
+}
+
+void WriteBehindDeviceRepository::saveAll(const std::vector<DetailedDevice>& devices)
+{
+    for (const DetailedDevice& device : devices)
+    {
+        m_queue.save(device.getKey(), device);
+    }
+}
+
+void WriteBehindDeviceRepository::remove(const std::string& deviceKey)
+{
+    m_queue.remove(deviceKey);
+}
+
+void WriteBehindDeviceRepository::removeMany(const std::vector<std::string>& deviceKeys)
+{
+    for (const std::string& deviceKey : deviceKeys)
+    {
+        m_queue.remove(deviceKey);
+    }
+}
+
+void WriteBehindDeviceRepository::removeAll()
+{
+    m_queue.discard();
+    m_queue.flush();
+
+    m_repository->removeAll();
+}
+
+std::unique_ptr<DetailedDevice> WriteBehindDeviceRepository::findByDeviceKey(const std::string& deviceKey)
+{
+    std::shared_ptr<const DetailedDevice> device;
+    switch (m_queue.find(deviceKey, device))
+    {
+    case WriteBehindQueue<DetailedDevice>::State::SAVED:
+        return std::unique_ptr<DetailedDevice>(new DetailedDevice(*device));
+    case WriteBehindQueue<DetailedDevice>::State::REMOVED:
+        return nullptr;
+    case WriteBehindQueue<DetailedDevice>::State::UNKNOWN:
+        break;
+    }
+
+    return m_repository->findByDeviceKey(deviceKey);
+}
+
+std::unique_ptr<std::vector<std::string>> WriteBehindDeviceRepository::findAllDeviceKeys()
+{
+    // queued keys are read first, a write committed in between then shows up in both and is deduplicated
+    std::vector<std::string> saved;
+    std::vector<std::string> removed;
+    m_queue.keys(saved, removed);
+
+    auto deviceKeys = m_repository->findAllDeviceKeys();
+    if (!deviceKeys)
+    {
+        deviceKeys.reset(new std::vector<std::string>());
+    }
+
+    std::unordered_set<std::string> excluded{removed.begin(), removed.end()};
+    excluded.insert(saved.begin(), saved.end());
+
+    deviceKeys->erase(std::remove_if(deviceKeys->begin(), deviceKeys->end(),
+                                     [&](const std::string& deviceKey) { return excluded.count(deviceKey) != 0; }),
+                      deviceKeys->end());
+    deviceKeys->insert(deviceKeys->end(), saved.begin(), saved.end());
+
+    return deviceKeys;
+}
+
+bool WriteBehindDeviceRepository::containsDeviceWithKey(const std::string& deviceKey)
+{
+    std::shared_ptr<const DetailedDevice> device;
+    switch (m_queue.find(deviceKey, device))
+    {
+    case WriteBehindQueue<DetailedDevice>::State::SAVED:
+        return true;
+    case WriteBehindQueue<DetailedDevice>::State::REMOVED:
+        return false;
+    case WriteBehindQueue<DetailedDevice>::State::UNKNOWN:
+        break;
+    }
+
+    return m_repository->containsDeviceWithKey(deviceKey);
+}
+
+std::shared_ptr<const DeviceReferences> WriteBehindDeviceRepository::findReferencesByDeviceKey(
+  const std::string& deviceKey)
+{
+    std::shared_ptr<const DetailedDevice> device;
+    switch (m_queue.find(deviceKey, device))
+    {
+    case WriteBehindQueue<DetailedDevice>::State::SAVED:
+        return std::make_shared<DeviceReferences>(*device);
+    case WriteBehindQueue<DetailedDevice>::State::REMOVED:
+        return nullptr;
+    case WriteBehindQueue<DetailedDevice>::State::UNKNOWN:
+        break;
+    }
+
+    return m_repository->findReferencesByDeviceKey(deviceKey);
+}
+
+std::string WriteBehindDeviceRepository::findTemplateHash(const std::string& deviceKey)
+{
+    std::shared_ptr<const DetailedDevice> device;
+    switch (m_queue.find(deviceKey, device))
+    {
+    case WriteBehindQueue<DetailedDevice>::State::SAVED:
+        return SQLiteDeviceRepository::calculateSha256(device->getTemplate());
+    case WriteBehindQueue<DetailedDevice>::State::REMOVED:
+        return "";
+    case WriteBehindQueue<DetailedDevice>::State::UNKNOWN:
+        break;
+    }
+
+    return m_repository->findTemplateHash(deviceKey);
+}
+
+void WriteBehindDeviceRepository::flush()
+{
+    m_queue.flush();
+}
+
+void WriteBehindDeviceRepository::commit(const std::vector<std::shared_ptr<const DetailedDevice>>& saved,
+                                         const std::vector<std::string>& removed)
+{
+    if (!saved.empty())
+    {
+        std::vector<DetailedDevice> devices;
+        devices.reserve(saved.size());
+        for (const auto& device : saved)
+        {
+            devices.push_back(*device);
+        }
+
+        m_repository->saveAll(devices);
+    }
+
+    if (!removed.empty())
+    {
+        m_repository->removeMany(removed);
+    }
+}
+}    // namespace wolkabout
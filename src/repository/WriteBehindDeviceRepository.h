@@ -0,0 +1,85 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WRITEBEHINDDEVICEREPOSITORY_H
+#define WRITEBEHINDDEVICEREPOSITORY_H
+
+#include "repository/DeviceRepository.h"
+#include "utilities/WriteBehindQueue.h"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+class DetailedDevice;
+
+/**
+ * @brief Device repository which returns from writes immediately and applies them to another repository later
+ *
+ * Saves and removals are queued and written by a dedicated thread in batched transactions,
+ * so registration does not wait for the database to sync. Lookups see queued writes before they are committed.
+ * removeAll drops queued writes and is applied synchronously.
+ */
+class WriteBehindDeviceRepository : public DeviceRepository
+{
+public:
+    WriteBehindDeviceRepository(
+      std::unique_ptr<DeviceRepository> repository,
+      std::chrono::milliseconds commitDelay =
+        std::chrono::milliseconds{WriteBehindQueue<DetailedDevice>::DEFAULT_COMMIT_DELAY_MS},
+      std::size_t batchSize = WriteBehindQueue<DetailedDevice>::DEFAULT_BATCH_SIZE);
+
+    void save(const DetailedDevice& device) override;
+
+    void saveAll(const std::vector<DetailedDevice>& devices) override;
+
+    void remove(const std::string& deviceKey) override;
+
+    void removeMany(const std::vector<std::string>& deviceKeys) override;
+
+    void removeAll() override;
+
+    std::unique_ptr<DetailedDevice> findByDeviceKey(const std::string& deviceKey) override;
+
+    std::unique_ptr<std::vector<std::string>> findAllDeviceKeys() override;
+
+    bool containsDeviceWithKey(const std::string& deviceKey) override;
+
+    std::shared_ptr<const DeviceReferences> findReferencesByDeviceKey(const std::string& deviceKey) override;
+
+    std::string findTemplateHash(const std::string& deviceKey) override;
+
+    /**
+     * @brief Blocks until all queued writes are committed to wrapped repository
+     */
+    void flush();
+
+private:
+    void commit(const std::vector<std::shared_ptr<const DetailedDevice>>& saved,
+                const std::vector<std::string>& removed);
+
+    std::unique_ptr<DeviceRepository> m_repository;
+
+    // declared last, so queued writes are committed before wrapped repository is destroyed
+    WriteBehindQueue<DetailedDevice> m_queue;
+};
+}    // namespace wolkabout
+
+#endif    // WRITEBEHINDDEVICEREPOSITORY_H
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "repository/WriteBehindFileRepository.h"
+
+#include <algorithm>
+#include <unordered_set>
+#include <utility>
+
+namespace wolkabout
+{
+WriteBehindFileRepository::WriteBehindFileRepository(std::unique_ptr<FileRepository> repository,
+                                                     std::chrono::milliseconds commitDelay, std::size_t batchSize)
+: m_repository{std::move(repository)}
+, m_queue{[this](const std::vector<std::shared_ptr<const FileInfo>>& stored,
+                 const std::vector<std::string>& removed) { commit(stored, removed); },
+          "file_repository", commitDelay, batchSize}
+{
+}
+
+std::unique_ptr<FileInfo> WriteBehindFileRepository::getFileInfo(const std::string& fileName)
+{
+    std::shared_ptr<const FileInfo> info;
+    switch (m_queue.find(fileName, info))
+    {
+    case WriteBehindQueue<FileInfo>::State::SAVED:
+        return std::unique_ptr<FileInfo>(new FileInfo(*info));
+    case WriteBehindQueue<FileInfo>::State::REMOVED:
+        return nullptr;
+    case WriteBehindQueue<FileInfo>::State::UNKNOWN:
+        break;
+    }
+
+    return m_repository->getFileInfo(fileName);
+}
+
+std::unique_ptr<std::vector<std::string>> WriteBehindFileRepository::getAllFileNames()
+{
+    // queued names are read first, a write committed in between then shows up in both and is deduplicated
+    std::vector<std::string> stored;
+    std::vector<std::string> removed;
+    m_queue.keys(stored, removed);
+
+    auto fileNames = m_repository->getAllFileNames();
+    if (!fileNames)
+    {
+        fileNames.reset(new std::vector<std::string>());
+    }
+
+    std::unordered_set<std::string> excluded{removed.begin(), removed.end()};
+    excluded.insert(stored.begin(), stored.end());
+
+    fileNames->erase(std::remove_if(fileNames->begin(), fileNames->end(),
+                                    [&](const std::string& fileName) { return excluded.count(fileName) != 0; }),
+                     fileNames->end());
+    fileNames->insert(fileNames->end(), stored.begin(), stored.end());
+
+    return fileNames;
+}
+
+void WriteBehindFileRepository::store(const FileInfo& info)
+{
+    m_queue.save(info.name, info);
+}
+
+void WriteBehindFileRepository::storeAll(const std::vector<FileInfo>& infos)
+{
+    for (const FileInfo& info : infos)
+    {
+        m_queue.save(info.name, info);
+    }
+}
+
+void WriteBehindFileRepository::remove(const std::string& fileName)
+{
+    m_queue.remove(fileName);
+}
+
+void WriteBehindFileRepository::removeMany(const std::vector<std::string>& fileNames)
+{
+    for (const std::string& fileName : fileNames)
+    {
+        m_queue.remove(fileName);
+    }
+}
+
+void WriteBehindFileRepository::removeAll()
+{
+    m_queue.discard();
+    m_queue.flush();
+
+    m_repository->removeAll();
+}
+
+bool WriteBehindFileRepository::containsInfoForFile(const std::string& fileName)
+{
+    std::shared_ptr<const FileInfo> info;
+    switch (m_queue.find(fileName, info))
+    {
+    case WriteBehindQueue<FileInfo>::State::SAVED:
+        return true;
+    case WriteBehindQueue<FileInfo>::State::REMOVED:
+        return false;
+    case WriteBehindQueue<FileInfo>::State::UNKNOWN:
+        break;
+    }
+
+    return m_repository->containsInfoForFile(fileName);
+}
+
+std::unique_ptr<FileInfo> WriteBehindFileRepository::getFileInfoByHash(const std::string& hash)
+{
+    m_queue.flush();
+
+    return m_repository->getFileInfoByHash(hash);
+}
+
+void WriteBehindFileRepository::touch(const std::string& fileName)
+{
+    // storing marks file as used as well, so touching a file whose store is still queued can be skipped
+    m_repository->touch(fileName);
+}
+
+std::unique_ptr<std::vector<std::string>> WriteBehindFileRepository::getFileNamesByLastUse()
+{
+    m_queue.flush();
+
+    return m_repository->getFileNamesByLastUse();
+}
+
+void WriteBehindFileRepository::flush()
+{
+    m_queue.flush();
+}
+
+void WriteBehindFileRepository::commit(const std::vector<std::shared_ptr<const FileInfo>>& stored,
+                                       const std::vector<std::string>& removed)
+{
+    if (!stored.empty())
+    {
+        std::vector<FileInfo> infos;
+        infos.reserve(stored.size());
+        for (const auto& info : stored)
+        {
+            infos.push_back(*info);
+        }
+
+        m_repository->storeAll(infos);
+    }
+
+    if (!removed.empty())
+    {
+        m_repository->removeMany(removed);
+    }
+}
+}    // namespace wolkabout
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WRITEBEHINDFILEREPOSITORY_H
+#define WRITEBEHINDFILEREPOSITORY_H
+
+#include "repository/FileRepository.h"
+#include "utilities/WriteBehindQueue.h"
+
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief File repository which returns from writes immediately and applies them to another repository later
+ *
+ * Stored and removed file infos are queued and written by a dedicated thread in batched transactions,
+ * so file transfers do not wait for the database to sync. Lookups by name see queued writes before they are
+ * committed, lookups by hash and by last use wait for queued writes first. removeAll drops queued writes
+ * and is applied synchronously.
+ */
+class WriteBehindFileRepository : public FileRepository
+{
+public:
+    WriteBehindFileRepository(
+      std::unique_ptr<FileRepository> repository,
+      std::chrono::milliseconds commitDelay =
+        std::chrono::milliseconds{WriteBehindQueue<FileInfo>::DEFAULT_COMMIT_DELAY_MS},
+      std::size_t batchSize = WriteBehindQueue<FileInfo>::DEFAULT_BATCH_SIZE);
+
+    std::unique_ptr<FileInfo> getFileInfo(const std::string& fileName) override;
+    std::unique_ptr<std::vector<std::string>> getAllFileNames() override;
+
+    void store(const FileInfo& info) override;
+    void storeAll(const std::vector<FileInfo>& infos) override;
+
+    void remove(const std::string& fileName) override;
+    void removeMany(const std::vector<std::string>& fileNames) override;
+    void removeAll() override;
+
+    bool containsInfoForFile(const std::string& fileName) override;
+
+    std::unique_ptr<FileInfo> getFileInfoByHash(const std::string& hash) override;
+
+    void touch(const std::string& fileName) override;
+
+    std::unique_ptr<std::vector<std::string>> getFileNamesByLastUse() override;
+
+    /**
+     * @brief Blocks until all queued writes are committed to wrapped repository
+     */
+    void flush();
+
+private:
+    void commit(const std::vector<std::shared_ptr<const FileInfo>>& stored, const std::vector<std::string>& removed);
+
+    std::unique_ptr<FileRepository> m_repository;
+
+    // declared last, so queued writes are committed before wrapped repository is destroyed
+    WriteBehindQueue<FileInfo> m_queue;
+};
+}    // namespace wolkabout
+
+#endif    // WRITEBEHINDFILEREPOSITORY_H
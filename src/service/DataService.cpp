@@ -20,17 +20,79 @@
 #include "model/ActuatorGetCommand.h"
 #include "model/ActuatorStatus.h"
 #include "model/DetailedDevice.h"
+#include "model/DeviceReferences.h"
 #include "model/Message.h"
 #include "protocol/DataProtocol.h"
 #include "protocol/GatewayDataProtocol.h"
 #include "repository/DeviceRepository.h"
-#include "utilities/Logger.h"
+#include "utilities/GatewayLog.h"
+#include "utilities/MessagePack.h"
+#include "utilities/MessagePool.h"
+#include "utilities/Tracer.h"
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
 
 namespace wolkabout
 {
+namespace
+{
+const char* const WHITESPACE = " \t\r\n";
+
+// a device has a few kinds of platform channels, more prefixes than this are routed without the cache
+const std::size_t MAX_PLATFORM_PREFIXES = 8;
+
+const std::chrono::steady_clock::duration UNREGISTERED_WARNING_INTERVAL = std::chrono::seconds{10};
+
+void appendReadingsElement(std::string& readings, const std::string& content)
+{
+    const auto first = content.find_first_not_of(WHITESPACE);
+    if (first == std::string::npos)
+    {
+        return;
+    }
+
+    const auto last = content.find_last_not_of(WHITESPACE);
+
+    std::string element;
+    if (content[first] == '[' && content[last] == ']')
+    {
+        if (content.find_first_not_of(WHITESPACE, first + 1) == last)
+        {
+            return;
+        }
+
+        element = content.substr(first + 1, last - first - 1);
+    }
+    else if (content[first] == '{' && content.find("\"utc\"") == std::string::npos)
+    {
+        // readings without timestamp would all get the time at which platform received the batch
+        const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::system_clock::now().time_since_epoch())
+                           .count();
+        const bool isEmpty = content[content.find_first_not_of(WHITESPACE, first + 1)] == '}';
+
+        element = "{\"utc\":" + std::to_string(now) + (isEmpty ? "" : ",") + content.substr(first + 1, last - first);
+    }
+    else
+    {
+        element = content.substr(first, last - first + 1);
+    }
+
+    if (!readings.empty())
+    {
+        readings += ',';
+    }
+
+    readings += element;
+}
+}    // namespace
+
 DataService::DataService(const std::string& gatewayKey, DataProtocol& protocol, GatewayDataProtocol& gatewayProtocol,
                          DeviceRepository* deviceRepository, OutboundMessageHandler& outboundPlatformMessageHandler,
                          OutboundMessageHandler& outboundDeviceMessageHandler, MessageListener* gatewayDevice)
@@ -41,12 +103,113 @@ DataService::DataService(const std::string& gatewayKey, DataProtocol& protocol,
 , m_outboundPlatformMessageHandler{outboundPlatformMessageHandler}
 , m_outboundDeviceMessageHandler{outboundDeviceMessageHandler}
 , m_gatewayDevice{gatewayDevice}
+, m_deviceToPlatformMessages{MetricsRegistry::getInstance().counter("wolkgateway_data_device_to_platform_total")}
+, m_platformToDeviceMessages{MetricsRegistry::getInstance().counter("wolkgateway_data_platform_to_device_total")}
+, m_droppedMessages{MetricsRegistry::getInstance().counter("wolkgateway_data_dropped_messages_total")}
+, m_filteredReadings{MetricsRegistry::getInstance().counter("wolkgateway_data_filtered_readings_total")}
+, m_lastUnregisteredWarning{0}
+, m_suppressedUnregisteredWarnings{0}
+, m_transformedReadings{MetricsRegistry::getInstance().counter("wolkgateway_data_transformed_readings_total")}
+, m_windowedReadings{MetricsRegistry::getInstance().counter("wolkgateway_data_windowed_readings_total")}
+, m_aggregationWindow{0}
+, m_aggregationMaxReadings{0}
+, m_executor{nullptr}
+, m_nextBatchGeneration{0}
+, m_actuationInterval{0}
+, m_actuationExecutor{nullptr}
+, m_coalescedActuations{MetricsRegistry::getInstance().counter("wolkgateway_data_coalesced_actuations_total")}
+, m_configurationWindow{0}
+, m_configurationPacing{0}
+, m_configurationExecutor{nullptr}
+, m_coalescedConfigurations{
+    MetricsRegistry::getInstance().counter("wolkgateway_data_coalesced_configurations_total")}
+, m_configurationTask{0}
+, m_deviceStateMaxAge{0}
+, m_deviceStateHits{MetricsRegistry::getInstance().counter("wolkgateway_data_device_state_cache_hits_total")}
+, m_bulkActuatorStatusRequests{false}
+{
+}
+
+DataService::~DataService()
 {
+    // windows closing on executor route into this service
+    m_windowedAggregator.reset();
+
+    std::unordered_map<std::uint64_t, Executor::TaskId> flushTasks;
+
+    {
+        std::lock_guard<std::mutex> lg{m_aggregationLock};
+        flushTasks.swap(m_batchFlushTasks);
+    }
+
+    // flush that is already running is waited for
+    for (const auto& flushTask : flushTasks)
+    {
+        m_executor->cancel(flushTask.second);
+    }
+
+    flushReadings();
+
+    std::vector<std::pair<std::string, Executor::TaskId>> heldActuations;
+
+    {
+        std::lock_guard<std::mutex> lg{m_actuationLock};
+        for (const auto& actuation : m_actuations)
+        {
+            if (actuation.second.held)
+            {
+                heldActuations.emplace_back(actuation.first, actuation.second.task);
+            }
+        }
+    }
+
+    // latest command of each actuator is still delivered
+    for (const auto& actuation : heldActuations)
+    {
+        m_actuationExecutor->cancel(actuation.second);
+        forwardHeldActuation(actuation.first);
+    }
+
+    std::list<HeldConfiguration> heldConfigurations;
+
+    // forward that is running reschedules itself before it finishes, so the task is cancelled until none is left
+    while (true)
+    {
+        Executor::TaskId configurationTask = 0;
+        {
+            std::lock_guard<std::mutex> lg{m_configurationLock};
+            if (m_configurationTask == 0)
+            {
+                m_mergeableConfigurations.clear();
+                heldConfigurations.swap(m_heldConfigurations);
+                break;
+            }
+
+            configurationTask = m_configurationTask;
+        }
+
+        if (m_configurationExecutor->cancel(configurationTask))
+        {
+            std::lock_guard<std::mutex> lg{m_configurationLock};
+            if (m_configurationTask == configurationTask)
+            {
+                m_configurationTask = 0;
+            }
+        }
+    }
+
+    // held requests are delivered without pacing
+    for (const auto& held : heldConfigurations)
+    {
+        m_outboundDeviceMessageHandler.addMessage(held.message);
+        m_platformToDeviceMessages.increment();
+    }
 }
 
 void DataService::platformMessageReceived(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
+    TraceSpan span{"data_service_platform_message"};
 
     const std::string topic = message->getChannel();
 
@@ -55,6 +218,7 @@ void DataService::platformMessageReceived(std::shared_ptr<Message> message)
     if (deviceKey.empty())
     {
         LOG(WARN) << "DataService: Failed to extract device key from channel '" << topic << "'";
+        m_droppedMessages.increment();
         return;
     }
 
@@ -65,77 +229,169 @@ void DataService::platformMessageReceived(std::shared_ptr<Message> message)
     else
     {
         // if message is for device remove gateway info from channel
-        routePlatformToDeviceMessage(message);
+        routePlatformToDeviceMessage(message, deviceKey);
     }
 }
 
 void DataService::deviceMessageReceived(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
+    TraceSpan span{"data_service_device_message"};
 
     const std::string channel = message->getChannel();
+    const DataChannelView channelView = m_gatewayProtocol.parseDeviceChannel(channel);
+    const std::string deviceKey = channelView.getDeviceKey();
 
     if (m_deviceRepository)
     {
-        const std::string deviceKey = m_protocol.extractDeviceKeyFromChannel(channel);
-        const std::unique_ptr<DetailedDevice> device = m_deviceRepository->findByDeviceKey(deviceKey);
-        if (!device)
+        std::shared_ptr<const DeviceReferences> references;
+        {
+            TraceSpan lookup{"device_repository_lookup"};
+            references = m_deviceRepository->findReferencesByDeviceKey(deviceKey);
+        }
+
+        if (!references)
         {
-            LOG(WARN) << "DataService: Not forwarding data message from device with key '" << deviceKey
-                      << "'. Device not registered";
+            const auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+            auto last = m_lastUnregisteredWarning.load();
+            if ((last == 0 || now - last >= UNREGISTERED_WARNING_INTERVAL.count()) &&
+                m_lastUnregisteredWarning.compare_exchange_strong(last, now))
+            {
+                LOG(WARN) << "DataService: Not forwarding data message from device with key '" << deviceKey
+                          << "'. Device not registered. Suppressed " << m_suppressedUnregisteredWarnings.exchange(0)
+                          << " similar warnings";
+            }
+            else
+            {
+                ++m_suppressedUnregisteredWarnings;
+            }
+
+            m_droppedMessages.increment();
             return;
         }
 
-        if (m_gatewayProtocol.isSensorReadingMessage(*message))
+        switch (channelView.getType())
         {
-            const std::string sensorReference = m_protocol.extractReferenceFromChannel(channel);
-            const DeviceTemplate& deviceTemplate = device->getTemplate();
-            if (!deviceTemplate.hasSensorTemplateWithReference(sensorReference))
+        case DataChannelView::Type::SENSOR_READING:
+        {
+            const std::string sensorReference = channelView.getReference();
+            if (!references->hasSensor(sensorReference))
             {
                 LOG(WARN) << "DataService: Not forwarding sensor reading with reference '" << sensorReference
                           << "' from device with key '" << deviceKey
                           << "'. No sensor with given reference in device template";
+                m_droppedMessages.increment();
                 return;
             }
+            break;
         }
-        else if (m_gatewayProtocol.isAlarmMessage(*message))
+        case DataChannelView::Type::ALARM:
         {
-            const std::string alarmReference = m_protocol.extractReferenceFromChannel(channel);
-            const DeviceTemplate& deviceTemplate = device->getTemplate();
-            if (!deviceTemplate.hasAlarmTemplateWithReference(alarmReference))
+            const std::string alarmReference = channelView.getReference();
+            if (!references->hasAlarm(alarmReference))
             {
                 LOG(WARN) << "DataService: Not forwarding alarm with reference '" << alarmReference
                           << "' from device with key '" << deviceKey
                           << "'. No event with given reference in device template";
+                m_droppedMessages.increment();
                 return;
             }
+            break;
         }
-        else if (m_gatewayProtocol.isActuatorStatusMessage(*message))
+        case DataChannelView::Type::ACTUATOR_STATUS:
         {
-            const std::string actuatorReference = m_protocol.extractReferenceFromChannel(channel);
-            const DeviceTemplate& deviceTemplate = device->getTemplate();
-            if (!deviceTemplate.hasActuatorTemplateWithReference(actuatorReference))
+            if (!channelView.hasReference())
+            {
+                // batch of statuses, references are checked once it is split
+                break;
+            }
+
+            const std::string actuatorReference = channelView.getReference();
+            if (!references->hasActuator(actuatorReference))
             {
                 LOG(WARN) << "DataService: Not forwarding actuator status with reference '" << actuatorReference
                           << "' from device with key '" << deviceKey
                           << "'. No actuator with given reference in device template";
+                m_droppedMessages.increment();
                 return;
             }
+            break;
         }
-        else if (m_gatewayProtocol.isConfigurationCurrentMessage(*message))
-        {
-        }
-        else
+        case DataChannelView::Type::CONFIGURATION_CURRENT:
+            break;
+        default:
         {
             assert(false && "DataService: Unsupported message type");
 
             LOG(ERROR) << "DataService: Not forwarding message from device on channel: '" << channel
                        << "'. Unsupported message type";
+            m_droppedMessages.increment();
             return;
         }
+        }
+
+        if (m_deviceActivityListener)
+        {
+            m_deviceActivityListener(deviceKey);
+        }
+
+        if (references->getPayloadEncoding() == DeviceReferences::PayloadEncoding::MESSAGE_PACK)
+        {
+            std::string content;
+            if (!MessagePack::toJson(message->getContent(), content))
+            {
+                LOG(WARN) << "DataService: Not forwarding message from device with key '" << deviceKey
+                          << "'. Invalid MessagePack payload";
+                m_droppedMessages.increment();
+                return;
+            }
+
+            message = MessagePool::make(std::move(content), channel);
+        }
+
+        if (channelView.getType() == DataChannelView::Type::ACTUATOR_STATUS && !channelView.hasReference())
+        {
+            routeActuatorStatusBatch(message, deviceKey, references.get());
+            return;
+        }
+
+        if (m_deadbandFilter && channelView.getType() == DataChannelView::Type::SENSOR_READING)
+        {
+            const std::string sensorReference = channelView.getReference();
+            if (!m_deadbandFilter->accept(deviceKey, sensorReference, references->getSensorRange(sensorReference),
+                                          message->getContent()))
+            {
+                GATEWAY_LOG(DEBUG) << "DataService: Not forwarding sensor reading with reference '" << sensorReference
+                                   << "' from device with key '" << deviceKey << "'. Value within deadband";
+                m_filteredReadings.increment();
+                return;
+            }
+        }
+
+        if (channelView.getType() == DataChannelView::Type::SENSOR_READING &&
+            (m_readingTransformer || m_windowedAggregator))
+        {
+            std::string sensorReference = channelView.getReference();
+            if (m_readingTransformer && !transformReading(deviceKey, sensorReference, message))
+            {
+                return;
+            }
+
+            if (m_windowedAggregator && m_windowedAggregator->accept(deviceKey, sensorReference,
+                                                                     message->getChannel(), message->getContent()))
+            {
+                m_windowedReadings.increment();
+                return;
+            }
+        }
+    }
+    else if (channelView.getType() == DataChannelView::Type::ACTUATOR_STATUS && !channelView.hasReference())
+    {
+        routeActuatorStatusBatch(message, deviceKey, nullptr);
+        return;
     }
 
-    routeDeviceToPlatformMessage(message);
+    routeDeviceToPlatformMessage(message, channelView.getType(), deviceKey);
 }
 
 const Protocol& DataService::getProtocol() const
@@ -158,6 +414,94 @@ void DataService::setGatewayMessageListener(MessageListener* gatewayDevice)
     m_gatewayDevice = gatewayDevice;
 }
 
+void DataService::setReadingAggregation(std::chrono::milliseconds window, std::size_t maxReadings, Executor* executor)
+{
+    assert((window.count() == 0 || executor) && "DataService: Executor is required for aggregation window");
+
+    std::lock_guard<std::mutex> lg{m_aggregationLock};
+    m_aggregationWindow = executor ? window : std::chrono::milliseconds{0};
+    m_aggregationMaxReadings = maxReadings;
+    m_executor = executor;
+}
+
+void DataService::setActuationCoalescing(std::chrono::milliseconds interval, Executor* executor)
+{
+    assert((interval.count() == 0 || executor) && "DataService: Executor is required for actuation coalescing");
+
+    std::lock_guard<std::mutex> lg{m_actuationLock};
+    m_actuationInterval = executor ? interval : std::chrono::milliseconds{0};
+    m_actuationExecutor = executor;
+}
+
+void DataService::setConfigurationCoalescing(std::chrono::milliseconds window, std::chrono::milliseconds pacing,
+                                             Executor* executor)
+{
+    assert(((window.count() == 0 && pacing.count() == 0) || executor) &&
+           "DataService: Executor is required for configuration coalescing");
+
+    std::lock_guard<std::mutex> lg{m_configurationLock};
+    m_configurationWindow = executor ? window : std::chrono::milliseconds{0};
+    m_configurationPacing = executor ? pacing : std::chrono::milliseconds{0};
+    m_configurationExecutor = executor;
+}
+
+void DataService::setDeviceStateCache(std::chrono::milliseconds maxAge)
+{
+    std::lock_guard<std::mutex> lg{m_deviceStatesLock};
+    m_deviceStateMaxAge = maxAge;
+}
+
+void DataService::setBulkActuatorStatusRequests(bool enabled)
+{
+    m_bulkActuatorStatusRequests = enabled;
+}
+
+void DataService::setDeadbandFilter(std::unique_ptr<DeadbandFilter> filter)
+{
+    m_deadbandFilter = std::move(filter);
+}
+
+void DataService::setReadingTransformer(std::unique_ptr<ReadingTransformer> transformer)
+{
+    m_readingTransformer = std::move(transformer);
+}
+
+void DataService::setWindowedAggregator(std::unique_ptr<WindowedAggregator> aggregator)
+{
+    m_windowedAggregator = std::move(aggregator);
+    if (m_windowedAggregator)
+    {
+        m_windowedAggregator->setListener(
+          [this](const std::string& deviceKey, const std::string& channel, const std::string& payload) {
+              routeDeviceToPlatformMessage(MessagePool::make(payload, channel), DataChannelView::Type::SENSOR_READING,
+                                           deviceKey);
+          });
+    }
+}
+
+void DataService::setDeviceActivityListener(std::function<void(const std::string& deviceKey)> listener)
+{
+    m_deviceActivityListener = std::move(listener);
+}
+
+void DataService::flushReadings()
+{
+    // statistics of open windows are routed as readings, so they are collected into batches flushed below
+    if (m_windowedAggregator)
+    {
+        m_windowedAggregator->flush();
+    }
+
+    std::lock_guard<std::mutex> lg{m_aggregationLock};
+
+    for (auto& readingBatch : m_readingBatches)
+    {
+        flushBatch(readingBatch.second);
+    }
+
+    m_readingBatches.clear();
+}
+
 void DataService::requestActuatorStatusesForDevice(const std::string& deviceKey)
 {
     if (!m_deviceRepository)
@@ -165,16 +509,20 @@ void DataService::requestActuatorStatusesForDevice(const std::string& deviceKey)
         return;
     }
 
-    auto device = m_deviceRepository->findByDeviceKey(deviceKey);
+    std::vector<std::string> staleReferences;
+    if (!publishCachedActuatorStatuses(deviceKey, staleReferences))
+    {
+        return;
+    }
 
-    if (!device)
+    if (m_bulkActuatorStatusRequests && staleReferences.size() > 1)
     {
-        LOG(ERROR) << "DeviceStatusService::requestActuatorStatusesForDevice Device not found in repository: "
-                   << deviceKey;
+        std::shared_ptr<Message> message = m_gatewayProtocol.makeMessage(deviceKey, ActuatorGetCommand(""));
+        m_outboundDeviceMessageHandler.addMessage(message);
         return;
     }
 
-    for (const auto& reference : device->getActuatorReferences())
+    for (const auto& reference : staleReferences)
     {
         std::shared_ptr<Message> message = m_gatewayProtocol.makeMessage(deviceKey, ActuatorGetCommand(reference));
         m_outboundDeviceMessageHandler.addMessage(message);
@@ -187,50 +535,703 @@ void DataService::requestActuatorStatusesForAllDevices()
     m_outboundDeviceMessageHandler.addMessage(message);
 }
 
-void DataService::routeDeviceToPlatformMessage(std::shared_ptr<Message> message)
+void DataService::requestActuatorStatusesForDevices(const std::vector<std::string>& deviceKeys)
+{
+    if (!m_bulkActuatorStatusRequests)
+    {
+        for (const auto& deviceKey : deviceKeys)
+        {
+            requestActuatorStatusesForDevice(deviceKey);
+        }
+        return;
+    }
+
+    if (!m_deviceRepository)
+    {
+        return;
+    }
+
+    std::vector<std::string> staleDevices;
+    for (const auto& deviceKey : deviceKeys)
+    {
+        std::vector<std::string> staleReferences;
+        if (publishCachedActuatorStatuses(deviceKey, staleReferences) && !staleReferences.empty())
+        {
+            staleDevices.push_back(deviceKey);
+        }
+    }
+
+    // broadcast would make subdevices with fresh cached statuses reply needlessly
+    if (staleDevices.size() > 1 && staleDevices.size() == deviceKeys.size())
+    {
+        requestActuatorStatusesForAllDevices();
+        return;
+    }
+
+    for (const auto& deviceKey : staleDevices)
+    {
+        std::shared_ptr<Message> message = m_gatewayProtocol.makeMessage(deviceKey, ActuatorGetCommand(""));
+        m_outboundDeviceMessageHandler.addMessage(message);
+    }
+}
+
+bool DataService::publishCachedActuatorStatuses(const std::string& deviceKey, std::vector<std::string>& staleReferences)
+{
+    // references are cached by repository, so device template is not read on every reconnect
+    const auto references = m_deviceRepository->findReferencesByDeviceKey(deviceKey);
+
+    if (!references)
+    {
+        LOG(ERROR) << "DeviceStatusService::requestActuatorStatusesForDevice Device not found in repository: "
+                   << deviceKey;
+        m_droppedMessages.increment();
+        return false;
+    }
+
+    std::vector<std::shared_ptr<Message>> cachedStatuses;
+
+    {
+        std::lock_guard<std::mutex> lg{m_deviceStatesLock};
+
+        const auto now = std::chrono::steady_clock::now();
+        const auto it = m_deviceStates.find(deviceKey);
+        for (const auto& reference : references->getActuators())
+        {
+            if (it != m_deviceStates.end())
+            {
+                const auto status = it->second.actuatorStatuses.find(reference);
+                if (status != it->second.actuatorStatuses.end() && isFresh(status->second, now))
+                {
+                    cachedStatuses.push_back(MessagePool::make(status->second.content, status->second.channel));
+                    continue;
+                }
+            }
+
+            staleReferences.push_back(reference);
+        }
+    }
+
+    for (const auto& message : cachedStatuses)
+    {
+        m_outboundPlatformMessageHandler.addMessage(message);
+        m_deviceStateHits.increment();
+    }
+
+    return true;
+}
+
+void DataService::addDevice(const std::string& deviceKey)
+{
+    auto channels = makeDeviceChannels(deviceKey);
+
+    m_deviceChannels.with(m_deviceChannels.acquire(deviceKey),
+                          [&](std::shared_ptr<const DeviceChannels>& slot) { slot = std::move(channels); });
+}
+
+void DataService::removeDevice(const std::string& deviceKey)
+{
+    {
+        std::lock_guard<std::mutex> lg{m_deviceStatesLock};
+        m_deviceStates.erase(deviceKey);
+    }
+
+
+    m_deviceChannels.release(deviceKey);
+}
+
+std::shared_ptr<const DataService::DeviceChannels> DataService::makeDeviceChannels(const std::string& deviceKey) const
+{
+    std::shared_ptr<DeviceChannels> channels = std::make_shared<DeviceChannels>();
+
+    // subscription channels of device cover every channel type, their device parts are routed once here
+    for (const auto& inboundChannel : m_gatewayProtocol.getInboundChannelsForDevice(deviceKey))
+    {
+        const DataChannelView view = m_gatewayProtocol.parseDeviceChannel(inboundChannel);
+        const auto index = static_cast<std::size_t>(view.getType());
+        if (view.getType() == DataChannelView::Type::UNKNOWN || !view.hasDeviceKey() ||
+            index >= channels->prefixes.size())
+        {
+            continue;
+        }
+
+        ChannelPrefix& prefix = channels->prefixes[index];
+        prefix.local = inboundChannel.substr(0, view.getDeviceKeyEnd());
+        prefix.platform = m_gatewayProtocol.routeDeviceToPlatformMessage(prefix.local, m_gatewayKey);
+        if (prefix.platform.empty())
+        {
+            prefix.local.clear();
+        }
+    }
+
+    return channels;
+}
+
+std::string DataService::routeDeviceChannel(const std::string& channel, DataChannelView::Type type,
+                                            const std::string& deviceKey)
+{
+    std::shared_ptr<const DeviceChannels> channels;
+    m_deviceChannels.with(deviceKey, [&](std::shared_ptr<const DeviceChannels>& slot) { channels = slot; });
+
+    // only devices validated against repository are remembered, so unknown keys can not grow the table
+    if (!channels && m_deviceRepository && !deviceKey.empty())
+    {
+        channels = makeDeviceChannels(deviceKey);
+
+        // channels stored meanwhile may already hold learned platform prefixes, so they are kept
+        m_deviceChannels.with(m_deviceChannels.acquire(deviceKey), [&](std::shared_ptr<const DeviceChannels>& slot) {
+            if (slot)
+            {
+                channels = slot;
+            }
+            else
+            {
+                slot = channels;
+            }
+        });
+    }
+
+    const auto index = static_cast<std::size_t>(type);
+    if (!channels || index >= channels->prefixes.size())
+    {
+        return m_gatewayProtocol.routeDeviceToPlatformMessage(channel, m_gatewayKey);
+    }
+
+    // channel was parsed to this device key, so it continues with a delimiter or ends right after the prefix
+    const ChannelPrefix& prefix = channels->prefixes[index];
+    if (prefix.local.empty() || channel.compare(0, prefix.local.size(), prefix.local) != 0)
+    {
+        return m_gatewayProtocol.routeDeviceToPlatformMessage(channel, m_gatewayKey);
+    }
+
+    std::string routedChannel;
+    routedChannel.reserve(prefix.platform.size() + channel.size() - prefix.local.size());
+    routedChannel.append(prefix.platform).append(channel, prefix.local.size(), std::string::npos);
+
+    return routedChannel;
+}
+
+std::string DataService::routePlatformChannel(const std::string& channel, const std::string& deviceKey)
 {
-    LOG(TRACE) << METHOD_INFO;
+    std::shared_ptr<const DeviceChannels> channels;
+    m_deviceChannels.with(deviceKey, [&](std::shared_ptr<const DeviceChannels>& slot) { channels = slot; });
+
+    if (channels)
+    {
+        for (const ChannelPrefix& prefix : channels->platformPrefixes)
+        {
+            if (channel.compare(0, prefix.platform.size(), prefix.platform) == 0 &&
+                (channel.size() == prefix.platform.size() || channel[prefix.platform.size()] == '/'))
+            {
+                std::string routedChannel;
+                routedChannel.reserve(prefix.local.size() + channel.size() - prefix.platform.size());
+                routedChannel.append(prefix.local).append(channel, prefix.platform.size(), std::string::npos);
 
-    const std::string channel = m_gatewayProtocol.routeDeviceToPlatformMessage(message->getChannel(), m_gatewayKey);
+                return routedChannel;
+            }
+        }
+    }
+
+    std::string routedChannel = m_gatewayProtocol.routePlatformToDeviceMessage(channel, m_gatewayKey);
+
+    // platform may address any key, so only devices already in the table learn prefixes
+    if (channels && !routedChannel.empty())
+    {
+        learnPlatformPrefix(channel, routedChannel, deviceKey);
+    }
+
+    return routedChannel;
+}
+
+void DataService::learnPlatformPrefix(const std::string& channel, const std::string& routedChannel,
+                                      const std::string& deviceKey)
+{
+    // routing removes gateway part from channel, everything after it is left as it is
+    if (routedChannel.size() >= channel.size() || deviceKey.empty())
+    {
+        return;
+    }
+
+    const auto removedLength = channel.size() - routedChannel.size();
+    const auto removedAt = static_cast<std::size_t>(
+      std::mismatch(routedChannel.begin(), routedChannel.end(), channel.begin()).first - routedChannel.begin());
+
+    const auto keyPosition = channel.find(deviceKey, removedAt + removedLength);
+    const auto keyEnd = keyPosition + deviceKey.size();
+    if (keyPosition == std::string::npos || (keyEnd != channel.size() && channel[keyEnd] != '/') ||
+        channel.compare(removedAt + removedLength, std::string::npos, routedChannel, removedAt, std::string::npos) != 0)
+    {
+        return;
+    }
+
+    ChannelPrefix prefix;
+    prefix.platform = channel.substr(0, keyEnd);
+    prefix.local = routedChannel.substr(0, keyEnd - removedLength);
+
+    m_deviceChannels.with(deviceKey, [&](std::shared_ptr<const DeviceChannels>& slot) {
+        if (!slot || slot->platformPrefixes.size() >= MAX_PLATFORM_PREFIXES)
+        {
+            return;
+        }
+
+        for (const ChannelPrefix& known : slot->platformPrefixes)
+        {
+            if (known.platform == prefix.platform)
+            {
+                return;
+            }
+        }
+
+        // readers hold on to previous channels, so they are copied instead of modified
+        auto channels = std::make_shared<DeviceChannels>(*slot);
+        channels->platformPrefixes.push_back(std::move(prefix));
+        slot = std::move(channels);
+    });
+}
+
+bool DataService::transformReading(const std::string& deviceKey, std::string& reference,
+                                   std::shared_ptr<Message>& message)
+{
+    const std::string sensorReference = reference;
+    std::string content;
+    switch (m_readingTransformer->transform(deviceKey, reference, message->getContent(), content))
+    {
+    case ReadingTransformer::Result::UNCHANGED:
+        break;
+    case ReadingTransformer::Result::DROPPED:
+        GATEWAY_LOG(DEBUG) << "DataService: Not forwarding sensor reading with reference '" << sensorReference
+                           << "' from device with key '" << deviceKey << "'. Dropped by transformation rule";
+        m_filteredReadings.increment();
+        return false;
+    case ReadingTransformer::Result::TRANSFORMED:
+    {
+        // reference is the last level of sensor reading channel
+        const std::string& channel = message->getChannel();
+        message = MessagePool::make(std::move(content),
+                                    channel.substr(0, channel.size() - sensorReference.size()) + reference);
+        m_transformedReadings.increment();
+        break;
+    }
+    }
+
+    return true;
+}
+
+void DataService::routeDeviceToPlatformMessage(std::shared_ptr<Message> message, DataChannelView::Type type,
+                                               const std::string& deviceKey)
+{
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
+
+    std::string channel = routeDeviceChannel(message->getChannel(), type, deviceKey);
     if (channel.empty())
     {
         LOG(WARN) << "Failed to route device message: " << message->getChannel();
+        m_droppedMessages.increment();
         return;
     }
 
-    const std::shared_ptr<Message> routedMessage{new Message(message->getContent(), channel)};
+    if (isAggregationEnabled())
+    {
+        if (type == DataChannelView::Type::SENSOR_READING)
+        {
+            aggregateReading(deviceKey, channel, message->getContent());
+            m_deviceToPlatformMessages.increment();
+            return;
+        }
+
+        if (type == DataChannelView::Type::ALARM)
+        {
+            // readings collected before alarm must not arrive after it
+            std::lock_guard<std::mutex> lg{m_aggregationLock};
+            auto it = m_readingBatches.find(deviceKey);
+            if (it != m_readingBatches.end())
+            {
+                flushBatch(it->second);
+                m_readingBatches.erase(it);
+            }
+        }
+    }
+
+    if (type == DataChannelView::Type::ACTUATOR_STATUS || type == DataChannelView::Type::CONFIGURATION_CURRENT)
+    {
+        cacheDeviceState(deviceKey, type, message->getChannel(), channel, message->getContent());
+    }
+
+    const auto routedMessage = MessagePool::make(message->getContent(), std::move(channel));
     m_outboundPlatformMessageHandler.addMessage(routedMessage);
+    m_deviceToPlatformMessages.increment();
 }
 
-void DataService::routePlatformToDeviceMessage(std::shared_ptr<Message> message)
+void DataService::routeActuatorStatusBatch(std::shared_ptr<Message> message, const std::string& deviceKey,
+                                           const DeviceReferences* references)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
+
+    auto statuses = m_gatewayProtocol.splitActuatorStatusBatch(message->getChannel(), message->getContent());
+    if (statuses.empty())
+    {
+        LOG(WARN) << "DataService: Not forwarding actuator status batch from device with key '" << deviceKey
+                  << "'. Invalid batch";
+        m_droppedMessages.increment();
+        return;
+    }
 
-    const std::string channel = m_gatewayProtocol.routePlatformToDeviceMessage(message->getChannel(), m_gatewayKey);
+    for (auto& status : statuses)
+    {
+        if (references)
+        {
+            const std::string actuatorReference = m_gatewayProtocol.extractReferenceFromChannel(status->getChannel());
+            if (!references->hasActuator(actuatorReference))
+            {
+                LOG(WARN) << "DataService: Not forwarding actuator status with reference '" << actuatorReference
+                          << "' from device with key '" << deviceKey
+                          << "'. No actuator with given reference in device template";
+                m_droppedMessages.increment();
+                continue;
+            }
+        }
+
+        routeDeviceToPlatformMessage(std::shared_ptr<Message>(std::move(status)),
+                                     DataChannelView::Type::ACTUATOR_STATUS, deviceKey);
+    }
+}
+
+void DataService::routePlatformToDeviceMessage(std::shared_ptr<Message> message, const std::string& deviceKey)
+{
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
+
+    std::string channel = routePlatformChannel(message->getChannel(), deviceKey);
     if (channel.empty())
     {
         LOG(WARN) << "Failed to route platform message: " << message->getChannel();
+        m_droppedMessages.increment();
+        return;
+    }
+
+    if (replyFromDeviceState(*message, deviceKey))
+    {
+        return;
+    }
+
+    const auto routedMessage = MessagePool::make(message->getContent(), std::move(channel));
+    if (m_actuationInterval.count() > 0 && m_protocol.isActuatorSetMessage(*message))
+    {
+        coalesceActuation(routedMessage);
+        return;
+    }
+
+    if ((m_configurationWindow.count() > 0 || m_configurationPacing.count() > 0) &&
+        m_protocol.isConfigurationSetMessage(*message))
+    {
+        coalesceConfiguration(routedMessage);
         return;
     }
 
-    const std::shared_ptr<Message> routedMessage{new Message(message->getContent(), channel)};
     m_outboundDeviceMessageHandler.addMessage(routedMessage);
+    m_platformToDeviceMessages.increment();
+}
+
+void DataService::coalesceActuation(std::shared_ptr<Message> message)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    {
+        std::lock_guard<std::mutex> lg{m_actuationLock};
+
+        auto it = m_actuations.find(message->getChannel());
+        if (it != m_actuations.end())
+        {
+            ActuationState& state = it->second;
+            if (state.held)
+            {
+                // latest value wins, command held so far is never forwarded
+                state.held = message;
+                m_coalescedActuations.increment();
+                return;
+            }
+
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - state.forwardedAt);
+            if (elapsed < m_actuationInterval)
+            {
+                const std::string channel = message->getChannel();
+                state.held = message;
+                state.task = m_actuationExecutor->schedule(m_actuationInterval - elapsed,
+                                                           [=] { forwardHeldActuation(channel); });
+                return;
+            }
+
+            state.forwardedAt = now;
+        }
+        else
+        {
+            m_actuations.emplace(message->getChannel(), ActuationState{now, nullptr, 0});
+        }
+    }
+
+    m_outboundDeviceMessageHandler.addMessage(message);
+    m_platformToDeviceMessages.increment();
+}
+
+void DataService::forwardHeldActuation(const std::string& channel)
+{
+    std::shared_ptr<Message> message;
+
+    {
+        std::lock_guard<std::mutex> lg{m_actuationLock};
+
+        auto it = m_actuations.find(channel);
+        if (it == m_actuations.end() || !it->second.held)
+        {
+            return;
+        }
+
+        message = std::move(it->second.held);
+        it->second.held = nullptr;
+        it->second.task = 0;
+        it->second.forwardedAt = std::chrono::steady_clock::now();
+    }
+
+    m_outboundDeviceMessageHandler.addMessage(message);
+    m_platformToDeviceMessages.increment();
+}
+
+void DataService::coalesceConfiguration(std::shared_ptr<Message> message)
+{
+    const auto now = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lg{m_configurationLock};
+
+    auto it = m_mergeableConfigurations.find(message->getChannel());
+    if (it != m_mergeableConfigurations.end())
+    {
+        HeldConfiguration& held = *it->second;
+        std::string merged =
+          m_gatewayProtocol.mergeConfigurationSet(held.message->getContent(), message->getContent());
+        if (!merged.empty())
+        {
+            held.message = MessagePool::make(std::move(merged), held.channel);
+            m_coalescedConfigurations.increment();
+            return;
+        }
+
+        // request that can not be merged is forwarded as it is, after the one held so far
+        GATEWAY_LOG(DEBUG) << "DataService: Unable to merge configuration set request on '" << message->getChannel()
+                           << "'";
+    }
+
+    const std::string channel = message->getChannel();
+    m_heldConfigurations.push_back(HeldConfiguration{channel, std::move(message), now + m_configurationWindow});
+    m_mergeableConfigurations[channel] = std::prev(m_heldConfigurations.end());
+
+    scheduleConfigurationForward(now);
+}
+
+void DataService::scheduleConfigurationForward(std::chrono::steady_clock::time_point now)
+{
+    if (m_configurationTask != 0 || m_heldConfigurations.empty())
+    {
+        return;
+    }
+
+    const auto forwardAt =
+      std::max(m_heldConfigurations.front().dueAt, m_configurationForwardedAt + m_configurationPacing);
+    const auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(forwardAt - now);
+
+    m_configurationTask = m_configurationExecutor->schedule(std::max(delay, std::chrono::milliseconds{0}),
+                                                            [=] { forwardHeldConfiguration(); });
+}
+
+void DataService::forwardHeldConfiguration()
+{
+    std::shared_ptr<Message> message;
+
+    {
+        std::lock_guard<std::mutex> lg{m_configurationLock};
+
+        if (!m_heldConfigurations.empty())
+        {
+            HeldConfiguration& held = m_heldConfigurations.front();
+
+            auto it = m_mergeableConfigurations.find(held.channel);
+            if (it != m_mergeableConfigurations.end() && it->second == m_heldConfigurations.begin())
+            {
+                m_mergeableConfigurations.erase(it);
+            }
+
+            message = std::move(held.message);
+            m_heldConfigurations.pop_front();
+        }
+    }
+
+    if (message)
+    {
+        m_outboundDeviceMessageHandler.addMessage(message);
+        m_platformToDeviceMessages.increment();
+    }
+
+    // task stays set until it is done, so nothing else schedules a forward meanwhile
+    std::lock_guard<std::mutex> lg{m_configurationLock};
+
+    const auto now = std::chrono::steady_clock::now();
+    m_configurationForwardedAt = now;
+    m_configurationTask = 0;
+    scheduleConfigurationForward(now);
+}
+
+void DataService::cacheDeviceState(const std::string& deviceKey, DataChannelView::Type type,
+                                   const std::string& channel, const std::string& routedChannel,
+                                   const std::string& content)
+{
+    std::lock_guard<std::mutex> lg{m_deviceStatesLock};
+
+    if (m_deviceStateMaxAge.count() == 0)
+    {
+        return;
+    }
+
+    DeviceState& state = m_deviceStates[deviceKey];
+    CachedState& cached = type == DataChannelView::Type::ACTUATOR_STATUS ?
+                            state.actuatorStatuses[m_gatewayProtocol.extractReferenceFromChannel(channel)] :
+                            state.configuration;
+
+    cached.channel = routedChannel;
+    cached.content = content;
+    cached.receivedAt = std::chrono::steady_clock::now();
+}
+
+bool DataService::replyFromDeviceState(const Message& request, const std::string& deviceKey)
+{
+    const bool isActuatorGet = m_protocol.isActuatorGetMessage(request);
+    if (!isActuatorGet && !m_protocol.isConfigurationGetMessage(request))
+    {
+        return false;
+    }
+
+    std::shared_ptr<Message> reply;
+
+    {
+        std::lock_guard<std::mutex> lg{m_deviceStatesLock};
+
+        auto it = m_deviceStates.find(deviceKey);
+        if (it == m_deviceStates.end())
+        {
+            return false;
+        }
+
+        const CachedState* cached = &it->second.configuration;
+        if (isActuatorGet)
+        {
+            const auto reference = m_gatewayProtocol.extractReferenceFromChannel(request.getChannel());
+            auto status = it->second.actuatorStatuses.find(reference);
+            cached = status != it->second.actuatorStatuses.end() ? &status->second : nullptr;
+        }
+
+        if (!cached || !isFresh(*cached, std::chrono::steady_clock::now()))
+        {
+            return false;
+        }
+
+        reply = MessagePool::make(cached->content, cached->channel);
+    }
+
+    GATEWAY_LOG(DEBUG) << "DataService: Answering " << request.getChannel() << " from device state cache";
+    m_outboundPlatformMessageHandler.addMessage(reply);
+    m_deviceStateHits.increment();
+    return true;
+}
+
+bool DataService::isFresh(const CachedState& state, std::chrono::steady_clock::time_point now) const
+{
+    return !state.channel.empty() && m_deviceStateMaxAge.count() > 0 && now - state.receivedAt < m_deviceStateMaxAge;
 }
 
 void DataService::routeGatewayToPlatformMessage(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     m_outboundPlatformMessageHandler.addMessage(message);
 }
 
 void DataService::routePlatformToGatewayMessage(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (m_gatewayDevice)
     {
         m_gatewayDevice->messageReceived(message);
     }
 }
+
+bool DataService::isAggregationEnabled() const
+{
+    return m_aggregationWindow.count() > 0 || m_aggregationMaxReadings > 0;
+}
+
+void DataService::aggregateReading(const std::string& deviceKey, const std::string& channel,
+                                   const std::string& content)
+{
+    const ChannelInterner::ChannelId channelId = m_channelInterner.intern(channel);
+
+    std::lock_guard<std::mutex> lg{m_aggregationLock};
+
+    auto it = m_readingBatches.find(deviceKey);
+    if (it == m_readingBatches.end())
+    {
+        ReadingBatch batch;
+        batch.count = 0;
+        batch.generation = m_nextBatchGeneration++;
+
+        it = m_readingBatches.emplace(deviceKey, std::move(batch)).first;
+
+        if (m_aggregationWindow.count() > 0)
+        {
+            const std::uint64_t generation = it->second.generation;
+            m_batchFlushTasks[generation] = m_executor->schedule(
+              m_aggregationWindow, [=] { flushExpiredBatch(deviceKey, generation); });
+        }
+    }
+
+    ReadingBatch& batch = it->second;
+    std::string& readings = batch.readings[channelId];
+    appendReadingsElement(readings, content);
+    ++batch.count;
+
+    if (m_aggregationMaxReadings > 0 && batch.count >= m_aggregationMaxReadings)
+    {
+        flushBatch(batch);
+        m_readingBatches.erase(it);
+    }
+}
+
+void DataService::flushExpiredBatch(const std::string& deviceKey, std::uint64_t generation)
+{
+    std::lock_guard<std::mutex> lg{m_aggregationLock};
+    m_batchFlushTasks.erase(generation);
+
+    // batch may have been published and replaced by a newer one in the meantime
+    auto it = m_readingBatches.find(deviceKey);
+    if (it == m_readingBatches.end() || it->second.generation != generation)
+    {
+        return;
+    }
+
+    flushBatch(it->second);
+    m_readingBatches.erase(it);
+}
+
+void DataService::flushBatch(ReadingBatch& batch)
+{
+    for (auto& readings : batch.readings)
+    {
+        if (readings.second.empty())
+        {
+            continue;
+        }
+
+        const auto message = MessagePool::make("[" + readings.second + "]", m_channelInterner.channel(readings.first));
+        m_outboundPlatformMessageHandler.addMessage(message);
+    }
+
+    batch.readings.clear();
+    batch.count = 0;
+}
 }    // namespace wolkabout
@@ -21,14 +21,33 @@
 #include "InboundDeviceMessageHandler.h"
 #include "InboundPlatformMessageHandler.h"
 #include "OutboundMessageHandler.h"
+#include "protocol/DataChannelView.h"
+#include "service/DeadbandFilter.h"
+#include "service/ReadingTransformer.h"
+#include "service/WindowedAggregator.h"
+#include "utilities/ChannelInterner.h"
+#include "utilities/DeviceRegistry.h"
+#include "utilities/Executor.h"
+#include "utilities/Metrics.h"
 
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace wolkabout
 {
 class DataProtocol;
+class DeviceReferences;
 class DeviceRepository;
 class GatewayDataProtocol;
 class MessageListener;
@@ -40,6 +59,8 @@ public:
                 DeviceRepository* deviceRepository, OutboundMessageHandler& outboundPlatformMessageHandler,
                 OutboundMessageHandler& outboundDeviceMessageHandler, MessageListener* gatewayDevice = nullptr);
 
+    ~DataService();
+
     void platformMessageReceived(std::shared_ptr<Message> message) override;
 
     void deviceMessageReceived(std::shared_ptr<Message> message) override;
@@ -52,16 +73,176 @@ public:
 
     void setGatewayMessageListener(MessageListener* gatewayDevice);
 
+    /**
+     * @brief Enables coalescing of device sensor readings into multi-reading platform messages
+     *
+     * Readings are collected per device and published, one message per reference, once window elapses
+     * or maxReadings readings are collected, whichever comes first. Alarm from device publishes readings
+     * collected for that device before the alarm itself. Must be called before messages are received.
+     * @param window Time after first collected reading at which device readings are published, 0 for no limit
+     * @param maxReadings Number of collected readings at which device readings are published, 0 for no limit
+     * @param executor Executor on which window expiry is handled, required if window is set
+     */
+    void setReadingAggregation(std::chrono::milliseconds window, std::size_t maxReadings, Executor* executor);
+
+    /**
+     * @brief Sets filter which drops sensor readings of subdevices that did not change enough
+     * Must be called before messages are received.
+     * @param filter Filter to use, nullptr disables filtering
+     */
+    void setDeadbandFilter(std::unique_ptr<DeadbandFilter> filter);
+
+    /**
+     * @brief Sets transformer which rescales, renames or drops sensor readings of subdevices
+     * Readings are transformed after validation and deadband filtering, before they are routed to platform.
+     * Must be called before messages are received.
+     * @param transformer Transformer to use, nullptr disables transformation
+     */
+    void setReadingTransformer(std::unique_ptr<ReadingTransformer> transformer);
+
+    /**
+     * @brief Sets aggregator which replaces sensor readings of subdevices with their statistics over time window
+     * Readings are aggregated after transformation, and statistics are routed to platform like received readings.
+     * Must be called before messages are received.
+     * @param aggregator Aggregator to use, nullptr disables windowed aggregation
+     */
+    void setWindowedAggregator(std::unique_ptr<WindowedAggregator> aggregator);
+
+    /**
+     * @brief Limits rate at which actuator set commands are forwarded to each subdevice actuator
+     *
+     * First command for an actuator is forwarded right away, commands arriving within interval after it
+     * replace each other and only the latest one is forwarded once interval elapses.
+     * Must be called before messages are received.
+     * @param interval Minimum time between commands forwarded to the same actuator, 0 forwards every command
+     * @param executor Executor on which held back commands are forwarded, required if interval is set
+     */
+    void setActuationCoalescing(std::chrono::milliseconds interval, Executor* executor);
+
+    /**
+     * @brief Merges configuration set requests for each subdevice and paces their delivery across subdevices
+     *
+     * Requests for a device are held for window after the first one, and requests arriving meanwhile are merged
+     * into it, later values replacing earlier ones, so device applies configuration once.
+     * Held requests are forwarded in order of arrival, at most one per pacing interval.
+     * Must be called before messages are received.
+     * @param window Time for which requests for a device are merged, 0 merges only while request waits for pacing
+     * @param pacing Minimum time between configuration set requests forwarded to subdevices, 0 for no limit
+     * @param executor Executor on which held requests are forwarded, required if window or pacing is set
+     */
+    void setConfigurationCoalescing(std::chrono::milliseconds window, std::chrono::milliseconds pacing,
+                                    Executor* executor);
+
+    /**
+     * @brief Keeps last actuator statuses and configuration each subdevice published
+     *
+     * Actuator status and configuration requests, from platform or on reconnect, are answered from statuses
+     * received within maxAge, and only actuators without such status are queried.
+     * Must be called before messages are received.
+     * @param maxAge Time for which received status is served from cache, 0 disables cache
+     */
+    void setDeviceStateCache(std::chrono::milliseconds maxAge);
+
+    /**
+     * @brief Requests statuses of all actuators of subdevice with one actuator get request without reference
+     *
+     * Subdevices are then expected to reply with one batch of statuses on actuator status channel without reference,
+     * which is split into one platform message per actuator. Requests for several subdevices are sent as one
+     * broadcast when none of them has fresh statuses in device state cache.
+     * Must be called before messages are received.
+     * @param enabled true to request statuses in bulk, false to request each actuator separately
+     */
+    void setBulkActuatorStatusRequests(bool enabled);
+
+    /**
+     * @brief Sets listener notified with key of registered subdevice whenever valid data message arrives from it
+     * Must be called before messages are received.
+     * @param listener Listener to notify
+     */
+    void setDeviceActivityListener(std::function<void(const std::string& deviceKey)> listener);
+
+    /**
+     * @brief Publishes all collected sensor readings, and statistics of open aggregation windows
+     */
+    void flushReadings();
+
+    /**
+     * @brief Precomputes local and platform channel prefixes of registered subdevice
+     * Prefixes are reused for every message routed from subdevice to platform
+     * @param deviceKey Key of registered subdevice
+     */
+    void addDevice(const std::string& deviceKey);
+
+    /**
+     * @brief Forgets channel prefixes of deleted subdevice
+     * @param deviceKey Key of deleted subdevice
+     */
+    void removeDevice(const std::string& deviceKey);
+
     virtual void requestActuatorStatusesForDevice(const std::string& deviceKey);
     virtual void requestActuatorStatusesForAllDevices();
+    virtual void requestActuatorStatusesForDevices(const std::vector<std::string>& deviceKeys);
 
 private:
-    void routeDeviceToPlatformMessage(std::shared_ptr<Message> message);
-    void routePlatformToDeviceMessage(std::shared_ptr<Message> message);
+    bool transformReading(const std::string& deviceKey, std::string& reference, std::shared_ptr<Message>& message);
+
+    void routeDeviceToPlatformMessage(std::shared_ptr<Message> message, DataChannelView::Type type,
+                                      const std::string& deviceKey);
+    void routePlatformToDeviceMessage(std::shared_ptr<Message> message, const std::string& deviceKey);
+    void routeActuatorStatusBatch(std::shared_ptr<Message> message, const std::string& deviceKey,
+                                  const DeviceReferences* references);
+    void coalesceActuation(std::shared_ptr<Message> message);
+    void forwardHeldActuation(const std::string& channel);
+    void coalesceConfiguration(std::shared_ptr<Message> message);
+    void scheduleConfigurationForward(std::chrono::steady_clock::time_point now);
+    void forwardHeldConfiguration();
+
+    void cacheDeviceState(const std::string& deviceKey, DataChannelView::Type type, const std::string& channel,
+                          const std::string& routedChannel, const std::string& content);
+    bool replyFromDeviceState(const Message& request, const std::string& deviceKey);
+    bool publishCachedActuatorStatuses(const std::string& deviceKey, std::vector<std::string>& staleReferences);
 
     void routeGatewayToPlatformMessage(std::shared_ptr<Message> message);
     void routePlatformToGatewayMessage(std::shared_ptr<Message> message);
 
+    struct ChannelPrefix
+    {
+        // channel of subdevice up to and including device key, and the same part of channel routed to platform
+        std::string local;
+        std::string platform;
+    };
+
+    struct DeviceChannels
+    {
+        // indexed by DataChannelView::Type
+        std::array<ChannelPrefix, 5> prefixes;
+
+        // platform channels of device, here local is the same part of channel routed to device.
+        // They are learned from the first message of each kind, as platform channels are not known up front
+        std::vector<ChannelPrefix> platformPrefixes;
+    };
+
+    std::shared_ptr<const DeviceChannels> makeDeviceChannels(const std::string& deviceKey) const;
+    std::string routeDeviceChannel(const std::string& channel, DataChannelView::Type type,
+                                   const std::string& deviceKey);
+    std::string routePlatformChannel(const std::string& channel, const std::string& deviceKey);
+    void learnPlatformPrefix(const std::string& channel, const std::string& routedChannel,
+                             const std::string& deviceKey);
+
+    struct ReadingBatch
+    {
+        // interned routed channel to comma separated readings
+        std::map<ChannelInterner::ChannelId, std::string> readings;
+        std::size_t count;
+        std::uint64_t generation;
+    };
+
+    bool isAggregationEnabled() const;
+
+    void aggregateReading(const std::string& deviceKey, const std::string& channel, const std::string& content);
+    void flushExpiredBatch(const std::string& deviceKey, std::uint64_t generation);
+    void flushBatch(ReadingBatch& batch);
+
     const std::string m_gatewayKey;
     DataProtocol& m_protocol;
     GatewayDataProtocol& m_gatewayProtocol;
@@ -72,6 +253,97 @@ private:
     OutboundMessageHandler& m_outboundDeviceMessageHandler;
 
     MessageListener* m_gatewayDevice;
+
+    Counter& m_deviceToPlatformMessages;
+    Counter& m_platformToDeviceMessages;
+    Counter& m_droppedMessages;
+    Counter& m_filteredReadings;
+
+    // unregistered devices keep publishing, so they are warned about at most once per interval
+    std::atomic<std::chrono::steady_clock::rep> m_lastUnregisteredWarning;
+    std::atomic<std::uint64_t> m_suppressedUnregisteredWarnings;
+
+    std::unique_ptr<DeadbandFilter> m_deadbandFilter;
+
+    std::unique_ptr<ReadingTransformer> m_readingTransformer;
+    Counter& m_transformedReadings;
+
+    std::unique_ptr<WindowedAggregator> m_windowedAggregator;
+    Counter& m_windowedReadings;
+
+    std::function<void(const std::string& deviceKey)> m_deviceActivityListener;
+
+    DeviceRegistry<std::shared_ptr<const DeviceChannels>> m_deviceChannels;
+
+    ChannelInterner m_channelInterner;
+
+    std::chrono::milliseconds m_aggregationWindow;
+    std::size_t m_aggregationMaxReadings;
+    Executor* m_executor;
+
+    std::unordered_map<std::string, ReadingBatch> m_readingBatches;
+    std::unordered_map<std::uint64_t, Executor::TaskId> m_batchFlushTasks;
+    std::uint64_t m_nextBatchGeneration;
+    std::mutex m_aggregationLock;
+
+    struct ActuationState
+    {
+        std::chrono::steady_clock::time_point forwardedAt;
+        // latest command received since forwardedAt, set only while forward is scheduled
+        std::shared_ptr<Message> held;
+        Executor::TaskId task;
+    };
+
+    std::chrono::milliseconds m_actuationInterval;
+    Executor* m_actuationExecutor;
+    Counter& m_coalescedActuations;
+
+    // keyed by routed channel, which identifies device and actuator reference
+    std::unordered_map<std::string, ActuationState> m_actuations;
+    std::mutex m_actuationLock;
+
+    struct HeldConfiguration
+    {
+        std::string channel;
+        std::shared_ptr<Message> message;
+        std::chrono::steady_clock::time_point dueAt;
+    };
+
+    std::chrono::milliseconds m_configurationWindow;
+    std::chrono::milliseconds m_configurationPacing;
+    Executor* m_configurationExecutor;
+    Counter& m_coalescedConfigurations;
+
+    // held requests in order of arrival, and by routed channel the request of each device later ones are merged into
+    std::list<HeldConfiguration> m_heldConfigurations;
+    std::unordered_map<std::string, std::list<HeldConfiguration>::iterator> m_mergeableConfigurations;
+    std::chrono::steady_clock::time_point m_configurationForwardedAt;
+    Executor::TaskId m_configurationTask;
+    std::mutex m_configurationLock;
+
+    struct CachedState
+    {
+        // platform channel and content of last message device published
+        std::string channel;
+        std::string content;
+        std::chrono::steady_clock::time_point receivedAt;
+    };
+
+    struct DeviceState
+    {
+        std::unordered_map<std::string, CachedState> actuatorStatuses;
+        CachedState configuration;
+    };
+
+    bool isFresh(const CachedState& state, std::chrono::steady_clock::time_point now) const;
+
+    std::chrono::milliseconds m_deviceStateMaxAge;
+    Counter& m_deviceStateHits;
+
+    std::unordered_map<std::string, DeviceState> m_deviceStates;
+    std::mutex m_deviceStatesLock;
+
+    bool m_bulkActuatorStatusRequests;
 };
 
 }    // namespace wolkabout
@@ -0,0 +1,182 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "service/DeadbandFilter.h"
+#include "utilities/JsonReader.h"
+#include "utilities/Logger.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace wolkabout
+{
+namespace
+{
+const char* const ANY_DEVICE = "*";
+const char* const READING_DATA_FIELD = "data";
+
+std::string makeKey(const std::string& deviceKey, const std::string& reference)
+{
+    std::string key;
+    key.reserve(deviceKey.size() + reference.size() + 1);
+    key.append(deviceKey).append(1, '/').append(reference);
+    return key;
+}
+
+bool parseNumber(const std::string& text, double& value)
+{
+    if (text.empty())
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size() && std::isfinite(value);
+}
+}    // namespace
+
+DeadbandFilter::DeadbandFilter(double percentOfRange, std::chrono::milliseconds maxSilence)
+: m_percentOfRange{percentOfRange}, m_maxSilence{maxSilence}
+{
+}
+
+bool DeadbandFilter::loadOverrides(const std::string& path)
+{
+    std::ifstream file{path};
+    if (!file.is_open())
+    {
+        LOG(ERROR) << "DeadbandFilter: Unable to open override file '" << path << "'";
+        return false;
+    }
+
+    std::unordered_map<std::string, Band> overrides;
+
+    std::string line;
+    unsigned lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+
+        std::istringstream fields{line};
+        std::string deviceKey;
+        if (!(fields >> deviceKey) || deviceKey[0] == '#')
+        {
+            continue;
+        }
+
+        std::string reference;
+        std::string bandText;
+        std::string trailing;
+        Band band;
+        if (!(fields >> reference >> bandText) || (fields >> trailing) || !parseBand(bandText, band))
+        {
+            LOG(ERROR) << "DeadbandFilter: Invalid line " << lineNumber << " in override file '" << path << "'";
+            return false;
+        }
+
+        overrides[makeKey(deviceKey, reference)] = band;
+    }
+
+    std::lock_guard<std::mutex> lg{m_overridesLock};
+    m_overrides = std::move(overrides);
+    return true;
+}
+
+bool DeadbandFilter::accept(const std::string& deviceKey, const std::string& reference, double range,
+                            const std::string& payload)
+{
+    const double width = bandWidth(deviceKey, reference, range);
+    double value;
+    if (width <= 0 || !parseReading(payload, value))
+    {
+        return true;
+    }
+
+    const std::int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::steady_clock::now().time_since_epoch())
+                               .count();
+
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    LastReading& lastReading = m_lastReadings[makeKey(deviceKey, reference)];
+    const bool isFirst = lastReading.forwardedAt == 0;
+    const bool isSilent = m_maxSilence.count() > 0 && now - lastReading.forwardedAt >= m_maxSilence.count();
+    if (!isFirst && !isSilent && std::fabs(value - lastReading.value) <= width)
+    {
+        return false;
+    }
+
+    lastReading.value = value;
+    lastReading.forwardedAt = now;
+    return true;
+}
+
+bool DeadbandFilter::parseBand(const std::string& text, Band& band)
+{
+    band.isPercentage = !text.empty() && text.back() == '%';
+    return parseNumber(band.isPercentage ? text.substr(0, text.size() - 1) : text, band.width) && band.width >= 0;
+}
+
+bool DeadbandFilter::parseReading(const std::string& payload, double& value)
+{
+    JsonReader reader{payload};
+
+    std::string field;
+    std::string data;
+    bool hasData = false;
+    if (reader.beginObject())
+    {
+        while (reader.nextMember(field))
+        {
+            if (field == READING_DATA_FIELD)
+            {
+                hasData = reader.readString(data);
+            }
+            else
+            {
+                reader.skipValue();
+            }
+        }
+    }
+
+    // multi-value readings are comma separated and are not parsed as a number
+    return reader.finish() && hasData && parseNumber(data, value);
+}
+
+double DeadbandFilter::bandWidth(const std::string& deviceKey, const std::string& reference, double range) const
+{
+    std::lock_guard<std::mutex> lg{m_overridesLock};
+
+    Band band{m_percentOfRange, true};
+
+    auto it = m_overrides.find(makeKey(deviceKey, reference));
+    if (it == m_overrides.end())
+    {
+        it = m_overrides.find(makeKey(ANY_DEVICE, reference));
+    }
+
+    if (it != m_overrides.end())
+    {
+        band = it->second;
+    }
+
+    return band.isPercentage ? band.width / 100 * range : band.width;
+}
+}    // namespace wolkabout
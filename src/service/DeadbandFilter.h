@@ -0,0 +1,96 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DEADBANDFILTER_H
+#define DEADBANDFILTER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace wolkabout
+{
+/**
+ * @brief Drops sensor readings which did not change enough since the last forwarded reading
+ *
+ * Band of a sensor is either taken from override file, or computed as percentage of
+ * sensor range from device template. Reading within band is still forwarded once
+ * maximum silence interval passes, so platform keeps receiving values of steady sensors.
+ */
+class DeadbandFilter
+{
+public:
+    /**
+     * @param percentOfRange Band as percentage of sensor range from device template, 0 to use only overrides
+     * @param maxSilence Time after which reading within band is forwarded anyway, 0 for no limit
+     */
+    DeadbandFilter(double percentOfRange, std::chrono::milliseconds maxSilence);
+
+    /**
+     * @brief Loads bands which take precedence over ones derived from device template
+     *
+     * Each line holds device key ('*' for any device), sensor reference and band, which is either
+     * absolute or percentage of sensor range when followed by '%'. Empty lines and lines starting with '#'
+     * are ignored.
+     * Can be called again while readings are filtered, loaded overrides replace previous ones.
+     * @param path Path of override file
+     * @return false if file can not be read or has invalid line, in which case previous overrides are kept
+     */
+    bool loadOverrides(const std::string& path);
+
+    /**
+     * @brief Checks whether reading should be forwarded, and remembers it as last forwarded if so
+     * @param deviceKey Key of device which sent reading
+     * @param reference Sensor reference
+     * @param range Difference between sensor maximum and minimum from device template, 0 if unknown
+     * @param payload Reading payload, anything but a single numeric reading is always forwarded
+     * @return true if reading should be forwarded
+     */
+    bool accept(const std::string& deviceKey, const std::string& reference, double range, const std::string& payload);
+
+private:
+    struct Band
+    {
+        double width;
+        bool isPercentage;
+    };
+
+    struct LastReading
+    {
+        double value;
+        std::int64_t forwardedAt;
+    };
+
+    static bool parseBand(const std::string& text, Band& band);
+    static bool parseReading(const std::string& payload, double& value);
+
+    double bandWidth(const std::string& deviceKey, const std::string& reference, double range) const;
+
+    const double m_percentOfRange;
+    const std::chrono::milliseconds m_maxSilence;
+
+    // keyed by "<device key>/<reference>", device keys can not contain '/' as they are part of topics
+    std::unordered_map<std::string, Band> m_overrides;
+    mutable std::mutex m_overridesLock;
+
+    std::mutex m_lock;
+    std::unordered_map<std::string, LastReading> m_lastReadings;
+};
+}    // namespace wolkabout
+
+#endif    // DEADBANDFILTER_H
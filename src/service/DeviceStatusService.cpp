@@ -17,25 +17,30 @@
 #include "service/DeviceStatusService.h"
 #include "ConnectionStatusListener.h"
 #include "OutboundMessageHandler.h"
+#include "model/DeviceReferences.h"
 #include "model/DeviceStatus.h"
 #include "model/Message.h"
 #include "protocol/GatewayStatusProtocol.h"
 #include "protocol/StatusProtocol.h"
 #include "repository/DeviceRepository.h"
-#include "utilities/Logger.h"
+#include "utilities/GatewayLog.h"
+#include "utilities/MessagePack.h"
+#include "utilities/MessagePool.h"
+#include "utilities/ResponseMetrics.h"
 
-namespace
-{
-const std::chrono::seconds STATUS_RESPONSE_TIMEOUT{5};
-}
+#include <algorithm>
+#include <functional>
 
 namespace wolkabout
 {
+const std::chrono::seconds DeviceStatusService::DEFAULT_STATUS_RESPONSE_TIMEOUT{5};
+
 DeviceStatusService::DeviceStatusService(std::string gatewayKey, StatusProtocol& protocol,
                                          GatewayStatusProtocol& gatewayProtocol, DeviceRepository* deviceRepository,
                                          OutboundMessageHandler& outboundPlatformMessageHandler,
                                          OutboundMessageHandler& outboundDeviceMessageHandler,
-                                         std::chrono::seconds statusRequestInterval)
+                                         std::chrono::seconds statusRequestInterval,
+                                         std::chrono::seconds statusResponseTimeout)
 : m_gatewayKey{std::move(gatewayKey)}
 , m_protocol{protocol}
 , m_gatewayProtocol{gatewayProtocol}
@@ -43,13 +48,43 @@ DeviceStatusService::DeviceStatusService(std::string gatewayKey, StatusProtocol&
 , m_outboundPlatformMessageHandler{outboundPlatformMessageHandler}
 , m_outboundDeviceMessageHandler{outboundDeviceMessageHandler}
 , m_statusRequestInterval{statusRequestInterval}
-, m_statusResponseInterval{STATUS_RESPONSE_TIMEOUT}
+, m_statusResponseInterval{std::max(statusResponseTimeout, std::chrono::seconds{1})}
+, m_statusTableLoaded{false}
+, m_pollingBuckets{1}
+, m_executor{nullptr}
+, m_pollingGeneration{0}
+, m_nextPolledBucket{0}
+, m_pollingTask{0}
+, m_statusUpdateWindow{0}
+, m_statusUpdatesFlushTask{0}
+, m_coalescedStatusUpdates{MetricsRegistry::getInstance().counter("wolkgateway_status_coalesced_updates_total")}
+, m_statusUpdateResponseMetrics{nullptr}
 {
 }
 
+DeviceStatusService::~DeviceStatusService()
+{
+    stopStaggeredPolling();
+
+    Executor::TaskId flushTask;
+    {
+        std::lock_guard<decltype(m_statusUpdatesMutex)> lg{m_statusUpdatesMutex};
+        flushTask = m_statusUpdatesFlushTask;
+        m_statusUpdatesFlushTask = 0;
+    }
+
+    // flush that is already running is waited for
+    if (m_executor && flushTask != 0)
+    {
+        m_executor->cancel(flushTask);
+    }
+
+    flushStatusUpdates();
+}
+
 void DeviceStatusService::platformMessageReceived(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     const std::string topic = message->getChannel();
 
@@ -66,6 +101,16 @@ void DeviceStatusService::platformMessageReceived(std::shared_ptr<Message> messa
     }
     else if (m_protocol.isStatusConfirmMessage(*message))
     {
+        const std::string deviceKey = m_protocol.extractDeviceKeyFromChannel(topic);
+
+        std::lock_guard<decltype(m_statusConfirmMutex)> lg{m_statusConfirmMutex};
+
+        auto it = m_unconfirmedStatusUpdates.find(deviceKey);
+        if (it != m_unconfirmedStatusUpdates.end() && m_statusUpdateResponseMetrics)
+        {
+            m_statusUpdateResponseMetrics->record(std::chrono::steady_clock::now() - it->second, 0);
+            m_unconfirmedStatusUpdates.erase(it);
+        }
     }
     else
     {
@@ -75,7 +120,7 @@ void DeviceStatusService::platformMessageReceived(std::shared_ptr<Message> messa
 
 void DeviceStatusService::deviceMessageReceived(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     const std::string topic = message->getChannel();
 
@@ -106,6 +151,13 @@ void DeviceStatusService::deviceMessageReceived(std::shared_ptr<Message> message
     }
     else if (m_gatewayProtocol.isStatusResponseMessage(*message))
     {
+        message = decodePayload(message, deviceKey);
+        if (!message)
+        {
+            LOG(WARN) << "Device Status Service: Unable to decode device status response";
+            return;
+        }
+
         auto statusResponse = m_gatewayProtocol.makeDeviceStatusResponse(*message);
         if (!statusResponse)
         {
@@ -125,6 +177,13 @@ void DeviceStatusService::deviceMessageReceived(std::shared_ptr<Message> message
     }
     else if (m_gatewayProtocol.isStatusUpdateMessage(*message))
     {
+        message = decodePayload(message, deviceKey);
+        if (!message)
+        {
+            LOG(WARN) << "Device Status Service: Unable to decode device status update";
+            return;
+        }
+
         auto statusUpdate = m_gatewayProtocol.makeDeviceStatusUpdate(*message);
         if (!statusUpdate)
         {
@@ -160,15 +219,169 @@ const GatewayProtocol& DeviceStatusService::getGatewayProtocol() const
 
 void DeviceStatusService::sendLastKnownStatusForDevice(const std::string& deviceKey)
 {
-    if (containsDeviceStatus(deviceKey))
+    DeviceStatus::Status status;
+    {
+        std::lock_guard<decltype(m_deviceStatusMutex)> lg{m_deviceStatusMutex};
+
+        auto it = m_statusTableIndices.find(deviceKey);
+        if (it == m_statusTableIndices.end() || !m_statusTable[it->second].reported)
+        {
+            return;
+        }
+
+        status = m_statusTable[it->second].status;
+    }
+
+    // last known status is resent on purpose, so it is not subject to coalescing
+    {
+        std::lock_guard<decltype(m_statusUpdatesMutex)> lg{m_statusUpdatesMutex};
+        if (m_statusUpdateWindow.count() > 0)
+        {
+            m_publishedStatuses[deviceKey] = status;
+        }
+    }
+
+    publishStatusUpdate(deviceKey, status);
+}
+
+void DeviceStatusService::addDevice(const std::string& deviceKey)
+{
+    if (deviceKey == m_gatewayKey)
+    {
+        return;
+    }
+
+    std::lock_guard<decltype(m_deviceStatusMutex)> lg{m_deviceStatusMutex};
+
+    m_statusTable[statusTableIndex(deviceKey)].registered = true;
+}
+
+void DeviceStatusService::removeDevice(const std::string& deviceKey)
+{
+    std::lock_guard<decltype(m_deviceStatusMutex)> lg{m_deviceStatusMutex};
+
+    auto it = m_statusTableIndices.find(deviceKey);
+    if (it == m_statusTableIndices.end())
+    {
+        return;
+    }
+
+    // move last entry into the freed slot to keep the table dense
+    const std::size_t index = it->second;
+    m_statusTableIndices.erase(it);
+
+    if (index != m_statusTable.size() - 1)
+    {
+        m_statusTable[index] = m_statusTable.back();
+        m_statusTableKeys[index] = std::move(m_statusTableKeys.back());
+        m_statusTableIndices[m_statusTableKeys[index]] = index;
+    }
+
+    m_statusTable.pop_back();
+    m_statusTableKeys.pop_back();
+
+    std::lock_guard<decltype(m_statusUpdatesMutex)> statusUpdatesLock{m_statusUpdatesMutex};
+    m_publishedStatuses.erase(deviceKey);
+
+    std::lock_guard<decltype(m_statusConfirmMutex)> statusConfirmLock{m_statusConfirmMutex};
+    m_unconfirmedStatusUpdates.erase(deviceKey);
+}
+
+void DeviceStatusService::setStaggeredPolling(std::size_t buckets, Executor* executor)
+{
+    if (buckets > 1 && !executor)
+    {
+        LOG(WARN) << "Device Status Service: Executor not set, status polling will not be staggered";
+        buckets = 1;
+    }
+
+    // each slot must be long enough for devices polled in it to respond
+    const auto maximumBuckets = static_cast<std::size_t>(
+      std::max<std::chrono::seconds::rep>(m_statusRequestInterval.count() / m_statusResponseInterval.count(), 1));
+
+    std::lock_guard<decltype(m_deviceStatusMutex)> lg{m_deviceStatusMutex};
+
+    m_pollingBuckets = static_cast<std::uint32_t>(std::min(std::max<std::size_t>(buckets, 1), maximumBuckets));
+    if (executor)
+    {
+        m_executor = executor;
+    }
+
+    for (std::size_t i = 0; i < m_statusTable.size(); ++i)
+    {
+        m_statusTable[i].bucket =
+          static_cast<std::uint32_t>(std::hash<std::string>{}(m_statusTableKeys[i]) % m_pollingBuckets);
+    }
+}
+
+void DeviceStatusService::setStatusUpdateCoalescing(std::chrono::milliseconds window, Executor* executor)
+{
+    if (window.count() > 0 && !executor)
+    {
+        LOG(WARN) << "Device Status Service: Executor not set, status updates will not be coalesced";
+        return;
+    }
+
+    std::lock_guard<decltype(m_statusUpdatesMutex)> lg{m_statusUpdatesMutex};
+
+    m_statusUpdateWindow = window;
+    if (executor)
+    {
+        m_executor = executor;
+    }
+}
+
+void DeviceStatusService::flushStatusUpdates()
+{
+    std::lock_guard<decltype(m_statusUpdatesMutex)> lg{m_statusUpdatesMutex};
+    publishPendingStatusUpdates();
+}
+
+void DeviceStatusService::publishPendingStatusUpdates()
+{
+    for (const auto& pending : m_pendingStatusUpdates)
     {
-        auto status = getDeviceStatus(deviceKey).second;
-        sendStatusUpdateForDevice(deviceKey, status);
+        auto published = m_publishedStatuses.find(pending.first);
+        if (published != m_publishedStatuses.end() && published->second == pending.second)
+        {
+            // device flapped back to published status
+            m_coalescedStatusUpdates.increment();
+            continue;
+        }
+
+        m_publishedStatuses[pending.first] = pending.second;
+        publishStatusUpdate(pending.first, pending.second);
+    }
+
+    m_pendingStatusUpdates.clear();
+}
+
+void DeviceStatusService::deviceActivity(const std::string& deviceKey)
+{
+    std::lock_guard<decltype(m_deviceStatusMutex)> lg{m_deviceStatusMutex};
+
+    auto it = m_statusTableIndices.find(deviceKey);
+    if (it != m_statusTableIndices.end())
+    {
+        m_statusTable[it->second].lastActivityTime = std::time(nullptr);
     }
 }
 
 void DeviceStatusService::connected()
 {
+    if (m_pollingBuckets > 1 && m_deviceRepository)
+    {
+        std::uint64_t generation;
+        {
+            std::lock_guard<decltype(m_pollingMutex)> lg{m_pollingMutex};
+            generation = ++m_pollingGeneration;
+            m_nextPolledBucket = 0;
+        }
+
+        pollNextSlot(generation);
+        return;
+    }
+
     requestDevicesStatus();
 
     m_requestTimer.run(std::chrono::duration_cast<std::chrono::milliseconds>(m_statusRequestInterval),
@@ -177,6 +390,8 @@ void DeviceStatusService::connected()
 
 void DeviceStatusService::disconnected()
 {
+    stopStaggeredPolling();
+
     m_requestTimer.stop();
     m_responseTimer.stop();
 }
@@ -185,17 +400,7 @@ void DeviceStatusService::requestDevicesStatus()
 {
     if (m_deviceRepository)
     {
-        auto keys = m_deviceRepository->findAllDeviceKeys();
-
-        for (const auto& key : *keys)
-        {
-            if (key == m_gatewayKey)
-            {
-                continue;
-            }
-
-            sendStatusRequestForDevice(key);
-        }
+        pollBucket(0);
 
         m_responseTimer.start(std::chrono::duration_cast<std::chrono::milliseconds>(m_statusResponseInterval),
                               [=] { validateDevicesStatus(); });
@@ -213,37 +418,130 @@ void DeviceStatusService::validateDevicesStatus()
         return;
     }
 
-    auto keys = m_deviceRepository->findAllDeviceKeys();
-
-    for (const auto& key : *keys)
+    std::vector<std::string> offlineDeviceKeys;
     {
-        if (key == m_gatewayKey)
+        std::lock_guard<decltype(m_deviceStatusMutex)> lg{m_deviceStatusMutex};
+
+        const std::time_t currentTime = std::time(nullptr);
+
+        for (std::size_t i = 0; i < m_statusTable.size(); ++i)
         {
-            continue;
+            DeviceStatusEntry& entry = m_statusTable[i];
+            if (!entry.registered || !entry.pollPending)
+            {
+                continue;
+            }
+
+            entry.pollPending = false;
+
+            // device has not reported status at all, or has not reported it in time and last status was CONNECTED
+            const bool timedOut = entry.status == DeviceStatus::Status::CONNECTED &&
+                                  std::difftime(currentTime, entry.lastReportTime) > m_statusResponseInterval.count();
+            if (!entry.reported || timedOut)
+            {
+                entry.lastReportTime = currentTime;
+                entry.status = DeviceStatus::Status::OFFLINE;
+                entry.reported = true;
+
+                offlineDeviceKeys.push_back(m_statusTableKeys[i]);
+            }
         }
+    }
+
+    for (const auto& key : offlineDeviceKeys)
+    {
+        sendStatusUpdateForDevice(key, DeviceStatus::Status::OFFLINE);
+    }
+}
 
-        if (!containsDeviceStatus(key))
+void DeviceStatusService::pollBucket(std::uint32_t bucket)
+{
+    loadStatusTable();
+
+    std::vector<std::shared_ptr<Message>> requests;
+    {
+        std::lock_guard<decltype(m_deviceStatusMutex)> lg{m_deviceStatusMutex};
+
+        const std::time_t currentTime = std::time(nullptr);
+
+        for (std::size_t i = 0; i < m_statusTable.size(); ++i)
         {
-            // device has not reported status at all, send offline status
-            logDeviceStatus(key, DeviceStatus::Status::OFFLINE);
-            sendStatusUpdateForDevice(key, DeviceStatus::Status::OFFLINE);
-            continue;
-        }
+            DeviceStatusEntry& entry = m_statusTable[i];
+            if (!entry.registered || entry.bucket != bucket)
+            {
+                continue;
+            }
 
-        auto statusReport = getDeviceStatus(key);
+            // recent data traffic already proves device is online
+            if (entry.reported && entry.status == DeviceStatus::Status::CONNECTED &&
+                std::difftime(currentTime, entry.lastActivityTime) < m_statusRequestInterval.count())
+            {
+                continue;
+            }
 
-        std::time_t lastReportTime = statusReport.first;
-        std::time_t currentTime = std::time(nullptr);
-        DeviceStatus::Status lastStatus = statusReport.second;
+            const std::string& key = m_statusTableKeys[i];
+            std::shared_ptr<Message> message = m_gatewayProtocol.makeDeviceStatusRequestMessage(key);
+            if (!message)
+            {
+                LOG(WARN) << "Failed to create status request message for device: " << key;
+                continue;
+            }
+
+            entry.pollPending = true;
+            requests.push_back(message);
+        }
+    }
 
-        if (std::difftime(lastReportTime, currentTime) > m_statusResponseInterval.count() &&
-            lastStatus == DeviceStatus::Status::CONNECTED)
+    for (const auto& message : requests)
+    {
+        m_outboundDeviceMessageHandler.addMessage(message);
+    }
+}
+
+void DeviceStatusService::pollNextSlot(std::uint64_t generation)
+{
+    std::uint32_t bucket;
+    {
+        std::lock_guard<decltype(m_pollingMutex)> lg{m_pollingMutex};
+        if (generation != m_pollingGeneration)
         {
-            // device has not reported status in time and last status was CONNECTED, send offline status
-            logDeviceStatus(key, DeviceStatus::Status::OFFLINE);
-            sendStatusUpdateForDevice(key, DeviceStatus::Status::OFFLINE);
-            continue;
+            return;
         }
+
+        bucket = m_nextPolledBucket;
+        m_nextPolledBucket = (m_nextPolledBucket + 1) % m_pollingBuckets;
+    }
+
+    // devices polled in previous slot had at least status response timeout to respond
+    validateDevicesStatus();
+
+    pollBucket(bucket);
+
+    // next slot is scheduled only after this one is done, so stopStaggeredPolling has single task to cancel
+    std::lock_guard<decltype(m_pollingMutex)> lg{m_pollingMutex};
+    if (generation != m_pollingGeneration)
+    {
+        return;
+    }
+
+    const auto slot = std::chrono::duration_cast<std::chrono::milliseconds>(m_statusRequestInterval) /
+                      static_cast<std::chrono::milliseconds::rep>(m_pollingBuckets);
+    m_pollingTask = m_executor->schedule(slot, [=] { pollNextSlot(generation); });
+}
+
+void DeviceStatusService::stopStaggeredPolling()
+{
+    Executor::TaskId task;
+    {
+        std::lock_guard<decltype(m_pollingMutex)> lg{m_pollingMutex};
+        ++m_pollingGeneration;
+        task = m_pollingTask;
+        m_pollingTask = 0;
+    }
+
+    if (m_executor && task != 0)
+    {
+        m_executor->cancel(task);
     }
 }
 
@@ -286,6 +584,39 @@ void DeviceStatusService::sendStatusResponseForDevice(const std::string& deviceK
 }
 
 void DeviceStatusService::sendStatusUpdateForDevice(const std::string& deviceKey, DeviceStatus::Status status)
+{
+    {
+        std::lock_guard<decltype(m_statusUpdatesMutex)> lg{m_statusUpdatesMutex};
+
+        if (m_statusUpdateWindow.count() > 0)
+        {
+            auto it = m_pendingStatusUpdates.find(deviceKey);
+            if (it != m_pendingStatusUpdates.end())
+            {
+                // only last status within window is published
+                it->second = status;
+                m_coalescedStatusUpdates.increment();
+                return;
+            }
+
+            m_pendingStatusUpdates.emplace(deviceKey, status);
+            if (m_statusUpdatesFlushTask == 0)
+            {
+                // whole flush runs under lock, so destructor flushing after it waits for flush on executor
+                m_statusUpdatesFlushTask = m_executor->schedule(m_statusUpdateWindow, [=] {
+                    std::lock_guard<decltype(m_statusUpdatesMutex)> flushLock{m_statusUpdatesMutex};
+                    m_statusUpdatesFlushTask = 0;
+                    publishPendingStatusUpdates();
+                });
+            }
+            return;
+        }
+    }
+
+    publishStatusUpdate(deviceKey, status);
+}
+
+void DeviceStatusService::publishStatusUpdate(const std::string& deviceKey, DeviceStatus::Status status)
 {
     std::shared_ptr<Message> statusMessage =
       m_protocol.makeStatusUpdateMessage(m_gatewayKey, DeviceStatus{deviceKey, status});
@@ -296,35 +627,94 @@ void DeviceStatusService::sendStatusUpdateForDevice(const std::string& deviceKey
         return;
     }
 
+    {
+        std::lock_guard<decltype(m_statusConfirmMutex)> lg{m_statusConfirmMutex};
+        if (!m_statusUpdateResponseMetrics)
+        {
+            m_statusUpdateResponseMetrics = &ResponseMetrics::forRequestChannel(statusMessage->getChannel());
+        }
+
+        // confirmation time is measured from the latest update of device
+        m_unconfirmedStatusUpdates[deviceKey] = std::chrono::steady_clock::now();
+    }
+
     m_outboundPlatformMessageHandler.addMessage(statusMessage);
 }
 
-bool DeviceStatusService::containsDeviceStatus(const std::string& deviceKey)
+void DeviceStatusService::loadStatusTable()
 {
-    std::lock_guard<decltype(m_deviceStatusMutex)> lg{m_deviceStatusMutex};
+    // table is read from repository once, afterwards it is kept in sync by addDevice and removeDevice
+    {
+        std::lock_guard<decltype(m_deviceStatusMutex)> lg{m_deviceStatusMutex};
+        if (m_statusTableLoaded)
+        {
+            return;
+        }
+    }
 
-    return m_deviceStatuses.find(deviceKey) != m_deviceStatuses.end();
-}
+    const auto keys = m_deviceRepository->findAllDeviceKeys();
 
-std::pair<std::time_t, DeviceStatus::Status> DeviceStatusService::getDeviceStatus(const std::string& deviceKey)
-{
     std::lock_guard<decltype(m_deviceStatusMutex)> lg{m_deviceStatusMutex};
 
-    auto it = m_deviceStatuses.find(deviceKey);
+    for (const auto& key : *keys)
+    {
+        if (key != m_gatewayKey)
+        {
+            m_statusTable[statusTableIndex(key)].registered = true;
+        }
+    }
 
-    if (it != m_deviceStatuses.end())
+    m_statusTableLoaded = true;
+}
+
+std::size_t DeviceStatusService::statusTableIndex(const std::string& deviceKey)
+{
+    auto it = m_statusTableIndices.find(deviceKey);
+    if (it != m_statusTableIndices.end())
     {
         return it->second;
     }
 
-    return std::make_pair(0, DeviceStatus::Status::OFFLINE);
+    const std::size_t index = m_statusTable.size();
+    const auto bucket = static_cast<std::uint32_t>(std::hash<std::string>{}(deviceKey) % m_pollingBuckets);
+    m_statusTable.push_back(DeviceStatusEntry{0, 0, DeviceStatus::Status::OFFLINE, bucket, false, false, false});
+    m_statusTableKeys.push_back(deviceKey);
+    m_statusTableIndices.emplace(deviceKey, index);
+
+    return index;
 }
 
 void DeviceStatusService::logDeviceStatus(const std::string& deviceKey, DeviceStatus::Status status)
 {
     std::lock_guard<decltype(m_deviceStatusMutex)> lg{m_deviceStatusMutex};
 
-    m_deviceStatuses[deviceKey] = std::make_pair(std::time(nullptr), status);
+    DeviceStatusEntry& entry = m_statusTable[statusTableIndex(deviceKey)];
+    entry.lastReportTime = std::time(nullptr);
+    entry.status = status;
+    entry.reported = true;
+}
+
+std::shared_ptr<Message> DeviceStatusService::decodePayload(std::shared_ptr<Message> message,
+                                                            const std::string& deviceKey)
+{
+    if (!m_deviceRepository)
+    {
+        return message;
+    }
+
+    const auto references = m_deviceRepository->findReferencesByDeviceKey(deviceKey);
+    if (!references || references->getPayloadEncoding() != DeviceReferences::PayloadEncoding::MESSAGE_PACK)
+    {
+        return message;
+    }
+
+    std::string content;
+    if (!MessagePack::toJson(message->getContent(), content))
+    {
+        return nullptr;
+    }
+
+    return MessagePool::make(std::move(content), message->getChannel());
 }
 
 }    // namespace wolkabout
@@ -21,13 +21,19 @@
 #include "InboundDeviceMessageHandler.h"
 #include "InboundPlatformMessageHandler.h"
 #include "model/DeviceStatus.h"
+#include "utilities/Executor.h"
+#include "utilities/Metrics.h"
+#include "utilities/ResponseMetrics.h"
 #include "utilities/Timer.h"
 
 #include <chrono>
-#include <map>
+#include <cstdint>
+#include <ctime>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace wolkabout
 {
@@ -45,7 +51,10 @@ public:
     DeviceStatusService(std::string gatewayKey, StatusProtocol& protocol, GatewayStatusProtocol& gatewayProtocol,
                         DeviceRepository* deviceRepository, OutboundMessageHandler& outboundPlatformMessageHandler,
                         OutboundMessageHandler& outboundDeviceMessageHandler,
-                        std::chrono::seconds statusRequestInterval);
+                        std::chrono::seconds statusRequestInterval,
+                        std::chrono::seconds statusResponseTimeout = DEFAULT_STATUS_RESPONSE_TIMEOUT);
+
+    ~DeviceStatusService();
 
     void platformMessageReceived(std::shared_ptr<Message> message) override;
 
@@ -57,22 +66,78 @@ public:
 
     void sendLastKnownStatusForDevice(const std::string& deviceKey);
 
+    /**
+     * @brief Adds registered device to status table, so its status is polled and validated
+     * @param deviceKey Key of registered device
+     */
+    void addDevice(const std::string& deviceKey);
+
+    /**
+     * @brief Removes deleted device from status table
+     * @param deviceKey Key of deleted device
+     */
+    void removeDevice(const std::string& deviceKey);
+
+    /**
+     * @brief Spreads periodic status requests of subdevices over status request interval
+     *
+     * Devices are assigned to buckets by hash of their key, and each bucket is polled in its own slot of the
+     * interval, which is never shorter than status response timeout. Must be called before connected().
+     * @param buckets Number of slots interval is divided into, 1 polls all devices at once
+     * @param executor Executor on which polling is scheduled, required if buckets is greater than 1
+     */
+    void setStaggeredPolling(std::size_t buckets, Executor* executor);
+
+    /**
+     * @brief Collects status updates of subdevices for window before publishing them together
+     *
+     * Only last status of each device within window is published, and none if it is the one already published,
+     * so devices flapping during window produce at most one update. Must be called before messages are received.
+     * @param window Time for which status updates are collected, 0 publishes each update immediately
+     * @param executor Executor on which window expiry is handled, required if window is set
+     */
+    void setStatusUpdateCoalescing(std::chrono::milliseconds window, Executor* executor);
+
+    /**
+     * @brief Publishes all collected status updates
+     */
+    void flushStatusUpdates();
+
+    /**
+     * @brief Records data traffic of device
+     * Devices which are connected and sent data within status request interval are not polled.
+     * @param deviceKey Key of device which sent data
+     */
+    void deviceActivity(const std::string& deviceKey);
+
     void connected() override;
     void disconnected() override;
 
+    static const std::chrono::seconds DEFAULT_STATUS_RESPONSE_TIMEOUT;
+
 private:
     void requestDevicesStatus();
     void validateDevicesStatus();
 
+    void pollBucket(std::uint32_t bucket);
+    void pollNextSlot(std::uint64_t generation);
+    void stopStaggeredPolling();
+
     void sendStatusRequestForDevice(const std::string& deviceKey);
     void sendStatusRequestForAllDevices();
     void sendStatusResponseForDevice(const std::string& deviceKey, DeviceStatus::Status status);
     void sendStatusUpdateForDevice(const std::string& deviceKey, DeviceStatus::Status status);
+    void publishStatusUpdate(const std::string& deviceKey, DeviceStatus::Status status);
+    // requires m_statusUpdatesMutex to be held
+    void publishPendingStatusUpdates();
 
-    bool containsDeviceStatus(const std::string& deviceKey);
-    std::pair<std::time_t, DeviceStatus::Status> getDeviceStatus(const std::string& deviceKey);
+    void loadStatusTable();
+    std::size_t statusTableIndex(const std::string& deviceKey);
     void logDeviceStatus(const std::string& deviceKey, DeviceStatus::Status status);
 
+    // converts MessagePack payload of device to JSON, returns nullptr if payload can not be converted
+    std::shared_ptr<Message> decodePayload(std::shared_ptr<Message> message, const std::string& deviceKey);
+
     const std::string m_gatewayKey;
     StatusProtocol& m_protocol;
     GatewayStatusProtocol& m_gatewayProtocol;
@@ -87,8 +152,44 @@ private:
     Timer m_requestTimer;
     Timer m_responseTimer;
 
+    struct DeviceStatusEntry
+    {
+        std::time_t lastReportTime;
+        std::time_t lastActivityTime;
+        DeviceStatus::Status status;
+        std::uint32_t bucket;
+        bool reported;
+        bool registered;
+        bool pollPending;
+    };
+
+    // Devices are identified by their index in the status table, so validation is a scan over packed entries.
+    // Entries with registered=false hold statuses reported by devices that are not (yet) in repository
     std::mutex m_deviceStatusMutex;
-    std::map<std::string, std::pair<std::time_t, DeviceStatus::Status>> m_deviceStatuses;
+    bool m_statusTableLoaded;
+    std::vector<DeviceStatusEntry> m_statusTable;
+    std::vector<std::string> m_statusTableKeys;
+    std::unordered_map<std::string, std::size_t> m_statusTableIndices;
+
+    std::uint32_t m_pollingBuckets;
+    Executor* m_executor;
+
+    std::mutex m_pollingMutex;
+    std::uint64_t m_pollingGeneration;
+    std::uint32_t m_nextPolledBucket;
+    Executor::TaskId m_pollingTask;
+
+    std::chrono::milliseconds m_statusUpdateWindow;
+    std::mutex m_statusUpdatesMutex;
+    std::unordered_map<std::string, DeviceStatus::Status> m_pendingStatusUpdates;
+    std::unordered_map<std::string, DeviceStatus::Status> m_publishedStatuses;
+    Executor::TaskId m_statusUpdatesFlushTask;
+
+    Counter& m_coalescedStatusUpdates;
+
+    std::mutex m_statusConfirmMutex;
+    std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_unconfirmedStatusUpdates;
+    ResponseMetrics* m_statusUpdateResponseMetrics;
 };
 }    // namespace wolkabout
 
@@ -29,48 +29,70 @@
 #include "model/Message.h"
 #include "protocol/json/JsonDownloadProtocol.h"
 #include "repository/FileRepository.h"
+#include "repository/FileTransferCheckpointRepository.h"
 #include "service/UrlFileDownloader.h"
+#include "utilities/BandwidthScheduler.h"
 #include "utilities/ByteUtils.h"
+#include "utilities/CommandWatchdog.h"
 #include "utilities/FileSystemUtils.h"
-#include "utilities/Logger.h"
+#include "utilities/GatewayLog.h"
+#include "utilities/Sha256.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
 #include <utilities/StringUtils.h>
-
-namespace
-{
-static const size_t FILE_HASH_INDEX = 0;
-static const size_t FILE_DOWNLOADER_INDEX = 1;
-static const size_t FLAG_INDEX = 2;
-}    // namespace
+#include <vector>
 
 namespace wolkabout
 {
 FileDownloadService::FileDownloadService(std::string gatewayKey, JsonDownloadProtocol& protocol,
                                          std::string fileDownloadDirectory,
                                          OutboundMessageHandler& outboundMessageHandler, FileRepository& fileRepository,
-                                         std::shared_ptr<UrlFileDownloader> urlFileDownloader)
+                                         Executor& executor, std::shared_ptr<UrlFileDownloader> urlFileDownloader,
+                                         unsigned packetRequestWindow,
+                                         FileTransferCheckpointRepository* fileTransferCheckpointRepository,
+                                         std::uint64_t fileCacheQuota,
+                                         std::shared_ptr<BandwidthScheduler> bandwidthScheduler,
+                                         std::size_t maxConcurrentTransfers)
 : m_gatewayKey{std::move(gatewayKey)}
 , m_protocol{protocol}
 , m_fileDownloadDirectory{std::move(fileDownloadDirectory)}
 , m_outboundMessageHandler{outboundMessageHandler}
 , m_fileRepository{fileRepository}
+, m_executor{executor}
 , m_urlFileDownloader{std::move(urlFileDownloader)}
-, m_activeDownload{""}
+, m_packetRequestWindow{packetRequestWindow}
+, m_maxPacketSize{DEFAULT_MAX_PACKET_SIZE}
+, m_packetRequestTimeout{FileDownloader::DEFAULT_PACKET_REQUEST_TIMEOUT}
+, m_fileTransferCheckpointRepository{fileTransferCheckpointRepository}
+, m_fileCacheQuota{fileCacheQuota}
+, m_bandwidthScheduler{std::move(bandwidthScheduler)}
+, m_fileIndexLoaded{false}
+, m_fileIndexChanged{false}
+, m_packetScheduler{maxConcurrentTransfers, [this](const FilePacketRequest& request) { requestPacket(request); }}
+, m_transfers(m_packetScheduler.maxTransfers())
 , m_run{true}
-, m_garbageCollector(&FileDownloadService::clearDownloads, this)
+, m_cleanupTask{0}
 {
 }
 
 FileDownloadService::~FileDownloadService()
 {
-    m_run = false;
-    notifyCleanup();
+    Executor::TaskId cleanupTask;
+
+    {
+        std::lock_guard<decltype(m_mutex)> lg{m_mutex};
+        m_run = false;
+        cleanupTask = m_cleanupTask;
+    }
 
-    if (m_garbageCollector.joinable())
+    if (cleanupTask != 0)
     {
-        m_garbageCollector.join();
+        m_executor.cancel(cleanupTask);
     }
 }
 
@@ -131,7 +153,7 @@ void FileDownloadService::platformMessageReceived(std::shared_ptr<Message> messa
     auto listConfirmResult = m_protocol.makeFileListConfirm(*message);
     if (listConfirmResult)
     {
-        LOG(DEBUG) << "Received file list confirm: " << to_string(*listConfirmResult);
+        GATEWAY_LOG(DEBUG) << "Received file list confirm: " << to_string(*listConfirmResult);
         return;
     }
 
@@ -164,16 +186,22 @@ const Protocol& FileDownloadService::getProtocol() const
 
 void FileDownloadService::handle(const BinaryData& binaryData)
 {
-    std::lock_guard<decltype(m_mutex)> lg{m_mutex};
+    const auto id = m_packetScheduler.received();
 
-    auto it = m_activeDownloads.find(m_activeDownload);
-    if (it == m_activeDownloads.end())
+    std::shared_ptr<Transfer> transfer;
+    if (id != FilePacketScheduler::INVALID_TRANSFER)
+    {
+        transfer = std::atomic_load(&m_transfers[id]);
+    }
+
+    if (!transfer)
     {
         LOG(WARN) << "Unexpected binary data";
         return;
     }
 
-    std::get<FILE_DOWNLOADER_INDEX>(it->second)->handleData(binaryData);
+    std::lock_guard<std::mutex> lg{transfer->mutex};
+    transfer->downloader->handleData(binaryData);
 }
 
 void FileDownloadService::handle(const FileUploadInitiate& request)
@@ -204,6 +232,13 @@ void FileDownloadService::handle(const FileUploadInitiate& request)
 
     if (!fileInfo)
     {
+        if (linkCachedFile(request.getName(), request.getHash()))
+        {
+            sendStatus(FileUploadStatus{request.getName(), FileTransferStatus::FILE_READY});
+            sendFileListIfChanged();
+            return;
+        }
+
         download(request.getName(), request.getSize(), request.getHash());
     }
     else if (fileInfo->hash != request.getHash())
@@ -212,6 +247,7 @@ void FileDownloadService::handle(const FileUploadInitiate& request)
     }
     else
     {
+        m_fileRepository.touch(request.getName());
         sendStatus(FileUploadStatus{request.getName(), FileTransferStatus::FILE_READY});
     }
 }
@@ -288,10 +324,22 @@ void FileDownloadService::download(const std::string& fileName, uint64_t fileSiz
 {
     std::lock_guard<decltype(m_mutex)> lg{m_mutex};
 
+    std::string activeHash;
     auto it = m_activeDownloads.find(fileName);
     if (it != m_activeDownloads.end())
     {
-        auto activeHash = std::get<FILE_HASH_INDEX>(m_activeDownloads[fileName]);
+        activeHash = it->second->fileHash;
+    }
+
+    auto queued = std::find_if(m_queuedDownloads.begin(), m_queuedDownloads.end(),
+                               [&](const QueuedDownload& download) { return download.fileName == fileName; });
+    if (queued != m_queuedDownloads.end())
+    {
+        activeHash = queued->fileHash;
+    }
+
+    if (it != m_activeDownloads.end() || queued != m_queuedDownloads.end())
+    {
         if (activeHash != fileHash)
         {
             LOG(WARN) << "Download already active for file: " << fileName << ", but with different hash";
@@ -305,25 +353,74 @@ void FileDownloadService::download(const std::string& fileName, uint64_t fileSiz
         return;
     }
 
-    LOG(INFO) << "Downloading file: " << fileName;
     sendStatus(FileUploadStatus{fileName, FileTransferStatus::FILE_TRANSFER});
 
+    const auto id = m_packetScheduler.open();
+    if (id == FilePacketScheduler::INVALID_TRANSFER)
+    {
+        LOG(INFO) << "Maximum number of concurrent transfers reached, queueing download of file: " << fileName;
+        m_queuedDownloads.push_back(QueuedDownload{fileName, fileSize, fileHash});
+        return;
+    }
+
+    startDownload(id, fileName, fileSize, fileHash);
+}
+
+void FileDownloadService::startDownload(FilePacketScheduler::TransferId id, const std::string& fileName,
+                                        std::uint64_t fileSize, const std::string& fileHash)
+{
+    LOG(INFO) << "Downloading file: " << fileName;
+
     const auto byteHash = ByteUtils::toByteArray(StringUtils::base64Decode(fileHash));
 
-    auto downloader = std::unique_ptr<FileDownloader>(new FileDownloader(MAX_PACKET_SIZE));
-    m_activeDownloads[fileName] = std::make_tuple(fileHash, std::move(downloader), false);
-    m_activeDownload = fileName;
+    std::function<void(const FileTransferCheckpoint&)> onCheckpoint;
+    std::shared_ptr<FileTransferCheckpoint> checkpoint;
+    if (m_fileTransferCheckpointRepository)
+    {
+        onCheckpoint = [=](const FileTransferCheckpoint& progress) {
+            m_fileTransferCheckpointRepository->store(progress);
+        };
+        checkpoint = m_fileTransferCheckpointRepository->getCheckpoint(fileName);
+    }
+
+    auto transfer = std::make_shared<Transfer>(id, fileHash);
+    // packet hashes are checked on shared executor, so downloader keeps requesting packets meanwhile
+    transfer->downloader.reset(new FileDownloader(m_maxPacketSize, m_packetRequestWindow, m_bandwidthScheduler,
+                                                  m_packetRequestTimeout, &m_executor));
 
-    std::get<FILE_DOWNLOADER_INDEX>(m_activeDownloads[fileName])
-      ->download(fileName, fileSize, byteHash, m_fileDownloadDirectory,
-                 [=](const FilePacketRequest& request) { requestPacket(request); },
-                 [=](const std::string& filePath) { downloadCompleted(fileName, filePath, fileHash); },
-                 [=](FileTransferError code) { downloadFailed(fileName, code); });
+    m_activeDownloads[fileName] = transfer;
+    std::atomic_store(&m_transfers[id], transfer);
+
+    std::lock_guard<std::mutex> transferLock{transfer->mutex};
+    transfer->downloader->download(
+      fileName, fileSize, byteHash, m_fileDownloadDirectory,
+      [=](const FilePacketRequest& request) { m_packetScheduler.request(id, request); },
+      [=](const std::string& filePath) { downloadCompleted(fileName, filePath, fileHash); },
+      [=](FileTransferError code) { downloadFailed(fileName, code); }, onCheckpoint, checkpoint);
+}
+
+void FileDownloadService::startQueuedDownloads()
+{
+    std::lock_guard<decltype(m_mutex)> lg{m_mutex};
+
+    while (m_run && !m_queuedDownloads.empty())
+    {
+        const auto id = m_packetScheduler.open();
+        if (id == FilePacketScheduler::INVALID_TRANSFER)
+        {
+            return;
+        }
+
+        const QueuedDownload download = m_queuedDownloads.front();
+        m_queuedDownloads.pop_front();
+
+        startDownload(id, download.fileName, download.fileSize, download.fileHash);
+    }
 }
 
 void FileDownloadService::urlDownload(const std::string& fileUrl)
 {
-    LOG(DEBUG) << "FileDownloadService::urlDownload " << fileUrl;
+    GATEWAY_LOG(DEBUG) << "FileDownloadService::urlDownload " << fileUrl;
 
     m_urlFileDownloader->download(
       fileUrl, m_fileDownloadDirectory,
@@ -335,30 +432,42 @@ void FileDownloadService::urlDownload(const std::string& fileUrl)
 
 void FileDownloadService::abortDownload(const std::string& fileName)
 {
-    LOG(DEBUG) << "FileDownloadService::abort " << fileName;
+    GATEWAY_LOG(DEBUG) << "FileDownloadService::abort " << fileName;
 
     std::lock_guard<decltype(m_mutex)> lg{m_mutex};
 
+    auto queued = std::find_if(m_queuedDownloads.begin(), m_queuedDownloads.end(),
+                               [&](const QueuedDownload& download) { return download.fileName == fileName; });
+    if (queued != m_queuedDownloads.end())
+    {
+        LOG(INFO) << "Aborting queued download for file: " << fileName;
+        m_queuedDownloads.erase(queued);
+        sendStatus(FileUploadStatus{fileName, FileTransferStatus::ABORTED});
+        return;
+    }
+
     auto it = m_activeDownloads.find(fileName);
     if (it != m_activeDownloads.end())
     {
         LOG(INFO) << "Aborting download for file: " << fileName;
-        std::get<FILE_DOWNLOADER_INDEX>(it->second)->abort();
+        {
+            std::lock_guard<std::mutex> transferLock{it->second->mutex};
+            it->second->downloader->abort();
+        }
         flagCompletedDownload(fileName);
+        removeCheckpoint(fileName);
         // TODO race with completed
         sendStatus(FileUploadStatus{fileName, FileTransferStatus::ABORTED});
-
-        m_activeDownload = "";
     }
     else
     {
-        LOG(DEBUG) << "FileDownloadService::abort download not active";
+        GATEWAY_LOG(DEBUG) << "FileDownloadService::abort download not active";
     }
 }
 
 void FileDownloadService::abortUrlDownload(const std::string& fileUrl)
 {
-    LOG(DEBUG) << "FileDownloadService::abortUrlDownload " << fileUrl;
+    GATEWAY_LOG(DEBUG) << "FileDownloadService::abortUrlDownload " << fileUrl;
 
     LOG(INFO) << "Aborting download for file: " << fileUrl;
     m_urlFileDownloader->abort(fileUrl);
@@ -368,7 +477,7 @@ void FileDownloadService::abortUrlDownload(const std::string& fileUrl)
 
 void FileDownloadService::deleteFile(const std::string& fileName)
 {
-    LOG(DEBUG) << "FileDownloadService::delete " << fileName;
+    GATEWAY_LOG(DEBUG) << "FileDownloadService::delete " << fileName;
 
     auto info = m_fileRepository.getFileInfo(fileName);
     if (!info)
@@ -384,14 +493,14 @@ void FileDownloadService::deleteFile(const std::string& fileName)
         return;
     }
 
-    m_fileRepository.remove(fileName);
+    removeFile(fileName);
 
-    sendFileList();
+    sendFileListIfChanged();
 }
 
 void FileDownloadService::purgeFiles()
 {
-    LOG(DEBUG) << "FileDownloadService::purge";
+    GATEWAY_LOG(DEBUG) << "FileDownloadService::purge";
 
     auto fileNames = m_fileRepository.getAllFileNames();
     if (!fileNames)
@@ -417,17 +526,22 @@ void FileDownloadService::purgeFiles()
             continue;
         }
 
-        m_fileRepository.remove(name);
+        removeFile(name);
     }
 
-    sendFileList();
+    sendFileListIfChanged();
 }
 
 void FileDownloadService::sendFileList()
 {
-    LOG(DEBUG) << "FileDownloadService::sendFileList";
+    GATEWAY_LOG(DEBUG) << "FileDownloadService::sendFileList";
+
+    addToCommandBuffer([=] { sendFileListUpdate(true); });
+}
 
-    addToCommandBuffer([=] { sendFileListUpdate(); });
+void FileDownloadService::sendFileListIfChanged()
+{
+    addToCommandBuffer([=] { sendFileListUpdate(false); });
 }
 
 void FileDownloadService::sendStatus(const FileUploadStatus& response)
@@ -456,18 +570,32 @@ void FileDownloadService::sendStatus(const FileUrlDownloadStatus& response)
     m_outboundMessageHandler.addMessage(message);
 }
 
-void FileDownloadService::sendFileListUpdate()
+void FileDownloadService::sendFileListUpdate(bool rebuild)
 {
-    LOG(DEBUG) << "FileDownloadService::sendFileListUpdate";
+    GATEWAY_LOG(DEBUG) << "FileDownloadService::sendFileListUpdate";
 
-    auto fileNames = m_fileRepository.getAllFileNames();
-    if (!fileNames)
+    std::vector<std::string> fileNames;
     {
-        LOG(ERROR) << "Failed to fetch file names";
-        return;
+        std::lock_guard<std::mutex> lg{m_fileIndexLock};
+
+        if (rebuild || !m_fileIndexLoaded)
+        {
+            if (!loadFileIndex())
+            {
+                return;
+            }
+        }
+        else if (!m_fileIndexChanged)
+        {
+            GATEWAY_LOG(DEBUG) << "FileDownloadService: File list unchanged, update not sent";
+            return;
+        }
+
+        m_fileIndexChanged = false;
+        fileNames.assign(m_fileIndex.begin(), m_fileIndex.end());
     }
 
-    std::shared_ptr<Message> message = m_protocol.makeFileListUpdateMessage(m_gatewayKey, FileList{*fileNames});
+    std::shared_ptr<Message> message = m_protocol.makeFileListUpdateMessage(m_gatewayKey, FileList{fileNames});
 
     if (!message)
     {
@@ -480,16 +608,23 @@ void FileDownloadService::sendFileListUpdate()
 
 void FileDownloadService::sendFileListResponse()
 {
-    LOG(DEBUG) << "FileDownloadService::sendFileListResponse";
+    GATEWAY_LOG(DEBUG) << "FileDownloadService::sendFileListResponse";
 
-    auto fileNames = m_fileRepository.getAllFileNames();
-    if (!fileNames)
+    std::vector<std::string> fileNames;
     {
-        LOG(ERROR) << "Failed to fetch file names";
-        return;
+        std::lock_guard<std::mutex> lg{m_fileIndexLock};
+
+        // explicit request is answered from repository, which also resynchronizes the index
+        if (!loadFileIndex())
+        {
+            return;
+        }
+
+        m_fileIndexChanged = false;
+        fileNames.assign(m_fileIndex.begin(), m_fileIndex.end());
     }
 
-    std::shared_ptr<Message> message = m_protocol.makeFileListResponseMessage(m_gatewayKey, FileList{*fileNames});
+    std::shared_ptr<Message> message = m_protocol.makeFileListResponseMessage(m_gatewayKey, FileList{fileNames});
 
     if (!message)
     {
@@ -500,6 +635,43 @@ void FileDownloadService::sendFileListResponse()
     m_outboundMessageHandler.addMessage(message);
 }
 
+bool FileDownloadService::loadFileIndex()
+{
+    auto fileNames = m_fileRepository.getAllFileNames();
+    if (!fileNames)
+    {
+        LOG(ERROR) << "Failed to fetch file names";
+        return false;
+    }
+
+    m_fileIndex.clear();
+    m_fileIndex.insert(fileNames->begin(), fileNames->end());
+    m_fileIndexLoaded = true;
+    return true;
+}
+
+void FileDownloadService::storeFile(const FileInfo& info)
+{
+    m_fileRepository.store(info);
+
+    std::lock_guard<std::mutex> lg{m_fileIndexLock};
+    if (m_fileIndexLoaded && m_fileIndex.insert(info.name).second)
+    {
+        m_fileIndexChanged = true;
+    }
+}
+
+void FileDownloadService::removeFile(const std::string& fileName)
+{
+    m_fileRepository.remove(fileName);
+
+    std::lock_guard<std::mutex> lg{m_fileIndexLock};
+    if (m_fileIndexLoaded && m_fileIndex.erase(fileName) != 0)
+    {
+        m_fileIndexChanged = true;
+    }
+}
+
 void FileDownloadService::requestPacket(const FilePacketRequest& request)
 {
     std::shared_ptr<Message> message = m_protocol.makeMessage(m_gatewayKey, request);
@@ -513,34 +685,147 @@ void FileDownloadService::requestPacket(const FilePacketRequest& request)
     m_outboundMessageHandler.addMessage(message);
 }
 
+bool FileDownloadService::linkCachedFile(const std::string& fileName, const std::string& fileHash)
+{
+    auto cachedInfo = m_fileRepository.getFileInfoByHash(fileHash);
+    if (!cachedInfo || !FileSystemUtils::isFilePresent(cachedInfo->path))
+    {
+        return false;
+    }
+
+    // each file keeps its own path, content is shared through hard link instead of being transferred again
+    const auto filePath = FileSystemUtils::composePath(fileName, m_fileDownloadDirectory);
+    if (::link(cachedInfo->path.c_str(), filePath.c_str()) != 0)
+    {
+        std::ifstream source(cachedInfo->path, std::ios::binary);
+        std::ofstream destination(filePath, std::ios::binary | std::ios::trunc);
+        if (!source || !destination || !(destination << source.rdbuf()) || !destination.flush())
+        {
+            LOG(WARN) << "Failed to reuse file " << cachedInfo->name << " for file: " << fileName;
+            FileSystemUtils::deleteFile(filePath);
+            return false;
+        }
+    }
+
+    LOG(INFO) << "File " << fileName << " has same content as " << cachedInfo->name << ", skipping download";
+    storeFile(FileInfo{fileName, fileHash, filePath});
+    m_fileRepository.touch(cachedInfo->name);
+    evictFiles(fileName);
+    return true;
+}
+
+void FileDownloadService::evictFiles(const std::string& keptFileName)
+{
+    if (m_fileCacheQuota == 0)
+    {
+        return;
+    }
+
+    auto fileNames = m_fileRepository.getFileNamesByLastUse();
+    if (!fileNames)
+    {
+        return;
+    }
+
+    std::vector<std::pair<std::string, std::string>> files;
+    std::uint64_t totalSize = 0;
+    for (const auto& name : *fileNames)
+    {
+        auto info = m_fileRepository.getFileInfo(name);
+        struct stat fileStat;
+        if (!info || ::stat(info->path.c_str(), &fileStat) != 0)
+        {
+            continue;
+        }
+
+        // hard linked copies take no additional space
+        if (fileStat.st_nlink <= 1)
+        {
+            totalSize += static_cast<std::uint64_t>(fileStat.st_size);
+        }
+        else
+        {
+            totalSize += static_cast<std::uint64_t>(fileStat.st_size) / fileStat.st_nlink;
+        }
+
+        files.emplace_back(name, info->path);
+    }
+
+    for (const auto& file : files)
+    {
+        if (totalSize <= m_fileCacheQuota)
+        {
+            break;
+        }
+
+        if (file.first == keptFileName)
+        {
+            continue;
+        }
+
+        struct stat fileStat;
+        if (::stat(file.second.c_str(), &fileStat) != 0)
+        {
+            continue;
+        }
+
+        const auto links = fileStat.st_nlink <= 1 ? 1 : fileStat.st_nlink;
+        LOG(INFO) << "File cache quota exceeded, deleting least recently used file: " << file.first;
+        if (!FileSystemUtils::deleteFile(file.second))
+        {
+            LOG(ERROR) << "Failed to delete file: " << file.second;
+            continue;
+        }
+
+        removeFile(file.first);
+        totalSize -= std::min(totalSize, static_cast<std::uint64_t>(fileStat.st_size) / links);
+    }
+}
+
 void FileDownloadService::downloadCompleted(const std::string& fileName, const std::string& filePath,
                                             const std::string& fileHash)
 {
     flagCompletedDownload(fileName);
+    removeCheckpoint(fileName);
 
     addToCommandBuffer([=] {
-        m_fileRepository.store(FileInfo{fileName, fileHash, filePath});
+        storeFile(FileInfo{fileName, fileHash, filePath});
+        evictFiles(fileName);
         sendStatus(FileUploadStatus{fileName, FileTransferStatus::FILE_READY});
     });
 
-    sendFileList();
+    sendFileListIfChanged();
 }
 
 void FileDownloadService::downloadFailed(const std::string& fileName, FileTransferError errorCode)
 {
     flagCompletedDownload(fileName);
 
+    // partial file is kept only when platform stopped responding, any other failure starts over
+    if (errorCode != FileTransferError::RETRY_COUNT_EXCEEDED)
+    {
+        removeCheckpoint(fileName);
+    }
+
     sendStatus(FileUploadStatus{fileName, errorCode});
 
-    sendFileList();
+    sendFileListIfChanged();
+}
+
+void FileDownloadService::removeCheckpoint(const std::string& fileName)
+{
+    if (m_fileTransferCheckpointRepository)
+    {
+        m_fileTransferCheckpointRepository->remove(fileName);
+    }
 }
 
 void FileDownloadService::urlDownloadCompleted(const std::string& fileUrl, const std::string& fileName,
                                                const std::string& filePath)
 {
     addToCommandBuffer([=] {
-        ByteArray fileContent;
-        if (!FileSystemUtils::readBinaryFileContent(filePath, fileContent))
+        ByteArray byteHash;
+        if (!Sha256::hashFile(filePath, byteHash))
         {
             LOG(ERROR) << "Failed to open downloaded file: " << filePath;
             FileSystemUtils::deleteFile(filePath);
@@ -548,26 +833,27 @@ void FileDownloadService::urlDownloadCompleted(const std::string& fileUrl, const
             return;
         }
 
-        auto byteHash = ByteUtils::hashSHA256(fileContent);
         auto hashStr = StringUtils::base64Encode(byteHash);
 
-        m_fileRepository.store(FileInfo{fileName, hashStr, filePath});
+        storeFile(FileInfo{fileName, hashStr, filePath});
+        evictFiles(fileName);
         sendStatus(FileUrlDownloadStatus{fileUrl, fileName});
     });
 
-    sendFileList();
+    sendFileListIfChanged();
 }
 
 void FileDownloadService::urlDownloadFailed(const std::string& fileUrl, FileTransferError errorCode)
 {
     sendStatus(FileUrlDownloadStatus{fileUrl, errorCode});
 
-    sendFileList();
+    sendFileListIfChanged();
 }
 
 void FileDownloadService::addToCommandBuffer(std::function<void()> command)
 {
-    m_commandBuffer.pushCommand(std::make_shared<std::function<void()>>(command));
+    auto tracked = CommandWatchdog::getInstance().track("file_download", "", std::move(command));
+    m_commandBuffer.pushCommand(std::make_shared<std::function<void()>>(std::move(tracked)));
 }
 
 void FileDownloadService::flagCompletedDownload(const std::string& key)
@@ -575,47 +861,42 @@ void FileDownloadService::flagCompletedDownload(const std::string& key)
     std::lock_guard<decltype(m_mutex)> lg{m_mutex};
 
     auto it = m_activeDownloads.find(key);
-    if (it != m_activeDownloads.end())
+    if (it != m_activeDownloads.end() && !it->second->completed)
     {
-        std::get<FLAG_INDEX>(it->second) = true;
-    }
+        it->second->completed = true;
 
-    notifyCleanup();
-}
+        // packets still arriving for the transfer are dropped, and its id can be given to a queued download
+        std::atomic_store(&m_transfers[it->second->id], std::shared_ptr<Transfer>{});
+        m_packetScheduler.close(it->second->id);
+    }
 
-void FileDownloadService::notifyCleanup()
-{
-    m_condition.notify_one();
+    // downloader invokes this from its own callback, so it is removed from another thread
+    if (m_run && m_cleanupTask == 0)
+    {
+        m_cleanupTask = m_executor.post([=] { clearDownloads(); });
+    }
 }
 
 void FileDownloadService::clearDownloads()
 {
-    while (m_run)
-    {
-        std::unique_lock<decltype(m_mutex)> lg{m_mutex};
+    std::lock_guard<decltype(m_mutex)> lg{m_mutex};
 
-        for (auto it = m_activeDownloads.begin(); it != m_activeDownloads.end();)
+    for (auto it = m_activeDownloads.begin(); it != m_activeDownloads.end();)
+    {
+        if (it->second->completed)
         {
-            auto& tuple = it->second;
-            auto& downloadCompleted = std::get<FLAG_INDEX>(tuple);
-
-            if (downloadCompleted)
-            {
-                LOG(DEBUG) << "Removing completed download on channel: " << it->first;
-                // removed flagged messages
-                it = m_activeDownloads.erase(it);
-            }
-            else
-            {
-                ++it;
-            }
+            GATEWAY_LOG(DEBUG) << "Removing completed download on channel: " << it->first;
+            // removed flagged messages
+            it = m_activeDownloads.erase(it);
+        }
+        else
+        {
+            ++it;
         }
+    }
 
-        lg.unlock();
+    m_cleanupTask = 0;
 
-        static std::mutex cvMutex;
-        std::unique_lock<std::mutex> lock{cvMutex};
-        m_condition.wait(lock);
-    }
+    startQueuedDownloads();
 }
 }    // namespace wolkabout
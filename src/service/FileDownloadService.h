@@ -20,27 +20,36 @@
 #include "GatewayInboundPlatformMessageHandler.h"
 #include "WolkaboutFileDownloader.h"
 #include "service/FileDownloader.h"
+#include "service/FilePacketScheduler.h"
 #include "utilities/ByteUtils.h"
 #include "utilities/CommandBuffer.h"
+#include "utilities/Executor.h"
 
 #include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
 #include <map>
 #include <memory>
 #include <model/FileDelete.h>
 #include <model/FileUploadAbort.h>
 #include <model/FileUploadInitiate.h>
 #include <mutex>
+#include <set>
 #include <string>
-#include <thread>
-#include <tuple>
+#include <utility>
+#include <vector>
 
 namespace wolkabout
 {
+class BandwidthScheduler;
 class BinaryData;
 class JsonDownloadProtocol;
 class FileDelete;
 class FileRepository;
+struct FileInfo;
+class FileTransferCheckpointRepository;
 class FileUploadAbort;
 class FileUploadInitiate;
 class FileUploadStatus;
@@ -55,7 +64,12 @@ class FileDownloadService : public PlatformMessageListener
 public:
     FileDownloadService(std::string gatewayKey, JsonDownloadProtocol& protocol, std::string fileDownloadDirectory,
                         OutboundMessageHandler& outboundMessageHandler, FileRepository& fileRepository,
-                        std::shared_ptr<UrlFileDownloader> urlFileDownloader = nullptr);
+                        Executor& executor, std::shared_ptr<UrlFileDownloader> urlFileDownloader = nullptr,
+                        unsigned packetRequestWindow = 1,
+                        FileTransferCheckpointRepository* fileTransferCheckpointRepository = nullptr,
+                        std::uint64_t fileCacheQuota = 0,
+                        std::shared_ptr<BandwidthScheduler> bandwidthScheduler = nullptr,
+                        std::size_t maxConcurrentTransfers = 1);
 
     ~FileDownloadService();
 
@@ -66,8 +80,21 @@ public:
 
     const Protocol& getProtocol() const override;
 
+    /**
+     * @brief Publishes complete list of files, read from file repository
+     * Changes made by this service after that are published only if they change the list
+     */
     virtual void sendFileList();
 
+    /**
+     * @brief Must be called before files are downloaded
+     * @param maxPacketSize Maximum size of single file packet requested from platform
+     * @param packetRequestTimeout Time after which packet which did not arrive is requested again
+     */
+    void setPacketLimits(std::uint64_t maxPacketSize, std::chrono::milliseconds packetRequestTimeout);
+
+    static const constexpr std::uint64_t DEFAULT_MAX_PACKET_SIZE = 10 * 1024 * 1024;    // 10MB
+
 private:
     void handle(const BinaryData& binaryData);
     void handle(const FileUploadInitiate& request);
@@ -77,6 +104,9 @@ private:
     void handle(const FileUrlDownloadAbort& request);
 
     void download(const std::string& fileName, std::uint64_t fileSize, const std::string& fileHash);
+    void startDownload(FilePacketScheduler::TransferId id, const std::string& fileName, std::uint64_t fileSize,
+                       const std::string& fileHash);
+    void startQueuedDownloads();
     void urlDownload(const std::string& fileUrl);
     void abortDownload(const std::string& fileName);
     void abortUrlDownload(const std::string& fileUrl);
@@ -85,12 +115,20 @@ private:
 
     void sendStatus(const FileUploadStatus& response);
     void sendStatus(const FileUrlDownloadStatus& response);
-    void sendFileListUpdate();
+    void sendFileListUpdate(bool rebuild);
     void sendFileListResponse();
+    void sendFileListIfChanged();
+    bool loadFileIndex();
+    void storeFile(const FileInfo& info);
+    void removeFile(const std::string& fileName);
 
     void requestPacket(const FilePacketRequest& request);
+    bool linkCachedFile(const std::string& fileName, const std::string& fileHash);
+    void evictFiles(const std::string& keptFileName);
+
     void downloadCompleted(const std::string& fileName, const std::string& filePath, const std::string& fileHash);
     void downloadFailed(const std::string& fileName, FileTransferError errorCode);
+    void removeCheckpoint(const std::string& fileName);
 
     void urlDownloadCompleted(const std::string& fileUrl, const std::string& fileName, const std::string& filePath);
     void urlDownloadFailed(const std::string& fileUrl, FileTransferError errorCode);
@@ -99,7 +137,6 @@ private:
 
     void flagCompletedDownload(const std::string& key);
     void clearDownloads();
-    void notifyCleanup();
 
     const std::string m_gatewayKey;
     const std::string m_fileDownloadDirectory;
@@ -108,21 +145,68 @@ private:
 
     OutboundMessageHandler& m_outboundMessageHandler;
     FileRepository& m_fileRepository;
+    Executor& m_executor;
 
     std::shared_ptr<UrlFileDownloader> m_urlFileDownloader;
 
-    // temporary to disallow simultaneous downloads
-    std::string m_activeDownload;
-    std::map<std::string, std::tuple<std::string, std::unique_ptr<FileDownloader>, bool>> m_activeDownloads;
+    const unsigned m_packetRequestWindow;
+    std::uint64_t m_maxPacketSize;
+    std::chrono::milliseconds m_packetRequestTimeout;
+
+    // interrupted transfers are resumed from their last checkpoint when set
+    FileTransferCheckpointRepository* m_fileTransferCheckpointRepository;
+
+    // least recently used files are deleted when downloaded files exceed quota, 0 when unlimited
+    const std::uint64_t m_fileCacheQuota;
+
+    // file packets are requested at the rate telemetry leaves over when set
+    std::shared_ptr<BandwidthScheduler> m_bandwidthScheduler;
+
+    // names of files in repository, kept up to date by this service so list updates need no query
+    std::set<std::string> m_fileIndex;
+    bool m_fileIndexLoaded;
+    bool m_fileIndexChanged;
+    std::mutex m_fileIndexLock;
+
+    struct Transfer
+    {
+        Transfer(FilePacketScheduler::TransferId transferId, std::string hash)
+        : id{transferId}, fileHash{std::move(hash)}, completed{false}
+        {
+        }
+
+        const FilePacketScheduler::TransferId id;
+        const std::string fileHash;
+
+        // serializes packets and abort of this transfer only
+        std::mutex mutex;
+        std::unique_ptr<FileDownloader> downloader;
+
+        bool completed;
+    };
+
+    struct QueuedDownload
+    {
+        std::string fileName;
+        std::uint64_t fileSize;
+        std::string fileHash;
+    };
+
+    // guarded by m_mutex
+    std::map<std::string, std::shared_ptr<Transfer>> m_activeDownloads;
+    // downloads waiting for one of concurrent transfers to finish, guarded by m_mutex
+    std::deque<QueuedDownload> m_queuedDownloads;
+
+    FilePacketScheduler m_packetScheduler;
+    // indexed by transfer id, fixed size so binary packets are routed with std::atomic_load instead of m_mutex
+    std::vector<std::shared_ptr<Transfer>> m_transfers;
 
     std::atomic_bool m_run;
-    std::condition_variable m_condition;
     std::recursive_mutex m_mutex;
-    std::thread m_garbageCollector;
+    // pending removal of completed downloads, 0 when none is scheduled
+    Executor::TaskId m_cleanupTask;
 
     CommandBuffer m_commandBuffer;
-
-    static const constexpr std::uint64_t MAX_PACKET_SIZE = 10 * 1024 * 1024;    // 10MB
 };
 }    // namespace wolkabout
 
@@ -17,25 +17,62 @@
 #include "service/FileDownloader.h"
 #include "model/BinaryData.h"
 #include "model/FilePacketRequest.h"
+#include "utilities/BandwidthScheduler.h"
+#include "utilities/CommandWatchdog.h"
+#include "utilities/Executor.h"
 #include "utilities/FileSystemUtils.h"
 #include "utilities/Logger.h"
+#include "utilities/Sha256.h"
 
 #include <cmath>
+#include <cstddef>
+
+namespace
+{
+bool hashValid(const wolkabout::BinaryData& binaryData)
+{
+    // same check as BinaryData::valid, through OpenSSL so hardware SHA-256 is used where available
+    return wolkabout::Sha256::hash(binaryData.getData()) == binaryData.getHash();
+}
+}    // namespace
 
 namespace wolkabout
 {
-const constexpr std::chrono::milliseconds FileDownloader::PACKET_REQUEST_TIMEOUT;
+const constexpr std::chrono::milliseconds FileDownloader::DEFAULT_PACKET_REQUEST_TIMEOUT;
+const constexpr char FileDownloader::TEMPORARY_FILE_SUFFIX[];
 
-FileDownloader::FileDownloader(std::uint64_t maxPacketSize) : m_maxPacketSize{maxPacketSize} {}
+FileDownloader::FileDownloader(std::uint64_t maxPacketSize, unsigned windowSize,
+                               std::shared_ptr<BandwidthScheduler> bandwidthScheduler,
+                               std::chrono::milliseconds packetRequestTimeout, Executor* verificationExecutor)
+: m_maxPacketSize{maxPacketSize}
+, m_windowSize{windowSize != 0 ? windowSize : 1}
+, m_bandwidthScheduler{std::move(bandwidthScheduler)}
+, m_packetRequestTimeout{packetRequestTimeout}
+, m_verificationExecutor{verificationExecutor}
+, m_verificationGuard{std::make_shared<VerificationGuard>()}
+, m_generation{0}
+{
+    clear();
+}
+
+FileDownloader::~FileDownloader()
+{
+    // waits for verification that is handing its result over right now
+    std::lock_guard<decltype(m_verificationGuard->mutex)> l{m_verificationGuard->mutex};
+    m_verificationGuard->alive = false;
+}
 
 void FileDownloader::download(const std::string& fileName, std::uint64_t fileSize, const ByteArray& fileHash,
                               const std::string& downloadDirectory,
                               std::function<void(const FilePacketRequest&)> packetProvider,
                               std::function<void(const std::string& filePath)> onSuccessCallback,
-                              std::function<void(FileTransferError errorCode)> onFailCallback)
+                              std::function<void(FileTransferError errorCode)> onFailCallback,
+                              std::function<void(const FileTransferCheckpoint&)> onCheckpointCallback,
+                              std::shared_ptr<FileTransferCheckpoint> resumeFrom)
 {
     addToCommandBuffer([=] {
         m_timer.stop();
+        m_throttleTimer.stop();
         clear();
 
         if (fileSize <= m_maxPacketSize - (2 * ByteUtils::SHA_256_HASH_BYTE_LENGTH))
@@ -58,149 +95,347 @@ void FileDownloader::download(const std::string& fileName, std::uint64_t fileSiz
         m_packetProvider = packetProvider;
         m_currentOnSuccessCallback = onSuccessCallback;
         m_currentOnFailCallback = onFailCallback;
+        m_currentOnCheckpointCallback = onCheckpointCallback;
 
-        requestPacket(m_currentPacketIndex, m_currentPacketSize);
+        // packets go straight to disk, so file size is not limited by available memory
+        const auto temporaryFilePath =
+          FileSystemUtils::composePath(fileName + TEMPORARY_FILE_SUFFIX, downloadDirectory);
+        if ((!resumeFrom || !resume(*resumeFrom, temporaryFilePath)) &&
+            m_fileHandler.streamTo(temporaryFilePath) != FileHandler::StatusCode::OK)
+        {
+            fail(FileTransferError::FILE_SYSTEM_ERROR);
+            return;
+        }
+
+        m_retryCount = 1;
+        requestPackets();
     });
 }
 
 void FileDownloader::handleData(const BinaryData& binaryData)
 {
     addToCommandBuffer([=] {
-        m_timer.stop();
+        if (m_currentPacketCount == 0)
+        {
+            // no download in progress, packet requested before abort
+            return;
+        }
 
-        const auto result = m_fileHandler.handleData(binaryData);
-        switch (result)
+        if (!m_verificationExecutor)
         {
-        case FileHandler::StatusCode::OK:
+            packetVerified(binaryData, hashValid(binaryData));
+            return;
+        }
+
+        // next packets are requested while this one is hashed, so the link does not idle on verification
+        ++m_unverifiedCount;
+        requestPackets();
+
+        verifyPacket(binaryData);
+    });
+}
+
+void FileDownloader::abort()
+{
+    addToCommandBuffer([=] {
+        m_timer.stop();
+        m_throttleTimer.stop();
+        clear();
+    });
+}
+
+void FileDownloader::addToCommandBuffer(std::function<void()> command)
+{
+    auto tracked = CommandWatchdog::getInstance().track("file_downloader", "", std::move(command));
+    m_commandBuffer.pushCommand(std::make_shared<std::function<void()>>(std::move(tracked)));
+}
+
+void FileDownloader::requestPacket(unsigned index, std::uint64_t size)
+{
+    m_packetProvider(FilePacketRequest{m_currentFileName, index, size});
+}
+
+void FileDownloader::requestPackets()
+{
+    m_throttleTimer.stop();
+
+    const auto windowSize =
+      m_bandwidthScheduler ? m_bandwidthScheduler->bulkWindow(m_currentPacketSize, m_windowSize) : m_windowSize;
+
+    bool requested = false;
+    while (m_nextRequestIndex < m_currentPacketCount &&
+           m_nextRequestIndex < m_currentPacketIndex + m_unverifiedCount + windowSize)
+    {
+        if (m_bandwidthScheduler)
         {
-            if (++m_currentPacketIndex == m_currentPacketCount)
+            const auto delay = m_bandwidthScheduler->reserveBulk(m_currentPacketSize);
+            if (delay.count() != 0)
             {
-                // download complete
-                const auto validationResult = m_fileHandler.validateFile(m_currentFileHash);
-                switch (validationResult)
-                {
-                case FileHandler::StatusCode::OK:
-                {
-                    const auto filePath = FileSystemUtils::composePath(m_currentFileName, m_currentDownloadDirectory);
-                    const auto saveResult = m_fileHandler.saveFile(m_currentFileName, m_currentDownloadDirectory);
-                    switch (saveResult)
-                    {
-                    case FileHandler::StatusCode::OK:
-                    {
-                        if (m_currentOnSuccessCallback)
+                m_throttleTimer.start(delay, [=] {
+                    addToCommandBuffer([=] {
+                        if (m_currentPacketCount != 0)
                         {
-                            const auto abosolutePath = FileSystemUtils::absolutePath(filePath);
-                            m_currentOnSuccessCallback(abosolutePath);
+                            requestPackets();
                         }
+                    });
+                });
+                break;
+            }
+        }
 
-                        clear();
-                        return;
-                    }
-                    case FileHandler::StatusCode::FILE_HANDLING_ERROR:
-                    {
-                        if (m_currentOnFailCallback)
-                        {
-                            m_currentOnFailCallback(FileTransferError::FILE_SYSTEM_ERROR);
-                        }
+        requestPacket(m_nextRequestIndex++, m_currentPacketSize);
+        requested = true;
+    }
 
-                        clear();
-                        return;
-                    }
-                    default:
-                    {
-                        if (m_currentOnFailCallback)
-                        {
-                            m_currentOnFailCallback(FileTransferError::UNSPECIFIED_ERROR);
-                        }
+    // timeout covers requests in flight, throttled requests are not yet waiting for the platform
+    if (m_nextRequestIndex == m_currentPacketIndex || (!requested && m_timer.running()))
+    {
+        return;
+    }
 
-                        clear();
-                        return;
-                    }
-                    }
-                }
-                case FileHandler::StatusCode::FILE_HASH_NOT_VALID:
-                default:
-                {
-                    if (m_currentOnFailCallback)
-                    {
-                        m_currentOnFailCallback(FileTransferError::UNSPECIFIED_ERROR);
-                    }
-
-                    clear();
-                    return;
-                }
-                }
-            }
-            else
+    m_timer.start(m_packetRequestTimeout, [=] { addToCommandBuffer([=] { packetFailed(); }); });
+}
+
+void FileDownloader::verifyPacket(const BinaryData& binaryData)
+{
+    const auto guard = m_verificationGuard;
+    const auto generation = m_generation;
+
+    m_verificationExecutor->post([=] {
+        const bool valid = hashValid(binaryData);
+
+        std::lock_guard<decltype(guard->mutex)> l{guard->mutex};
+        if (!guard->alive)
+        {
+            return;
+        }
+
+        addToCommandBuffer([=] {
+            if (generation != m_generation)
             {
-                m_retryCount = 0;
-                requestPacket(m_currentPacketIndex, m_currentPacketSize);
+                // download was aborted or restarted meanwhile
+                return;
             }
 
-            break;
-        }
-        case FileHandler::StatusCode::PACKAGE_HASH_NOT_VALID:
-        {
-            packetFailed();
+            --m_unverifiedCount;
+            packetVerified(binaryData, valid);
+        });
+    });
+}
 
-            break;
-        }
-        case FileHandler::StatusCode::PREVIOUS_PACKAGE_HASH_NOT_VALID:
+void FileDownloader::packetVerified(const BinaryData& binaryData, bool valid)
+{
+    if (!valid)
+    {
+        m_timer.stop();
+        packetFailed();
+        return;
+    }
+
+    if (!consumePacket(binaryData))
+    {
+        // with verification offloaded, packet checked first may be ahead of one still being checked
+        if (m_windowSize == 1 && m_unverifiedCount == 0)
         {
+            m_timer.stop();
             packetFailed();
+            return;
+        }
 
-            break;
+        // arrived ahead of the expected packet, or is a late duplicate of an already written one
+        if (m_pendingPackets.size() >= m_windowSize + m_unverifiedCount)
+        {
+            m_pendingPackets.erase(m_pendingPackets.begin());
         }
-        default:
+
+        m_pendingPackets.push_back(binaryData);
+        return;
+    }
+
+    // packets held back may now continue the chain
+    bool consumed = true;
+    while (consumed && m_currentPacketCount != 0 && m_currentPacketIndex != m_currentPacketCount)
+    {
+        consumed = false;
+        for (std::size_t i = 0; i < m_pendingPackets.size() && m_currentPacketCount != 0; ++i)
         {
-            if (m_currentOnFailCallback)
+            // copied, since failure clears pending packets
+            const auto packet = m_pendingPackets[i];
+            if (consumePacket(packet))
             {
-                m_currentOnFailCallback(FileTransferError::UNSPECIFIED_ERROR);
+                m_pendingPackets.erase(m_pendingPackets.begin() + static_cast<std::ptrdiff_t>(i));
+                consumed = true;
+                break;
             }
-
-            clear();
-            return;
         }
-        }
-    });
+    }
+
+    if (m_currentPacketCount == 0)
+    {
+        // failed while writing packet
+        return;
+    }
+
+    m_timer.stop();
+
+    if (m_currentPacketIndex == m_currentPacketCount)
+    {
+        completeDownload();
+        return;
+    }
+
+    checkpoint();
+
+    m_retryCount = 1;
+    requestPackets();
 }
 
-void FileDownloader::abort()
+bool FileDownloader::resume(const FileTransferCheckpoint& checkpoint, const std::string& temporaryFilePath)
 {
-    addToCommandBuffer([=] {
+    const auto packetDataSize = m_currentPacketSize - (2 * ByteUtils::SHA_256_HASH_BYTE_LENGTH);
+    if (checkpoint.name != m_currentFileName || checkpoint.hash != m_currentFileHash ||
+        checkpoint.packetIndex == 0 || checkpoint.packetIndex >= m_currentPacketCount ||
+        checkpoint.offset != checkpoint.packetIndex * packetDataSize)
+    {
+        LOG(INFO) << "FileDownloader: Checkpoint does not match file " << m_currentFileName;
+        return false;
+    }
+
+    if (m_fileHandler.resume(temporaryFilePath, checkpoint.offset, checkpoint.previousPacketHash) !=
+        FileHandler::StatusCode::OK)
+    {
+        return false;
+    }
+
+    LOG(INFO) << "FileDownloader: Resuming download of file " << m_currentFileName << " from packet "
+              << checkpoint.packetIndex;
+
+    m_currentPacketIndex = checkpoint.packetIndex;
+    m_nextRequestIndex = checkpoint.packetIndex;
+    return true;
+}
+
+void FileDownloader::checkpoint()
+{
+    if (!m_currentOnCheckpointCallback)
+    {
+        return;
+    }
+
+    // checkpoint must never point past data that is actually on disk
+    if (m_fileHandler.sync() != FileHandler::StatusCode::OK)
+    {
+        return;
+    }
+
+    m_currentOnCheckpointCallback(FileTransferCheckpoint{m_currentFileName, m_currentFileHash, m_currentPacketIndex,
+                                                         m_fileHandler.getPreviousPacketHash(),
+                                                         m_fileHandler.getWrittenSize()});
+}
+
+bool FileDownloader::consumePacket(const BinaryData& binaryData)
+{
+    // packet hash is checked before packet is consumed
+    const auto result = m_fileHandler.handleData(binaryData, true);
+    switch (result)
+    {
+    case FileHandler::StatusCode::OK:
+    {
+        ++m_currentPacketIndex;
+        return true;
+    }
+    case FileHandler::StatusCode::PACKAGE_HASH_NOT_VALID:
+    case FileHandler::StatusCode::PREVIOUS_PACKAGE_HASH_NOT_VALID:
+    {
+        return false;
+    }
+    case FileHandler::StatusCode::FILE_HANDLING_ERROR:
+    {
         m_timer.stop();
-        clear();
-    });
+        fail(FileTransferError::FILE_SYSTEM_ERROR);
+        return false;
+    }
+    default:
+    {
+        m_timer.stop();
+        fail(FileTransferError::UNSPECIFIED_ERROR);
+        return false;
+    }
+    }
 }
 
-void FileDownloader::addToCommandBuffer(std::function<void()> command)
+void FileDownloader::completeDownload()
 {
-    m_commandBuffer.pushCommand(std::make_shared<std::function<void()>>(command));
+    const auto validationResult = m_fileHandler.validateFile(m_currentFileHash);
+    if (validationResult != FileHandler::StatusCode::OK)
+    {
+        fail(FileTransferError::UNSPECIFIED_ERROR);
+        return;
+    }
+
+    const auto filePath = FileSystemUtils::composePath(m_currentFileName, m_currentDownloadDirectory);
+    const auto saveResult = m_fileHandler.saveFile(m_currentFileName, m_currentDownloadDirectory);
+    switch (saveResult)
+    {
+    case FileHandler::StatusCode::OK:
+    {
+        if (m_currentOnSuccessCallback)
+        {
+            const auto abosolutePath = FileSystemUtils::absolutePath(filePath);
+            m_currentOnSuccessCallback(abosolutePath);
+        }
+
+        clear();
+        return;
+    }
+    case FileHandler::StatusCode::FILE_HANDLING_ERROR:
+    {
+        fail(FileTransferError::FILE_SYSTEM_ERROR);
+        return;
+    }
+    default:
+    {
+        fail(FileTransferError::UNSPECIFIED_ERROR);
+        return;
+    }
+    }
 }
 
-void FileDownloader::requestPacket(unsigned index, std::uint_fast64_t size)
+void FileDownloader::fail(FileTransferError errorCode)
 {
-    ++m_retryCount;
+    if (errorCode == FileTransferError::RETRY_COUNT_EXCEEDED && m_currentOnCheckpointCallback)
+    {
+        // written packets are covered by last checkpoint, keep them for the next attempt
+        m_fileHandler.detach();
+    }
 
-    m_packetProvider(FilePacketRequest{m_currentFileName, index, size});
+    if (m_currentOnFailCallback)
+    {
+        m_currentOnFailCallback(errorCode);
+    }
 
-    m_timer.start(PACKET_REQUEST_TIMEOUT, [=] { packetFailed(); });
+    clear();
 }
 
 void FileDownloader::packetFailed()
 {
-    if (m_retryCount == FileDownloader::MAX_RETRY_COUNT)
+    if (m_currentPacketCount == 0)
     {
-        if (m_currentOnFailCallback)
-        {
-            m_currentOnFailCallback(FileTransferError::RETRY_COUNT_EXCEEDED);
-        }
-        clear();
+        return;
     }
-    else
+
+    if (m_retryCount == FileDownloader::MAX_RETRY_COUNT)
     {
-        requestPacket(m_currentPacketIndex, m_currentPacketSize);
+        fail(FileTransferError::RETRY_COUNT_EXCEEDED);
+        return;
     }
+
+    ++m_retryCount;
+
+    // request the whole window again, starting from the first packet not yet written
+    m_nextRequestIndex = m_currentPacketIndex;
+    m_pendingPackets.clear();
+    requestPackets();
 }
 
 void FileDownloader::clear()
@@ -211,6 +446,10 @@ void FileDownloader::clear()
 
     m_currentPacketCount = 0;
     m_currentPacketIndex = 0;
+    m_nextRequestIndex = 0;
+    m_unverifiedCount = 0;
+    ++m_generation;
+    m_pendingPackets.clear();
 
     m_currentFileHash = {};
     m_currentDownloadDirectory = "";
@@ -218,6 +457,7 @@ void FileDownloader::clear()
     m_packetProvider = nullptr;
     m_currentOnSuccessCallback = nullptr;
     m_currentOnFailCallback = nullptr;
+    m_currentOnCheckpointCallback = nullptr;
 
     m_retryCount = 0;
     m_fileHandler.clear();
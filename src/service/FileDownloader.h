@@ -17,7 +17,9 @@
 #define FILEDOWNLOADER_H
 
 #include "FileHandler.h"
+#include "model/BinaryData.h"
 #include "model/FileTransferStatus.h"
+#include "repository/FileTransferCheckpoint.h"
 #include "utilities/ByteUtils.h"
 #include "utilities/CommandBuffer.h"
 #include "utilities/Timer.h"
@@ -25,60 +27,125 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace wolkabout
 {
-class BinaryData;
+class BandwidthScheduler;
+class Executor;
 class FilePacketRequest;
 
 class FileDownloader
 {
 public:
-    FileDownloader(std::uint64_t maxPacketSize);
-
+    /**
+     * @param maxPacketSize Maximum size of single packet
+     * @param windowSize Number of packet requests kept in flight. Packets arriving out of order are
+     * held back until the chain of previous packet hashes reaches them
+     * @param bandwidthScheduler When set, packets are requested only as fast as bandwidth left over by telemetry
+     * allows, and window shrinks while link is busy
+     * @param packetRequestTimeout Time after which packet which did not arrive is requested again
+     * @param verificationExecutor When set, packet hashes are checked on its workers instead of on the downloader's
+     * command buffer, and packets which arrived but are still being checked do not hold back further requests
+     */
+    FileDownloader(std::uint64_t maxPacketSize, unsigned windowSize = 1,
+                   std::shared_ptr<BandwidthScheduler> bandwidthScheduler = nullptr,
+                   std::chrono::milliseconds packetRequestTimeout = DEFAULT_PACKET_REQUEST_TIMEOUT,
+                   Executor* verificationExecutor = nullptr);
+
+    ~FileDownloader();
+
+    FileDownloader(const FileDownloader&) = delete;
+    FileDownloader& operator=(const FileDownloader&) = delete;
+
+    /**
+     * @param onCheckpointCallback Called with progress each time packets are written to disk. When set,
+     * partial file is kept if download fails with RETRY_COUNT_EXCEEDED, so that it can be resumed
+     * @param resumeFrom Checkpoint of previous attempt of the same download. Ignored if it does not match
+     * the file, in which case download starts from the first packet
+     */
     void download(const std::string& fileName, std::uint64_t fileSize, const ByteArray& fileHash,
                   const std::string& downloadDirectory, std::function<void(const FilePacketRequest&)> packetProvider,
                   std::function<void(const std::string& filePath)> onSuccessCallback,
-                  std::function<void(FileTransferError errorCode)> onFailCallback);
+                  std::function<void(FileTransferError errorCode)> onFailCallback,
+                  std::function<void(const FileTransferCheckpoint&)> onCheckpointCallback = nullptr,
+                  std::shared_ptr<FileTransferCheckpoint> resumeFrom = nullptr);
 
     void handleData(const BinaryData& binaryData);
 
     void abort();
 
+    static const constexpr std::chrono::milliseconds DEFAULT_PACKET_REQUEST_TIMEOUT{6000};
+
 private:
     void addToCommandBuffer(std::function<void()> command);
 
     void requestPacket(unsigned index, std::uint64_t size);
+    void requestPackets();
+
+    bool resume(const FileTransferCheckpoint& checkpoint, const std::string& temporaryFilePath);
+    void checkpoint();
+
+    void verifyPacket(const BinaryData& binaryData);
+    void packetVerified(const BinaryData& binaryData, bool valid);
+
+    bool consumePacket(const BinaryData& binaryData);
+    void completeDownload();
+    void fail(FileTransferError errorCode);
 
     void packetFailed();
 
     void clear();
 
     const std::uint64_t m_maxPacketSize;
+    const unsigned m_windowSize;
+    std::shared_ptr<BandwidthScheduler> m_bandwidthScheduler;
+    const std::chrono::milliseconds m_packetRequestTimeout;
+    Executor* const m_verificationExecutor;
+
+    // lets verification still running on executor find out that downloader is gone
+    struct VerificationGuard
+    {
+        std::mutex mutex;
+        bool alive = true;
+    };
+    std::shared_ptr<VerificationGuard> m_verificationGuard;
 
     FileHandler m_fileHandler;
 
     Timer m_timer;
+    // delays packet requests for which there is no bandwidth yet
+    Timer m_throttleTimer;
 
     std::string m_currentFileName;
     std::uint64_t m_currentFileSize;
     std::uint64_t m_currentPacketSize;
     unsigned m_currentPacketCount;
     unsigned m_currentPacketIndex;
+    unsigned m_nextRequestIndex;
+    // packets which arrived and are being verified on executor
+    unsigned m_unverifiedCount;
+    // changes with each clear, so verification results of previous download are dropped
+    std::uint64_t m_generation;
+    // valid packets which arrived ahead of the one expected next
+    std::vector<BinaryData> m_pendingPackets;
     ByteArray m_currentFileHash;
     std::string m_currentDownloadDirectory;
 
     std::function<void(const FilePacketRequest&)> m_packetProvider;
     std::function<void(const std::string&)> m_currentOnSuccessCallback;
     std::function<void(FileTransferError)> m_currentOnFailCallback;
+    std::function<void(const FileTransferCheckpoint&)> m_currentOnCheckpointCallback;
 
     unsigned short m_retryCount;
 
     CommandBuffer m_commandBuffer;
 
     static const unsigned short MAX_RETRY_COUNT = 3;
-    static const constexpr std::chrono::milliseconds PACKET_REQUEST_TIMEOUT{6000};
+    static const constexpr char TEMPORARY_FILE_SUFFIX[] = ".part";
 };
 }    // namespace wolkabout
 
@@ -0,0 +1,208 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "service/FilePacketScheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace wolkabout
+{
+constexpr FilePacketScheduler::TransferId FilePacketScheduler::INVALID_TRANSFER;
+
+FilePacketScheduler::FilePacketScheduler(std::size_t maxTransfers, std::function<void(const FilePacketRequest&)> send)
+: m_send{std::move(send)}, m_transfers(maxTransfers == 0 ? 1 : maxTransfers), m_holder{INVALID_TRANSFER}
+{
+}
+
+FilePacketScheduler::TransferId FilePacketScheduler::open()
+{
+    std::lock_guard<std::mutex> guard{m_mutex};
+
+    for (std::size_t i = 0; i < m_transfers.size(); ++i)
+    {
+        if (!m_transfers[i].open)
+        {
+            m_transfers[i].open = true;
+            return static_cast<TransferId>(i);
+        }
+    }
+
+    return INVALID_TRANSFER;
+}
+
+void FilePacketScheduler::close(TransferId id)
+{
+    std::vector<FilePacketRequest> requests;
+
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+
+        if (id >= m_transfers.size())
+        {
+            return;
+        }
+
+        m_transfers[id] = Transfer{};
+        if (m_holder == id)
+        {
+            passChannel(requests);
+        }
+    }
+
+    for (const FilePacketRequest& request : requests)
+    {
+        m_send(request);
+    }
+}
+
+void FilePacketScheduler::request(TransferId id, const FilePacketRequest& request)
+{
+    std::vector<FilePacketRequest> requests;
+
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+
+        if (id >= m_transfers.size() || !m_transfers[id].open)
+        {
+            return;
+        }
+
+        Transfer& transfer = m_transfers[id];
+        const unsigned index = request.getChunkIndex();
+
+        if (m_holder == INVALID_TRANSFER)
+        {
+            m_holder = id;
+        }
+
+        if (m_holder == id &&
+            std::find(transfer.inFlight.begin(), transfer.inFlight.end(), index) != transfer.inFlight.end())
+        {
+            // packet which did not arrive in time is requested again, it already counts as in flight
+            requests.push_back(request);
+        }
+        else if (m_holder == id && !othersWaiting(id))
+        {
+            transfer.inFlight.push_back(index);
+            requests.push_back(request);
+        }
+        else
+        {
+            auto queued = std::find_if(transfer.queued.begin(), transfer.queued.end(),
+                                       [&](const FilePacketRequest& other) { return other.getChunkIndex() == index; });
+            if (queued != transfer.queued.end())
+            {
+                *queued = request;
+            }
+            else
+            {
+                transfer.queued.push_back(request);
+            }
+
+            // idle holder does not receive anything that would pass the channel on
+            if (m_transfers[m_holder].inFlight.empty())
+            {
+                passChannel(requests);
+            }
+        }
+    }
+
+    for (const FilePacketRequest& packetRequest : requests)
+    {
+        m_send(packetRequest);
+    }
+}
+
+FilePacketScheduler::TransferId FilePacketScheduler::received()
+{
+    std::vector<FilePacketRequest> requests;
+    TransferId id = INVALID_TRANSFER;
+
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+
+        if (m_holder == INVALID_TRANSFER || m_transfers[m_holder].inFlight.empty())
+        {
+            return INVALID_TRANSFER;
+        }
+
+        id = m_holder;
+
+        Transfer& transfer = m_transfers[id];
+        transfer.inFlight.pop_front();
+        if (transfer.inFlight.empty())
+        {
+            passChannel(requests);
+        }
+    }
+
+    for (const FilePacketRequest& request : requests)
+    {
+        m_send(request);
+    }
+
+    return id;
+}
+
+std::size_t FilePacketScheduler::maxTransfers() const
+{
+    return m_transfers.size();
+}
+
+bool FilePacketScheduler::othersWaiting(TransferId id) const
+{
+    for (std::size_t i = 0; i < m_transfers.size(); ++i)
+    {
+        if (i != id && !m_transfers[i].queued.empty())
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void FilePacketScheduler::passChannel(std::vector<FilePacketRequest>& requests)
+{
+    const std::size_t count = m_transfers.size();
+    const std::size_t start = m_holder == INVALID_TRANSFER ? 0 : m_holder + 1;
+
+    // current holder is considered last, so it keeps the channel only when nobody else is waiting
+    for (std::size_t offset = 0; offset < count; ++offset)
+    {
+        const std::size_t next = (start + offset) % count;
+
+        Transfer& transfer = m_transfers[next];
+        if (!transfer.open || transfer.queued.empty())
+        {
+            continue;
+        }
+
+        m_holder = static_cast<TransferId>(next);
+        while (!transfer.queued.empty())
+        {
+            transfer.inFlight.push_back(transfer.queued.front().getChunkIndex());
+            requests.push_back(transfer.queued.front());
+            transfer.queued.pop_front();
+        }
+
+        return;
+    }
+
+    m_holder = INVALID_TRANSFER;
+}
+}    // namespace wolkabout
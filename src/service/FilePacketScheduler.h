@@ -0,0 +1,102 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FILEPACKETSCHEDULER_H
+#define FILEPACKETSCHEDULER_H
+
+#include "model/FilePacketRequest.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Shares platform file packet channel between concurrent file transfers
+ *
+ * Binary packets sent by platform do not name the file they belong to, so packets of only one transfer,
+ * the holder, are in flight at a time and each arriving packet belongs to the holder.
+ * Holder sends its whole window at once, and keeps requesting packets while no other transfer is waiting.
+ * Otherwise its further requests are queued, and once its packets have arrived the channel passes to the next
+ * waiting transfer in round robin order, so every transfer gets an equal share.
+ * A repeated request for a queued packet replaces the queued one.
+ */
+class FilePacketScheduler
+{
+public:
+    using TransferId = std::uint32_t;
+
+    static constexpr TransferId INVALID_TRANSFER = std::numeric_limits<TransferId>::max();
+
+    /**
+     * @param maxTransfers Number of transfers which can be open at the same time
+     * @param send Sends packet request to platform
+     */
+    FilePacketScheduler(std::size_t maxTransfers, std::function<void(const FilePacketRequest&)> send);
+
+    FilePacketScheduler(const FilePacketScheduler&) = delete;
+    FilePacketScheduler& operator=(const FilePacketScheduler&) = delete;
+
+    /**
+     * @brief Opens new transfer
+     * @return Id of transfer, or INVALID_TRANSFER if maximum number of transfers is open
+     */
+    TransferId open();
+
+    /**
+     * @brief Closes transfer, dropping its queued requests and passing channel on if transfer holds it
+     */
+    void close(TransferId id);
+
+    void request(TransferId id, const FilePacketRequest& request);
+
+    /**
+     * @brief Accounts for packet which arrived from platform
+     * @return Id of transfer packet belongs to, or INVALID_TRANSFER if no packet is expected
+     */
+    TransferId received();
+
+    std::size_t maxTransfers() const;
+
+private:
+    struct Transfer
+    {
+        Transfer() : open{false} {}
+
+        bool open;
+        // requests waiting for channel
+        std::deque<FilePacketRequest> queued;
+        // chunk indices of packets requested from platform, in request order
+        std::deque<unsigned> inFlight;
+    };
+
+    bool othersWaiting(TransferId id) const;
+    void passChannel(std::vector<FilePacketRequest>& requests);
+
+    const std::function<void(const FilePacketRequest&)> m_send;
+
+    mutable std::mutex m_mutex;
+    std::vector<Transfer> m_transfers;
+    TransferId m_holder;
+};
+}    // namespace wolkabout
+
+#endif    // FILEPACKETSCHEDULER_H
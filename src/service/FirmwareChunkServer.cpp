@@ -0,0 +1,207 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "service/FirmwareChunkServer.h"
+#include "utilities/Logger.h"
+#include "utilities/Sha256.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utility>
+
+namespace wolkabout
+{
+constexpr std::size_t FirmwareChunkServer::DEFAULT_CHUNK_SIZE;
+
+FirmwareImage::FirmwareImage(std::string filePath, std::size_t chunkSize)
+: m_filePath{std::move(filePath)}, m_chunkSize{chunkSize}, m_data{nullptr}, m_size{0}
+{
+}
+
+FirmwareImage::~FirmwareImage()
+{
+    if (m_data)
+    {
+        ::munmap(const_cast<std::uint8_t*>(m_data), m_size);
+    }
+}
+
+std::shared_ptr<const FirmwareImage> FirmwareImage::map(const std::string& filePath, std::size_t chunkSize)
+{
+    if (chunkSize == 0)
+    {
+        return nullptr;
+    }
+
+    const int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        LOG(ERROR) << "FirmwareImage: Unable to open file '" << filePath << "': " << std::strerror(errno);
+        return nullptr;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        LOG(ERROR) << "FirmwareImage: Unable to stat file '" << filePath << "': " << std::strerror(errno);
+        ::close(fd);
+        return nullptr;
+    }
+
+    std::shared_ptr<FirmwareImage> image{new FirmwareImage(filePath, chunkSize)};
+    const auto size = static_cast<std::size_t>(info.st_size);
+
+    if (size != 0)
+    {
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            LOG(ERROR) << "FirmwareImage: Unable to map file '" << filePath << "': " << std::strerror(errno);
+            ::close(fd);
+            return nullptr;
+        }
+
+        // devices fetch the whole image, read it ahead in one pass while hashing
+        ::madvise(mapping, size, MADV_WILLNEED);
+
+        image->m_data = static_cast<const std::uint8_t*>(mapping);
+        image->m_size = size;
+    }
+
+    // mapping keeps file contents reachable after descriptor is closed
+    ::close(fd);
+
+    const std::size_t chunkCount = size / chunkSize + 1;
+    image->m_hashes.reserve(chunkCount);
+
+    Sha256 sha256;
+    for (std::size_t index = 0; index < chunkCount; ++index)
+    {
+        sha256.update(image->getChunkData(index), image->getChunkLength(index));
+        image->m_hashes.push_back(sha256.digest());
+    }
+
+    return image;
+}
+
+const std::string& FirmwareImage::getFilePath() const
+{
+    return m_filePath;
+}
+
+std::size_t FirmwareImage::getSize() const
+{
+    return m_size;
+}
+
+std::size_t FirmwareImage::getChunkSize() const
+{
+    return m_chunkSize;
+}
+
+std::size_t FirmwareImage::getChunkCount() const
+{
+    return m_size / m_chunkSize + 1;
+}
+
+const std::uint8_t* FirmwareImage::getChunkData(std::size_t index) const
+{
+    if (index >= getChunkCount())
+    {
+        return nullptr;
+    }
+
+    // empty file has no mapping, its only chunk is empty
+    static const std::uint8_t EMPTY = 0;
+    return m_data ? m_data + index * m_chunkSize : &EMPTY;
+}
+
+std::size_t FirmwareImage::getChunkLength(std::size_t index) const
+{
+    if (index >= getChunkCount())
+    {
+        return 0;
+    }
+
+    return std::min(m_chunkSize, m_size - index * m_chunkSize);
+}
+
+const ByteArray& FirmwareImage::getChunkHash(std::size_t index) const
+{
+    return m_hashes.at(index);
+}
+
+FirmwareChunkServer::FirmwareChunkServer(std::size_t chunkSize) : m_chunkSize{chunkSize} {}
+
+bool FirmwareChunkServer::publish(const std::string& filePath)
+{
+    {
+        std::lock_guard<decltype(m_mutex)> l{m_mutex};
+        if (m_images.find(filePath) != m_images.end())
+        {
+            return true;
+        }
+    }
+
+    // hashing a large image is done outside of lock, so requests for other images are served meanwhile
+    auto image = FirmwareImage::map(filePath, m_chunkSize);
+    if (!image)
+    {
+        return false;
+    }
+
+    LOG(DEBUG) << "FirmwareChunkServer: Serving '" << filePath << "' in " << image->getChunkCount() << " chunks";
+
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    m_images.emplace(filePath, std::move(image));
+    return true;
+}
+
+void FirmwareChunkServer::withdraw(const std::string& filePath)
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    m_images.erase(filePath);
+}
+
+void FirmwareChunkServer::withdrawAll()
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    m_images.clear();
+}
+
+std::shared_ptr<const FirmwareImage> FirmwareChunkServer::find(const std::string& filePath) const
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    const auto it = m_images.find(filePath);
+    return it != m_images.end() ? it->second : nullptr;
+}
+
+std::size_t FirmwareChunkServer::getChunkSize() const
+{
+    return m_chunkSize;
+}
+
+std::size_t FirmwareChunkServer::size() const
+{
+    std::lock_guard<decltype(m_mutex)> l{m_mutex};
+    return m_images.size();
+}
+}    // namespace wolkabout
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRMWARECHUNKSERVER_H
+#define FIRMWARECHUNKSERVER_H
+
+#include "utilities/ByteUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Read-only mapping of firmware file, split into fixed-size chunks with precomputed SHA-256 of each chunk
+ *
+ * Last chunk is shorter than chunk size, and is empty when file size is a multiple of chunk size,
+ * so a device always recognizes the end of the file.
+ */
+class FirmwareImage
+{
+public:
+    /**
+     * @brief Maps file and hashes its chunks
+     * @return Mapped image, or nullptr if file could not be read
+     */
+    static std::shared_ptr<const FirmwareImage> map(const std::string& filePath, std::size_t chunkSize);
+
+    ~FirmwareImage();
+
+    FirmwareImage(const FirmwareImage&) = delete;
+    FirmwareImage& operator=(const FirmwareImage&) = delete;
+
+    const std::string& getFilePath() const;
+
+    std::size_t getSize() const;
+
+    std::size_t getChunkSize() const;
+
+    std::size_t getChunkCount() const;
+
+    /**
+     * @brief Returns pointer into mapped pages, valid while image is held
+     * @return nullptr if index is out of range
+     */
+    const std::uint8_t* getChunkData(std::size_t index) const;
+
+    std::size_t getChunkLength(std::size_t index) const;
+
+    const ByteArray& getChunkHash(std::size_t index) const;
+
+private:
+    FirmwareImage(std::string filePath, std::size_t chunkSize);
+
+    const std::string m_filePath;
+    const std::size_t m_chunkSize;
+
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+
+    std::vector<ByteArray> m_hashes;
+};
+
+/**
+ * @brief Serves chunks of firmware files to subdevices
+ *
+ * Each file is mapped and hashed once when it is published, and all devices installing it read from the same
+ * mapping, so concurrent transfers share the page cache instead of reading the file on every request.
+ * Thread safe, images stay mapped while a chunk taken from them is held, even if they are withdrawn meanwhile.
+ */
+class FirmwareChunkServer
+{
+public:
+    static constexpr std::size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    explicit FirmwareChunkServer(std::size_t chunkSize = DEFAULT_CHUNK_SIZE);
+
+    FirmwareChunkServer(const FirmwareChunkServer&) = delete;
+    FirmwareChunkServer& operator=(const FirmwareChunkServer&) = delete;
+
+    /**
+     * @brief Maps file, if it is not served already
+     * @return false if file could not be mapped
+     */
+    bool publish(const std::string& filePath);
+
+    void withdraw(const std::string& filePath);
+
+    void withdrawAll();
+
+    /**
+     * @return Image of published file, or nullptr if file is not published
+     */
+    std::shared_ptr<const FirmwareImage> find(const std::string& filePath) const;
+
+    std::size_t getChunkSize() const;
+
+    std::size_t size() const;
+
+private:
+    const std::size_t m_chunkSize;
+
+    mutable std::mutex m_mutex;
+    std::unordered_map<std::string, std::shared_ptr<const FirmwareImage>> m_images;
+};
+}    // namespace wolkabout
+
+#endif    // FIRMWARECHUNKSERVER_H
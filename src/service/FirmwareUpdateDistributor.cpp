@@ -0,0 +1,143 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "service/FirmwareUpdateDistributor.h"
+
+#include <utility>
+
+namespace wolkabout
+{
+FirmwareUpdateDistributor::FirmwareUpdateDistributor(std::size_t maxConcurrentInstallations)
+: m_maxConcurrentInstallations{maxConcurrentInstallations}, m_activeCount{0}, m_queuedCount{0}, m_nextId{0}
+{
+}
+
+std::vector<FirmwareUpdateDistributor::Installation> FirmwareUpdateDistributor::enqueue(
+  const std::vector<std::string>& deviceKeys, const std::string& filePath)
+{
+    const auto sharedFilePath = std::make_shared<const std::string>(filePath);
+
+    for (const auto& key : deviceKeys)
+    {
+        const auto id = ++m_nextId;
+        if (!m_devices.emplace(key, Entry{State::QUEUED, id, sharedFilePath}).second)
+        {
+            continue;
+        }
+
+        m_queue.push_back(Ticket{key, id});
+        ++m_queuedCount;
+    }
+
+    return startQueued();
+}
+
+bool FirmwareUpdateDistributor::installing(const std::string& deviceKey)
+{
+    const auto it = m_devices.find(deviceKey);
+    if (it == m_devices.end() || it->second.state == State::QUEUED)
+    {
+        return false;
+    }
+
+    it->second.state = State::INSTALLING;
+    return true;
+}
+
+std::vector<FirmwareUpdateDistributor::Installation> FirmwareUpdateDistributor::finished(const std::string& deviceKey)
+{
+    const auto it = m_devices.find(deviceKey);
+    if (it != m_devices.end() && it->second.state != State::QUEUED)
+    {
+        m_devices.erase(it);
+        --m_activeCount;
+    }
+
+    return startQueued();
+}
+
+bool FirmwareUpdateDistributor::expired(const std::string& deviceKey, std::uint64_t installationId)
+{
+    const auto it = m_devices.find(deviceKey);
+    if (it == m_devices.end() || it->second.id != installationId || it->second.state == State::QUEUED)
+    {
+        return false;
+    }
+
+    m_devices.erase(it);
+    --m_activeCount;
+    return true;
+}
+
+bool FirmwareUpdateDistributor::cancel(const std::string& deviceKey)
+{
+    const auto it = m_devices.find(deviceKey);
+    if (it == m_devices.end() || it->second.state != State::QUEUED)
+    {
+        return false;
+    }
+
+    m_devices.erase(it);
+    --m_queuedCount;
+    return true;
+}
+
+FirmwareUpdateDistributor::State FirmwareUpdateDistributor::getState(const std::string& deviceKey) const
+{
+    const auto it = m_devices.find(deviceKey);
+    return it == m_devices.end() ? State::IDLE : it->second.state;
+}
+
+bool FirmwareUpdateDistributor::isActive(const std::string& deviceKey) const
+{
+    const State state = getState(deviceKey);
+    return state == State::COMMANDED || state == State::INSTALLING;
+}
+
+std::size_t FirmwareUpdateDistributor::activeCount() const
+{
+    return m_activeCount;
+}
+
+std::size_t FirmwareUpdateDistributor::queuedCount() const
+{
+    return m_queuedCount;
+}
+
+std::vector<FirmwareUpdateDistributor::Installation> FirmwareUpdateDistributor::startQueued()
+{
+    std::vector<Installation> started;
+    while (!m_queue.empty() && (m_maxConcurrentInstallations == 0 || m_activeCount < m_maxConcurrentInstallations))
+    {
+        const Ticket ticket = std::move(m_queue.front());
+        m_queue.pop_front();
+
+        const auto it = m_devices.find(ticket.deviceKey);
+        if (it == m_devices.end() || it->second.id != ticket.id || it->second.state != State::QUEUED)
+        {
+            continue;
+        }
+
+        it->second.state = State::COMMANDED;
+        --m_queuedCount;
+        ++m_activeCount;
+
+        started.push_back(Installation{ticket.deviceKey, *it->second.filePath, ticket.id});
+    }
+
+    return started;
+}
+}    // namespace wolkabout
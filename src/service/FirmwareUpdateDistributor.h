@@ -0,0 +1,132 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FIRMWAREUPDATEDISTRIBUTOR_H
+#define FIRMWAREUPDATEDISTRIBUTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Per-device firmware installation state, limiting number of subdevices installing at the same time
+ *
+ * Each device moves from QUEUED to COMMANDED when install command may be sent to it, then to INSTALLING
+ * once it reports progress, and leaves the table when it completes, fails, aborts or times out.
+ * Installations beyond the limit are queued in the order they were requested, so several rollout waves
+ * share the same slots. Keeps the local bus from being flooded when firmware is sent to hundreds of devices at once.
+ *
+ * Not thread safe, callers are expected to provide synchronization.
+ */
+class FirmwareUpdateDistributor
+{
+public:
+    enum class State
+    {
+        IDLE,
+        QUEUED,
+        COMMANDED,
+        INSTALLING
+    };
+
+    struct Installation
+    {
+        std::string deviceKey;
+        std::string filePath;
+        // distinguishes installations of same device, so stale timeouts can be recognized
+        std::uint64_t id;
+    };
+
+    /**
+     * @param maxConcurrentInstallations Number of devices installing at once, 0 for no limit
+     */
+    explicit FirmwareUpdateDistributor(std::size_t maxConcurrentInstallations = 0);
+
+    /**
+     * @brief Adds installation of firmware file on devices
+     * Devices that already have installation active or queued are skipped
+     * @return Installations that should be started now
+     */
+    std::vector<Installation> enqueue(const std::vector<std::string>& deviceKeys, const std::string& filePath);
+
+    /**
+     * @brief Marks commanded device as installing
+     * @return false if device has no active installation
+     */
+    bool installing(const std::string& deviceKey);
+
+    /**
+     * @brief Releases slot held by device which completed, failed or aborted installation
+     * @return Installations that should be started now
+     */
+    std::vector<Installation> finished(const std::string& deviceKey);
+
+    /**
+     * @brief Releases slot of installation whose deadline passed
+     * @param installationId Id of installation the deadline was set for
+     * @return true if that installation was still active, in which case slot was released
+     */
+    bool expired(const std::string& deviceKey, std::uint64_t installationId);
+
+    /**
+     * @brief Removes queued installation that was not started yet
+     * @return true if installation was queued, false if it is active or not known
+     */
+    bool cancel(const std::string& deviceKey);
+
+    State getState(const std::string& deviceKey) const;
+
+    bool isActive(const std::string& deviceKey) const;
+
+    std::size_t activeCount() const;
+    std::size_t queuedCount() const;
+
+private:
+    struct Entry
+    {
+        State state;
+        std::uint64_t id;
+        // shared by all devices of one rollout wave
+        std::shared_ptr<const std::string> filePath;
+    };
+
+    struct Ticket
+    {
+        std::string deviceKey;
+        std::uint64_t id;
+    };
+
+    std::vector<Installation> startQueued();
+
+    const std::size_t m_maxConcurrentInstallations;
+
+    std::unordered_map<std::string, Entry> m_devices;
+    std::size_t m_activeCount;
+    std::size_t m_queuedCount;
+
+    // cancelled installations are left in queue and skipped, their tickets no longer match an entry
+    std::deque<Ticket> m_queue;
+    std::uint64_t m_nextId;
+};
+}    // namespace wolkabout
+
+#endif    // FIRMWAREUPDATEDISTRIBUTOR_H
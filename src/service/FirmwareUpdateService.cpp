@@ -16,6 +16,8 @@
 
 #include "service/FirmwareUpdateService.h"
 #include "OutboundMessageHandler.h"
+#include "model/FirmwareChunk.h"
+#include "model/FirmwareChunkRequest.h"
 #include "model/FirmwareUpdateAbort.h"
 #include "model/FirmwareUpdateInstall.h"
 #include "model/FirmwareVersion.h"
@@ -24,6 +26,7 @@
 #include "protocol/json/JsonDFUProtocol.h"
 #include "repository/FileRepository.h"
 #include "service/FirmwareInstaller.h"
+#include "utilities/CommandWatchdog.h"
 #include "utilities/FileSystemUtils.h"
 #include "utilities/Logger.h"
 #include "utilities/StringUtils.h"
@@ -36,7 +39,9 @@ FirmwareUpdateService::FirmwareUpdateService(std::string gatewayKey, JsonDFUProt
                                              GatewayFirmwareUpdateProtocol& gatewayProtocol,
                                              FileRepository& fileRepository,
                                              OutboundMessageHandler& outboundPlatformMessageHandler,
-                                             OutboundMessageHandler& outboundDeviceMessageHandler)
+                                             OutboundMessageHandler& outboundDeviceMessageHandler,
+                                             Executor& executor, std::size_t maxConcurrentDeviceInstallations,
+                                             std::chrono::milliseconds installationTimeout)
 : m_gatewayKey{std::move(gatewayKey)}
 , m_protocol{protocol}
 , m_gatewayProtocol{gatewayProtocol}
@@ -45,6 +50,10 @@ FirmwareUpdateService::FirmwareUpdateService(std::string gatewayKey, JsonDFUProt
 , m_outboundDeviceMessageHandler{outboundDeviceMessageHandler}
 , m_firmwareInstaller{nullptr}
 , m_currentFirmwareVersion{""}
+, m_distributor{maxConcurrentDeviceInstallations}
+, m_executor{executor}
+, m_installationTimeout{installationTimeout}
+, m_stopped{false}
 {
 }
 
@@ -53,8 +62,10 @@ FirmwareUpdateService::FirmwareUpdateService(std::string gatewayKey, JsonDFUProt
                                              FileRepository& fileRepository,
                                              OutboundMessageHandler& outboundPlatformMessageHandler,
                                              OutboundMessageHandler& outboundDeviceMessageHandler,
-                                             std::shared_ptr<FirmwareInstaller> firmwareInstaller,
-                                             std::string currentFirmwareVersion)
+                                             Executor& executor, std::shared_ptr<FirmwareInstaller> firmwareInstaller,
+                                             std::string currentFirmwareVersion,
+                                             std::size_t maxConcurrentDeviceInstallations,
+                                             std::chrono::milliseconds installationTimeout)
 : m_gatewayKey{std::move(gatewayKey)}
 , m_protocol{protocol}
 , m_gatewayProtocol{gatewayProtocol}
@@ -63,7 +74,32 @@ FirmwareUpdateService::FirmwareUpdateService(std::string gatewayKey, JsonDFUProt
 , m_outboundDeviceMessageHandler{outboundDeviceMessageHandler}
 , m_firmwareInstaller{std::move(firmwareInstaller)}
 , m_currentFirmwareVersion{std::move(currentFirmwareVersion)}
+, m_distributor{maxConcurrentDeviceInstallations}
+, m_executor{executor}
+, m_installationTimeout{installationTimeout}
+, m_stopped{false}
+{
+}
+
+FirmwareUpdateService::~FirmwareUpdateService()
 {
+    std::vector<Executor::TaskId> timeouts;
+
+    {
+        std::lock_guard<decltype(m_timeoutsMutex)> l{m_timeoutsMutex};
+        m_stopped = true;
+
+        for (const auto& timeout : m_timeouts)
+        {
+            timeouts.push_back(timeout.second);
+        }
+    }
+
+    // timeout that is already running is waited for, it only queues a command
+    for (const auto timeout : timeouts)
+    {
+        m_executor.cancel(timeout);
+    }
 }
 
 void FirmwareUpdateService::platformMessageReceived(std::shared_ptr<Message> message)
@@ -110,6 +146,15 @@ void FirmwareUpdateService::deviceMessageReceived(std::shared_ptr<Message> messa
         return;
     }
 
+    auto chunkRequest = m_gatewayProtocol.makeFirmwareChunkRequest(*message);
+    if (chunkRequest)
+    {
+        auto requestDto = *chunkRequest;
+        addToCommandBuffer([=] { handleFirmwareChunkRequest(requestDto); });
+
+        return;
+    }
+
     LOG(WARN) << "Unable to parse message; channel: " << message->getChannel()
               << ", content: " << message->getContent();
 }
@@ -262,8 +307,53 @@ void FirmwareUpdateService::handleFirmwareVersion(const FirmwareVersion& version
     sendVersion(version);
 }
 
+void FirmwareUpdateService::handleFirmwareChunkRequest(const FirmwareChunkRequest& request)
+{
+    if (!m_distributor.isActive(request.getDeviceKey()))
+    {
+        LOG(WARN) << "Firmware chunk requested by device without active installation: " << request.getDeviceKey();
+        return;
+    }
+
+    const auto image = m_chunkServer.find(request.getFileName());
+    if (!image)
+    {
+        LOG(WARN) << "Firmware chunk requested for file that is not served: " << request.getFileName();
+        return;
+    }
+
+    if (request.getChunkIndex() >= image->getChunkCount())
+    {
+        LOG(WARN) << "Firmware chunk index out of range: " << request.getChunkIndex() << ", file has "
+                  << image->getChunkCount() << " chunks";
+        return;
+    }
+
+    const auto index = static_cast<std::size_t>(request.getChunkIndex());
+    static const ByteArray NO_HASH;
+
+    // image is held until chunk is copied into message
+    const FirmwareChunk chunk{request.getDeviceKey(),
+                              request.getChunkIndex(),
+                              image->getChunkData(index),
+                              image->getChunkLength(index),
+                              index == 0 ? NO_HASH : image->getChunkHash(index - 1),
+                              image->getChunkHash(index)};
+
+    std::shared_ptr<Message> message = m_gatewayProtocol.makeMessage(m_gatewayKey, chunk);
+
+    if (!message)
+    {
+        LOG(ERROR) << "Failed to create firmware chunk";
+        return;
+    }
+
+    m_outboundDeviceMessageHandler.addMessage(message);
+}
+
 void FirmwareUpdateService::install(const std::vector<std::string>& deviceKeys, const std::string& fileName)
 {
+    std::vector<std::string> subdeviceKeys;
     for (const auto& key : deviceKeys)
     {
         if (key == m_gatewayKey)
@@ -272,16 +362,33 @@ void FirmwareUpdateService::install(const std::vector<std::string>& deviceKeys,
         }
         else
         {
-            auto fileInfo = m_fileRepository.getFileInfo(fileName);
-            if (!fileInfo)
-            {
-                LOG(ERROR) << "Missing file info: " << fileName;
-                return;
-            }
-
-            installDeviceFirmware(key, fileInfo->path);
+            subdeviceKeys.push_back(key);
         }
     }
+
+    if (subdeviceKeys.empty())
+    {
+        return;
+    }
+
+    auto fileInfo = m_fileRepository.getFileInfo(fileName);
+    if (!fileInfo)
+    {
+        LOG(ERROR) << "Missing file info: " << fileName;
+        return;
+    }
+
+    if (!m_chunkServer.publish(fileInfo->path))
+    {
+        LOG(WARN) << "Unable to serve firmware file to devices in chunks: " << fileInfo->path;
+    }
+
+    startInstallations(m_distributor.enqueue(subdeviceKeys, fileInfo->path));
+
+    if (m_distributor.queuedCount() != 0)
+    {
+        LOG(INFO) << "Firmware installation queued for " << m_distributor.queuedCount() << " devices";
+    }
 }
 
 void FirmwareUpdateService::installGatewayFirmware(const std::string& filePath)
@@ -317,11 +424,93 @@ void FirmwareUpdateService::installDeviceFirmware(const std::string& deviceKey,
     sendCommand(FirmwareUpdateInstall{{deviceKey}, filePath});
 }
 
+void FirmwareUpdateService::startInstallations(
+  const std::vector<FirmwareUpdateDistributor::Installation>& installations)
+{
+    for (const auto& installation : installations)
+    {
+        installDeviceFirmware(installation.deviceKey, installation.filePath);
+
+        if (m_installationTimeout.count() == 0)
+        {
+            continue;
+        }
+
+        const std::string deviceKey = installation.deviceKey;
+        const std::uint64_t installationId = installation.id;
+
+        std::lock_guard<decltype(m_timeoutsMutex)> l{m_timeoutsMutex};
+        if (m_stopped)
+        {
+            return;
+        }
+
+        m_timeouts[deviceKey] = m_executor.schedule(m_installationTimeout, [=] {
+            addToCommandBuffer([=] { installationTimedOut(deviceKey, installationId); });
+        });
+    }
+}
+
+void FirmwareUpdateService::finishInstallation(const std::string& deviceKey)
+{
+    Executor::TaskId timeout = 0;
+
+    {
+        std::lock_guard<decltype(m_timeoutsMutex)> l{m_timeoutsMutex};
+        const auto it = m_timeouts.find(deviceKey);
+        if (it != m_timeouts.end())
+        {
+            timeout = it->second;
+            m_timeouts.erase(it);
+        }
+    }
+
+    if (timeout != 0)
+    {
+        m_executor.cancel(timeout);
+    }
+
+    startInstallations(m_distributor.finished(deviceKey));
+    withdrawUnusedImages();
+}
+
+void FirmwareUpdateService::installationTimedOut(const std::string& deviceKey, std::uint64_t installationId)
+{
+    if (!m_distributor.expired(deviceKey, installationId))
+    {
+        // installation finished, or device was given another installation since
+        return;
+    }
+
+    {
+        std::lock_guard<decltype(m_timeoutsMutex)> l{m_timeoutsMutex};
+        m_timeouts.erase(deviceKey);
+    }
+
+    LOG(WARN) << "Firmware installation timed out for device: " << deviceKey;
+
+    sendCommand(FirmwareUpdateAbort{{deviceKey}});
+    sendStatus(FirmwareUpdateStatus{{deviceKey}, FirmwareUpdateStatus::Error::INSTALLATION_FAILED});
+
+    startInstallations(m_distributor.finished(deviceKey));
+    withdrawUnusedImages();
+}
+
+void FirmwareUpdateService::withdrawUnusedImages()
+{
+    if (m_distributor.activeCount() == 0 && m_distributor.queuedCount() == 0 && m_chunkServer.size() != 0)
+    {
+        LOG(DEBUG) << "No firmware installations left, unmapping firmware files";
+        m_chunkServer.withdrawAll();
+    }
+}
+
 void FirmwareUpdateService::installationInProgress(const std::vector<std::string>& deviceKeys)
 {
     for (const auto& key : deviceKeys)
     {
         LOG(INFO) << "Firmware installation in progress for device: " << key;
+        m_distributor.installing(key);
     }
 }
 
@@ -330,6 +519,7 @@ void FirmwareUpdateService::installationCompleted(const std::vector<std::string>
     for (const auto& key : deviceKeys)
     {
         LOG(INFO) << "Firmware installation completed for device: " << key;
+        finishInstallation(key);
     }
 }
 
@@ -338,6 +528,7 @@ void FirmwareUpdateService::installationAborted(const std::vector<std::string>&
     for (const auto& key : deviceKeys)
     {
         LOG(INFO) << "Firmware installation aborted for device: " << key;
+        finishInstallation(key);
     }
 }
 
@@ -348,6 +539,7 @@ void FirmwareUpdateService::installationFailed(const std::vector<std::string>& d
     {
         LOG(INFO) << "Firmware installation failed for device: " << key
                   << (errorCode ? std::to_string(static_cast<int>(errorCode.value())) : "");
+        finishInstallation(key);
     }
 }
 
@@ -374,6 +566,15 @@ void FirmwareUpdateService::abortGatewayFirmware()
 void FirmwareUpdateService::abortDeviceFirmware(const std::string& deviceKey)
 {
     LOG(INFO) << "Handling firmware update abort for device: " << deviceKey;
+
+    if (m_distributor.cancel(deviceKey))
+    {
+        // installation was never sent to device
+        sendStatus(FirmwareUpdateStatus{{deviceKey}, FirmwareUpdateStatus::Status::ABORTED});
+        withdrawUnusedImages();
+        return;
+    }
+
     sendCommand(FirmwareUpdateAbort{{deviceKey}});
 }
 
@@ -431,151 +632,7 @@ void FirmwareUpdateService::sendCommand(const FirmwareUpdateAbort& command)
 
 void FirmwareUpdateService::addToCommandBuffer(std::function<void()> command)
 {
-    m_commandBuffer.pushCommand(std::make_shared<std::function<void()>>(command));
-}
-//
-// void FirmwareUpdateService::addDeviceUpdateStatus(const std::string& deviceKey,
-//                                                  DeviceUpdateStruct::DeviceUpdateStatus status, bool autoInstall)
-//{
-//    m_deviceUpdateStatuses[deviceKey] = {autoInstall, status};
-//}
-//
-// void FirmwareUpdateService::setDeviceUpdateStatus(const std::string& deviceKey,
-//                                                  DeviceUpdateStruct::DeviceUpdateStatus status)
-//{
-//    m_deviceUpdateStatuses[deviceKey].status = status;
-//}
-//
-// bool FirmwareUpdateService::deviceUpdateStatusExists(const std::string& deviceKey)
-//{
-//    return m_deviceUpdateStatuses.find(deviceKey) != m_deviceUpdateStatuses.end();
-//}
-//
-// FirmwareUpdateService::DeviceUpdateStruct FirmwareUpdateService::getDeviceUpdateStatus(const std::string& deviceKey)
-//{
-//    if (deviceUpdateStatusExists(deviceKey))
-//    {
-//        return m_deviceUpdateStatuses.at(deviceKey);
-//    }
-//
-//    return FirmwareUpdateService::DeviceUpdateStruct{false, DeviceUpdateStruct::DeviceUpdateStatus::UNKNOWN};
-//}
-//
-// void FirmwareUpdateService::removeDeviceUpdateStatus(const std::string& deviceKey)
-//{
-//    if (deviceUpdateStatusExists(deviceKey))
-//    {
-//        m_deviceUpdateStatuses.erase(m_deviceUpdateStatuses.find(deviceKey));
-//    }
-//}
-//
-// void FirmwareUpdateService::addFirmwareDownloadStatus(const std::string& key, const std::string& channel,
-//                                                      const std::string& uri,
-//                                                      FirmwareDownloadStruct::FirmwareDownloadStatus status,
-//                                                      const std::vector<std::string>& deviceKeys,
-//                                                      const std::string& firmwareFile)
-//{
-//    m_firmwareStatuses[key] = {status, channel, uri, deviceKeys, firmwareFile};
-//}
-//
-// FirmwareUpdateService::FirmwareDownloadStruct FirmwareUpdateService::getFirmwareDownloadStatus(const std::string&
-// key)
-//{
-//    if (firmwareDownloadStatusExists(key))
-//    {
-//        return m_firmwareStatuses.at(key);
-//    }
-//
-//    return FirmwareUpdateService::FirmwareDownloadStruct{
-//      FirmwareDownloadStruct::FirmwareDownloadStatus::UNKNOWN, "", "", {}, ""};
-//}
-//
-// void FirmwareUpdateService::setFirmwareDownloadCompletedStatus(const std::string& key, const std::string&
-// firmwareFile)
-//{
-//    m_firmwareStatuses[key].downloadedFirmwarePath = firmwareFile;
-//    m_firmwareStatuses[key].status = FirmwareDownloadStruct::FirmwareDownloadStatus::COMPLETED;
-//}
-//
-// bool FirmwareUpdateService::firmwareDownloadStatusExists(const std::string& key)
-//{
-//    return m_firmwareStatuses.find(key) != m_firmwareStatuses.end();
-//}
-//
-// bool FirmwareUpdateService::firmwareDownloadStatusExistsForDevice(const std::string& deviceKey)
-//{
-//    for (auto& pair : m_firmwareStatuses)
-//    {
-//        auto& deviceList = pair.second.devices;
-//
-//        auto it = std::find(deviceList.begin(), deviceList.end(), deviceKey);
-//        if (it != deviceList.end())
-//        {
-//            return true;
-//        }
-//    }
-//
-//    return false;
-//}
-//
-// FirmwareUpdateService::FirmwareDownloadStruct FirmwareUpdateService::getFirmwareDownloadStatusForDevice(
-//  const std::string& deviceKey)
-//{
-//    for (auto& pair : m_firmwareStatuses)
-//    {
-//        auto& deviceList = pair.second.devices;
-//
-//        auto it = std::find(deviceList.begin(), deviceList.end(), deviceKey);
-//        if (it != deviceList.end())
-//        {
-//            return pair.second;
-//        }
-//    }
-//
-//    return FirmwareUpdateService::FirmwareDownloadStruct{
-//      FirmwareDownloadStruct::FirmwareDownloadStatus::UNKNOWN, "", "", {}, ""};
-//}
-//
-// void FirmwareUpdateService::removeDeviceFromFirmwareStatus(const std::string& deviceKey)
-//{
-//    for (auto& pair : m_firmwareStatuses)
-//    {
-//        auto& deviceList = pair.second.devices;
-//
-//        auto it = std::find(deviceList.begin(), deviceList.end(), deviceKey);
-//        if (it != deviceList.end())
-//        {
-//            deviceList.erase(it);
-//        }
-//    }
-//}
-//
-// void FirmwareUpdateService::removeFirmwareStatus(const std::string& key)
-//{
-//    auto it = m_firmwareStatuses.find(key);
-//    if (it != m_firmwareStatuses.end())
-//    {
-//        for (const auto& deviceKey : it->second.devices)
-//        {
-//            removeDeviceUpdateStatus(deviceKey);
-//        }
-//        m_firmwareStatuses.erase(it);
-//    }
-//}
-//
-// void FirmwareUpdateService::clearUsedFirmwareFiles()
-//{
-//    for (auto it = m_firmwareStatuses.begin(); it != m_firmwareStatuses.end();)
-//    {
-//        if (it->second.devices.empty())
-//        {
-//            FileSystemUtils::deleteFile(it->second.downloadedFirmwarePath);
-//            it = m_firmwareStatuses.erase(it);
-//        }
-//        else
-//        {
-//            ++it;
-//        }
-//    }
-//}
+    auto tracked = CommandWatchdog::getInstance().track("firmware_update", "", std::move(command));
+    m_commandBuffer.pushCommand(std::make_shared<std::function<void()>>(std::move(tracked)));
+}
 }    // namespace wolkabout
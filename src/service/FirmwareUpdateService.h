@@ -19,16 +19,25 @@
 #include "GatewayInboundDeviceMessageHandler.h"
 #include "GatewayInboundPlatformMessageHandler.h"
 #include "model/FirmwareUpdateStatus.h"
+#include "service/FirmwareChunkServer.h"
+#include "service/FirmwareUpdateDistributor.h"
 #include "utilities/CommandBuffer.h"
+#include "utilities/Executor.h"
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace wolkabout
 {
 class FileRepository;
+class FirmwareChunkRequest;
 class FirmwareInstaller;
 class FirmwareUpdateAbort;
 class FirmwareUpdateInstall;
@@ -41,16 +50,27 @@ class OutboundMessageHandler;
 class FirmwareUpdateService : public DeviceMessageListener, public PlatformMessageListener
 {
 public:
+    /**
+     * @param maxConcurrentDeviceInstallations Number of subdevices installing firmware at once, remaining
+     * devices wait until one of them reports completion, failure or abort. 0 installs on all devices at once
+     * @param installationTimeout Time after which subdevice that has not finished installation is reported
+     * as failed and its slot is given to next device. 0 waits for subdevice indefinitely
+     */
     FirmwareUpdateService(std::string gatewayKey, JsonDFUProtocol& protocol,
                           GatewayFirmwareUpdateProtocol& gatewayProtocol, FileRepository& fileRepository,
                           OutboundMessageHandler& outboundPlatformMessageHandler,
-                          OutboundMessageHandler& outboundDeviceMessageHandler);
+                          OutboundMessageHandler& outboundDeviceMessageHandler, Executor& executor,
+                          std::size_t maxConcurrentDeviceInstallations = 0,
+                          std::chrono::milliseconds installationTimeout = std::chrono::milliseconds{0});
 
     FirmwareUpdateService(std::string gatewayKey, JsonDFUProtocol& protocol,
                           GatewayFirmwareUpdateProtocol& gatewayProtocol, FileRepository& fileRepository,
                           OutboundMessageHandler& outboundPlatformMessageHandler,
-                          OutboundMessageHandler& outboundDeviceMessageHandler,
-                          std::shared_ptr<FirmwareInstaller> firmwareInstaller, std::string currentFirmwareVersion);
+                          OutboundMessageHandler& outboundDeviceMessageHandler, Executor& executor,
+                          std::shared_ptr<FirmwareInstaller> firmwareInstaller, std::string currentFirmwareVersion,
+                          std::size_t maxConcurrentDeviceInstallations = 0,
+                          std::chrono::milliseconds installationTimeout = std::chrono::milliseconds{0});
+    ~FirmwareUpdateService();
 
     void platformMessageReceived(std::shared_ptr<Message> message) override;
 
@@ -70,10 +90,15 @@ private:
 
     void handleFirmwareUpdateStatus(const FirmwareUpdateStatus& status);
     void handleFirmwareVersion(const FirmwareVersion& version);
+    void handleFirmwareChunkRequest(const FirmwareChunkRequest& request);
 
     void install(const std::vector<std::string>& deviceKeys, const std::string& fileName);
     void installGatewayFirmware(const std::string& filePath);
     void installDeviceFirmware(const std::string& deviceKey, const std::string& filePath);
+    void startInstallations(const std::vector<FirmwareUpdateDistributor::Installation>& installations);
+    void finishInstallation(const std::string& deviceKey);
+    void installationTimedOut(const std::string& deviceKey, std::uint64_t installationId);
+    void withdrawUnusedImages();
 
     void installationInProgress(const std::vector<std::string>& deviceKeys);
     void installationCompleted(const std::vector<std::string>& deviceKeys);
@@ -105,6 +130,18 @@ private:
     std::shared_ptr<FirmwareInstaller> m_firmwareInstaller;
     const std::string m_currentFirmwareVersion;
 
+    FirmwareUpdateDistributor m_distributor;
+    // images of files being installed on subdevices, mapped once for all of them
+    FirmwareChunkServer m_chunkServer;
+
+    Executor& m_executor;
+    const std::chrono::milliseconds m_installationTimeout;
+
+    // deadline of each active subdevice installation, scheduled on shared executor
+    std::mutex m_timeoutsMutex;
+    std::unordered_map<std::string, Executor::TaskId> m_timeouts;
+    bool m_stopped;
+
     CommandBuffer m_commandBuffer;
 
     static const constexpr char* FIRMWARE_VERSION_FILE = ".dfu-version";
@@ -19,15 +19,19 @@
 #include "connectivity/ConnectivityService.h"
 #include "model/ActuatorGetCommand.h"
 #include "model/ActuatorSetCommand.h"
+#include "model/Alarm.h"
 #include "model/ConfigurationSetCommand.h"
 #include "model/Message.h"
 #include "model/SensorReading.h"
 #include "persistence/Persistence.h"
 #include "protocol/DataProtocol.h"
+#include "utilities/JsonWriter.h"
 #include "utilities/Logger.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <utility>
 
 namespace wolkabout
 {
@@ -45,9 +49,42 @@ GatewayDataService::GatewayDataService(std::string deviceKey, DataProtocol& prot
 , m_actuatorGetHandler{actuatorGetHandler}
 , m_configurationSetHandler{configurationSetHandler}
 , m_configurationGetHandler{configurationGetHandler}
+, m_persistOnIngest{false}
+, m_flushMaxItems{0}
+, m_flushMaxBytes{0}
+, m_flushMaxAge{0}
+, m_flushExecutor{nullptr}
+, m_queuedItems{0}
+, m_queuedBytes{0}
+, m_flushRequested{false}
+, m_flushTimerArmed{false}
+, m_flushTimer{0}
 {
 }
 
+GatewayDataService::~GatewayDataService()
+{
+    cancelFlushTimer();
+}
+
+void GatewayDataService::cancelFlushTimer()
+{
+    bool armed;
+    Executor::TaskId flushTimer;
+
+    {
+        std::lock_guard<std::mutex> lg{m_flushTimerLock};
+        armed = m_flushTimerArmed;
+        flushTimer = m_flushTimer;
+    }
+
+    // expiry that is already running is waited for
+    if (armed)
+    {
+        m_flushExecutor->cancel(flushTimer);
+    }
+}
+
 void GatewayDataService::messageReceived(std::shared_ptr<Message> message)
 {
     assert(message);
@@ -129,23 +166,78 @@ void GatewayDataService::addSensorReading(const std::string& reference, const st
                                           unsigned long long int rtc)
 {
     auto sensorReading = std::make_shared<SensorReading>(value, reference, rtc);
-
-    m_persistence.putSensorReading(reference, sensorReading);
+    if (m_persistOnIngest)
+    {
+        m_persistence.putSensorReading(reference, sensorReading);
+    }
+    else
+    {
+        m_queuedSensorReadings.push({std::move(sensorReading), {}});
+    }
+    itemsQueued(1, reference.size() + value.size());
 }
 
 void GatewayDataService::addSensorReading(const std::string& reference, const std::vector<std::string>& values,
                                           unsigned long long int rtc)
 {
     auto sensorReading = std::make_shared<SensorReading>(values, reference, rtc);
+    if (m_persistOnIngest)
+    {
+        m_persistence.putSensorReading(reference, sensorReading);
+    }
+    else
+    {
+        m_queuedSensorReadings.push({std::move(sensorReading), {}});
+    }
+
+    std::size_t bytes = reference.size();
+    for (const auto& value : values)
+    {
+        bytes += value.size() + 1;
+    }
+    itemsQueued(1, bytes);
+}
+
+void GatewayDataService::addSensorReadings(std::vector<NumericReading> readings)
+{
+    if (readings.empty())
+    {
+        return;
+    }
+
+    std::size_t bytes = 0;
+    for (const auto& reading : readings)
+    {
+        bytes += reading.getReference().size() + reading.getSize() * sizeof(double);
+    }
 
-    m_persistence.putSensorReading(reference, sensorReading);
+    const std::size_t count = readings.size();
+    if (m_persistOnIngest)
+    {
+        for (const auto& reading : readings)
+        {
+            persistNumericReading(reading);
+        }
+    }
+    else
+    {
+        m_queuedSensorReadings.push({nullptr, std::move(readings)});
+    }
+    itemsQueued(count, bytes);
 }
 
 void GatewayDataService::addAlarm(const std::string& reference, bool active, unsigned long long int rtc)
 {
     auto alarm = std::make_shared<Alarm>(active, reference, rtc);
-
-    m_persistence.putAlarm(reference, alarm);
+    if (m_persistOnIngest)
+    {
+        m_persistence.putAlarm(reference, alarm);
+    }
+    else
+    {
+        m_queuedAlarms.push(std::move(alarm));
+    }
+    itemsQueued(1, reference.size() + 1);
 }
 
 void GatewayDataService::addActuatorStatus(const std::string& reference, const std::string& value,
@@ -163,14 +255,139 @@ void GatewayDataService::addConfiguration(const std::vector<ConfigurationItem>&
     m_persistence.putConfiguration(m_deviceKey, conf);
 }
 
+void GatewayDataService::setFlushPolicy(std::size_t maxItems, std::size_t maxBytes, std::chrono::milliseconds maxAge,
+                                        Executor* executor, std::function<void()> flush)
+{
+    assert((maxAge.count() == 0 || executor) && "GatewayDataService: Executor is required for flush on max age");
+
+    m_flushMaxItems = maxItems;
+    m_flushMaxBytes = maxBytes;
+    m_flushMaxAge = maxAge;
+    m_flushExecutor = executor;
+    m_flush = std::move(flush);
+}
+
+void GatewayDataService::setPersistOnIngest(bool persistOnIngest)
+{
+    m_persistOnIngest = persistOnIngest;
+}
+
+void GatewayDataService::itemsQueued(std::size_t count, std::size_t bytes)
+{
+    if (!m_flush)
+    {
+        return;
+    }
+
+    const std::size_t items = m_queuedItems += count;
+    const std::size_t size = m_queuedBytes += bytes;
+
+    if ((m_flushMaxItems > 0 && items >= m_flushMaxItems) || (m_flushMaxBytes > 0 && size >= m_flushMaxBytes))
+    {
+        requestFlush();
+        return;
+    }
+
+    if (m_flushMaxAge.count() > 0 && !m_flushTimerArmed)
+    {
+        std::lock_guard<std::mutex> lg{m_flushTimerLock};
+        if (!m_flushTimerArmed)
+        {
+            m_flushTimerArmed = true;
+            m_flushTimer = m_flushExecutor->schedule(m_flushMaxAge, [=] { flushExpired(); });
+        }
+    }
+}
+
+void GatewayDataService::requestFlush()
+{
+    // one request per publish, items keep arriving while publishing is pending
+    if (!m_flushRequested.exchange(true))
+    {
+        m_flush();
+    }
+}
+
+void GatewayDataService::flushExpired()
+{
+    // held for the whole expiry, so destructor either cancels it or sees it finished
+    std::lock_guard<std::mutex> lg{m_flushTimerLock};
+    m_flushTimerArmed = false;
+
+    if (m_queuedItems > 0)
+    {
+        requestFlush();
+    }
+}
+
+void GatewayDataService::resetQueuedCounts()
+{
+    m_queuedItems = 0;
+    m_queuedBytes = 0;
+    m_flushRequested = false;
+}
+
 void GatewayDataService::publishSensorReadings()
 {
+    persistQueuedSensorReadings();
+
     for (const auto& key : m_persistence.getSensorReadingsKeys())
     {
         publishSensorReadingsForPersistanceKey(key);
     }
 }
 
+void GatewayDataService::persistQueuedSensorReadings()
+{
+    resetQueuedCounts();
+
+    for (const auto& queued : m_queuedSensorReadings.drain())
+    {
+        if (queued.reading)
+        {
+            m_persistence.putSensorReading(queued.reading->getReference(), queued.reading);
+            continue;
+        }
+
+        for (const auto& numericReading : queued.numericReadings)
+        {
+            persistNumericReading(numericReading);
+        }
+    }
+}
+
+void GatewayDataService::persistNumericReading(const NumericReading& reading)
+{
+    std::vector<std::string> values(reading.getSize());
+    for (std::size_t i = 0; i < reading.getSize(); ++i)
+    {
+        const double value = reading.getValues()[i];
+        if (!std::isfinite(value))
+        {
+            LOG(WARN) << "Dropping sensor reading with non-finite value: " << reading.getReference();
+            return;
+        }
+
+        JsonWriter::appendNumber(values[i], value);
+    }
+
+    const auto sensorReading =
+      values.size() == 1 ? std::make_shared<SensorReading>(values.front(), reading.getReference(), reading.getRtc()) :
+                           std::make_shared<SensorReading>(values, reading.getReference(), reading.getRtc());
+
+    m_persistence.putSensorReading(reading.getReference(), sensorReading);
+}
+
+void GatewayDataService::persistQueuedAlarms()
+{
+    resetQueuedCounts();
+
+    for (const auto& alarm : m_queuedAlarms.drain())
+    {
+        m_persistence.putAlarm(alarm->getReference(), alarm);
+    }
+}
+
 void GatewayDataService::publishSensorReadingsForPersistanceKey(const std::string& persistanceKey)
 {
     const auto sensorReadings = m_persistence.getSensorReadings(persistanceKey, PUBLISH_BATCH_ITEMS_COUNT);
@@ -198,6 +415,8 @@ void GatewayDataService::publishSensorReadingsForPersistanceKey(const std::strin
 
 void GatewayDataService::publishAlarms()
 {
+    persistQueuedAlarms();
+
     for (const auto& key : m_persistence.getAlarmsKeys())
     {
         publishAlarmsForPersistanceKey(key);
@@ -20,16 +20,25 @@
 #include "InboundMessageHandler.h"
 #include "model/ActuatorStatus.h"
 #include "model/ConfigurationItem.h"
+#include "model/NumericReading.h"
+#include "utilities/Executor.h"
+#include "utilities/IngestQueue.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
 namespace wolkabout
 {
+class Alarm;
 class DataProtocol;
 class Persistence;
+class SensorReading;
 class ConnectivityService;
 class ConfigurationSetCommand;
 class OutboundMessageHandler;
@@ -49,20 +58,66 @@ public:
                        const ConfigurationSetHandler& configurationSetHandler,
                        const ConfigurationGetHandler& configurationGetHandler);
 
+    ~GatewayDataService();
+
     void messageReceived(std::shared_ptr<Message> message) override;
     const Protocol& getProtocol() override;
 
+    /**
+     * @brief Queues sensor reading for publishing, may be called from any thread
+     * Readings reach persistence on the next publishSensorReadings call, so callers do not contend on it
+     */
     void addSensorReading(const std::string& reference, const std::string& value, unsigned long long int rtc);
 
     void addSensorReading(const std::string& reference, const std::vector<std::string>& values,
                           unsigned long long int rtc);
 
+    /**
+     * @brief Queues alarm for publishing, may be called from any thread
+     * Alarms reach persistence on the next publishAlarms call
+     */
+    /**
+     * @brief Queues numeric sensor readings for publishing, may be called from any thread
+     * Values are converted to text only when readings are moved to persistence
+     * @param readings Readings with their time set
+     */
+    void addSensorReadings(std::vector<NumericReading> readings);
+
     void addAlarm(const std::string& reference, bool active, unsigned long long int rtc);
 
     void addActuatorStatus(const std::string& reference, const std::string& value, ActuatorStatus::State state);
 
     void addConfiguration(const std::vector<ConfigurationItem>& configuration);
 
+    /**
+     * @brief Requests publishing of queued sensor readings and alarms once they reach a limit
+     *
+     * Flush is requested once per publish, when number or approximate size of items queued since last publish
+     * reaches its limit, or maxAge after first item was queued. Must be called before items are added.
+     * @param maxItems Number of queued items at which flush is requested, 0 for no limit
+     * @param maxBytes Approximate size of queued items at which flush is requested, 0 for no limit
+     * @param maxAge Time after first queued item at which flush is requested, 0 for no limit
+     * @param executor Executor on which maxAge expiry is handled, required if maxAge is set
+     * @param flush Called from thread which hit the limit, expected to schedule publishSensorReadings and
+     * publishAlarms
+     */
+    void setFlushPolicy(std::size_t maxItems, std::size_t maxBytes, std::chrono::milliseconds maxAge,
+                        Executor* executor, std::function<void()> flush);
+
+    /**
+     * @brief Stores sensor readings and alarms in persistence as they are added, instead of queueing them in memory
+     * Used with durable persistence, so items are kept even if process stops before they are published.
+     * Flush policy still counts items added since last publish. Must be called before items are added.
+     * @param persistOnIngest true to store items as they are added
+     */
+    void setPersistOnIngest(bool persistOnIngest);
+
+    /**
+     * @brief Cancels pending maxAge flush request, waiting for one in progress
+     * Called once items are no longer added, before whatever flush schedules publishing on is destroyed
+     */
+    void cancelFlushTimer();
+
     void publishSensorReadings();
 
     void publishAlarms();
@@ -72,6 +127,15 @@ public:
     void publishConfiguration();
 
 private:
+    void itemsQueued(std::size_t count, std::size_t bytes);
+    void requestFlush();
+    void flushExpired();
+    void resetQueuedCounts();
+
+    void persistQueuedSensorReadings();
+    void persistNumericReading(const NumericReading& reading);
+    void persistQueuedAlarms();
+
     void publishSensorReadingsForPersistanceKey(const std::string& persistanceKey);
     void publishAlarmsForPersistanceKey(const std::string& persistanceKey);
     void publishActuatorStatusesForPersistanceKey(const std::string& persistanceKey);
@@ -89,6 +153,33 @@ private:
     ConfigurationSetHandler m_configurationSetHandler;
     ConfigurationGetHandler m_configurationGetHandler;
 
+    struct QueuedSensorReadings
+    {
+        // either a reading with text values, or a batch of numeric readings
+        std::shared_ptr<SensorReading> reading;
+        std::vector<NumericReading> numericReadings;
+    };
+
+    // single queue for both kinds keeps readings of a reference in submission order
+    IngestQueue<QueuedSensorReadings> m_queuedSensorReadings;
+    IngestQueue<std::shared_ptr<Alarm>> m_queuedAlarms;
+
+    bool m_persistOnIngest;
+
+    std::size_t m_flushMaxItems;
+    std::size_t m_flushMaxBytes;
+    std::chrono::milliseconds m_flushMaxAge;
+    Executor* m_flushExecutor;
+    std::function<void()> m_flush;
+
+    std::atomic<std::size_t> m_queuedItems;
+    std::atomic<std::size_t> m_queuedBytes;
+    std::atomic_bool m_flushRequested;
+
+    std::atomic_bool m_flushTimerArmed;
+    Executor::TaskId m_flushTimer;
+    std::mutex m_flushTimerLock;
+
     static const constexpr unsigned int PUBLISH_BATCH_ITEMS_COUNT = 50;
 };
 }    // namespace wolkabout
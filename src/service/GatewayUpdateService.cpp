@@ -21,7 +21,8 @@
 #include "model/Message.h"
 #include "protocol/RegistrationProtocol.h"
 #include "repository/DeviceRepository.h"
-#include "utilities/Logger.h"
+#include "repository/DeviceTemplateDiff.h"
+#include "utilities/GatewayLog.h"
 
 #include <cassert>
 
@@ -35,12 +36,13 @@ namespace wolkabout
 {
 GatewayUpdateService::GatewayUpdateService(std::string gatewayKey, RegistrationProtocol& protocol,
                                            DeviceRepository& deviceRepository,
-                                           OutboundMessageHandler& outboundPlatformMessageHandler)
+                                           OutboundMessageHandler& outboundPlatformMessageHandler,
+                                           Executor& executor)
 : m_gatewayKey{std::move(gatewayKey)}
 , m_protocol{protocol}
 , m_deviceRepository{deviceRepository}
 , m_outboundPlatformMessageHandler{outboundPlatformMessageHandler}
-, m_platformRetryMessageHandler{outboundPlatformMessageHandler}
+, m_platformRetryMessageHandler{outboundPlatformMessageHandler, executor}
 , m_pendingUpdateRequest{nullptr}
 {
 }
@@ -49,7 +51,7 @@ GatewayUpdateService::~GatewayUpdateService() = default;
 
 void GatewayUpdateService::platformMessageReceived(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     m_platformRetryMessageHandler.messageReceived(message);
 
@@ -87,7 +89,7 @@ void GatewayUpdateService::updateGateway(const DetailedDevice& device)
 {
     std::lock_guard<decltype(m_mutex)> lg{m_mutex};
 
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     auto savedGateway = m_deviceRepository.findByDeviceKey(device.getKey());
     auto newGateway =
@@ -96,7 +98,9 @@ void GatewayUpdateService::updateGateway(const DetailedDevice& device)
     {
         if (*savedGateway != *newGateway)
         {
-            LOG(ERROR) << "GatewayUpdateService: Gateway update already performed, ignoring changes to device template";
+            const DeviceTemplateDiff diff{savedGateway->getTemplate(), newGateway->getTemplate()};
+            LOG(ERROR) << "GatewayUpdateService: Gateway update already performed, ignoring changes to device template"
+                       << (diff.empty() ? "" : ": " + diff.toString());
             return;
         }
 
@@ -125,11 +129,31 @@ void GatewayUpdateService::updateGateway(const DetailedDevice& device)
     m_platformRetryMessageHandler.addMessage(retryMessage);
 }
 
+void GatewayUpdateService::assumeGatewayUpdated(const DetailedDevice& device)
+{
+    std::lock_guard<decltype(m_mutex)> lg{m_mutex};
+
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
+
+    if (m_deviceRepository.containsDeviceWithKey(device.getKey()))
+    {
+        return;
+    }
+
+    LOG(INFO) << "GatewayUpdateService: Gateway is updated by primary shard, saving gateway";
+    m_deviceRepository.save(DetailedDevice(device.getName(), device.getKey(), device.getTemplate()));
+
+    if (m_onGatewayUpdated)
+    {
+        m_onGatewayUpdated();
+    }
+}
+
 void GatewayUpdateService::handleUpdateResponse(const GatewayUpdateResponse& response)
 {
     std::lock_guard<decltype(m_mutex)> lg{m_mutex};
 
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (!m_pendingUpdateRequest)
     {
@@ -142,7 +166,7 @@ void GatewayUpdateService::handleUpdateResponse(const GatewayUpdateResponse& res
     {
         LOG(INFO) << "GatewayUpdateService: Gateway successfully update on platform";
 
-        LOG(DEBUG) << "GatewayUpdateService: Saving gateway";
+        GATEWAY_LOG(DEBUG) << "GatewayUpdateService: Saving gateway";
         m_deviceRepository.save(*m_pendingUpdateRequest);
 
         if (m_onGatewayUpdated)
@@ -29,6 +29,7 @@ namespace wolkabout
 {
 class DetailedDevice;
 class DeviceRepository;
+class Executor;
 class GatewayUpdateResponse;
 class OutboundMessageHandler;
 class RegistrationProtocol;
@@ -37,7 +38,7 @@ class GatewayUpdateService : public PlatformMessageListener
 {
 public:
     GatewayUpdateService(std::string gatewayKey, RegistrationProtocol& protocol, DeviceRepository& deviceRepository,
-                         OutboundMessageHandler& outboundPlatformMessageHandler);
+                         OutboundMessageHandler& outboundPlatformMessageHandler, Executor& executor);
     ~GatewayUpdateService();
 
     void platformMessageReceived(std::shared_ptr<Message> message) override;
@@ -48,6 +49,12 @@ public:
 
     void updateGateway(const DetailedDevice& device);
 
+    /**
+     * @brief Stores gateway as updated without sending update request to platform
+     * Used by shard workers other than primary, which performs the update for all of them
+     */
+    void assumeGatewayUpdated(const DetailedDevice& device);
+
 private:
     void handleUpdateResponse(const GatewayUpdateResponse& response);
 
@@ -19,6 +19,7 @@
 #include "connectivity/ConnectivityService.h"
 #include "model/Message.h"
 #include "protocol/StatusProtocol.h"
+#include "utilities/GatewayLog.h"
 
 namespace wolkabout
 {
@@ -29,10 +30,52 @@ KeepAliveService::KeepAliveService(std::string gatewayKey, StatusProtocol& proto
 , m_protocol{protocol}
 , m_outboundMessageHandler{outboundMessageHandler}
 , m_keepAliveInterval{std::move(keepAliveInterval)}
+, m_lastOutboundMessageCount{0}
+, m_pongTimeout{0}
+, m_executor{nullptr}
+, m_pingSequence{0}
+, m_pingPending{false}
+, m_pongTimeoutTask{0}
+, m_sentPings{MetricsRegistry::getInstance().counter("wolkgateway_keep_alive_pings_total")}
+, m_suppressedPings{MetricsRegistry::getInstance().counter("wolkgateway_keep_alive_suppressed_pings_total")}
+, m_pongTimeouts{MetricsRegistry::getInstance().counter("wolkgateway_keep_alive_pong_timeouts_total")}
+, m_roundTripTime{MetricsRegistry::getInstance().histogram("wolkgateway_keep_alive_round_trip_seconds")}
+, m_lastRoundTripTime{MetricsRegistry::getInstance().gauge("wolkgateway_keep_alive_last_round_trip_milliseconds")}
 {
 }
 
-void KeepAliveService::platformMessageReceived(std::shared_ptr<Message> message) {}
+KeepAliveService::~KeepAliveService()
+{
+    m_timer.stop();
+
+    Executor::TaskId pongTimeoutTask;
+    {
+        std::lock_guard<decltype(m_pingMutex)> lg{m_pingMutex};
+        pongTimeoutTask = m_pongTimeoutTask;
+    }
+
+    // timeout that is already running is waited for
+    if (m_executor && pongTimeoutTask != 0)
+    {
+        m_executor->cancel(pongTimeoutTask);
+    }
+}
+
+void KeepAliveService::platformMessageReceived(std::shared_ptr<Message> /* message */)
+{
+    // only pong messages are routed here
+    std::lock_guard<decltype(m_pingMutex)> lg{m_pingMutex};
+    if (!m_pingPending)
+    {
+        return;
+    }
+
+    m_pingPending = false;
+
+    const auto roundTripTime = std::chrono::steady_clock::now() - m_pingSentAt;
+    m_roundTripTime.record(roundTripTime);
+    m_lastRoundTripTime.set(std::chrono::duration_cast<std::chrono::milliseconds>(roundTripTime).count());
+}
 
 const Protocol& KeepAliveService::getProtocol() const
 {
@@ -41,15 +84,35 @@ const Protocol& KeepAliveService::getProtocol() const
 
 void KeepAliveService::connected()
 {
+    if (m_outboundMessageCount)
+    {
+        // messages published right after connecting count as traffic of the first interval
+        m_lastOutboundMessageCount = m_outboundMessageCount() + 1;
+    }
+
     // send as soon as connected
-    sendPingMessage();
+    ping();
 
-    m_timer.run(std::chrono::duration_cast<std::chrono::milliseconds>(m_keepAliveInterval), [=] { sendPingMessage(); });
+    m_timer.run(std::chrono::duration_cast<std::chrono::milliseconds>(m_keepAliveInterval), [=] { keepAlive(); });
 }
 
 void KeepAliveService::disconnected()
 {
     m_timer.stop();
+
+    Executor::TaskId pongTimeoutTask;
+    {
+        std::lock_guard<decltype(m_pingMutex)> lg{m_pingMutex};
+        ++m_pingSequence;
+        m_pingPending = false;
+        pongTimeoutTask = m_pongTimeoutTask;
+        m_pongTimeoutTask = 0;
+    }
+
+    if (m_executor && pongTimeoutTask != 0)
+    {
+        m_executor->cancel(pongTimeoutTask);
+    }
 }
 
 void KeepAliveService::sendPingMessage() const
@@ -61,4 +124,96 @@ void KeepAliveService::sendPingMessage() const
         m_outboundMessageHandler.addMessage(message);
     }
 }
+
+void KeepAliveService::setOutboundTrafficCounter(std::function<std::uint64_t()> outboundMessageCount)
+{
+    m_outboundMessageCount = std::move(outboundMessageCount);
+}
+
+void KeepAliveService::setPongTimeout(std::chrono::milliseconds timeout, Executor* executor,
+                                      std::function<void()> onPongTimeout)
+{
+    if (timeout.count() > 0 && !executor)
+    {
+        LOG(WARN) << "KeepAliveService: Executor not set, pong timeout will not be detected";
+        return;
+    }
+
+    m_pongTimeout = timeout;
+    m_executor = executor;
+    m_onPongTimeout = std::move(onPongTimeout);
+}
+
+void KeepAliveService::keepAlive()
+{
+    if (m_outboundMessageCount)
+    {
+        const std::uint64_t outboundMessageCount = m_outboundMessageCount();
+        const bool trafficFlowed = outboundMessageCount != m_lastOutboundMessageCount;
+
+        // ping published now is counted with the next interval
+        m_lastOutboundMessageCount = outboundMessageCount + (trafficFlowed ? 0 : 1);
+
+        if (trafficFlowed)
+        {
+            m_suppressedPings.increment();
+            return;
+        }
+    }
+
+    ping();
+}
+
+void KeepAliveService::ping()
+{
+    Executor::TaskId previousTimeoutTask;
+    {
+        std::lock_guard<decltype(m_pingMutex)> lg{m_pingMutex};
+        previousTimeoutTask = m_pongTimeoutTask;
+        m_pongTimeoutTask = 0;
+    }
+
+    if (m_executor && previousTimeoutTask != 0)
+    {
+        m_executor->cancel(previousTimeoutTask);
+    }
+
+    {
+        std::lock_guard<decltype(m_pingMutex)> lg{m_pingMutex};
+
+        const std::uint64_t sequence = ++m_pingSequence;
+        m_pingPending = true;
+        m_pingSentAt = std::chrono::steady_clock::now();
+
+        if (m_executor && m_pongTimeout.count() > 0)
+        {
+            m_pongTimeoutTask = m_executor->schedule(m_pongTimeout, [=] { pongTimedOut(sequence); });
+        }
+    }
+
+    m_sentPings.increment();
+    sendPingMessage();
+}
+
+void KeepAliveService::pongTimedOut(std::uint64_t sequence)
+{
+    {
+        std::lock_guard<decltype(m_pingMutex)> lg{m_pingMutex};
+        if (!m_pingPending || sequence != m_pingSequence)
+        {
+            return;
+        }
+
+        m_pingPending = false;
+    }
+
+    LOG(WARN) << "KeepAliveService: Pong not received within " << m_pongTimeout.count()
+              << "ms, connection to platform is considered lost";
+    m_pongTimeouts.increment();
+
+    if (m_onPongTimeout)
+    {
+        m_onPongTimeout();
+    }
+}
 }    // namespace wolkabout
@@ -19,8 +19,16 @@
 
 #include "ConnectionStatusListener.h"
 #include "InboundPlatformMessageHandler.h"
+#include "utilities/Executor.h"
+#include "utilities/Metrics.h"
 #include "utilities/Timer.h"
 
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+
 namespace wolkabout
 {
 class OutboundMessageHandler;
@@ -32,6 +40,8 @@ public:
     KeepAliveService(std::string gatewayKey, StatusProtocol& protocol, OutboundMessageHandler& outboundMessageHandler,
                      std::chrono::seconds keepAliveInterval);
 
+    ~KeepAliveService();
+
     void platformMessageReceived(std::shared_ptr<Message> message) override;
 
     const Protocol& getProtocol() const override;
@@ -41,7 +51,29 @@ public:
 
     virtual void sendPingMessage() const;
 
+    /**
+     * @brief Suppresses pings while outbound traffic shows connection is alive
+     *
+     * At each keep alive interval the count is compared with the one from previous interval,
+     * and ping is sent only if it did not change. Must be called before connected().
+     * @param outboundMessageCount Returns number of messages published to platform so far
+     */
+    void setOutboundTrafficCounter(std::function<std::uint64_t()> outboundMessageCount);
+
+    /**
+     * @brief Treats connection as lost if pong does not arrive in time after ping
+     * Must be called before connected().
+     * @param timeout Time within which pong is expected, 0 disables detection
+     * @param executor Executor on which timeout is handled, required if timeout is set
+     * @param onPongTimeout Called when pong did not arrive in time
+     */
+    void setPongTimeout(std::chrono::milliseconds timeout, Executor* executor, std::function<void()> onPongTimeout);
+
 private:
+    void keepAlive();
+    void ping();
+    void pongTimedOut(std::uint64_t sequence);
+
     const std::string m_gatewayKey;
 
     StatusProtocol& m_protocol;
@@ -50,6 +82,25 @@ private:
     const std::chrono::seconds m_keepAliveInterval;
 
     Timer m_timer;
+
+    std::function<std::uint64_t()> m_outboundMessageCount;
+    std::uint64_t m_lastOutboundMessageCount;
+
+    std::chrono::milliseconds m_pongTimeout;
+    Executor* m_executor;
+    std::function<void()> m_onPongTimeout;
+
+    std::mutex m_pingMutex;
+    std::uint64_t m_pingSequence;
+    bool m_pingPending;
+    std::chrono::steady_clock::time_point m_pingSentAt;
+    Executor::TaskId m_pongTimeoutTask;
+
+    Counter& m_sentPings;
+    Counter& m_suppressedPings;
+    Counter& m_pongTimeouts;
+    Histogram& m_roundTripTime;
+    Gauge& m_lastRoundTripTime;
 };
 }    // namespace wolkabout
 
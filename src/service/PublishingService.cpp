@@ -17,61 +17,460 @@
 #include "PublishingService.h"
 #include "connectivity/ConnectivityService.h"
 #include "model/Message.h"
-#include "utilities/Logger.h"
+#include "utilities/BandwidthScheduler.h"
+#include "utilities/Deflate.h"
+#include "utilities/GatewayLog.h"
+#include "utilities/MessagePool.h"
+#include "utilities/Tracer.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <utility>
+
+namespace
+{
+const std::chrono::milliseconds INITIAL_RETRY_DELAY{100};
+const std::chrono::milliseconds MAXIMUM_RETRY_DELAY{10000};
+
+const std::string DEVICE_PATH_PREFIX = "/d/";
+
+std::string deviceKeyFromChannel(const std::string& channel)
+{
+    const auto start = channel.find(DEVICE_PATH_PREFIX);
+    if (start == std::string::npos)
+    {
+        return "";
+    }
+
+    const auto keyStart = start + DEVICE_PATH_PREFIX.size();
+    return channel.substr(keyStart, channel.find('/', keyStart) - keyStart);
+}
+}    // namespace
 
 namespace wolkabout
 {
 PublishingService::PublishingService(ConnectivityService& connectivityService,
-                                     std::unique_ptr<GatewayPersistence> persistence)
-: m_connectivityService{connectivityService}
-, m_persistence{std::move(persistence)}
+                                     std::unique_ptr<GatewayPersistence> persistence, std::size_t batchSize,
+                                     const std::string& name)
+: m_batchSize{batchSize != 0 ? batchSize : 1}
 , m_connected{false}
+, m_compressionThreshold{0}
+, m_highWatermark{0}
+, m_lowWatermark{0}
+, m_depth{0}
+, m_backpressure{false}
+, m_failedPublishCount{0}
+, m_queuedMessages{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_queued_messages_total")}
+, m_publishedMessages{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_published_messages_total")}
+, m_droppedMessages{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_dropped_messages_total")}
+, m_failedPublishes{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_failed_publishes_total")}
+, m_unacknowledgedDrops{
+    MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_at_most_once_dropped_messages_total")}
+, m_compressedMessages{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_compressed_messages_total")}
+, m_compressionSavedBytes{
+    MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_compression_saved_bytes_total")}
+, m_queueDepth{MetricsRegistry::getInstance().gauge("wolkgateway_" + name + "_queue_depth")}
+, m_backpressureEvents{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_backpressure_total")}
 , m_run{true}
-, m_worker{new std::thread(&PublishingService::run, this)}
 {
+    startPartition(connectivityService, std::move(persistence));
 }
 
 PublishingService::~PublishingService()
 {
-    m_run = false;
-    m_condition.notify_one();
-    m_worker->join();
+    {
+        std::lock_guard<std::mutex> locker{m_lock};
+        m_run = false;
+    }
+
+    for (auto& partition : m_partitions)
+    {
+        partition->condition.notify_one();
+        partition->worker.join();
+    }
+
+    for (auto& barrier : m_barriers)
+    {
+        barrier.callback(false);
+    }
 }
 
 void PublishingService::addMessage(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << "PublishingService: Message added. Channel: '" << message->getChannel() << "' Payload: '"
-               << message->getContent() << "'";
-    m_persistence->push(message);
-    m_condition.notify_one();
+    GATEWAY_LOG(TRACE) << "PublishingService: Message added. Channel: '" << message->getChannel() << "' Payload: '"
+                       << message->getContent() << "'";
+
+    if (m_compressionThreshold != 0 && message->getContent().size() >= m_compressionThreshold)
+    {
+        std::string compressed;
+        if (Deflate::compress(message->getContent(), m_compressionDictionary, compressed) &&
+            compressed.size() < message->getContent().size())
+        {
+            m_compressedMessages.increment();
+            m_compressionSavedBytes.increment(message->getContent().size() - compressed.size());
+            message = MessagePool::make(std::move(compressed), message->getChannel());
+        }
+    }
+
+    // bound before push, as partition worker may take message as soon as it is queued
+    auto& tracer = Tracer::getInstance();
+    const auto traceId = Tracer::current();
+    tracer.bind(*message, traceId);
+
+    auto& partition = partitionFor(*message);
+    if (!partition.persistence->push(message))
+    {
+        if (traceId != 0)
+        {
+            Tracer::Clock::time_point boundAt;
+            tracer.take(*message, boundAt);
+        }
+
+        m_droppedMessages.increment();
+        return;
+    }
+
+    ++partition.addedCount;
+    m_queuedMessages.increment();
+    m_queueDepth.increment();
+    queueDepthChanged(++m_depth);
+    partition.condition.notify_one();
 }
 
 void PublishingService::connected()
 {
+    {
+        std::lock_guard<std::mutex> locker{m_lock};
+        for (auto& partition : m_partitions)
+        {
+            partition->retryDelay = INITIAL_RETRY_DELAY;
+        }
+    }
+
     m_connected = true;
-    m_condition.notify_one();
+    for (auto& partition : m_partitions)
+    {
+        partition->condition.notify_one();
+    }
 }
 
 void PublishingService::disconnected()
 {
     m_connected = false;
+    for (auto& partition : m_partitions)
+    {
+        partition->condition.notify_one();
+    }
+}
+
+void PublishingService::setCompression(std::size_t threshold, std::string dictionary)
+{
+    m_compressionThreshold = threshold;
+    m_compressionDictionary = std::move(dictionary);
+}
+
+void PublishingService::setBandwidthScheduler(std::shared_ptr<BandwidthScheduler> scheduler)
+{
+    m_bandwidthScheduler = std::move(scheduler);
+}
+
+void PublishingService::setBackpressureListener(std::size_t highWatermark, std::size_t lowWatermark,
+                                                std::function<void(bool)> listener)
+{
+    m_highWatermark = highWatermark;
+    m_lowWatermark = std::min(lowWatermark, highWatermark);
+    m_backpressureListener = std::move(listener);
+}
+
+void PublishingService::setDeliveryClassifier(std::function<DeliveryClass(const Message&)> classifier)
+{
+    m_deliveryClassifier = std::move(classifier);
+}
+
+bool PublishingService::isUnderBackpressure() const
+{
+    return m_backpressure;
+}
+
+void PublishingService::addPartition(ConnectivityService& connectivityService,
+                                     std::unique_ptr<GatewayPersistence> persistence)
+{
+    startPartition(connectivityService, std::move(persistence));
+}
+
+std::size_t PublishingService::getPartitionCount() const
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+    return m_partitions.size();
+}
+
+void PublishingService::whenPublished(std::function<void(bool)> callback)
+{
+    Barrier barrier{{}, std::move(callback)};
+    {
+        std::lock_guard<std::mutex> locker{m_lock};
+        for (const auto& partition : m_partitions)
+        {
+            barrier.addedCounts.push_back(partition->addedCount);
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> locker{m_barrierLock};
+        m_barriers.push_back(std::move(barrier));
+    }
+
+    // workers may have handed all messages over before barrier was registered
+    resolveBarriers();
+}
+
+std::uint64_t PublishingService::getFailedPublishCount() const
+{
+    return m_failedPublishCount;
+}
+
+std::uint64_t PublishingService::getPublishedMessageCount() const
+{
+    return m_publishedMessages.value();
+}
+
+PublishingService::Partition::Partition(ConnectivityService& service, std::unique_ptr<GatewayPersistence> storage)
+: connectivityService{service}
+, persistence{std::move(storage)}
+, retryDelay{INITIAL_RETRY_DELAY}
+, addedCount{0}
+, handedOverCount{0}
+{
+}
+
+void PublishingService::startPartition(ConnectivityService& connectivityService,
+                                       std::unique_ptr<GatewayPersistence> persistence)
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    m_partitions.emplace_back(new Partition(connectivityService, std::move(persistence)));
+    auto& partition = *m_partitions.back();
+    partition.worker = std::thread(&PublishingService::run, this, std::ref(partition));
+}
+
+PublishingService::Partition& PublishingService::partitionFor(const Message& message)
+{
+    if (m_partitions.size() == 1)
+    {
+        return *m_partitions.front();
+    }
+
+    const auto deviceKey = deviceKeyFromChannel(message.getChannel());
+    if (deviceKey.empty())
+    {
+        return *m_partitions.front();
+    }
+
+    return *m_partitions[std::hash<std::string>{}(deviceKey) % m_partitions.size()];
+}
+
+bool PublishingService::allPartitionsEmpty() const
+{
+    return std::all_of(m_partitions.begin(), m_partitions.end(),
+                       [](const std::unique_ptr<Partition>& partition) { return partition->persistence->empty(); });
 }
 
-void PublishingService::run()
+void PublishingService::handedOver(Partition& partition, std::uint64_t count)
 {
+    // only worker of partition hands its messages over
+    if (count > partition.handedOverCount)
+    {
+        partition.handedOverCount = count;
+    }
+
+    resolveBarriers();
+}
+
+void PublishingService::resolveBarriers()
+{
+    std::vector<std::function<void(bool)>> resolved;
+    {
+        std::lock_guard<std::mutex> locker{m_barrierLock};
+        if (m_barriers.empty())
+        {
+            return;
+        }
+
+        auto reached = [&](const Barrier& barrier) {
+            for (std::size_t i = 0; i < barrier.addedCounts.size(); ++i)
+            {
+                if (m_partitions[i]->handedOverCount < barrier.addedCounts[i])
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        auto pending = std::stable_partition(m_barriers.begin(), m_barriers.end(),
+                                             [&](const Barrier& barrier) { return !reached(barrier); });
+        for (auto it = pending; it != m_barriers.end(); ++it)
+        {
+            resolved.push_back(std::move(it->callback));
+        }
+        m_barriers.erase(pending, m_barriers.end());
+    }
+
+    for (const auto& callback : resolved)
+    {
+        callback(true);
+    }
+}
+
+void PublishingService::run(Partition& partition)
+{
+    std::minstd_rand random{std::random_device{}()};
+    auto& tracer = Tracer::getInstance();
+
+    // messages stored before start are not counted as added, so taken ones are counted once persistence drains,
+    // and taken ones of persistence reordering or merging messages are not the oldest added, so they are never counted
+    const bool fifo = partition.persistence->isFifo();
+    bool counting = fifo && partition.persistence->empty();
+
     while (m_run)
     {
-        while (m_connected && !m_persistence->empty())
+        // read before checking for messages, so the count never covers a message added after the check
+        auto added = partition.addedCount.load();
+        while (m_run && m_connected && !partition.persistence->empty())
         {
-            const auto message = m_persistence->front();
-            if (m_connectivityService.publish(message))
+            const auto messages = partition.persistence->frontBatch(m_batchSize);
+
+            std::size_t published = 0;
+            std::size_t taken = 0;
+            for (const auto& message : messages)
+            {
+                const bool tracing = tracer.enabled();
+                const auto publishedAt = tracing ? Tracer::Clock::now() : Tracer::Clock::time_point{};
+
+                if (!m_connected)
+                {
+                    break;
+                }
+
+                if (!partition.connectivityService.publish(message))
+                {
+                    if (!m_connected || !m_deliveryClassifier ||
+                        m_deliveryClassifier(*message) != DeliveryClass::AT_MOST_ONCE)
+                    {
+                        break;
+                    }
+
+                    GATEWAY_LOG(DEBUG) << "PublishingService: Publish failed, dropping message on channel '"
+                                       << message->getChannel() << "'";
+
+                    if (tracing)
+                    {
+                        Tracer::Clock::time_point boundAt;
+                        tracer.take(*message, boundAt);
+                    }
+
+                    m_unacknowledgedDrops.increment();
+                    ++taken;
+                    continue;
+                }
+
+                // trace is taken once message leaves the queue, failed publish keeps it for the retry
+                if (tracing)
+                {
+                    Tracer::Clock::time_point boundAt;
+                    if (const auto traceId = tracer.take(*message, boundAt))
+                    {
+                        tracer.record("publish_queue", traceId, boundAt, publishedAt);
+                        tracer.record("publish", traceId, publishedAt, Tracer::Clock::now());
+                    }
+                }
+
+                if (m_bandwidthScheduler)
+                {
+                    m_bandwidthScheduler->telemetrySent(message->getChannel().size() + message->getContent().size());
+                }
+
+                ++published;
+                ++taken;
+            }
+
+            if (taken != 0)
             {
-                m_persistence->pop();
+                partition.persistence->popBatch(taken);
+                if (counting)
+                {
+                    handedOver(partition, partition.handedOverCount + taken);
+                }
+                m_publishedMessages.increment(published);
+                m_queueDepth.decrement(static_cast<std::int64_t>(taken));
+                queueDepthChanged(m_depth -= std::min<std::size_t>(taken, m_depth));
             }
+
+            if (taken == messages.size() || !m_connected)
+            {
+                std::lock_guard<std::mutex> locker{m_lock};
+                partition.retryDelay = INITIAL_RETRY_DELAY;
+                added = partition.addedCount.load();
+                continue;
+            }
+
+            ++m_failedPublishCount;
+            m_failedPublishes.increment();
+
+            std::unique_lock<std::mutex> locker{m_lock};
+            // wait somewhere between half and full delay so publishers do not retry in lockstep
+            const auto delay = std::chrono::milliseconds{std::uniform_int_distribution<std::chrono::milliseconds::rep>{
+              partition.retryDelay.count() / 2, partition.retryDelay.count()}(random)};
+            partition.retryDelay = std::min(partition.retryDelay * 2, MAXIMUM_RETRY_DELAY);
+
+            GATEWAY_LOG(DEBUG) << "PublishingService: Publish failed, retrying in " << delay.count() << "ms";
+            partition.condition.wait_for(locker, delay, [&] { return !m_run || !m_connected; });
+        }
+
+        // messages persistence dropped are not reported either, so all added before the check are handed over
+        if (partition.persistence->empty())
+        {
+            counting = fifo;
+            handedOver(partition, added);
         }
 
         std::unique_lock<std::mutex> locker{m_lock};
-        m_condition.wait(locker);
+
+        // persistences dropping oldest messages do not report it, so depth is resynchronized once drained
+        if (m_connected && m_depth != 0 && allPartitionsEmpty())
+        {
+            m_depth = 0;
+            locker.unlock();
+            queueDepthChanged(0);
+            locker.lock();
+        }
+
+        partition.condition.wait(locker, [&] { return !m_run || (m_connected && !partition.persistence->empty()); });
+    }
+}
+
+void PublishingService::queueDepthChanged(std::size_t depth)
+{
+    if (m_highWatermark == 0 || !m_backpressureListener)
+    {
+        return;
+    }
+
+    // transitions are serialized so listener never observes release before the matching apply
+    std::lock_guard<std::mutex> locker{m_backpressureLock};
+    if (!m_backpressure && depth >= m_highWatermark)
+    {
+        GATEWAY_LOG(INFO) << "PublishingService: Queue reached " << depth << " messages, applying backpressure";
+        m_backpressure = true;
+        m_backpressureEvents.increment();
+        m_backpressureListener(true);
+    }
+    else if (m_backpressure && depth <= m_lowWatermark)
+    {
+        GATEWAY_LOG(INFO) << "PublishingService: Queue drained to " << depth << " messages, releasing backpressure";
+        m_backpressure = false;
+        m_backpressureListener(false);
     }
 }
 }    // namespace wolkabout
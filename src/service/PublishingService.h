@@ -19,21 +19,38 @@
 
 #include "ConnectionStatusListener.h"
 #include "OutboundMessageHandler.h"
+#include "model/DeliveryClass.h"
 #include "persistence/GatewayPersistence.h"
+#include "utilities/Metrics.h"
+
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
+#include <vector>
 
 namespace wolkabout
 {
+class BandwidthScheduler;
 class ConnectivityService;
 
 class PublishingService : public OutboundMessageHandler, public ConnectionStatusListener
 {
 public:
-    PublishingService(ConnectivityService& connectivityService, std::unique_ptr<GatewayPersistence> persistence);
+    /**
+     * @param connectivityService Service used for publishing
+     * @param persistence Storage holding messages until they are published
+     * @param batchSize Maximum number of messages taken from persistence at once
+     * @param name Prefix of metrics reported by this instance
+     */
+    PublishingService(ConnectivityService& connectivityService, std::unique_ptr<GatewayPersistence> persistence,
+                      std::size_t batchSize = 1, const std::string& name = "publisher");
     ~PublishingService();
 
     void addMessage(std::shared_ptr<Message> message) override;
@@ -41,18 +58,151 @@ public:
     void connected() override;
     void disconnected() override;
 
+    /**
+     * @brief Compresses payloads of messages added from now on whose size reaches threshold
+     *
+     * Payloads are replaced by zlib streams before they are stored, so queued messages take less space too.
+     * Receiver must inflate payloads starting with byte 0x78 using the same dictionary.
+     * @param threshold Minimum payload size in bytes, 0 disables compression
+     * @param dictionary Preset dictionary, empty for none
+     */
+    void setCompression(std::size_t threshold, std::string dictionary);
+
+    /**
+     * @brief Accounts published messages as telemetry in scheduler, so that bulk transfers yield to them
+     * @param scheduler Scheduler of link on which messages are published, nullptr for none
+     */
+    void setBandwidthScheduler(std::shared_ptr<BandwidthScheduler> scheduler);
+
+    /**
+     * @brief Reports when number of queued messages crosses watermarks, so producers can back off
+     *
+     * Listener is called with true once queue holds highWatermark messages and with false once it is drained
+     * down to lowWatermark, on thread that added or published the message. Must be called before messages are added
+     * @param highWatermark Number of queued messages at which backpressure is applied, 0 disables it
+     * @param lowWatermark Number of queued messages at which backpressure is released
+     * @param listener Called when backpressure is applied or released
+     */
+    void setBackpressureListener(std::size_t highWatermark, std::size_t lowWatermark,
+                                 std::function<void(bool)> listener);
+
+    /**
+     * @brief Selects delivery guarantee of each message as it is published
+     *
+     * Message classified as DeliveryClass::AT_MOST_ONCE is dropped if its publish fails while connected,
+     * instead of holding up messages queued behind it with retries. Messages are kept while disconnected regardless
+     * of their class. Must be called before messages are added
+     * @param classifier Returns delivery class of message, all messages are DeliveryClass::AT_LEAST_ONCE without it
+     */
+    void setDeliveryClassifier(std::function<DeliveryClass(const Message&)> classifier);
+
+    /**
+     * @brief Returns true while queue is above low watermark after reaching high watermark
+     */
+    bool isUnderBackpressure() const;
+
+    /**
+     * @brief Adds partition publishing over its own connection, with its own worker and persistence
+     *
+     * Messages are partitioned by key of device in their channel, so messages of one device stay in order,
+     * and messages without device key go to the first partition. Retries of a partition whose publishes fail
+     * do not delay other partitions. Must be called before messages are added
+     * @param connectivityService Service used for publishing messages of partition
+     * @param persistence Storage holding messages of partition until they are published
+     */
+    void addPartition(ConnectivityService& connectivityService, std::unique_ptr<GatewayPersistence> persistence);
+
+    std::size_t getPartitionCount() const;
+
+    /**
+     * @brief Calls callback once all messages added so far are handed to connectivity service
+     *
+     * Messages dropped by their persistence or as DeliveryClass::AT_MOST_ONCE count as handed over.
+     * With persistence which is not FIFO, messages count as handed over only once partition is drained.
+     * Callback is called with true on publishing thread, or right away if nothing is queued,
+     * and with false if service is destroyed first
+     * @param callback Called once messages are handed over
+     */
+    void whenPublished(std::function<void(bool)> callback);
+
+    /**
+     * @brief Returns number of publish attempts that failed while connected
+     */
+    std::uint64_t getFailedPublishCount() const;
+
+    /**
+     * @brief Returns number of messages published so far
+     */
+    std::uint64_t getPublishedMessageCount() const;
+
 private:
-    void run();
+    struct Partition
+    {
+        Partition(ConnectivityService& service, std::unique_ptr<GatewayPersistence> storage);
+
+        ConnectivityService& connectivityService;
+        std::unique_ptr<GatewayPersistence> persistence;
+        std::chrono::milliseconds retryDelay;
+        std::condition_variable condition;
+        std::thread worker;
+
+        std::atomic<std::uint64_t> addedCount;
+        std::atomic<std::uint64_t> handedOverCount;
+    };
 
-    ConnectivityService& m_connectivityService;
-    std::unique_ptr<GatewayPersistence> m_persistence;
+    struct Barrier
+    {
+        std::vector<std::uint64_t> addedCounts;
+        std::function<void(bool)> callback;
+    };
+
+    void startPartition(ConnectivityService& connectivityService, std::unique_ptr<GatewayPersistence> persistence);
+    Partition& partitionFor(const Message& message);
+    bool allPartitionsEmpty() const;
+
+    void handedOver(Partition& partition, std::uint64_t count);
+    void resolveBarriers();
+
+    void run(Partition& partition);
+
+    void queueDepthChanged(std::size_t depth);
+
+    const std::size_t m_batchSize;
 
     std::atomic_bool m_connected;
 
+    std::size_t m_compressionThreshold;
+    std::string m_compressionDictionary;
+
+    std::shared_ptr<BandwidthScheduler> m_bandwidthScheduler;
+
+    std::size_t m_highWatermark;
+    std::size_t m_lowWatermark;
+    std::function<void(bool)> m_backpressureListener;
+
+    std::function<DeliveryClass(const Message&)> m_deliveryClassifier;
+    std::atomic<std::size_t> m_depth;
+    std::atomic_bool m_backpressure;
+    std::mutex m_backpressureLock;
+
+    std::atomic<std::uint64_t> m_failedPublishCount;
+
+    Counter& m_queuedMessages;
+    Counter& m_publishedMessages;
+    Counter& m_droppedMessages;
+    Counter& m_failedPublishes;
+    Counter& m_unacknowledgedDrops;
+    Counter& m_compressedMessages;
+    Counter& m_compressionSavedBytes;
+    Gauge& m_queueDepth;
+    Counter& m_backpressureEvents;
+
+    std::mutex m_barrierLock;
+    std::vector<Barrier> m_barriers;
+
     std::atomic_bool m_run;
-    std::mutex m_lock;
-    std::condition_variable m_condition;
-    std::unique_ptr<std::thread> m_worker;
+    mutable std::mutex m_lock;
+    std::vector<std::unique_ptr<Partition>> m_partitions;
 };
 }    // namespace wolkabout
 
@@ -0,0 +1,443 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "service/ReadingTransformer.h"
+#include "utilities/JsonReader.h"
+#include "utilities/JsonWriter.h"
+#include "utilities/Logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <utility>
+
+namespace wolkabout
+{
+namespace
+{
+const char* const ANY_DEVICE = "*";
+const char* const READING_DATA_FIELD = "data";
+const char* const WHITESPACE = " \t\r\n";
+const char VALUE_SEPARATOR = ',';
+
+const int MAX_DECIMALS = 15;
+
+struct Unit
+{
+    const char* name;
+    const char* quantity;
+    // value in base unit of quantity is value * factor + offset
+    double factor;
+    double offset;
+};
+
+const Unit UNITS[] = {{"K", "temperature", 1, 0},
+                      {"C", "temperature", 1, 273.15},
+                      {"F", "temperature", 5.0 / 9, 273.15 - 32 * 5.0 / 9},
+                      {"Pa", "pressure", 1, 0},
+                      {"hPa", "pressure", 100, 0},
+                      {"kPa", "pressure", 1000, 0},
+                      {"bar", "pressure", 100000, 0},
+                      {"psi", "pressure", 6894.757293168, 0},
+                      {"mm", "length", 0.001, 0},
+                      {"cm", "length", 0.01, 0},
+                      {"m", "length", 1, 0},
+                      {"km", "length", 1000, 0}};
+
+std::string makeKey(const std::string& deviceKey, const std::string& reference)
+{
+    std::string key;
+    key.reserve(deviceKey.size() + reference.size() + 1);
+    key.append(deviceKey).append(1, '/').append(reference);
+    return key;
+}
+
+bool parseNumber(const std::string& text, double& value)
+{
+    if (text.empty())
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size() && std::isfinite(value);
+}
+
+bool parsePair(const std::string& text, std::string& first, std::string& second)
+{
+    const auto separator = text.find(':');
+    if (separator == std::string::npos)
+    {
+        return false;
+    }
+
+    first = text.substr(0, separator);
+    second = text.substr(separator + 1);
+    return true;
+}
+
+const Unit* findUnit(const std::string& name)
+{
+    for (const auto& unit : UNITS)
+    {
+        if (name == unit.name)
+        {
+            return &unit;
+        }
+    }
+
+    return nullptr;
+}
+}    // namespace
+
+ReadingTransformer::ReadingTransformer() : m_programs{std::make_shared<const Programs>()} {}
+
+bool ReadingTransformer::loadRules(const std::string& path)
+{
+    std::ifstream file{path};
+    if (!file.is_open())
+    {
+        LOG(ERROR) << "ReadingTransformer: Unable to open rule file '" << path << "'";
+        return false;
+    }
+
+    std::shared_ptr<Programs> programs = std::make_shared<Programs>();
+
+    std::string line;
+    unsigned lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+
+        std::istringstream fields{line};
+        std::string deviceKey;
+        if (!(fields >> deviceKey) || deviceKey[0] == '#')
+        {
+            continue;
+        }
+
+        std::string reference;
+        std::vector<std::string> operations;
+        std::string operation;
+        fields >> reference;
+        while (fields >> operation)
+        {
+            operations.push_back(operation);
+        }
+
+        Program program;
+        if (reference.empty() || !compile(operations, program))
+        {
+            LOG(ERROR) << "ReadingTransformer: Invalid line " << lineNumber << " in rule file '" << path << "'";
+            return false;
+        }
+
+        (*programs)[makeKey(deviceKey, reference)] = std::move(program);
+    }
+
+    std::atomic_store(&m_programs, std::shared_ptr<const Programs>{programs});
+    return true;
+}
+
+ReadingTransformer::Result ReadingTransformer::transform(const std::string& deviceKey, std::string& reference,
+                                                         const std::string& payload,
+                                                         std::string& transformedPayload) const
+{
+    const auto programs = std::atomic_load(&m_programs);
+    if (programs->empty())
+    {
+        return Result::UNCHANGED;
+    }
+
+    auto it = programs->find(makeKey(deviceKey, reference));
+    if (it == programs->end())
+    {
+        it = programs->find(makeKey(ANY_DEVICE, reference));
+    }
+
+    if (it == programs->end())
+    {
+        return Result::UNCHANGED;
+    }
+
+    const Program& program = it->second;
+    if (program.drop)
+    {
+        return Result::DROPPED;
+    }
+
+    const bool rewritten = !program.instructions.empty() && rewrite(program, payload, transformedPayload);
+    if (program.reference.empty())
+    {
+        return rewritten ? Result::TRANSFORMED : Result::UNCHANGED;
+    }
+
+    if (!rewritten)
+    {
+        transformedPayload = payload;
+    }
+
+    reference = program.reference;
+    return Result::TRANSFORMED;
+}
+
+bool ReadingTransformer::compile(const std::vector<std::string>& operations, Program& program)
+{
+    program.instructions.clear();
+    program.reference.clear();
+    program.drop = false;
+
+    if (operations.empty())
+    {
+        return false;
+    }
+
+    for (const auto& operation : operations)
+    {
+        if (operation == "drop")
+        {
+            program.drop = true;
+            continue;
+        }
+
+        const auto assignment = operation.find('=');
+        if (assignment == std::string::npos)
+        {
+            return false;
+        }
+
+        const std::string name = operation.substr(0, assignment);
+        const std::string argument = operation.substr(assignment + 1);
+
+        Instruction instruction{Opcode::MULTIPLY_ADD, 1, 0};
+        if (name == "scale")
+        {
+            if (!parseNumber(argument, instruction.a))
+            {
+                return false;
+            }
+        }
+        else if (name == "offset")
+        {
+            if (!parseNumber(argument, instruction.b))
+            {
+                return false;
+            }
+        }
+        else if (name == "unit")
+        {
+            std::string fromName;
+            std::string toName;
+            if (!parsePair(argument, fromName, toName))
+            {
+                return false;
+            }
+
+            const Unit* from = findUnit(fromName);
+            const Unit* to = findUnit(toName);
+            if (!from || !to || std::strcmp(from->quantity, to->quantity) != 0)
+            {
+                return false;
+            }
+
+            instruction.a = from->factor / to->factor;
+            instruction.b = (from->offset - to->offset) / to->factor;
+        }
+        else if (name == "clamp")
+        {
+            std::string minimum;
+            std::string maximum;
+            instruction.opcode = Opcode::CLAMP;
+            if (!parsePair(argument, minimum, maximum) || !parseNumber(minimum, instruction.a) ||
+                !parseNumber(maximum, instruction.b) || instruction.a > instruction.b)
+            {
+                return false;
+            }
+        }
+        else if (name == "round")
+        {
+            double decimals;
+            instruction.opcode = Opcode::ROUND;
+            if (!parseNumber(argument, decimals) || decimals < 0 || decimals > MAX_DECIMALS ||
+                std::floor(decimals) < decimals)
+            {
+                return false;
+            }
+
+            instruction.a = std::pow(10.0, decimals);
+        }
+        else if (name == "rename")
+        {
+            if (argument.empty() || argument.find('/') != std::string::npos)
+            {
+                return false;
+            }
+
+            program.reference = argument;
+            continue;
+        }
+        else
+        {
+            return false;
+        }
+
+        // consecutive multiply-adds are folded, so any chain of scale, offset and unit is one instruction
+        if (instruction.opcode == Opcode::MULTIPLY_ADD && !program.instructions.empty() &&
+            program.instructions.back().opcode == Opcode::MULTIPLY_ADD)
+        {
+            Instruction& previous = program.instructions.back();
+            previous.b = previous.b * instruction.a + instruction.b;
+            previous.a *= instruction.a;
+            continue;
+        }
+
+        program.instructions.push_back(instruction);
+    }
+
+    return true;
+}
+
+double ReadingTransformer::execute(const std::vector<Instruction>& instructions, double value)
+{
+    for (const auto& instruction : instructions)
+    {
+        switch (instruction.opcode)
+        {
+        case Opcode::MULTIPLY_ADD:
+            value = value * instruction.a + instruction.b;
+            break;
+        case Opcode::CLAMP:
+            value = std::min(std::max(value, instruction.a), instruction.b);
+            break;
+        case Opcode::ROUND:
+            value = std::round(value * instruction.a) / instruction.a;
+            break;
+        }
+    }
+
+    return value;
+}
+
+bool ReadingTransformer::rewrite(const Program& program, const std::string& payload, std::string& result)
+{
+    struct Data
+    {
+        // span of "data" member value in payload, including whitespace before it
+        std::size_t begin;
+        std::size_t end;
+        std::string text;
+    };
+
+    std::vector<Data> values;
+    JsonReader reader{payload};
+
+    const auto readReading = [&]() {
+        std::string field;
+        if (!reader.beginObject())
+        {
+            return false;
+        }
+
+        while (reader.nextMember(field))
+        {
+            if (field != READING_DATA_FIELD)
+            {
+                reader.skipValue();
+                continue;
+            }
+
+            Data data;
+            data.begin = reader.getPosition();
+            if (!reader.readString(data.text))
+            {
+                return false;
+            }
+
+            data.end = reader.getPosition();
+            values.push_back(std::move(data));
+        }
+
+        return !reader.failed();
+    };
+
+    const auto first = payload.find_first_not_of(WHITESPACE);
+    if (first != std::string::npos && payload[first] == '[')
+    {
+        reader.beginArray();
+        while (reader.nextElement() && readReading())
+        {
+        }
+    }
+    else
+    {
+        readReading();
+    }
+
+    if (!reader.finish() || values.empty())
+    {
+        return false;
+    }
+
+    result.clear();
+    result.reserve(payload.size() + 16 * values.size());
+
+    std::string text;
+    std::size_t copied = 0;
+    for (const auto& data : values)
+    {
+        result.append(payload, copied, data.begin - copied).append(1, '"');
+
+        std::size_t start = 0;
+        while (true)
+        {
+            const auto end = std::min(data.text.find(VALUE_SEPARATOR, start), data.text.size());
+
+            double value;
+            text.assign(data.text, start, end - start);
+            if (!parseNumber(text, value))
+            {
+                return false;
+            }
+
+            value = execute(program.instructions, value);
+            if (!std::isfinite(value))
+            {
+                return false;
+            }
+
+            JsonWriter::appendNumber(result, value);
+            if (end == data.text.size())
+            {
+                break;
+            }
+
+            result.append(1, VALUE_SEPARATOR);
+            start = end + 1;
+        }
+
+        result.append(1, '"');
+        copied = data.end;
+    }
+
+    result.append(payload, copied, std::string::npos);
+    return true;
+}
+}    // namespace wolkabout
@@ -0,0 +1,110 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef READINGTRANSFORMER_H
+#define READINGTRANSFORMER_H
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Rescales, renames or drops subdevice sensor readings before they are routed to platform
+ *
+ * Rules are loaded from file and compiled once per device key and reference into a flat list of
+ * instructions, in which consecutive scale, offset and unit conversions are folded into one multiply-add.
+ * Applying a rule to a reading therefore costs one lookup and a pass over its values.
+ */
+class ReadingTransformer
+{
+public:
+    enum class Result
+    {
+        // no rule for reading, it is forwarded as received
+        UNCHANGED,
+        TRANSFORMED,
+        DROPPED
+    };
+
+    ReadingTransformer();
+
+    /**
+     * @brief Loads transformation rules
+     *
+     * Each line holds device key ('*' for any device), sensor reference and one or more operations,
+     * applied in order:
+     *  scale=<factor>, offset=<value>, unit=<from>:<to> (C, F, K, Pa, hPa, kPa, bar, psi, mm, cm, m, km),
+     *  clamp=<min>:<max>, round=<decimals>, rename=<reference> and drop.
+     * Empty lines and lines starting with '#' are ignored.
+     * Can be called again while readings are transformed, loaded rules replace previous ones.
+     * @param path Path of rule file
+     * @return false if file can not be read or has invalid line, in which case previous rules are kept
+     */
+    bool loadRules(const std::string& path);
+
+    /**
+     * @brief Applies rule of sensor to reading payload
+     * @param deviceKey Key of device which sent reading
+     * @param reference Sensor reference, receives reference reading is routed with if rule renames it
+     * @param payload Reading payload
+     * @param transformedPayload Receives payload to route, readings with non-numeric values are only renamed
+     * @return Result of transformation, reference and transformedPayload are meaningful only if reading is TRANSFORMED
+     */
+    Result transform(const std::string& deviceKey, std::string& reference, const std::string& payload,
+                     std::string& transformedPayload) const;
+
+private:
+    enum class Opcode
+    {
+        // value * a + b
+        MULTIPLY_ADD,
+        // clamps value to [a, b]
+        CLAMP,
+        // rounds value to multiple of a
+        ROUND
+    };
+
+    struct Instruction
+    {
+        Opcode opcode;
+        double a;
+        double b;
+    };
+
+    struct Program
+    {
+        std::vector<Instruction> instructions;
+        // empty if reading keeps its reference
+        std::string reference;
+        bool drop;
+    };
+
+    using Programs = std::unordered_map<std::string, Program>;
+
+    static bool compile(const std::vector<std::string>& operations, Program& program);
+
+    static double execute(const std::vector<Instruction>& instructions, double value);
+    static bool rewrite(const Program& program, const std::string& payload, std::string& result);
+
+    // keyed by "<device key>/<reference>", replaced as a whole on load and read through std::atomic_load
+    std::shared_ptr<const Programs> m_programs;
+};
+}    // namespace wolkabout
+
+#endif    // READINGTRANSFORMER_H
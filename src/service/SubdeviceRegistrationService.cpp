@@ -24,7 +24,8 @@
 #include "protocol/GatewaySubdeviceRegistrationProtocol.h"
 #include "protocol/RegistrationProtocol.h"
 #include "repository/DeviceRepository.h"
-#include "utilities/Logger.h"
+#include "repository/SQLiteDeviceRepository.h"
+#include "utilities/GatewayLog.h"
 
 #include <algorithm>
 #include <cassert>
@@ -33,34 +34,83 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 namespace
 {
-static const short RETRY_COUNT = 3;
-static const std::chrono::milliseconds RETRY_TIMEOUT{5000};
+static const std::size_t DELETION_REQUEST_BATCH_SIZE = 100;
+
+// accepted devices are saved together once this many are held, or this long after the first one was accepted
+static const std::size_t REGISTERED_DEVICES_SAVE_BATCH_SIZE = 100;
+static const std::chrono::milliseconds REGISTERED_DEVICES_SAVE_DELAY{50};
 }    // namespace
 
 namespace wolkabout
 {
+const short SubdeviceRegistrationService::DEFAULT_RETRY_COUNT = 3;
+const std::chrono::milliseconds SubdeviceRegistrationService::DEFAULT_RETRY_TIMEOUT{5000};
+
 SubdeviceRegistrationService::SubdeviceRegistrationService(std::string gatewayKey, RegistrationProtocol& protocol,
                                                            GatewaySubdeviceRegistrationProtocol& gatewayProtocol,
                                                            DeviceRepository& deviceRepository,
                                                            OutboundMessageHandler& outboundPlatformMessageHandler,
-                                                           OutboundMessageHandler& outboundDeviceMessageHandler)
+                                                           OutboundMessageHandler& outboundDeviceMessageHandler,
+                                                           Executor& executor, short retryCount,
+                                                           std::chrono::milliseconds retryTimeout)
 : m_gatewayKey{std::move(gatewayKey)}
 , m_protocol{protocol}
 , m_gatewayProtocol{gatewayProtocol}
 , m_deviceRepository{deviceRepository}
 , m_outboundPlatformMessageHandler{outboundPlatformMessageHandler}
 , m_outboundDeviceMessageHandler{outboundDeviceMessageHandler}
-, m_platformRetryMessageHandler{outboundPlatformMessageHandler}
+, m_platformRetryMessageHandler{outboundPlatformMessageHandler, executor}
+, m_retryCount{std::max<short>(retryCount, 0)}
+, m_retryTimeout{retryTimeout}
+, m_executor{executor}
+, m_registrationRetryTask{0}
+, m_registrationRetryScheduled{false}
+, m_registeredDevicesSaveTask{0}
+, m_registeredDevicesSaveScheduled{false}
+, m_stopped{false}
+{
+}
+
+SubdeviceRegistrationService::~SubdeviceRegistrationService()
 {
+    Executor::TaskId task;
+    bool isScheduled;
+    Executor::TaskId saveTask;
+    bool isSaveScheduled;
+
+    {
+        std::lock_guard<decltype(m_devicesAwaitingRegistrationResponseMutex)> l{
+          m_devicesAwaitingRegistrationResponseMutex};
+        m_stopped = true;
+        task = m_registrationRetryTask;
+        isScheduled = m_registrationRetryScheduled;
+        saveTask = m_registeredDevicesSaveTask;
+        isSaveScheduled = m_registeredDevicesSaveScheduled;
+    }
+
+    // retry that is already running is waited for, and will not schedule another one
+    if (isScheduled)
+    {
+        m_executor.cancel(task);
+    }
+
+    if (isSaveScheduled)
+    {
+        m_executor.cancel(saveTask);
+    }
+
+    // devices accepted by platform are kept, listeners and devices are not notified while shutting down
+    saveRegisteredDevices(false);
 }
 
 void SubdeviceRegistrationService::platformMessageReceived(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     m_platformRetryMessageHandler.messageReceived(message);
 
@@ -90,7 +140,7 @@ void SubdeviceRegistrationService::platformMessageReceived(std::shared_ptr<Messa
 
 void SubdeviceRegistrationService::deviceMessageReceived(std::shared_ptr<Message> message)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (!m_gatewayProtocol.isSubdeviceRegistrationRequest(*message))
     {
@@ -142,41 +192,86 @@ void SubdeviceRegistrationService::invokeOnDeviceRegisteredListener(const std::s
     }
 }
 
+void SubdeviceRegistrationService::onDeviceDeleted(std::function<void(const std::string& deviceKey)> onDeviceDeleted)
+{
+    m_onDeviceDeleted = onDeviceDeleted;
+}
+
+void SubdeviceRegistrationService::invokeOnDeviceDeletedListener(const std::string& deviceKey) const
+{
+    if (m_onDeviceDeleted)
+    {
+        m_onDeviceDeleted(deviceKey);
+    }
+}
+
 void SubdeviceRegistrationService::deleteDevicesOtherThan(const std::vector<std::string>& devicesKeys)
 {
+    const std::unordered_set<std::string> keptDeviceKeys{devicesKeys.begin(), devicesKeys.end()};
+
     const auto deviceKeysFromRepository = m_deviceRepository.findAllDeviceKeys();
+    std::vector<std::string> deletedDeviceKeys;
     for (const std::string& deviceKeyFromRepository : *deviceKeysFromRepository)
     {
-        if (std::find(devicesKeys.begin(), devicesKeys.end(), deviceKeyFromRepository) == devicesKeys.end())
+        if (keptDeviceKeys.find(deviceKeyFromRepository) != keptDeviceKeys.end())
         {
-            if (deviceKeyFromRepository == m_gatewayKey)
-            {
-                LOG(DEBUG) << "Skiping delete gateway";
-                continue;
-            }
+            continue;
+        }
 
-            LOG(INFO) << "Deleting device with key " << deviceKeyFromRepository;
-            m_deviceRepository.remove(deviceKeyFromRepository);
+        if (deviceKeyFromRepository == m_gatewayKey)
+        {
+            GATEWAY_LOG(DEBUG) << "Skiping delete gateway";
+            continue;
+        }
 
-            std::shared_ptr<Message> subdeviceDeletionRequestMessage =
-              m_protocol.makeMessage(m_gatewayKey, SubdeviceDeletionRequest{deviceKeyFromRepository});
-            if (!subdeviceDeletionRequestMessage)
-            {
-                LOG(WARN) << "SubdeviceRegistrationService: Unable to create deletion request message";
-                continue;
-            }
+        LOG(INFO) << "Deleting device with key " << deviceKeyFromRepository;
+        deletedDeviceKeys.push_back(deviceKeyFromRepository);
+    }
+
+    if (deletedDeviceKeys.empty())
+    {
+        return;
+    }
+
+    m_deviceRepository.removeMany(deletedDeviceKeys);
+    for (const std::string& deletedDeviceKey : deletedDeviceKeys)
+    {
+        forgetRegistration(deletedDeviceKey);
+    }
+
+    std::vector<RetryMessageStruct> retryMessages;
+    retryMessages.reserve(deletedDeviceKeys.size());
+    for (const std::string& deletedDeviceKey : deletedDeviceKeys)
+    {
+        invokeOnDeviceDeletedListener(deletedDeviceKey);
+
+        std::shared_ptr<Message> subdeviceDeletionRequestMessage =
+          m_protocol.makeMessage(m_gatewayKey, SubdeviceDeletionRequest{deletedDeviceKey});
+        if (!subdeviceDeletionRequestMessage)
+        {
+            LOG(WARN) << "SubdeviceRegistrationService: Unable to create deletion request message";
+            continue;
+        }
+
+        auto responseChannel = m_protocol.getResponseChannel(m_gatewayKey, *subdeviceDeletionRequestMessage);
+        retryMessages.push_back(RetryMessageStruct{subdeviceDeletionRequestMessage, responseChannel,
+                                                   [=](std::shared_ptr<Message>) {
+                                                       LOG(ERROR) << "Failed to delete device with key: "
+                                                                  << deletedDeviceKey << ", no response from platform";
+                                                   },
+                                                   m_retryCount, m_retryTimeout});
 
-            auto responseChannel = m_protocol.getResponseChannel(m_gatewayKey, *subdeviceDeletionRequestMessage);
-            RetryMessageStruct retryMessage{subdeviceDeletionRequestMessage, responseChannel,
-                                            [=](std::shared_ptr<Message>) {
-                                                LOG(ERROR)
-                                                  << "Failed to delete device with key: " << deviceKeyFromRepository
-                                                  << ", no response from platform";
-                                            },
-                                            RETRY_COUNT, RETRY_TIMEOUT};
-            m_platformRetryMessageHandler.addMessage(retryMessage);
+        if (retryMessages.size() == DELETION_REQUEST_BATCH_SIZE)
+        {
+            m_platformRetryMessageHandler.addMessages(std::move(retryMessages));
+            retryMessages.clear();
         }
     }
+
+    if (!retryMessages.empty())
+    {
+        m_platformRetryMessageHandler.addMessages(std::move(retryMessages));
+    }
 }
 
 void SubdeviceRegistrationService::registerPostponedDevices()
@@ -187,6 +282,10 @@ void SubdeviceRegistrationService::registerPostponedDevices()
     {
         LOG(INFO) << "SubdeviceRegistrationService: Processing postponed device registration requests";
 
+        // responses arriving while requests are sent must not persist only part of the batch
+        std::lock_guard<decltype(m_devicesAwaitingRegistrationResponseMutex)> devicesAwaitingRegistrationResponseLock{
+          m_devicesAwaitingRegistrationResponseMutex};
+
         for (const auto& deviceWithPostponedRegistration : m_devicesWithPostponedRegistration)
         {
             handleSubdeviceRegistrationRequest(deviceWithPostponedRegistration.first,
@@ -200,7 +299,7 @@ void SubdeviceRegistrationService::registerPostponedDevices()
 void SubdeviceRegistrationService::handleSubdeviceRegistrationRequest(const std::string& deviceKey,
                                                                       const SubdeviceRegistrationRequest& request)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (deviceKey == m_gatewayKey)
     {
@@ -211,20 +310,23 @@ void SubdeviceRegistrationService::handleSubdeviceRegistrationRequest(const std:
     LOG(INFO) << "SubdeviceRegistrationService: Handling registration request for device with key '" << deviceKey
               << "'";
 
-    auto savedDevice = m_deviceRepository.findByDeviceKey(deviceKey);
-    auto subdeviceRequestingRegistration = std::unique_ptr<DetailedDevice>(
-      new DetailedDevice(request.getSubdeviceName(), request.getSubdeviceKey(), request.getTemplate()));
-    if (savedDevice && *savedDevice == *subdeviceRequestingRegistration)
+    if (isRegisteredUnchanged(deviceKey, request))
     {
-        LOG(WARN) << "SubdeviceRegistrationService: Ignoring device registration request for device with key '"
-                  << deviceKey << "'. Already registered with given device info and device template";
+        LOG(INFO) << "SubdeviceRegistrationService: Device with key '" << deviceKey
+                  << "' already registered with given device info and device template, confirming registration";
+
+        // device waits for response after every power cycle, platform already knows it
+        std::shared_ptr<Message> registrationResponseMessage = m_gatewayProtocol.makeMessage(
+          SubdeviceRegistrationResponse{deviceKey, SubdeviceRegistrationResponse::Result::OK, ""});
+        if (registrationResponseMessage)
+        {
+            m_outboundDeviceMessageHandler.addMessage(registrationResponseMessage);
+        }
         return;
     }
 
-    std::lock_guard<decltype(m_devicesAwaitingRegistrationResponseMutex)> l{m_devicesAwaitingRegistrationResponseMutex};
-    auto device = std::unique_ptr<DetailedDevice>(
+    auto subdeviceRequestingRegistration = std::unique_ptr<DetailedDevice>(
       new DetailedDevice(request.getSubdeviceName(), request.getSubdeviceKey(), request.getTemplate()));
-    m_devicesAwaitingRegistrationResponse[deviceKey] = std::move(device);
 
     std::shared_ptr<Message> registrationRequest = m_protocol.makeMessage(m_gatewayKey, request);
     if (!registrationRequest)
@@ -233,20 +335,60 @@ void SubdeviceRegistrationService::handleSubdeviceRegistrationRequest(const std:
         return;
     }
 
-    auto responseChannel = m_protocol.getResponseChannel(m_gatewayKey, *registrationRequest);
-    RetryMessageStruct retryMessage{registrationRequest, responseChannel,
-                                    [=](std::shared_ptr<Message>) {
-                                        LOG(ERROR) << "Failed to register device with key: " << deviceKey
-                                                   << ", no response from platform";
-                                    },
-                                    RETRY_COUNT, RETRY_TIMEOUT};
-    m_platformRetryMessageHandler.addMessage(retryMessage);
+    std::lock_guard<decltype(m_devicesAwaitingRegistrationResponseMutex)> l{m_devicesAwaitingRegistrationResponseMutex};
+    PendingRegistration& pendingRegistration = m_devicesAwaitingRegistrationResponse[deviceKey];
+    pendingRegistration.device = std::move(subdeviceRequestingRegistration);
+    pendingRegistration.request = registrationRequest;
+    pendingRegistration.sentAt = std::chrono::steady_clock::now();
+    pendingRegistration.retryCount = 0;
+
+    // requests are not waiting for each other, responses are matched to them by device key
+    m_outboundPlatformMessageHandler.addMessage(registrationRequest);
+    scheduleRegistrationRetry();
+}
+
+bool SubdeviceRegistrationService::isRegisteredUnchanged(const std::string& deviceKey,
+                                                         const SubdeviceRegistrationRequest& request)
+{
+    const auto templateHash = SQLiteDeviceRepository::calculateSha256(request.getTemplate());
+    const auto registration = std::make_pair(request.getSubdeviceName(), templateHash);
+
+    {
+        std::lock_guard<decltype(m_registeredDevicesMutex)> l{m_registeredDevicesMutex};
+        auto it = m_registeredDevices.find(deviceKey);
+        if (it != m_registeredDevices.end() && it->second == registration)
+        {
+            return true;
+        }
+    }
+
+    // stored digest is read without loading template, device is loaded only when templates match
+    if (m_deviceRepository.findTemplateHash(deviceKey) != templateHash)
+    {
+        return false;
+    }
+
+    const auto savedDevice = m_deviceRepository.findByDeviceKey(deviceKey);
+    if (!savedDevice || savedDevice->getName() != request.getSubdeviceName())
+    {
+        return false;
+    }
+
+    std::lock_guard<decltype(m_registeredDevicesMutex)> l{m_registeredDevicesMutex};
+    m_registeredDevices[deviceKey] = registration;
+    return true;
+}
+
+void SubdeviceRegistrationService::forgetRegistration(const std::string& deviceKey)
+{
+    std::lock_guard<decltype(m_registeredDevicesMutex)> l{m_registeredDevicesMutex};
+    m_registeredDevices.erase(deviceKey);
 }
 
 void SubdeviceRegistrationService::handleSubdeviceRegistrationResponse(const std::string& deviceKey,
                                                                        const SubdeviceRegistrationResponse& response)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     if (deviceKey == m_gatewayKey)
     {
@@ -263,18 +405,39 @@ void SubdeviceRegistrationService::handleSubdeviceRegistrationResponse(const std
         return;
     }
 
+    const PendingRegistration& pendingRegistration = m_devicesAwaitingRegistrationResponse.at(deviceKey);
+    ResponseMetrics::forRequestChannel(pendingRegistration.request->getChannel())
+      .record(std::chrono::steady_clock::now() - pendingRegistration.sentAt,
+              static_cast<unsigned>(pendingRegistration.retryCount));
+
     const auto registrationResult = response.getResult();
     if (registrationResult == SubdeviceRegistrationResponse::Result::OK)
     {
         LOG(INFO) << "SubdeviceRegistrationService: Device with key '" << deviceKey
                   << "' successfully registered on platform";
 
-        const auto& device = *m_devicesAwaitingRegistrationResponse.at(deviceKey);
-        LOG(DEBUG) << "SubdeviceRegistrationService: Saving device with key '" << device.getKey()
-                   << "' to device repository";
+        // Saving is deferred briefly, so a burst of registrations is persisted with a single saveAll
+        m_registeredDevicesAwaitingSave.push_back(
+          std::move(m_devicesAwaitingRegistrationResponse.at(deviceKey).device));
+        m_devicesAwaitingRegistrationResponse.erase(deviceKey);
+
+        std::shared_ptr<Message> registrationResponseMessage = m_gatewayProtocol.makeMessage(response);
+        if (!registrationResponseMessage)
+        {
+            LOG(WARN) << "SubdeviceRegistrationService: Unable to create registration response message";
+        }
+        m_registrationResponsesAwaitingSave.push_back(registrationResponseMessage);
 
-        m_deviceRepository.save(device);
-        invokeOnDeviceRegisteredListener(deviceKey);
+        if (m_devicesAwaitingRegistrationResponse.empty() ||
+            m_registeredDevicesAwaitingSave.size() >= REGISTERED_DEVICES_SAVE_BATCH_SIZE)
+        {
+            saveRegisteredDevices();
+        }
+        else
+        {
+            scheduleRegisteredDevicesSave();
+        }
+        return;
     }
     else
     {
@@ -326,6 +489,10 @@ void SubdeviceRegistrationService::handleSubdeviceRegistrationResponse(const std
     }
 
     m_devicesAwaitingRegistrationResponse.erase(deviceKey);
+    if (m_devicesAwaitingRegistrationResponse.empty())
+    {
+        saveRegisteredDevices();
+    }
 
     // send response to device
     std::shared_ptr<Message> registrationResponseMessage = m_gatewayProtocol.makeMessage(response);
@@ -338,10 +505,142 @@ void SubdeviceRegistrationService::handleSubdeviceRegistrationResponse(const std
     m_outboundDeviceMessageHandler.addMessage(registrationResponseMessage);
 }
 
+void SubdeviceRegistrationService::scheduleRegistrationRetry()
+{
+    std::lock_guard<decltype(m_devicesAwaitingRegistrationResponseMutex)> l(m_devicesAwaitingRegistrationResponseMutex);
+
+    if (m_registrationRetryScheduled || m_stopped || m_devicesAwaitingRegistrationResponse.empty())
+    {
+        return;
+    }
+
+    // single timer serves all pending registrations, it fires when the oldest request is due
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    for (const auto& pendingRegistration : m_devicesAwaitingRegistrationResponse)
+    {
+        deadline = std::min(deadline, pendingRegistration.second.sentAt + m_retryTimeout);
+    }
+
+    const auto delay = std::max(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  deadline - std::chrono::steady_clock::now()),
+                                std::chrono::milliseconds{0});
+
+    m_registrationRetryScheduled = true;
+    m_registrationRetryTask = m_executor.schedule(delay, [=] { retryRegistrations(); });
+}
+
+void SubdeviceRegistrationService::retryRegistrations()
+{
+    std::lock_guard<decltype(m_devicesAwaitingRegistrationResponseMutex)> l(m_devicesAwaitingRegistrationResponseMutex);
+
+    m_registrationRetryScheduled = false;
+    if (m_stopped)
+    {
+        return;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    for (auto it = m_devicesAwaitingRegistrationResponse.begin(); it != m_devicesAwaitingRegistrationResponse.end();)
+    {
+        PendingRegistration& pendingRegistration = it->second;
+        if (now - pendingRegistration.sentAt < m_retryTimeout)
+        {
+            ++it;
+            continue;
+        }
+
+        if (pendingRegistration.retryCount >= m_retryCount)
+        {
+            LOG(ERROR) << "Failed to register device with key: " << it->first << ", no response from platform";
+            it = m_devicesAwaitingRegistrationResponse.erase(it);
+            continue;
+        }
+
+        LOG(INFO) << "SubdeviceRegistrationService: Retrying registration of device with key '" << it->first << "'";
+
+        ++pendingRegistration.retryCount;
+        pendingRegistration.sentAt = now;
+        m_outboundPlatformMessageHandler.addMessage(pendingRegistration.request);
+        ++it;
+    }
+
+    if (m_devicesAwaitingRegistrationResponse.empty())
+    {
+        saveRegisteredDevices();
+        return;
+    }
+
+    scheduleRegistrationRetry();
+}
+
+void SubdeviceRegistrationService::scheduleRegisteredDevicesSave()
+{
+    std::lock_guard<decltype(m_devicesAwaitingRegistrationResponseMutex)> l(m_devicesAwaitingRegistrationResponseMutex);
+
+    if (m_registeredDevicesSaveScheduled || m_stopped)
+    {
+        return;
+    }
+
+    m_registeredDevicesSaveScheduled = true;
+    m_registeredDevicesSaveTask = m_executor.schedule(REGISTERED_DEVICES_SAVE_DELAY, [=] {
+        std::lock_guard<decltype(m_devicesAwaitingRegistrationResponseMutex)> lock(
+          m_devicesAwaitingRegistrationResponseMutex);
+
+        m_registeredDevicesSaveScheduled = false;
+        if (!m_stopped)
+        {
+            saveRegisteredDevices();
+        }
+    });
+}
+
+void SubdeviceRegistrationService::saveRegisteredDevices(bool notify)
+{
+    std::lock_guard<decltype(m_devicesAwaitingRegistrationResponseMutex)> l(m_devicesAwaitingRegistrationResponseMutex);
+
+    if (m_registeredDevicesAwaitingSave.empty())
+    {
+        return;
+    }
+
+    GATEWAY_LOG(DEBUG) << "SubdeviceRegistrationService: Saving " << m_registeredDevicesAwaitingSave.size()
+                       << " registered device(s) to device repository";
+
+    std::vector<DetailedDevice> devices;
+    devices.reserve(m_registeredDevicesAwaitingSave.size());
+    for (const auto& device : m_registeredDevicesAwaitingSave)
+    {
+        devices.push_back(*device);
+    }
+
+    m_deviceRepository.saveAll(devices);
+
+    for (const auto& device : m_registeredDevicesAwaitingSave)
+    {
+        forgetRegistration(device->getKey());
+        if (notify)
+        {
+            invokeOnDeviceRegisteredListener(device->getKey());
+        }
+    }
+
+    for (const auto& registrationResponseMessage : m_registrationResponsesAwaitingSave)
+    {
+        if (registrationResponseMessage && notify)
+        {
+            m_outboundDeviceMessageHandler.addMessage(registrationResponseMessage);
+        }
+    }
+
+    m_registeredDevicesAwaitingSave.clear();
+    m_registrationResponsesAwaitingSave.clear();
+}
+
 void SubdeviceRegistrationService::addToPostponedSubdeviceRegistrationRequests(
   const std::string& deviceKey, const wolkabout::SubdeviceRegistrationRequest& request)
 {
-    LOG(TRACE) << METHOD_INFO;
+    GATEWAY_LOG(TRACE) << METHOD_INFO;
 
     LOG(INFO) << "SubdeviceRegistrationService: Postponing registration of device with key '" << deviceKey
               << "'. Waiting for gateway to be updated";
@@ -21,11 +21,15 @@
 #include "GatewayInboundPlatformMessageHandler.h"
 #include "OutboundRetryMessageHandler.h"
 #include "model/SubdeviceRegistrationRequest.h"
+#include "utilities/Executor.h"
 
+#include <chrono>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace wolkabout
@@ -45,7 +49,10 @@ public:
                                  GatewaySubdeviceRegistrationProtocol& gatewayProtocol,
                                  DeviceRepository& deviceRepository,
                                  OutboundMessageHandler& outboundPlatformMessageHandler,
-                                 OutboundMessageHandler& outboundDeviceMessageHandler);
+                                 OutboundMessageHandler& outboundDeviceMessageHandler, Executor& executor,
+                                 short retryCount = DEFAULT_RETRY_COUNT,
+                                 std::chrono::milliseconds retryTimeout = DEFAULT_RETRY_TIMEOUT);
+    ~SubdeviceRegistrationService();
 
     void platformMessageReceived(std::shared_ptr<Message> message) override;
 
@@ -57,12 +64,18 @@ public:
 
     void onDeviceRegistered(std::function<void(const std::string& deviceKey)> onDeviceRegistered);
 
+    void onDeviceDeleted(std::function<void(const std::string& deviceKey)> onDeviceDeleted);
+
     virtual void deleteDevicesOtherThan(const std::vector<std::string>& devicesKeys);
 
     virtual void registerPostponedDevices();
 
+    static const short DEFAULT_RETRY_COUNT;
+    static const std::chrono::milliseconds DEFAULT_RETRY_TIMEOUT;
+
 protected:
     void invokeOnDeviceRegisteredListener(const std::string& deviceKey) const;
+    void invokeOnDeviceDeletedListener(const std::string& deviceKey) const;
 
 private:
     void handleSubdeviceRegistrationRequest(const std::string& deviceKey, const SubdeviceRegistrationRequest& request);
@@ -70,6 +83,15 @@ private:
     void handleSubdeviceRegistrationResponse(const std::string& deviceKey,
                                              const SubdeviceRegistrationResponse& response);
 
+    bool isRegisteredUnchanged(const std::string& deviceKey, const SubdeviceRegistrationRequest& request);
+    void forgetRegistration(const std::string& deviceKey);
+
+    void scheduleRegistrationRetry();
+    void retryRegistrations();
+
+    void scheduleRegisteredDevicesSave();
+    void saveRegisteredDevices(bool notify = true);
+
     void addToPostponedSubdeviceRegistrationRequests(const std::string& deviceKey,
                                                      const SubdeviceRegistrationRequest& request);
 
@@ -84,13 +106,41 @@ private:
 
     OutboundRetryMessageHandler m_platformRetryMessageHandler;
 
+    // registration and deletion requests are resent this many times when platform does not respond within timeout
+    const short m_retryCount;
+    const std::chrono::milliseconds m_retryTimeout;
+
     std::function<void(const std::string& deviceKey)> m_onDeviceRegistered;
+    std::function<void(const std::string& deviceKey)> m_onDeviceDeleted;
+
+    // all registration responses arrive on the same channel, so retries are tracked per device key
+    // here instead of in OutboundRetryMessageHandler, which would treat any response as answer to every request
+    struct PendingRegistration
+    {
+        std::unique_ptr<DetailedDevice> device;
+        std::shared_ptr<Message> request;
+        std::chrono::steady_clock::time_point sentAt;
+        short retryCount;
+    };
+
+    Executor& m_executor;
 
     std::recursive_mutex m_devicesAwaitingRegistrationResponseMutex;
-    std::map<std::string, std::unique_ptr<DetailedDevice>> m_devicesAwaitingRegistrationResponse;
+    std::map<std::string, PendingRegistration> m_devicesAwaitingRegistrationResponse;
+    std::vector<std::unique_ptr<DetailedDevice>> m_registeredDevicesAwaitingSave;
+    std::vector<std::shared_ptr<Message>> m_registrationResponsesAwaitingSave;
+    Executor::TaskId m_registrationRetryTask;
+    bool m_registrationRetryScheduled;
+    Executor::TaskId m_registeredDevicesSaveTask;
+    bool m_registeredDevicesSaveScheduled;
+    bool m_stopped;
 
     std::mutex m_devicesWithPostponedRegistrationMutex;
     std::map<std::string, std::unique_ptr<SubdeviceRegistrationRequest>> m_devicesWithPostponedRegistration;
+
+    // name and template digest of devices found registered, so repeated requests skip the repository
+    std::mutex m_registeredDevicesMutex;
+    std::unordered_map<std::string, std::pair<std::string, std::string>> m_registeredDevices;
 };
 }    // namespace wolkabout
 
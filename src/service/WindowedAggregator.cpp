@@ -0,0 +1,509 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "service/WindowedAggregator.h"
+#include "utilities/JsonReader.h"
+#include "utilities/JsonWriter.h"
+#include "utilities/Logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+
+namespace wolkabout
+{
+namespace
+{
+const char* const ANY_DEVICE = "*";
+const char* const READING_DATA_FIELD = "data";
+const char* const WHITESPACE = " \t\r\n";
+const char VALUE_SEPARATOR = ',';
+
+std::string makeKey(const std::string& deviceKey, const std::string& reference)
+{
+    std::string key;
+    key.reserve(deviceKey.size() + reference.size() + 1);
+    key.append(deviceKey).append(1, '/').append(reference);
+    return key;
+}
+
+bool parseNumber(const std::string& text, double& value)
+{
+    if (text.empty())
+    {
+        return false;
+    }
+
+    char* end = nullptr;
+    value = std::strtod(text.c_str(), &end);
+    return end == text.c_str() + text.size() && std::isfinite(value);
+}
+
+bool parseStatistic(const std::string& name, WindowedAggregator::Statistic& statistic)
+{
+    if (name == "min")
+    {
+        statistic = WindowedAggregator::Statistic::MINIMUM;
+    }
+    else if (name == "max")
+    {
+        statistic = WindowedAggregator::Statistic::MAXIMUM;
+    }
+    else if (name == "avg")
+    {
+        statistic = WindowedAggregator::Statistic::AVERAGE;
+    }
+    else if (name == "rms")
+    {
+        statistic = WindowedAggregator::Statistic::RMS;
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+}    // namespace
+
+constexpr std::size_t WindowedAggregator::BLOCK_SIZE;
+
+WindowedAggregator::WindowedAggregator(Executor& executor)
+: m_executor{executor}, m_rules{std::make_shared<const Rules>()}, m_nextGeneration{0}
+{
+}
+
+WindowedAggregator::~WindowedAggregator()
+{
+    std::vector<Executor::TaskId> tasks;
+
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+        for (const auto& window : m_windows)
+        {
+            tasks.push_back(window.second.task);
+        }
+
+        m_windows.clear();
+    }
+
+    // close that is already running is waited for
+    for (const auto task : tasks)
+    {
+        m_executor.cancel(task);
+    }
+}
+
+void WindowedAggregator::setListener(Listener listener)
+{
+    m_listener = std::move(listener);
+}
+
+bool WindowedAggregator::loadRules(const std::string& path)
+{
+    std::ifstream file{path};
+    if (!file.is_open())
+    {
+        LOG(ERROR) << "WindowedAggregator: Unable to open rule file '" << path << "'";
+        return false;
+    }
+
+    std::shared_ptr<Rules> rules = std::make_shared<Rules>();
+
+    std::string line;
+    unsigned lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        ++lineNumber;
+
+        std::istringstream stream{line};
+        std::string deviceKey;
+        if (!(stream >> deviceKey) || deviceKey[0] == '#')
+        {
+            continue;
+        }
+
+        std::string reference;
+        std::vector<std::string> fields;
+        std::string field;
+        stream >> reference;
+        while (stream >> field)
+        {
+            fields.push_back(field);
+        }
+
+        std::shared_ptr<Rule> rule = std::make_shared<Rule>();
+        if (reference.empty() || !parseRule(fields, *rule))
+        {
+            LOG(ERROR) << "WindowedAggregator: Invalid line " << lineNumber << " in rule file '" << path << "'";
+            return false;
+        }
+
+        (*rules)[makeKey(deviceKey, reference)] = rule;
+    }
+
+    std::atomic_store(&m_rules, std::shared_ptr<const Rules>{rules});
+    return true;
+}
+
+bool WindowedAggregator::accept(const std::string& deviceKey, const std::string& reference,
+                                const std::string& channel, const std::string& payload)
+{
+    const auto rules = std::atomic_load(&m_rules);
+    if (rules->empty())
+    {
+        return false;
+    }
+
+    const std::string key = makeKey(deviceKey, reference);
+    auto rule = rules->find(key);
+    if (rule == rules->end())
+    {
+        rule = rules->find(makeKey(ANY_DEVICE, reference));
+    }
+
+    if (rule == rules->end())
+    {
+        return false;
+    }
+
+    std::size_t values;
+    std::vector<double> samples;
+    if (!parseValues(payload, values, samples))
+    {
+        return false;
+    }
+
+    std::vector<Output> outputs;
+    std::vector<Executor::TaskId> tasks;
+
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+
+        auto it = m_windows.find(key);
+        if (it != m_windows.end() && it->second.values != values)
+        {
+            // statistics of readings with different number of values can not be combined
+            close(it->second, outputs);
+            tasks.push_back(it->second.task);
+            m_windows.erase(it);
+            it = m_windows.end();
+        }
+
+        if (it == m_windows.end())
+        {
+            Window window;
+            window.rule = rule->second;
+            window.deviceKey = deviceKey;
+            window.channelPrefix = channel.substr(0, channel.size() - reference.size());
+            window.values = values;
+            window.block.resize(BLOCK_SIZE * values);
+            window.blockSamples = 0;
+            window.minimum.assign(values, std::numeric_limits<double>::infinity());
+            window.maximum.assign(values, -std::numeric_limits<double>::infinity());
+            window.sum.assign(values, 0);
+            window.sumOfSquares.assign(values, 0);
+            window.samples = 0;
+            window.generation = m_nextGeneration++;
+
+            const std::uint64_t generation = window.generation;
+            window.task = m_executor.schedule(window.rule->window, [=] { closeExpired(key, generation); });
+
+            it = m_windows.emplace(key, std::move(window)).first;
+        }
+
+        Window& window = it->second;
+        for (std::size_t sample = 0; sample < samples.size(); sample += values)
+        {
+            for (std::size_t value = 0; value < values; ++value)
+            {
+                window.block[value * BLOCK_SIZE + window.blockSamples] = samples[sample + value];
+            }
+
+            if (++window.blockSamples == BLOCK_SIZE)
+            {
+                reduce(window);
+            }
+        }
+    }
+
+    for (const auto task : tasks)
+    {
+        m_executor.cancel(task);
+    }
+
+    publish(outputs);
+    return true;
+}
+
+void WindowedAggregator::flush()
+{
+    std::vector<Output> outputs;
+    std::vector<Executor::TaskId> tasks;
+
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+        for (auto& window : m_windows)
+        {
+            close(window.second, outputs);
+            tasks.push_back(window.second.task);
+        }
+
+        m_windows.clear();
+    }
+
+    for (const auto task : tasks)
+    {
+        m_executor.cancel(task);
+    }
+
+    publish(outputs);
+}
+
+bool WindowedAggregator::parseRule(const std::vector<std::string>& fields, Rule& rule)
+{
+    if (fields.size() < 2)
+    {
+        return false;
+    }
+
+    double window;
+    if (!parseNumber(fields[0], window) || window < 1 || std::floor(window) < window)
+    {
+        return false;
+    }
+
+    rule.window = std::chrono::milliseconds{static_cast<std::chrono::milliseconds::rep>(window)};
+
+    for (std::size_t i = 1; i < fields.size(); ++i)
+    {
+        const auto assignment = fields[i].find('=');
+        Statistic statistic;
+        if (assignment == std::string::npos || assignment + 1 == fields[i].size() ||
+            fields[i].find('/', assignment) != std::string::npos ||
+            !parseStatistic(fields[i].substr(0, assignment), statistic))
+        {
+            return false;
+        }
+
+        rule.outputs.emplace_back(statistic, fields[i].substr(assignment + 1));
+    }
+
+    return true;
+}
+
+bool WindowedAggregator::parseValues(const std::string& payload, std::size_t& values, std::vector<double>& samples)
+{
+    JsonReader reader{payload};
+    values = 0;
+
+    std::string field;
+    std::string data;
+    std::string text;
+    const auto readReading = [&]() {
+        bool hasData = false;
+        if (!reader.beginObject())
+        {
+            return false;
+        }
+
+        while (reader.nextMember(field))
+        {
+            if (field != READING_DATA_FIELD)
+            {
+                reader.skipValue();
+                continue;
+            }
+
+            if (!reader.readString(data))
+            {
+                return false;
+            }
+
+            hasData = true;
+        }
+
+        if (reader.failed() || !hasData)
+        {
+            return false;
+        }
+
+        std::size_t count = 0;
+        std::size_t start = 0;
+        while (true)
+        {
+            const auto end = std::min(data.find(VALUE_SEPARATOR, start), data.size());
+
+            double value;
+            text.assign(data, start, end - start);
+            if (!parseNumber(text, value))
+            {
+                return false;
+            }
+
+            samples.push_back(value);
+            ++count;
+
+            if (end == data.size())
+            {
+                break;
+            }
+
+            start = end + 1;
+        }
+
+        if (values == 0)
+        {
+            values = count;
+        }
+
+        return values == count;
+    };
+
+    const auto first = payload.find_first_not_of(WHITESPACE);
+    if (first != std::string::npos && payload[first] == '[')
+    {
+        if (!reader.beginArray())
+        {
+            return false;
+        }
+
+        while (reader.nextElement())
+        {
+            if (!readReading())
+            {
+                return false;
+            }
+        }
+    }
+    else if (!readReading())
+    {
+        return false;
+    }
+
+    return reader.finish() && values > 0;
+}
+
+void WindowedAggregator::reduce(Window& window)
+{
+    for (std::size_t value = 0; value < window.values; ++value)
+    {
+        const double* samples = window.block.data() + value * BLOCK_SIZE;
+
+        // plain loops over contiguous samples, kept branch free so compiler can vectorize them
+        double minimum = window.minimum[value];
+        double maximum = window.maximum[value];
+        double sum = 0;
+        double sumOfSquares = 0;
+        for (std::size_t i = 0; i < window.blockSamples; ++i)
+        {
+            minimum = samples[i] < minimum ? samples[i] : minimum;
+            maximum = samples[i] > maximum ? samples[i] : maximum;
+            sum += samples[i];
+            sumOfSquares += samples[i] * samples[i];
+        }
+
+        window.minimum[value] = minimum;
+        window.maximum[value] = maximum;
+        window.sum[value] += sum;
+        window.sumOfSquares[value] += sumOfSquares;
+    }
+
+    window.samples += window.blockSamples;
+    window.blockSamples = 0;
+}
+
+void WindowedAggregator::close(Window& window, std::vector<Output>& outputs)
+{
+    reduce(window);
+    if (window.samples == 0)
+    {
+        return;
+    }
+
+    const auto now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+    const auto samples = static_cast<double>(window.samples);
+
+    for (const auto& output : window.rule->outputs)
+    {
+        std::string payload = "{\"utc\":" + std::to_string(now) + ",\"data\":\"";
+        for (std::size_t value = 0; value < window.values; ++value)
+        {
+            if (value > 0)
+            {
+                payload.append(1, VALUE_SEPARATOR);
+            }
+
+            switch (output.first)
+            {
+            case Statistic::MINIMUM:
+                JsonWriter::appendNumber(payload, window.minimum[value]);
+                break;
+            case Statistic::MAXIMUM:
+                JsonWriter::appendNumber(payload, window.maximum[value]);
+                break;
+            case Statistic::AVERAGE:
+                JsonWriter::appendNumber(payload, window.sum[value] / samples);
+                break;
+            case Statistic::RMS:
+                JsonWriter::appendNumber(payload, std::sqrt(window.sumOfSquares[value] / samples));
+                break;
+            }
+        }
+
+        payload.append("\"}");
+        outputs.push_back(Output{window.deviceKey, window.channelPrefix + output.second, std::move(payload)});
+    }
+}
+
+void WindowedAggregator::closeExpired(const std::string& key, std::uint64_t generation)
+{
+    std::vector<Output> outputs;
+
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+
+        auto it = m_windows.find(key);
+        if (it == m_windows.end() || it->second.generation != generation)
+        {
+            return;
+        }
+
+        close(it->second, outputs);
+        m_windows.erase(it);
+    }
+
+    publish(outputs);
+}
+
+void WindowedAggregator::publish(const std::vector<Output>& outputs)
+{
+    if (!m_listener)
+    {
+        return;
+    }
+
+    for (const auto& output : outputs)
+    {
+        m_listener(output.deviceKey, output.channel, output.payload);
+    }
+}
+}    // namespace wolkabout
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WINDOWEDAGGREGATOR_H
+#define WINDOWEDAGGREGATOR_H
+
+#include "utilities/Executor.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Replaces high rate numeric sensor readings with their minimum, maximum, average and RMS over a time window
+ *
+ * Window of a sensor opens with the first reading and closes once its duration elapses, at which point
+ * one reading per configured statistic is published. Multi-value readings are aggregated per value.
+ * Samples are collected into a fixed-size block per sensor, which is reduced as a whole when full or when
+ * window closes, so memory does not grow with reading rate and reductions run over contiguous values.
+ */
+class WindowedAggregator
+{
+public:
+    /**
+     * @brief Receives aggregated reading
+     * @param deviceKey Key of device reading belongs to
+     * @param channel Device channel of aggregated reading, ending with reference of statistic
+     * @param payload Reading payload
+     */
+    using Listener =
+      std::function<void(const std::string& deviceKey, const std::string& channel, const std::string& payload)>;
+
+    enum class Statistic
+    {
+        MINIMUM,
+        MAXIMUM,
+        AVERAGE,
+        RMS
+    };
+
+    static constexpr std::size_t BLOCK_SIZE = 64;
+
+    explicit WindowedAggregator(Executor& executor);
+
+    /**
+     * @brief Closes open windows without publishing them
+     */
+    ~WindowedAggregator();
+
+    WindowedAggregator(const WindowedAggregator&) = delete;
+    WindowedAggregator& operator=(const WindowedAggregator&) = delete;
+
+    /**
+     * @brief Sets listener which receives aggregated readings, must be called before readings are accepted
+     */
+    void setListener(Listener listener);
+
+    /**
+     * @brief Loads aggregation rules
+     *
+     * Each line holds device key ('*' for any device), sensor reference, window in milliseconds and
+     * one or more statistics with reference they are published with, as in "* VIB 1000 min=VIB_MIN avg=VIB".
+     * Statistics are min, max, avg and rms. Empty lines and lines starting with '#' are ignored.
+     * Can be called again while readings are aggregated, windows that are already open keep their rule.
+     * @param path Path of rule file
+     * @return false if file can not be read or has invalid line, in which case previous rules are kept
+     */
+    bool loadRules(const std::string& path);
+
+    /**
+     * @brief Adds reading to window of its sensor
+     * @param deviceKey Key of device which sent reading
+     * @param reference Sensor reference
+     * @param channel Device channel reading was published on, ending with reference
+     * @param payload Reading payload, single reading or array of readings
+     * @return true if reading was aggregated, false if it has no rule or non-numeric values and should be forwarded
+     */
+    bool accept(const std::string& deviceKey, const std::string& reference, const std::string& channel,
+                const std::string& payload);
+
+    /**
+     * @brief Closes all open windows, publishing their statistics
+     */
+    void flush();
+
+private:
+    struct Rule
+    {
+        std::chrono::milliseconds window;
+        std::vector<std::pair<Statistic, std::string>> outputs;
+    };
+
+    using Rules = std::unordered_map<std::string, std::shared_ptr<const Rule>>;
+
+    struct Window
+    {
+        std::shared_ptr<const Rule> rule;
+        std::string deviceKey;
+        // channel up to sensor reference
+        std::string channelPrefix;
+
+        std::size_t values;
+        // BLOCK_SIZE samples of first value, followed by BLOCK_SIZE samples of next one and so on
+        std::vector<double> block;
+        std::size_t blockSamples;
+
+        std::vector<double> minimum;
+        std::vector<double> maximum;
+        std::vector<double> sum;
+        std::vector<double> sumOfSquares;
+        std::uint64_t samples;
+
+        std::uint64_t generation;
+        Executor::TaskId task;
+    };
+
+    struct Output
+    {
+        std::string deviceKey;
+        std::string channel;
+        std::string payload;
+    };
+
+    static bool parseRule(const std::vector<std::string>& fields, Rule& rule);
+    static bool parseValues(const std::string& payload, std::size_t& values, std::vector<double>& samples);
+
+    static void reduce(Window& window);
+    static void close(Window& window, std::vector<Output>& outputs);
+
+    void closeExpired(const std::string& key, std::uint64_t generation);
+    void publish(const std::vector<Output>& outputs);
+
+    Executor& m_executor;
+    Listener m_listener;
+
+    // keyed by "<device key>/<reference>", replaced as a whole on load and read through std::atomic_load
+    std::shared_ptr<const Rules> m_rules;
+
+    std::unordered_map<std::string, Window> m_windows;
+    std::uint64_t m_nextGeneration;
+    std::mutex m_lock;
+};
+}    // namespace wolkabout
+
+#endif    // WINDOWEDAGGREGATOR_H
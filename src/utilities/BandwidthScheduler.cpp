@@ -0,0 +1,95 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/BandwidthScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace wolkabout
+{
+BandwidthScheduler::BandwidthScheduler(std::uint64_t linkRate, double bulkShare)
+: m_linkRate{static_cast<double>(std::max<std::uint64_t>(linkRate, 1))}
+, m_bulkRate{m_linkRate * std::min(std::max(bulkShare, 0.0), 1.0)}
+, m_linkTokens{m_linkRate}
+, m_bulkTokens{m_bulkRate}
+, m_lastRefill{Clock::now()}
+{
+}
+
+void BandwidthScheduler::telemetrySent(std::uint64_t bytes, Clock::time_point now)
+{
+    std::lock_guard<decltype(m_lock)> lg{m_lock};
+
+    refill(now);
+
+    // debt is bounded, telemetry beyond link rate is not something bulk transfers can make up for
+    m_linkTokens = std::max(m_linkTokens - static_cast<double>(bytes), -m_linkRate);
+}
+
+std::chrono::milliseconds BandwidthScheduler::reserveBulk(std::uint64_t bytes, Clock::time_point now)
+{
+    std::lock_guard<decltype(m_lock)> lg{m_lock};
+
+    refill(now);
+
+    if (m_linkTokens >= 0 && m_bulkTokens >= 0 && m_bulkRate > 0)
+    {
+        m_linkTokens -= static_cast<double>(bytes);
+        m_bulkTokens -= static_cast<double>(bytes);
+        return std::chrono::milliseconds{0};
+    }
+
+    if (m_bulkRate <= 0)
+    {
+        return std::chrono::milliseconds{1000};
+    }
+
+    const double seconds = std::max(-m_linkTokens / m_linkRate, -m_bulkTokens / m_bulkRate);
+    return std::chrono::milliseconds{std::max<std::chrono::milliseconds::rep>(
+      static_cast<std::chrono::milliseconds::rep>(std::ceil(seconds * 1000)), 1)};
+}
+
+unsigned BandwidthScheduler::bulkWindow(std::uint64_t packetSize, unsigned maximum, Clock::time_point now)
+{
+    std::lock_guard<decltype(m_lock)> lg{m_lock};
+
+    refill(now);
+
+    const double leftOver = std::min(m_linkTokens, m_bulkTokens);
+    if (leftOver <= 0 || packetSize == 0 || maximum <= 1)
+    {
+        return 1;
+    }
+
+    const double window = 1 + std::floor(leftOver / static_cast<double>(packetSize));
+    return window >= static_cast<double>(maximum) ? maximum : static_cast<unsigned>(window);
+}
+
+void BandwidthScheduler::refill(Clock::time_point now)
+{
+    if (now <= m_lastRefill)
+    {
+        return;
+    }
+
+    const double seconds = std::chrono::duration<double>(now - m_lastRefill).count();
+    m_lastRefill = now;
+
+    m_linkTokens = std::min(m_linkTokens + seconds * m_linkRate, m_linkRate);
+    m_bulkTokens = std::min(m_bulkTokens + seconds * m_bulkRate, m_bulkRate);
+}
+}    // namespace wolkabout
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef BANDWIDTHSCHEDULER_H
+#define BANDWIDTHSCHEDULER_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+namespace wolkabout
+{
+/**
+ * @brief Shares platform link between telemetry and bulk file transfers
+ *
+ * Two token buckets refill at link rate and at bulk share of it, each holding at most one second worth of bytes.
+ * Telemetry is never delayed, its bytes are taken from link bucket as they are published, so bulk transfer
+ * only gets bandwidth telemetry left over and never more than its share. Bulk transfers may overdraw buckets,
+ * in which case next transfer waits until the debt is repaid, so packets larger than one second of link
+ * are still sent at the configured rate.
+ */
+class BandwidthScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @param linkRate Bytes per second available on platform link
+     * @param bulkShare Maximum part of link given to bulk transfers, between 0 and 1
+     */
+    BandwidthScheduler(std::uint64_t linkRate, double bulkShare);
+
+    /**
+     * @brief Accounts published telemetry
+     * @param bytes Size of published message
+     */
+    void telemetrySent(std::uint64_t bytes, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Reserves bandwidth for bulk transfer
+     * @param bytes Size of transfer
+     * @return Zero if bandwidth is reserved, otherwise time to wait before trying again
+     */
+    std::chrono::milliseconds reserveBulk(std::uint64_t bytes, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Returns number of bulk packets which fit bandwidth that is currently left over
+     * @param packetSize Size of single packet
+     * @param maximum Upper bound of returned window
+     * @return Window between 1 and maximum
+     */
+    unsigned bulkWindow(std::uint64_t packetSize, unsigned maximum, Clock::time_point now = Clock::now());
+
+private:
+    void refill(Clock::time_point now);
+
+    const double m_linkRate;
+    const double m_bulkRate;
+
+    std::mutex m_lock;
+    double m_linkTokens;
+    double m_bulkTokens;
+    Clock::time_point m_lastRefill;
+};
+}    // namespace wolkabout
+
+#endif    // BANDWIDTHSCHEDULER_H
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/ChannelInterner.h"
+
+namespace wolkabout
+{
+ChannelInterner::ChannelId ChannelInterner::intern(const std::string& channel)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    auto it = m_ids.find(channel);
+    if (it != m_ids.end())
+    {
+        return it->second;
+    }
+
+    m_channels.push_back(channel);
+    const auto id = static_cast<ChannelId>(m_channels.size());
+    m_ids.emplace(channel, id);
+
+    return id;
+}
+
+ChannelInterner::ChannelId ChannelInterner::find(const std::string& channel) const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    auto it = m_ids.find(channel);
+    return it != m_ids.end() ? it->second : 0;
+}
+
+const std::string& ChannelInterner::channel(ChannelId id) const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    // deque never relocates stored elements on push_back
+    return m_channels[id - 1];
+}
+
+std::size_t ChannelInterner::size() const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+    return m_channels.size();
+}
+}    // namespace wolkabout
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CHANNELINTERNER_H
+#define CHANNELINTERNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace wolkabout
+{
+/**
+ * @brief Assigns small integer ids to channels so routing tables can be keyed by an integer instead of a string
+ *
+ * Each distinct channel is stored once and is never removed, references returned by channel() stay valid
+ * for the lifetime of the interner. Thread safe.
+ */
+class ChannelInterner
+{
+public:
+    using ChannelId = std::uint32_t;
+
+    /**
+     * @brief Returns id of channel, assigning a new one if channel was not interned before
+     * @return Id of channel, never 0
+     */
+    ChannelId intern(const std::string& channel);
+
+    /**
+     * @brief Returns id of channel
+     * @return Id of channel, or 0 if channel was not interned
+     */
+    ChannelId find(const std::string& channel) const;
+
+    /**
+     * @brief Returns channel of id returned by intern
+     */
+    const std::string& channel(ChannelId id) const;
+
+    std::size_t size() const;
+
+private:
+    mutable std::mutex m_lock;
+    std::unordered_map<std::string, ChannelId> m_ids;
+    std::deque<std::string> m_channels;
+};
+}    // namespace wolkabout
+
+#endif    // CHANNELINTERNER_H
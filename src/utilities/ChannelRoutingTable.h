@@ -0,0 +1,165 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CHANNELROUTINGTABLE_H
+#define CHANNELROUTINGTABLE_H
+
+#include "model/Message.h"
+#include "utilities/TopicTrie.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Maps channels of a protocol straight to the handler of their message type
+ *
+ * Routes are an ordered chain of message type predicates and handlers, as message routers would test them.
+ * Each subscribed channel filter is classified once on construction, by running the chain on a channel
+ * matching the filter, and filters matched by exactly one predicate are indexed in a topic trie.
+ * Only filters whose first two levels, direction and message type, are literal are indexed,
+ * so every channel the filter matches has the message type the filter was classified by.
+ * Messages on other channels fall back to running the whole chain, so routing is the same as without the table.
+ *
+ * Immutable after construction, so it can be used from several threads without synchronization.
+ */
+template <class Listener> class ChannelRoutingTable
+{
+public:
+    struct Route
+    {
+        Route(std::function<bool(const Message&)> matchesArg, Listener* handlerArg)
+        : matches{std::move(matchesArg)}, handler{handlerArg}
+        {
+        }
+
+        std::function<bool(const Message&)> matches;
+        Listener* handler;
+    };
+
+    ChannelRoutingTable(const std::vector<std::string>& filters, std::vector<Route> routes)
+    : m_routes{std::move(routes)}
+    {
+        for (const std::string& filter : filters)
+        {
+            if (!hasLiteralMessageType(filter))
+            {
+                continue;
+            }
+
+            const Message sample{"", sampleChannel(filter)};
+
+            const Route* matched = nullptr;
+            std::size_t matches = 0;
+            for (const Route& route : m_routes)
+            {
+                if (route.matches(sample))
+                {
+                    matched = &route;
+                    ++matches;
+                }
+            }
+
+            if (matches == 1 && matched->handler)
+            {
+                m_handlers.insert(filter, matched->handler);
+            }
+        }
+    }
+
+    /**
+     * @brief Finds handler of given message
+     * @param message Message to route
+     * @return Handler of first route which matches message, or nullptr if message can not be routed
+     */
+    Listener* route(const Message& message) const
+    {
+        if (Listener* const* handler = m_handlers.match(message.getChannel()))
+        {
+            return *handler;
+        }
+
+        for (const Route& route : m_routes)
+        {
+            if (route.handler && route.matches(message))
+            {
+                return route.handler;
+            }
+        }
+
+        return nullptr;
+    }
+
+    /**
+     * @brief Returns number of channel filters routed without running the predicate chain
+     */
+    std::size_t size() const { return m_handlers.size(); }
+
+private:
+    static bool hasLiteralMessageType(const std::string& filter)
+    {
+        const auto directionEnd = filter.find('/');
+        if (directionEnd == std::string::npos)
+        {
+            return false;
+        }
+
+        const auto typeEnd = filter.find('/', directionEnd + 1);
+        const auto wildcard = filter.find_first_of("+#");
+        return typeEnd != std::string::npos && (wildcard == std::string::npos || wildcard > typeEnd);
+    }
+
+    // Wildcard levels are replaced by a placeholder, so predicates see a channel the filter matches
+    static std::string sampleChannel(const std::string& filter)
+    {
+        std::string channel;
+
+        std::string::size_type start = 0;
+        while (true)
+        {
+            const auto end = filter.find('/', start);
+            const std::string level =
+              filter.substr(start, end == std::string::npos ? std::string::npos : end - start);
+
+            if (start != 0)
+            {
+                channel += '/';
+            }
+            channel += (level == "+" || level == "#") ? SAMPLE_LEVEL : level;
+
+            if (end == std::string::npos)
+            {
+                return channel;
+            }
+
+            start = end + 1;
+        }
+    }
+
+    static constexpr const char* SAMPLE_LEVEL = "_";
+
+    const std::vector<Route> m_routes;
+    TopicTrie<Listener*> m_handlers;
+};
+
+template <class Listener> constexpr const char* ChannelRoutingTable<Listener>::SAMPLE_LEVEL;
+}    // namespace wolkabout
+
+#endif    // CHANNELROUTINGTABLE_H
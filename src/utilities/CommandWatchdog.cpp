@@ -0,0 +1,225 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/CommandWatchdog.h"
+#include "utilities/Logger.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace wolkabout
+{
+namespace
+{
+const std::chrono::milliseconds MINIMUM_WATCH_INTERVAL{10};
+}    // namespace
+
+CommandWatchdog& CommandWatchdog::getInstance()
+{
+    static CommandWatchdog instance;
+    return instance;
+}
+
+CommandWatchdog::CommandWatchdog()
+: m_thresholdMilliseconds{0}, m_dumpOrigins{true}, m_stallCount{0}, m_nextId{0}, m_run{false}
+{
+}
+
+CommandWatchdog::~CommandWatchdog()
+{
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+        m_run = false;
+    }
+
+    m_condition.notify_all();
+    if (m_watcher.joinable())
+    {
+        m_watcher.join();
+    }
+}
+
+void CommandWatchdog::configure(std::chrono::milliseconds threshold, bool dumpOrigins)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    m_thresholdMilliseconds = std::max<std::int64_t>(threshold.count(), 0);
+    m_dumpOrigins = dumpOrigins;
+
+    if (m_thresholdMilliseconds > 0 && !m_run)
+    {
+        m_run = true;
+        m_watcher = std::thread(&CommandWatchdog::watch, this);
+    }
+
+    m_condition.notify_all();
+}
+
+bool CommandWatchdog::enabled() const
+{
+    return m_thresholdMilliseconds.load(std::memory_order_relaxed) > 0;
+}
+
+std::function<void()> CommandWatchdog::track(const std::string& buffer, const std::string& origin,
+                                             std::function<void()> command)
+{
+    if (!enabled())
+    {
+        return command;
+    }
+
+    std::shared_ptr<Ticket> ticket;
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+
+        const std::string* bufferName = nullptr;
+        Buffer& tracked = this->buffer(buffer, bufferName);
+
+        const auto id = ++m_nextId;
+        m_entries.emplace(id, Entry{&tracked, bufferName, origin, Clock::now(), {}, false, false});
+        ticket = std::make_shared<Ticket>(*this, id);
+    }
+
+    // ticket is released with the last copy of the command, also when buffer drops it without running
+    auto shared = std::make_shared<std::function<void()>>(std::move(command));
+    return [ticket, shared] {
+        ticket->start();
+        (*shared)();
+        ticket->finish();
+    };
+}
+
+std::uint64_t CommandWatchdog::getStallCount() const
+{
+    return m_stallCount;
+}
+
+CommandWatchdog::Ticket::Ticket(CommandWatchdog& watchdog, std::uint64_t id) : m_watchdog{watchdog}, m_id{id} {}
+
+CommandWatchdog::Ticket::~Ticket()
+{
+    m_watchdog.release(m_id);
+}
+
+void CommandWatchdog::Ticket::start()
+{
+    m_watchdog.start(m_id);
+}
+
+void CommandWatchdog::Ticket::finish()
+{
+    m_watchdog.finish(m_id);
+}
+
+CommandWatchdog::Buffer& CommandWatchdog::buffer(const std::string& name, const std::string*& storedName)
+{
+    auto it = m_buffers.find(name);
+    if (it == m_buffers.end())
+    {
+        auto& registry = MetricsRegistry::getInstance();
+        const std::string prefix = "wolkgateway_command_buffer_" + name;
+        it = m_buffers
+               .emplace(name, std::unique_ptr<Buffer>(new Buffer{registry.histogram(prefix + "_queue_latency_seconds"),
+                                                                 registry.histogram(prefix + "_run_time_seconds"),
+                                                                 registry.counter(prefix + "_stalls_total")}))
+               .first;
+    }
+
+    storedName = &it->first;
+    return *it->second;
+}
+
+void CommandWatchdog::start(std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    auto it = m_entries.find(id);
+    if (it == m_entries.end())
+    {
+        return;
+    }
+
+    Entry& entry = it->second;
+    entry.startedAt = Clock::now();
+    entry.started = true;
+    entry.buffer->queueLatency.record(entry.startedAt - entry.enqueuedAt);
+
+    // watcher may not have looked since the threshold was crossed
+    report(entry, entry.startedAt);
+}
+
+void CommandWatchdog::finish(std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    auto it = m_entries.find(id);
+    if (it == m_entries.end())
+    {
+        return;
+    }
+
+    Entry& entry = it->second;
+    const auto now = Clock::now();
+    entry.buffer->runTime.record(now - entry.startedAt);
+    report(entry, now);
+
+    m_entries.erase(it);
+}
+
+void CommandWatchdog::release(std::uint64_t id)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    m_entries.erase(id);
+}
+
+void CommandWatchdog::report(Entry& entry, Clock::time_point now)
+{
+    const std::chrono::milliseconds threshold{m_thresholdMilliseconds.load()};
+    const auto since = entry.started ? entry.startedAt : entry.enqueuedAt;
+    if (entry.reported || threshold.count() == 0 || now - since <= threshold)
+    {
+        return;
+    }
+
+    entry.reported = true;
+    entry.buffer->stalls.increment();
+    ++m_stallCount;
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - since).count();
+    LOG(WARN) << "CommandWatchdog: Command on '" << *entry.bufferName << "' has been "
+              << (entry.started ? "running" : "queued") << " for " << elapsed << " ms"
+              << (m_dumpOrigins && !entry.origin.empty() ? ", queued by '" + entry.origin + "'" : "");
+}
+
+void CommandWatchdog::watch()
+{
+    std::unique_lock<std::mutex> locker{m_lock};
+
+    while (m_run)
+    {
+        const std::chrono::milliseconds threshold{m_thresholdMilliseconds.load()};
+        const auto interval = std::max(threshold / 2, MINIMUM_WATCH_INTERVAL);
+        m_condition.wait_for(locker, interval);
+
+        const auto now = Clock::now();
+        for (auto& entry : m_entries)
+        {
+            report(entry.second, now);
+        }
+    }
+}
+}    // namespace wolkabout
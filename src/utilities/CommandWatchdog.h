@@ -0,0 +1,143 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef COMMANDWATCHDOG_H
+#define COMMANDWATCHDOG_H
+
+#include "utilities/Metrics.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace wolkabout
+{
+/**
+ * @brief Reports commands that wait in or block a command buffer for longer than a threshold
+ *
+ * Commands are wrapped before they are pushed to their buffer. Time from push to start and running time
+ * are recorded as wolkgateway_command_buffer_<buffer>_queue_latency_seconds and _run_time_seconds histograms,
+ * and a watcher thread logs a warning and increments wolkgateway_command_buffer_<buffer>_stalls_total
+ * as soon as a command crosses the threshold, so a blocked buffer is reported while it is still blocked.
+ * Each command is reported at most once. Origin tag, such as channel of the handled message or
+ * function that queued the command, is included in reports when enabled.
+ *
+ * When disabled, commands are passed through unchanged and nothing is recorded.
+ */
+class CommandWatchdog
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static CommandWatchdog& getInstance();
+
+    ~CommandWatchdog();
+
+    CommandWatchdog(const CommandWatchdog&) = delete;
+    CommandWatchdog& operator=(const CommandWatchdog&) = delete;
+
+    /**
+     * @param threshold Time a command may be queued or running before it is reported, 0 disables watchdog
+     * @param dumpOrigins Whether origin tags of reported commands are logged
+     */
+    void configure(std::chrono::milliseconds threshold, bool dumpOrigins = true);
+
+    bool enabled() const;
+
+    /**
+     * @brief Wraps command about to be pushed to command buffer
+     * @param buffer Name of command buffer, part of metric names
+     * @param origin Tag describing where command comes from
+     * @param command Command to wrap
+     * @return Command to push instead, or the given one if watchdog is disabled
+     */
+    std::function<void()> track(const std::string& buffer, const std::string& origin,
+                                std::function<void()> command);
+
+    /**
+     * @brief Number of commands reported as stalled so far, for all buffers
+     */
+    std::uint64_t getStallCount() const;
+
+private:
+    struct Buffer
+    {
+        Histogram& queueLatency;
+        Histogram& runTime;
+        Counter& stalls;
+    };
+
+    struct Entry
+    {
+        Buffer* buffer;
+        const std::string* bufferName;
+        std::string origin;
+        Clock::time_point enqueuedAt;
+        Clock::time_point startedAt;
+        bool started;
+        bool reported;
+    };
+
+    class Ticket
+    {
+    public:
+        Ticket(CommandWatchdog& watchdog, std::uint64_t id);
+        ~Ticket();
+
+        void start();
+        void finish();
+
+    private:
+        CommandWatchdog& m_watchdog;
+        const std::uint64_t m_id;
+    };
+
+    CommandWatchdog();
+
+    Buffer& buffer(const std::string& name, const std::string*& storedName);
+
+    void start(std::uint64_t id);
+    void finish(std::uint64_t id);
+    void release(std::uint64_t id);
+
+    void report(Entry& entry, Clock::time_point now);
+    void watch();
+
+    std::atomic<std::int64_t> m_thresholdMilliseconds;
+    std::atomic_bool m_dumpOrigins;
+    std::atomic<std::uint64_t> m_stallCount;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_condition;
+    std::map<std::string, std::unique_ptr<Buffer>> m_buffers;
+    std::unordered_map<std::uint64_t, Entry> m_entries;
+    std::uint64_t m_nextId;
+
+    bool m_run;
+    std::thread m_watcher;
+};
+}    // namespace wolkabout
+
+#endif    // COMMANDWATCHDOG_H
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/Deflate.h"
+
+#include <zlib.h>
+
+namespace wolkabout
+{
+// zlib favours matches near the end of dictionary, so most common fragments come last
+const std::string Deflate::READING_DICTIONARY =
+  "{\"fileList\":[\"\",\"\"]}{\"status\":\"ERROR\",\"value\":\"\"},{\"status\":\"READY\",\"value\":\""
+  "\"active\":false}\"active\":true}\"data\":\"0.\"},{\"utc\":1[{\"utc\":1";
+
+bool Deflate::compress(const std::string& input, const std::string& dictionary, std::string& output)
+{
+    z_stream stream{};
+    if (deflateInit(&stream, Z_BEST_COMPRESSION) != Z_OK)
+    {
+        return false;
+    }
+
+    if (!dictionary.empty() &&
+        deflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.data()),
+                             static_cast<uInt>(dictionary.size())) != Z_OK)
+    {
+        deflateEnd(&stream);
+        return false;
+    }
+
+    output.resize(deflateBound(&stream, static_cast<uLong>(input.size())));
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+
+    const int result = deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+
+    return result == Z_STREAM_END;
+}
+
+bool Deflate::decompress(const std::string& input, const std::string& dictionary, std::string& output)
+{
+    z_stream stream{};
+    if (inflateInit(&stream) != Z_OK)
+    {
+        return false;
+    }
+
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+    stream.avail_in = static_cast<uInt>(input.size());
+
+    output.clear();
+    char buffer[4096];
+
+    int result = Z_OK;
+    while (result == Z_OK)
+    {
+        stream.next_out = reinterpret_cast<Bytef*>(buffer);
+        stream.avail_out = sizeof(buffer);
+
+        result = inflate(&stream, Z_NO_FLUSH);
+        if (result == Z_NEED_DICT && !dictionary.empty())
+        {
+            result = inflateSetDictionary(&stream, reinterpret_cast<const Bytef*>(dictionary.data()),
+                                          static_cast<uInt>(dictionary.size()));
+        }
+
+        output.append(buffer, sizeof(buffer) - stream.avail_out);
+
+        // no progress is only possible on truncated input
+        if (result == Z_BUF_ERROR || (result == Z_OK && stream.avail_in == 0 && stream.avail_out != 0))
+        {
+            break;
+        }
+    }
+
+    inflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+}    // namespace wolkabout
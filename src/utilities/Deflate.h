@@ -0,0 +1,57 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DEFLATE_H
+#define DEFLATE_H
+
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * @brief zlib stream compression of message payloads, optionally primed with a preset dictionary
+ *
+ * With a dictionary, receiver must inflate using the same one, identified by its Adler-32 checksum
+ * in the zlib header. Compressed payloads always start with the zlib header byte 0x78,
+ * so they can not be mistaken for JSON text.
+ */
+class Deflate
+{
+public:
+    /**
+     * @brief Dictionary made of JSON fragments common to readings, alarms, actuator statuses and file lists
+     */
+    static const std::string READING_DICTIONARY;
+
+    /**
+     * @param input Data to compress
+     * @param dictionary Preset dictionary, empty for none
+     * @param output Receives zlib stream
+     * @return false if zlib reports an error
+     */
+    static bool compress(const std::string& input, const std::string& dictionary, std::string& output);
+
+    /**
+     * @param input zlib stream
+     * @param dictionary Preset dictionary stream was compressed with, empty for none
+     * @param output Receives decompressed data
+     * @return false if input is not a complete zlib stream or dictionary does not match
+     */
+    static bool decompress(const std::string& input, const std::string& dictionary, std::string& output);
+};
+}    // namespace wolkabout
+
+#endif    // DEFLATE_H
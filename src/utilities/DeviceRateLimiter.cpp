@@ -0,0 +1,193 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/DeviceRateLimiter.h"
+#include "utilities/GatewayLog.h"
+
+#include <algorithm>
+
+namespace wolkabout
+{
+const std::string DeviceRateLimiter::DROPPED_MESSAGES_METRIC = "wolkgateway_inbound_device_rate_limited_messages_total";
+
+DeviceRateLimiter::DeviceRateLimiter(double messagesPerSecond, std::size_t burst,
+                                     std::chrono::milliseconds quarantineAfter,
+                                     std::chrono::milliseconds quarantineDuration)
+: m_rate{std::max(messagesPerSecond, 0.0)}
+, m_capacity{static_cast<double>(std::max<std::size_t>(burst, 1))}
+, m_quarantineAfter{quarantineAfter}
+, m_quarantineDuration{quarantineDuration}
+, m_droppedMessages{MetricsRegistry::getInstance().counter(DROPPED_MESSAGES_METRIC)}
+, m_quarantinedDevices{MetricsRegistry::getInstance().gauge("wolkgateway_inbound_device_quarantined_devices")}
+{
+}
+
+bool DeviceRateLimiter::allow(const std::string& deviceKey, Clock::time_point now)
+{
+    bool released = false;
+    bool quarantined = false;
+    bool allowed = false;
+    double rate = 0;
+
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+
+        auto it = m_buckets.find(deviceKey);
+        if (it == m_buckets.end())
+        {
+            it = m_buckets.emplace(deviceKey, Bucket{m_capacity, now}).first;
+        }
+
+        Bucket& bucket = it->second;
+
+        if (bucket.quarantined)
+        {
+            if (now < bucket.quarantinedUntil)
+            {
+                drop(deviceKey, bucket);
+                return false;
+            }
+
+            bucket.quarantined = false;
+            bucket.overLimit = false;
+            bucket.tokens = m_capacity;
+            bucket.lastRefill = now;
+            m_quarantinedDevices.decrement();
+            released = true;
+        }
+
+        refill(bucket, now);
+
+        if (bucket.tokens >= 1)
+        {
+            bucket.tokens -= 1;
+            allowed = true;
+        }
+        else
+        {
+            drop(deviceKey, bucket);
+
+            if (!bucket.overLimit)
+            {
+                bucket.overLimit = true;
+                bucket.overLimitSince = now;
+            }
+            else if (m_quarantineDuration.count() > 0 && now - bucket.overLimitSince >= m_quarantineAfter)
+            {
+                bucket.quarantined = true;
+                bucket.quarantinedUntil = now + m_quarantineDuration;
+                m_quarantinedDevices.increment();
+                quarantined = true;
+                rate = m_rate;
+            }
+        }
+    }
+
+    if (released)
+    {
+        LOG(INFO) << "DeviceRateLimiter: Device '" << deviceKey << "' released from quarantine";
+        if (m_quarantineListener)
+        {
+            m_quarantineListener(deviceKey, false);
+        }
+    }
+
+    if (quarantined)
+    {
+        LOG(WARN) << "DeviceRateLimiter: Device '" << deviceKey << "' quarantined, it kept exceeding "
+                  << rate << " messages per second";
+        if (m_quarantineListener)
+        {
+            m_quarantineListener(deviceKey, true);
+        }
+    }
+
+    return allowed;
+}
+
+void DeviceRateLimiter::setQuarantineListener(QuarantineListener listener)
+{
+    m_quarantineListener = std::move(listener);
+}
+
+void DeviceRateLimiter::setRate(double messagesPerSecond, std::size_t burst)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    m_rate = std::max(messagesPerSecond, 0.0);
+    m_capacity = static_cast<double>(std::max<std::size_t>(burst, 1));
+
+    for (auto& kvp : m_buckets)
+    {
+        kvp.second.tokens = std::min(kvp.second.tokens, m_capacity);
+    }
+}
+
+bool DeviceRateLimiter::isQuarantined(const std::string& deviceKey) const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    auto it = m_buckets.find(deviceKey);
+    return it != m_buckets.end() && it->second.quarantined;
+}
+
+std::map<std::string, std::uint64_t> DeviceRateLimiter::droppedMessages() const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    std::map<std::string, std::uint64_t> dropped;
+    for (const auto& kvp : m_buckets)
+    {
+        if (kvp.second.dropped)
+        {
+            dropped[kvp.first] = kvp.second.dropped->value();
+        }
+    }
+
+    return dropped;
+}
+
+void DeviceRateLimiter::refill(Bucket& bucket, Clock::time_point now) const
+{
+    if (now <= bucket.lastRefill)
+    {
+        return;
+    }
+
+    const double seconds = std::chrono::duration<double>(now - bucket.lastRefill).count();
+    bucket.lastRefill = now;
+    bucket.tokens = std::min(bucket.tokens + seconds * m_rate, m_capacity);
+
+    // device that let its bucket fill up is no longer considered flooding
+    if (bucket.tokens >= m_capacity)
+    {
+        bucket.overLimit = false;
+    }
+}
+
+void DeviceRateLimiter::drop(const std::string& deviceKey, Bucket& bucket)
+{
+    // per device counters are created only for devices that get limited, which keeps their number small
+    if (!bucket.dropped)
+    {
+        bucket.dropped =
+          &MetricsRegistry::getInstance().counter(DROPPED_MESSAGES_METRIC + "{device=\"" + deviceKey + "\"}");
+    }
+
+    bucket.dropped->increment();
+    m_droppedMessages.increment();
+}
+}    // namespace wolkabout
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DEVICERATELIMITER_H
+#define DEVICERATELIMITER_H
+
+#include "utilities/Metrics.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace wolkabout
+{
+/**
+ * @brief Token bucket per device, so one flooding device can not starve the others
+ *
+ * Each device may send burst messages at once and messagesPerSecond on average. Messages beyond that are dropped.
+ * Device that keeps exceeding its rate, without letting its bucket fill up again, for quarantineAfter
+ * is quarantined and all of its messages are dropped for quarantineDuration. Quarantine is lifted with the first
+ * message received after it expires, and the device starts again with a full bucket.
+ */
+class DeviceRateLimiter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Called with device key when device enters (true) or leaves (false) quarantine
+     */
+    using QuarantineListener = std::function<void(const std::string& deviceKey, bool quarantined)>;
+
+    DeviceRateLimiter(double messagesPerSecond, std::size_t burst, std::chrono::milliseconds quarantineAfter,
+                      std::chrono::milliseconds quarantineDuration);
+
+    /**
+     * @brief Accounts message received from device
+     * @return true if message should be handled, false if it is dropped
+     */
+    bool allow(const std::string& deviceKey, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Must be called before messages are received
+     */
+    void setQuarantineListener(QuarantineListener listener);
+
+    /**
+     * @brief Changes rate and burst of all devices, buckets holding more tokens than new burst are trimmed
+     */
+    void setRate(double messagesPerSecond, std::size_t burst);
+
+    bool isQuarantined(const std::string& deviceKey) const;
+
+    /**
+     * @brief Dropped message counts of devices that had messages dropped
+     */
+    std::map<std::string, std::uint64_t> droppedMessages() const;
+
+    static const std::string DROPPED_MESSAGES_METRIC;
+
+private:
+    struct Bucket
+    {
+        Bucket(double capacity, Clock::time_point now)
+        : tokens{capacity}, lastRefill{now}, overLimit{false}, quarantined{false}, dropped{nullptr}
+        {
+        }
+
+        double tokens;
+        Clock::time_point lastRefill;
+
+        bool overLimit;
+        Clock::time_point overLimitSince;
+
+        bool quarantined;
+        Clock::time_point quarantinedUntil;
+
+        Counter* dropped;
+    };
+
+    void refill(Bucket& bucket, Clock::time_point now) const;
+    void drop(const std::string& deviceKey, Bucket& bucket);
+
+    double m_rate;
+    double m_capacity;
+    const Clock::duration m_quarantineAfter;
+    const Clock::duration m_quarantineDuration;
+
+    QuarantineListener m_quarantineListener;
+
+    mutable std::mutex m_lock;
+    std::unordered_map<std::string, Bucket> m_buckets;
+
+    Counter& m_droppedMessages;
+    Gauge& m_quarantinedDevices;
+};
+}    // namespace wolkabout
+
+#endif    // DEVICERATELIMITER_H
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DEVICEREGISTRY_H
+#define DEVICEREGISTRY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Per-device state slots addressed by dense integer handles
+ *
+ * Devices are spread over shards by hash of their key, and each shard has its own lock, so devices in
+ * different shards are looked up and updated concurrently. Handle encodes shard and position of slot
+ * within it, so slot is reached without hashing the key again.
+ * Handle stays valid until device is released, after which it may be given to another device.
+ */
+template <class Slot> class DeviceRegistry
+{
+public:
+    using Handle = std::uint32_t;
+
+    static constexpr Handle INVALID_HANDLE = std::numeric_limits<Handle>::max();
+    static constexpr std::size_t DEFAULT_SHARDS = 16;
+
+    explicit DeviceRegistry(std::size_t shards = DEFAULT_SHARDS)
+    {
+        const auto count = shards != 0 ? shards : 1;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            m_shards.emplace_back(new Shard());
+        }
+    }
+
+    DeviceRegistry(const DeviceRegistry&) = delete;
+    DeviceRegistry& operator=(const DeviceRegistry&) = delete;
+
+    /**
+     * @brief Returns handle of device, adding device with default constructed slot if it is not present
+     */
+    Handle acquire(const std::string& deviceKey)
+    {
+        const auto shardIndex = shardOf(deviceKey);
+        Shard& shard = *m_shards[shardIndex];
+
+        std::lock_guard<std::mutex> lg{shard.lock};
+
+        const auto it = shard.indices.find(deviceKey);
+        if (it != shard.indices.end())
+        {
+            return handleOf(shardIndex, it->second);
+        }
+
+        std::uint32_t index;
+        if (!shard.free.empty())
+        {
+            index = shard.free.back();
+            shard.free.pop_back();
+        }
+        else
+        {
+            index = static_cast<std::uint32_t>(shard.entries.size());
+            shard.entries.emplace_back();
+        }
+
+        shard.entries[index].live = true;
+        shard.indices.emplace(deviceKey, index);
+        return handleOf(shardIndex, index);
+    }
+
+    /**
+     * @return Handle of device, or INVALID_HANDLE if device is not present
+     */
+    Handle find(const std::string& deviceKey) const
+    {
+        const auto shardIndex = shardOf(deviceKey);
+        const Shard& shard = *m_shards[shardIndex];
+
+        std::lock_guard<std::mutex> lg{shard.lock};
+
+        const auto it = shard.indices.find(deviceKey);
+        return it != shard.indices.end() ? handleOf(shardIndex, it->second) : INVALID_HANDLE;
+    }
+
+    /**
+     * @brief Removes device and resets its slot
+     * @return false if device was not present
+     */
+    bool release(const std::string& deviceKey)
+    {
+        Shard& shard = *m_shards[shardOf(deviceKey)];
+
+        std::lock_guard<std::mutex> lg{shard.lock};
+
+        const auto it = shard.indices.find(deviceKey);
+        if (it == shard.indices.end())
+        {
+            return false;
+        }
+
+        Entry& entry = shard.entries[it->second];
+        entry.live = false;
+        entry.slot = Slot{};
+        shard.free.push_back(it->second);
+        shard.indices.erase(it);
+        return true;
+    }
+
+    /**
+     * @brief Calls function with slot of device while holding lock of its shard
+     * Function must not call back into registry
+     * @return false if handle does not belong to a present device
+     */
+    template <class Function> bool with(Handle handle, Function function)
+    {
+        if (handle == INVALID_HANDLE)
+        {
+            return false;
+        }
+
+        Shard& shard = *m_shards[handle % m_shards.size()];
+        const auto index = handle / m_shards.size();
+
+        std::lock_guard<std::mutex> lg{shard.lock};
+
+        if (index >= shard.entries.size() || !shard.entries[index].live)
+        {
+            return false;
+        }
+
+        function(shard.entries[index].slot);
+        return true;
+    }
+
+    /**
+     * @brief Calls function with slot of device while holding lock of its shard
+     * @return false if device is not present
+     */
+    template <class Function> bool with(const std::string& deviceKey, Function function)
+    {
+        Shard& shard = *m_shards[shardOf(deviceKey)];
+
+        std::lock_guard<std::mutex> lg{shard.lock};
+
+        const auto it = shard.indices.find(deviceKey);
+        if (it == shard.indices.end())
+        {
+            return false;
+        }
+
+        function(shard.entries[it->second].slot);
+        return true;
+    }
+
+    void clear()
+    {
+        for (auto& shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lg{shard->lock};
+            shard->indices.clear();
+            shard->entries.clear();
+            shard->free.clear();
+        }
+    }
+
+    std::size_t size() const
+    {
+        std::size_t count = 0;
+        for (const auto& shard : m_shards)
+        {
+            std::lock_guard<std::mutex> lg{shard->lock};
+            count += shard->indices.size();
+        }
+
+        return count;
+    }
+
+private:
+    struct Entry
+    {
+        bool live = false;
+        Slot slot{};
+    };
+
+    struct Shard
+    {
+        mutable std::mutex lock;
+        std::unordered_map<std::string, std::uint32_t> indices;
+        std::vector<Entry> entries;
+        std::vector<std::uint32_t> free;
+    };
+
+    std::size_t shardOf(const std::string& deviceKey) const
+    {
+        return std::hash<std::string>{}(deviceKey) % m_shards.size();
+    }
+
+    Handle handleOf(std::size_t shard, std::uint32_t index) const
+    {
+        return static_cast<Handle>(index * m_shards.size() + shard);
+    }
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+};
+
+template <class Slot> constexpr typename DeviceRegistry<Slot>::Handle DeviceRegistry<Slot>::INVALID_HANDLE;
+template <class Slot> constexpr std::size_t DeviceRegistry<Slot>::DEFAULT_SHARDS;
+}    // namespace wolkabout
+
+#endif    // DEVICEREGISTRY_H
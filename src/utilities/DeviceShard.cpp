@@ -0,0 +1,112 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/DeviceShard.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+namespace wolkabout
+{
+const std::string DeviceShard::CHANNEL_PREFIX = "shard/";
+
+DeviceShard::DeviceShard(std::size_t index, std::size_t count)
+: m_index{index}, m_count{std::max<std::size_t>(count, 1)}
+{
+    if (m_index >= m_count)
+    {
+        throw std::logic_error("Shard index must be lower than shard count");
+    }
+}
+
+std::size_t DeviceShard::getIndex() const
+{
+    return m_index;
+}
+
+std::size_t DeviceShard::getCount() const
+{
+    return m_count;
+}
+
+bool DeviceShard::isPrimary() const
+{
+    return m_index == 0;
+}
+
+bool DeviceShard::owns(const std::string& deviceKey) const
+{
+    return of(deviceKey, m_count) == m_index;
+}
+
+bool DeviceShard::ownsChannel(const std::string& channel) const
+{
+    const auto deviceKey = deviceKeyOf(channel);
+    return deviceKey.empty() ? isPrimary() : owns(deviceKey);
+}
+
+std::string DeviceShard::getChannelPrefix() const
+{
+    return channelPrefix(m_index);
+}
+
+std::size_t DeviceShard::of(const std::string& deviceKey, std::size_t count)
+{
+    if (count <= 1)
+    {
+        return 0;
+    }
+
+    // std::hash may differ between builds, workers and router must agree on the owner
+    std::uint64_t hash = 14695981039346656037ull;
+    for (const char c : deviceKey)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+
+    return static_cast<std::size_t>(hash % count);
+}
+
+std::string DeviceShard::deviceKeyOf(const std::string& channel)
+{
+    std::string::size_type start = 0;
+    while (start < channel.size())
+    {
+        auto end = channel.find('/', start);
+        if (end == std::string::npos)
+        {
+            end = channel.size();
+        }
+
+        if (end - start == 1 && channel[start] == 'd' && end < channel.size())
+        {
+            const auto keyEnd = channel.find('/', end + 1);
+            return channel.substr(end + 1, keyEnd == std::string::npos ? std::string::npos : keyEnd - end - 1);
+        }
+
+        start = end + 1;
+    }
+
+    return "";
+}
+
+std::string DeviceShard::channelPrefix(std::size_t index)
+{
+    return CHANNEL_PREFIX + std::to_string(index) + "/";
+}
+}    // namespace wolkabout
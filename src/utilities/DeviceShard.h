@@ -0,0 +1,75 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DEVICESHARD_H
+#define DEVICESHARD_H
+
+#include <cstddef>
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * @brief Slice of subdevices handled by one of several gateway worker processes
+ *
+ * Devices are assigned to shards by FNV-1a hash of their key, which is the same in every process,
+ * so the router and all workers agree on the owner of a device without sharing any state.
+ * Messages of the gateway itself belong to the primary shard, the one with index 0.
+ */
+class DeviceShard
+{
+public:
+    /**
+     * @param index Index of this shard, lower than count
+     * @param count Number of shards, 0 is treated as 1
+     */
+    explicit DeviceShard(std::size_t index = 0, std::size_t count = 1);
+
+    std::size_t getIndex() const;
+    std::size_t getCount() const;
+    bool isPrimary() const;
+
+    bool owns(const std::string& deviceKey) const;
+
+    /**
+     * @brief Checks whether message on channel belongs to this shard
+     * Channels without device key, "d/<key>" level, belong to the primary shard
+     */
+    bool ownsChannel(const std::string& channel) const;
+
+    /**
+     * @brief Prefix of channels on which router republishes messages of this shard
+     */
+    std::string getChannelPrefix() const;
+
+    static std::size_t of(const std::string& deviceKey, std::size_t count);
+
+    /**
+     * @brief Returns device key from "d/<key>" level of channel, or empty string if there is none
+     */
+    static std::string deviceKeyOf(const std::string& channel);
+
+    static std::string channelPrefix(std::size_t index);
+
+    static const std::string CHANNEL_PREFIX;
+
+private:
+    std::size_t m_index;
+    std::size_t m_count;
+};
+}    // namespace wolkabout
+
+#endif    // DEVICESHARD_H
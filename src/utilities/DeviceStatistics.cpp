@@ -0,0 +1,222 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/DeviceStatistics.h"
+#include "utilities/JsonWriter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// sums are rescaled before their weight outgrows the precision of double
+const double MAXIMUM_WEIGHT_EXPONENT = 32;
+
+const double LATENCY_SMOOTHING = 0.125;
+}    // namespace
+
+namespace wolkabout
+{
+const std::size_t DeviceStatistics::DEFAULT_CAPACITY = 256;
+const std::chrono::milliseconds DeviceStatistics::DEFAULT_HALF_LIFE{10000};
+
+DeviceStatistics::DeviceStatistics(std::size_t capacity, std::chrono::milliseconds halfLife)
+: m_capacity{capacity != 0 ? capacity : 1}
+, m_halfLife{std::max(std::chrono::duration<double>(halfLife).count(), 0.001)}
+, m_landmark{Clock::now()}
+{
+    m_slots.reserve(m_capacity);
+}
+
+void DeviceStatistics::messageReceived(const std::string& deviceKey, std::size_t bytes, Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    if (std::chrono::duration<double>(now - m_landmark).count() / m_halfLife > MAXIMUM_WEIGHT_EXPONENT)
+    {
+        rescale(now);
+    }
+
+    const double increment = weight(now);
+
+    auto it = m_index.find(deviceKey);
+    if (it != m_index.end())
+    {
+        Slot& slot = m_slots[it->second];
+        slot.messages += increment;
+        slot.bytes += increment * static_cast<double>(bytes);
+        slot.lastSeen = std::max(slot.lastSeen, now);
+        return;
+    }
+
+    Slot slot{deviceKey, increment, increment * static_cast<double>(bytes), 0, 0, now, 0, false};
+    if (m_slots.size() < m_capacity)
+    {
+        m_index.emplace(deviceKey, m_slots.size());
+        m_slots.push_back(std::move(slot));
+        return;
+    }
+
+    const auto replaced = std::min_element(m_slots.begin(), m_slots.end(), [](const Slot& lhs, const Slot& rhs) {
+        return lhs.messages < rhs.messages;
+    });
+
+    slot.messages += replaced->messages;
+    slot.error = replaced->messages;
+
+    m_index.erase(replaced->deviceKey);
+    m_index.emplace(deviceKey, static_cast<std::size_t>(replaced - m_slots.begin()));
+    *replaced = std::move(slot);
+}
+
+void DeviceStatistics::messageRejected(const std::string& deviceKey)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    auto it = m_index.find(deviceKey);
+    if (it != m_index.end())
+    {
+        ++m_slots[it->second].rejectedMessages;
+    }
+}
+
+void DeviceStatistics::messageForwarded(const std::string& deviceKey, Clock::duration latency)
+{
+    const double microseconds = std::chrono::duration<double, std::micro>(latency).count();
+
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    auto it = m_index.find(deviceKey);
+    if (it == m_index.end())
+    {
+        return;
+    }
+
+    Slot& slot = m_slots[it->second];
+    if (!slot.hasLatency)
+    {
+        slot.forwardingLatency = microseconds;
+        slot.hasLatency = true;
+    }
+    else
+    {
+        slot.forwardingLatency += LATENCY_SMOOTHING * (microseconds - slot.forwardingLatency);
+    }
+}
+
+std::vector<DeviceStatistics::Entry> DeviceStatistics::topTalkers(std::size_t count, Clock::time_point now) const
+{
+    auto entries = snapshot(now);
+
+    count = std::min(count, entries.size());
+    std::partial_sort(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(count), entries.end(),
+                      [](const Entry& lhs, const Entry& rhs) { return lhs.messagesPerSecond > rhs.messagesPerSecond; });
+    entries.resize(count);
+
+    return entries;
+}
+
+std::vector<DeviceStatistics::Entry> DeviceStatistics::slowestDevices(std::size_t count, Clock::time_point now) const
+{
+    auto entries = snapshot(now);
+
+    count = std::min(count, entries.size());
+    std::partial_sort(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(count), entries.end(),
+                      [](const Entry& lhs, const Entry& rhs) { return lhs.forwardingLatency > rhs.forwardingLatency; });
+    entries.resize(count);
+
+    return entries;
+}
+
+std::string DeviceStatistics::format(std::size_t count, Clock::time_point now) const
+{
+    const auto systemNow = std::chrono::system_clock::now();
+
+    JsonWriter writer;
+    auto writeEntries = [&](const std::vector<Entry>& entries) {
+        writer.beginArray();
+        for (const auto& entry : entries)
+        {
+            const auto lastSeen = systemNow - std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                                                now - std::min(entry.lastSeen, now));
+
+            writer.beginObject()
+              .key("device_key")
+              .value(entry.deviceKey)
+              .key("messages_per_second")
+              .value(entry.messagesPerSecond)
+              .key("bytes_per_second")
+              .value(entry.bytesPerSecond)
+              .key("error")
+              .value(entry.error)
+              .key("rejected_messages")
+              .value(entry.rejectedMessages)
+              .key("last_seen")
+              .value(static_cast<std::int64_t>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(lastSeen.time_since_epoch()).count()))
+              .key("forwarding_latency_us")
+              .value(static_cast<std::int64_t>(entry.forwardingLatency.count()))
+              .endObject();
+        }
+        writer.endArray();
+    };
+
+    writer.beginObject().key("top_talkers");
+    writeEntries(topTalkers(count, now));
+    writer.key("slowest_devices");
+    writeEntries(slowestDevices(count, now));
+    writer.endObject();
+
+    return writer.str();
+}
+
+double DeviceStatistics::weight(Clock::time_point now) const
+{
+    return std::exp2(std::chrono::duration<double>(now - m_landmark).count() / m_halfLife);
+}
+
+void DeviceStatistics::rescale(Clock::time_point now)
+{
+    const double factor = 1 / weight(now);
+    for (auto& slot : m_slots)
+    {
+        slot.messages *= factor;
+        slot.bytes *= factor;
+        slot.error *= factor;
+    }
+
+    m_landmark = now;
+}
+
+std::vector<DeviceStatistics::Entry> DeviceStatistics::snapshot(Clock::time_point now) const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    // decayed sum of a steady rate converges to rate * halfLife / ln(2)
+    const double toRate = std::log(2.0) / (weight(now) * m_halfLife);
+
+    std::vector<Entry> entries;
+    entries.reserve(m_slots.size());
+    for (const auto& slot : m_slots)
+    {
+        entries.push_back(Entry{slot.deviceKey, slot.messages * toRate, slot.bytes * toRate, slot.error * toRate,
+                                slot.rejectedMessages, slot.lastSeen,
+                                std::chrono::microseconds{static_cast<std::int64_t>(slot.forwardingLatency)}});
+    }
+
+    return entries;
+}
+}    // namespace wolkabout
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DEVICESTATISTICS_H
+#define DEVICESTATISTICS_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Approximate per device traffic statistics, for finding devices that load the gateway
+ *
+ * At most capacity devices are tracked, chosen by space-saving: device not in the table replaces the one with
+ * the lowest message rate and inherits its count, so devices sending the most are kept while memory stays bounded.
+ * Message and byte counts decay exponentially with halfLife and are reported as rates, updates are O(1)
+ * except when a device is replaced, which scans the table.
+ */
+class DeviceStatistics
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry
+    {
+        std::string deviceKey;
+        double messagesPerSecond;
+        double bytesPerSecond;
+
+        // rate by which messagesPerSecond may be overestimated, inherited from replaced device
+        double error;
+
+        std::uint64_t rejectedMessages;
+        Clock::time_point lastSeen;
+
+        // moving average of time between message arrival and its handling
+        std::chrono::microseconds forwardingLatency;
+    };
+
+    static const std::size_t DEFAULT_CAPACITY;
+    static const std::chrono::milliseconds DEFAULT_HALF_LIFE;
+
+    explicit DeviceStatistics(std::size_t capacity = DEFAULT_CAPACITY,
+                              std::chrono::milliseconds halfLife = DEFAULT_HALF_LIFE);
+
+    void messageReceived(const std::string& deviceKey, std::size_t bytes, Clock::time_point now = Clock::now());
+
+    /**
+     * @brief Accounts message received from device that was not accepted, such as rate limited or unrouted one
+     * Message must have been accounted with messageReceived first
+     */
+    void messageRejected(const std::string& deviceKey);
+
+    void messageForwarded(const std::string& deviceKey, Clock::duration latency);
+
+    /**
+     * @return Up to count devices with highest message rate, highest first
+     */
+    std::vector<Entry> topTalkers(std::size_t count, Clock::time_point now = Clock::now()) const;
+
+    /**
+     * @return Up to count devices with highest forwarding latency, highest first
+     */
+    std::vector<Entry> slowestDevices(std::size_t count, Clock::time_point now = Clock::now()) const;
+
+    /**
+     * @brief Formats top talkers and slowest devices as JSON object, last seen times as UTC milliseconds
+     */
+    std::string format(std::size_t count, Clock::time_point now = Clock::now()) const;
+
+private:
+    struct Slot
+    {
+        std::string deviceKey;
+
+        // forward decayed sums, weighted relative to m_landmark so that updates do not touch other slots
+        double messages;
+        double bytes;
+        double error;
+
+        std::uint64_t rejectedMessages;
+        Clock::time_point lastSeen;
+        double forwardingLatency;
+        bool hasLatency;
+    };
+
+    double weight(Clock::time_point now) const;
+    void rescale(Clock::time_point now);
+
+    std::vector<Entry> snapshot(Clock::time_point now) const;
+
+    const std::size_t m_capacity;
+    const double m_halfLife;
+
+    mutable std::mutex m_lock;
+    Clock::time_point m_landmark;
+    std::vector<Slot> m_slots;
+    std::unordered_map<std::string, std::size_t> m_index;
+};
+}    // namespace wolkabout
+
+#endif    // DEVICESTATISTICS_H
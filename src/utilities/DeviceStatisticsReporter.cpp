@@ -0,0 +1,105 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/DeviceStatisticsReporter.h"
+#include "utilities/DeviceStatistics.h"
+#include "utilities/Logger.h"
+
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+namespace wolkabout
+{
+DeviceStatisticsReporter::DeviceStatisticsReporter(const DeviceStatistics& statistics, std::size_t count,
+                                                   std::string filePath,
+                                                   std::function<void(const std::string&)> publisher,
+                                                   std::chrono::milliseconds interval, Executor& executor)
+: m_statistics{statistics}
+, m_count{count}
+, m_filePath{std::move(filePath)}
+, m_publisher{std::move(publisher)}
+, m_interval{interval}
+, m_executor{executor}
+, m_task{0}
+, m_stopped{false}
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+    m_task = m_executor.schedule(m_interval, [=] { reportAndReschedule(); });
+}
+
+DeviceStatisticsReporter::~DeviceStatisticsReporter()
+{
+    Executor::TaskId task;
+
+    {
+        std::lock_guard<std::mutex> lg{m_mutex};
+        m_stopped = true;
+        task = m_task;
+    }
+
+    // report that is already running is waited for, and will not schedule another one
+    m_executor.cancel(task);
+}
+
+bool DeviceStatisticsReporter::reportNow()
+{
+    const auto statistics = m_statistics.format(m_count);
+
+    if (m_publisher)
+    {
+        m_publisher(statistics);
+    }
+
+    if (m_filePath.empty())
+    {
+        return true;
+    }
+
+    const std::string temporaryFilePath = m_filePath + ".tmp";
+
+    {
+        std::ofstream file{temporaryFilePath, std::ios::trunc};
+        file << statistics;
+
+        if (!file.good())
+        {
+            LOG(ERROR) << "DeviceStatisticsReporter: Unable to write statistics to '" << temporaryFilePath << "'";
+            return false;
+        }
+    }
+
+    if (std::rename(temporaryFilePath.c_str(), m_filePath.c_str()) != 0)
+    {
+        LOG(ERROR) << "DeviceStatisticsReporter: Unable to replace statistics file '" << m_filePath << "'";
+        std::remove(temporaryFilePath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void DeviceStatisticsReporter::reportAndReschedule()
+{
+    reportNow();
+
+    std::lock_guard<std::mutex> lg{m_mutex};
+    if (!m_stopped)
+    {
+        m_task = m_executor.schedule(m_interval, [=] { reportAndReschedule(); });
+    }
+}
+}    // namespace wolkabout
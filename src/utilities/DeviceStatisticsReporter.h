@@ -0,0 +1,72 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef DEVICESTATISTICSREPORTER_H
+#define DEVICESTATISTICSREPORTER_H
+
+#include "utilities/Executor.h"
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace wolkabout
+{
+class DeviceStatistics;
+
+/**
+ * @brief Periodically writes wolkabout::DeviceStatistics to a file and hands them to a publisher
+ *
+ * File is replaced atomically, so local tools can read it at any time to see which devices load the gateway.
+ */
+class DeviceStatisticsReporter
+{
+public:
+    /**
+     * @param statistics Statistics to report, must outlive reporter
+     * @param count Number of top talkers and slowest devices reported
+     * @param filePath File statistics are written to as JSON, empty for none
+     * @param publisher Called with statistics JSON on executor thread, empty for none
+     */
+    DeviceStatisticsReporter(const DeviceStatistics& statistics, std::size_t count, std::string filePath,
+                             std::function<void(const std::string&)> publisher, std::chrono::milliseconds interval,
+                             Executor& executor);
+    ~DeviceStatisticsReporter();
+
+    DeviceStatisticsReporter(const DeviceStatisticsReporter&) = delete;
+    DeviceStatisticsReporter& operator=(const DeviceStatisticsReporter&) = delete;
+
+    bool reportNow();
+
+private:
+    void reportAndReschedule();
+
+    const DeviceStatistics& m_statistics;
+    const std::size_t m_count;
+    const std::string m_filePath;
+    const std::function<void(const std::string&)> m_publisher;
+    const std::chrono::milliseconds m_interval;
+    Executor& m_executor;
+
+    std::mutex m_mutex;
+    Executor::TaskId m_task;
+    bool m_stopped;
+};
+}    // namespace wolkabout
+
+#endif    // DEVICESTATISTICSREPORTER_H
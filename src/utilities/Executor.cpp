@@ -0,0 +1,167 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/Executor.h"
+#include "utilities/Logger.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace wolkabout
+{
+const std::size_t Executor::DEFAULT_WORKERS = 2;
+
+Executor::Executor(std::size_t workers) : m_nextId{0}, m_run{true}
+{
+    for (std::size_t i = 0; i < std::max(workers, std::size_t{1}); ++i)
+    {
+        m_workers.emplace_back(&Executor::run, this);
+    }
+}
+
+Executor::~Executor()
+{
+    {
+        std::lock_guard<std::mutex> locker{m_lock};
+        m_run = false;
+    }
+
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        if (worker.joinable())
+        {
+            worker.join();
+        }
+    }
+}
+
+Executor::TaskId Executor::post(std::function<void()> task)
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    const auto id = ++m_nextId;
+    m_tasks.emplace(id, Task{std::move(task), 0});
+    m_queue.push_back(id);
+
+    m_condition.notify_one();
+    return id;
+}
+
+Executor::TaskId Executor::schedule(std::chrono::milliseconds delay, std::function<void()> task)
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    const auto id = ++m_nextId;
+    // timer callback takes the lock, so it can not run before the task is registered
+    const auto timer = m_timers.schedule(delay, [=] { enqueue(id); });
+    m_tasks.emplace(id, Task{std::move(task), timer});
+
+    return id;
+}
+
+bool Executor::cancel(TaskId id)
+{
+    std::unique_lock<std::mutex> locker{m_lock};
+
+    auto it = m_tasks.find(id);
+    if (it != m_tasks.end())
+    {
+        if (it->second.timer != 0)
+        {
+            m_timers.cancel(it->second.timer);
+        }
+
+        // queued id is skipped by workers once the task is gone
+        m_tasks.erase(it);
+        return true;
+    }
+
+    m_finished.wait(locker, [&] {
+        auto running = m_running.find(id);
+        return running == m_running.end() || running->second == std::this_thread::get_id();
+    });
+
+    return false;
+}
+
+void Executor::enqueue(TaskId id)
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    auto it = m_tasks.find(id);
+    if (it == m_tasks.end())
+    {
+        return;
+    }
+
+    it->second.timer = 0;
+    m_queue.push_back(id);
+
+    m_condition.notify_one();
+}
+
+void Executor::run()
+{
+    std::unique_lock<std::mutex> locker{m_lock};
+
+    while (true)
+    {
+        m_condition.wait(locker, [&] { return !m_run || !m_queue.empty(); });
+
+        if (!m_run)
+        {
+            return;
+        }
+
+        const auto id = m_queue.front();
+        m_queue.pop_front();
+
+        auto it = m_tasks.find(id);
+        if (it == m_tasks.end())
+        {
+            continue;
+        }
+
+        auto function = std::move(it->second.function);
+        m_tasks.erase(it);
+        m_running.emplace(id, std::this_thread::get_id());
+
+        locker.unlock();
+
+        try
+        {
+            function();
+        }
+        catch (const std::exception& e)
+        {
+            LOG(ERROR) << "Executor: Task failed: " << e.what();
+        }
+        catch (...)
+        {
+            LOG(ERROR) << "Executor: Task failed";
+        }
+
+        // release captured state before taking the lock, its destructors may use the executor
+        function = nullptr;
+        locker.lock();
+
+        m_running.erase(id);
+        m_finished.notify_all();
+    }
+}
+}    // namespace wolkabout
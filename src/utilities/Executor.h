@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef EXECUTOR_H
+#define EXECUTOR_H
+
+#include "utilities/TimerWheel.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Fixed pool of worker threads with delayed task support, shared by gateway services
+ *
+ * Delayed tasks are kept on a TimerWheel and handed over to workers once due.
+ * Tasks still pending when executor is destroyed are dropped.
+ */
+class Executor
+{
+public:
+    using TaskId = std::uint64_t;
+
+    explicit Executor(std::size_t workers = DEFAULT_WORKERS);
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /**
+     * @brief Queues task for execution on one of the workers
+     * @param task Task to execute
+     * @return Id which can be used to cancel task
+     */
+    TaskId post(std::function<void()> task);
+
+    /**
+     * @brief Queues task for execution after delay
+     * @param delay Time after which task is executed
+     * @param task Task to execute
+     * @return Id which can be used to cancel task
+     */
+    TaskId schedule(std::chrono::milliseconds delay, std::function<void()> task);
+
+    /**
+     * @brief Cancels task which has not started yet
+     *
+     * If task is running on another thread, waits for it to finish, so that
+     * owner can safely release resources task refers to once this returns.
+     * @param id Id returned by post or schedule
+     * @return true if task was cancelled before it started
+     */
+    bool cancel(TaskId id);
+
+    static const std::size_t DEFAULT_WORKERS;
+
+private:
+    struct Task
+    {
+        std::function<void()> function;
+        TimerWheel::Id timer;
+    };
+
+    void enqueue(TaskId id);
+    void run();
+
+    std::unordered_map<TaskId, Task> m_tasks;
+    std::deque<TaskId> m_queue;
+    std::unordered_map<TaskId, std::thread::id> m_running;
+    TaskId m_nextId;
+
+    std::mutex m_lock;
+    std::condition_variable m_condition;
+    std::condition_variable m_finished;
+
+    std::atomic_bool m_run;
+    std::vector<std::thread> m_workers;
+
+    TimerWheel m_timers;
+};
+}    // namespace wolkabout
+
+#endif    // EXECUTOR_H
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef GATEWAYLOG_H
+#define GATEWAYLOG_H
+
+#include "utilities/Logger.h"
+
+/**
+ * Lowest log level compiled into the gateway, one of TRACE, DEBUG, INFO, WARN or ERROR.
+ * Set through WOLKGATEWAY_MIN_LOG_LEVEL CMake cache variable.
+ */
+#ifndef WOLKGATEWAY_MIN_LOG_LEVEL
+#define WOLKGATEWAY_MIN_LOG_LEVEL TRACE
+#endif
+
+namespace wolkabout
+{
+constexpr bool isLogLevelCompiledIn(LogLevel level)
+{
+    return static_cast<int>(level) >= static_cast<int>(LogLevel::WOLKGATEWAY_MIN_LOG_LEVEL);
+}
+}    // namespace wolkabout
+
+/**
+ * Same as LOG, but statements below WOLKGATEWAY_MIN_LOG_LEVEL are discarded at compile time,
+ * including evaluation and formatting of everything streamed into them.
+ * Used for TRACE and DEBUG statements.
+ */
+#define GATEWAY_LOG(level)                                                                                             \
+    if (!wolkabout::isLogLevelCompiledIn(wolkabout::LogLevel::level))                                                  \
+    {                                                                                                                  \
+    }                                                                                                                  \
+    else                                                                                                               \
+        LOG(level)
+
+#endif    // GATEWAYLOG_H
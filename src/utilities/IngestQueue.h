@@ -0,0 +1,99 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INGESTQUEUE_H
+#define INGESTQUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Lock-free queue which any number of threads push to, and which is emptied all at once
+ *
+ * Push links a node to the head with a single compare and swap, drain detaches the whole list with an exchange.
+ * Nodes are never removed one by one, so the list head can not be recycled under a pushing thread.
+ */
+template <class T> class IngestQueue
+{
+public:
+    IngestQueue() : m_head{nullptr} {}
+
+    IngestQueue(const IngestQueue&) = delete;
+    IngestQueue& operator=(const IngestQueue&) = delete;
+
+    ~IngestQueue() { release(m_head.exchange(nullptr)); }
+
+    void push(T value)
+    {
+        Node* node = new Node(std::move(value));
+        node->next = m_head.load(std::memory_order_relaxed);
+        while (!m_head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    /**
+     * @brief Takes all values pushed so far
+     * @return Values in the order they were pushed in
+     */
+    std::vector<T> drain()
+    {
+        std::vector<T> values;
+
+        Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+        while (node)
+        {
+            values.push_back(std::move(node->value));
+
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+
+        std::reverse(values.begin(), values.end());
+        return values;
+    }
+
+    bool empty() const { return m_head.load(std::memory_order_acquire) == nullptr; }
+
+private:
+    struct Node
+    {
+        explicit Node(T nodeValue) : value{std::move(nodeValue)}, next{nullptr} {}
+
+        T value;
+        Node* next;
+    };
+
+    static void release(Node* node)
+    {
+        while (node)
+        {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+    std::atomic<Node*> m_head;
+};
+}    // namespace wolkabout
+
+#endif
@@ -0,0 +1,396 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/JsonReader.h"
+
+#include <cstring>
+
+namespace wolkabout
+{
+JsonReader::JsonReader(const std::string& text) : m_text{text}, m_position{0}, m_failed{false} {}
+
+bool JsonReader::beginObject()
+{
+    if (!next('{'))
+    {
+        return fail();
+    }
+
+    m_first.push_back(true);
+    return true;
+}
+
+bool JsonReader::nextMember(std::string& name)
+{
+    if (!separator('}'))
+    {
+        return false;
+    }
+
+    if (!readString(name) || !next(':'))
+    {
+        return fail();
+    }
+
+    return true;
+}
+
+bool JsonReader::beginArray()
+{
+    if (!next('['))
+    {
+        return fail();
+    }
+
+    m_first.push_back(true);
+    return true;
+}
+
+bool JsonReader::nextElement()
+{
+    return separator(']');
+}
+
+bool JsonReader::readString(std::string& value)
+{
+    if (!next('"'))
+    {
+        return fail();
+    }
+
+    value.clear();
+    while (m_position < m_text.size())
+    {
+        const char c = m_text[m_position++];
+        if (c == '"')
+        {
+            return true;
+        }
+
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+            return fail();
+        }
+
+        if (c != '\\')
+        {
+            value.push_back(c);
+            continue;
+        }
+
+        if (m_position == m_text.size())
+        {
+            return fail();
+        }
+
+        const char escaped = m_text[m_position++];
+        switch (escaped)
+        {
+        case '"':
+        case '\\':
+        case '/':
+            value.push_back(escaped);
+            break;
+        case 'b':
+            value.push_back('\b');
+            break;
+        case 'f':
+            value.push_back('\f');
+            break;
+        case 'n':
+            value.push_back('\n');
+            break;
+        case 'r':
+            value.push_back('\r');
+            break;
+        case 't':
+            value.push_back('\t');
+            break;
+        case 'u':
+        {
+            unsigned codePoint;
+            if (!readHexQuad(codePoint))
+            {
+                return fail();
+            }
+
+            if (codePoint >= 0xD800 && codePoint <= 0xDBFF)
+            {
+                if (m_text.compare(m_position, 2, "\\u") != 0)
+                {
+                    return fail();
+                }
+
+                m_position += 2;
+                unsigned low;
+                if (!readHexQuad(low) || low < 0xDC00 || low > 0xDFFF)
+                {
+                    return fail();
+                }
+
+                codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            }
+
+            if (codePoint < 0x80)
+            {
+                value.push_back(static_cast<char>(codePoint));
+            }
+            else if (codePoint < 0x800)
+            {
+                value.push_back(static_cast<char>(0xC0 | (codePoint >> 6)));
+                value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else if (codePoint < 0x10000)
+            {
+                value.push_back(static_cast<char>(0xE0 | (codePoint >> 12)));
+                value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            else
+            {
+                value.push_back(static_cast<char>(0xF0 | (codePoint >> 18)));
+                value.push_back(static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F)));
+                value.push_back(static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F)));
+                value.push_back(static_cast<char>(0x80 | (codePoint & 0x3F)));
+            }
+            break;
+        }
+        default:
+            return fail();
+        }
+    }
+
+    return fail();
+}
+
+bool JsonReader::readBool(bool& value)
+{
+    char c;
+    if (!peek(c))
+    {
+        return fail();
+    }
+
+    value = c == 't';
+    return skipLiteral(value ? "true" : "false");
+}
+
+bool JsonReader::skipValue()
+{
+    char c;
+    if (!peek(c))
+    {
+        return fail();
+    }
+
+    switch (c)
+    {
+    case '"':
+    {
+        std::string ignored;
+        return readString(ignored);
+    }
+    case '{':
+    {
+        std::string name;
+        if (!beginObject())
+        {
+            return false;
+        }
+
+        while (nextMember(name))
+        {
+            if (!skipValue())
+            {
+                return false;
+            }
+        }
+
+        return !m_failed;
+    }
+    case '[':
+    {
+        if (!beginArray())
+        {
+            return false;
+        }
+
+        while (nextElement())
+        {
+            if (!skipValue())
+            {
+                return false;
+            }
+        }
+
+        return !m_failed;
+    }
+    case 't':
+        return skipLiteral("true");
+    case 'f':
+        return skipLiteral("false");
+    case 'n':
+        return skipLiteral("null");
+    default:
+        return skipNumber();
+    }
+}
+
+bool JsonReader::finish()
+{
+    skipWhitespace();
+    return !m_failed && m_first.empty() && m_position == m_text.size();
+}
+
+bool JsonReader::failed() const
+{
+    return m_failed;
+}
+
+std::size_t JsonReader::getPosition() const
+{
+    return m_position;
+}
+
+bool JsonReader::fail()
+{
+    m_failed = true;
+    return false;
+}
+
+bool JsonReader::next(char expected)
+{
+    char c;
+    if (!peek(c) || c != expected)
+    {
+        return false;
+    }
+
+    ++m_position;
+    return true;
+}
+
+bool JsonReader::peek(char& c)
+{
+    if (m_failed)
+    {
+        return false;
+    }
+
+    skipWhitespace();
+    if (m_position == m_text.size())
+    {
+        return false;
+    }
+
+    c = m_text[m_position];
+    return true;
+}
+
+void JsonReader::skipWhitespace()
+{
+    while (m_position < m_text.size() && (m_text[m_position] == ' ' || m_text[m_position] == '\t' ||
+                                          m_text[m_position] == '\n' || m_text[m_position] == '\r'))
+    {
+        ++m_position;
+    }
+}
+
+bool JsonReader::separator(char closing)
+{
+    if (m_failed || m_first.empty())
+    {
+        return fail();
+    }
+
+    if (next(closing))
+    {
+        m_first.pop_back();
+        return false;
+    }
+
+    if (m_first.back())
+    {
+        m_first.back() = false;
+        return true;
+    }
+
+    if (!next(','))
+    {
+        return fail();
+    }
+
+    return true;
+}
+
+bool JsonReader::readHexQuad(unsigned& codePoint)
+{
+    if (m_position + 4 > m_text.size())
+    {
+        return false;
+    }
+
+    codePoint = 0;
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        const char c = m_text[m_position++];
+        codePoint <<= 4;
+        if (c >= '0' && c <= '9')
+        {
+            codePoint |= static_cast<unsigned>(c - '0');
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            codePoint |= static_cast<unsigned>(c - 'a' + 10);
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+            codePoint |= static_cast<unsigned>(c - 'A' + 10);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool JsonReader::skipLiteral(const char* literal)
+{
+    const std::size_t length = std::strlen(literal);
+    if (m_text.compare(m_position, length, literal) != 0)
+    {
+        return fail();
+    }
+
+    m_position += length;
+    return true;
+}
+
+bool JsonReader::skipNumber()
+{
+    const std::size_t start = m_position;
+    // validated loosely, members that are read as numbers are not needed by current decoders
+    while (m_position < m_text.size() && m_text[m_position] != '\0' &&
+           std::strchr("+-0123456789.eE", m_text[m_position]) != nullptr)
+    {
+        ++m_position;
+    }
+
+    return m_position != start || fail();
+}
+}    // namespace wolkabout
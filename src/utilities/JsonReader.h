@@ -0,0 +1,93 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Pull parser that reads JSON text in place, without building a document tree
+ *
+ * Callers walk the document in order and pick the members they need, skipping the rest.
+ * Any syntax error puts the reader in a failed state in which every call returns false.
+ * Text is referenced, not copied, and must outlive the reader.
+ */
+class JsonReader
+{
+public:
+    explicit JsonReader(const std::string& text);
+
+    bool beginObject();
+
+    /**
+     * @brief Moves to next member of current object
+     * @param name Receives member name, string capacity is reused
+     * @return false when object is closed or on error
+     */
+    bool nextMember(std::string& name);
+
+    bool beginArray();
+
+    /**
+     * @brief Moves to next element of current array
+     * @return false when array is closed or on error
+     */
+    bool nextElement();
+
+    bool readString(std::string& value);
+    bool readBool(bool& value);
+
+    bool skipValue();
+
+    /**
+     * @brief Checks that the whole text was consumed
+     */
+    bool finish();
+
+    bool failed() const;
+
+    /**
+     * @brief Returns offset in text just past the last consumed character
+     */
+    std::size_t getPosition() const;
+
+private:
+    bool fail();
+
+    bool next(char expected);
+    bool peek(char& c);
+    void skipWhitespace();
+
+    bool separator(char closing);
+    bool readHexQuad(unsigned& codePoint);
+    bool skipLiteral(const char* literal);
+    bool skipNumber();
+
+    const std::string& m_text;
+    std::size_t m_position;
+    bool m_failed;
+
+    // one entry per open object or array, true until first element is read
+    std::vector<bool> m_first;
+};
+}    // namespace wolkabout
+
+#endif    // JSONREADER_H
@@ -0,0 +1,230 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/JsonWriter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace wolkabout
+{
+void JsonWriter::clear()
+{
+    m_buffer.clear();
+    m_scopes.clear();
+    m_afterKey = false;
+}
+
+JsonWriter& JsonWriter::beginObject()
+{
+    separate();
+    m_buffer.push_back('{');
+    m_scopes.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+    m_buffer.push_back('}');
+    m_scopes.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::beginArray()
+{
+    separate();
+    m_buffer.push_back('[');
+    m_scopes.push_back(false);
+    return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+    m_buffer.push_back(']');
+    m_scopes.pop_back();
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const std::string& name)
+{
+    separate();
+    writeEscaped(name);
+    m_buffer.push_back(':');
+    m_afterKey = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const std::string& text)
+{
+    separate();
+    writeEscaped(text);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool flag)
+{
+    separate();
+    m_buffer.append(flag ? "true" : "false");
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::uint64_t number)
+{
+    separate();
+    writeDigits(number);
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(std::int64_t number)
+{
+    separate();
+    if (number < 0)
+    {
+        m_buffer.push_back('-');
+
+        // negated in unsigned arithmetic, so the smallest int64 does not overflow
+        writeDigits(0 - static_cast<std::uint64_t>(number));
+    }
+    else
+    {
+        writeDigits(static_cast<std::uint64_t>(number));
+    }
+
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double number)
+{
+    if (!std::isfinite(number))
+    {
+        return null();
+    }
+
+    separate();
+    appendNumber(m_buffer, number);
+    return *this;
+}
+
+void JsonWriter::appendNumber(std::string& buffer, double number)
+{
+    // shortest of the two precisions that reads back as the same number
+    char digits[32];
+    int length = std::snprintf(digits, sizeof(digits), "%.15g", number);
+    const double parsed = std::strtod(digits, nullptr);
+    if (parsed < number || parsed > number)
+    {
+        length = std::snprintf(digits, sizeof(digits), "%.17g", number);
+    }
+
+    buffer.append(digits, static_cast<std::size_t>(length));
+}
+
+JsonWriter& JsonWriter::null()
+{
+    separate();
+    m_buffer.append("null");
+    return *this;
+}
+
+const std::string& JsonWriter::str() const
+{
+    return m_buffer;
+}
+
+void JsonWriter::separate()
+{
+    if (m_afterKey)
+    {
+        m_afterKey = false;
+        return;
+    }
+
+    if (m_scopes.empty())
+    {
+        return;
+    }
+
+    if (m_scopes.back())
+    {
+        m_buffer.push_back(',');
+    }
+
+    m_scopes.back() = true;
+}
+
+void JsonWriter::writeDigits(std::uint64_t number)
+{
+    char digits[20];
+    std::size_t count = 0;
+    do
+    {
+        digits[count++] = static_cast<char>('0' + number % 10);
+        number /= 10;
+    } while (number != 0);
+
+    while (count > 0)
+    {
+        m_buffer.push_back(digits[--count]);
+    }
+}
+
+void JsonWriter::writeEscaped(const std::string& text)
+{
+    static const char* const HEX_DIGITS = "0123456789abcdef";
+
+    m_buffer.push_back('"');
+    for (const char c : text)
+    {
+        switch (c)
+        {
+        case '"':
+            m_buffer.append("\\\"");
+            break;
+        case '\\':
+            m_buffer.append("\\\\");
+            break;
+        case '\b':
+            m_buffer.append("\\b");
+            break;
+        case '\f':
+            m_buffer.append("\\f");
+            break;
+        case '\n':
+            m_buffer.append("\\n");
+            break;
+        case '\r':
+            m_buffer.append("\\r");
+            break;
+        case '\t':
+            m_buffer.append("\\t");
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                m_buffer.append("\\u00");
+                m_buffer.push_back(HEX_DIGITS[static_cast<unsigned char>(c) >> 4]);
+                m_buffer.push_back(HEX_DIGITS[static_cast<unsigned char>(c) & 0x0F]);
+            }
+            else
+            {
+                m_buffer.push_back(c);
+            }
+        }
+    }
+    m_buffer.push_back('"');
+}
+}    // namespace wolkabout
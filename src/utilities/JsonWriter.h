@@ -0,0 +1,77 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Writes JSON text directly into a buffer, without building a document tree
+ *
+ * Buffer capacity is kept between clear() calls, so a writer reused for messages of similar size
+ * stops allocating after the first few messages. Structure is not validated beyond comma placement.
+ */
+class JsonWriter
+{
+public:
+    JsonWriter() = default;
+
+    void clear();
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+
+    JsonWriter& beginArray();
+    JsonWriter& endArray();
+
+    JsonWriter& key(const std::string& name);
+
+    JsonWriter& value(const std::string& text);
+    JsonWriter& value(bool flag);
+    JsonWriter& value(std::uint64_t number);
+    JsonWriter& value(std::int64_t number);
+
+    // non-finite numbers have no JSON representation and are written as null
+    JsonWriter& value(double number);
+
+    JsonWriter& null();
+
+    const std::string& str() const;
+
+    /**
+     * @brief Appends shortest text of finite number that reads back as the same number
+     */
+    static void appendNumber(std::string& buffer, double number);
+
+private:
+    void separate();
+    void writeDigits(std::uint64_t number);
+    void writeEscaped(const std::string& text);
+
+    std::string m_buffer;
+
+    // one entry per open object or array, true once it has an element
+    std::vector<bool> m_scopes;
+    bool m_afterKey = false;
+};
+}    // namespace wolkabout
+
+#endif    // JSONWRITER_H
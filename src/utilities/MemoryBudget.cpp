@@ -0,0 +1,102 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/MemoryBudget.h"
+
+namespace wolkabout
+{
+MemoryAccount::MemoryAccount(MemoryBudget& budget, Gauge& bytes) : m_budget{budget}, m_bytes{bytes} {}
+
+void MemoryAccount::add(std::uint64_t bytes)
+{
+    m_bytes.increment(static_cast<std::int64_t>(bytes));
+    m_budget.add(bytes);
+}
+
+void MemoryAccount::release(std::uint64_t bytes)
+{
+    m_bytes.decrement(static_cast<std::int64_t>(bytes));
+    m_budget.release(bytes);
+}
+
+std::uint64_t MemoryAccount::bytes() const
+{
+    const auto value = m_bytes.value();
+    return value > 0 ? static_cast<std::uint64_t>(value) : 0;
+}
+
+MemoryBudget& MemoryBudget::getInstance()
+{
+    static MemoryBudget instance;
+    return instance;
+}
+
+MemoryBudget::MemoryBudget()
+: m_limit{0}
+, m_used{0}
+, m_usedGauge{MetricsRegistry::getInstance().gauge("wolkgateway_memory_used_bytes")}
+, m_limitGauge{MetricsRegistry::getInstance().gauge("wolkgateway_memory_budget_bytes")}
+{
+}
+
+MemoryAccount& MemoryBudget::account(const std::string& component)
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+
+    auto& account = m_accounts[component];
+    if (!account)
+    {
+        account.reset(new MemoryAccount(
+          *this, MetricsRegistry::getInstance().gauge("wolkgateway_memory_bytes{component=\"" + component + "\"}")));
+    }
+
+    return *account;
+}
+
+void MemoryBudget::setLimit(std::uint64_t bytes)
+{
+    m_limit.store(bytes, std::memory_order_relaxed);
+    m_limitGauge.set(static_cast<std::int64_t>(bytes));
+}
+
+std::uint64_t MemoryBudget::getLimit() const
+{
+    return m_limit.load(std::memory_order_relaxed);
+}
+
+std::uint64_t MemoryBudget::used() const
+{
+    return m_used.load(std::memory_order_relaxed);
+}
+
+bool MemoryBudget::allows(std::uint64_t bytes) const
+{
+    const auto limit = m_limit.load(std::memory_order_relaxed);
+    return limit == 0 || m_used.load(std::memory_order_relaxed) + bytes <= limit;
+}
+
+void MemoryBudget::add(std::uint64_t bytes)
+{
+    m_used.fetch_add(bytes, std::memory_order_relaxed);
+    m_usedGauge.increment(static_cast<std::int64_t>(bytes));
+}
+
+void MemoryBudget::release(std::uint64_t bytes)
+{
+    m_used.fetch_sub(bytes, std::memory_order_relaxed);
+    m_usedGauge.decrement(static_cast<std::int64_t>(bytes));
+}
+}    // namespace wolkabout
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include "utilities/Metrics.h"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace wolkabout
+{
+class MemoryBudget;
+
+/**
+ * @brief Bytes held by one kind of buffer, shared by all buffers reporting under the same component name
+ */
+class MemoryAccount
+{
+public:
+    MemoryAccount(MemoryBudget& budget, Gauge& bytes);
+
+    MemoryAccount(const MemoryAccount&) = delete;
+    MemoryAccount& operator=(const MemoryAccount&) = delete;
+
+    void add(std::uint64_t bytes);
+    void release(std::uint64_t bytes);
+
+    std::uint64_t bytes() const;
+
+private:
+    MemoryBudget& m_budget;
+    Gauge& m_bytes;
+};
+
+/**
+ * @brief Process wide accounting of memory held by gateway buffers, with optional global budget
+ *
+ * Buffers report bytes they hold under a component name, exported as gauge
+ * wolkgateway_memory_bytes{component="..."}. Buffers which can shed data ask whether growing stays
+ * within budget, and once it does not they apply their overflow policy as if their own limit was reached,
+ * so memory stops growing before the process is killed for running out of it.
+ * Accounting covers payloads held by buffers, not allocator and container overhead, so budget should be
+ * set with headroom below memory available to the process.
+ */
+class MemoryBudget
+{
+public:
+    static MemoryBudget& getInstance();
+
+    /**
+     * @brief Returns account of component, creating it on first lookup. Account lives as long as the process
+     */
+    MemoryAccount& account(const std::string& component);
+
+    /**
+     * @param bytes Maximum number of bytes held by all accounts, 0 for no limit
+     */
+    void setLimit(std::uint64_t bytes);
+    std::uint64_t getLimit() const;
+
+    std::uint64_t used() const;
+
+    /**
+     * @brief Checks whether bytes can be added without exceeding budget
+     */
+    bool allows(std::uint64_t bytes) const;
+
+private:
+    friend class MemoryAccount;
+
+    MemoryBudget();
+
+    void add(std::uint64_t bytes);
+    void release(std::uint64_t bytes);
+
+    std::atomic<std::uint64_t> m_limit;
+    std::atomic<std::uint64_t> m_used;
+
+    Gauge& m_usedGauge;
+    Gauge& m_limitGauge;
+
+    std::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<MemoryAccount>> m_accounts;
+};
+}    // namespace wolkabout
+
+#endif    // MEMORYBUDGET_H
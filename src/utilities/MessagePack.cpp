@@ -0,0 +1,278 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/MessagePack.h"
+#include "utilities/JsonWriter.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+// bounds recursion on hostile input, device payloads are a few levels deep
+const unsigned MAXIMUM_NESTING_DEPTH = 32;
+}    // namespace
+
+namespace wolkabout
+{
+class MessagePack::Decoder
+{
+public:
+    Decoder(const std::string& payload, JsonWriter& writer) : m_payload{payload}, m_position{0}, m_writer{writer} {}
+
+    bool decode() { return value(0) && m_position == m_payload.size(); }
+
+private:
+    bool value(unsigned depth)
+    {
+        if (depth > MAXIMUM_NESTING_DEPTH)
+        {
+            return false;
+        }
+
+        std::uint64_t marker;
+        if (!read(1, marker))
+        {
+            return false;
+        }
+
+        if (marker <= 0x7F)
+        {
+            m_writer.value(marker);
+            return true;
+        }
+
+        if (marker >= 0xE0)
+        {
+            m_writer.value(static_cast<std::int64_t>(static_cast<std::int8_t>(marker)));
+            return true;
+        }
+
+        if ((marker & 0xF0) == 0x80)
+        {
+            return map(marker & 0x0F, depth);
+        }
+
+        if ((marker & 0xF0) == 0x90)
+        {
+            return array(marker & 0x0F, depth);
+        }
+
+        if ((marker & 0xE0) == 0xA0)
+        {
+            return string(marker & 0x1F);
+        }
+
+        std::uint64_t number;
+        switch (marker)
+        {
+        case 0xC0:
+            m_writer.null();
+            return true;
+        case 0xC2:
+            m_writer.value(false);
+            return true;
+        case 0xC3:
+            m_writer.value(true);
+            return true;
+        case 0xCA:
+        {
+            if (!read(4, number))
+            {
+                return false;
+            }
+
+            const auto bits = static_cast<std::uint32_t>(number);
+            float single;
+            std::memcpy(&single, &bits, sizeof(single));
+            m_writer.value(static_cast<double>(single));
+            return true;
+        }
+        case 0xCB:
+        {
+            if (!read(8, number))
+            {
+                return false;
+            }
+
+            double precise;
+            std::memcpy(&precise, &number, sizeof(precise));
+            m_writer.value(precise);
+            return true;
+        }
+        case 0xCC:
+        case 0xCD:
+        case 0xCE:
+        case 0xCF:
+        {
+            if (!read(std::size_t{1} << (marker - 0xCC), number))
+            {
+                return false;
+            }
+
+            m_writer.value(number);
+            return true;
+        }
+        case 0xD0:
+        case 0xD1:
+        case 0xD2:
+        case 0xD3:
+        {
+            const std::size_t size = std::size_t{1} << (marker - 0xD0);
+            if (!read(size, number))
+            {
+                return false;
+            }
+
+            // sign extend from the encoded width
+            const unsigned shift = static_cast<unsigned>(64 - size * 8);
+            m_writer.value(static_cast<std::int64_t>(number << shift) >> shift);
+            return true;
+        }
+        case 0xD9:
+        case 0xDA:
+        case 0xDB:
+            return read(std::size_t{1} << (marker - 0xD9), number) && string(number);
+        case 0xDC:
+        case 0xDD:
+            return read(std::size_t{2} << (marker - 0xDC), number) && array(number, depth);
+        case 0xDE:
+        case 0xDF:
+            return read(std::size_t{2} << (marker - 0xDE), number) && map(number, depth);
+        default:
+            // 0xC1 is never used, remaining markers are binary and extension types
+            return false;
+        }
+    }
+
+    bool string(std::uint64_t length)
+    {
+        if (!text(length))
+        {
+            return false;
+        }
+
+        m_writer.value(m_text);
+        return true;
+    }
+
+    bool array(std::uint64_t count, unsigned depth)
+    {
+        m_writer.beginArray();
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            if (!value(depth + 1))
+            {
+                return false;
+            }
+        }
+
+        m_writer.endArray();
+        return true;
+    }
+
+    bool map(std::uint64_t count, unsigned depth)
+    {
+        m_writer.beginObject();
+        for (std::uint64_t i = 0; i < count; ++i)
+        {
+            if (!key() || !value(depth + 1))
+            {
+                return false;
+            }
+        }
+
+        m_writer.endObject();
+        return true;
+    }
+
+    bool key()
+    {
+        std::uint64_t marker;
+        if (!read(1, marker))
+        {
+            return false;
+        }
+
+        std::uint64_t length;
+        if ((marker & 0xE0) == 0xA0)
+        {
+            length = marker & 0x1F;
+        }
+        else if (marker < 0xD9 || marker > 0xDB || !read(std::size_t{1} << (marker - 0xD9), length))
+        {
+            return false;
+        }
+
+        if (!text(length))
+        {
+            return false;
+        }
+
+        m_writer.key(m_text);
+        return true;
+    }
+
+    bool text(std::uint64_t length)
+    {
+        if (length > m_payload.size() - m_position)
+        {
+            return false;
+        }
+
+        m_text.assign(m_payload, m_position, static_cast<std::size_t>(length));
+        m_position += static_cast<std::size_t>(length);
+        return true;
+    }
+
+    // reads big endian unsigned integer of given size
+    bool read(std::size_t size, std::uint64_t& number)
+    {
+        if (size > m_payload.size() - m_position)
+        {
+            return false;
+        }
+
+        number = 0;
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            number = (number << 8) | static_cast<std::uint8_t>(m_payload[m_position++]);
+        }
+
+        return true;
+    }
+
+    const std::string& m_payload;
+    std::size_t m_position;
+    JsonWriter& m_writer;
+
+    // scratch buffer for strings and keys, reused across the document
+    std::string m_text;
+};
+
+bool MessagePack::toJson(const std::string& payload, std::string& json)
+{
+    JsonWriter writer;
+    if (!Decoder(payload, writer).decode())
+    {
+        return false;
+    }
+
+    json = writer.str();
+    return true;
+}
+}    // namespace wolkabout
@@ -0,0 +1,47 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESSAGEPACK_H
+#define MESSAGEPACK_H
+
+#include <string>
+
+namespace wolkabout
+{
+class JsonWriter;
+
+/**
+ * @brief Transcodes MessagePack payloads of constrained devices to the JSON payloads forwarded to platform
+ *
+ * Maps must have string keys. Binary and extension types have no JSON counterpart and are rejected.
+ */
+class MessagePack
+{
+public:
+    /**
+     * @brief Converts MessagePack document to JSON text
+     * @param payload Single MessagePack value
+     * @param json Receives JSON text
+     * @return false if payload is malformed, has trailing bytes or contains unsupported types
+     */
+    static bool toJson(const std::string& payload, std::string& json);
+
+private:
+    class Decoder;
+};
+}    // namespace wolkabout
+
+#endif    // MESSAGEPACK_H
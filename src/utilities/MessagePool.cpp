@@ -0,0 +1,174 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/MessagePool.h"
+#include "utilities/Metrics.h"
+
+#include <array>
+#include <mutex>
+#include <new>
+
+namespace
+{
+const std::size_t BLOCK_ALIGNMENT = alignof(std::max_align_t);
+const std::size_t SIZE_CLASSES = wolkabout::MessagePool::MAX_BLOCK_SIZE / BLOCK_ALIGNMENT;
+
+// blocks of one size class kept by a thread before surplus is handed over to shared list
+const std::size_t THREAD_CACHE_SIZE = 512;
+const std::size_t TRANSFER_BATCH_SIZE = 128;
+
+struct FreeBlock
+{
+    FreeBlock* next;
+};
+
+struct FreeList
+{
+    FreeList() : head{nullptr}, size{0} {}
+
+    void push(FreeBlock* block)
+    {
+        block->next = head;
+        head = block;
+        ++size;
+    }
+
+    FreeBlock* pop()
+    {
+        FreeBlock* block = head;
+        head = block->next;
+        --size;
+        return block;
+    }
+
+    void transfer(FreeList& destination, std::size_t count)
+    {
+        while (count-- != 0 && head)
+        {
+            destination.push(pop());
+        }
+    }
+
+    FreeBlock* head;
+    std::size_t size;
+};
+
+struct SharedLists
+{
+    std::mutex lock;
+    std::array<FreeList, SIZE_CLASSES> lists;
+};
+
+SharedLists& sharedLists()
+{
+    // intentionally leaked, thread caches of threads outliving static destruction still return blocks to it
+    static SharedLists* lists = new SharedLists();
+    return *lists;
+}
+
+// set once thread cache is destroyed, messages freed later during thread exit go straight to shared lists
+thread_local bool threadCacheDestroyed = false;
+
+struct ThreadCache
+{
+    ~ThreadCache()
+    {
+        threadCacheDestroyed = true;
+
+        SharedLists& shared = sharedLists();
+        std::lock_guard<std::mutex> lg{shared.lock};
+        for (std::size_t i = 0; i < SIZE_CLASSES; ++i)
+        {
+            lists[i].transfer(shared.lists[i], lists[i].size);
+        }
+    }
+
+    std::array<FreeList, SIZE_CLASSES> lists;
+};
+
+thread_local ThreadCache threadCache;
+
+std::size_t sizeClass(std::size_t size)
+{
+    return (size + BLOCK_ALIGNMENT - 1) / BLOCK_ALIGNMENT - 1;
+}
+
+wolkabout::Counter& heapAllocations()
+{
+    static wolkabout::Counter& counter =
+      wolkabout::MetricsRegistry::getInstance().counter("wolkgateway_message_pool_heap_allocations_total");
+    return counter;
+}
+}    // namespace
+
+namespace wolkabout
+{
+constexpr std::size_t MessagePool::MAX_BLOCK_SIZE;
+
+std::uint64_t MessagePool::getHeapAllocationCount()
+{
+    return heapAllocations().value();
+}
+
+void* MessagePool::allocateBlock(std::size_t size)
+{
+    const std::size_t index = sizeClass(size);
+    if (threadCacheDestroyed)
+    {
+        heapAllocations().increment();
+        return ::operator new((index + 1) * BLOCK_ALIGNMENT);
+    }
+
+    FreeList& list = threadCache.lists[index];
+
+    if (!list.head)
+    {
+        SharedLists& shared = sharedLists();
+        std::lock_guard<std::mutex> lg{shared.lock};
+        shared.lists[index].transfer(list, TRANSFER_BATCH_SIZE);
+    }
+
+    if (!list.head)
+    {
+        heapAllocations().increment();
+        return ::operator new((index + 1) * BLOCK_ALIGNMENT);
+    }
+
+    return list.pop();
+}
+
+void MessagePool::deallocateBlock(void* block, std::size_t size)
+{
+    const std::size_t index = sizeClass(size);
+    if (threadCacheDestroyed)
+    {
+        SharedLists& shared = sharedLists();
+        std::lock_guard<std::mutex> lg{shared.lock};
+        shared.lists[index].push(static_cast<FreeBlock*>(block));
+        return;
+    }
+
+    FreeList& list = threadCache.lists[index];
+    list.push(static_cast<FreeBlock*>(block));
+
+    if (list.size > THREAD_CACHE_SIZE)
+    {
+        SharedLists& shared = sharedLists();
+        std::lock_guard<std::mutex> lg{shared.lock};
+        list.transfer(shared.lists[index], TRANSFER_BATCH_SIZE);
+    }
+}
+}    // namespace wolkabout
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef MESSAGEPOOL_H
+#define MESSAGEPOOL_H
+
+#include "model/Message.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace wolkabout
+{
+/**
+ * @brief Creates wolkabout::Message instances in pooled memory
+ *
+ * Message and its shared pointer control block are placed in a single block taken from per thread free lists.
+ * Freed blocks go back to the list of the freeing thread, and surplus is handed over to a shared list,
+ * so blocks allocated by inbound threads and freed by publisher threads keep circulating instead of
+ * going back to malloc. Blocks are never returned to the heap, pool size follows the peak number of messages.
+ */
+class MessagePool
+{
+public:
+    template <class T> class Allocator
+    {
+    public:
+        using value_type = T;
+
+        Allocator() = default;
+        template <class U> Allocator(const Allocator<U>&) {}
+
+        T* allocate(std::size_t count)
+        {
+            if (count != 1 || sizeof(T) > MAX_BLOCK_SIZE || alignof(T) > alignof(std::max_align_t))
+            {
+                return std::allocator<T>{}.allocate(count);
+            }
+
+            return static_cast<T*>(allocateBlock(sizeof(T)));
+        }
+
+        void deallocate(T* pointer, std::size_t count)
+        {
+            if (count != 1 || sizeof(T) > MAX_BLOCK_SIZE || alignof(T) > alignof(std::max_align_t))
+            {
+                std::allocator<T>{}.deallocate(pointer, count);
+                return;
+            }
+
+            deallocateBlock(pointer, sizeof(T));
+        }
+
+        template <class U> bool operator==(const Allocator<U>&) const { return true; }
+        template <class U> bool operator!=(const Allocator<U>&) const { return false; }
+    };
+
+    template <class... Args> static std::shared_ptr<Message> make(Args&&... args)
+    {
+        return std::allocate_shared<Message>(Allocator<Message>{}, std::forward<Args>(args)...);
+    }
+
+    /**
+     * @brief Returns number of blocks pool took from the heap, stops growing once pool covers peak load
+     */
+    static std::uint64_t getHeapAllocationCount();
+
+    static constexpr std::size_t MAX_BLOCK_SIZE = 256;
+
+private:
+    static void* allocateBlock(std::size_t size);
+    static void deallocateBlock(void* block, std::size_t size);
+};
+}    // namespace wolkabout
+
+#endif    // MESSAGEPOOL_H
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/Metrics.h"
+
+#include <algorithm>
+#include <set>
+#include <sstream>
+
+namespace wolkabout
+{
+const std::size_t Histogram::BUCKET_COUNT;
+
+const std::array<std::uint64_t, Histogram::BUCKET_COUNT> Histogram::BUCKET_BOUNDS = {
+  {10, 50, 100, 500, 1000, 5000, 10000, 50000, 100000, 500000, 1000000, 5000000}};
+
+Histogram::Histogram() : m_count{0}, m_sumMicroseconds{0}
+{
+    for (auto& bucket : m_buckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::record(std::chrono::nanoseconds duration)
+{
+    const auto microseconds =
+      static_cast<std::uint64_t>(std::max<std::chrono::microseconds::rep>(
+        std::chrono::duration_cast<std::chrono::microseconds>(duration).count(), 0));
+
+    const auto bucket = std::lower_bound(BUCKET_BOUNDS.begin(), BUCKET_BOUNDS.end(), microseconds);
+    m_buckets[static_cast<std::size_t>(bucket - BUCKET_BOUNDS.begin())].fetch_add(1, std::memory_order_relaxed);
+
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sumMicroseconds.fetch_add(microseconds, std::memory_order_relaxed);
+}
+
+std::array<std::uint64_t, Histogram::BUCKET_COUNT + 1> Histogram::buckets() const
+{
+    std::array<std::uint64_t, BUCKET_COUNT + 1> result;
+    for (std::size_t i = 0; i < m_buckets.size(); ++i)
+    {
+        result[i] = m_buckets[i].load(std::memory_order_relaxed);
+    }
+
+    return result;
+}
+
+std::uint64_t Histogram::count() const
+{
+    return m_count.load(std::memory_order_relaxed);
+}
+
+std::uint64_t Histogram::sumMicroseconds() const
+{
+    return m_sumMicroseconds.load(std::memory_order_relaxed);
+}
+
+MetricsRegistry& MetricsRegistry::getInstance()
+{
+    static MetricsRegistry instance;
+    return instance;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name)
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+
+    auto& metric = m_counters[name];
+    if (!metric)
+    {
+        metric.reset(new Counter());
+    }
+
+    return *metric;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name)
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+
+    auto& metric = m_gauges[name];
+    if (!metric)
+    {
+        metric.reset(new Gauge());
+    }
+
+    return *metric;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name)
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+
+    auto& metric = m_histograms[name];
+    if (!metric)
+    {
+        metric.reset(new Histogram());
+    }
+
+    return *metric;
+}
+
+std::string MetricsRegistry::format() const
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+
+    std::ostringstream stream;
+
+    // names may carry labels, as in name{device="key"}, type is declared once per metric family
+    std::set<std::string> families;
+    const auto declare = [&](const std::string& name, const char* type) {
+        const auto family = name.substr(0, name.find('{'));
+        if (families.insert(family).second)
+        {
+            stream << "# TYPE " << family << " " << type << "\n";
+        }
+    };
+
+    for (const auto& kvp : m_counters)
+    {
+        declare(kvp.first, "counter");
+        stream << kvp.first << " " << kvp.second->value() << "\n";
+    }
+
+    for (const auto& kvp : m_gauges)
+    {
+        declare(kvp.first, "gauge");
+        stream << kvp.first << " " << kvp.second->value() << "\n";
+    }
+
+    for (const auto& kvp : m_histograms)
+    {
+        const auto& name = kvp.first;
+        const auto buckets = kvp.second->buckets();
+
+        stream << "# TYPE " << name << " histogram\n";
+
+        // bucket counts are cumulative in exposition format
+        std::uint64_t cumulative = 0;
+        for (std::size_t i = 0; i < Histogram::BUCKET_COUNT; ++i)
+        {
+            cumulative += buckets[i];
+            stream << name << "_bucket{le=\"" << static_cast<double>(Histogram::BUCKET_BOUNDS[i]) / 1e6 << "\"} "
+                   << cumulative << "\n";
+        }
+
+        cumulative += buckets[Histogram::BUCKET_COUNT];
+        stream << name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+        stream << name << "_sum " << static_cast<double>(kvp.second->sumMicroseconds()) / 1e6 << "\n";
+        stream << name << "_count " << kvp.second->count() << "\n";
+    }
+
+    return stream.str();
+}
+
+void MetricsRegistry::forEachHistogram(const std::function<void(const std::string&, const Histogram&)>& visitor) const
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+
+    for (const auto& kvp : m_histograms)
+    {
+        visitor(kvp.first, *kvp.second);
+    }
+}
+}    // namespace wolkabout
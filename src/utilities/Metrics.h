@@ -0,0 +1,126 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace wolkabout
+{
+class Counter
+{
+public:
+    Counter() : m_value{0} {}
+
+    void increment(std::uint64_t count = 1) { m_value.fetch_add(count, std::memory_order_relaxed); }
+
+    std::uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::uint64_t> m_value;
+};
+
+class Gauge
+{
+public:
+    Gauge() : m_value{0} {}
+
+    void increment(std::int64_t count = 1) { m_value.fetch_add(count, std::memory_order_relaxed); }
+    void decrement(std::int64_t count = 1) { m_value.fetch_sub(count, std::memory_order_relaxed); }
+    void set(std::int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+
+    std::int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<std::int64_t> m_value;
+};
+
+/**
+ * @brief Latency distribution over fixed buckets
+ *
+ * Recording is a few relaxed atomic increments, buckets are not resized or locked.
+ */
+class Histogram
+{
+public:
+    static const std::size_t BUCKET_COUNT = 12;
+
+    // upper bounds of buckets in microseconds, last bucket has no upper bound
+    static const std::array<std::uint64_t, BUCKET_COUNT> BUCKET_BOUNDS;
+
+    Histogram();
+
+    void record(std::chrono::nanoseconds duration);
+
+    // count of samples in each bucket, last element holds samples above the largest bound
+    std::array<std::uint64_t, BUCKET_COUNT + 1> buckets() const;
+
+    std::uint64_t count() const;
+    std::uint64_t sumMicroseconds() const;
+
+private:
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT + 1> m_buckets;
+    std::atomic<std::uint64_t> m_count;
+    std::atomic<std::uint64_t> m_sumMicroseconds;
+};
+
+/**
+ * @brief Process wide set of named metrics
+ *
+ * Metrics are created on first lookup and live as long as the process, so references may be kept
+ * and updated without further lookups. Names follow Prometheus conventions.
+ */
+class MetricsRegistry
+{
+public:
+    static MetricsRegistry& getInstance();
+
+    Counter& counter(const std::string& name);
+    Gauge& gauge(const std::string& name);
+    Histogram& histogram(const std::string& name);
+
+    /**
+     * @brief Formats all metrics in Prometheus text exposition format
+     */
+    std::string format() const;
+
+    /**
+     * @brief Calls visitor with each histogram and its name, in name order
+     * Visitor runs under registry lock and must not register metrics
+     */
+    void forEachHistogram(const std::function<void(const std::string&, const Histogram&)>& visitor) const;
+
+private:
+    MetricsRegistry() = default;
+
+    mutable std::mutex m_mutex;
+    std::map<std::string, std::unique_ptr<Counter>> m_counters;
+    std::map<std::string, std::unique_ptr<Gauge>> m_gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> m_histograms;
+};
+}    // namespace wolkabout
+
+#endif    // METRICS_H
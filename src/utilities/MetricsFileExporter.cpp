@@ -0,0 +1,89 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/MetricsFileExporter.h"
+#include "utilities/Logger.h"
+#include "utilities/Metrics.h"
+
+#include <cstdio>
+#include <fstream>
+#include <utility>
+
+namespace wolkabout
+{
+MetricsFileExporter::MetricsFileExporter(MetricsRegistry& registry, std::string filePath,
+                                         std::chrono::milliseconds interval, Executor& executor)
+: m_registry{registry}
+, m_filePath{std::move(filePath)}
+, m_interval{interval}
+, m_executor{executor}
+, m_task{0}
+, m_stopped{false}
+{
+    std::lock_guard<std::mutex> lg{m_mutex};
+    m_task = m_executor.schedule(m_interval, [=] { exportAndReschedule(); });
+}
+
+MetricsFileExporter::~MetricsFileExporter()
+{
+    Executor::TaskId task;
+
+    {
+        std::lock_guard<std::mutex> lg{m_mutex};
+        m_stopped = true;
+        task = m_task;
+    }
+
+    // export that is already running is waited for, and will not schedule another one
+    m_executor.cancel(task);
+}
+
+bool MetricsFileExporter::exportNow()
+{
+    const std::string temporaryFilePath = m_filePath + ".tmp";
+
+    {
+        std::ofstream file{temporaryFilePath, std::ios::trunc};
+        file << m_registry.format();
+
+        if (!file.good())
+        {
+            LOG(ERROR) << "MetricsFileExporter: Unable to write metrics to '" << temporaryFilePath << "'";
+            return false;
+        }
+    }
+
+    if (std::rename(temporaryFilePath.c_str(), m_filePath.c_str()) != 0)
+    {
+        LOG(ERROR) << "MetricsFileExporter: Unable to replace metrics file '" << m_filePath << "'";
+        std::remove(temporaryFilePath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+void MetricsFileExporter::exportAndReschedule()
+{
+    exportNow();
+
+    std::lock_guard<std::mutex> lg{m_mutex};
+    if (!m_stopped)
+    {
+        m_task = m_executor.schedule(m_interval, [=] { exportAndReschedule(); });
+    }
+}
+}    // namespace wolkabout
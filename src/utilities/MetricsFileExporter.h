@@ -0,0 +1,62 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef METRICSFILEEXPORTER_H
+#define METRICSFILEEXPORTER_H
+
+#include "utilities/Executor.h"
+
+#include <chrono>
+#include <mutex>
+#include <string>
+
+namespace wolkabout
+{
+class MetricsRegistry;
+
+/**
+ * @brief Periodically writes metrics to a file in Prometheus text format
+ *
+ * File is replaced atomically, so it can be read at any time by local scrapers,
+ * for example node_exporter textfile collector.
+ */
+class MetricsFileExporter
+{
+public:
+    MetricsFileExporter(MetricsRegistry& registry, std::string filePath, std::chrono::milliseconds interval,
+                        Executor& executor);
+    ~MetricsFileExporter();
+
+    MetricsFileExporter(const MetricsFileExporter&) = delete;
+    MetricsFileExporter& operator=(const MetricsFileExporter&) = delete;
+
+    bool exportNow();
+
+private:
+    void exportAndReschedule();
+
+    MetricsRegistry& m_registry;
+    const std::string m_filePath;
+    const std::chrono::milliseconds m_interval;
+    Executor& m_executor;
+
+    std::mutex m_mutex;
+    Executor::TaskId m_task;
+    bool m_stopped;
+};
+}    // namespace wolkabout
+
+#endif    // METRICSFILEEXPORTER_H
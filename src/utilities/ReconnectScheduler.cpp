@@ -0,0 +1,158 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/ReconnectScheduler.h"
+#include "utilities/GatewayLog.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace wolkabout
+{
+const std::chrono::milliseconds ReconnectScheduler::DEFAULT_INITIAL_DELAY{2000};
+const std::chrono::milliseconds ReconnectScheduler::DEFAULT_MAXIMUM_DELAY{60000};
+const std::chrono::milliseconds ReconnectScheduler::DEFAULT_STABLE_PERIOD{30000};
+
+ReconnectScheduler::ReconnectScheduler(Executor& executor, std::function<bool()> connect,
+                                       std::function<void()> connected, const std::string& name,
+                                       std::chrono::milliseconds initialDelay, std::chrono::milliseconds maximumDelay,
+                                       std::chrono::milliseconds stablePeriod)
+: m_executor{executor}
+, m_connect{std::move(connect)}
+, m_connected{std::move(connected)}
+, m_initialDelay{initialDelay}
+, m_maximumDelay{std::max(initialDelay, maximumDelay)}
+, m_stablePeriod{stablePeriod}
+, m_attempts{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_reconnect_attempts_total")}
+, m_failures{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_reconnect_failures_total")}
+, m_flappingConnections{MetricsRegistry::getInstance().counter("wolkgateway_" + name + "_flapping_connections_total")}
+, m_running{false}
+, m_generation{0}
+, m_task{0}
+, m_delay{initialDelay}
+, m_wasConnected{false}
+, m_random{std::random_device{}()}
+{
+}
+
+ReconnectScheduler::~ReconnectScheduler()
+{
+    stop();
+}
+
+void ReconnectScheduler::start()
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+    if (m_running)
+    {
+        return;
+    }
+
+    m_running = true;
+    const std::uint64_t generation = ++m_generation;
+
+    if (m_wasConnected && std::chrono::steady_clock::now() - m_connectedAt < m_stablePeriod)
+    {
+        m_flappingConnections.increment();
+
+        const auto delay = nextDelay();
+        GATEWAY_LOG(DEBUG) << "ReconnectScheduler: Connection was lost shortly after connecting, reconnecting in "
+                           << delay.count() << "ms";
+        m_task = m_executor.schedule(delay, [=] { attempt(generation); });
+        return;
+    }
+
+    m_delay = m_initialDelay;
+    m_task = m_executor.post([=] { attempt(generation); });
+}
+
+void ReconnectScheduler::stop()
+{
+    Executor::TaskId task;
+
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+        m_running = false;
+        // connection closed on purpose is not flapping
+        m_wasConnected = false;
+        ++m_generation;
+        task = m_task;
+    }
+
+    m_executor.cancel(task);
+}
+
+bool ReconnectScheduler::isRunning() const
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+    return m_running;
+}
+
+void ReconnectScheduler::setBackoff(std::chrono::milliseconds initialDelay, std::chrono::milliseconds maximumDelay,
+                                    std::chrono::milliseconds stablePeriod)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+    m_initialDelay = initialDelay;
+    m_maximumDelay = std::max(initialDelay, maximumDelay);
+    m_stablePeriod = stablePeriod;
+    m_delay = std::min(std::max(m_delay, m_initialDelay), m_maximumDelay);
+}
+
+void ReconnectScheduler::attempt(std::uint64_t generation)
+{
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+        if (generation != m_generation)
+        {
+            return;
+        }
+    }
+
+    m_attempts.increment();
+    const bool isConnected = m_connect();
+
+    std::unique_lock<std::mutex> locker{m_lock};
+    if (generation != m_generation)
+    {
+        return;
+    }
+
+    if (isConnected)
+    {
+        m_running = false;
+        m_wasConnected = true;
+        m_connectedAt = std::chrono::steady_clock::now();
+        locker.unlock();
+
+        m_connected();
+        return;
+    }
+
+    m_failures.increment();
+
+    const auto delay = nextDelay();
+    GATEWAY_LOG(DEBUG) << "ReconnectScheduler: Connection attempt failed, retrying in " << delay.count() << "ms";
+    m_task = m_executor.schedule(delay, [=] { attempt(generation); });
+}
+
+std::chrono::milliseconds ReconnectScheduler::nextDelay()
+{
+    const auto delay = std::chrono::milliseconds{
+      std::uniform_int_distribution<std::chrono::milliseconds::rep>{m_delay.count() / 2, m_delay.count()}(m_random)};
+    m_delay = std::min(m_delay * 2, m_maximumDelay);
+    return delay;
+}
+}    // namespace wolkabout
@@ -0,0 +1,117 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RECONNECTSCHEDULER_H
+#define RECONNECTSCHEDULER_H
+
+#include "utilities/Executor.h"
+#include "utilities/Metrics.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <random>
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * @brief Retries connecting on Executor with exponential backoff and jitter
+ *
+ * Attempts run on executor workers, so threads that request reconnect are never blocked by it.
+ * Delay between attempts doubles up to maximum, and each wait is picked between half and full delay,
+ * so that gateways which lost connection at the same time do not retry in lockstep.
+ * Connection lost before it stayed up for stable period is treated as flapping: backoff carries on
+ * from where it stopped instead of reconnecting right away, so an unstable link does not cause a storm
+ * of handshakes.
+ */
+class ReconnectScheduler
+{
+public:
+    /**
+     * @param executor Executor on which connection attempts run
+     * @param connect Makes one connection attempt, returns true on success
+     * @param connected Called once connection attempt succeeds
+     * @param name Prefix of metrics reported by this instance
+     * @param initialDelay Delay after first failed attempt
+     * @param maximumDelay Upper bound of delay between attempts
+     * @param stablePeriod Time connection must stay up for backoff to be reset, 0 always resets it
+     */
+    ReconnectScheduler(Executor& executor, std::function<bool()> connect, std::function<void()> connected,
+                       const std::string& name, std::chrono::milliseconds initialDelay = DEFAULT_INITIAL_DELAY,
+                       std::chrono::milliseconds maximumDelay = DEFAULT_MAXIMUM_DELAY,
+                       std::chrono::milliseconds stablePeriod = DEFAULT_STABLE_PERIOD);
+    ~ReconnectScheduler();
+
+    ReconnectScheduler(const ReconnectScheduler&) = delete;
+    ReconnectScheduler& operator=(const ReconnectScheduler&) = delete;
+
+    /**
+     * @brief Starts connecting, right away unless last connection was lost before stable period,
+     * does nothing if already connecting
+     */
+    void start();
+
+    /**
+     * @brief Stops connecting, waits for attempt which is in progress
+     */
+    void stop();
+
+    bool isRunning() const;
+
+    /**
+     * @brief Changes backoff parameters, delay of attempt already scheduled is not changed
+     * @param initialDelay Delay after first failed attempt
+     * @param maximumDelay Upper bound of delay between attempts
+     * @param stablePeriod Time connection must stay up for backoff to be reset, 0 always resets it
+     */
+    void setBackoff(std::chrono::milliseconds initialDelay, std::chrono::milliseconds maximumDelay,
+                    std::chrono::milliseconds stablePeriod);
+
+    static const std::chrono::milliseconds DEFAULT_INITIAL_DELAY;
+    static const std::chrono::milliseconds DEFAULT_MAXIMUM_DELAY;
+    static const std::chrono::milliseconds DEFAULT_STABLE_PERIOD;
+
+private:
+    void attempt(std::uint64_t generation);
+    std::chrono::milliseconds nextDelay();
+
+    Executor& m_executor;
+    std::function<bool()> m_connect;
+    std::function<void()> m_connected;
+
+    std::chrono::milliseconds m_initialDelay;
+    std::chrono::milliseconds m_maximumDelay;
+    std::chrono::milliseconds m_stablePeriod;
+
+    Counter& m_attempts;
+    Counter& m_failures;
+    Counter& m_flappingConnections;
+
+    mutable std::mutex m_lock;
+    bool m_running;
+    // incremented on every start and stop, so attempts scheduled before are discarded
+    std::uint64_t m_generation;
+    Executor::TaskId m_task;
+    std::chrono::milliseconds m_delay;
+    bool m_wasConnected;
+    std::chrono::steady_clock::time_point m_connectedAt;
+    std::minstd_rand m_random;
+};
+}    // namespace wolkabout
+
+#endif    // RECONNECTSCHEDULER_H
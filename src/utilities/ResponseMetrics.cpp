@@ -0,0 +1,75 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/ResponseMetrics.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace wolkabout
+{
+const unsigned ResponseMetrics::MAX_TRACKED_RETRIES;
+
+ResponseMetrics::ResponseMetrics(const std::string& requestClass)
+: m_latency{MetricsRegistry::getInstance().histogram("wolkgateway_response_" + requestClass + "_latency_seconds")}
+{
+    for (unsigned i = 0; i < m_retries.size(); ++i)
+    {
+        m_retries[i] = &MetricsRegistry::getInstance().counter("wolkgateway_response_" + requestClass + "_retries_" +
+                                                              std::to_string(i) + "_total");
+    }
+}
+
+ResponseMetrics& ResponseMetrics::forRequestChannel(const std::string& channel)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::unique_ptr<ResponseMetrics>> metrics;
+
+    const std::string name = requestClass(channel);
+
+    std::lock_guard<std::mutex> lg{mutex};
+
+    auto& instance = metrics[name];
+    if (!instance)
+    {
+        instance.reset(new ResponseMetrics(name));
+    }
+
+    return *instance;
+}
+
+std::string ResponseMetrics::requestClass(const std::string& channel)
+{
+    // channels look like "d2p/register_subdevice_request/g/GATEWAY_KEY/..."
+    const auto start = channel.find('/');
+    if (start == std::string::npos)
+    {
+        return channel.empty() ? "unknown" : channel;
+    }
+
+    const auto end = channel.find('/', start + 1);
+    const std::string name = channel.substr(start + 1, end == std::string::npos ? end : end - start - 1);
+    return name.empty() ? "unknown" : name;
+}
+
+void ResponseMetrics::record(std::chrono::nanoseconds latency, unsigned retries)
+{
+    m_latency.record(latency);
+    m_retries[std::min<std::size_t>(retries, MAX_TRACKED_RETRIES)]->increment();
+}
+}    // namespace wolkabout
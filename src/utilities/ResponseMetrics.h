@@ -0,0 +1,59 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef RESPONSEMETRICS_H
+#define RESPONSEMETRICS_H
+
+#include "utilities/Metrics.h"
+
+#include <array>
+#include <chrono>
+#include <string>
+
+namespace wolkabout
+{
+/**
+ * @brief Response latency and retry count distribution of one class of platform requests
+ *
+ * Request class is the message type level of request channel, e.g. "register_subdevice_request".
+ * Latency from the last send of a request to its response is recorded in
+ * wolkgateway_response_<class>_latency_seconds, and number of retries it took in
+ * wolkgateway_response_<class>_retries_<n>_total, counts above MAX_TRACKED_RETRIES going to the last counter.
+ */
+class ResponseMetrics
+{
+public:
+    static const unsigned MAX_TRACKED_RETRIES = 5;
+
+    explicit ResponseMetrics(const std::string& requestClass);
+
+    /**
+     * @brief Returns metrics of class request on given channel belongs to
+     * Instances live as long as the process, so callers may keep the reference.
+     */
+    static ResponseMetrics& forRequestChannel(const std::string& channel);
+
+    static std::string requestClass(const std::string& channel);
+
+    void record(std::chrono::nanoseconds latency, unsigned retries);
+
+private:
+    Histogram& m_latency;
+    std::array<Counter*, MAX_TRACKED_RETRIES + 1> m_retries;
+};
+}    // namespace wolkabout
+
+#endif    // RESPONSEMETRICS_H
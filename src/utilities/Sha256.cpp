@@ -0,0 +1,153 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/Sha256.h"
+#include "utilities/Logger.h"
+
+#include "Poco/Crypto/DigestEngine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#elif defined(__aarch64__) && defined(__linux__)
+#include <asm/hwcap.h>
+#include <sys/auxv.h>
+#endif
+
+namespace
+{
+// mapped pages are released after every block, keeping resident memory bounded for large files
+const std::size_t HASH_BLOCK_SIZE = 1024 * 1024;
+}    // namespace
+
+namespace wolkabout
+{
+Sha256::Sha256() : m_engine{new Poco::Crypto::DigestEngine("SHA256")} {}
+
+Sha256::~Sha256() = default;
+
+void Sha256::update(const std::uint8_t* data, std::size_t size)
+{
+    m_engine->update(data, size);
+}
+
+void Sha256::update(const ByteArray& data)
+{
+    update(data.data(), data.size());
+}
+
+ByteArray Sha256::digest()
+{
+    const auto& digest = m_engine->digest();
+    return ByteArray(digest.begin(), digest.end());
+}
+
+void Sha256::reset()
+{
+    m_engine->reset();
+}
+
+bool Sha256::hashFile(const std::string& filePath, ByteArray& hash)
+{
+    const int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        LOG(ERROR) << "Sha256: Unable to open file '" << filePath << "': " << std::strerror(errno);
+        return false;
+    }
+
+    struct stat info;
+    if (::fstat(fd, &info) != 0)
+    {
+        LOG(ERROR) << "Sha256: Unable to stat file '" << filePath << "': " << std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+
+    Sha256 sha256;
+    const auto size = static_cast<std::size_t>(info.st_size);
+
+    if (size != 0)
+    {
+        void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            LOG(ERROR) << "Sha256: Unable to map file '" << filePath << "': " << std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+
+        ::madvise(mapping, size, MADV_SEQUENTIAL);
+
+        auto* data = static_cast<std::uint8_t*>(mapping);
+        for (std::size_t offset = 0; offset < size; offset += HASH_BLOCK_SIZE)
+        {
+            const auto length = std::min(HASH_BLOCK_SIZE, size - offset);
+            sha256.update(data + offset, length);
+            ::madvise(data + offset, length, MADV_DONTNEED);
+        }
+
+        ::munmap(mapping, size);
+    }
+
+    ::close(fd);
+
+    hash = sha256.digest();
+    return true;
+}
+
+ByteArray Sha256::hash(const std::uint8_t* data, std::size_t size)
+{
+    Sha256 sha256;
+    sha256.update(data, size);
+    return sha256.digest();
+}
+
+ByteArray Sha256::hash(const ByteArray& data)
+{
+    return hash(data.data(), data.size());
+}
+
+const char* Sha256::cpuAcceleration()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_max(0, nullptr) >= 7)
+    {
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        // CPUID.(EAX=7,ECX=0):EBX bit 29
+        if ((ebx & (1u << 29)) != 0)
+        {
+            return "SHA-NI";
+        }
+    }
+#elif defined(__aarch64__) && defined(__linux__)
+    if ((::getauxval(AT_HWCAP) & HWCAP_SHA2) != 0)
+    {
+        return "ARMv8 SHA2";
+    }
+#endif
+
+    return "none";
+}
+}    // namespace wolkabout
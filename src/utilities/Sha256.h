@@ -0,0 +1,82 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include "utilities/ByteUtils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace Poco
+{
+namespace Crypto
+{
+class DigestEngine;
+}
+}    // namespace Poco
+
+namespace wolkabout
+{
+/**
+ * @brief Incremental SHA-256, for hashing data that arrives or is read in parts
+ *
+ * Backed by OpenSSL, which selects SHA-NI on x86 or ARMv8 crypto extensions at runtime when CPU supports them.
+ */
+class Sha256
+{
+public:
+    Sha256();
+    ~Sha256();
+
+    Sha256(const Sha256&) = delete;
+    Sha256& operator=(const Sha256&) = delete;
+
+    void update(const std::uint8_t* data, std::size_t size);
+    void update(const ByteArray& data);
+
+    /**
+     * @brief Returns hash of all data passed to update, and starts new hash
+     */
+    ByteArray digest();
+
+    void reset();
+
+    /**
+     * @brief Hashes file in a single pass, without reading it into memory
+     * @param filePath Path of file to hash
+     * @param hash Resulting hash
+     * @return false if file could not be read
+     */
+    static bool hashFile(const std::string& filePath, ByteArray& hash);
+
+    static ByteArray hash(const std::uint8_t* data, std::size_t size);
+    static ByteArray hash(const ByteArray& data);
+
+    /**
+     * @brief Name of SHA-256 instructions detected on this CPU, "none" when only portable implementation is usable
+     */
+    static const char* cpuAcceleration();
+
+private:
+    std::unique_ptr<Poco::Crypto::DigestEngine> m_engine;
+};
+}    // namespace wolkabout
+
+#endif    // SHA256_H
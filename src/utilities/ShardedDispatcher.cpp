@@ -0,0 +1,209 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/ShardedDispatcher.h"
+#include "utilities/Logger.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace wolkabout
+{
+const std::size_t ShardedDispatcher::SHARDS_PER_WORKER = 16;
+const std::size_t ShardedDispatcher::TASKS_PER_TURN = 32;
+
+ShardedDispatcher::ShardedDispatcher(std::size_t workers, std::size_t shards) : m_readyCount{0}, m_run{true}
+{
+    workers = std::max(workers, std::size_t{1});
+    shards = shards != 0 ? shards : workers * SHARDS_PER_WORKER;
+
+    for (std::size_t i = 0; i < shards; ++i)
+    {
+        m_shards.emplace_back(new Shard());
+    }
+
+    for (std::size_t i = 0; i < workers; ++i)
+    {
+        m_workers.emplace_back(new Worker());
+    }
+
+    for (std::size_t i = 0; i < workers; ++i)
+    {
+        m_workers[i]->thread = std::thread(&ShardedDispatcher::run, this, i);
+    }
+}
+
+ShardedDispatcher::~ShardedDispatcher()
+{
+    {
+        std::lock_guard<std::mutex> locker{m_lock};
+        m_run = false;
+    }
+
+    m_condition.notify_all();
+
+    for (auto& worker : m_workers)
+    {
+        if (worker->thread.joinable())
+        {
+            worker->thread.join();
+        }
+    }
+}
+
+void ShardedDispatcher::dispatch(const std::string& key, std::function<void()> task)
+{
+    const auto index = std::hash<std::string>{}(key) % m_shards.size();
+    auto& shard = *m_shards[index];
+
+    {
+        std::lock_guard<std::mutex> locker{shard.lock};
+        shard.tasks.push_back(std::move(task));
+
+        if (shard.scheduled)
+        {
+            // worker owning the shard will pick the task up
+            return;
+        }
+
+        shard.scheduled = true;
+    }
+
+    makeReady(index);
+}
+
+std::size_t ShardedDispatcher::getWorkerCount() const
+{
+    return m_workers.size();
+}
+
+void ShardedDispatcher::makeReady(std::size_t shard)
+{
+    auto& worker = *m_workers[shard % m_workers.size()];
+    {
+        std::lock_guard<std::mutex> locker{worker.lock};
+        worker.ready.push_back(shard);
+    }
+
+    {
+        std::lock_guard<std::mutex> locker{m_lock};
+        ++m_readyCount;
+    }
+
+    m_condition.notify_one();
+}
+
+std::size_t ShardedDispatcher::takeReady(std::size_t worker)
+{
+    // a ready shard was reserved by the caller, so one of the queues is guaranteed to hold it
+    while (true)
+    {
+        for (std::size_t i = 0; i < m_workers.size(); ++i)
+        {
+            auto& victim = *m_workers[(worker + i) % m_workers.size()];
+
+            std::lock_guard<std::mutex> locker{victim.lock};
+            if (victim.ready.empty())
+            {
+                continue;
+            }
+
+            std::size_t shard;
+            if (i == 0)
+            {
+                shard = victim.ready.front();
+                victim.ready.pop_front();
+            }
+            else
+            {
+                // steal from the back, away from where the owner takes work
+                shard = victim.ready.back();
+                victim.ready.pop_back();
+            }
+
+            return shard;
+        }
+
+        std::this_thread::yield();
+    }
+}
+
+void ShardedDispatcher::process(std::size_t index)
+{
+    auto& shard = *m_shards[index];
+
+    for (std::size_t i = 0; i < TASKS_PER_TURN; ++i)
+    {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> locker{shard.lock};
+            if (shard.tasks.empty())
+            {
+                shard.scheduled = false;
+                return;
+            }
+
+            task = std::move(shard.tasks.front());
+            shard.tasks.pop_front();
+        }
+
+        try
+        {
+            task();
+        }
+        catch (const std::exception& e)
+        {
+            LOG(ERROR) << "ShardedDispatcher: Task failed: " << e.what();
+        }
+        catch (...)
+        {
+            LOG(ERROR) << "ShardedDispatcher: Task failed";
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> locker{shard.lock};
+        if (shard.tasks.empty())
+        {
+            shard.scheduled = false;
+            return;
+        }
+    }
+
+    // give other shards a turn before continuing with a busy one
+    makeReady(index);
+}
+
+void ShardedDispatcher::run(std::size_t worker)
+{
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> locker{m_lock};
+            m_condition.wait(locker, [&] { return !m_run || m_readyCount != 0; });
+
+            if (!m_run)
+            {
+                return;
+            }
+
+            --m_readyCount;
+        }
+
+        process(takeReady(worker));
+    }
+}
+}    // namespace wolkabout
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef SHARDEDDISPATCHER_H
+#define SHARDEDDISPATCHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Runs tasks on a pool of workers, keeping tasks with the same key in submission order
+ *
+ * Keys are hashed to shards, and a shard is processed by at most one worker at a time.
+ * Shards with pending work are queued on the worker they belong to, and idle workers steal
+ * them from busy ones, so load spreads across the pool while per-key ordering is preserved.
+ */
+class ShardedDispatcher
+{
+public:
+    explicit ShardedDispatcher(std::size_t workers, std::size_t shards = 0);
+    ~ShardedDispatcher();
+
+    ShardedDispatcher(const ShardedDispatcher&) = delete;
+    ShardedDispatcher& operator=(const ShardedDispatcher&) = delete;
+
+    void dispatch(const std::string& key, std::function<void()> task);
+
+    std::size_t getWorkerCount() const;
+
+    static const std::size_t SHARDS_PER_WORKER;
+    static const std::size_t TASKS_PER_TURN;
+
+private:
+    struct Shard
+    {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+        bool scheduled = false;
+    };
+
+    struct Worker
+    {
+        std::mutex lock;
+        std::deque<std::size_t> ready;
+        std::thread thread;
+    };
+
+    void makeReady(std::size_t shard);
+    std::size_t takeReady(std::size_t worker);
+    void process(std::size_t shard);
+    void run(std::size_t worker);
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+    std::vector<std::unique_ptr<Worker>> m_workers;
+
+    // number of ready shards not yet claimed by a worker
+    std::size_t m_readyCount;
+    std::mutex m_lock;
+    std::condition_variable m_condition;
+
+    std::atomic_bool m_run;
+};
+}    // namespace wolkabout
+
+#endif    // SHARDEDDISPATCHER_H
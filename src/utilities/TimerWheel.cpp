@@ -0,0 +1,216 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/TimerWheel.h"
+
+#include <algorithm>
+
+namespace wolkabout
+{
+const std::chrono::milliseconds TimerWheel::DEFAULT_TICK{100};
+
+constexpr unsigned TimerWheel::SLOT_BITS;
+constexpr std::size_t TimerWheel::SLOTS;
+constexpr std::size_t TimerWheel::LEVELS;
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick)
+: m_tick{std::max(tick, std::chrono::milliseconds{1})}
+, m_start{std::chrono::steady_clock::now()}
+, m_now{0}
+, m_nextId{0}
+, m_run{true}
+, m_worker{&TimerWheel::run, this}
+{
+}
+
+TimerWheel::~TimerWheel()
+{
+    {
+        std::lock_guard<std::mutex> locker{m_lock};
+        m_run = false;
+    }
+
+    m_condition.notify_one();
+
+    if (m_worker.joinable())
+    {
+        m_worker.join();
+    }
+}
+
+TimerWheel::Id TimerWheel::schedule(std::chrono::milliseconds delay, std::function<void()> callback)
+{
+    const auto rounded = std::max(delay.count() + m_tick.count() - 1, std::chrono::milliseconds::rep{0});
+    const auto ticks = static_cast<std::uint64_t>(rounded / m_tick.count());
+
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    const bool wasIdle = m_entries.empty();
+    if (wasIdle)
+    {
+        // nothing was pending, so the wheel did not follow the clock while idle
+        m_now = elapsedTicks();
+    }
+
+    // current tick is already partially elapsed, so count from the next one to never fire early
+    const Id id = ++m_nextId;
+    const std::uint64_t expiry = elapsedTicks() + ticks + 1;
+
+    m_entries.emplace(id, Entry{expiry, std::move(callback)});
+    place(id, expiry);
+
+    if (wasIdle)
+    {
+        m_condition.notify_one();
+    }
+
+    return id;
+}
+
+bool TimerWheel::cancel(Id id)
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+
+    // slots are cleaned up lazily when they come up
+    return m_entries.erase(id) != 0;
+}
+
+std::size_t TimerWheel::size() const
+{
+    std::lock_guard<std::mutex> locker{m_lock};
+    return m_entries.size();
+}
+
+void TimerWheel::run()
+{
+    std::vector<std::function<void()>> expired;
+
+    while (m_run)
+    {
+        {
+            std::unique_lock<std::mutex> locker{m_lock};
+
+            if (m_entries.empty())
+            {
+                m_condition.wait(locker, [&] { return !m_run || !m_entries.empty(); });
+            }
+            else
+            {
+                m_condition.wait_until(locker, m_start + m_tick * static_cast<std::int64_t>(m_now + 1),
+                                       [&] { return !m_run; });
+            }
+
+            if (!m_run)
+            {
+                return;
+            }
+
+            const auto target = elapsedTicks();
+            while (m_now < target && !m_entries.empty())
+            {
+                advance(expired);
+            }
+        }
+
+        for (const auto& callback : expired)
+        {
+            callback();
+        }
+
+        expired.clear();
+    }
+}
+
+void TimerWheel::place(Id id, std::uint64_t expiry)
+{
+    const std::uint64_t delta = expiry > m_now ? expiry - m_now : 1;
+
+    for (std::size_t level = 0; level < LEVELS; ++level)
+    {
+        const unsigned shift = static_cast<unsigned>(SLOT_BITS * (level + 1));
+        if (level + 1 == LEVELS || delta < (std::uint64_t{1} << shift))
+        {
+            // timeouts beyond the wheel range are parked in the last level and re-placed on cascade
+            const std::uint64_t limit = m_now + (std::uint64_t{1} << shift) - 1;
+            const std::uint64_t slotTime = std::max(std::min(expiry, limit), m_now + 1);
+            const auto index = static_cast<std::size_t>((slotTime >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+            m_slots[level][index].push_back(id);
+            return;
+        }
+    }
+}
+
+void TimerWheel::cascade(std::size_t level)
+{
+    const auto index = static_cast<std::size_t>((m_now >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+    Slot slot;
+    slot.swap(m_slots[level][index]);
+
+    for (const Id id : slot)
+    {
+        auto it = m_entries.find(id);
+        if (it != m_entries.end())
+        {
+            place(id, it->second.expiry);
+        }
+    }
+}
+
+void TimerWheel::advance(std::vector<std::function<void()>>& expired)
+{
+    ++m_now;
+
+    // move timeouts down from every level whose slot boundary was crossed, highest level first
+    for (std::size_t level = LEVELS - 1; level > 0; --level)
+    {
+        if ((m_now & ((std::uint64_t{1} << (SLOT_BITS * level)) - 1)) == 0)
+        {
+            cascade(level);
+        }
+    }
+
+    Slot slot;
+    slot.swap(m_slots[0][static_cast<std::size_t>(m_now & (SLOTS - 1))]);
+
+    for (const Id id : slot)
+    {
+        auto it = m_entries.find(id);
+        if (it == m_entries.end())
+        {
+            continue;
+        }
+
+        if (it->second.expiry <= m_now)
+        {
+            expired.push_back(std::move(it->second.callback));
+            m_entries.erase(it);
+        }
+        else
+        {
+            place(id, it->second.expiry);
+        }
+    }
+}
+
+std::uint64_t TimerWheel::elapsedTicks() const
+{
+    const auto elapsed =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_start);
+    return static_cast<std::uint64_t>(elapsed.count() / m_tick.count());
+}
+}    // namespace wolkabout
@@ -0,0 +1,111 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Hierarchical timer wheel running all timeouts on a single thread
+ *
+ * Timeouts are kept in four levels of 64 slots. Level 0 slots span one tick, every following level spans
+ * 64 slots of the previous one, and timeouts are moved down a level when their slot comes up.
+ * Scheduling and cancelling are constant time regardless of the number of pending timeouts.
+ *
+ * Callbacks are invoked from the wheel thread without internal lock held,
+ * so they may schedule or cancel timeouts.
+ */
+class TimerWheel
+{
+public:
+    using Id = std::uint64_t;
+
+    explicit TimerWheel(std::chrono::milliseconds tick = DEFAULT_TICK);
+    ~TimerWheel();
+
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    /**
+     * @brief Schedules one shot timeout
+     * @param delay Time after which callback is invoked, rounded up to whole ticks
+     * @param callback Function to invoke
+     * @return Id which can be used to cancel timeout
+     */
+    Id schedule(std::chrono::milliseconds delay, std::function<void()> callback);
+
+    /**
+     * @brief Cancels pending timeout
+     * @param id Id returned by schedule
+     * @return true if timeout was pending, false if it already fired or was cancelled
+     */
+    bool cancel(Id id);
+
+    std::size_t size() const;
+
+    static const std::chrono::milliseconds DEFAULT_TICK;
+
+private:
+    static constexpr unsigned SLOT_BITS = 6;
+    static constexpr std::size_t SLOTS = 1u << SLOT_BITS;
+    static constexpr std::size_t LEVELS = 4;
+
+    struct Entry
+    {
+        std::uint64_t expiry;
+        std::function<void()> callback;
+    };
+
+    using Slot = std::vector<Id>;
+
+    void run();
+
+    void place(Id id, std::uint64_t expiry);
+    void cascade(std::size_t level);
+    void advance(std::vector<std::function<void()>>& expired);
+
+    std::uint64_t elapsedTicks() const;
+
+    const std::chrono::milliseconds m_tick;
+    const std::chrono::steady_clock::time_point m_start;
+
+    std::uint64_t m_now;
+    Id m_nextId;
+
+    std::unordered_map<Id, Entry> m_entries;
+    std::array<std::array<Slot, SLOTS>, LEVELS> m_slots;
+
+    mutable std::mutex m_lock;
+    std::condition_variable m_condition;
+
+    std::atomic_bool m_run;
+    std::thread m_worker;
+};
+}    // namespace wolkabout
+
+#endif    // TIMERWHEEL_H
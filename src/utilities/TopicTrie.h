@@ -0,0 +1,356 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TOPICTRIE_H
+#define TOPICTRIE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Subscription index keyed by MQTT topic filters
+ *
+ * Filters are split on '/' and stored one level per node, with '+' and '#' kept in dedicated
+ * slots, so lookup cost depends on topic depth instead of the number of subscriptions.
+ * When several filters match a topic, the value of the lexicographically smallest filter is returned,
+ * which is the same one a scan over an ordered std::map of filters would find first.
+ *
+ * Not thread safe, callers are expected to provide synchronization.
+ */
+template <class T> class TopicTrie
+{
+public:
+    TopicTrie() : m_root{new Node()}, m_size{0} {}
+
+    TopicTrie(const TopicTrie& other) : m_root{clone(*other.m_root)}, m_size{other.m_size} {}
+
+    TopicTrie& operator=(const TopicTrie& other)
+    {
+        if (this != &other)
+        {
+            m_root = clone(*other.m_root);
+            m_size = other.m_size;
+        }
+
+        return *this;
+    }
+
+    /**
+     * @brief Adds value for topic filter, replacing value previously stored for the same filter
+     * @param filter MQTT topic filter, may contain '+' and '#' wildcards
+     * @param value Value to store
+     */
+    void insert(const std::string& filter, T value)
+    {
+        Node* node = m_root.get();
+        for (const auto& level : split(filter))
+        {
+            std::unique_ptr<Node>& next = childSlot(*node, level);
+            if (!next)
+            {
+                next.reset(new Node());
+            }
+
+            node = next.get();
+        }
+
+        if (!node->hasValue)
+        {
+            ++m_size;
+        }
+
+        node->hasValue = true;
+        node->filter = filter;
+        node->value = std::move(value);
+    }
+
+    /**
+     * @brief Removes value stored for topic filter
+     * @param filter MQTT topic filter exactly as it was inserted
+     * @return true if value was removed, false if filter was not present
+     */
+    bool remove(const std::string& filter)
+    {
+        if (!remove(*m_root, split(filter), 0))
+        {
+            return false;
+        }
+
+        --m_size;
+        return true;
+    }
+
+    /**
+     * @brief Finds value whose filter matches given topic
+     * @param topic Topic without wildcards
+     * @return Pointer to stored value, or nullptr if no filter matches. Pointer is valid until trie is modified
+     */
+    const T* match(const std::string& topic) const
+    {
+        const Node* best = nullptr;
+        match(*m_root, split(topic), 0, best);
+        return best ? &best->value : nullptr;
+    }
+
+    /**
+     * @brief Finds values of all filters that match given topic
+     * @param topic Topic without wildcards
+     * @return Matching values, ordered by filter
+     */
+    std::vector<T> matchAll(const std::string& topic) const
+    {
+        std::vector<const Node*> nodes;
+        matchAll(*m_root, split(topic), 0, nodes);
+
+        std::sort(nodes.begin(), nodes.end(),
+                  [](const Node* lhs, const Node* rhs) { return lhs->filter < rhs->filter; });
+
+        std::vector<T> values;
+        values.reserve(nodes.size());
+        for (const Node* node : nodes)
+        {
+            values.push_back(node->value);
+        }
+
+        return values;
+    }
+
+    bool empty() const { return m_size == 0; }
+
+    std::size_t size() const { return m_size; }
+
+    void clear()
+    {
+        m_root.reset(new Node());
+        m_size = 0;
+    }
+
+private:
+    static constexpr const char* SINGLE_LEVEL_WILDCARD = "+";
+    static constexpr const char* MULTI_LEVEL_WILDCARD = "#";
+
+    struct Node
+    {
+        Node() : hasValue{false} {}
+
+        std::unordered_map<std::string, std::unique_ptr<Node>> children;
+        std::unique_ptr<Node> singleLevel;
+        std::unique_ptr<Node> multiLevel;
+
+        bool hasValue;
+        std::string filter;
+        T value;
+    };
+
+    static std::vector<std::string> split(const std::string& topic)
+    {
+        std::vector<std::string> levels;
+
+        std::string::size_type start = 0;
+        while (true)
+        {
+            const auto end = topic.find('/', start);
+            if (end == std::string::npos)
+            {
+                levels.emplace_back(topic, start);
+                break;
+            }
+
+            levels.emplace_back(topic, start, end - start);
+            start = end + 1;
+        }
+
+        return levels;
+    }
+
+    static std::unique_ptr<Node> clone(const Node& node)
+    {
+        std::unique_ptr<Node> copy{new Node()};
+        copy->hasValue = node.hasValue;
+        copy->filter = node.filter;
+        copy->value = node.value;
+
+        for (const auto& child : node.children)
+        {
+            copy->children.emplace(child.first, clone(*child.second));
+        }
+
+        if (node.singleLevel)
+        {
+            copy->singleLevel = clone(*node.singleLevel);
+        }
+
+        if (node.multiLevel)
+        {
+            copy->multiLevel = clone(*node.multiLevel);
+        }
+
+        return copy;
+    }
+
+    static std::unique_ptr<Node>& childSlot(Node& node, const std::string& level)
+    {
+        if (level == SINGLE_LEVEL_WILDCARD)
+        {
+            return node.singleLevel;
+        }
+
+        if (level == MULTI_LEVEL_WILDCARD)
+        {
+            return node.multiLevel;
+        }
+
+        return node.children[level];
+    }
+
+    static void consider(const Node& node, const Node*& best)
+    {
+        if (node.hasValue && (!best || node.filter < best->filter))
+        {
+            best = &node;
+        }
+    }
+
+    static void match(const Node& node, const std::vector<std::string>& levels, std::size_t index, const Node*& best)
+    {
+        // '#' also matches the parent level, as in "a/#" matching "a"
+        if (node.multiLevel)
+        {
+            consider(*node.multiLevel, best);
+        }
+
+        if (index == levels.size())
+        {
+            consider(node, best);
+            return;
+        }
+
+        auto it = node.children.find(levels[index]);
+        if (it != node.children.end())
+        {
+            match(*it->second, levels, index + 1, best);
+        }
+
+        if (node.singleLevel)
+        {
+            match(*node.singleLevel, levels, index + 1, best);
+        }
+    }
+
+    static void matchAll(const Node& node, const std::vector<std::string>& levels, std::size_t index,
+                         std::vector<const Node*>& nodes)
+    {
+        if (node.multiLevel && node.multiLevel->hasValue)
+        {
+            nodes.push_back(node.multiLevel.get());
+        }
+
+        if (index == levels.size())
+        {
+            if (node.hasValue)
+            {
+                nodes.push_back(&node);
+            }
+            return;
+        }
+
+        auto it = node.children.find(levels[index]);
+        if (it != node.children.end())
+        {
+            matchAll(*it->second, levels, index + 1, nodes);
+        }
+
+        if (node.singleLevel)
+        {
+            matchAll(*node.singleLevel, levels, index + 1, nodes);
+        }
+    }
+
+    static bool isLeaf(const Node& node)
+    {
+        return !node.hasValue && node.children.empty() && !node.singleLevel && !node.multiLevel;
+    }
+
+    static bool remove(Node& node, const std::vector<std::string>& levels, std::size_t index)
+    {
+        if (index == levels.size())
+        {
+            if (!node.hasValue)
+            {
+                return false;
+            }
+
+            node.hasValue = false;
+            node.filter.clear();
+            node.value = T{};
+            return true;
+        }
+
+        const std::string& level = levels[index];
+        std::unique_ptr<Node>* slot = nullptr;
+        if (level == SINGLE_LEVEL_WILDCARD)
+        {
+            slot = &node.singleLevel;
+        }
+        else if (level == MULTI_LEVEL_WILDCARD)
+        {
+            slot = &node.multiLevel;
+        }
+        else
+        {
+            auto it = node.children.find(level);
+            if (it == node.children.end())
+            {
+                return false;
+            }
+            slot = &it->second;
+        }
+
+        if (!*slot || !remove(**slot, levels, index + 1))
+        {
+            return false;
+        }
+
+        if (isLeaf(**slot))
+        {
+            if (level == SINGLE_LEVEL_WILDCARD || level == MULTI_LEVEL_WILDCARD)
+            {
+                slot->reset();
+            }
+            else
+            {
+                node.children.erase(level);
+            }
+        }
+
+        return true;
+    }
+
+    std::unique_ptr<Node> m_root;
+    std::size_t m_size;
+};
+
+template <class T> constexpr const char* TopicTrie<T>::SINGLE_LEVEL_WILDCARD;
+template <class T> constexpr const char* TopicTrie<T>::MULTI_LEVEL_WILDCARD;
+}    // namespace wolkabout
+
+#endif
@@ -0,0 +1,234 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/Tracer.h"
+#include "utilities/JsonWriter.h"
+#include "utilities/Logger.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace
+{
+thread_local std::uint64_t currentTrace = 0;
+}    // namespace
+
+namespace wolkabout
+{
+const std::size_t Tracer::DEFAULT_CAPACITY = 10000;
+
+Tracer& Tracer::getInstance()
+{
+    static Tracer instance;
+    return instance;
+}
+
+Tracer::Tracer()
+: m_oneIn{0}, m_received{0}, m_nextTraceId{0}, m_epoch{Clock::now()}, m_capacity{DEFAULT_CAPACITY}, m_next{0}
+{
+}
+
+void Tracer::configure(std::uint32_t oneIn, std::size_t capacity)
+{
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    m_spans.clear();
+    m_spans.reserve(oneIn != 0 ? std::max<std::size_t>(capacity, 1) : 0);
+    m_capacity = std::max<std::size_t>(capacity, 1);
+    m_next = 0;
+    m_bindings.clear();
+
+    m_oneIn.store(oneIn, std::memory_order_relaxed);
+}
+
+bool Tracer::enabled() const
+{
+    return m_oneIn.load(std::memory_order_relaxed) != 0;
+}
+
+std::uint64_t Tracer::sample()
+{
+    const auto oneIn = m_oneIn.load(std::memory_order_relaxed);
+    if (oneIn == 0 || m_received.fetch_add(1, std::memory_order_relaxed) % oneIn != 0)
+    {
+        return 0;
+    }
+
+    return m_nextTraceId.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void Tracer::record(const char* name, std::uint64_t traceId, Clock::time_point start, Clock::time_point end)
+{
+    if (traceId == 0 || !enabled())
+    {
+        return;
+    }
+
+    const Span span{name, traceId, threadIndex(), start, end};
+
+    std::lock_guard<std::mutex> lg{m_lock};
+    if (m_spans.size() < m_capacity)
+    {
+        m_spans.push_back(span);
+    }
+    else
+    {
+        m_spans[m_next] = span;
+    }
+
+    m_next = (m_next + 1) % m_capacity;
+}
+
+void Tracer::bind(const Message& message, std::uint64_t traceId)
+{
+    if (traceId == 0 || !enabled())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    // messages dropped from queues are never taken, so bindings are bounded like spans
+    if (m_bindings.size() >= m_capacity)
+    {
+        m_bindings.clear();
+    }
+
+    m_bindings[&message] = Binding{traceId, Clock::now()};
+}
+
+std::uint64_t Tracer::take(const Message& message, Clock::time_point& boundAt)
+{
+    if (!enabled())
+    {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lg{m_lock};
+
+    const auto it = m_bindings.find(&message);
+    if (it == m_bindings.end())
+    {
+        return 0;
+    }
+
+    const auto traceId = it->second.traceId;
+    boundAt = it->second.boundAt;
+    m_bindings.erase(it);
+    return traceId;
+}
+
+bool Tracer::dump(const std::string& path) const
+{
+    JsonWriter writer;
+    writer.beginObject().key("traceEvents").beginArray();
+
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+
+        // oldest span first, once ring buffer has wrapped it is the one to be overwritten next
+        const auto first = m_spans.size() < m_capacity ? 0 : m_next;
+        for (std::size_t i = 0; i < m_spans.size(); ++i)
+        {
+            const Span& span = m_spans[(first + i) % m_spans.size()];
+            const auto start = std::chrono::duration_cast<std::chrono::microseconds>(span.start - m_epoch);
+            const auto duration = std::chrono::duration_cast<std::chrono::microseconds>(span.end - span.start);
+
+            writer.beginObject()
+              .key("name")
+              .value(std::string{span.name})
+              .key("cat")
+              .value(std::string{"wolkgateway"})
+              .key("ph")
+              .value(std::string{"X"})
+              .key("ts")
+              .value(static_cast<std::int64_t>(start.count()))
+              .key("dur")
+              .value(static_cast<std::int64_t>(duration.count()))
+              .key("pid")
+              .value(std::uint64_t{1})
+              .key("tid")
+              .value(std::uint64_t{span.thread})
+              .key("args")
+              .beginObject()
+              .key("trace")
+              .value(span.traceId)
+              .endObject()
+              .endObject();
+        }
+    }
+
+    writer.endArray().key("displayTimeUnit").value(std::string{"ms"}).endObject();
+
+    const std::string temporaryFilePath = path + ".tmp";
+
+    {
+        std::ofstream file{temporaryFilePath, std::ios::trunc};
+        file << writer.str();
+
+        if (!file.good())
+        {
+            LOG(ERROR) << "Tracer: Unable to write trace to '" << temporaryFilePath << "'";
+            return false;
+        }
+    }
+
+    if (std::rename(temporaryFilePath.c_str(), path.c_str()) != 0)
+    {
+        LOG(ERROR) << "Tracer: Unable to replace trace file '" << path << "'";
+        std::remove(temporaryFilePath.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+std::uint64_t Tracer::current()
+{
+    return currentTrace;
+}
+
+std::uint32_t Tracer::threadIndex()
+{
+    static std::atomic<std::uint32_t> nextIndex{0};
+    static thread_local const std::uint32_t index = ++nextIndex;
+    return index;
+}
+
+TraceScope::TraceScope(std::uint64_t traceId) : m_previous{currentTrace}
+{
+    currentTrace = traceId;
+}
+
+TraceScope::~TraceScope()
+{
+    currentTrace = m_previous;
+}
+
+TraceSpan::TraceSpan(const char* name, std::uint64_t traceId)
+: m_name{name}, m_traceId{traceId}, m_start{traceId != 0 ? Tracer::Clock::now() : Tracer::Clock::time_point{}}
+{
+}
+
+TraceSpan::~TraceSpan()
+{
+    if (m_traceId != 0)
+    {
+        Tracer::getInstance().record(m_name, m_traceId, m_start, Tracer::Clock::now());
+    }
+}
+}    // namespace wolkabout
@@ -0,0 +1,161 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+class Message;
+
+/**
+ * @brief Sampled trace spans of messages passing through routing pipeline
+ *
+ * One in N received messages is given a trace id. Stages running on the thread handling the message
+ * read the id from wolkabout::TraceScope, and stages on other threads receive it with the queued work,
+ * or through bind and take when message itself is queued. Finished spans are kept in a ring buffer
+ * of fixed capacity and written as Chrome trace event file, which Perfetto and chrome://tracing open.
+ *
+ * Spans of messages which are not sampled cost one relaxed atomic load.
+ */
+class Tracer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static Tracer& getInstance();
+
+    /**
+     * @param oneIn Sample one in this many messages, 0 disables tracing
+     * @param capacity Number of most recent spans kept
+     */
+    void configure(std::uint32_t oneIn, std::size_t capacity = DEFAULT_CAPACITY);
+
+    bool enabled() const;
+
+    /**
+     * @brief Decides whether message entering the gateway is traced
+     * @return New trace id, or 0 if message is not sampled
+     */
+    std::uint64_t sample();
+
+    void record(const char* name, std::uint64_t traceId, Clock::time_point start, Clock::time_point end);
+
+    /**
+     * @brief Hands trace of message over to thread that will later take message from a queue
+     */
+    void bind(const Message& message, std::uint64_t traceId);
+
+    /**
+     * @brief Takes trace bound to message
+     * @param boundAt Set to time message was bound
+     * @return Trace id, or 0 if message is not traced
+     */
+    std::uint64_t take(const Message& message, Clock::time_point& boundAt);
+
+    /**
+     * @brief Writes kept spans to file in Chrome trace event format
+     * @return false if file could not be written
+     */
+    bool dump(const std::string& path) const;
+
+    /**
+     * @brief Trace of message handled by calling thread, 0 if there is none
+     */
+    static std::uint64_t current();
+
+    static const std::size_t DEFAULT_CAPACITY;
+
+private:
+    struct Span
+    {
+        const char* name;
+        std::uint64_t traceId;
+        std::uint32_t thread;
+        Clock::time_point start;
+        Clock::time_point end;
+    };
+
+    struct Binding
+    {
+        std::uint64_t traceId;
+        Clock::time_point boundAt;
+    };
+
+    Tracer();
+
+    static std::uint32_t threadIndex();
+
+    std::atomic<std::uint32_t> m_oneIn;
+    std::atomic<std::uint64_t> m_received;
+    std::atomic<std::uint64_t> m_nextTraceId;
+    const Clock::time_point m_epoch;
+
+    mutable std::mutex m_lock;
+    std::vector<Span> m_spans;
+    std::size_t m_capacity;
+    std::size_t m_next;
+    std::unordered_map<const Message*, Binding> m_bindings;
+};
+
+/**
+ * @brief Makes trace current on calling thread for its lifetime
+ */
+class TraceScope
+{
+public:
+    explicit TraceScope(std::uint64_t traceId);
+    ~TraceScope();
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const std::uint64_t m_previous;
+};
+
+/**
+ * @brief Records span from its construction to its destruction, if trace is sampled
+ */
+class TraceSpan
+{
+public:
+    /**
+     * @param name Stage name, must outlive the tracer, e.g. string literal
+     */
+    explicit TraceSpan(const char* name, std::uint64_t traceId = Tracer::current());
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+    const char* m_name;
+    const std::uint64_t m_traceId;
+    const Tracer::Clock::time_point m_start;
+};
+}    // namespace wolkabout
+
+#endif    // TRACER_H
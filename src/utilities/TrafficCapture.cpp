@@ -0,0 +1,222 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/TrafficCapture.h"
+
+#include <cstring>
+
+namespace
+{
+// Guards against allocating for garbage when reading a corrupted file
+const std::uint64_t MAX_STRING_LENGTH = 64 * 1024 * 1024;
+}    // namespace
+
+namespace wolkabout
+{
+const char TrafficCapture::MAGIC[4] = {'W', 'G', 'T', 'C'};
+const std::uint8_t TrafficCapture::VERSION = 1;
+
+TrafficCaptureWriter::TrafficCaptureWriter(const std::string& path)
+: m_file{path, std::ios::binary | std::ios::trunc}, m_previous{Clock::now()}, m_recordCount{0}
+{
+    if (m_file)
+    {
+        m_file.write(TrafficCapture::MAGIC, sizeof(TrafficCapture::MAGIC));
+        m_file.put(static_cast<char>(TrafficCapture::VERSION));
+    }
+}
+
+TrafficCaptureWriter::~TrafficCaptureWriter()
+{
+    flush();
+}
+
+bool TrafficCaptureWriter::isOpen() const
+{
+    std::lock_guard<std::mutex> guard{m_lock};
+    return static_cast<bool>(m_file);
+}
+
+void TrafficCaptureWriter::record(TrafficCapture::Side side, const std::string& channel, const std::string& payload)
+{
+    const auto now = Clock::now();
+
+    std::lock_guard<std::mutex> guard{m_lock};
+    if (!m_file)
+    {
+        return;
+    }
+
+    const auto delta = std::chrono::duration_cast<std::chrono::microseconds>(now - m_previous).count();
+    m_previous = now;
+
+    m_file.put(static_cast<char>(side));
+    writeVarint(delta > 0 ? static_cast<std::uint64_t>(delta) : 0);
+
+    auto it = m_channels.find(channel);
+    if (it != m_channels.end())
+    {
+        writeVarint(it->second);
+    }
+    else
+    {
+        const auto index = static_cast<std::uint64_t>(m_channels.size());
+        m_channels.emplace(channel, index);
+
+        writeVarint(index);
+        writeVarint(channel.size());
+        m_file.write(channel.data(), static_cast<std::streamsize>(channel.size()));
+    }
+
+    writeVarint(payload.size());
+    m_file.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+
+    ++m_recordCount;
+}
+
+void TrafficCaptureWriter::flush()
+{
+    std::lock_guard<std::mutex> guard{m_lock};
+    m_file.flush();
+}
+
+std::uint64_t TrafficCaptureWriter::getRecordCount() const
+{
+    std::lock_guard<std::mutex> guard{m_lock};
+    return m_recordCount;
+}
+
+void TrafficCaptureWriter::writeVarint(std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        m_file.put(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+
+    m_file.put(static_cast<char>(value));
+}
+
+TrafficCaptureReader::TrafficCaptureReader(const std::string& path)
+: m_file{path, std::ios::binary}, m_valid{false}, m_offset{0}
+{
+    char magic[sizeof(TrafficCapture::MAGIC)];
+    if (!m_file.read(magic, sizeof(magic)) || std::memcmp(magic, TrafficCapture::MAGIC, sizeof(magic)) != 0)
+    {
+        return;
+    }
+
+    const auto version = m_file.get();
+    m_valid = version == TrafficCapture::VERSION;
+}
+
+bool TrafficCaptureReader::isValid() const
+{
+    return m_valid;
+}
+
+bool TrafficCaptureReader::next(TrafficCapture::Record& record)
+{
+    if (!m_valid)
+    {
+        return false;
+    }
+
+    const auto side = m_file.get();
+    if (side == std::ifstream::traits_type::eof())
+    {
+        return false;
+    }
+
+    if (side != static_cast<int>(TrafficCapture::Side::PLATFORM) &&
+        side != static_cast<int>(TrafficCapture::Side::DEVICE))
+    {
+        m_valid = false;
+        return false;
+    }
+
+    std::uint64_t delta = 0;
+    std::uint64_t index = 0;
+    if (!readVarint(delta) || !readVarint(index) || index > m_channels.size())
+    {
+        m_valid = false;
+        return false;
+    }
+
+    if (index == m_channels.size())
+    {
+        std::string channel;
+        if (!readString(channel))
+        {
+            m_valid = false;
+            return false;
+        }
+
+        m_channels.push_back(std::move(channel));
+    }
+
+    if (!readString(record.payload))
+    {
+        m_valid = false;
+        return false;
+    }
+
+    m_offset += std::chrono::microseconds{static_cast<std::chrono::microseconds::rep>(delta)};
+
+    record.side = static_cast<TrafficCapture::Side>(side);
+    record.offset = m_offset;
+    record.channel = m_channels[static_cast<std::size_t>(index)];
+    return true;
+}
+
+bool TrafficCaptureReader::readVarint(std::uint64_t& value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+        const auto byte = m_file.get();
+        if (byte == std::ifstream::traits_type::eof())
+        {
+            return false;
+        }
+
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TrafficCaptureReader::readString(std::string& value)
+{
+    std::uint64_t length = 0;
+    if (!readVarint(length) || length > MAX_STRING_LENGTH)
+    {
+        return false;
+    }
+
+    value.resize(static_cast<std::size_t>(length));
+    if (length == 0)
+    {
+        return true;
+    }
+
+    return static_cast<bool>(m_file.read(&value[0], static_cast<std::streamsize>(length)));
+}
+}    // namespace wolkabout
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TRAFFICCAPTURE_H
+#define TRAFFICCAPTURE_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Binary file format of inbound gateway traffic, written as messages arrive and read back by replay tool
+ *
+ * File starts with "WGTC" magic and format version. Each record holds the side message arrived on,
+ * microseconds elapsed since previous record, channel and payload. Integers are stored as varints and
+ * each channel is written once, later records refer to it by its index in order of first appearance,
+ * so a capture of sensor readings costs little more than the payloads themselves.
+ */
+class TrafficCapture
+{
+public:
+    enum class Side : std::uint8_t
+    {
+        PLATFORM = 0,
+        DEVICE = 1
+    };
+
+    struct Record
+    {
+        Side side;
+        std::chrono::microseconds offset;
+        std::string channel;
+        std::string payload;
+    };
+
+    static const char MAGIC[4];
+    static const std::uint8_t VERSION;
+};
+
+/**
+ * @brief Appends received messages to capture file, safe to call from platform and device connectivity threads
+ */
+class TrafficCaptureWriter
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit TrafficCaptureWriter(const std::string& path);
+    ~TrafficCaptureWriter();
+
+    TrafficCaptureWriter(const TrafficCaptureWriter&) = delete;
+    TrafficCaptureWriter& operator=(const TrafficCaptureWriter&) = delete;
+
+    /**
+     * @return false if file could not be created, in which case records are dropped
+     */
+    bool isOpen() const;
+
+    void record(TrafficCapture::Side side, const std::string& channel, const std::string& payload);
+
+    void flush();
+
+    std::uint64_t getRecordCount() const;
+
+private:
+    void writeVarint(std::uint64_t value);
+
+    mutable std::mutex m_lock;
+    std::ofstream m_file;
+    std::unordered_map<std::string, std::uint64_t> m_channels;
+    Clock::time_point m_previous;
+    std::uint64_t m_recordCount;
+};
+
+/**
+ * @brief Reads records of capture file in order they were written
+ */
+class TrafficCaptureReader
+{
+public:
+    explicit TrafficCaptureReader(const std::string& path);
+
+    /**
+     * @return false if file could not be opened or is not a capture
+     */
+    bool isValid() const;
+
+    /**
+     * @param record Filled with next record, offset is relative to start of capture
+     * @return false at end of capture or if file is truncated
+     */
+    bool next(TrafficCapture::Record& record);
+
+private:
+    bool readVarint(std::uint64_t& value);
+    bool readString(std::string& value);
+
+    std::ifstream m_file;
+    bool m_valid;
+    std::vector<std::string> m_channels;
+    std::chrono::microseconds m_offset;
+};
+}    // namespace wolkabout
+
+#endif
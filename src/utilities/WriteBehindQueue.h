@@ -0,0 +1,274 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef WRITEBEHINDQUEUE_H
+#define WRITEBEHINDQUEUE_H
+
+#include "utilities/Metrics.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace wolkabout
+{
+/**
+ * @brief Pending repository mutations, keyed by entity key and applied in batches by a dedicated writer thread
+ *
+ * Only the latest mutation of each key is kept, so an entity saved several times before the writer wakes up
+ * is written once. Writer waits for commit delay after first pending mutation, or until batch size is reached,
+ * and hands all pending mutations to commit function, which is expected to apply them in a single transaction.
+ * Mutations being committed stay visible through find until commit returns, so readers always see their own writes.
+ * Pending mutations are committed before queue is destroyed.
+ */
+template <class Value> class WriteBehindQueue
+{
+public:
+    using Commit = std::function<void(const std::vector<std::shared_ptr<const Value>>& saved,
+                                      const std::vector<std::string>& removed)>;
+
+    enum class State
+    {
+        UNKNOWN,
+        SAVED,
+        REMOVED
+    };
+
+    static constexpr std::size_t DEFAULT_BATCH_SIZE = 256;
+    static constexpr std::chrono::milliseconds::rep DEFAULT_COMMIT_DELAY_MS = 50;
+
+    WriteBehindQueue(Commit commit, const std::string& name,
+                     std::chrono::milliseconds commitDelay = std::chrono::milliseconds{DEFAULT_COMMIT_DELAY_MS},
+                     std::size_t batchSize = DEFAULT_BATCH_SIZE)
+    : m_commit{std::move(commit)}
+    , m_commitDelay{commitDelay}
+    , m_batchSize{batchSize == 0 ? 1 : batchSize}
+    , m_stopped{false}
+    , m_flushRequested{false}
+    , m_pendingGauge{MetricsRegistry::getInstance().gauge("wolkgateway_write_behind_pending{queue=\"" + name + "\"}")}
+    , m_commitDuration{
+        MetricsRegistry::getInstance().histogram("wolkgateway_write_behind_commit_duration{queue=\"" + name + "\"}")}
+    {
+        m_writer = std::thread(&WriteBehindQueue::run, this);
+    }
+
+    ~WriteBehindQueue()
+    {
+        {
+            std::lock_guard<std::mutex> guard{m_mutex};
+            m_stopped = true;
+        }
+
+        m_wakeWriter.notify_one();
+        m_writer.join();
+    }
+
+    WriteBehindQueue(const WriteBehindQueue&) = delete;
+    WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+    void save(const std::string& key, Value value)
+    {
+        push(key, std::make_shared<const Value>(std::move(value)));
+    }
+
+    void remove(const std::string& key) { push(key, nullptr); }
+
+    /**
+     * @brief Looks up mutation not yet committed for given key
+     * @param key Entity key
+     * @param value Set to saved value when SAVED is returned
+     * @return SAVED or REMOVED if a mutation is pending, UNKNOWN if wrapped repository holds latest state
+     */
+    State find(const std::string& key, std::shared_ptr<const Value>& value) const
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+
+        auto it = m_pending.find(key);
+        if (it == m_pending.end())
+        {
+            it = m_inFlight.find(key);
+            if (it == m_inFlight.end())
+            {
+                return State::UNKNOWN;
+            }
+        }
+
+        value = it->second;
+        return value ? State::SAVED : State::REMOVED;
+    }
+
+    /**
+     * @brief Returns keys with mutations not yet committed
+     * @param saved Keys of saved entities
+     * @param removed Keys of removed entities
+     */
+    void keys(std::vector<std::string>& saved, std::vector<std::string>& removed) const
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+
+        for (const auto& mutation : m_inFlight)
+        {
+            if (m_pending.find(mutation.first) == m_pending.end())
+            {
+                (mutation.second ? saved : removed).push_back(mutation.first);
+            }
+        }
+
+        for (const auto& mutation : m_pending)
+        {
+            (mutation.second ? saved : removed).push_back(mutation.first);
+        }
+    }
+
+    /**
+     * @brief Blocks until all mutations pushed so far are committed
+     */
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+
+        m_flushRequested = true;
+        m_wakeWriter.notify_one();
+        m_committed.wait(lock, [this] { return m_pending.empty() && m_inFlight.empty(); });
+        m_flushRequested = false;
+    }
+
+    /**
+     * @brief Drops mutations not yet committed, without waiting for batch being committed
+     */
+    void discard()
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+
+        m_pending.clear();
+        m_pendingGauge.set(0);
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> guard{m_mutex};
+
+        return m_pending.size() + m_inFlight.size();
+    }
+
+private:
+    using Mutations = std::map<std::string, std::shared_ptr<const Value>>;
+
+    void push(const std::string& key, std::shared_ptr<const Value> value)
+    {
+        bool wake = false;
+        {
+            std::lock_guard<std::mutex> guard{m_mutex};
+
+            m_pending[key] = std::move(value);
+            m_pendingGauge.set(static_cast<std::int64_t>(m_pending.size()));
+
+            wake = m_pending.size() == 1 || m_pending.size() >= m_batchSize;
+        }
+
+        if (wake)
+        {
+            m_wakeWriter.notify_one();
+        }
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock{m_mutex};
+
+        while (true)
+        {
+            m_wakeWriter.wait(lock, [this] { return m_stopped || !m_pending.empty(); });
+            if (m_pending.empty())
+            {
+                return;
+            }
+
+            const auto deadline = std::chrono::steady_clock::now() + m_commitDelay;
+            m_wakeWriter.wait_until(lock, deadline, [this] {
+                return m_stopped || m_flushRequested || m_pending.size() >= m_batchSize;
+            });
+
+            m_inFlight.swap(m_pending);
+            m_pendingGauge.set(0);
+
+            std::vector<std::shared_ptr<const Value>> saved;
+            std::vector<std::string> removed;
+            for (const auto& mutation : m_inFlight)
+            {
+                if (mutation.second)
+                {
+                    saved.push_back(mutation.second);
+                }
+                else
+                {
+                    removed.push_back(mutation.first);
+                }
+            }
+
+            lock.unlock();
+
+            const auto start = std::chrono::steady_clock::now();
+            try
+            {
+                m_commit(saved, removed);
+            }
+            catch (...)
+            {
+                // commit functions log their own failures, writer must keep running regardless
+            }
+            m_commitDuration.record(std::chrono::steady_clock::now() - start);
+
+            lock.lock();
+
+            m_inFlight.clear();
+            m_committed.notify_all();
+        }
+    }
+
+    const Commit m_commit;
+    const std::chrono::milliseconds m_commitDelay;
+    const std::size_t m_batchSize;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wakeWriter;
+    std::condition_variable m_committed;
+
+    Mutations m_pending;
+    Mutations m_inFlight;
+    bool m_stopped;
+    bool m_flushRequested;
+
+    Gauge& m_pendingGauge;
+    Histogram& m_commitDuration;
+
+    std::thread m_writer;
+};
+
+template <class Value> constexpr std::size_t WriteBehindQueue<Value>::DEFAULT_BATCH_SIZE;
+template <class Value> constexpr std::chrono::milliseconds::rep WriteBehindQueue<Value>::DEFAULT_COMMIT_DELAY_MS;
+}    // namespace wolkabout
+
+#endif    // WRITEBEHINDQUEUE_H
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/BandwidthScheduler.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+
+namespace
+{
+class BandwidthScheduler : public ::testing::Test
+{
+public:
+    // link of 1000 bytes per second, half of which may be taken by bulk transfers
+    wolkabout::BandwidthScheduler scheduler{1000, 0.5};
+
+    // taken after scheduler is created, so that buckets are full at this point
+    const wolkabout::BandwidthScheduler::Clock::time_point start = wolkabout::BandwidthScheduler::Clock::now();
+};
+}    // namespace
+
+TEST_F(BandwidthScheduler, Given_BulkShare_When_BulkBandwidthIsUsed_Then_NextTransferWaitsForShareToRefill)
+{
+    // When
+    const auto first = scheduler.reserveBulk(1000, start);
+    const auto second = scheduler.reserveBulk(100, start);
+
+    // Then
+    ASSERT_EQ(first.count(), 0);
+    ASSERT_EQ(second.count(), 1000);
+    ASSERT_EQ(scheduler.reserveBulk(100, start + std::chrono::milliseconds{1000}).count(), 0);
+}
+
+TEST_F(BandwidthScheduler, Given_Telemetry_When_LinkIsOverdrawn_Then_BulkIsDelayedUntilTelemetryIsRepaid)
+{
+    // When
+    scheduler.telemetrySent(1200, start);
+
+    // Then
+    ASSERT_EQ(scheduler.reserveBulk(100, start).count(), 200);
+    ASSERT_EQ(scheduler.reserveBulk(100, start + std::chrono::milliseconds{200}).count(), 0);
+}
+
+TEST_F(BandwidthScheduler, Given_LeftOverBandwidth_When_WindowIsRequested_Then_WindowFollowsLeftOverBandwidth)
+{
+    // Then
+    ASSERT_EQ(scheduler.bulkWindow(100, 10, start), 6u);
+    ASSERT_EQ(scheduler.bulkWindow(100, 3, start), 3u);
+
+    scheduler.telemetrySent(800, start);
+    ASSERT_EQ(scheduler.bulkWindow(100, 10, start), 3u);
+
+    scheduler.telemetrySent(500, start);
+    ASSERT_EQ(scheduler.bulkWindow(100, 10, start), 1u);
+}
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MockRepository.h"
+#include "model/DetailedDevice.h"
+#include "model/DeviceReferences.h"
+#include "repository/CachedDeviceRepository.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class CachedDeviceRepository : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        deviceRepository = new MockRepository();
+        cachedDeviceRepository = std::unique_ptr<wolkabout::CachedDeviceRepository>(
+          new wolkabout::CachedDeviceRepository(std::unique_ptr<wolkabout::DeviceRepository>(deviceRepository)));
+    }
+
+    static wolkabout::DetailedDevice* makeDevice()
+    {
+        return new wolkabout::DetailedDevice(
+          "", DEVICE_KEY,
+          wolkabout::DeviceTemplate{
+            {},
+            {wolkabout::SensorTemplate{"", "SENSOR_REF", wolkabout::DataType::NUMERIC, "", {0}, {100}}},
+            {wolkabout::AlarmTemplate{"", "ALARM_REF", ""}},
+            {},
+            "",
+            {},
+            {},
+            {}});
+    }
+
+    MockRepository* deviceRepository;
+    std::unique_ptr<wolkabout::CachedDeviceRepository> cachedDeviceRepository;
+
+    void TearDown() override
+    {
+        cachedDeviceRepository.reset();
+        std::remove(SNAPSHOT_PATH);
+        std::remove(DATABASE_PATH);
+    }
+
+    static constexpr const char* DEVICE_KEY = "DEVICE_KEY";
+    static constexpr const char* SNAPSHOT_PATH = "testsRoutingSnapshot.bin";
+    static constexpr const char* DATABASE_PATH = "testsRoutingSnapshotDatabase.db";
+};
+}    // namespace
+
+TEST_F(CachedDeviceRepository, Given_DeviceInRepository_When_ReferencesAreRequestedTwice_Then_RepositoryIsQueriedOnce)
+{
+    // Given
+    EXPECT_CALL(*deviceRepository, findByDeviceKeyProxy(DEVICE_KEY)).Times(1).WillOnce(testing::Return(makeDevice()));
+
+    // When
+    cachedDeviceRepository->findReferencesByDeviceKey(DEVICE_KEY);
+    auto references = cachedDeviceRepository->findReferencesByDeviceKey(DEVICE_KEY);
+
+    // Then
+    ASSERT_NE(references, nullptr);
+    ASSERT_TRUE(references->hasSensor("SENSOR_REF"));
+    ASSERT_TRUE(references->hasAlarm("ALARM_REF"));
+    ASSERT_FALSE(references->hasSensor("ALARM_REF"));
+    ASSERT_FALSE(references->hasActuator("SENSOR_REF"));
+}
+
+TEST_F(CachedDeviceRepository, Given_SavedDevice_When_ReferencesAreRequested_Then_RepositoryIsNotQueried)
+{
+    // Given
+    EXPECT_CALL(*deviceRepository, findByDeviceKeyProxy(testing::_)).Times(0);
+    std::unique_ptr<wolkabout::DetailedDevice> device{makeDevice()};
+    cachedDeviceRepository->save(*device);
+
+    // When
+    auto references = cachedDeviceRepository->findReferencesByDeviceKey(DEVICE_KEY);
+
+    // Then
+    ASSERT_NE(references, nullptr);
+    ASSERT_TRUE(references->hasSensor("SENSOR_REF"));
+    ASSERT_TRUE(cachedDeviceRepository->containsDeviceWithKey(DEVICE_KEY));
+}
+
+TEST_F(CachedDeviceRepository, Given_CachedDevice_When_DeviceIsRemoved_Then_ReferencesAreNotFound)
+{
+    // Given
+    std::unique_ptr<wolkabout::DetailedDevice> device{makeDevice()};
+    cachedDeviceRepository->save(*device);
+    EXPECT_CALL(*deviceRepository, findByDeviceKeyProxy(DEVICE_KEY)).WillOnce(testing::Return(nullptr));
+
+    // When
+    cachedDeviceRepository->remove(DEVICE_KEY);
+
+    // Then
+    ASSERT_EQ(cachedDeviceRepository->findReferencesByDeviceKey(DEVICE_KEY), nullptr);
+}
+
+TEST_F(CachedDeviceRepository, Given_SnapshotWrittenOnShutdown_When_Loaded_Then_RepositoryIsNotQueried)
+{
+    // Given
+    std::ofstream{DATABASE_PATH} << "database";
+    ASSERT_FALSE(cachedDeviceRepository->loadSnapshot(SNAPSHOT_PATH, DATABASE_PATH));
+    std::unique_ptr<wolkabout::DetailedDevice> device{makeDevice()};
+    cachedDeviceRepository->save(*device);
+    ON_CALL(*deviceRepository, findAllDeviceKeysProxy())
+      .WillByDefault(testing::ReturnNew<std::vector<std::string>>(std::vector<std::string>{DEVICE_KEY}));
+    cachedDeviceRepository.reset();
+
+    deviceRepository = new MockRepository();
+    cachedDeviceRepository.reset(
+      new wolkabout::CachedDeviceRepository(std::unique_ptr<wolkabout::DeviceRepository>(deviceRepository)));
+    EXPECT_CALL(*deviceRepository, findByDeviceKeyProxy(testing::_)).Times(0);
+    EXPECT_CALL(*deviceRepository, findAllDeviceKeysProxy()).Times(0);
+    EXPECT_CALL(*deviceRepository, containsDeviceWithKey(testing::_)).Times(0);
+
+    // When
+    ASSERT_TRUE(cachedDeviceRepository->loadSnapshot(SNAPSHOT_PATH, DATABASE_PATH));
+
+    // Then
+    const auto references = cachedDeviceRepository->findReferencesByDeviceKey(DEVICE_KEY);
+    ASSERT_NE(references, nullptr);
+    ASSERT_TRUE(references->hasSensor("SENSOR_REF"));
+    ASSERT_TRUE(references->hasAlarm("ALARM_REF"));
+    ASSERT_EQ(*cachedDeviceRepository->findAllDeviceKeys(), std::vector<std::string>{DEVICE_KEY});
+    ASSERT_FALSE(cachedDeviceRepository->containsDeviceWithKey("OTHER_KEY"));
+    ASSERT_EQ(cachedDeviceRepository->findReferencesByDeviceKey("OTHER_KEY"), nullptr);
+
+    cachedDeviceRepository->remove(DEVICE_KEY);
+    ASSERT_FALSE(std::ifstream{SNAPSHOT_PATH}.good());
+}
+
+TEST_F(CachedDeviceRepository, Given_UnknownDevice_When_LookedUpRepeatedly_Then_RepositoryIsQueriedUntilDeviceIsSaved)
+{
+    // Given
+    EXPECT_CALL(*deviceRepository, findByDeviceKeyProxy(DEVICE_KEY)).Times(1).WillOnce(testing::Return(nullptr));
+    EXPECT_CALL(*deviceRepository, containsDeviceWithKey(testing::_)).Times(0);
+    ASSERT_EQ(cachedDeviceRepository->findReferencesByDeviceKey(DEVICE_KEY), nullptr);
+
+    // When
+    ASSERT_EQ(cachedDeviceRepository->findReferencesByDeviceKey(DEVICE_KEY), nullptr);
+    ASSERT_FALSE(cachedDeviceRepository->containsDeviceWithKey(DEVICE_KEY));
+    std::unique_ptr<wolkabout::DetailedDevice> device{makeDevice()};
+    cachedDeviceRepository->save(*device);
+
+    // Then
+    ASSERT_NE(cachedDeviceRepository->findReferencesByDeviceKey(DEVICE_KEY), nullptr);
+    ASSERT_TRUE(cachedDeviceRepository->containsDeviceWithKey(DEVICE_KEY));
+}
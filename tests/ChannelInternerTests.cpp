@@ -0,0 +1,48 @@
+#include "utilities/ChannelInterner.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace
+{
+class ChannelInterner : public ::testing::Test
+{
+public:
+    wolkabout::ChannelInterner interner;
+};
+}    // namespace
+
+TEST_F(ChannelInterner, Given_SameChannelInternedTwice_When_Interned_Then_SameIdIsReturned)
+{
+    // Given
+    const auto first = interner.intern("d2p/sensor_reading/g/gateway/d/device1/r/T");
+    const auto second = interner.intern("d2p/sensor_reading/g/gateway/d/device1/r/H");
+
+    // When
+    const auto again = interner.intern("d2p/sensor_reading/g/gateway/d/device1/r/T");
+
+    // Then
+    ASSERT_NE(first, 0u);
+    ASSERT_NE(first, second);
+    ASSERT_EQ(first, again);
+    ASSERT_EQ(interner.size(), 2u);
+    ASSERT_EQ(interner.channel(second), "d2p/sensor_reading/g/gateway/d/device1/r/H");
+}
+
+TEST_F(ChannelInterner, Given_ChannelNotInterned_When_Found_Then_ZeroIsReturned)
+{
+    // Given
+    const auto id = interner.intern("d2p/events/g/gateway/d/device1/r/A");
+    const std::string& channel = interner.channel(id);
+
+    // When
+    for (int i = 0; i < 1000; ++i)
+    {
+        interner.intern("channel" + std::to_string(i));
+    }
+
+    // Then
+    ASSERT_EQ(interner.find("d2p/events/g/gateway/d/device2/r/A"), 0u);
+    ASSERT_EQ(interner.find("d2p/events/g/gateway/d/device1/r/A"), id);
+    ASSERT_EQ(channel, "d2p/events/g/gateway/d/device1/r/A");
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "model/Message.h"
+#include "utilities/ChannelRoutingTable.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct Handler
+{
+};
+
+bool startsWith(const wolkabout::Message& message, const std::string& prefix)
+{
+    return message.getChannel().compare(0, prefix.size(), prefix) == 0;
+}
+
+class ChannelRoutingTable : public ::testing::Test
+{
+public:
+    using Table = wolkabout::ChannelRoutingTable<Handler>;
+
+    Table::Route route(const std::string& prefix, Handler* handler)
+    {
+        return Table::Route{[this, prefix](const wolkabout::Message& message) {
+                                ++predicateCalls;
+                                return startsWith(message, prefix);
+                            },
+                            handler};
+    }
+
+    Handler statusHandler;
+    Handler lastWillHandler;
+
+    int predicateCalls = 0;
+};
+}    // namespace
+
+TEST_F(ChannelRoutingTable, Given_SubscribedFilter_When_MessageIsRouted_Then_HandlerIsFoundWithoutPredicates)
+{
+    // Given
+    Table table{{"d2p/subdevice_status_response/d/+", "d2p/subdevice_status_update/d/#"},
+                {route("d2p/subdevice_status_response/", &statusHandler),
+                 route("d2p/subdevice_status_update/", &lastWillHandler)}};
+    predicateCalls = 0;
+
+    // When
+    Handler* response = table.route(wolkabout::Message{"", "d2p/subdevice_status_response/d/device1"});
+    Handler* update = table.route(wolkabout::Message{"", "d2p/subdevice_status_update/d/device1/extra"});
+
+    // Then
+    ASSERT_EQ(table.size(), 2u);
+    ASSERT_EQ(response, &statusHandler);
+    ASSERT_EQ(update, &lastWillHandler);
+    ASSERT_EQ(predicateCalls, 0);
+}
+
+TEST_F(ChannelRoutingTable, Given_ChannelOutsideFilters_When_MessageIsRouted_Then_PredicatesAreUsed)
+{
+    // Given
+    Table table{{"d2p/subdevice_status_update/d/+", "lastwill/#"},
+                {route("d2p/subdevice_status_update/", &statusHandler), route("lastwill", &lastWillHandler)}};
+
+    // When
+    Handler* lastWill = table.route(wolkabout::Message{"", "lastwill"});
+    Handler* unknown = table.route(wolkabout::Message{"", "d2p/sensor_reading/d/device1"});
+
+    // Then
+    ASSERT_EQ(lastWill, &lastWillHandler);
+    ASSERT_EQ(unknown, nullptr);
+}
+
+TEST_F(ChannelRoutingTable, Given_FilterWithWildcardMessageType_When_MessageIsRouted_Then_FirstMatchingRouteWins)
+{
+    // Given
+    Table table{{"d2p/#", "lastwill/#"},
+                {route("d2p/subdevice", &lastWillHandler), route("d2p/", &statusHandler)}};
+
+    // When
+    Handler* handler = table.route(wolkabout::Message{"", "d2p/subdevice_status_update/d/device1"});
+
+    // Then
+    ASSERT_EQ(table.size(), 0u);
+    ASSERT_EQ(handler, &lastWillHandler);
+}
+
+TEST_F(ChannelRoutingTable, Given_RouteWithoutHandler_When_MessageIsRouted_Then_NextMatchingRouteIsUsed)
+{
+    // Given
+    Table table{{"d2p/subdevice_status_update/d/+"},
+                {route("d2p/subdevice_status_update/", nullptr), route("d2p/", &statusHandler)}};
+
+    // When
+    Handler* handler = table.route(wolkabout::Message{"", "d2p/subdevice_status_update/d/device1"});
+
+    // Then
+    ASSERT_EQ(handler, &statusHandler);
+}
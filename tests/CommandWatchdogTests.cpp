@@ -0,0 +1,103 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/CommandWatchdog.h"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace
+{
+class CommandWatchdog : public ::testing::Test
+{
+public:
+    void SetUp() override { watchdog().configure(std::chrono::milliseconds{50}, true); }
+
+    void TearDown() override { watchdog().configure(std::chrono::milliseconds{0}); }
+
+    static wolkabout::CommandWatchdog& watchdog() { return wolkabout::CommandWatchdog::getInstance(); }
+};
+}    // namespace
+
+TEST_F(CommandWatchdog, Given_FastCommand_When_Run_Then_CommandIsExecutedAndNotReportedAsStalled)
+{
+    // Given
+    bool executed = false;
+    auto command = watchdog().track("test_fast", "origin", [&] { executed = true; });
+    const auto stalls = watchdog().getStallCount();
+
+    // When
+    command();
+
+    // Then
+    ASSERT_TRUE(executed);
+    ASSERT_EQ(watchdog().getStallCount(), stalls);
+}
+
+TEST_F(CommandWatchdog, Given_BlockingCommand_When_ThresholdIsExceeded_Then_StallIsReportedWhileCommandRuns)
+{
+    // Given
+    const auto stalls = watchdog().getStallCount();
+    std::uint64_t stallsWhileRunning = 0;
+    auto command = watchdog().track("test_blocking", "origin", [&] {
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{2};
+        while (watchdog().getStallCount() == stalls && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+        }
+        stallsWhileRunning = watchdog().getStallCount();
+    });
+
+    // When
+    command();
+
+    // Then
+    ASSERT_EQ(stallsWhileRunning, stalls + 1);
+    ASSERT_EQ(watchdog().getStallCount(), stalls + 1);
+}
+
+TEST_F(CommandWatchdog, Given_CommandQueuedPastThreshold_When_Dropped_Then_StallIsReportedOnce)
+{
+    // Given
+    const auto stalls = watchdog().getStallCount();
+    auto command = watchdog().track("test_queued", "origin", [] {});
+
+    // When
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+    command = nullptr;
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+
+    // Then
+    ASSERT_EQ(watchdog().getStallCount(), stalls + 1);
+}
+
+TEST_F(CommandWatchdog, Given_DisabledWatchdog_When_CommandIsTracked_Then_CommandIsRunUnchanged)
+{
+    // Given
+    watchdog().configure(std::chrono::milliseconds{0});
+    int calls = 0;
+
+    // When
+    auto command = watchdog().track("test_disabled", "", [&] { ++calls; });
+    command();
+
+    // Then
+    ASSERT_FALSE(watchdog().enabled());
+    ASSERT_EQ(calls, 1);
+}
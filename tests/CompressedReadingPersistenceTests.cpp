@@ -0,0 +1,136 @@
+#include "model/Message.h"
+#include "persistence/CompressedReadingPersistence.h"
+#include "persistence/inmemory/GatewayInMemoryPersistence.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class CompressedReadingPersistence : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        persistence.reset(new wolkabout::CompressedReadingPersistence(
+          std::unique_ptr<wolkabout::GatewayPersistence>(new wolkabout::GatewayInMemoryPersistence()),
+          [](const wolkabout::Message& message) { return message.getChannel().find("sensor_reading") == 0; }, 0,
+          3));
+    }
+
+    void push(const std::string& channel, const std::string& content)
+    {
+        ASSERT_TRUE(persistence->push(std::make_shared<wolkabout::Message>(content, channel)));
+    }
+
+    static std::string contents(const std::vector<std::shared_ptr<wolkabout::Message>>& messages)
+    {
+        std::string joined;
+        for (const auto& message : messages)
+        {
+            joined += message->getChannel() + " " + message->getContent() + "\n";
+        }
+
+        return joined;
+    }
+
+    std::unique_ptr<wolkabout::CompressedReadingPersistence> persistence;
+};
+}    // namespace
+
+TEST_F(CompressedReadingPersistence, Given_Readings_When_Drained_Then_ReadingsAreReplayedInBatchesPerChannel)
+{
+    // Given
+    push("sensor_reading/T", R"({"utc":1000,"data":"25.3"})");
+    push("sensor_reading/T", R"([{"utc":2000,"data":"25.3"},{"utc":3000,"data":"-0.5"}])");
+    push("sensor_reading/H", R"({"utc":1500,"data":"40"})");
+    push("sensor_reading/T", R"({"utc":2500,"data":"1e+300"})");
+    ASSERT_EQ(persistence->getReadingCount(), 5u);
+
+    // When
+    const auto batch = persistence->frontBatch(10);
+
+    // Then
+    ASSERT_EQ(contents(batch), "sensor_reading/T "
+                               R"([{"utc":1000,"data":"25.3"},{"utc":2000,"data":"25.3"},{"utc":3000,"data":"-0.5"}])"
+                               "\n"
+                               "sensor_reading/H "
+                               R"([{"utc":1500,"data":"40"}])"
+                               "\n"
+                               "sensor_reading/T "
+                               R"([{"utc":2500,"data":"1e+300"}])"
+                               "\n");
+    ASSERT_EQ(persistence->popBatch(batch.size()), 3u);
+    ASSERT_TRUE(persistence->empty());
+    ASSERT_EQ(persistence->pop(), nullptr);
+}
+
+TEST_F(CompressedReadingPersistence, Given_MessagesThatCannotBeCompressed_When_Drained_Then_TheyComeFirstUnchanged)
+{
+    // Given
+    push("sensor_reading/T", R"({"utc":1000,"data":"25.3"})");
+    push("sensor_reading/T", R"({"utc":2000,"data":"25.30"})");
+    push("sensor_reading/S", R"({"utc":2000,"data":"ON"})");
+    push("events/A", R"({"utc":2000,"data":"1"})");
+
+    // When
+    const auto first = persistence->pop();
+    const auto rest = persistence->frontBatch(10);
+
+    // Then
+    ASSERT_NE(first, nullptr);
+    ASSERT_EQ(first->getContent(), R"({"utc":2000,"data":"25.30"})");
+    ASSERT_EQ(contents(rest), "sensor_reading/S "
+                              R"({"utc":2000,"data":"ON"})"
+                              "\n"
+                              "events/A "
+                              R"({"utc":2000,"data":"1"})"
+                              "\n"
+                              "sensor_reading/T "
+                              R"([{"utc":1000,"data":"25.3"}])"
+                              "\n");
+    ASSERT_EQ(persistence->popBatch(2), 2u);
+    ASSERT_EQ(persistence->front()->getContent(), R"([{"utc":1000,"data":"25.3"}])");
+    ASSERT_EQ(persistence->popBatch(10), 1u);
+    ASSERT_TRUE(persistence->empty());
+}
+
+TEST_F(CompressedReadingPersistence, Given_RegularlySampledReadings_When_Pushed_Then_TheyTakeLessSpaceThanJson)
+{
+    // Given
+    persistence.reset(new wolkabout::CompressedReadingPersistence(
+      std::unique_ptr<wolkabout::GatewayPersistence>(new wolkabout::GatewayInMemoryPersistence()),
+      [](const wolkabout::Message&) { return true; }, 0));
+
+    std::size_t jsonBytes = 0;
+    std::vector<std::string> expected;
+    for (unsigned i = 0; i < 300; ++i)
+    {
+        const std::string content = "{\"utc\":" + std::to_string(1546300800000ull + i * 1000) + ",\"data\":\"" +
+                                    std::to_string(20 + i % 4) + ".5\"}";
+        jsonBytes += content.size();
+        expected.push_back(content);
+        push("sensor_reading/T", content);
+    }
+
+    // When
+    const auto compressedBytes = persistence->getCompressedBytes();
+    std::string replayed;
+    while (auto message = persistence->pop())
+    {
+        replayed += message->getContent();
+    }
+
+    std::string joined;
+    for (std::size_t i = 0; i < expected.size(); ++i)
+    {
+        joined += (i % 100 == 0 ? "[" : ",") + expected[i] + (i % 100 == 99 ? "]" : "");
+    }
+
+    // Then
+    ASSERT_LT(compressedBytes * 4, jsonBytes);
+    ASSERT_EQ(replayed, joined);
+    ASSERT_EQ(persistence->getCompressedBytes(), 0u);
+}
@@ -5,10 +5,14 @@
 #include "protocol/json/JsonProtocol.h"
 #include "repository/SQLiteDeviceRepository.h"
 #include "service/DataService.h"
+#include "utilities/Executor.h"
 
 #include <gtest/gtest.h>
 #include <cstdio>
+#include <fstream>
 #include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 
 namespace
@@ -27,11 +31,23 @@ private:
 class DeviceOutboundMessageHandler : public wolkabout::OutboundMessageHandler
 {
 public:
-    void addMessage(std::shared_ptr<wolkabout::Message> message) override { m_messages.push_back(message); }
+    void addMessage(std::shared_ptr<wolkabout::Message> message) override
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+        m_messages.push_back(message);
+    }
 
     const std::vector<std::shared_ptr<wolkabout::Message>>& getMessages() const { return m_messages; }
 
+    // for messages forwarded from executor while test is running
+    std::size_t getMessageCount() const
+    {
+        std::lock_guard<std::mutex> lg{m_lock};
+        return m_messages.size();
+    }
+
 private:
+    mutable std::mutex m_lock;
     std::vector<std::shared_ptr<wolkabout::Message>> m_messages;
 };
 
@@ -63,6 +79,8 @@ public:
     std::unique_ptr<wolkabout::DataService> dataService;
 
     static constexpr const char* DEVICE_REPOSITORY_PATH = "testsDeviceRepository.db";
+    static constexpr const char* TRANSFORMATION_RULE_FILE_PATH = "testsDataServiceTransformationRules.txt";
+    static constexpr const char* AGGREGATION_RULE_FILE_PATH = "testsDataServiceAggregationRules.txt";
     static constexpr const char* GATEWAY_KEY = "GATEWAY_KEY";
 };
 }    // namespace
@@ -227,3 +245,469 @@ TEST_F(DataService,
     ASSERT_TRUE(deviceOutboundMessageHandler->getMessages().empty());
     ASSERT_TRUE(platformOutboundMessageHandler->getMessages().empty());
 }
+
+TEST_F(DataService, Given_MessagePackDevice_When_MessageFromDeviceIsReceived_Then_JsonIsSentToPlatform)
+{
+    // Given
+    ON_CALL(*deviceRepository, findByDeviceKeyProxy("DEVICE_KEY"))
+      .WillByDefault(testing::ReturnNew<wolkabout::DetailedDevice>(
+        "", "DEVICE_KEY",
+        wolkabout::DeviceTemplate{{},
+                                  {wolkabout::SensorTemplate{"", "REF", wolkabout::DataType::NUMERIC, "", {0}, {100}}},
+                                  {},
+                                  {},
+                                  "",
+                                  {},
+                                  {{"payload_encoding", "msgpack"}},
+                                  {}}));
+
+    // When
+    const std::string payload{"\x81\xa4" "data" "\xa2" "42"};
+    auto message = std::make_shared<wolkabout::Message>(payload, "d2p/sensor_reading/d/DEVICE_KEY/r/REF");
+    dataService->deviceMessageReceived(message);
+
+    // Then
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().size(), 1);
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().front()->getContent(), "{\"data\":\"42\"}");
+}
+
+TEST_F(DataService, Given_ReadingAggregation_When_MaxReadingsAreReceived_Then_SingleMessageIsSentToPlatform)
+{
+    // Given
+    ON_CALL(*deviceRepository, findByDeviceKeyProxy("DEVICE_KEY"))
+      .WillByDefault(testing::ReturnNew<wolkabout::DetailedDevice>(
+        "", "DEVICE_KEY",
+        wolkabout::DeviceTemplate{{},
+                                  {wolkabout::SensorTemplate{"", "REF", wolkabout::DataType::NUMERIC, "", {0}, {100}}},
+                                  {},
+                                  {},
+                                  "",
+                                  {},
+                                  {},
+                                  {}}));
+    dataService->setReadingAggregation(std::chrono::milliseconds{0}, 3, nullptr);
+
+    // When
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("{\"utc\":1,\"data\":\"1\"}", "d2p/sensor_reading/d/DEVICE_KEY/r/REF"));
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("[{\"utc\":2,\"data\":\"2\"}]", "d2p/sensor_reading/d/DEVICE_KEY/r/REF"));
+    ASSERT_TRUE(platformOutboundMessageHandler->getMessages().empty());
+
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("{\"utc\":3,\"data\":\"3\"}", "d2p/sensor_reading/d/DEVICE_KEY/r/REF"));
+
+    // Then
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().size(), 1);
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().front()->getChannel(),
+              "d2p/sensor_reading/g/GATEWAY_KEY/d/DEVICE_KEY/r/REF");
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().front()->getContent(),
+              "[{\"utc\":1,\"data\":\"1\"},{\"utc\":2,\"data\":\"2\"},{\"utc\":3,\"data\":\"3\"}]");
+}
+
+TEST_F(DataService, Given_AggregatedReadings_When_AlarmIsReceived_Then_ReadingsAreSentBeforeAlarm)
+{
+    // Given
+    ON_CALL(*deviceRepository, findByDeviceKeyProxy("DEVICE_KEY"))
+      .WillByDefault(testing::ReturnNew<wolkabout::DetailedDevice>(
+        "", "DEVICE_KEY",
+        wolkabout::DeviceTemplate{{},
+                                  {wolkabout::SensorTemplate{"", "REF", wolkabout::DataType::NUMERIC, "", {0}, {100}}},
+                                  {wolkabout::AlarmTemplate{"", "ALM", ""}},
+                                  {},
+                                  "",
+                                  {},
+                                  {},
+                                  {}}));
+    dataService->setReadingAggregation(std::chrono::milliseconds{0}, 100, nullptr);
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("{\"utc\":1,\"data\":\"1\"}", "d2p/sensor_reading/d/DEVICE_KEY/r/REF"));
+
+    // When
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("{\"utc\":2,\"active\":true}", "d2p/events/d/DEVICE_KEY/r/ALM"));
+
+    // Then
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().size(), 2);
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().at(0)->getContent(), "[{\"utc\":1,\"data\":\"1\"}]");
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().at(1)->getChannel(),
+              "d2p/events/g/GATEWAY_KEY/d/DEVICE_KEY/r/ALM");
+}
+
+TEST_F(DataService, Given_DeadbandFilter_When_UnchangedReadingIsReceived_Then_ReadingIsNotSentToPlatform)
+{
+    // Given
+    ON_CALL(*deviceRepository, findByDeviceKeyProxy("DEVICE_KEY"))
+      .WillByDefault(testing::ReturnNew<wolkabout::DetailedDevice>(
+        "", "DEVICE_KEY",
+        wolkabout::DeviceTemplate{{},
+                                  {wolkabout::SensorTemplate{"", "REF", wolkabout::DataType::NUMERIC, "", {0}, {100}}},
+                                  {},
+                                  {},
+                                  "",
+                                  {},
+                                  {},
+                                  {}}));
+    dataService->setDeadbandFilter(std::unique_ptr<wolkabout::DeadbandFilter>(
+      new wolkabout::DeadbandFilter(5, std::chrono::milliseconds{0})));
+
+    // When
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("{\"data\":\"20\"}", "d2p/sensor_reading/d/DEVICE_KEY/r/REF"));
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("{\"data\":\"21\"}", "d2p/sensor_reading/d/DEVICE_KEY/r/REF"));
+
+    // Then
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().size(), 1);
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().front()->getContent(), "{\"data\":\"20\"}");
+}
+
+TEST_F(DataService, Given_ReadingTransformer_When_ReadingIsReceived_Then_TransformedReadingIsSentToPlatform)
+{
+    // Given
+    ON_CALL(*deviceRepository, findByDeviceKeyProxy("DEVICE_KEY"))
+      .WillByDefault(testing::ReturnNew<wolkabout::DetailedDevice>(
+        "", "DEVICE_KEY",
+        wolkabout::DeviceTemplate{{},
+                                  {wolkabout::SensorTemplate{"", "T", wolkabout::DataType::NUMERIC, "", {0}, {100}},
+                                   wolkabout::SensorTemplate{"", "P", wolkabout::DataType::NUMERIC, "", {0}, {100}}},
+                                  {},
+                                  {},
+                                  "",
+                                  {},
+                                  {},
+                                  {}}));
+    {
+        std::ofstream file{TRANSFORMATION_RULE_FILE_PATH};
+        file << "* T scale=10 rename=TEMP\n"
+             << "* P drop\n";
+    }
+
+    std::unique_ptr<wolkabout::ReadingTransformer> transformer{new wolkabout::ReadingTransformer()};
+    ASSERT_TRUE(transformer->loadRules(TRANSFORMATION_RULE_FILE_PATH));
+    std::remove(TRANSFORMATION_RULE_FILE_PATH);
+    dataService->setReadingTransformer(std::move(transformer));
+
+    // When
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("{\"data\":\"2\"}", "d2p/sensor_reading/d/DEVICE_KEY/r/T"));
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("{\"data\":\"3\"}", "d2p/sensor_reading/d/DEVICE_KEY/r/P"));
+
+    // Then
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().size(), 1);
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().front()->getChannel(),
+              "d2p/sensor_reading/g/GATEWAY_KEY/d/DEVICE_KEY/r/TEMP");
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().front()->getContent(), "{\"data\":\"20\"}");
+}
+
+TEST_F(DataService, Given_WindowedAggregator_When_ReadingsAreFlushed_Then_StatisticsAreSentToPlatform)
+{
+    // Given
+    ON_CALL(*deviceRepository, findByDeviceKeyProxy("DEVICE_KEY"))
+      .WillByDefault(testing::ReturnNew<wolkabout::DetailedDevice>(
+        "", "DEVICE_KEY",
+        wolkabout::DeviceTemplate{{},
+                                  {wolkabout::SensorTemplate{"", "VIB", wolkabout::DataType::NUMERIC, "", {0}, {100}}},
+                                  {},
+                                  {},
+                                  "",
+                                  {},
+                                  {},
+                                  {}}));
+    {
+        std::ofstream file{AGGREGATION_RULE_FILE_PATH};
+        file << "* VIB 60000 max=VIB_MAX\n";
+    }
+
+    wolkabout::Executor executor{1};
+    std::unique_ptr<wolkabout::WindowedAggregator> aggregator{new wolkabout::WindowedAggregator(executor)};
+    ASSERT_TRUE(aggregator->loadRules(AGGREGATION_RULE_FILE_PATH));
+    std::remove(AGGREGATION_RULE_FILE_PATH);
+    dataService->setWindowedAggregator(std::move(aggregator));
+
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("{\"data\":\"2\"}", "d2p/sensor_reading/d/DEVICE_KEY/r/VIB"));
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("{\"data\":\"5\"}", "d2p/sensor_reading/d/DEVICE_KEY/r/VIB"));
+    ASSERT_TRUE(platformOutboundMessageHandler->getMessages().empty());
+
+    // When
+    dataService->flushReadings();
+
+    // Then
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().size(), 1);
+    ASSERT_EQ(platformOutboundMessageHandler->getMessages().front()->getChannel(),
+              "d2p/sensor_reading/g/GATEWAY_KEY/d/DEVICE_KEY/r/VIB_MAX");
+    const auto& content = platformOutboundMessageHandler->getMessages().front()->getContent();
+    ASSERT_EQ(content.substr(content.find("\"data\"")), "\"data\":\"5\"}");
+
+    // aggregator uses executor of this test
+    dataService.reset();
+}
+
+TEST_F(DataService, Given_RegisteredDevices_When_MessagesFromDevicesAreReceived_Then_ChannelsAreRoutedWithPrefixes)
+{
+    // Given
+    for (const std::string deviceKey : {"DEVICE_KEY", "DEVICE_KEY2"})
+    {
+        ON_CALL(*deviceRepository, findByDeviceKeyProxy(deviceKey))
+          .WillByDefault(testing::ReturnNew<wolkabout::DetailedDevice>(
+            "", deviceKey,
+            wolkabout::DeviceTemplate{
+              {},
+              {wolkabout::SensorTemplate{"", "REF", wolkabout::DataType::NUMERIC, "", {0}, {100}}},
+              {},
+              {},
+              "",
+              {},
+              {},
+              {}}));
+    }
+    dataService->addDevice("DEVICE_KEY");
+
+    // When
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("", "d2p/sensor_reading/d/DEVICE_KEY/r/REF"));
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("", "d2p/sensor_reading/d/DEVICE_KEY2/r/REF"));
+    dataService->deviceMessageReceived(std::make_shared<wolkabout::Message>("", "d2p/configuration_get/d/DEVICE_KEY"));
+    dataService->removeDevice("DEVICE_KEY");
+    dataService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("", "d2p/sensor_reading/d/DEVICE_KEY/r/REF"));
+
+    // Then
+    const auto& messages = platformOutboundMessageHandler->getMessages();
+    ASSERT_EQ(messages.size(), 4);
+    ASSERT_EQ(messages[0]->getChannel(), "d2p/sensor_reading/g/GATEWAY_KEY/d/DEVICE_KEY/r/REF");
+    ASSERT_EQ(messages[1]->getChannel(), "d2p/sensor_reading/g/GATEWAY_KEY/d/DEVICE_KEY2/r/REF");
+    ASSERT_EQ(messages[2]->getChannel(), "d2p/configuration_get/g/GATEWAY_KEY/d/DEVICE_KEY");
+    ASSERT_EQ(messages[3]->getChannel(), "d2p/sensor_reading/g/GATEWAY_KEY/d/DEVICE_KEY/r/REF");
+}
+
+TEST_F(DataService, Given_RegisteredDevice_When_MessagesFromPlatformAreReceived_Then_ChannelsAreRoutedWithPrefixes)
+{
+    // Given
+    dataService->addDevice("DEVICE_KEY");
+
+    // When
+    dataService->platformMessageReceived(
+      std::make_shared<wolkabout::Message>("", "p2d/actuator_set/g/GATEWAY_KEY/d/DEVICE_KEY/r/REF"));
+    dataService->platformMessageReceived(
+      std::make_shared<wolkabout::Message>("", "p2d/actuator_set/g/GATEWAY_KEY/d/DEVICE_KEY/r/REF2"));
+    dataService->platformMessageReceived(
+      std::make_shared<wolkabout::Message>("", "p2d/actuator_set/g/GATEWAY_KEY/d/DEVICE_KEY2/r/REF"));
+    dataService->platformMessageReceived(
+      std::make_shared<wolkabout::Message>("", "p2d/configuration_set/g/GATEWAY_KEY/d/DEVICE_KEY"));
+
+    // Then
+    const auto& messages = deviceOutboundMessageHandler->getMessages();
+    ASSERT_EQ(messages.size(), 4);
+    ASSERT_EQ(messages[0]->getChannel(), "p2d/actuator_set/d/DEVICE_KEY/r/REF");
+    ASSERT_EQ(messages[1]->getChannel(), "p2d/actuator_set/d/DEVICE_KEY/r/REF2");
+    ASSERT_EQ(messages[2]->getChannel(), "p2d/actuator_set/d/DEVICE_KEY2/r/REF");
+    ASSERT_EQ(messages[3]->getChannel(), "p2d/configuration_set/d/DEVICE_KEY");
+}
+
+TEST_F(DataService, Given_ActuationCoalescing_When_CommandsArriveWithinInterval_Then_OnlyLatestCommandIsForwarded)
+{
+    // Given
+    wolkabout::Executor executor;
+    dataService->setActuationCoalescing(std::chrono::milliseconds{60000}, &executor);
+
+    // When
+    for (const auto& value : {"1", "2", "3"})
+    {
+        dataService->platformMessageReceived(std::make_shared<wolkabout::Message>(
+          std::string("{\"value\":\"") + value + "\"}", "p2d/actuator_set/g/GATEWAY_KEY/d/DEVICE_KEY/r/SL"));
+    }
+    dataService->platformMessageReceived(std::make_shared<wolkabout::Message>(
+      "{\"value\":\"true\"}", "p2d/actuator_set/g/GATEWAY_KEY/d/DEVICE_KEY/r/SW"));
+
+    ASSERT_EQ(deviceOutboundMessageHandler->getMessages().size(), 2);
+
+    // held command is still delivered on shutdown
+    dataService.reset();
+
+    // Then
+    const auto& messages = deviceOutboundMessageHandler->getMessages();
+    ASSERT_EQ(messages.size(), 3);
+    ASSERT_EQ(messages[0]->getChannel(), "p2d/actuator_set/d/DEVICE_KEY/r/SL");
+    ASSERT_EQ(messages[0]->getContent(), "{\"value\":\"1\"}");
+    ASSERT_EQ(messages[1]->getChannel(), "p2d/actuator_set/d/DEVICE_KEY/r/SW");
+    ASSERT_EQ(messages[2]->getChannel(), "p2d/actuator_set/d/DEVICE_KEY/r/SL");
+    ASSERT_EQ(messages[2]->getContent(), "{\"value\":\"3\"}");
+}
+
+TEST_F(DataService, Given_DeviceStateCache_When_PlatformRequestsActuatorStatus_Then_CachedStatusIsSentToPlatform)
+{
+    // Given
+    ON_CALL(*deviceRepository, findByDeviceKeyProxy("DEVICE_KEY"))
+      .WillByDefault(testing::ReturnNew<wolkabout::DetailedDevice>(
+        "", "DEVICE_KEY",
+        wolkabout::DeviceTemplate{{},
+                                  {},
+                                  {},
+                                  {wolkabout::ActuatorTemplate{"", "SW", "SWITCH(ACTUATOR)", "", "", {0}, {1}}},
+                                  "",
+                                  {},
+                                  {},
+                                  {}}));
+    dataService->setDeviceStateCache(std::chrono::milliseconds{60000});
+
+    dataService->deviceMessageReceived(std::make_shared<wolkabout::Message>(
+      "{\"status\":\"READY\",\"value\":\"true\"}", "d2p/actuator_status/d/DEVICE_KEY/r/SW"));
+
+    // When
+    dataService->platformMessageReceived(
+      std::make_shared<wolkabout::Message>("", "p2d/actuator_get/g/GATEWAY_KEY/d/DEVICE_KEY/r/SW"));
+    dataService->requestActuatorStatusesForDevice("DEVICE_KEY");
+
+    // Then
+    ASSERT_TRUE(deviceOutboundMessageHandler->getMessages().empty());
+
+    const auto& messages = platformOutboundMessageHandler->getMessages();
+    ASSERT_EQ(messages.size(), 3);
+    for (const auto& message : messages)
+    {
+        ASSERT_EQ(message->getChannel(), "d2p/actuator_status/g/GATEWAY_KEY/d/DEVICE_KEY/r/SW");
+        ASSERT_EQ(message->getContent(), "{\"status\":\"READY\",\"value\":\"true\"}");
+    }
+}
+
+TEST_F(DataService, Given_NoCachedStatus_When_ActuatorStatusesAreRequested_Then_DeviceIsQueried)
+{
+    // Given
+    ON_CALL(*deviceRepository, findByDeviceKeyProxy("DEVICE_KEY"))
+      .WillByDefault(testing::ReturnNew<wolkabout::DetailedDevice>(
+        "", "DEVICE_KEY",
+        wolkabout::DeviceTemplate{{},
+                                  {},
+                                  {},
+                                  {wolkabout::ActuatorTemplate{"", "SW", "SWITCH(ACTUATOR)", "", "", {0}, {1}}},
+                                  "",
+                                  {},
+                                  {},
+                                  {}}));
+    dataService->setDeviceStateCache(std::chrono::milliseconds{60000});
+
+    // When
+    dataService->requestActuatorStatusesForDevice("DEVICE_KEY");
+
+    // Then
+    ASSERT_TRUE(platformOutboundMessageHandler->getMessages().empty());
+    ASSERT_EQ(deviceOutboundMessageHandler->getMessages().size(), 1);
+    ASSERT_EQ(deviceOutboundMessageHandler->getMessages().front()->getChannel(), "p2d/actuator_get/d/DEVICE_KEY/r/SW");
+}
+
+TEST_F(DataService, Given_BulkActuatorStatusRequests_When_ActuatorStatusesAreRequested_Then_DeviceIsQueriedOnce)
+{
+    // Given
+    ON_CALL(*deviceRepository, findByDeviceKeyProxy("DEVICE_KEY"))
+      .WillByDefault(testing::ReturnNew<wolkabout::DetailedDevice>(
+        "", "DEVICE_KEY",
+        wolkabout::DeviceTemplate{{},
+                                  {},
+                                  {},
+                                  {wolkabout::ActuatorTemplate{"", "SW", "SWITCH(ACTUATOR)", "", "", {0}, {1}},
+                                   wolkabout::ActuatorTemplate{"", "SL", "SLIDER(ACTUATOR)", "", "", {0}, {100}}},
+                                  "",
+                                  {},
+                                  {},
+                                  {}}));
+    dataService->setBulkActuatorStatusRequests(true);
+
+    // When
+    dataService->requestActuatorStatusesForDevice("DEVICE_KEY");
+
+    // Then
+    ASSERT_EQ(deviceOutboundMessageHandler->getMessages().size(), 1);
+    ASSERT_EQ(deviceOutboundMessageHandler->getMessages().front()->getChannel(), "p2d/actuator_get/d/DEVICE_KEY");
+}
+
+TEST_F(DataService, Given_ActuatorStatusBatch_When_DeviceMessageIsReceived_Then_StatusesAreSentPerReference)
+{
+    // Given
+    ON_CALL(*deviceRepository, findByDeviceKeyProxy("DEVICE_KEY"))
+      .WillByDefault(testing::ReturnNew<wolkabout::DetailedDevice>(
+        "", "DEVICE_KEY",
+        wolkabout::DeviceTemplate{{},
+                                  {},
+                                  {},
+                                  {wolkabout::ActuatorTemplate{"", "SW", "SWITCH(ACTUATOR)", "", "", {0}, {1}}},
+                                  "",
+                                  {},
+                                  {},
+                                  {}}));
+
+    // When
+    dataService->deviceMessageReceived(std::make_shared<wolkabout::Message>(
+      "[{\"reference\":\"SW\",\"status\":\"READY\",\"value\":\"true\"},{\"reference\":\"XX\",\"status\":\"READY\"}]",
+      "d2p/actuator_status/d/DEVICE_KEY"));
+
+    // Then
+    const auto& messages = platformOutboundMessageHandler->getMessages();
+    ASSERT_EQ(messages.size(), 1);
+    ASSERT_EQ(messages.front()->getChannel(), "d2p/actuator_status/g/GATEWAY_KEY/d/DEVICE_KEY/r/SW");
+    ASSERT_EQ(messages.front()->getContent(), "{\"status\":\"READY\",\"value\":\"true\"}");
+}
+
+TEST_F(DataService, Given_ConfigurationCoalescing_When_RequestsArriveWithinWindow_Then_OneMergedRequestIsForwarded)
+{
+    // Given
+    wolkabout::Executor executor;
+    dataService->setConfigurationCoalescing(std::chrono::milliseconds{60000}, std::chrono::milliseconds{0},
+                                            &executor);
+
+    // When
+    dataService->platformMessageReceived(std::make_shared<wolkabout::Message>(
+      "{\"values\":{\"HB\":\"10\",\"LL\":\"INFO\"}}", "p2d/configuration_set/g/GATEWAY_KEY/d/DEVICE_KEY"));
+    dataService->platformMessageReceived(std::make_shared<wolkabout::Message>(
+      "{\"values\":{\"HB\":\"30\"}}", "p2d/configuration_set/g/GATEWAY_KEY/d/DEVICE_KEY"));
+    dataService->platformMessageReceived(std::make_shared<wolkabout::Message>(
+      "{\"values\":{\"HB\":\"5\"}}", "p2d/configuration_set/g/GATEWAY_KEY/d/OTHER_KEY"));
+
+    ASSERT_TRUE(deviceOutboundMessageHandler->getMessages().empty());
+
+    // held requests are still delivered on shutdown
+    dataService.reset();
+
+    // Then
+    const auto& messages = deviceOutboundMessageHandler->getMessages();
+    ASSERT_EQ(messages.size(), 2);
+    ASSERT_EQ(messages[0]->getChannel(), "p2d/configuration_set/d/DEVICE_KEY");
+    ASSERT_EQ(messages[0]->getContent(), "{\"values\":{\"HB\":\"30\",\"LL\":\"INFO\"}}");
+    ASSERT_EQ(messages[1]->getChannel(), "p2d/configuration_set/d/OTHER_KEY");
+    ASSERT_EQ(messages[1]->getContent(), "{\"values\":{\"HB\":\"5\"}}");
+}
+
+TEST_F(DataService, Given_ConfigurationPacing_When_RequestsForSeveralDevicesArrive_Then_TheyAreForwardedOneByOne)
+{
+    // Given
+    wolkabout::Executor executor;
+    dataService->setConfigurationCoalescing(std::chrono::milliseconds{0}, std::chrono::milliseconds{60000},
+                                            &executor);
+
+    // When
+    for (const auto& deviceKey : {"DEVICE1", "DEVICE2", "DEVICE3"})
+    {
+        dataService->platformMessageReceived(std::make_shared<wolkabout::Message>(
+          "{\"values\":{\"HB\":\"10\"}}", std::string("p2d/configuration_set/g/GATEWAY_KEY/d/") + deviceKey));
+    }
+
+    // Then
+    for (int i = 0; i < 100 && deviceOutboundMessageHandler->getMessageCount() == 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    ASSERT_EQ(deviceOutboundMessageHandler->getMessageCount(), 1u);
+
+    dataService.reset();
+
+    const auto& messages = deviceOutboundMessageHandler->getMessages();
+    ASSERT_EQ(messages.size(), 3);
+    ASSERT_EQ(messages[0]->getChannel(), "p2d/configuration_set/d/DEVICE1");
+    ASSERT_EQ(messages[1]->getChannel(), "p2d/configuration_set/d/DEVICE2");
+    ASSERT_EQ(messages[2]->getChannel(), "p2d/configuration_set/d/DEVICE3");
+}
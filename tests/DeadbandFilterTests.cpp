@@ -0,0 +1,118 @@
+#include "service/DeadbandFilter.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+namespace
+{
+class DeadbandFilter : public ::testing::Test
+{
+public:
+    void TearDown() override { std::remove(OVERRIDE_FILE_PATH); }
+
+    static constexpr const char* OVERRIDE_FILE_PATH = "testsDeadbandOverrides.txt";
+};
+}    // namespace
+
+TEST_F(DeadbandFilter, Given_PercentageOfRange_When_ReadingIsWithinBand_Then_ReadingIsDropped)
+{
+    // Given
+    wolkabout::DeadbandFilter filter{5, std::chrono::milliseconds{0}};
+    ASSERT_TRUE(filter.accept("DEVICE_KEY", "T", 100, "{\"data\":\"20\"}"));
+
+    // When
+    const bool withinBand = filter.accept("DEVICE_KEY", "T", 100, "{\"utc\":1,\"data\":\"24.5\"}");
+    const bool outsideBand = filter.accept("DEVICE_KEY", "T", 100, "{\"data\":\"25.5\"}");
+
+    // Then
+    ASSERT_FALSE(withinBand);
+    ASSERT_TRUE(outsideBand);
+    ASSERT_TRUE(filter.accept("DEVICE_KEY", "T", 0, "{\"data\":\"25.5\"}"));
+    ASSERT_TRUE(filter.accept("DEVICE_KEY", "T", 100, "{\"data\":\"25.5,1\"}"));
+}
+
+TEST_F(DeadbandFilter, Given_MaxSilence_When_IntervalPasses_Then_UnchangedReadingIsForwarded)
+{
+    // Given
+    wolkabout::DeadbandFilter filter{10, std::chrono::milliseconds{20}};
+    ASSERT_TRUE(filter.accept("DEVICE_KEY", "T", 100, "{\"data\":\"20\"}"));
+    ASSERT_FALSE(filter.accept("DEVICE_KEY", "T", 100, "{\"data\":\"20\"}"));
+
+    // When
+    std::this_thread::sleep_for(std::chrono::milliseconds{30});
+
+    // Then
+    ASSERT_TRUE(filter.accept("DEVICE_KEY", "T", 100, "{\"data\":\"20\"}"));
+    ASSERT_FALSE(filter.accept("DEVICE_KEY", "T", 100, "{\"data\":\"20\"}"));
+}
+
+TEST_F(DeadbandFilter, Given_OverrideFile_When_Loaded_Then_OverridesTakePrecedence)
+{
+    // Given
+    {
+        std::ofstream file{OVERRIDE_FILE_PATH};
+        file << "# device reference band\n"
+             << "\n"
+             << "* T 1\n"
+             << "DEVICE_KEY T 50%\n";
+    }
+
+    wolkabout::DeadbandFilter filter{0, std::chrono::milliseconds{0}};
+
+    // When
+    ASSERT_TRUE(filter.loadOverrides(OVERRIDE_FILE_PATH));
+
+    // Then
+    ASSERT_TRUE(filter.accept("DEVICE_KEY", "T", 10, "{\"data\":\"0\"}"));
+    ASSERT_FALSE(filter.accept("DEVICE_KEY", "T", 10, "{\"data\":\"4\"}"));
+    ASSERT_TRUE(filter.accept("OTHER_KEY", "T", 10, "{\"data\":\"0\"}"));
+    ASSERT_TRUE(filter.accept("OTHER_KEY", "T", 10, "{\"data\":\"2\"}"));
+    ASSERT_TRUE(filter.accept("OTHER_KEY", "P", 10, "{\"data\":\"2\"}"));
+    ASSERT_TRUE(filter.accept("OTHER_KEY", "P", 10, "{\"data\":\"2\"}"));
+}
+
+TEST_F(DeadbandFilter, Given_InvalidOverrideFile_When_Loaded_Then_LoadingFails)
+{
+    // Given
+    {
+        std::ofstream file{OVERRIDE_FILE_PATH};
+        file << "DEVICE_KEY T 5\n"
+             << "DEVICE_KEY P\n";
+    }
+
+    wolkabout::DeadbandFilter filter{0, std::chrono::milliseconds{0}};
+
+    // Then
+    ASSERT_FALSE(filter.loadOverrides(OVERRIDE_FILE_PATH));
+    ASSERT_FALSE(filter.loadOverrides("missingDeadbandOverrides.txt"));
+    ASSERT_TRUE(filter.accept("DEVICE_KEY", "T", 10, "{\"data\":\"0\"}"));
+    ASSERT_TRUE(filter.accept("DEVICE_KEY", "T", 10, "{\"data\":\"1\"}"));
+}
+
+TEST_F(DeadbandFilter, Given_LoadedOverrides_When_FileIsReloaded_Then_NewOverridesReplaceOldOnes)
+{
+    // Given
+    {
+        std::ofstream file{OVERRIDE_FILE_PATH};
+        file << "DEVICE_KEY T 5\n";
+    }
+
+    wolkabout::DeadbandFilter filter{0, std::chrono::milliseconds{0}};
+    ASSERT_TRUE(filter.loadOverrides(OVERRIDE_FILE_PATH));
+    ASSERT_TRUE(filter.accept("DEVICE_KEY", "T", 10, "{\"data\":\"0\"}"));
+    ASSERT_FALSE(filter.accept("DEVICE_KEY", "T", 10, "{\"data\":\"1\"}"));
+
+    // When
+    {
+        std::ofstream file{OVERRIDE_FILE_PATH};
+        file << "DEVICE_KEY P 5\n";
+    }
+
+    ASSERT_TRUE(filter.loadOverrides(OVERRIDE_FILE_PATH));
+
+    // Then
+    ASSERT_TRUE(filter.accept("DEVICE_KEY", "T", 10, "{\"data\":\"1\"}"));
+}
@@ -0,0 +1,74 @@
+#include "utilities/Deflate.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace
+{
+class Deflate : public ::testing::Test
+{
+};
+
+std::string makeReadings(unsigned count)
+{
+    std::string readings = "[";
+    for (unsigned i = 0; i < count; ++i)
+    {
+        readings += (i ? ",{\"utc\":" : "{\"utc\":") + std::to_string(1546300800000ull + i * 1000) + ",\"data\":\"" +
+                    std::to_string(20 + i % 7) + ".5\"}";
+    }
+
+    return readings + "]";
+}
+}    // namespace
+
+TEST_F(Deflate, Given_Readings_When_CompressedWithDictionary_Then_DecompressedPayloadIsEqual)
+{
+    // Given
+    const std::string readings = makeReadings(50);
+
+    // When
+    std::string compressed;
+    ASSERT_TRUE(wolkabout::Deflate::compress(readings, wolkabout::Deflate::READING_DICTIONARY, compressed));
+
+    // Then
+    ASSERT_LT(compressed.size(), readings.size() / 3);
+    ASSERT_EQ(static_cast<unsigned char>(compressed[0]), 0x78);
+
+    std::string decompressed;
+    ASSERT_TRUE(wolkabout::Deflate::decompress(compressed, wolkabout::Deflate::READING_DICTIONARY, decompressed));
+    ASSERT_EQ(decompressed, readings);
+}
+
+TEST_F(Deflate, Given_SmallReading_When_CompressedWithDictionary_Then_PayloadIsSmallerThanWithout)
+{
+    // Given
+    const std::string reading = "[{\"utc\":1546300800000,\"data\":\"21.5\"},{\"utc\":1546300801000,\"data\":\"21.7\"}]";
+
+    // When
+    std::string withDictionary;
+    std::string withoutDictionary;
+    ASSERT_TRUE(wolkabout::Deflate::compress(reading, wolkabout::Deflate::READING_DICTIONARY, withDictionary));
+    ASSERT_TRUE(wolkabout::Deflate::compress(reading, "", withoutDictionary));
+
+    // Then
+    ASSERT_LT(withDictionary.size(), withoutDictionary.size());
+
+    std::string decompressed;
+    ASSERT_TRUE(wolkabout::Deflate::decompress(withoutDictionary, "", decompressed));
+    ASSERT_EQ(decompressed, reading);
+}
+
+TEST_F(Deflate, Given_InvalidStream_When_Decompressed_Then_DecompressionFails)
+{
+    // Given
+    std::string compressed;
+    ASSERT_TRUE(wolkabout::Deflate::compress(makeReadings(10), wolkabout::Deflate::READING_DICTIONARY, compressed));
+
+    // Then
+    std::string decompressed;
+    ASSERT_FALSE(wolkabout::Deflate::decompress(compressed, "", decompressed));
+    ASSERT_FALSE(wolkabout::Deflate::decompress(compressed.substr(0, compressed.size() / 2),
+                                                wolkabout::Deflate::READING_DICTIONARY, decompressed));
+    ASSERT_FALSE(wolkabout::Deflate::decompress("{\"data\":\"1\"}", "", decompressed));
+}
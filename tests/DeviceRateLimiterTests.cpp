@@ -0,0 +1,128 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/DeviceRateLimiter.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+class DeviceRateLimiter : public ::testing::Test
+{
+public:
+    // 10 messages per second with burst of 5, quarantine after 1 second of flooding, for 5 seconds
+    wolkabout::DeviceRateLimiter limiter{10, 5, std::chrono::seconds{1}, std::chrono::seconds{5}};
+
+    const wolkabout::DeviceRateLimiter::Clock::time_point start = wolkabout::DeviceRateLimiter::Clock::now();
+
+    std::size_t send(const std::string& deviceKey, std::size_t count,
+                     wolkabout::DeviceRateLimiter::Clock::time_point now)
+    {
+        std::size_t allowed = 0;
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (limiter.allow(deviceKey, now))
+            {
+                ++allowed;
+            }
+        }
+
+        return allowed;
+    }
+};
+}    // namespace
+
+TEST_F(DeviceRateLimiter, Given_Burst_When_DeviceExceedsIt_Then_ExtraMessagesAreDroppedAndCounted)
+{
+    // When
+    const auto allowed = send("DEVICE_1", 8, start);
+
+    // Then
+    ASSERT_EQ(allowed, 5u);
+    ASSERT_EQ(limiter.droppedMessages().at("DEVICE_1"), 3u);
+
+    ASSERT_TRUE(limiter.allow("DEVICE_1", start + std::chrono::milliseconds{100}));
+    ASSERT_FALSE(limiter.allow("DEVICE_1", start + std::chrono::milliseconds{100}));
+}
+
+TEST_F(DeviceRateLimiter, Given_FloodingDevice_When_OtherDeviceSends_Then_OtherDeviceIsNotLimited)
+{
+    // Given
+    send("FLOODING", 100, start);
+
+    // When
+    const auto allowed = send("QUIET", 5, start);
+
+    // Then
+    ASSERT_EQ(allowed, 5u);
+    ASSERT_EQ(limiter.droppedMessages().count("QUIET"), 0u);
+}
+
+TEST_F(DeviceRateLimiter, Given_DeviceOverLimit_When_ItKeepsFlooding_Then_ItIsQuarantinedAndLaterReleased)
+{
+    // Given
+    std::vector<std::pair<std::string, bool>> events;
+    limiter.setQuarantineListener(
+      [&](const std::string& deviceKey, bool quarantined) { events.emplace_back(deviceKey, quarantined); });
+
+    // When
+    for (int i = 0; i <= 12; ++i)
+    {
+        send("DEVICE_1", 20, start + std::chrono::milliseconds{100 * i});
+    }
+
+    // Then
+    ASSERT_TRUE(limiter.isQuarantined("DEVICE_1"));
+    ASSERT_EQ(events, (std::vector<std::pair<std::string, bool>>{{"DEVICE_1", true}}));
+
+    // tokens are not refilled during quarantine
+    ASSERT_FALSE(limiter.allow("DEVICE_1", start + std::chrono::seconds{4}));
+
+    ASSERT_TRUE(limiter.allow("DEVICE_1", start + std::chrono::seconds{7}));
+    ASSERT_FALSE(limiter.isQuarantined("DEVICE_1"));
+    ASSERT_EQ(events.back(), std::make_pair(std::string{"DEVICE_1"}, false));
+}
+
+TEST_F(DeviceRateLimiter, Given_DeviceOverLimit_When_ItCalmsDownBeforeQuarantine_Then_ItIsNotQuarantined)
+{
+    // Given
+    send("DEVICE_1", 10, start);
+
+    // When
+    send("DEVICE_1", 1, start + std::chrono::milliseconds{600});
+    send("DEVICE_1", 10, start + std::chrono::milliseconds{1200});
+
+    // Then
+    ASSERT_FALSE(limiter.isQuarantined("DEVICE_1"));
+}
+
+TEST_F(DeviceRateLimiter, Given_FullBucket_When_RateIsLowered_Then_NewBurstApplies)
+{
+    // Given
+    send("DEVICE_1", 1, start);
+
+    // When
+    limiter.setRate(1, 2);
+
+    // Then
+    ASSERT_EQ(send("DEVICE_1", 5, start), 2u);
+    ASSERT_EQ(send("DEVICE_1", 5, start + std::chrono::milliseconds{500}), 0u);
+    ASSERT_EQ(send("DEVICE_1", 5, start + std::chrono::seconds{1}), 1u);
+}
@@ -12,12 +12,16 @@
 #include "repository/SQLiteDeviceRepository.h"
 #include "service/GatewayUpdateService.h"
 #include "service/SubdeviceRegistrationService.h"
+#include "utilities/Executor.h"
 
 #include <gtest/gtest.h>
+#include <chrono>
 #include <cstdio>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace
@@ -33,14 +37,24 @@ private:
     std::vector<std::shared_ptr<wolkabout::Message>> m_messages;
 };
 
+// registration responses are sent from executor thread once accepted devices are saved
 class DeviceOutboundMessageHandler : public wolkabout::OutboundMessageHandler
 {
 public:
-    void addMessage(std::shared_ptr<wolkabout::Message> message) override { m_messages.push_back(message); }
+    void addMessage(std::shared_ptr<wolkabout::Message> message) override
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        m_messages.push_back(message);
+    }
 
-    const std::vector<std::shared_ptr<wolkabout::Message>>& getMessages() const { return m_messages; }
+    std::vector<std::shared_ptr<wolkabout::Message>> getMessages() const
+    {
+        std::lock_guard<std::mutex> lock{m_lock};
+        return m_messages;
+    }
 
 private:
+    mutable std::mutex m_lock;
     std::vector<std::shared_ptr<wolkabout::Message>> m_messages;
 };
 
@@ -57,11 +71,13 @@ public:
           std::unique_ptr<PlatformOutboundMessageHandler>(new PlatformOutboundMessageHandler());
         deviceOutboundMessageHandler =
           std::unique_ptr<DeviceOutboundMessageHandler>(new DeviceOutboundMessageHandler());
-        deviceRegistrationService = std::unique_ptr<wolkabout::SubdeviceRegistrationService>(
-          new wolkabout::SubdeviceRegistrationService(GATEWAY_KEY, *protocol, *gatewayProtocol, *deviceRepository,
-                                                      *platformOutboundMessageHandler, *deviceOutboundMessageHandler));
+        executor = std::unique_ptr<wolkabout::Executor>(new wolkabout::Executor());
+        deviceRegistrationService =
+          std::unique_ptr<wolkabout::SubdeviceRegistrationService>(new wolkabout::SubdeviceRegistrationService(
+            GATEWAY_KEY, *protocol, *gatewayProtocol, *deviceRepository, *platformOutboundMessageHandler,
+            *deviceOutboundMessageHandler, *executor));
         gatewayUpdateService = std::unique_ptr<wolkabout::GatewayUpdateService>(new wolkabout::GatewayUpdateService(
-          GATEWAY_KEY, *protocol, *deviceRepository, *platformOutboundMessageHandler));
+          GATEWAY_KEY, *protocol, *deviceRepository, *platformOutboundMessageHandler, *executor));
     }
 
     void TearDown() override { remove(DEVICE_REPOSITORY_PATH); }
@@ -71,6 +87,7 @@ public:
     std::unique_ptr<wolkabout::SQLiteDeviceRepository> deviceRepository;
     std::unique_ptr<PlatformOutboundMessageHandler> platformOutboundMessageHandler;
     std::unique_ptr<DeviceOutboundMessageHandler> deviceOutboundMessageHandler;
+    std::unique_ptr<wolkabout::Executor> executor;
     std::unique_ptr<wolkabout::SubdeviceRegistrationService> deviceRegistrationService;
     std::unique_ptr<wolkabout::GatewayUpdateService> gatewayUpdateService;
 
@@ -160,6 +177,29 @@ TEST_F(
     ASSERT_TRUE(platformOutboundMessageHandler->getMessages().empty());
 }
 
+TEST_F(SubdeviceRegistrationService,
+       Given_RegisteredDevice_When_RequestIsRepeatedUnchanged_Then_DeviceIsAnsweredWithoutPlatformRoundTrip)
+{
+    // Given
+    wolkabout::GatewayDevice gateway(GATEWAY_KEY, "", wolkabout::SubdeviceManagement::GATEWAY, true, true);
+    deviceRepository->save(gateway);
+
+    const std::string deviceKey("device_key");
+    wolkabout::DeviceTemplate deviceTemplate;
+    deviceTemplate.addSensor(wolkabout::SensorTemplate("Sensor name", "ref", wolkabout::DataType::STRING, "", {}, {}));
+    deviceRepository->save(wolkabout::DetailedDevice("Device name", deviceKey, deviceTemplate));
+
+    // When
+    wolkabout::SubdeviceRegistrationRequest deviceRegistrationRequest("Device name", deviceKey, deviceTemplate);
+    deviceRegistrationService->deviceMessageReceived(protocol->makeMessage(GATEWAY_KEY, deviceRegistrationRequest));
+    deviceRegistrationService->deviceMessageReceived(protocol->makeMessage(GATEWAY_KEY, deviceRegistrationRequest));
+
+    // Then
+    ASSERT_TRUE(platformOutboundMessageHandler->getMessages().empty());
+    ASSERT_EQ(2, deviceOutboundMessageHandler->getMessages().size());
+    ASSERT_NE(deviceOutboundMessageHandler->getMessages()[0]->getContent().find("OK"), std::string::npos);
+}
+
 TEST_F(
   SubdeviceRegistrationService,
   Given_ThatDeviceIsRegistered_When_AlreadyRegisteredDeviceRequestsRegistrationWithDifferentTemplate_Then_RegistrationRequestIsForwardedToPlatform)
@@ -366,6 +406,29 @@ TEST_F(SubdeviceRegistrationService,
     ASSERT_FALSE(deviceRepository->containsDeviceWithKey(childDeviceKey));
 }
 
+TEST_F(SubdeviceRegistrationService,
+       Given_ManyRegisteredChildDevices_When_DevicesOtherThanSomeAreDeleted_Then_OnlyStaleDevicesAreDeleted)
+{
+    // Given
+    wolkabout::DeviceTemplate deviceTemplate;
+    std::vector<wolkabout::DetailedDevice> devices;
+    for (int i = 0; i < 250; ++i)
+    {
+        devices.emplace_back("Child device", "child_device_key_" + std::to_string(i), deviceTemplate);
+    }
+    deviceRepository->saveAll(devices);
+
+    // When
+    deviceRegistrationService->deleteDevicesOtherThan({"child_device_key_0", "child_device_key_1"});
+
+    // Then
+    ASSERT_EQ(248, platformOutboundMessageHandler->getMessages().size());
+    ASSERT_EQ(2, deviceRepository->findAllDeviceKeys()->size());
+    ASSERT_TRUE(deviceRepository->containsDeviceWithKey("child_device_key_0"));
+    ASSERT_TRUE(deviceRepository->containsDeviceWithKey("child_device_key_1"));
+    ASSERT_FALSE(deviceRepository->containsDeviceWithKey("child_device_key_2"));
+}
+
 TEST_F(
   SubdeviceRegistrationService,
   Given_DeviceRegistrationAwaitingPlatformResponse_When_DeviceIsSuccessfullyRegistered_Then_ResponseIsForwardedToDevice)
@@ -421,3 +484,45 @@ TEST_F(
     // Then
     ASSERT_EQ(1, deviceOutboundMessageHandler->getMessages().size());
 }
+
+TEST_F(SubdeviceRegistrationService,
+       Given_SeveralPendingRegistrations_When_OneIsAnswered_Then_ItIsSavedWithoutWaitingForOthers)
+{
+    // Given
+    wolkabout::DeviceTemplate gatewayTemplate;
+    wolkabout::DetailedDevice gateway("Gateway", GATEWAY_KEY, gatewayTemplate);
+    deviceRepository->save(gateway);
+
+    wolkabout::DeviceTemplate deviceTemplate;
+    for (const std::string deviceKey : {"first_key", "second_key"})
+    {
+        wolkabout::SubdeviceRegistrationRequest deviceRegistrationRequest("Device name", deviceKey, deviceTemplate);
+        deviceRegistrationService->deviceMessageReceived(protocol->makeMessage(GATEWAY_KEY, deviceRegistrationRequest));
+    }
+    ASSERT_EQ(2, platformOutboundMessageHandler->getMessages().size());
+
+    const auto channel = std::string("p2d/register_subdevice_response/g/") + GATEWAY_KEY;
+    const auto makeResponse = [&](const std::string& deviceKey) {
+        return std::make_shared<wolkabout::Message>(
+          R"({"payload":{"deviceKey":")" + deviceKey + R"("}, "result":"OK", "description":""})", channel);
+    };
+
+    // When
+    deviceRegistrationService->platformMessageReceived(makeResponse("second_key"));
+
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{5};
+    while (deviceOutboundMessageHandler->getMessages().empty() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+
+    // Then
+    ASSERT_EQ(1, deviceOutboundMessageHandler->getMessages().size());
+    ASSERT_NE(nullptr, deviceRepository->findByDeviceKey("second_key"));
+    ASSERT_EQ(nullptr, deviceRepository->findByDeviceKey("first_key"));
+
+    deviceRegistrationService->platformMessageReceived(makeResponse("first_key"));
+
+    ASSERT_NE(nullptr, deviceRepository->findByDeviceKey("first_key"));
+    ASSERT_EQ(2, deviceOutboundMessageHandler->getMessages().size());
+}
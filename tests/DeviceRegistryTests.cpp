@@ -0,0 +1,138 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "utilities/DeviceRegistry.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class DeviceRegistry : public ::testing::Test
+{
+public:
+    using Registry = wolkabout::DeviceRegistry<std::string>;
+
+    Registry registry{4};
+};
+}    // namespace
+
+TEST_F(DeviceRegistry, Given_AcquiredDevice_When_AcquiredAgain_Then_SameHandleIsReturned)
+{
+    // Given
+    const auto handle = registry.acquire("device1");
+
+    // When
+    const auto again = registry.acquire("device1");
+
+    // Then
+    ASSERT_EQ(handle, again);
+    ASSERT_EQ(registry.find("device1"), handle);
+    ASSERT_EQ(registry.find("device2"), Registry::INVALID_HANDLE);
+    ASSERT_EQ(registry.size(), 1u);
+}
+
+TEST_F(DeviceRegistry, Given_SlotUpdatedByHandle_When_ReadByKey_Then_UpdateIsVisible)
+{
+    // Given
+    const auto handle = registry.acquire("device1");
+    ASSERT_TRUE(registry.with(handle, [](std::string& slot) { slot = "online"; }));
+
+    // When
+    std::string status;
+    const bool found = registry.with("device1", [&](std::string& slot) { status = slot; });
+
+    // Then
+    ASSERT_TRUE(found);
+    ASSERT_EQ(status, "online");
+    ASSERT_FALSE(registry.with("device2", [](std::string&) {}));
+}
+
+TEST_F(DeviceRegistry, Given_ReleasedDevice_When_AnotherDeviceIsAcquired_Then_HandleIsReusedWithEmptySlot)
+{
+    // Given
+    std::vector<Registry::Handle> handles;
+    for (int i = 0; i < 16; ++i)
+    {
+        handles.push_back(registry.acquire("device" + std::to_string(i)));
+        registry.with(handles.back(), [](std::string& slot) { slot = "state"; });
+    }
+
+    // When
+    ASSERT_TRUE(registry.release("device3"));
+
+    // Then
+    ASSERT_FALSE(registry.release("device3"));
+    ASSERT_FALSE(registry.with(handles[3], [](std::string&) {}));
+    ASSERT_EQ(registry.size(), 15u);
+
+    // handles are dense, so new device of the same shard takes the freed one
+    for (int i = 16; i < 64; ++i)
+    {
+        const auto handle = registry.acquire("device" + std::to_string(i));
+        if (handle == handles[3])
+        {
+            std::string slot = "not empty";
+            registry.with(handle, [&](std::string& value) { slot = value; });
+            ASSERT_TRUE(slot.empty());
+            return;
+        }
+    }
+
+    FAIL() << "Released handle was not reused";
+}
+
+TEST_F(DeviceRegistry, Given_ConcurrentUpdates_When_DevicesAreInDifferentShards_Then_AllUpdatesAreApplied)
+{
+    // Given
+    wolkabout::DeviceRegistry<int> counters{8};
+    std::vector<wolkabout::DeviceRegistry<int>::Handle> handles;
+    for (int i = 0; i < 32; ++i)
+    {
+        handles.push_back(counters.acquire("device" + std::to_string(i)));
+    }
+
+    // When
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&] {
+            for (int round = 0; round < 1000; ++round)
+            {
+                for (const auto handle : handles)
+                {
+                    counters.with(handle, [](int& counter) { ++counter; });
+                }
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    // Then
+    for (const auto handle : handles)
+    {
+        int counter = 0;
+        counters.with(handle, [&](int& value) { counter = value; });
+        ASSERT_EQ(counter, 4000);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "utilities/DeviceShard.h"
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace
+{
+class DeviceShard : public ::testing::Test
+{
+};
+}    // namespace
+
+TEST_F(DeviceShard, Given_ManyDevices_When_Sharded_Then_EachDeviceIsOwnedByExactlyOneShard)
+{
+    // Given
+    std::vector<wolkabout::DeviceShard> shards;
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        shards.emplace_back(i, 4);
+    }
+
+    // When
+    std::vector<std::size_t> owned(4, 0);
+    for (int i = 0; i < 4000; ++i)
+    {
+        const std::string key = "device" + std::to_string(i);
+        std::size_t owners = 0;
+        for (const auto& shard : shards)
+        {
+            if (shard.owns(key))
+            {
+                ++owners;
+                ++owned[shard.getIndex()];
+            }
+        }
+
+        ASSERT_EQ(owners, 1u);
+        ASSERT_TRUE(shards[wolkabout::DeviceShard::of(key, 4)].owns(key));
+    }
+
+    // Then
+    for (const auto count : owned)
+    {
+        ASSERT_GT(count, 800u);
+        ASSERT_LT(count, 1200u);
+    }
+}
+
+TEST_F(DeviceShard, Given_Channels_When_OwnershipIsChecked_Then_GatewayChannelsBelongToPrimaryShard)
+{
+    // Given
+    const wolkabout::DeviceShard primary{0, 3};
+    const wolkabout::DeviceShard secondary{1, 3};
+    const std::string channel = "d2p/sensor_reading/d/device1/r/T";
+
+    // Then
+    ASSERT_EQ(wolkabout::DeviceShard::deviceKeyOf(channel), "device1");
+    ASSERT_EQ(wolkabout::DeviceShard::deviceKeyOf("p2d/actuator_set/g/gateway/d/device2"), "device2");
+    ASSERT_EQ(wolkabout::DeviceShard::deviceKeyOf("p2d/update_gateway_response/g/gateway"), "");
+    ASSERT_TRUE(primary.ownsChannel("p2d/update_gateway_response/g/gateway"));
+    ASSERT_FALSE(secondary.ownsChannel("p2d/update_gateway_response/g/gateway"));
+    ASSERT_EQ(primary.ownsChannel(channel), primary.owns("device1"));
+    ASSERT_EQ(secondary.getChannelPrefix(), "shard/1/");
+    ASSERT_THROW(wolkabout::DeviceShard(3, 3), std::logic_error);
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/DeviceStatistics.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace
+{
+class DeviceStatistics : public ::testing::Test
+{
+public:
+    // three devices tracked, counts halve every second
+    wolkabout::DeviceStatistics statistics{3, std::chrono::seconds{1}};
+
+    const wolkabout::DeviceStatistics::Clock::time_point start = wolkabout::DeviceStatistics::Clock::now();
+
+    void send(const std::string& deviceKey, std::size_t count, std::size_t bytes,
+              wolkabout::DeviceStatistics::Clock::time_point now)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            statistics.messageReceived(deviceKey, bytes, now);
+        }
+    }
+
+    static std::vector<std::string> keys(const std::vector<wolkabout::DeviceStatistics::Entry>& entries)
+    {
+        std::vector<std::string> deviceKeys;
+        for (const auto& entry : entries)
+        {
+            deviceKeys.push_back(entry.deviceKey);
+        }
+
+        return deviceKeys;
+    }
+};
+}    // namespace
+
+TEST_F(DeviceStatistics, Given_Devices_When_TopTalkersAreQueried_Then_DevicesAreOrderedByMessageRate)
+{
+    // Given
+    send("DEVICE_1", 5, 10, start);
+    send("DEVICE_2", 20, 100, start);
+    send("DEVICE_3", 10, 10, start);
+
+    // When
+    const auto topTalkers = statistics.topTalkers(2, start);
+
+    // Then
+    ASSERT_EQ(keys(topTalkers), (std::vector<std::string>{"DEVICE_2", "DEVICE_3"}));
+    ASSERT_NEAR(topTalkers[0].bytesPerSecond / topTalkers[0].messagesPerSecond, 100, 1e-9);
+    ASSERT_NEAR(topTalkers[0].messagesPerSecond / topTalkers[1].messagesPerSecond, 2, 1e-9);
+    ASSERT_EQ(topTalkers[0].error, 0);
+}
+
+TEST_F(DeviceStatistics, Given_MessagesStop_When_HalfLifePasses_Then_RateIsHalved)
+{
+    // Given
+    send("DEVICE_1", 10, 10, start);
+    const auto rate = statistics.topTalkers(1, start).front().messagesPerSecond;
+
+    // When
+    const auto decayed = statistics.topTalkers(1, start + std::chrono::seconds{1}).front();
+
+    // Then
+    ASSERT_NEAR(decayed.messagesPerSecond, rate / 2, rate * 1e-9);
+    ASSERT_EQ(decayed.lastSeen, start);
+}
+
+TEST_F(DeviceStatistics, Given_FullTable_When_NewDeviceSends_Then_QuietestDeviceIsReplacedAndCountIsInherited)
+{
+    // Given
+    send("DEVICE_1", 5, 10, start);
+    send("DEVICE_2", 1, 10, start);
+    send("DEVICE_3", 3, 10, start);
+
+    // When
+    send("DEVICE_4", 1, 10, start);
+
+    // Then
+    const auto topTalkers = statistics.topTalkers(10, start);
+    ASSERT_EQ(keys(topTalkers), (std::vector<std::string>{"DEVICE_1", "DEVICE_3", "DEVICE_4"}));
+    ASSERT_NEAR(topTalkers[2].messagesPerSecond, 2 * topTalkers[2].error, 1e-9);
+}
+
+TEST_F(DeviceStatistics, Given_ForwardedAndRejectedMessages_When_Queried_Then_LatencyAndRejectsAreReported)
+{
+    // Given
+    send("DEVICE_1", 2, 10, start);
+    send("DEVICE_2", 2, 10, start);
+    statistics.messageForwarded("DEVICE_1", std::chrono::microseconds{100});
+    statistics.messageForwarded("DEVICE_2", std::chrono::microseconds{800});
+    statistics.messageRejected("DEVICE_1");
+    statistics.messageRejected("UNKNOWN");
+
+    // When
+    const auto slowest = statistics.slowestDevices(2, start);
+
+    // Then
+    ASSERT_EQ(keys(slowest), (std::vector<std::string>{"DEVICE_2", "DEVICE_1"}));
+    ASSERT_EQ(slowest[0].forwardingLatency, std::chrono::microseconds{800});
+    ASSERT_EQ(slowest[1].rejectedMessages, 1u);
+    ASSERT_NE(statistics.format(1, start).find("\"device_key\":\"DEVICE_2\""), std::string::npos);
+}
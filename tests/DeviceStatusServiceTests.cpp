@@ -7,10 +7,14 @@
 #include "protocol/json/JsonStatusProtocol.h"
 #include "repository/SQLiteDeviceRepository.h"
 #include "service/DeviceStatusService.h"
+#include "utilities/Executor.h"
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cstdio>
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace
@@ -327,3 +331,142 @@ TEST_F(DeviceStatusService,
     // Then
     ASSERT_EQ(deviceOutboundMessageHandler->getMessages().size(), 3);
 }
+
+TEST_F(DeviceStatusService, GivenDevicesInRepository_When_ConnectedSeveralTimes_Then_RepositoryIsReadOnce)
+{
+    // Given
+    std::vector<std::string> keys = {GATEWAY_KEY, "KEY1", "KEY2"};
+
+    EXPECT_CALL(*deviceRepository, findAllDeviceKeysProxy())
+      .Times(1)
+      .WillOnce(testing::ReturnNew<std::vector<std::string>>(keys));
+
+    // When
+    deviceStatusService->connected();
+    deviceStatusService->disconnected();
+    deviceStatusService->connected();
+    deviceStatusService->disconnected();
+
+    // Then
+    ASSERT_EQ(deviceOutboundMessageHandler->getMessages().size(), 4);
+}
+
+TEST_F(DeviceStatusService,
+       GivenLoadedStatusTable_When_DevicesAreAddedAndRemoved_Then_StatusIsRequestedFromCurrentDevices)
+{
+    // Given
+    std::vector<std::string> keys = {GATEWAY_KEY, "KEY1"};
+
+    ON_CALL(*deviceRepository, findAllDeviceKeysProxy())
+      .WillByDefault(testing::ReturnNew<std::vector<std::string>>(keys));
+
+    deviceStatusService->connected();
+    deviceStatusService->disconnected();
+
+    // When
+    deviceStatusService->addDevice("KEY2");
+    deviceStatusService->removeDevice("KEY1");
+    deviceStatusService->connected();
+    deviceStatusService->disconnected();
+
+    // Then
+    ASSERT_EQ(deviceOutboundMessageHandler->getMessages().size(), 2);
+    ASSERT_EQ(deviceOutboundMessageHandler->getMessages().back()->getChannel(), "p2d/subdevice_status_request/d/KEY2");
+}
+
+TEST_F(DeviceStatusService, GivenConnectedDeviceWithRecentData_When_ConnectedToDevices_Then_StatusRequestIsNotSent)
+{
+    // Given
+    std::vector<std::string> keys = {GATEWAY_KEY, "KEY1", "KEY2"};
+
+    ON_CALL(*deviceRepository, findAllDeviceKeysProxy())
+      .WillByDefault(testing::ReturnNew<std::vector<std::string>>(keys));
+
+    deviceStatusService->connected();
+    deviceStatusService->disconnected();
+
+    deviceStatusService->deviceMessageReceived(
+      std::make_shared<wolkabout::Message>("{\"state\":\"CONNECTED\"}", "d2p/subdevice_status_update/d/KEY1"));
+    deviceStatusService->deviceActivity("KEY1");
+
+    // When
+    deviceStatusService->connected();
+    deviceStatusService->disconnected();
+
+    // Then
+    ASSERT_EQ(deviceOutboundMessageHandler->getMessages().size(), 3);
+    ASSERT_EQ(deviceOutboundMessageHandler->getMessages().back()->getChannel(), "p2d/subdevice_status_request/d/KEY2");
+}
+
+TEST_F(DeviceStatusService, GivenStaggeredPolling_When_ConnectedToDevices_Then_StatusIsRequestedFromFirstBucketOnly)
+{
+    // Given
+    std::vector<std::string> keys = {GATEWAY_KEY};
+    std::vector<std::string> expectedChannels;
+    for (int i = 0; i < 8; ++i)
+    {
+        const std::string key = "KEY" + std::to_string(i);
+        keys.push_back(key);
+
+        if (std::hash<std::string>{}(key) % 2 == 0)
+        {
+            expectedChannels.push_back("p2d/subdevice_status_request/d/" + key);
+        }
+    }
+
+    ON_CALL(*deviceRepository, findAllDeviceKeysProxy())
+      .WillByDefault(testing::ReturnNew<std::vector<std::string>>(keys));
+
+    wolkabout::Executor executor;
+    deviceStatusService->setStaggeredPolling(2, &executor);
+
+    // When
+    deviceStatusService->connected();
+    deviceStatusService->disconnected();
+
+    // Then
+    std::vector<std::string> channels;
+    for (const auto& message : deviceOutboundMessageHandler->getMessages())
+    {
+        channels.push_back(message->getChannel());
+    }
+
+    ASSERT_EQ(channels, expectedChannels);
+}
+
+TEST_F(DeviceStatusService, GivenStatusUpdateCoalescing_When_DevicesFlap_Then_OnlyFinalChangedStatusesArePublished)
+{
+    // Given
+    wolkabout::Executor executor;
+    deviceStatusService->setStatusUpdateCoalescing(std::chrono::milliseconds{3600000}, &executor);
+
+    const auto statusUpdate = [](const std::string& deviceKey, const std::string& state) {
+        return std::make_shared<wolkabout::Message>("{\"state\":\"" + state + "\"}",
+                                                    "d2p/subdevice_status_update/d/" + deviceKey);
+    };
+
+    // When
+    deviceStatusService->deviceMessageReceived(statusUpdate("KEY1", "CONNECTED"));
+    deviceStatusService->deviceMessageReceived(statusUpdate("KEY1", "OFFLINE"));
+    deviceStatusService->deviceMessageReceived(statusUpdate("KEY2", "OFFLINE"));
+    deviceStatusService->deviceMessageReceived(statusUpdate("KEY1", "CONNECTED"));
+    ASSERT_TRUE(platformOutboundMessageHandler->getMessages().empty());
+    deviceStatusService->flushStatusUpdates();
+
+    deviceStatusService->deviceMessageReceived(statusUpdate("KEY1", "OFFLINE"));
+    deviceStatusService->deviceMessageReceived(statusUpdate("KEY1", "CONNECTED"));
+    deviceStatusService->flushStatusUpdates();
+
+    // Then
+    std::vector<std::string> channels;
+    for (const auto& message : platformOutboundMessageHandler->getMessages())
+    {
+        channels.push_back(message->getChannel());
+    }
+    std::sort(channels.begin(), channels.end());
+
+    ASSERT_EQ(channels, (std::vector<std::string>{"d2p/subdevice_status_update/g/GATEWAY_KEY/d/KEY1",
+                                                  "d2p/subdevice_status_update/g/GATEWAY_KEY/d/KEY2"}));
+
+    deviceStatusService.reset();
+}
@@ -0,0 +1,60 @@
+#include "model/DeviceTemplate.h"
+#include "repository/DeviceTemplateDiff.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+class DeviceTemplateDiff : public ::testing::Test
+{
+public:
+    static wolkabout::DeviceTemplate makeTemplate(const std::vector<wolkabout::SensorTemplate>& sensors,
+                                                  const std::string& firmwareUpdateType = "")
+    {
+        return wolkabout::DeviceTemplate{{}, sensors, {}, {}, firmwareUpdateType, {}, {}, {}};
+    }
+};
+}    // namespace
+
+TEST_F(DeviceTemplateDiff, Given_EqualTemplates_When_Compared_Then_DiffIsEmpty)
+{
+    // Given
+    const auto previous =
+      makeTemplate({wolkabout::SensorTemplate{"", "T", wolkabout::DataType::NUMERIC, "", {0}, {100}}});
+    const auto current =
+      makeTemplate({wolkabout::SensorTemplate{"", "T", wolkabout::DataType::NUMERIC, "", {0}, {100}}});
+
+    // When
+    const wolkabout::DeviceTemplateDiff diff{previous, current};
+
+    // Then
+    ASSERT_TRUE(diff.empty());
+    ASSERT_EQ(diff.toString(), "");
+}
+
+TEST_F(DeviceTemplateDiff, Given_ChangedSensors_When_Compared_Then_AddedRemovedAndChangedReferencesAreListed)
+{
+    // Given
+    const auto previous =
+      makeTemplate({wolkabout::SensorTemplate{"", "T", wolkabout::DataType::NUMERIC, "", {0}, {100}},
+                    wolkabout::SensorTemplate{"", "H", wolkabout::DataType::NUMERIC, "", {0}, {100}}});
+    const auto current =
+      makeTemplate({wolkabout::SensorTemplate{"", "T", wolkabout::DataType::NUMERIC, "", {0}, {200}},
+                    wolkabout::SensorTemplate{"", "P", wolkabout::DataType::NUMERIC, "", {0}, {100}}},
+                   "DFU");
+
+    // When
+    const wolkabout::DeviceTemplateDiff diff{previous, current};
+
+    // Then
+    ASSERT_FALSE(diff.empty());
+    ASSERT_EQ(diff.getSensors().added, std::vector<std::string>{"P"});
+    ASSERT_EQ(diff.getSensors().removed, std::vector<std::string>{"H"});
+    ASSERT_EQ(diff.getSensors().changed, std::vector<std::string>{"T"});
+    ASSERT_TRUE(diff.getActuators().empty());
+    ASSERT_TRUE(diff.parametersChanged());
+    ASSERT_EQ(diff.toString(),
+              "sensors added: 'P'; sensors removed: 'H'; sensors changed: 'T'; parameters changed");
+}
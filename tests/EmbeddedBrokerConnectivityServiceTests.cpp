@@ -0,0 +1,258 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "connectivity/EmbeddedBrokerConnectivityService.h"
+#include "model/Message.h"
+
+#include <arpa/inet.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace
+{
+class Listener : public wolkabout::ConnectivityServiceListener
+{
+public:
+    void messageReceived(const std::string& channel, const std::string& message) override
+    {
+        std::lock_guard<std::mutex> locker{mutex};
+        messages.emplace_back(channel, message);
+        received.notify_all();
+    }
+
+    void connectionLost() override {}
+
+    std::vector<std::string> getChannels() const override { return {"d2p/+/d/+/r/#", "lastwill/#"}; }
+
+    bool waitFor(std::size_t count)
+    {
+        std::unique_lock<std::mutex> locker{mutex};
+        return received.wait_for(locker, std::chrono::seconds{2}, [&] { return messages.size() >= count; });
+    }
+
+    std::mutex mutex;
+    std::condition_variable received;
+    std::vector<std::pair<std::string, std::string>> messages;
+};
+
+class Client
+{
+public:
+    explicit Client(std::uint16_t port) : m_socket{socket(AF_INET, SOCK_STREAM, 0)}
+    {
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        inet_pton(AF_INET, "127.0.0.1", &address.sin_addr);
+        ::connect(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+        // write to broker that stopped reading fails instead of blocking the test
+        timeval timeout{2, 0};
+        setsockopt(m_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    }
+
+    ~Client() { close(); }
+
+    void close()
+    {
+        if (m_socket != -1)
+        {
+            ::close(m_socket);
+            m_socket = -1;
+        }
+    }
+
+    bool write(const std::string& bytes)
+    {
+        return ::send(m_socket, bytes.data(), bytes.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(bytes.size());
+    }
+
+    // reads one packet, returns empty string on timeout
+    std::string read()
+    {
+        std::string packet;
+        while (true)
+        {
+            if (packet.size() >= 2 && (packet[1] & 0x80) == 0 &&
+                packet.size() >= 2u + static_cast<std::uint8_t>(packet[1]))
+            {
+                return packet;
+            }
+
+            pollfd descriptor{m_socket, POLLIN, 0};
+            char byte = 0;
+            if (poll(&descriptor, 1, 2000) != 1 || recv(m_socket, &byte, 1, 0) != 1)
+            {
+                return "";
+            }
+
+            packet.push_back(byte);
+        }
+    }
+
+    static std::string encode(const std::string& value)
+    {
+        return std::string{static_cast<char>(value.size() >> 8), static_cast<char>(value.size() & 0xFF)} + value;
+    }
+
+    static std::string packet(char header, const std::string& body)
+    {
+        return std::string{header, static_cast<char>(body.size())} + body;
+    }
+
+    static std::string connect(const std::string& clientId, const std::string& willTopic = "")
+    {
+        const char flags = willTopic.empty() ? 0x02 : 0x06;
+        std::string body = encode("MQTT") + std::string{0x04, flags, 0x00, 0x3C} + encode(clientId);
+        if (!willTopic.empty())
+        {
+            body += encode(willTopic) + encode("OFFLINE");
+        }
+        return packet(0x10, body);
+    }
+
+    static std::string subscribe(const std::string& filter)
+    {
+        return packet(static_cast<char>(0x82), std::string{0x00, 0x01} + encode(filter) + std::string{0x01});
+    }
+
+    static std::string publish(const std::string& topic, const std::string& payload)
+    {
+        return packet(0x30, encode(topic) + payload);
+    }
+
+private:
+    int m_socket;
+};
+
+class EmbeddedBrokerConnectivityService : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        broker.setListener(listener);
+        ASSERT_TRUE(broker.connect());
+    }
+
+    void connect(Client& client, const std::string& clientId, const std::string& willTopic = "")
+    {
+        client.write(Client::connect(clientId, willTopic));
+        ASSERT_EQ(client.read(), std::string("\x20\x02\x00\x00", 4));
+    }
+
+    std::shared_ptr<Listener> listener = std::make_shared<Listener>();
+    wolkabout::EmbeddedBrokerConnectivityService broker{"127.0.0.1", 0};
+};
+}    // namespace
+
+TEST_F(EmbeddedBrokerConnectivityService, Given_Client_When_PublishingOnGatewayChannel_Then_ListenerReceivesMessage)
+{
+    // Given
+    Client client{broker.getPort()};
+    connect(client, "DEVICE_1");
+
+    // When
+    client.write(Client::publish("d2p/sensor_reading/d/DEVICE_1/r/T", "{\"data\":\"25\"}"));
+    client.write(Client::publish("other/topic", "ignored"));
+
+    // Then
+    ASSERT_TRUE(listener->waitFor(1));
+    ASSERT_EQ(listener->messages.size(), 1u);
+    ASSERT_EQ(listener->messages[0].first, "d2p/sensor_reading/d/DEVICE_1/r/T");
+    ASSERT_EQ(listener->messages[0].second, "{\"data\":\"25\"}");
+    ASSERT_EQ(broker.getClientCount(), 1u);
+}
+
+TEST_F(EmbeddedBrokerConnectivityService, Given_SubscribedClient_When_GatewayPublishes_Then_ClientReceivesMessage)
+{
+    // Given
+    Client client{broker.getPort()};
+    connect(client, "DEVICE_1");
+    client.write(Client::subscribe("p2d/+/d/DEVICE_1/r/#"));
+    ASSERT_EQ(client.read(), std::string("\x90\x03\x00\x01\x00", 5));
+
+    // When
+    broker.publish(std::make_shared<wolkabout::Message>("ON", "p2d/actuator_set/d/DEVICE_1/r/SW"));
+    broker.publish(std::make_shared<wolkabout::Message>("OFF", "p2d/actuator_set/d/DEVICE_2/r/SW"));
+
+    // Then
+    ASSERT_EQ(client.read(), Client::publish("p2d/actuator_set/d/DEVICE_1/r/SW", "ON"));
+}
+
+TEST_F(EmbeddedBrokerConnectivityService, Given_ClientWithWill_When_ConnectionDrops_Then_WillIsPublished)
+{
+    // Given
+    Client client{broker.getPort()};
+    connect(client, "DEVICE_1", "lastwill/DEVICE_1");
+    Client graceful{broker.getPort()};
+    connect(graceful, "DEVICE_2", "lastwill/DEVICE_2");
+
+    // When
+    graceful.write(std::string{static_cast<char>(0xE0), 0x00});
+    graceful.close();
+    client.close();
+
+    // Then
+    ASSERT_TRUE(listener->waitFor(1));
+    ASSERT_EQ(listener->messages.size(), 1u);
+    ASSERT_EQ(listener->messages[0].first, "lastwill/DEVICE_1");
+    ASSERT_EQ(listener->messages[0].second, "OFFLINE");
+}
+
+TEST_F(EmbeddedBrokerConnectivityService, Given_Client_When_StreamingOversizedPacket_Then_SessionIsClosed)
+{
+    // Given
+    Client client{broker.getPort()};
+    connect(client, "DEVICE_1");
+    ASSERT_EQ(broker.getClientCount(), 1u);
+
+    // When
+    std::string header{0x30};
+    for (auto length = wolkabout::EmbeddedBrokerConnectivityService::MAXIMUM_PACKET_SIZE + 1; length > 0;
+         length /= 128)
+    {
+        header.push_back(static_cast<char>((length % 128) | (length >= 128 ? 0x80 : 0x00)));
+    }
+    client.write(header);
+
+    const std::string chunk(64 * 1024, 'x');
+    for (int i = 0; i < 256 && client.write(chunk); ++i)
+    {
+    }
+
+    // Then
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{2};
+    while (broker.getClientCount() != 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+
+    ASSERT_EQ(broker.getClientCount(), 0u);
+    ASSERT_TRUE(listener->messages.empty());
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/Executor.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+class Executor : public ::testing::Test
+{
+public:
+    bool waitFor(const std::atomic_int& counter, int value)
+    {
+        for (int i = 0; i < 100 && counter != value; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+
+        return counter == value;
+    }
+
+    wolkabout::Executor executor;
+};
+}    // namespace
+
+TEST_F(Executor, Given_PostedTasks_When_WorkersRun_Then_EveryTaskIsExecuted)
+{
+    // Given
+    std::atomic_int counter{0};
+
+    // When
+    for (int i = 0; i < 10; ++i)
+    {
+        executor.post([&] { ++counter; });
+    }
+
+    // Then
+    ASSERT_TRUE(waitFor(counter, 10));
+}
+
+TEST_F(Executor, Given_ScheduledTask_When_DelayPasses_Then_TaskIsExecuted)
+{
+    // Given
+    std::atomic_int counter{0};
+    const auto start = std::chrono::steady_clock::now();
+
+    // When
+    executor.schedule(std::chrono::milliseconds{100}, [&] { ++counter; });
+
+    // Then
+    ASSERT_TRUE(waitFor(counter, 1));
+    ASSERT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds{100});
+}
+
+TEST_F(Executor, Given_ScheduledTask_When_Cancelled_Then_TaskIsNotExecuted)
+{
+    // Given
+    std::atomic_int counter{0};
+    const auto id = executor.schedule(std::chrono::milliseconds{100}, [&] { ++counter; });
+
+    // When
+    ASSERT_TRUE(executor.cancel(id));
+
+    // Then
+    std::this_thread::sleep_for(std::chrono::milliseconds{300});
+    ASSERT_EQ(counter, 0);
+}
+
+TEST_F(Executor, Given_RunningTask_When_Cancelled_Then_CancelWaitsForTaskToFinish)
+{
+    // Given
+    std::atomic_bool started{false};
+    std::atomic_bool finished{false};
+    const auto id = executor.post([&] {
+        started = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        finished = true;
+    });
+
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+
+    // When
+    ASSERT_FALSE(executor.cancel(id));
+
+    // Then
+    ASSERT_TRUE(finished);
+}
@@ -0,0 +1,264 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "service/FileDownloader.h"
+#include "model/BinaryData.h"
+#include "model/FilePacketRequest.h"
+#include "utilities/BandwidthScheduler.h"
+#include "utilities/ByteUtils.h"
+#include "utilities/Executor.h"
+#include "utilities/FileSystemUtils.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+const char* FILE_NAME = "fileDownloaderTestFile";
+const std::uint64_t PACKET_DATA_SIZE = 10;
+const std::uint64_t MAX_PACKET_SIZE = PACKET_DATA_SIZE + 2 * wolkabout::ByteUtils::SHA_256_HASH_BYTE_LENGTH;
+
+class FileDownloader : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        auto previousHash = wolkabout::ByteArray(wolkabout::ByteUtils::SHA_256_HASH_BYTE_LENGTH, 0);
+        for (const auto& content : {"packet-0..", "packet-1..", "packet-2.."})
+        {
+            const auto data = wolkabout::ByteUtils::toByteArray(content);
+            const auto hash = wolkabout::ByteUtils::hashSHA256(data);
+
+            wolkabout::ByteArray packet{previousHash};
+            packet.insert(packet.end(), data.begin(), data.end());
+            packet.insert(packet.end(), hash.begin(), hash.end());
+            packets.emplace_back(packet);
+
+            fileContent += content;
+            previousHash = hash;
+        }
+    }
+
+    void TearDown() override { std::remove(FILE_NAME); }
+
+    template <class Predicate> static bool waitFor(Predicate predicate)
+    {
+        for (int i = 0; i < 100 && !predicate(); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+
+        return predicate();
+    }
+
+    std::vector<wolkabout::BinaryData> packets;
+    std::string fileContent;
+};
+}    // namespace
+
+TEST_F(FileDownloader, Given_Window_When_PacketsArriveOutOfOrder_Then_FileIsAssembledInOrder)
+{
+    // Given
+    wolkabout::FileDownloader downloader{MAX_PACKET_SIZE, 3};
+
+    std::atomic_int requests{0};
+    std::atomic_bool completed{false};
+    std::atomic_bool failed{false};
+
+    downloader.download(FILE_NAME, fileContent.size(),
+                        wolkabout::ByteUtils::hashSHA256(wolkabout::ByteUtils::toByteArray(fileContent)), ".",
+                        [&](const wolkabout::FilePacketRequest&) { ++requests; },
+                        [&](const std::string&) { completed = true; },
+                        [&](wolkabout::FileTransferError) { failed = true; });
+
+    // When
+    ASSERT_TRUE(waitFor([&] { return requests == 3; }));
+    downloader.handleData(packets[2]);
+    downloader.handleData(packets[0]);
+    downloader.handleData(packets[1]);
+
+    // Then
+    ASSERT_TRUE(waitFor([&] { return completed || failed; }));
+    ASSERT_TRUE(completed);
+
+    wolkabout::ByteArray content;
+    ASSERT_TRUE(wolkabout::FileSystemUtils::readBinaryFileContent(FILE_NAME, content));
+    ASSERT_EQ(wolkabout::ByteUtils::toString(content), fileContent);
+}
+
+TEST_F(FileDownloader, Given_NoWindow_When_PacketIsReceived_Then_NextPacketIsRequested)
+{
+    // Given
+    wolkabout::FileDownloader downloader{MAX_PACKET_SIZE};
+
+    std::atomic_int requests{0};
+    std::atomic_bool completed{false};
+
+    downloader.download(FILE_NAME, fileContent.size(),
+                        wolkabout::ByteUtils::hashSHA256(wolkabout::ByteUtils::toByteArray(fileContent)), ".",
+                        [&](const wolkabout::FilePacketRequest&) { ++requests; },
+                        [&](const std::string&) { completed = true; }, [&](wolkabout::FileTransferError) {});
+
+    ASSERT_TRUE(waitFor([&] { return requests == 1; }));
+
+    // When
+    downloader.handleData(packets[0]);
+
+    // Then
+    ASSERT_TRUE(waitFor([&] { return requests == 2; }));
+
+    downloader.handleData(packets[1]);
+    downloader.handleData(packets[2]);
+    ASSERT_TRUE(waitFor([&] { return completed.load(); }));
+}
+
+TEST_F(FileDownloader, Given_VerificationExecutor_When_PacketArrives_Then_NextPacketIsRequestedAndFileIsAssembled)
+{
+    // Given
+    wolkabout::Executor executor{2};
+    wolkabout::FileDownloader downloader{MAX_PACKET_SIZE, 1, nullptr,
+                                         wolkabout::FileDownloader::DEFAULT_PACKET_REQUEST_TIMEOUT, &executor};
+
+    std::atomic_int requests{0};
+    std::atomic_bool completed{false};
+    std::atomic_bool failed{false};
+
+    downloader.download(FILE_NAME, fileContent.size(),
+                        wolkabout::ByteUtils::hashSHA256(wolkabout::ByteUtils::toByteArray(fileContent)), ".",
+                        [&](const wolkabout::FilePacketRequest&) { ++requests; },
+                        [&](const std::string&) { completed = true; },
+                        [&](wolkabout::FileTransferError) { failed = true; });
+
+    ASSERT_TRUE(waitFor([&] { return requests == 1; }));
+
+    // When
+    downloader.handleData(packets[0]);
+    ASSERT_TRUE(waitFor([&] { return requests == 2; }));
+    downloader.handleData(packets[1]);
+    ASSERT_TRUE(waitFor([&] { return requests == 3; }));
+    downloader.handleData(packets[2]);
+
+    // Then
+    ASSERT_TRUE(waitFor([&] { return completed || failed; }));
+    ASSERT_TRUE(completed);
+
+    wolkabout::ByteArray content;
+    ASSERT_TRUE(wolkabout::FileSystemUtils::readBinaryFileContent(FILE_NAME, content));
+    ASSERT_EQ(wolkabout::ByteUtils::toString(content), fileContent);
+}
+
+TEST_F(FileDownloader, Given_VerificationExecutor_When_PacketIsCorrupted_Then_PacketIsRequestedAgain)
+{
+    // Given
+    wolkabout::Executor executor{2};
+    wolkabout::FileDownloader downloader{MAX_PACKET_SIZE, 1, nullptr,
+                                         wolkabout::FileDownloader::DEFAULT_PACKET_REQUEST_TIMEOUT, &executor};
+
+    std::atomic_int requests{0};
+    std::atomic_uint lastRequestedIndex{0};
+
+    downloader.download(FILE_NAME, fileContent.size(),
+                        wolkabout::ByteUtils::hashSHA256(wolkabout::ByteUtils::toByteArray(fileContent)), ".",
+                        [&](const wolkabout::FilePacketRequest& request) {
+                            lastRequestedIndex = request.getChunkIndex();
+                            ++requests;
+                        },
+                        [](const std::string&) {}, [](wolkabout::FileTransferError) {});
+
+    ASSERT_TRUE(waitFor([&] { return requests == 1; }));
+
+    // data does not match hash of the first packet
+    wolkabout::ByteArray corrupted(wolkabout::ByteUtils::SHA_256_HASH_BYTE_LENGTH, 0);
+    const auto data = wolkabout::ByteUtils::toByteArray("packet-x..");
+    corrupted.insert(corrupted.end(), data.begin(), data.end());
+    const auto hash = packets[0].getHash();
+    corrupted.insert(corrupted.end(), hash.begin(), hash.end());
+
+    // When
+    downloader.handleData(wolkabout::BinaryData{corrupted});
+
+    // Then
+    ASSERT_TRUE(waitFor([&] { return requests == 3; }));
+    ASSERT_EQ(lastRequestedIndex, 0u);
+}
+
+TEST_F(FileDownloader, Given_Checkpoint_When_DownloadIsStarted_Then_DownloadResumesFromCheckpoint)
+{
+    // Given
+    const std::string temporaryFileName = std::string{FILE_NAME} + ".part";
+    ASSERT_TRUE(wolkabout::FileSystemUtils::createFileWithContent(temporaryFileName, "packet-0..packet-1..pac"));
+
+    const auto fileHash = wolkabout::ByteUtils::hashSHA256(wolkabout::ByteUtils::toByteArray(fileContent));
+    auto checkpoint = std::make_shared<wolkabout::FileTransferCheckpoint>(FILE_NAME, fileHash, 2,
+                                                                          packets[1].getHash(), 2 * PACKET_DATA_SIZE);
+
+    wolkabout::FileDownloader downloader{MAX_PACKET_SIZE};
+
+    std::atomic_int requests{0};
+    std::atomic_uint firstRequestedIndex{0};
+    std::atomic_bool completed{false};
+
+    // When
+    downloader.download(FILE_NAME, fileContent.size(), fileHash, ".",
+                        [&](const wolkabout::FilePacketRequest& request) {
+                            if (requests++ == 0)
+                            {
+                                firstRequestedIndex = request.getChunkIndex();
+                            }
+                        },
+                        [&](const std::string&) { completed = true; }, [&](wolkabout::FileTransferError) {},
+                        [&](const wolkabout::FileTransferCheckpoint&) {}, checkpoint);
+
+    ASSERT_TRUE(waitFor([&] { return requests == 1; }));
+    downloader.handleData(packets[2]);
+
+    // Then
+    ASSERT_TRUE(waitFor([&] { return completed.load(); }));
+    ASSERT_EQ(requests, 1);
+    ASSERT_EQ(firstRequestedIndex, 2u);
+
+    wolkabout::ByteArray content;
+    ASSERT_TRUE(wolkabout::FileSystemUtils::readBinaryFileContent(FILE_NAME, content));
+    ASSERT_EQ(wolkabout::ByteUtils::toString(content), fileContent);
+}
+
+TEST_F(FileDownloader, Given_LinkBusyWithTelemetry_When_DownloadIsStarted_Then_PacketIsRequestedOnceBandwidthIsLeft)
+{
+    // Given
+    auto scheduler = std::make_shared<wolkabout::BandwidthScheduler>(1000, 0.5);
+    scheduler->telemetrySent(1500);
+
+    wolkabout::FileDownloader downloader{MAX_PACKET_SIZE, 3, scheduler};
+
+    std::atomic_int requests{0};
+
+    // When
+    downloader.download(FILE_NAME, fileContent.size(),
+                        wolkabout::ByteUtils::hashSHA256(wolkabout::ByteUtils::toByteArray(fileContent)), ".",
+                        [&](const wolkabout::FilePacketRequest&) { ++requests; }, [](const std::string&) {},
+                        [](wolkabout::FileTransferError) {});
+
+    // Then
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+    ASSERT_EQ(requests, 0);
+    ASSERT_TRUE(waitFor([&] { return requests != 0; }));
+}
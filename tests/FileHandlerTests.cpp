@@ -0,0 +1,146 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "FileHandler.h"
+#include "model/BinaryData.h"
+#include "utilities/ByteUtils.h"
+#include "utilities/FileSystemUtils.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+const char* FILE_PATH = "./fileHandlerTestFile";
+const char* TEMPORARY_FILE_PATH = "./fileHandlerTestFile.part";
+
+wolkabout::ByteArray makePacket(const wolkabout::ByteArray& previousHash, const std::string& content)
+{
+    const auto data = wolkabout::ByteUtils::toByteArray(content);
+    const auto hash = wolkabout::ByteUtils::hashSHA256(data);
+
+    wolkabout::ByteArray packet{previousHash};
+    packet.insert(packet.end(), data.begin(), data.end());
+    packet.insert(packet.end(), hash.begin(), hash.end());
+    return packet;
+}
+
+class FileHandler : public ::testing::Test
+{
+public:
+    void TearDown() override
+    {
+        std::remove(FILE_PATH);
+        std::remove(TEMPORARY_FILE_PATH);
+    }
+
+    wolkabout::FileHandler fileHandler;
+};
+}    // namespace
+
+TEST_F(FileHandler, Given_StreamingMode_When_PacketsAreHandled_Then_FileIsWrittenAndRenamedOnSave)
+{
+    // Given
+    ASSERT_EQ(fileHandler.streamTo(TEMPORARY_FILE_PATH), wolkabout::FileHandler::StatusCode::OK);
+
+    const wolkabout::BinaryData first{
+      makePacket(wolkabout::ByteArray(wolkabout::ByteUtils::SHA_256_HASH_BYTE_LENGTH, 0), "first ")};
+    const wolkabout::BinaryData second{makePacket(first.getHash(), "second")};
+
+    // When
+    ASSERT_EQ(fileHandler.handleData(first), wolkabout::FileHandler::StatusCode::OK);
+    ASSERT_EQ(fileHandler.handleData(second), wolkabout::FileHandler::StatusCode::OK);
+
+    // Then
+    const auto fileHash = wolkabout::ByteUtils::hashSHA256(wolkabout::ByteUtils::toByteArray("first second"));
+    ASSERT_EQ(fileHandler.validateFile(fileHash), wolkabout::FileHandler::StatusCode::OK);
+    ASSERT_EQ(fileHandler.saveFile(FILE_PATH), wolkabout::FileHandler::StatusCode::OK);
+
+    wolkabout::ByteArray content;
+    ASSERT_TRUE(wolkabout::FileSystemUtils::readBinaryFileContent(FILE_PATH, content));
+    ASSERT_EQ(wolkabout::ByteUtils::toString(content), "first second");
+    ASSERT_FALSE(wolkabout::FileSystemUtils::isFilePresent(TEMPORARY_FILE_PATH));
+}
+
+TEST_F(FileHandler, Given_StreamingMode_When_HashDoesNotMatch_Then_TemporaryFileIsRemovedOnClear)
+{
+    // Given
+    ASSERT_EQ(fileHandler.streamTo(TEMPORARY_FILE_PATH), wolkabout::FileHandler::StatusCode::OK);
+    const wolkabout::BinaryData packet{
+      makePacket(wolkabout::ByteArray(wolkabout::ByteUtils::SHA_256_HASH_BYTE_LENGTH, 0), "content")};
+    ASSERT_EQ(fileHandler.handleData(packet), wolkabout::FileHandler::StatusCode::OK);
+
+    // When
+    const auto result = fileHandler.validateFile(wolkabout::ByteUtils::hashSHA256({1, 2, 3}));
+    fileHandler.clear();
+
+    // Then
+    ASSERT_EQ(result, wolkabout::FileHandler::StatusCode::FILE_HASH_NOT_VALID);
+    ASSERT_FALSE(wolkabout::FileSystemUtils::isFilePresent(TEMPORARY_FILE_PATH));
+    ASSERT_FALSE(wolkabout::FileSystemUtils::isFilePresent(FILE_PATH));
+}
+
+TEST_F(FileHandler, Given_DetachedPartialFile_When_Resumed_Then_RemainingPacketsCompleteTheFile)
+{
+    // Given
+    ASSERT_EQ(fileHandler.streamTo(TEMPORARY_FILE_PATH), wolkabout::FileHandler::StatusCode::OK);
+
+    const wolkabout::BinaryData first{
+      makePacket(wolkabout::ByteArray(wolkabout::ByteUtils::SHA_256_HASH_BYTE_LENGTH, 0), "first ")};
+    const wolkabout::BinaryData second{makePacket(first.getHash(), "second")};
+
+    ASSERT_EQ(fileHandler.handleData(first), wolkabout::FileHandler::StatusCode::OK);
+    ASSERT_EQ(fileHandler.sync(), wolkabout::FileHandler::StatusCode::OK);
+    const auto offset = fileHandler.getWrittenSize();
+    const auto previousPacketHash = fileHandler.getPreviousPacketHash();
+
+    // data written after the checkpoint is discarded on resume
+    ASSERT_EQ(fileHandler.handleData(second), wolkabout::FileHandler::StatusCode::OK);
+    fileHandler.detach();
+    ASSERT_TRUE(wolkabout::FileSystemUtils::isFilePresent(TEMPORARY_FILE_PATH));
+
+    // When
+    wolkabout::FileHandler resumed;
+    ASSERT_EQ(resumed.resume(TEMPORARY_FILE_PATH, offset, previousPacketHash),
+              wolkabout::FileHandler::StatusCode::OK);
+    ASSERT_EQ(resumed.handleData(second), wolkabout::FileHandler::StatusCode::OK);
+
+    // Then
+    const auto fileHash = wolkabout::ByteUtils::hashSHA256(wolkabout::ByteUtils::toByteArray("first second"));
+    ASSERT_EQ(resumed.validateFile(fileHash), wolkabout::FileHandler::StatusCode::OK);
+    ASSERT_EQ(resumed.saveFile(FILE_PATH), wolkabout::FileHandler::StatusCode::OK);
+
+    wolkabout::ByteArray content;
+    ASSERT_TRUE(wolkabout::FileSystemUtils::readBinaryFileContent(FILE_PATH, content));
+    ASSERT_EQ(wolkabout::ByteUtils::toString(content), "first second");
+}
+
+TEST_F(FileHandler, Given_PartialFileShorterThanOffset_When_Resumed_Then_ErrorIsReturned)
+{
+    // Given
+    ASSERT_EQ(fileHandler.streamTo(TEMPORARY_FILE_PATH), wolkabout::FileHandler::StatusCode::OK);
+    const wolkabout::BinaryData packet{
+      makePacket(wolkabout::ByteArray(wolkabout::ByteUtils::SHA_256_HASH_BYTE_LENGTH, 0), "content")};
+    ASSERT_EQ(fileHandler.handleData(packet), wolkabout::FileHandler::StatusCode::OK);
+    fileHandler.detach();
+
+    // When
+    const auto result = fileHandler.resume(TEMPORARY_FILE_PATH, 1024, packet.getHash());
+
+    // Then
+    ASSERT_EQ(result, wolkabout::FileHandler::StatusCode::FILE_HANDLING_ERROR);
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "model/FilePacketRequest.h"
+#include "service/FilePacketScheduler.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class FilePacketScheduler : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        scheduler.reset(new wolkabout::FilePacketScheduler(
+          2, [this](const wolkabout::FilePacketRequest& request) {
+              sent.push_back(request.getFileName() + ":" + std::to_string(request.getChunkIndex()));
+          }));
+    }
+
+    static wolkabout::FilePacketRequest packet(const std::string& fileName, unsigned index)
+    {
+        return wolkabout::FilePacketRequest{fileName, index, 1024};
+    }
+
+    std::unique_ptr<wolkabout::FilePacketScheduler> scheduler;
+    std::vector<std::string> sent;
+};
+}    // namespace
+
+TEST_F(FilePacketScheduler, Given_SingleTransfer_When_PacketsAreRequested_Then_WholeWindowIsSentImmediately)
+{
+    // Given
+    const auto id = scheduler->open();
+
+    // When
+    scheduler->request(id, packet("a", 0));
+    scheduler->request(id, packet("a", 1));
+
+    // Then
+    ASSERT_EQ(sent, (std::vector<std::string>{"a:0", "a:1"}));
+    ASSERT_EQ(scheduler->received(), id);
+    ASSERT_EQ(scheduler->received(), id);
+    ASSERT_EQ(scheduler->received(), wolkabout::FilePacketScheduler::INVALID_TRANSFER);
+}
+
+TEST_F(FilePacketScheduler, Given_MaximumTransfersOpen_When_AnotherIsOpened_Then_ItIsRefusedUntilOneCloses)
+{
+    // Given
+    const auto first = scheduler->open();
+    scheduler->open();
+
+    // When
+    const auto refused = scheduler->open();
+    scheduler->close(first);
+
+    // Then
+    ASSERT_EQ(refused, wolkabout::FilePacketScheduler::INVALID_TRANSFER);
+    ASSERT_EQ(scheduler->open(), first);
+}
+
+TEST_F(FilePacketScheduler, Given_TwoTransfers_When_PacketsArrive_Then_TransfersTakeTurns)
+{
+    // Given
+    const auto a = scheduler->open();
+    const auto b = scheduler->open();
+    scheduler->request(a, packet("a", 0));
+    scheduler->request(b, packet("b", 0));
+
+    // When
+    const auto firstOwner = scheduler->received();
+    scheduler->request(a, packet("a", 1));
+    const auto secondOwner = scheduler->received();
+    scheduler->request(b, packet("b", 1));
+    const auto thirdOwner = scheduler->received();
+
+    // Then
+    ASSERT_EQ(firstOwner, a);
+    ASSERT_EQ(secondOwner, b);
+    ASSERT_EQ(thirdOwner, a);
+    ASSERT_EQ(sent, (std::vector<std::string>{"a:0", "b:0", "a:1", "b:1"}));
+}
+
+TEST_F(FilePacketScheduler, Given_WaitingTransfer_When_PacketIsRequestedAgain_Then_QueuedRequestIsReplaced)
+{
+    // Given
+    const auto a = scheduler->open();
+    const auto b = scheduler->open();
+    scheduler->request(a, packet("a", 0));
+    scheduler->request(b, packet("b", 0));
+
+    // When
+    scheduler->request(b, packet("b", 0));
+    scheduler->received();
+
+    // Then
+    ASSERT_EQ(sent, (std::vector<std::string>{"a:0", "b:0"}));
+    ASSERT_EQ(scheduler->received(), b);
+}
+
+TEST_F(FilePacketScheduler, Given_TransferHoldingChannel_When_Closed_Then_WaitingTransferGetsChannel)
+{
+    // Given
+    const auto a = scheduler->open();
+    const auto b = scheduler->open();
+    scheduler->request(a, packet("a", 0));
+    scheduler->request(b, packet("b", 0));
+
+    // When
+    scheduler->close(a);
+
+    // Then
+    ASSERT_EQ(sent, (std::vector<std::string>{"a:0", "b:0"}));
+    ASSERT_EQ(scheduler->received(), b);
+}
+
+TEST_F(FilePacketScheduler, Given_IdleHolder_When_OtherTransferRequests_Then_RequestIsSentImmediately)
+{
+    // Given
+    const auto a = scheduler->open();
+    const auto b = scheduler->open();
+    scheduler->request(a, packet("a", 0));
+    scheduler->received();
+
+    // When
+    scheduler->request(b, packet("b", 0));
+
+    // Then
+    ASSERT_EQ(sent, (std::vector<std::string>{"a:0", "b:0"}));
+    ASSERT_EQ(scheduler->received(), b);
+}
@@ -0,0 +1,157 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "service/FirmwareChunkServer.h"
+#include "utilities/ByteUtils.h"
+#include "utilities/FileSystemUtils.h"
+#include "utilities/Sha256.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+const char* FILE_PATH = "./firmwareChunkServerTestFile";
+
+wolkabout::ByteArray hashOf(const std::string& data)
+{
+    wolkabout::Sha256 sha256;
+    sha256.update(wolkabout::ByteUtils::toByteArray(data));
+    return sha256.digest();
+}
+
+std::string chunkOf(const wolkabout::FirmwareImage& image, std::size_t index)
+{
+    return std::string(reinterpret_cast<const char*>(image.getChunkData(index)), image.getChunkLength(index));
+}
+
+class FirmwareChunkServer : public ::testing::Test
+{
+public:
+    void TearDown() override { std::remove(FILE_PATH); }
+
+    static void createFile(const std::string& content)
+    {
+        ASSERT_TRUE(wolkabout::FileSystemUtils::createBinaryFileWithContent(
+          FILE_PATH, wolkabout::ByteUtils::toByteArray(content)));
+    }
+};
+}    // namespace
+
+TEST_F(FirmwareChunkServer, Given_PublishedFile_When_ChunksAreRead_Then_DataAndHashesMatchFileContent)
+{
+    // Given
+    createFile("abcdefghij");
+    wolkabout::FirmwareChunkServer server{4};
+
+    // When
+    ASSERT_TRUE(server.publish(FILE_PATH));
+    const auto image = server.find(FILE_PATH);
+
+    // Then
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(image->getSize(), 10u);
+    ASSERT_EQ(image->getChunkCount(), 3u);
+
+    ASSERT_EQ(chunkOf(*image, 0), "abcd");
+    ASSERT_EQ(chunkOf(*image, 1), "efgh");
+    ASSERT_EQ(chunkOf(*image, 2), "ij");
+
+    ASSERT_EQ(image->getChunkHash(0), hashOf("abcd"));
+    ASSERT_EQ(image->getChunkHash(2), hashOf("ij"));
+
+    ASSERT_EQ(image->getChunkData(3), nullptr);
+    ASSERT_EQ(image->getChunkLength(3), 0u);
+}
+
+TEST_F(FirmwareChunkServer, Given_FileSizeMultipleOfChunkSize_When_Mapped_Then_LastChunkIsEmpty)
+{
+    // Given
+    createFile("abcdefgh");
+
+    // When
+    const auto image = wolkabout::FirmwareImage::map(FILE_PATH, 4);
+
+    // Then
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(image->getChunkCount(), 3u);
+    ASSERT_EQ(chunkOf(*image, 1), "efgh");
+    ASSERT_EQ(image->getChunkLength(2), 0u);
+    ASSERT_EQ(image->getChunkHash(2), hashOf(""));
+}
+
+TEST_F(FirmwareChunkServer, Given_EmptyFile_When_Mapped_Then_SingleEmptyChunkIsServed)
+{
+    // Given
+    createFile("");
+
+    // When
+    const auto image = wolkabout::FirmwareImage::map(FILE_PATH, 4);
+
+    // Then
+    ASSERT_NE(image, nullptr);
+    ASSERT_EQ(image->getChunkCount(), 1u);
+    ASSERT_NE(image->getChunkData(0), nullptr);
+    ASSERT_EQ(image->getChunkLength(0), 0u);
+}
+
+TEST_F(FirmwareChunkServer, Given_FilePublishedTwice_When_Found_Then_SameImageIsShared)
+{
+    // Given
+    createFile("abcdefghij");
+    wolkabout::FirmwareChunkServer server{4};
+    ASSERT_TRUE(server.publish(FILE_PATH));
+    const auto first = server.find(FILE_PATH);
+
+    // When
+    ASSERT_TRUE(server.publish(FILE_PATH));
+
+    // Then
+    ASSERT_EQ(server.size(), 1u);
+    ASSERT_EQ(server.find(FILE_PATH), first);
+}
+
+TEST_F(FirmwareChunkServer, Given_HeldImage_When_Withdrawn_Then_ImageStaysReadable)
+{
+    // Given
+    createFile("abcdefghij");
+    wolkabout::FirmwareChunkServer server{4};
+    ASSERT_TRUE(server.publish(FILE_PATH));
+    const auto image = server.find(FILE_PATH);
+
+    // When
+    server.withdraw(FILE_PATH);
+
+    // Then
+    ASSERT_EQ(server.find(FILE_PATH), nullptr);
+    ASSERT_EQ(server.size(), 0u);
+    ASSERT_EQ(chunkOf(*image, 1), "efgh");
+}
+
+TEST_F(FirmwareChunkServer, Given_MissingFile_When_Published_Then_PublishFails)
+{
+    // Given
+    wolkabout::FirmwareChunkServer server;
+
+    // When
+    const bool published = server.publish("./missingFirmwareFile");
+
+    // Then
+    ASSERT_FALSE(published);
+    ASSERT_EQ(server.size(), 0u);
+}
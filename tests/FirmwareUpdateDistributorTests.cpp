@@ -0,0 +1,150 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "service/FirmwareUpdateDistributor.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+class FirmwareUpdateDistributor : public ::testing::Test
+{
+public:
+    static std::vector<std::string> keys(const std::vector<wolkabout::FirmwareUpdateDistributor::Installation>& list)
+    {
+        std::vector<std::string> result;
+        for (const auto& installation : list)
+        {
+            result.push_back(installation.deviceKey);
+        }
+
+        return result;
+    }
+};
+}    // namespace
+
+TEST_F(FirmwareUpdateDistributor, Given_Limit_When_DevicesAreEnqueued_Then_OnlyLimitIsStarted)
+{
+    // Given
+    wolkabout::FirmwareUpdateDistributor distributor{2};
+
+    // When
+    const auto started = distributor.enqueue({"d1", "d2", "d3", "d4"}, "firmware.bin");
+
+    // Then
+    ASSERT_EQ(keys(started), (std::vector<std::string>{"d1", "d2"}));
+    ASSERT_EQ(started.front().filePath, "firmware.bin");
+    ASSERT_EQ(distributor.activeCount(), 2u);
+    ASSERT_EQ(distributor.queuedCount(), 2u);
+}
+
+TEST_F(FirmwareUpdateDistributor, Given_FullSlots_When_InstallationFinishes_Then_NextQueuedDeviceIsStarted)
+{
+    // Given
+    wolkabout::FirmwareUpdateDistributor distributor{1};
+    distributor.enqueue({"d1", "d2", "d3"}, "firmware.bin");
+
+    // When
+    const auto started = distributor.finished("d1");
+
+    // Then
+    ASSERT_EQ(keys(started), std::vector<std::string>{"d2"});
+    ASSERT_TRUE(distributor.isActive("d2"));
+    ASSERT_FALSE(distributor.isActive("d1"));
+    ASSERT_TRUE(distributor.finished("unknown").empty());
+}
+
+TEST_F(FirmwareUpdateDistributor, Given_QueuedDevice_When_Cancelled_Then_ItIsNeverStarted)
+{
+    // Given
+    wolkabout::FirmwareUpdateDistributor distributor{1};
+    distributor.enqueue({"d1", "d2", "d3"}, "firmware.bin");
+
+    // When
+    ASSERT_TRUE(distributor.cancel("d2"));
+
+    // Then
+    ASSERT_FALSE(distributor.cancel("d1"));
+    ASSERT_EQ(keys(distributor.finished("d1")), std::vector<std::string>{"d3"});
+    ASSERT_EQ(distributor.queuedCount(), 0u);
+}
+
+TEST_F(FirmwareUpdateDistributor, Given_NoLimit_When_DevicesAreEnqueued_Then_AllAreStartedOnce)
+{
+    // Given
+    wolkabout::FirmwareUpdateDistributor distributor;
+
+    // When
+    const auto started = distributor.enqueue({"d1", "d2", "d1"}, "firmware.bin");
+
+    // Then
+    ASSERT_EQ(keys(started), (std::vector<std::string>{"d1", "d2"}));
+    ASSERT_TRUE(distributor.enqueue({"d2"}, "firmware.bin").empty());
+}
+
+TEST_F(FirmwareUpdateDistributor, Given_StartedDevice_When_ItReportsProgress_Then_StateMovesToInstalling)
+{
+    // Given
+    wolkabout::FirmwareUpdateDistributor distributor{1};
+    distributor.enqueue({"d1", "d2"}, "firmware.bin");
+    ASSERT_EQ(distributor.getState("d1"), wolkabout::FirmwareUpdateDistributor::State::COMMANDED);
+    ASSERT_EQ(distributor.getState("d2"), wolkabout::FirmwareUpdateDistributor::State::QUEUED);
+
+    // When
+    ASSERT_TRUE(distributor.installing("d1"));
+
+    // Then
+    ASSERT_FALSE(distributor.installing("d2"));
+    ASSERT_EQ(distributor.getState("d1"), wolkabout::FirmwareUpdateDistributor::State::INSTALLING);
+    ASSERT_EQ(distributor.getState("unknown"), wolkabout::FirmwareUpdateDistributor::State::IDLE);
+}
+
+TEST_F(FirmwareUpdateDistributor, Given_ReinstalledDevice_When_DeadlineOfEarlierInstallationPasses_Then_ItIsIgnored)
+{
+    // Given
+    wolkabout::FirmwareUpdateDistributor distributor{1};
+    const auto first = distributor.enqueue({"d1"}, "first.bin").front();
+    distributor.finished("d1");
+    const auto second = distributor.enqueue({"d1", "d2"}, "second.bin").front();
+
+    // When
+    ASSERT_FALSE(distributor.expired("d1", first.id));
+    ASSERT_TRUE(distributor.expired("d1", second.id));
+
+    // Then
+    ASSERT_EQ(distributor.getState("d1"), wolkabout::FirmwareUpdateDistributor::State::IDLE);
+    ASSERT_EQ(keys(distributor.finished("d1")), std::vector<std::string>{"d2"});
+}
+
+TEST_F(FirmwareUpdateDistributor, Given_CancelledDevice_When_EnqueuedAgain_Then_ItIsStartedOnceInNewOrder)
+{
+    // Given
+    wolkabout::FirmwareUpdateDistributor distributor{1};
+    distributor.enqueue({"d1", "d2", "d3"}, "first.bin");
+    ASSERT_TRUE(distributor.cancel("d2"));
+
+    // When
+    distributor.enqueue({"d2"}, "second.bin");
+
+    // Then
+    ASSERT_EQ(keys(distributor.finished("d1")), std::vector<std::string>{"d3"});
+    const auto started = distributor.finished("d3");
+    ASSERT_EQ(keys(started), std::vector<std::string>{"d2"});
+    ASSERT_EQ(started.front().filePath, "second.bin");
+    ASSERT_TRUE(distributor.finished("d2").empty());
+}
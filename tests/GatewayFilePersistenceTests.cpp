@@ -0,0 +1,239 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/Message.h"
+#include "persistence/filesystem/GatewayFilePersistence.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include <dirent.h>
+#include <unistd.h>
+
+namespace
+{
+class GatewayFilePersistence : public ::testing::Test
+{
+public:
+    void SetUp() override { removeDirectory(); }
+
+    void TearDown() override { removeDirectory(); }
+
+    static void removeDirectory()
+    {
+        if (DIR* dir = opendir(PERSISTENCE_DIRECTORY))
+        {
+            while (struct dirent* entry = readdir(dir))
+            {
+                const std::string name{entry->d_name};
+                if (name != "." && name != "..")
+                {
+                    std::remove((std::string(PERSISTENCE_DIRECTORY) + "/" + name).c_str());
+                }
+            }
+            closedir(dir);
+        }
+
+        rmdir(PERSISTENCE_DIRECTORY);
+    }
+
+    static std::shared_ptr<wolkabout::Message> makeMessage(int index)
+    {
+        return std::make_shared<wolkabout::Message>("payload " + std::to_string(index),
+                                                    "d2p/sensor_reading/g/GATEWAY/r/" + std::to_string(index));
+    }
+
+    static constexpr const char* PERSISTENCE_DIRECTORY = "testsGatewayFilePersistence";
+};
+}    // namespace
+
+TEST_F(GatewayFilePersistence, Given_EmptyPersistence_When_MessagesArePushed_Then_MessagesArePoppedInOrder)
+{
+    // Given
+    wolkabout::GatewayFilePersistence persistence{PERSISTENCE_DIRECTORY, 256, 64 * 1024};
+    ASSERT_TRUE(persistence.empty());
+
+    // When
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(persistence.push(makeMessage(i)));
+    }
+
+    // Then
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_FALSE(persistence.empty());
+
+        const auto front = persistence.front();
+        const auto message = persistence.pop();
+        ASSERT_NE(message, nullptr);
+        ASSERT_EQ(front->getChannel(), message->getChannel());
+        ASSERT_EQ(message->getChannel(), makeMessage(i)->getChannel());
+        ASSERT_EQ(message->getContent(), makeMessage(i)->getContent());
+    }
+
+    ASSERT_TRUE(persistence.empty());
+    ASSERT_EQ(persistence.pop(), nullptr);
+}
+
+TEST_F(GatewayFilePersistence, Given_StoredMessages_When_PersistenceIsReopened_Then_UnreadMessagesAreRecovered)
+{
+    // Given
+    {
+        wolkabout::GatewayFilePersistence persistence{PERSISTENCE_DIRECTORY, 256, 64 * 1024};
+        for (int i = 0; i < 20; ++i)
+        {
+            persistence.push(makeMessage(i));
+        }
+
+        for (int i = 0; i < 5; ++i)
+        {
+            persistence.pop();
+        }
+    }
+
+    // When
+    wolkabout::GatewayFilePersistence persistence{PERSISTENCE_DIRECTORY, 256, 64 * 1024};
+
+    // Then
+    for (int i = 5; i < 20; ++i)
+    {
+        const auto message = persistence.pop();
+        ASSERT_NE(message, nullptr);
+        ASSERT_EQ(message->getContent(), makeMessage(i)->getContent());
+    }
+
+    ASSERT_TRUE(persistence.empty());
+
+    persistence.push(makeMessage(20));
+    ASSERT_EQ(persistence.pop()->getContent(), makeMessage(20)->getContent());
+}
+
+TEST_F(GatewayFilePersistence, Given_FullPersistence_When_MessageIsPushed_Then_MessageIsRejected)
+{
+    // Given
+    wolkabout::GatewayFilePersistence persistence{PERSISTENCE_DIRECTORY, 128, 256};
+
+    // When
+    int pushed = 0;
+    while (persistence.push(makeMessage(pushed)))
+    {
+        ++pushed;
+        ASSERT_LT(pushed, 100);
+    }
+
+    // Then
+    ASSERT_GT(pushed, 0);
+    persistence.pop();
+    persistence.pop();
+    ASSERT_TRUE(persistence.push(makeMessage(pushed)));
+}
+
+TEST_F(GatewayFilePersistence, Given_MessagesInSeveralSegments_When_BatchIsTaken_Then_MessagesAreReturnedInOrder)
+{
+    // Given
+    wolkabout::GatewayFilePersistence persistence{PERSISTENCE_DIRECTORY, 256, 64 * 1024};
+    for (int i = 0; i < 10; ++i)
+    {
+        persistence.push(makeMessage(i));
+    }
+
+    // When
+    const auto batch = persistence.frontBatch(7);
+    const auto removed = persistence.popBatch(7);
+
+    // Then
+    ASSERT_EQ(batch.size(), 7u);
+    ASSERT_EQ(removed, 7u);
+    for (int i = 0; i < 7; ++i)
+    {
+        ASSERT_EQ(batch[static_cast<std::size_t>(i)]->getContent(), makeMessage(i)->getContent());
+    }
+
+    ASSERT_EQ(persistence.frontBatch(10).size(), 3u);
+    ASSERT_EQ(persistence.front()->getContent(), makeMessage(7)->getContent());
+    ASSERT_EQ(persistence.popBatch(10), 3u);
+    ASSERT_TRUE(persistence.empty());
+}
+
+TEST_F(GatewayFilePersistence, Given_SingleSegmentPersistence_When_FilledDrainedAndRefilled_Then_MessagesAreAccepted)
+{
+    // Given
+    wolkabout::GatewayFilePersistence persistence{PERSISTENCE_DIRECTORY, 256, 256};
+
+    int pushed = 0;
+    while (persistence.push(makeMessage(pushed)))
+    {
+        ++pushed;
+        ASSERT_LT(pushed, 100);
+    }
+
+    ASSERT_GT(pushed, 0);
+    for (int i = 0; i < pushed; ++i)
+    {
+        ASSERT_EQ(persistence.pop()->getContent(), makeMessage(i)->getContent());
+    }
+
+    ASSERT_TRUE(persistence.empty());
+
+    // When
+    int refilled = 0;
+    while (persistence.push(makeMessage(pushed + refilled)))
+    {
+        ++refilled;
+        ASSERT_LT(refilled, 100);
+    }
+
+    // Then
+    ASSERT_EQ(refilled, pushed);
+    for (int i = 0; i < refilled; ++i)
+    {
+        ASSERT_EQ(persistence.pop()->getContent(), makeMessage(pushed + i)->getContent());
+    }
+
+    ASSERT_TRUE(persistence.empty());
+}
+
+TEST_F(GatewayFilePersistence, Given_RewoundSegment_When_PersistenceIsReopened_Then_OnlyNewMessagesAreRecovered)
+{
+    // Given
+    int pushed = 0;
+    {
+        wolkabout::GatewayFilePersistence persistence{PERSISTENCE_DIRECTORY, 256, 256};
+        while (persistence.push(makeMessage(pushed)))
+        {
+            ++pushed;
+            ASSERT_LT(pushed, 100);
+        }
+
+        while (persistence.pop())
+        {
+        }
+
+        ASSERT_TRUE(persistence.push(makeMessage(pushed)));
+    }
+
+    // When
+    wolkabout::GatewayFilePersistence persistence{PERSISTENCE_DIRECTORY, 256, 256};
+
+    // Then
+    const auto message = persistence.pop();
+    ASSERT_NE(message, nullptr);
+    ASSERT_EQ(message->getContent(), makeMessage(pushed)->getContent());
+    ASSERT_TRUE(persistence.empty());
+}
@@ -0,0 +1,89 @@
+#define private public
+#define protected public
+#include "Wolk.h"
+#include "service/GatewayUpdateService.h"
+#undef protected
+#undef private
+#include "GatewayHost.h"
+#include "model/GatewayDevice.h"
+#include "model/SubdeviceManagement.h"
+
+#include <gtest/gtest.h>
+#include <ftw.h>
+#include <stdexcept>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+namespace
+{
+class GatewayHost : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        char storage[] = "/tmp/gatewayHostTestXXXXXX";
+        ASSERT_NE(mkdtemp(storage), nullptr);
+        m_storageDirectory = storage;
+    }
+
+    void TearDown() override
+    {
+        nftw(m_storageDirectory.c_str(),
+             [](const char* path, const struct stat*, int, struct FTW*) { return remove(path); }, 16,
+             FTW_DEPTH | FTW_PHYS);
+    }
+
+    static wolkabout::GatewayDevice device(const std::string& key)
+    {
+        return wolkabout::GatewayDevice(key, GATEWAY_PASSWORD, wolkabout::SubdeviceManagement::GATEWAY);
+    }
+
+    static constexpr const char* GATEWAY_PASSWORD = "gateway_password";
+
+    std::string m_storageDirectory;
+};
+}    // namespace
+
+TEST_F(GatewayHost, Given_TwoGateways_When_AddedToHost_Then_TheyShareExecutor)
+{
+    // Given
+    wolkabout::GatewayHost host{m_storageDirectory, 2};
+
+    // When
+    auto& first = host.addGateway(device("hosted_gateway_1"));
+    auto& second = host.addGateway(device("hosted_gateway_2"));
+
+    // Then
+    ASSERT_EQ(host.getGatewayCount(), 2u);
+    ASSERT_EQ(first.m_executor, second.m_executor);
+    ASSERT_EQ(host.getGateway("hosted_gateway_2"), &second);
+    ASSERT_EQ(host.getGateway("unknown_gateway"), nullptr);
+}
+
+TEST_F(GatewayHost, Given_HostedGateway_When_SameKeyIsAdded_Then_ExceptionIsThrown)
+{
+    // Given
+    wolkabout::GatewayHost host{m_storageDirectory, 1};
+    host.addGateway(device("hosted_gateway_1"));
+
+    // Then
+    ASSERT_THROW(host.addGateway(device("hosted_gateway_1")), std::logic_error);
+    ASSERT_EQ(host.getGatewayCount(), 1u);
+}
+
+TEST_F(GatewayHost, Given_TwoHostedGateways_When_BothConnect_Then_BothSendGatewayUpdate)
+{
+    // Given
+    wolkabout::GatewayHost host{m_storageDirectory, 2};
+    auto& first = host.addGateway(device("hosted_gateway_1"));
+    auto& second = host.addGateway(device("hosted_gateway_2"));
+
+    // When
+    first.updateGatewayAndDeleteDevices();
+    second.updateGatewayAndDeleteDevices();
+
+    // Then
+    ASSERT_NE(first.m_gatewayUpdateService->m_pendingUpdateRequest, nullptr);
+    ASSERT_NE(second.m_gatewayUpdateService->m_pendingUpdateRequest, nullptr);
+}
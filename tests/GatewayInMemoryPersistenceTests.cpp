@@ -0,0 +1,103 @@
+#include "model/Message.h"
+#include "persistence/inmemory/GatewayInMemoryPersistence.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class GatewayInMemoryPersistence : public ::testing::Test
+{
+public:
+    static std::shared_ptr<wolkabout::Message> message(const std::string& channel, const std::string& content)
+    {
+        return std::make_shared<wolkabout::Message>(content, channel);
+    }
+
+    static std::string contents(const std::vector<std::shared_ptr<wolkabout::Message>>& messages)
+    {
+        std::string joined;
+        for (const auto& queued : messages)
+        {
+            joined += queued->getContent();
+        }
+
+        return joined;
+    }
+};
+}    // namespace
+
+TEST_F(GatewayInMemoryPersistence, Given_FullQueueDroppingOldest_When_MessageIsPushed_Then_OldestMessageIsRemoved)
+{
+    // Given
+    wolkabout::GatewayInMemoryPersistence persistence{
+      2, 0, wolkabout::GatewayInMemoryPersistence::OverflowPolicy::DROP_OLDEST};
+    ASSERT_TRUE(persistence.push(message("c", "a")));
+    ASSERT_TRUE(persistence.push(message("c", "b")));
+
+    // When
+    const bool pushed = persistence.push(message("c", "c"));
+
+    // Then
+    ASSERT_TRUE(pushed);
+    ASSERT_EQ(contents(persistence.frontBatch(10)), "bc");
+}
+
+TEST_F(GatewayInMemoryPersistence, Given_ByteLimitDroppingNewest_When_MessageDoesNotFit_Then_MessageIsRejected)
+{
+    // Given
+    wolkabout::GatewayInMemoryPersistence persistence{
+      0, 4, wolkabout::GatewayInMemoryPersistence::OverflowPolicy::DROP_NEWEST};
+    ASSERT_TRUE(persistence.push(message("c", "a")));
+
+    // When
+    const bool pushed = persistence.push(message("c", "bcd"));
+
+    // Then
+    ASSERT_FALSE(pushed);
+    ASSERT_TRUE(persistence.push(message("c", "b")));
+    ASSERT_EQ(contents(persistence.frontBatch(10)), "ab");
+}
+
+TEST_F(GatewayInMemoryPersistence,
+       Given_FullQueueDownsampling_When_MessageIsPushed_Then_OldestMessageOnItsChannelIsRemoved)
+{
+    // Given
+    wolkabout::GatewayInMemoryPersistence persistence{
+      3, 0, wolkabout::GatewayInMemoryPersistence::OverflowPolicy::DOWNSAMPLE};
+    ASSERT_TRUE(persistence.push(message("T", "1")));
+    ASSERT_TRUE(persistence.push(message("H", "2")));
+    ASSERT_TRUE(persistence.push(message("H", "3")));
+
+    // When
+    const bool pushed = persistence.push(message("H", "4"));
+
+    // Then
+    ASSERT_TRUE(pushed);
+    ASSERT_FALSE(persistence.push(message("P", "5")));
+    ASSERT_EQ(contents(persistence.frontBatch(10)), "134");
+}
+
+TEST_F(GatewayInMemoryPersistence, Given_FullQueueSpilling_When_MessagesArePushed_Then_TheyAreDrainedInOrder)
+{
+    // Given
+    auto spill = new wolkabout::GatewayInMemoryPersistence();
+    wolkabout::GatewayInMemoryPersistence persistence{
+      1, 0, wolkabout::GatewayInMemoryPersistence::OverflowPolicy::SPILL,
+      std::unique_ptr<wolkabout::GatewayPersistence>(spill)};
+    ASSERT_TRUE(persistence.push(message("c", "a")));
+
+    // When
+    ASSERT_TRUE(persistence.push(message("c", "b")));
+    ASSERT_EQ(persistence.pop()->getContent(), "a");
+    ASSERT_TRUE(persistence.push(message("c", "c")));
+
+    // Then
+    ASSERT_FALSE(spill->empty());
+    ASSERT_EQ(contents(persistence.frontBatch(10)), "bc");
+    ASSERT_EQ(persistence.popBatch(10), 2u);
+    ASSERT_TRUE(persistence.empty());
+    ASSERT_EQ(persistence.front(), nullptr);
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "GatewayInboundDeviceMessageHandler.h"
+#include "InboundDeviceMessageHandler.h"
+#include "protocol/GatewayProtocol.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class Protocol : public wolkabout::GatewayProtocol
+{
+public:
+    std::vector<std::string> getInboundChannels() const override { return {"d2p/sensor_reading/d/+/r/#"}; }
+
+    std::vector<std::string> getInboundChannelsForDevice(const std::string& deviceKey) const override
+    {
+        return {"d2p/sensor_reading/d/" + deviceKey + "/r/#"};
+    }
+};
+
+class Listener : public wolkabout::DeviceMessageListener
+{
+public:
+    void deviceMessageReceived(std::shared_ptr<wolkabout::Message> /* message */) override {}
+
+    const wolkabout::GatewayProtocol& getGatewayProtocol() const override { return protocol; }
+
+    Protocol protocol;
+};
+
+class GatewayInboundDeviceMessageHandler : public ::testing::Test
+{
+public:
+    wolkabout::GatewayInboundDeviceMessageHandler handler;
+    std::shared_ptr<Listener> listener = std::make_shared<Listener>();
+};
+}    // namespace
+
+TEST_F(GatewayInboundDeviceMessageHandler, Given_Listener_When_Added_Then_WildcardChannelsAreSubscribed)
+{
+    // When
+    handler.addListener(listener);
+
+    // Then
+    ASSERT_EQ(handler.getChannels(), std::vector<std::string>{"d2p/sensor_reading/d/+/r/#"});
+}
+
+TEST_F(GatewayInboundDeviceMessageHandler, Given_PerDeviceListener_When_DevicesChange_Then_OnlyTheirChannelsAreReturned)
+{
+    // Given
+    int changes = 0;
+    handler.addPerDeviceListener(listener);
+    handler.setSubscriptionListener([&] { ++changes; });
+    ASSERT_TRUE(handler.getChannels().empty());
+
+    // When
+    ASSERT_TRUE(handler.subscribeDevice("DEVICE_1"));
+    ASSERT_TRUE(handler.subscribeDevice("DEVICE_2"));
+    ASSERT_FALSE(handler.subscribeDevice("DEVICE_1"));
+    ASSERT_TRUE(handler.unsubscribeDevice("DEVICE_1"));
+    ASSERT_FALSE(handler.unsubscribeDevice("DEVICE_3"));
+
+    // Then
+    ASSERT_EQ(handler.getChannels(), std::vector<std::string>{"d2p/sensor_reading/d/DEVICE_2/r/#"});
+    ASSERT_EQ(changes, 3);
+}
@@ -0,0 +1,93 @@
+#include "model/Message.h"
+#include "persistence/inmemory/GatewayRingBufferPersistence.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class GatewayRingBufferPersistence : public ::testing::Test
+{
+public:
+    static std::shared_ptr<wolkabout::Message> message(const std::string& content)
+    {
+        return std::make_shared<wolkabout::Message>(content, "channel");
+    }
+};
+}    // namespace
+
+TEST_F(GatewayRingBufferPersistence, Given_FullRing_When_MessageIsPushed_Then_ItIsRejectedUntilMessageIsPopped)
+{
+    // Given
+    wolkabout::GatewayRingBufferPersistence persistence{3};
+    ASSERT_EQ(persistence.capacity(), 4u);
+    for (const auto& content : {"a", "b", "c", "d"})
+    {
+        ASSERT_TRUE(persistence.push(message(content)));
+    }
+
+    // When
+    const bool pushed = persistence.push(message("e"));
+
+    // Then
+    ASSERT_FALSE(pushed);
+    ASSERT_EQ(persistence.pop()->getContent(), "a");
+    ASSERT_TRUE(persistence.push(message("e")));
+
+    const auto messages = persistence.frontBatch(10);
+    ASSERT_EQ(messages.size(), 4u);
+    ASSERT_EQ(messages.front()->getContent(), "b");
+    ASSERT_EQ(messages.back()->getContent(), "e");
+
+    ASSERT_EQ(persistence.popBatch(10), 4u);
+    ASSERT_TRUE(persistence.empty());
+    ASSERT_EQ(persistence.front(), nullptr);
+}
+
+TEST_F(GatewayRingBufferPersistence, Given_ConcurrentProducers_When_ConsumerDrains_Then_EveryMessageIsReceivedOnce)
+{
+    // Given
+    const int producers = 4;
+    const int messagesPerProducer = 2000;
+    wolkabout::GatewayRingBufferPersistence persistence{64};
+
+    std::vector<std::thread> threads;
+    for (int producer = 0; producer < producers; ++producer)
+    {
+        threads.emplace_back([&, producer] {
+            for (int i = 0; i < messagesPerProducer; ++i)
+            {
+                const auto pushed = message(std::to_string(producer * messagesPerProducer + i));
+                while (!persistence.push(pushed))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    // When
+    std::set<std::string> received;
+    while (received.size() < static_cast<std::size_t>(producers * messagesPerProducer))
+    {
+        const auto messages = persistence.frontBatch(16);
+        for (const auto& batchMessage : messages)
+        {
+            ASSERT_TRUE(received.insert(batchMessage->getContent()).second);
+        }
+
+        ASSERT_EQ(persistence.popBatch(messages.size()), messages.size());
+    }
+
+    // Then
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    ASSERT_TRUE(persistence.empty());
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/IngestQueue.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace
+{
+class IngestQueue : public ::testing::Test
+{
+public:
+    wolkabout::IngestQueue<std::string> queue;
+};
+}    // namespace
+
+TEST_F(IngestQueue, Given_PushedValues_When_Drained_Then_ValuesAreReturnedInPushOrder)
+{
+    // Given
+    queue.push("first");
+    queue.push("second");
+    queue.push("third");
+
+    // When
+    const auto values = queue.drain();
+
+    // Then
+    ASSERT_EQ(values, (std::vector<std::string>{"first", "second", "third"}));
+    ASSERT_TRUE(queue.empty());
+    ASSERT_TRUE(queue.drain().empty());
+}
+
+TEST_F(IngestQueue, Given_ConcurrentProducers_When_Drained_Then_EveryValueIsReturnedOnceInPerThreadOrder)
+{
+    // Given
+    const int threadCount = 8;
+    const int valuesPerThread = 10000;
+
+    wolkabout::IngestQueue<std::pair<int, int>> values;
+
+    // When
+    std::vector<std::thread> producers;
+    for (int thread = 0; thread < threadCount; ++thread)
+    {
+        producers.emplace_back([&values, thread] {
+            for (int value = 0; value < valuesPerThread; ++value)
+            {
+                values.push(std::make_pair(thread, value));
+            }
+        });
+    }
+
+    std::vector<std::pair<int, int>> drained;
+    while (drained.size() < static_cast<std::size_t>(threadCount * valuesPerThread))
+    {
+        for (const auto& value : values.drain())
+        {
+            drained.push_back(value);
+        }
+    }
+
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+
+    // Then
+    std::vector<int> next(threadCount, 0);
+    for (const auto& value : drained)
+    {
+        ASSERT_EQ(value.second, next[static_cast<std::size_t>(value.first)]++);
+    }
+    ASSERT_TRUE(values.empty());
+}
+
+TEST_F(IngestQueue, Given_UndrainedValues_When_QueueIsDestroyed_Then_ValuesAreReleased)
+{
+    // Given
+    auto value = std::make_shared<int>(1);
+    {
+        wolkabout::IngestQueue<std::shared_ptr<int>> values;
+        values.push(value);
+        ASSERT_EQ(value.use_count(), 2);
+    }
+
+    // Then
+    ASSERT_EQ(value.use_count(), 1);
+}
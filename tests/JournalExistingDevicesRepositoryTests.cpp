@@ -0,0 +1,91 @@
+#include "repository/JournalExistingDevicesRepository.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class JournalExistingDevicesRepository : public ::testing::Test
+{
+public:
+    void TearDown() override
+    {
+        std::remove(JOURNAL_PATH);
+        std::remove(LEGACY_PATH);
+    }
+
+    static std::unique_ptr<wolkabout::JournalExistingDevicesRepository> open()
+    {
+        return std::unique_ptr<wolkabout::JournalExistingDevicesRepository>(
+          new wolkabout::JournalExistingDevicesRepository(JOURNAL_PATH, LEGACY_PATH));
+    }
+
+    static void write(const char* path, const std::string& content)
+    {
+        std::ofstream file{path, std::ios::binary | std::ios::trunc};
+        file << content;
+    }
+
+    static std::string read(const char* path)
+    {
+        std::ifstream file{path, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    }
+
+    static constexpr const char* JOURNAL_PATH = "testExistingDevices.journal";
+    static constexpr const char* LEGACY_PATH = "testExistingDevices.json";
+};
+
+constexpr const char* JournalExistingDevicesRepository::JOURNAL_PATH;
+constexpr const char* JournalExistingDevicesRepository::LEGACY_PATH;
+}    // namespace
+
+TEST_F(JournalExistingDevicesRepository, Given_AddedKeys_When_Reopened_Then_KeysAreRestoredInOrderWithoutDuplicates)
+{
+    // Given
+    auto repository = open();
+    repository->addDeviceKey("device1");
+    repository->addDeviceKey("device2");
+    repository->addDeviceKey("device1");
+
+    // When
+    repository.reset();
+    repository = open();
+
+    // Then
+    ASSERT_EQ(repository->getDeviceKeys(), (std::vector<std::string>{"device1", "device2"}));
+    ASSERT_EQ(read(JOURNAL_PATH), "device1\ndevice2\n");
+}
+
+TEST_F(JournalExistingDevicesRepository,
+       Given_JournalWithDuplicateAndPartiallyWrittenLines_When_Opened_Then_JournalIsCompacted)
+{
+    // Given
+    write(JOURNAL_PATH, "device1\ndevice2\n\ndevice1\ndevi");
+
+    // When
+    auto repository = open();
+    repository->addDeviceKey("device3");
+
+    // Then
+    ASSERT_EQ(repository->getDeviceKeys(), (std::vector<std::string>{"device1", "device2", "device3"}));
+    ASSERT_EQ(read(JOURNAL_PATH), "device1\ndevice2\ndevice3\n");
+}
+
+TEST_F(JournalExistingDevicesRepository, Given_LegacyJsonFile_When_JournalDoesNotExist_Then_KeysAreImported)
+{
+    // Given
+    write(LEGACY_PATH, R"({"deviceKeys": ["device1", "device2"]})");
+
+    // When
+    auto repository = open();
+
+    // Then
+    ASSERT_EQ(repository->getDeviceKeys(), (std::vector<std::string>{"device1", "device2"}));
+    ASSERT_EQ(read(JOURNAL_PATH), "device1\ndevice2\n");
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "persistence/filesystem/JournalPersistence.h"
+#include "model/ActuatorStatus.h"
+#include "model/Alarm.h"
+#include "model/ConfigurationItem.h"
+#include "model/SensorReading.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+const std::string JOURNAL_FILE = "journalPersistenceTest.journal";
+
+class JournalPersistence : public ::testing::Test
+{
+public:
+    void SetUp() override { std::remove(JOURNAL_FILE.c_str()); }
+
+    void TearDown() override { std::remove(JOURNAL_FILE.c_str()); }
+
+    static std::string journalContent()
+    {
+        std::ifstream journal{JOURNAL_FILE, std::ios::binary};
+        return {std::istreambuf_iterator<char>{journal}, std::istreambuf_iterator<char>{}};
+    }
+};
+}    // namespace
+
+TEST_F(JournalPersistence, Given_StoredItems_When_PersistenceIsReopened_Then_ItemsAreRecovered)
+{
+    // Given
+    {
+        wolkabout::JournalPersistence persistence{JOURNAL_FILE};
+        persistence.putSensorReading("T", std::make_shared<wolkabout::SensorReading>("21.5", "T", 1));
+        persistence.putSensorReading("T", std::make_shared<wolkabout::SensorReading>("22", "T", 2));
+        persistence.putSensorReading("T", std::make_shared<wolkabout::SensorReading>("23", "T", 3));
+        persistence.removeSensorReadings("T", 1);
+        persistence.putAlarm("HH", std::make_shared<wolkabout::Alarm>(true, "HH", 4));
+        persistence.putActuatorStatus(
+          "SW", std::make_shared<wolkabout::ActuatorStatus>("true", "SW", wolkabout::ActuatorStatus::State::BUSY));
+        persistence.putConfiguration("GATEWAY_KEY", std::make_shared<std::vector<wolkabout::ConfigurationItem>>(
+                                                      std::vector<wolkabout::ConfigurationItem>{
+                                                        wolkabout::ConfigurationItem{{"1", "2"}, "CFG"}}));
+    }
+
+    // When
+    wolkabout::JournalPersistence persistence{JOURNAL_FILE};
+
+    // Then
+    const auto sensorReadings = persistence.getSensorReadings("T", 10);
+    ASSERT_EQ(sensorReadings.size(), 2u);
+    ASSERT_EQ(sensorReadings[0]->getValues(), std::vector<std::string>{"22"});
+    ASSERT_EQ(sensorReadings[1]->getRtc(), 3u);
+
+    const auto alarms = persistence.getAlarms("HH", 10);
+    ASSERT_EQ(alarms.size(), 1u);
+    ASSERT_TRUE(alarms.front()->getActive());
+
+    const auto actuatorStatus = persistence.getActuatorStatus("SW");
+    ASSERT_NE(actuatorStatus, nullptr);
+    ASSERT_EQ(actuatorStatus->getValue(), "true");
+    ASSERT_EQ(actuatorStatus->getState(), wolkabout::ActuatorStatus::State::BUSY);
+
+    const auto configuration = persistence.getConfiguration("GATEWAY_KEY");
+    ASSERT_NE(configuration, nullptr);
+    ASSERT_EQ(configuration->size(), 1u);
+    ASSERT_EQ(configuration->front().getReference(), "CFG");
+    ASSERT_EQ(configuration->front().getValues(), (std::vector<std::string>{"1", "2"}));
+}
+
+TEST_F(JournalPersistence, Given_AllItemsRemoved_When_PersistenceIsEmpty_Then_JournalIsTruncated)
+{
+    // Given
+    wolkabout::JournalPersistence persistence{JOURNAL_FILE};
+    persistence.putSensorReading("T", std::make_shared<wolkabout::SensorReading>("21.5", "T", 1));
+    persistence.putAlarm("HH", std::make_shared<wolkabout::Alarm>(false, "HH", 2));
+    ASSERT_FALSE(journalContent().empty());
+
+    // When
+    persistence.removeSensorReadings("T", 1);
+    persistence.removeAlarms("HH", 1);
+
+    // Then
+    ASSERT_TRUE(persistence.isEmpty());
+    ASSERT_TRUE(journalContent().empty());
+}
+
+TEST_F(JournalPersistence, Given_PartiallyWrittenEntry_When_PersistenceIsOpened_Then_EntryIsDiscarded)
+{
+    // Given
+    {
+        wolkabout::JournalPersistence persistence{JOURNAL_FILE};
+        persistence.putSensorReading("T", std::make_shared<wolkabout::SensorReading>("21.5", "T", 1));
+    }
+    {
+        std::ofstream journal{JOURNAL_FILE, std::ios::binary | std::ios::app};
+        journal << R"({"type":"sensor_reading","key":"T","refer)";
+    }
+
+    // When
+    wolkabout::JournalPersistence persistence{JOURNAL_FILE};
+
+    // Then
+    ASSERT_EQ(persistence.getSensorReadings("T", 10).size(), 1u);
+    ASSERT_EQ(journalContent().back(), '\n');
+}
+
+TEST_F(JournalPersistence, Given_JournalPastCompactionLimit_When_ItemIsStored_Then_JournalHoldsOnlyCurrentItems)
+{
+    // Given
+    wolkabout::JournalPersistence persistence{JOURNAL_FILE, 4};
+    persistence.putSensorReading("T", std::make_shared<wolkabout::SensorReading>("1", "T", 1));
+    persistence.putSensorReading("T", std::make_shared<wolkabout::SensorReading>("2", "T", 2));
+    persistence.removeSensorReadings("T", 1);
+
+    // When
+    persistence.putSensorReading("T", std::make_shared<wolkabout::SensorReading>("3", "T", 3));
+
+    // Then
+    const std::string content = journalContent();
+    ASSERT_EQ(std::count(content.begin(), content.end(), '\n'), 2);
+    ASSERT_EQ(content.find("remove"), std::string::npos);
+}
@@ -310,3 +310,104 @@ TEST_F(JsonGatewayDataProtocol, Given_Channels_When_DeviceChannelsAreRequested_T
         ASSERT_TRUE(it != deviceChannels.end());
     }
 }
+
+TEST_F(JsonGatewayDataProtocol, Given_SensorReadingChannel_When_ChannelIsParsed_Then_TypeDeviceKeyAndReferenceAreFound)
+{
+    // Given
+    const std::string channel = "d2p/sensor_reading/d/DEVICE_KEY/r/REF/";
+
+    // When
+    const wolkabout::DataChannelView view = protocol->parseDeviceChannel(channel);
+
+    // Then
+    ASSERT_EQ(wolkabout::DataChannelView::Type::SENSOR_READING, view.getType());
+    ASSERT_EQ("DEVICE_KEY", view.getDeviceKey());
+    ASSERT_EQ("REF", view.getReference());
+}
+
+TEST_F(JsonGatewayDataProtocol, Given_ConfigurationChannel_When_ChannelIsParsed_Then_DeviceKeyIsFoundWithoutReference)
+{
+    // Given
+    const std::string channel = "d2p/configuration_get/d/DEVICE_KEY";
+
+    // When
+    const wolkabout::DataChannelView view = protocol->parseDeviceChannel(channel);
+
+    // Then
+    ASSERT_EQ(wolkabout::DataChannelView::Type::CONFIGURATION_CURRENT, view.getType());
+    ASSERT_EQ("DEVICE_KEY", view.getDeviceKey());
+    ASSERT_FALSE(view.hasReference());
+}
+
+TEST_F(JsonGatewayDataProtocol, Given_EventAndActuatorStatusChannels_When_ChannelsAreParsed_Then_TypesAreRecognized)
+{
+    // Given
+    const std::string eventChannel = "d2p/events/d/DEVICE_KEY/r/ALARM";
+    const std::string actuatorStatusChannel = "d2p/actuator_status/d/DEVICE_KEY/r/SW";
+
+    // When
+    const wolkabout::DataChannelView eventView = protocol->parseDeviceChannel(eventChannel);
+    const wolkabout::DataChannelView actuatorStatusView = protocol->parseDeviceChannel(actuatorStatusChannel);
+
+    // Then
+    ASSERT_EQ(wolkabout::DataChannelView::Type::ALARM, eventView.getType());
+    ASSERT_EQ("ALARM", eventView.getReference());
+    ASSERT_EQ(wolkabout::DataChannelView::Type::ACTUATOR_STATUS, actuatorStatusView.getType());
+    ASSERT_EQ("SW", actuatorStatusView.getReference());
+}
+
+TEST_F(JsonGatewayDataProtocol, Given_PlatformChannel_When_ChannelIsParsed_Then_TypeIsUnknown)
+{
+    // Given
+    const std::string channel = "p2d/actuator_set/g/GATEWAY_KEY/d/DEVICE_KEY/r/REF";
+
+    // When
+    const wolkabout::DataChannelView view = protocol->parseDeviceChannel(channel);
+
+    // Then
+    ASSERT_EQ(wolkabout::DataChannelView::Type::UNKNOWN, view.getType());
+    ASSERT_FALSE(view.hasDeviceKey());
+    ASSERT_FALSE(view.hasReference());
+}
+
+TEST_F(JsonGatewayDataProtocol, Given_ActuatorGetCommandWithoutReference_When_MessageIsMade_Then_DeviceIsQueriedInBulk)
+{
+    // When
+    const auto message = protocol->makeMessage("DEVICE_KEY", wolkabout::ActuatorGetCommand(""));
+
+    // Then
+    ASSERT_EQ("p2d/actuator_get/d/DEVICE_KEY", message->getChannel());
+}
+
+TEST_F(JsonGatewayDataProtocol, Given_ActuatorStatusBatch_When_BatchIsSplit_Then_MessageIsMadePerReference)
+{
+    // Given
+    const std::string payload = "[{\"reference\":\"SW\",\"status\":\"READY\",\"value\":\"true\"},"
+                                "{\"reference\":\"SL\",\"status\":\"BUSY\",\"value\":\"5\"}]";
+
+    // When
+    const auto messages = protocol->splitActuatorStatusBatch("d2p/actuator_status/d/DEVICE_KEY", payload);
+
+    // Then
+    ASSERT_EQ(messages.size(), 2u);
+    ASSERT_EQ("d2p/actuator_status/d/DEVICE_KEY/r/SW", messages[0]->getChannel());
+    ASSERT_EQ("{\"status\":\"READY\",\"value\":\"true\"}", messages[0]->getContent());
+    ASSERT_EQ("d2p/actuator_status/d/DEVICE_KEY/r/SL", messages[1]->getChannel());
+    ASSERT_TRUE(protocol->splitActuatorStatusBatch("d2p/actuator_status/d/DEVICE_KEY", "[{\"status\":\"READY\"}]")
+                  .empty());
+}
+
+TEST_F(JsonGatewayDataProtocol, Given_TwoConfigurationSetRequests_When_Merged_Then_LaterValuesReplaceEarlierOnes)
+{
+    // Given
+    const std::string payload = "{\"values\":{\"HB\":\"10\",\"LL\":\"INFO\"}}";
+    const std::string laterPayload = "{\"values\":{\"HB\":\"30\",\"EN\":\"true\"}}";
+
+    // When
+    const auto merged = protocol->mergeConfigurationSet(payload, laterPayload);
+
+    // Then
+    ASSERT_EQ("{\"values\":{\"EN\":\"true\",\"HB\":\"30\",\"LL\":\"INFO\"}}", merged);
+    ASSERT_TRUE(protocol->mergeConfigurationSet(payload, "[1,2]").empty());
+    ASSERT_TRUE(protocol->mergeConfigurationSet("not json", laterPayload).empty());
+}
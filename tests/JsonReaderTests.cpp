@@ -0,0 +1,88 @@
+#include "utilities/JsonReader.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+class JsonReader : public ::testing::Test
+{
+};
+}    // namespace
+
+TEST_F(JsonReader, Given_Object_When_MembersAreRead_Then_UnneededMembersAreSkipped)
+{
+    // Given
+    const std::string text = R"( {"skip": {"a": [1, -2.5e3, null, {"b": false}]}, "state" : "CONNECTED", "x": true} )";
+    wolkabout::JsonReader reader{text};
+
+    // When
+    std::string name;
+    std::string state;
+    ASSERT_TRUE(reader.beginObject());
+    while (reader.nextMember(name))
+    {
+        if (name == "state")
+        {
+            ASSERT_TRUE(reader.readString(state));
+        }
+        else
+        {
+            ASSERT_TRUE(reader.skipValue());
+        }
+    }
+
+    // Then
+    ASSERT_FALSE(reader.failed());
+    ASSERT_TRUE(reader.finish());
+    ASSERT_EQ(state, "CONNECTED");
+}
+
+TEST_F(JsonReader, Given_ArrayOfStrings_When_Read_Then_EscapesAreDecoded)
+{
+    // Given
+    const std::string text = R"(["plain", "q\"b\\s\/n\n", "é😀"])";
+    wolkabout::JsonReader reader{text};
+
+    // When
+    std::vector<std::string> values;
+    std::string value;
+    ASSERT_TRUE(reader.beginArray());
+    while (reader.nextElement())
+    {
+        ASSERT_TRUE(reader.readString(value));
+        values.push_back(value);
+    }
+
+    // Then
+    ASSERT_TRUE(reader.finish());
+    ASSERT_EQ(values, (std::vector<std::string>{"plain", "q\"b\\s/n\n", "\xC3\xA9\xF0\x9F\x98\x80"}));
+}
+
+TEST_F(JsonReader, Given_MalformedText_When_Read_Then_ReaderFails)
+{
+    // Given
+    const std::string missingComma = R"({"a": "1" "b": "2"})";
+    const std::string unterminated = R"({"a": "1)";
+    const std::string trailingText = R"({} {})";
+
+    // When
+    wolkabout::JsonReader missingCommaReader{missingComma};
+    wolkabout::JsonReader unterminatedReader{unterminated};
+    wolkabout::JsonReader trailingTextReader{trailingText};
+
+    // Then
+    std::string name;
+    ASSERT_TRUE(missingCommaReader.beginObject());
+    ASSERT_TRUE(missingCommaReader.nextMember(name));
+    ASSERT_TRUE(missingCommaReader.skipValue());
+    ASSERT_FALSE(missingCommaReader.nextMember(name));
+    ASSERT_TRUE(missingCommaReader.failed());
+
+    ASSERT_FALSE(unterminatedReader.skipValue());
+    ASSERT_TRUE(unterminatedReader.failed());
+
+    ASSERT_TRUE(trailingTextReader.skipValue());
+    ASSERT_FALSE(trailingTextReader.finish());
+}
@@ -0,0 +1,76 @@
+#include "model/ActuatorStatus.h"
+#include "model/Alarm.h"
+#include "model/Message.h"
+#include "model/SensorReading.h"
+#include "protocol/json/JsonProtocol.h"
+#include "protocol/json/JsonStreamingProtocol.h"
+#include "utilities/json.hpp"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class JsonStreamingProtocol : public ::testing::Test
+{
+public:
+    void expectSameMessage(const std::unique_ptr<wolkabout::Message>& expected,
+                           const std::unique_ptr<wolkabout::Message>& actual)
+    {
+        ASSERT_TRUE(expected);
+        ASSERT_TRUE(actual);
+        ASSERT_EQ(expected->getChannel(), actual->getChannel());
+        ASSERT_EQ(nlohmann::json::parse(expected->getContent()), nlohmann::json::parse(actual->getContent()));
+    }
+
+    wolkabout::JsonProtocol referenceProtocol{true};
+    wolkabout::JsonStreamingProtocol protocol{true};
+};
+}    // namespace
+
+TEST_F(JsonStreamingProtocol, Given_SensorReadings_When_MessageIsMade_Then_MessageMatchesJsonProtocol)
+{
+    // Given
+    const std::vector<std::shared_ptr<wolkabout::SensorReading>> readings{
+      std::make_shared<wolkabout::SensorReading>("21.5", "T", 1546300800000),
+      std::make_shared<wolkabout::SensorReading>(std::vector<std::string>{"1", "2", "3"}, "T", 1546300801000),
+      std::make_shared<wolkabout::SensorReading>("quote \" and \\", "T", 0)};
+
+    // When
+    const auto expected = referenceProtocol.makeMessage("GATEWAY_KEY", readings);
+    const auto actual = protocol.makeMessage("GATEWAY_KEY", readings);
+
+    // Then
+    expectSameMessage(expected, actual);
+}
+
+TEST_F(JsonStreamingProtocol, Given_Alarms_When_MessageIsMade_Then_MessageMatchesJsonProtocol)
+{
+    // Given
+    const std::vector<std::shared_ptr<wolkabout::Alarm>> alarms{
+      std::make_shared<wolkabout::Alarm>(true, "HH", 1546300800000),
+      std::make_shared<wolkabout::Alarm>(false, "HH", 1546300801000)};
+
+    // When
+    const auto expected = referenceProtocol.makeMessage("GATEWAY_KEY", alarms);
+    const auto actual = protocol.makeMessage("GATEWAY_KEY", alarms);
+
+    // Then
+    expectSameMessage(expected, actual);
+}
+
+TEST_F(JsonStreamingProtocol, Given_ActuatorStatus_When_MessageIsMade_Then_MessageMatchesJsonProtocol)
+{
+    // Given
+    const std::vector<std::shared_ptr<wolkabout::ActuatorStatus>> statuses{
+      std::make_shared<wolkabout::ActuatorStatus>("true", "SW", wolkabout::ActuatorStatus::State::BUSY)};
+
+    // When
+    const auto expected = referenceProtocol.makeMessage("GATEWAY_KEY", statuses);
+    const auto actual = protocol.makeMessage("GATEWAY_KEY", statuses);
+
+    // Then
+    expectSameMessage(expected, actual);
+}
@@ -0,0 +1,66 @@
+#include "utilities/JsonWriter.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <string>
+
+namespace
+{
+class JsonWriter : public ::testing::Test
+{
+public:
+    wolkabout::JsonWriter writer;
+};
+}    // namespace
+
+TEST_F(JsonWriter, Given_NestedValues_When_Written_Then_CommasSeparateElements)
+{
+    // When
+    writer.beginArray();
+    writer.beginObject().key("utc").value(std::uint64_t{1546300800000});
+    writer.key("data").value(std::string{"21.5"}).endObject();
+    writer.beginObject().key("active").value(true).endObject();
+    writer.beginArray().endArray();
+    writer.endArray();
+
+    // Then
+    ASSERT_EQ(writer.str(), R"([{"utc":1546300800000,"data":"21.5"},{"active":true},[]])");
+}
+
+TEST_F(JsonWriter, Given_StringWithSpecialCharacters_When_Written_Then_CharactersAreEscaped)
+{
+    // When
+    writer.value(std::string{"a\"b\\c\n\x01/"});
+
+    // Then
+    ASSERT_EQ(writer.str(), R"("a\"b\\c\n\u0001/")");
+}
+
+TEST_F(JsonWriter, Given_WrittenDocument_When_Cleared_Then_NextDocumentStartsFromScratch)
+{
+    // Given
+    writer.beginObject().key("value").value(std::uint64_t{0});
+
+    // When
+    writer.clear();
+    writer.beginObject().key("value").value(false).endObject();
+
+    // Then
+    ASSERT_EQ(writer.str(), R"({"value":false})");
+}
+
+TEST_F(JsonWriter, Given_Number_When_AppendedToBuffer_Then_ShortestRoundTripTextIsAppended)
+{
+    // Given
+    std::string buffer{"data:"};
+
+    // When
+    wolkabout::JsonWriter::appendNumber(buffer, 21.5);
+    buffer += ",";
+    wolkabout::JsonWriter::appendNumber(buffer, 0.1);
+    buffer += ",";
+    wolkabout::JsonWriter::appendNumber(buffer, 3);
+
+    // Then
+    ASSERT_EQ(buffer, "data:21.5,0.1,3");
+}
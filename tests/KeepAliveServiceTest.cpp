@@ -16,10 +16,16 @@
 
 #include "OutboundMessageHandler.h"
 #include "protocol/json/JsonStatusProtocol.h"
+#include "model/Message.h"
 #include "service/KeepAliveService.h"
+#include "utilities/Executor.h"
+#include "utilities/Metrics.h"
 
 #include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <thread>
 
 namespace
 {
@@ -68,3 +74,43 @@ TEST_F(KeepAliveService, Given_When_ConnectedIsCalled_Then_PingMessageIsSentToPl
     // Then
     ASSERT_EQ(platformOutboundMessageHandler->getMessages().size(), 1);
 }
+
+TEST_F(KeepAliveService, Given_PongTimeout_When_PongIsNotReceived_Then_TimeoutIsReported)
+{
+    // Given
+    wolkabout::Executor executor;
+    std::atomic_bool timedOut{false};
+    keepAliveService->setPongTimeout(std::chrono::milliseconds{20}, &executor, [&] { timedOut = true; });
+
+    // When
+    keepAliveService->connected();
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+    // Then
+    ASSERT_TRUE(timedOut);
+
+    keepAliveService.reset();
+}
+
+TEST_F(KeepAliveService, Given_PongTimeout_When_PongIsReceived_Then_RoundTripTimeIsRecorded)
+{
+    // Given
+    wolkabout::Executor executor;
+    std::atomic_bool timedOut{false};
+    keepAliveService->setPongTimeout(std::chrono::milliseconds{50}, &executor, [&] { timedOut = true; });
+
+    auto& roundTripTime =
+      wolkabout::MetricsRegistry::getInstance().histogram("wolkgateway_keep_alive_round_trip_seconds");
+    const auto samples = roundTripTime.count();
+
+    // When
+    keepAliveService->connected();
+    keepAliveService->platformMessageReceived(std::make_shared<wolkabout::Message>("", "pong/gateway_key"));
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+    // Then
+    ASSERT_FALSE(timedOut);
+    ASSERT_EQ(roundTripTime.count(), samples + 1);
+
+    keepAliveService.reset();
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "connectivity/LocalSocketConnectivityService.h"
+#include "MockConnectivityService.h"
+#include "model/Message.h"
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+namespace
+{
+const std::string SOCKET_PATH = "./local_socket_test.sock";
+
+class Listener : public wolkabout::ConnectivityServiceListener
+{
+public:
+    void messageReceived(const std::string& channel, const std::string& message) override
+    {
+        std::lock_guard<std::mutex> locker{mutex};
+        messages.emplace_back(channel, message);
+        received.notify_all();
+    }
+
+    void connectionLost() override {}
+
+    std::vector<std::string> getChannels() const override { return {"d2p/+/d/+/r/#"}; }
+
+    bool waitFor(std::size_t count)
+    {
+        std::unique_lock<std::mutex> locker{mutex};
+        return received.wait_for(locker, std::chrono::seconds{2}, [&] { return messages.size() >= count; });
+    }
+
+    std::mutex mutex;
+    std::condition_variable received;
+    std::vector<std::pair<std::string, std::string>> messages;
+};
+
+class Adapter
+{
+public:
+    Adapter() : m_socket{socket(AF_UNIX, SOCK_STREAM, 0)}
+    {
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, SOCKET_PATH.c_str(), SOCKET_PATH.size());
+        ::connect(m_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+
+        // write to service that stopped reading fails instead of blocking the test
+        timeval timeout{2, 0};
+        setsockopt(m_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    }
+
+    ~Adapter() { close(m_socket); }
+
+    bool write(const std::string& bytes)
+    {
+        return ::send(m_socket, bytes.data(), bytes.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(bytes.size());
+    }
+
+    bool isClosedByService()
+    {
+        pollfd descriptor{m_socket, POLLIN, 0};
+        char buffer[256];
+        return poll(&descriptor, 1, 2000) == 1 && recv(m_socket, buffer, sizeof(buffer), 0) <= 0;
+    }
+
+    std::string read(std::size_t size)
+    {
+        std::string bytes;
+        while (bytes.size() < size)
+        {
+            pollfd descriptor{m_socket, POLLIN, 0};
+            char buffer[256];
+            if (poll(&descriptor, 1, 2000) != 1)
+            {
+                break;
+            }
+
+            const auto received = recv(m_socket, buffer, std::min(sizeof(buffer), size - bytes.size()), 0);
+            if (received <= 0)
+            {
+                break;
+            }
+            bytes.append(buffer, static_cast<std::size_t>(received));
+        }
+
+        return bytes;
+    }
+
+private:
+    int m_socket;
+};
+
+class LocalSocketConnectivityService : public ::testing::Test
+{
+public:
+    void start(std::unique_ptr<wolkabout::ConnectivityService> broker = nullptr)
+    {
+        service.reset(new wolkabout::LocalSocketConnectivityService(SOCKET_PATH, std::move(broker)));
+        service->setListener(listener);
+    }
+
+    std::shared_ptr<Listener> listener = std::make_shared<Listener>();
+    std::unique_ptr<wolkabout::LocalSocketConnectivityService> service;
+};
+}    // namespace
+
+using Frame = wolkabout::LocalSocketConnectivityService;
+
+TEST_F(LocalSocketConnectivityService, Given_Adapter_When_FramesAreWrittenInPieces_Then_ListenerReceivesMessages)
+{
+    // Given
+    start();
+    ASSERT_TRUE(service->connect());
+    Adapter adapter;
+
+    const auto frames = Frame::makeFrame(Frame::MESSAGE, "d2p/sensor_reading/d/MODBUS_1/r/T", "{\"data\":\"25\"}") +
+                        Frame::makeFrame(Frame::MESSAGE, "d2p/sensor_reading/d/MODBUS_2/r/T", "");
+
+    // When
+    adapter.write(frames.substr(0, 7));
+    adapter.write(frames.substr(7));
+
+    // Then
+    ASSERT_TRUE(listener->waitFor(2));
+    ASSERT_EQ(listener->messages[0].first, "d2p/sensor_reading/d/MODBUS_1/r/T");
+    ASSERT_EQ(listener->messages[0].second, "{\"data\":\"25\"}");
+    ASSERT_EQ(listener->messages[1].first, "d2p/sensor_reading/d/MODBUS_2/r/T");
+    ASSERT_EQ(listener->messages[1].second, "");
+}
+
+TEST_F(LocalSocketConnectivityService, Given_SubscribedAdapter_When_Published_Then_AdapterAndBrokerReceiveMessage)
+{
+    // Given
+    auto broker = new MockConnectivityService();
+    start(std::unique_ptr<wolkabout::ConnectivityService>(broker));
+
+    EXPECT_CALL(*broker, isConnected()).WillRepeatedly(testing::Return(false));
+    EXPECT_CALL(*broker, connect()).WillOnce(testing::Return(true));
+    EXPECT_CALL(*broker, publish(testing::_, testing::_)).Times(2).WillRepeatedly(testing::Return(true));
+    ASSERT_TRUE(service->connect());
+
+    Adapter adapter;
+    adapter.write(Frame::makeFrame(Frame::SUBSCRIBE, "p2d/+/d/MODBUS_1/r/#"));
+    // frames are handled in order, so subscription is in place once this message arrives
+    adapter.write(Frame::makeFrame(Frame::MESSAGE, "d2p/sensor_reading/d/MODBUS_1/r/T", "25"));
+    ASSERT_TRUE(listener->waitFor(1));
+
+    // When
+    ASSERT_TRUE(service->publish(std::make_shared<wolkabout::Message>("OFF", "p2d/actuator_set/d/MODBUS_2/r/SW")));
+    ASSERT_TRUE(service->publish(std::make_shared<wolkabout::Message>("ON", "p2d/actuator_set/d/MODBUS_1/r/SW")));
+
+    // Then
+    const auto expected = Frame::makeFrame(Frame::MESSAGE, "p2d/actuator_set/d/MODBUS_1/r/SW", "ON");
+    ASSERT_EQ(adapter.read(expected.size()), expected);
+}
+
+TEST_F(LocalSocketConnectivityService, Given_Adapter_When_StreamingOversizedFrame_Then_ConnectionIsClosed)
+{
+    // Given
+    start();
+    ASSERT_TRUE(service->connect());
+    Adapter adapter;
+
+    // When
+    const auto length = Frame::MAXIMUM_FRAME_SIZE + 1;
+    std::string header;
+    for (int shift = 24; shift >= 0; shift -= 8)
+    {
+        header.push_back(static_cast<char>((length >> shift) & 0xFF));
+    }
+    adapter.write(header);
+
+    const std::string chunk(64 * 1024, 'x');
+    for (int i = 0; i < 256 && adapter.write(chunk); ++i)
+    {
+    }
+
+    // Then
+    ASSERT_TRUE(adapter.isClosedByService());
+    ASSERT_TRUE(listener->messages.empty());
+}
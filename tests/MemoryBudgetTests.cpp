@@ -0,0 +1,116 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "model/Message.h"
+#include "persistence/inmemory/GatewayInMemoryPersistence.h"
+#include "persistence/inmemory/GatewayRingBufferPersistence.h"
+#include "utilities/MemoryBudget.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+
+namespace
+{
+class MemoryBudget : public ::testing::Test
+{
+public:
+    void TearDown() override { wolkabout::MemoryBudget::getInstance().setLimit(0); }
+
+    static std::shared_ptr<wolkabout::Message> message(const std::string& channel, const std::string& content)
+    {
+        return std::make_shared<wolkabout::Message>(content, channel);
+    }
+};
+}    // namespace
+
+TEST_F(MemoryBudget, Given_Account_When_BytesAreAddedAndReleased_Then_UsageFollows)
+{
+    // Given
+    auto& budget = wolkabout::MemoryBudget::getInstance();
+    auto& account = budget.account("test_account");
+    const auto used = budget.used();
+
+    // When
+    account.add(100);
+
+    // Then
+    ASSERT_EQ(account.bytes(), 100u);
+    ASSERT_EQ(budget.used(), used + 100);
+
+    account.release(100);
+    ASSERT_EQ(account.bytes(), 0u);
+    ASSERT_EQ(budget.used(), used);
+    ASSERT_EQ(&budget.account("test_account"), &account);
+}
+
+TEST_F(MemoryBudget, Given_Limit_When_BytesWouldExceedIt_Then_TheyAreNotAllowed)
+{
+    // Given
+    auto& budget = wolkabout::MemoryBudget::getInstance();
+
+    // When
+    budget.setLimit(budget.used() + 10);
+
+    // Then
+    ASSERT_TRUE(budget.allows(10));
+    ASSERT_FALSE(budget.allows(11));
+
+    budget.setLimit(0);
+    ASSERT_TRUE(budget.allows(1024 * 1024));
+}
+
+TEST_F(MemoryBudget, Given_ExhaustedBudget_When_QueueDropsOldest_Then_OldestMessageMakesRoom)
+{
+    // Given
+    auto& budget = wolkabout::MemoryBudget::getInstance();
+    wolkabout::GatewayInMemoryPersistence persistence{
+      0, 0, wolkabout::GatewayInMemoryPersistence::OverflowPolicy::DROP_OLDEST, nullptr, "test_queue"};
+    ASSERT_TRUE(persistence.push(message("c", "a")));
+    ASSERT_TRUE(persistence.push(message("c", "b")));
+    ASSERT_EQ(budget.account("test_queue").bytes(), 4u);
+    budget.setLimit(budget.used());
+
+    // When
+    const bool pushed = persistence.push(message("c", "c"));
+
+    // Then
+    ASSERT_TRUE(pushed);
+    ASSERT_EQ(persistence.frontBatch(10).size(), 2u);
+    ASSERT_EQ(persistence.front()->getContent(), "b");
+    ASSERT_FALSE(persistence.push(message("c", "longer")));
+    ASSERT_EQ(persistence.frontBatch(10).size(), 2u);
+}
+
+TEST_F(MemoryBudget, Given_ExhaustedBudget_When_MessageIsPushedToRingBuffer_Then_MessageIsRejected)
+{
+    // Given
+    auto& budget = wolkabout::MemoryBudget::getInstance();
+    wolkabout::GatewayRingBufferPersistence persistence{8, "test_ring_buffer"};
+    ASSERT_TRUE(persistence.push(message("c", "a")));
+    budget.setLimit(budget.used());
+
+    // When
+    const bool pushed = persistence.push(message("c", "b"));
+
+    // Then
+    ASSERT_FALSE(pushed);
+
+    persistence.pop();
+    ASSERT_EQ(budget.account("test_ring_buffer").bytes(), 0u);
+    ASSERT_TRUE(persistence.push(message("c", "b")));
+}
@@ -0,0 +1,66 @@
+#include "utilities/MessagePack.h"
+
+#include <gtest/gtest.h>
+#include <initializer_list>
+#include <string>
+
+namespace
+{
+class MessagePack : public ::testing::Test
+{
+public:
+    static std::string bytes(std::initializer_list<unsigned char> values)
+    {
+        return std::string(values.begin(), values.end());
+    }
+};
+}    // namespace
+
+TEST_F(MessagePack, Given_SensorReadingArray_When_ConvertedToJson_Then_JsonMatchesPlatformPayload)
+{
+    // Given
+    // [{"utc": 1546300800000, "data": "21.5"}]
+    const std::string payload = bytes({0x91, 0x82, 0xA3, 'u', 't', 'c', 0xCF, 0x00, 0x00, 0x01, 0x68, 0x06, 0xB5,
+                                       0xBC, 0x00, 0xA4, 'd', 'a', 't', 'a', 0xA4, '2', '1', '.', '5'});
+
+    // When
+    std::string json;
+    const bool converted = wolkabout::MessagePack::toJson(payload, json);
+
+    // Then
+    ASSERT_TRUE(converted);
+    ASSERT_EQ(json, R"([{"utc":1546300800000,"data":"21.5"}])");
+}
+
+TEST_F(MessagePack, Given_ScalarTypes_When_ConvertedToJson_Then_ValuesArePreserved)
+{
+    // Given
+    // [-1, -200, 65535, true, false, nil, 1.5, 0.25f]
+    const std::string payload = bytes({0x98, 0xFF, 0xD1, 0xFF, 0x38, 0xCD, 0xFF, 0xFF, 0xC3, 0xC2, 0xC0, 0xCB, 0x3F,
+                                       0xF8, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xCA, 0x3E, 0x80, 0x00, 0x00});
+
+    // When
+    std::string json;
+    const bool converted = wolkabout::MessagePack::toJson(payload, json);
+
+    // Then
+    ASSERT_TRUE(converted);
+    ASSERT_EQ(json, "[-1,-200,65535,true,false,null,1.5,0.25]");
+}
+
+TEST_F(MessagePack, Given_InvalidPayloads_When_ConvertedToJson_Then_ConversionFails)
+{
+    // Given
+    const std::string truncated = bytes({0x92, 0x01});
+    const std::string trailing = bytes({0x01, 0x02});
+    const std::string binary = bytes({0xC4, 0x01, 0x00});
+    const std::string integerKey = bytes({0x81, 0x01, 0x02});
+
+    // Then
+    std::string json;
+    ASSERT_FALSE(wolkabout::MessagePack::toJson(truncated, json));
+    ASSERT_FALSE(wolkabout::MessagePack::toJson(trailing, json));
+    ASSERT_FALSE(wolkabout::MessagePack::toJson(binary, json));
+    ASSERT_FALSE(wolkabout::MessagePack::toJson(integerKey, json));
+    ASSERT_FALSE(wolkabout::MessagePack::toJson(std::string(100, '\x91'), json));
+}
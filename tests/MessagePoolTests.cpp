@@ -0,0 +1,55 @@
+#include "utilities/MessagePool.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class MessagePool : public ::testing::Test
+{
+};
+}    // namespace
+
+TEST_F(MessagePool, Given_PooledMessage_When_Created_Then_ContentAndChannelAreSet)
+{
+    // When
+    const auto message = wolkabout::MessagePool::make("content", "channel");
+
+    // Then
+    ASSERT_EQ(message->getContent(), "content");
+    ASSERT_EQ(message->getChannel(), "channel");
+}
+
+TEST_F(MessagePool, Given_WarmPool_When_MessagesAreCreatedAndFreedAcrossThreads_Then_HeapIsNotUsed)
+{
+    // Given
+    const std::size_t messageCount = 2000;
+    std::vector<std::shared_ptr<wolkabout::Message>> messages;
+    for (int round = 0; round < 2; ++round)
+    {
+        std::thread producer{[&] {
+            for (std::size_t i = 0; i < messageCount; ++i)
+            {
+                messages.push_back(wolkabout::MessagePool::make("", "c"));
+            }
+        }};
+        producer.join();
+        messages.clear();
+    }
+
+    // When
+    const auto heapAllocations = wolkabout::MessagePool::getHeapAllocationCount();
+    std::thread producer{[&] {
+        for (std::size_t i = 0; i < messageCount / 2; ++i)
+        {
+            messages.push_back(wolkabout::MessagePool::make("", "c"));
+        }
+    }};
+    producer.join();
+    messages.clear();
+
+    // Then
+    ASSERT_EQ(wolkabout::MessagePool::getHeapAllocationCount(), heapAllocations);
+}
@@ -0,0 +1,105 @@
+#include "utilities/Metrics.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace
+{
+class Metrics : public ::testing::Test
+{
+public:
+    wolkabout::MetricsRegistry& registry = wolkabout::MetricsRegistry::getInstance();
+};
+}    // namespace
+
+TEST_F(Metrics, Given_Counter_When_LookedUpTwice_Then_SameCounterIsReturned)
+{
+    // Given
+    auto& counter = registry.counter("test_lookup_total");
+
+    // When
+    counter.increment();
+    registry.counter("test_lookup_total").increment(2);
+
+    // Then
+    ASSERT_EQ(&counter, &registry.counter("test_lookup_total"));
+    ASSERT_EQ(counter.value(), 3u);
+}
+
+TEST_F(Metrics, Given_Histogram_When_DurationsAreRecorded_Then_SamplesLandInMatchingBuckets)
+{
+    // Given
+    wolkabout::Histogram histogram;
+
+    // When
+    histogram.record(std::chrono::microseconds{5});
+    histogram.record(std::chrono::microseconds{10});
+    histogram.record(std::chrono::microseconds{700});
+    histogram.record(std::chrono::seconds{10});
+
+    // Then
+    const auto buckets = histogram.buckets();
+    ASSERT_EQ(buckets[0], 2u);
+    ASSERT_EQ(buckets[4], 1u);
+    ASSERT_EQ(buckets[wolkabout::Histogram::BUCKET_COUNT], 1u);
+    ASSERT_EQ(histogram.count(), 4u);
+    ASSERT_EQ(histogram.sumMicroseconds(), 10000715u);
+}
+
+TEST_F(Metrics, Given_Metrics_When_Formatted_Then_PrometheusTextIsProduced)
+{
+    // Given
+    registry.counter("test_format_total").increment(7);
+    registry.gauge("test_format_depth").set(-2);
+    registry.histogram("test_format_latency_seconds").record(std::chrono::microseconds{20});
+
+    // When
+    const std::string text = registry.format();
+
+    // Then
+    ASSERT_NE(text.find("# TYPE test_format_total counter\ntest_format_total 7\n"), std::string::npos);
+    ASSERT_NE(text.find("# TYPE test_format_depth gauge\ntest_format_depth -2\n"), std::string::npos);
+    ASSERT_NE(text.find("test_format_latency_seconds_bucket{le=\"1e-05\"} 0\n"), std::string::npos);
+    ASSERT_NE(text.find("test_format_latency_seconds_bucket{le=\"5e-05\"} 1\n"), std::string::npos);
+    ASSERT_NE(text.find("test_format_latency_seconds_bucket{le=\"+Inf\"} 1\n"), std::string::npos);
+    ASSERT_NE(text.find("test_format_latency_seconds_count 1\n"), std::string::npos);
+}
+
+TEST_F(Metrics, Given_LabelledCounters_When_Formatted_Then_TypeIsDeclaredOncePerFamily)
+{
+    // Given
+    registry.counter("test_labelled_total{device=\"A\"}").increment(1);
+    registry.counter("test_labelled_total{device=\"B\"}").increment(2);
+
+    // When
+    const std::string text = registry.format();
+
+    // Then
+    ASSERT_NE(text.find("# TYPE test_labelled_total counter\ntest_labelled_total{device=\"A\"} 1\n"
+                        "test_labelled_total{device=\"B\"} 2\n"),
+              std::string::npos);
+    ASSERT_EQ(text.find("# TYPE test_labelled_total{"), std::string::npos);
+}
+
+TEST_F(Metrics, Given_Histograms_When_Visited_Then_EachHistogramIsVisitedWithItsName)
+{
+    // Given
+    registry.histogram("test_visit_a_seconds").record(std::chrono::microseconds{20});
+    registry.histogram("test_visit_b_seconds").record(std::chrono::microseconds{30});
+    registry.histogram("test_visit_b_seconds").record(std::chrono::microseconds{40});
+
+    // When
+    std::map<std::string, std::uint64_t> counts;
+    registry.forEachHistogram([&](const std::string& name, const wolkabout::Histogram& histogram) {
+        if (name.find("test_visit_") == 0)
+        {
+            counts[name] = histogram.count();
+        }
+    });
+
+    // Then
+    ASSERT_EQ(counts, (std::map<std::string, std::uint64_t>{{"test_visit_a_seconds", 1}, {"test_visit_b_seconds", 2}}));
+}
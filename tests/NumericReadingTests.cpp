@@ -0,0 +1,55 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/NumericReading.h"
+
+#include <gtest/gtest.h>
+#include <vector>
+
+namespace
+{
+class NumericReading : public ::testing::Test
+{
+};
+}    // namespace
+
+TEST_F(NumericReading, Given_FewValues_When_ReadingIsCreated_Then_ValuesAreKept)
+{
+    // When
+    const wolkabout::NumericReading reading{"ACL", {1.5, -2, 3}, 1546300800000};
+
+    // Then
+    ASSERT_EQ(reading.getReference(), "ACL");
+    ASSERT_EQ(reading.getRtc(), 1546300800000u);
+    ASSERT_EQ(reading.getSize(), 3u);
+    ASSERT_EQ(std::vector<double>(reading.getValues(), reading.getValues() + reading.getSize()),
+              (std::vector<double>{1.5, -2, 3}));
+}
+
+TEST_F(NumericReading, Given_MoreValuesThanFitInline_When_ReadingIsCopied_Then_CopyHasAllValues)
+{
+    // Given
+    const std::vector<double> values{1, 2, 3, 4, 5, 6};
+    const wolkabout::NumericReading reading{"V", values.data(), values.size()};
+
+    // When
+    const wolkabout::NumericReading copy{reading};
+
+    // Then
+    ASSERT_EQ(copy.getRtc(), 0u);
+    ASSERT_EQ(copy.getSize(), values.size());
+    ASSERT_EQ(std::vector<double>(copy.getValues(), copy.getValues() + copy.getSize()), values);
+}
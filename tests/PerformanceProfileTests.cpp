@@ -0,0 +1,55 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/PerformanceProfile.h"
+#include "service/FileDownloader.h"
+#include "utilities/ReconnectScheduler.h"
+
+#include <gtest/gtest.h>
+
+namespace
+{
+class PerformanceProfile : public ::testing::Test
+{
+};
+}    // namespace
+
+TEST_F(PerformanceProfile, Given_DefaultProfile_When_Compared_Then_ItMatchesServiceDefaults)
+{
+    // When
+    const wolkabout::PerformanceProfile profile;
+
+    // Then
+    ASSERT_EQ(profile.filePacketRequestTimeout, wolkabout::FileDownloader::DEFAULT_PACKET_REQUEST_TIMEOUT);
+    ASSERT_EQ(profile.reconnectInitialDelay, wolkabout::ReconnectScheduler::DEFAULT_INITIAL_DELAY);
+    ASSERT_EQ(profile.reconnectMaximumDelay, wolkabout::ReconnectScheduler::DEFAULT_MAXIMUM_DELAY);
+}
+
+TEST_F(PerformanceProfile, Given_Presets_When_Compared_Then_ConstrainedEdgeIsBoundedAndLargeFleetScalesOut)
+{
+    // When
+    const auto constrained = wolkabout::PerformanceProfile::constrainedEdge();
+    const auto largeFleet = wolkabout::PerformanceProfile::largeFleet();
+
+    // Then
+    ASSERT_NE(constrained.outboundQueueMaximumMessages, 0u);
+    ASSERT_NE(constrained.outboundQueueMaximumBytes, 0u);
+    ASSERT_LT(constrained.outboundQueueMaximumMessages, largeFleet.outboundQueueMaximumMessages);
+    ASSERT_LT(constrained.maxFilePacketSize, largeFleet.maxFilePacketSize);
+    ASSERT_LT(constrained.publishBatchSize, largeFleet.publishBatchSize);
+    ASSERT_GT(largeFleet.inboundDeviceMessageWorkers, wolkabout::PerformanceProfile{}.inboundDeviceMessageWorkers);
+    ASSERT_GT(largeFleet.statusPollingBuckets, wolkabout::PerformanceProfile{}.statusPollingBuckets);
+}
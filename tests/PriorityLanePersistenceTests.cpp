@@ -0,0 +1,90 @@
+#include "model/Message.h"
+#include "persistence/PriorityLanePersistence.h"
+#include "persistence/inmemory/GatewayInMemoryPersistence.h"
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class PriorityLanePersistence : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        persistence.reset(new wolkabout::PriorityLanePersistence([](const wolkabout::Message& message) {
+            return static_cast<std::size_t>(message.getChannel()[0] - '0');
+        }));
+    }
+
+    void push(const std::string& lane, const std::string& content)
+    {
+        ASSERT_TRUE(persistence->push(std::make_shared<wolkabout::Message>(content, lane)));
+    }
+
+    static std::string contents(const std::vector<std::shared_ptr<wolkabout::Message>>& messages)
+    {
+        std::string joined;
+        for (const auto& message : messages)
+        {
+            joined += message->getContent();
+        }
+
+        return joined;
+    }
+
+    std::unique_ptr<wolkabout::PriorityLanePersistence> persistence;
+};
+}    // namespace
+
+TEST_F(PriorityLanePersistence, Given_BacklogInBulkLane_When_Drained_Then_LanesAreInterleavedByWeight)
+{
+    // Given
+    persistence->addLane(std::unique_ptr<wolkabout::GatewayPersistence>(new wolkabout::GatewayInMemoryPersistence()),
+                         2);
+    persistence->addLane(std::unique_ptr<wolkabout::GatewayPersistence>(new wolkabout::GatewayInMemoryPersistence()),
+                         1);
+
+    push("1", "a");
+    push("1", "b");
+    push("1", "c");
+    push("0", "X");
+    push("0", "Y");
+    push("0", "Z");
+
+    // When
+    const auto batch = persistence->frontBatch(4);
+    ASSERT_EQ(persistence->popBatch(batch.size()), batch.size());
+    persistence->push(std::make_shared<wolkabout::Message>("W", "0"));
+    const auto rest = persistence->frontBatch(10);
+
+    // Then
+    ASSERT_EQ(contents(batch), "XYaZ");
+    ASSERT_EQ(contents(rest), "Wbc");
+    ASSERT_EQ(persistence->popBatch(10), 3u);
+    ASSERT_TRUE(persistence->empty());
+    ASSERT_EQ(persistence->pop(), nullptr);
+}
+
+TEST_F(PriorityLanePersistence, Given_FullLane_When_MessageIsPushed_Then_OnlyThatLaneRejectsIt)
+{
+    // Given
+    persistence->addLane(std::unique_ptr<wolkabout::GatewayPersistence>(new wolkabout::GatewayInMemoryPersistence()),
+                         1);
+    persistence->addLane(std::unique_ptr<wolkabout::GatewayPersistence>(new wolkabout::GatewayInMemoryPersistence()),
+                         1, 1);
+    push("1", "a");
+
+    // When
+    const bool pushed = persistence->push(std::make_shared<wolkabout::Message>("b", "1"));
+
+    // Then
+    ASSERT_FALSE(pushed);
+    push("0", "X");
+    ASSERT_EQ(persistence->pop()->getContent(), "X");
+    ASSERT_EQ(persistence->pop()->getContent(), "a");
+    push("9", "c");
+    ASSERT_EQ(persistence->front()->getContent(), "c");
+}
@@ -0,0 +1,341 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MockConnectivityService.h"
+#include "model/Message.h"
+#include "persistence/PriorityLanePersistence.h"
+#include "persistence/inmemory/GatewayInMemoryPersistence.h"
+#include "service/PublishingService.h"
+#include "utilities/Deflate.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class PublishingService : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        connectivityService = std::unique_ptr<MockConnectivityService>(new MockConnectivityService());
+        persistence = new wolkabout::GatewayInMemoryPersistence();
+        publishingService = std::unique_ptr<wolkabout::PublishingService>(new wolkabout::PublishingService(
+          *connectivityService, std::unique_ptr<wolkabout::GatewayPersistence>(persistence)));
+    }
+
+    void TearDown() override { publishingService.reset(); }
+
+    bool waitUntilEmpty()
+    {
+        for (int i = 0; i < 100 && !persistence->empty(); ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{20});
+        }
+
+        return persistence->empty();
+    }
+
+    std::unique_ptr<MockConnectivityService> connectivityService;
+    wolkabout::GatewayPersistence* persistence;
+    std::unique_ptr<wolkabout::PublishingService> publishingService;
+};
+}    // namespace
+
+TEST_F(PublishingService, Given_PublishFails_When_Connected_Then_MessageIsRetriedWithBackoff)
+{
+    // Given
+    EXPECT_CALL(*connectivityService, publish(testing::_, testing::_))
+      .WillOnce(testing::Return(false))
+      .WillOnce(testing::Return(false))
+      .WillOnce(testing::Return(true));
+
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("content", "channel"));
+
+    // When
+    publishingService->connected();
+
+    // Then
+    ASSERT_TRUE(waitUntilEmpty());
+    ASSERT_EQ(publishingService->getFailedPublishCount(), 2u);
+}
+
+TEST_F(PublishingService, Given_Disconnected_When_MessageIsAdded_Then_MessageIsNotPublished)
+{
+    // Given
+    EXPECT_CALL(*connectivityService, publish(testing::_, testing::_)).Times(0);
+
+    // When
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("content", "channel"));
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+
+    // Then
+    ASSERT_FALSE(persistence->empty());
+    ASSERT_EQ(publishingService->getFailedPublishCount(), 0u);
+}
+
+TEST_F(PublishingService, Given_Compression_When_MessagesAreAdded_Then_OnlyLargePayloadsAreCompressed)
+{
+    // Given
+    const std::string largeContent(200, 'a');
+    publishingService->setCompression(100, wolkabout::Deflate::READING_DICTIONARY);
+
+    // When
+    publishingService->addMessage(std::make_shared<wolkabout::Message>(largeContent, "channel"));
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("content", "channel"));
+
+    // Then
+    const auto messages = persistence->frontBatch(2);
+    ASSERT_EQ(messages.size(), 2u);
+    ASSERT_LT(messages.at(0)->getContent().size(), largeContent.size());
+    ASSERT_EQ(messages.at(1)->getContent(), "content");
+
+    std::string decompressed;
+    ASSERT_TRUE(wolkabout::Deflate::decompress(messages.at(0)->getContent(), wolkabout::Deflate::READING_DICTIONARY,
+                                               decompressed));
+    ASSERT_EQ(decompressed, largeContent);
+}
+
+TEST_F(PublishingService, Given_BackpressureWatermarks_When_QueueFillsAndDrains_Then_ListenerIsNotifiedOnce)
+{
+    // Given
+    std::mutex notificationsLock;
+    std::vector<bool> notifications;
+    const auto notified = [&] {
+        std::lock_guard<std::mutex> locker{notificationsLock};
+        return notifications;
+    };
+    publishingService->setBackpressureListener(3, 1, [&](bool enabled) {
+        std::lock_guard<std::mutex> locker{notificationsLock};
+        notifications.push_back(enabled);
+    });
+
+    EXPECT_CALL(*connectivityService, publish(testing::_, testing::_)).WillRepeatedly(testing::Return(true));
+
+    // When
+    for (int i = 0; i < 5; ++i)
+    {
+        publishingService->addMessage(std::make_shared<wolkabout::Message>("content", "channel"));
+    }
+
+    // Then
+    ASSERT_TRUE(publishingService->isUnderBackpressure());
+    ASSERT_EQ(notified(), std::vector<bool>{true});
+
+    // When
+    publishingService->connected();
+
+    // Then
+    ASSERT_TRUE(waitUntilEmpty());
+    for (int i = 0; i < 100 && notified().size() < 2; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds{20});
+    }
+    ASSERT_FALSE(publishingService->isUnderBackpressure());
+    ASSERT_EQ(notified(), (std::vector<bool>{true, false}));
+}
+
+TEST_F(PublishingService, Given_Partitions_When_OnePartitionFailsToPublish_Then_OtherPartitionIsNotStalled)
+{
+    // Given
+    MockConnectivityService failingConnectivityService;
+    auto failingPersistence = new wolkabout::GatewayInMemoryPersistence();
+    publishingService->addPartition(failingConnectivityService,
+                                    std::unique_ptr<wolkabout::GatewayPersistence>(failingPersistence));
+
+    EXPECT_CALL(*connectivityService, publish(testing::_, testing::_)).WillRepeatedly(testing::Return(true));
+    EXPECT_CALL(failingConnectivityService, publish(testing::_, testing::_)).WillRepeatedly(testing::Return(false));
+
+    for (int i = 0; i < 10; ++i)
+    {
+        publishingService->addMessage(std::make_shared<wolkabout::Message>(
+          "content", "d2p/sensor_reading/d/device" + std::to_string(i) + "/r/T"));
+    }
+    ASSERT_FALSE(persistence->empty());
+    ASSERT_FALSE(failingPersistence->empty());
+
+    // When
+    publishingService->connected();
+
+    // Then
+    ASSERT_TRUE(waitUntilEmpty());
+    ASSERT_FALSE(failingPersistence->empty());
+    ASSERT_EQ(publishingService->getPartitionCount(), 2u);
+
+    // failing partition publishes over connectivity service that goes out of scope first
+    publishingService.reset();
+}
+
+TEST_F(PublishingService, Given_AtMostOnceMessage_When_PublishFails_Then_MessageIsDroppedWithoutRetry)
+{
+    // Given
+    publishingService->setDeliveryClassifier([](const wolkabout::Message& message) {
+        return message.getChannel() == "readings" ? wolkabout::DeliveryClass::AT_MOST_ONCE :
+                                                    wolkabout::DeliveryClass::AT_LEAST_ONCE;
+    });
+
+    std::vector<std::string> published;
+    int statusAttempts = 0;
+    EXPECT_CALL(*connectivityService, publish(testing::_, testing::_))
+      .WillRepeatedly(testing::Invoke([&](std::shared_ptr<wolkabout::Message> message, bool) {
+          published.push_back(message->getContent());
+          if (message->getContent() == "status")
+          {
+              return statusAttempts++ != 0;
+          }
+
+          return message->getContent() != "reading1";
+      }));
+
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("reading1", "readings"));
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("status", "control"));
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("reading2", "readings"));
+
+    // When
+    publishingService->connected();
+
+    // Then
+    ASSERT_TRUE(waitUntilEmpty());
+    ASSERT_EQ(published, (std::vector<std::string>{"reading1", "status", "status", "reading2"}));
+    ASSERT_EQ(publishingService->getFailedPublishCount(), 1u);
+}
+
+TEST_F(PublishingService, Given_QueuedMessages_When_Published_Then_CompletionIsReportedAfterLastMessage)
+{
+    // Given
+    std::mutex lock;
+    std::vector<std::string> events;
+    EXPECT_CALL(*connectivityService, publish(testing::_, testing::_))
+      .WillRepeatedly(testing::Invoke([&](std::shared_ptr<wolkabout::Message> message, bool) {
+          std::lock_guard<std::mutex> locker{lock};
+          events.push_back(message->getContent());
+          return true;
+      }));
+
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("first", "channel"));
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("second", "channel"));
+    publishingService->whenPublished([&](bool published) {
+        std::lock_guard<std::mutex> locker{lock};
+        events.push_back(published ? "published" : "stopped");
+    });
+    ASSERT_TRUE(events.empty());
+
+    // When
+    publishingService->connected();
+
+    // Then
+    ASSERT_TRUE(waitUntilEmpty());
+    for (int i = 0; i < 100; ++i)
+    {
+        {
+            std::lock_guard<std::mutex> locker{lock};
+            if (events.size() == 3)
+            {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    std::lock_guard<std::mutex> locker{lock};
+    ASSERT_EQ(events, (std::vector<std::string>{"first", "second", "published"}));
+}
+
+TEST_F(PublishingService, Given_PriorityLanes_When_LaterMessageIsPublishedFirst_Then_CompletionWaitsForEarlierOnes)
+{
+    // Given
+    auto lanes = new wolkabout::PriorityLanePersistence(
+      [](const wolkabout::Message& message) { return message.getChannel() == "alarm" ? 0u : 1u; });
+    lanes->addLane(std::unique_ptr<wolkabout::GatewayPersistence>(new wolkabout::GatewayInMemoryPersistence()), 1);
+    lanes->addLane(std::unique_ptr<wolkabout::GatewayPersistence>(new wolkabout::GatewayInMemoryPersistence()), 1);
+    persistence = lanes;
+    publishingService.reset(new wolkabout::PublishingService(
+      *connectivityService, std::unique_ptr<wolkabout::GatewayPersistence>(persistence)));
+
+    std::mutex lock;
+    std::vector<std::string> events;
+    EXPECT_CALL(*connectivityService, publish(testing::_, testing::_))
+      .WillRepeatedly(testing::Invoke([&](std::shared_ptr<wolkabout::Message> message, bool) {
+          std::lock_guard<std::mutex> locker{lock};
+          events.push_back(message->getContent());
+          return true;
+      }));
+
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("first", "reading"));
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("second", "reading"));
+    publishingService->whenPublished([&](bool published) {
+        std::lock_guard<std::mutex> locker{lock};
+        events.push_back(published ? "published" : "stopped");
+    });
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("alarm", "alarm"));
+
+    // When
+    publishingService->connected();
+
+    // Then
+    ASSERT_TRUE(waitUntilEmpty());
+    for (int i = 0; i < 100; ++i)
+    {
+        {
+            std::lock_guard<std::mutex> locker{lock};
+            if (events.size() == 4)
+            {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{10});
+    }
+    std::lock_guard<std::mutex> locker{lock};
+    ASSERT_EQ(events.size(), 4u);
+    ASSERT_EQ(events.front(), "alarm");
+    ASSERT_EQ(events.back(), "published");
+}
+
+TEST_F(PublishingService, Given_NothingQueued_When_CompletionIsRequested_Then_ItIsReportedImmediately)
+{
+    // Given
+    bool published = false;
+
+    // When
+    publishingService->whenPublished([&](bool result) { published = result; });
+
+    // Then
+    ASSERT_TRUE(published);
+}
+
+TEST_F(PublishingService, Given_Disconnected_When_ServiceIsDestroyed_Then_PendingCompletionIsReportedAsNotPublished)
+{
+    // Given
+    int calls = 0;
+    bool published = true;
+    publishingService->addMessage(std::make_shared<wolkabout::Message>("content", "channel"));
+    publishingService->whenPublished([&](bool result) {
+        ++calls;
+        published = result;
+    });
+
+    // When
+    publishingService.reset();
+
+    // Then
+    ASSERT_EQ(calls, 1);
+    ASSERT_FALSE(published);
+}
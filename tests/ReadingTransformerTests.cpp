@@ -0,0 +1,150 @@
+#include "service/ReadingTransformer.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace
+{
+class ReadingTransformer : public ::testing::Test
+{
+public:
+    void TearDown() override { std::remove(RULE_FILE_PATH); }
+
+    void writeRules(const std::string& rules)
+    {
+        std::ofstream file{RULE_FILE_PATH};
+        file << rules;
+    }
+
+    static constexpr const char* RULE_FILE_PATH = "testsReadingTransformationRules.txt";
+};
+}    // namespace
+
+TEST_F(ReadingTransformer, Given_NoRules_When_ReadingIsTransformed_Then_ReadingIsUnchanged)
+{
+    // Given
+    wolkabout::ReadingTransformer transformer;
+    std::string reference = "T";
+    std::string payload;
+
+    // When
+    const auto result = transformer.transform("DEVICE_KEY", reference, "{\"data\":\"20\"}", payload);
+
+    // Then
+    ASSERT_EQ(result, wolkabout::ReadingTransformer::Result::UNCHANGED);
+    ASSERT_EQ(reference, "T");
+}
+
+TEST_F(ReadingTransformer, Given_ScaleAndOffsetRule_When_ReadingIsTransformed_Then_ValuesAreRescaled)
+{
+    // Given
+    writeRules("# device reference operations\n"
+               "\n"
+               "* T scale=0.5 offset=-10 scale=2\n");
+    wolkabout::ReadingTransformer transformer;
+    ASSERT_TRUE(transformer.loadRules(RULE_FILE_PATH));
+    std::string reference = "T";
+    std::string payload;
+
+    // When
+    const auto result =
+      transformer.transform("DEVICE_KEY", reference, "[{\"utc\":1,\"data\":\"40\"}, {\"data\": \"60,80\"}]", payload);
+
+    // Then
+    ASSERT_EQ(result, wolkabout::ReadingTransformer::Result::TRANSFORMED);
+    ASSERT_EQ(reference, "T");
+    ASSERT_EQ(payload, "[{\"utc\":1,\"data\":\"20\"}, {\"data\":\"40,60\"}]");
+}
+
+TEST_F(ReadingTransformer, Given_UnitRoundAndRenameRule_When_ReadingIsTransformed_Then_ReadingIsConvertedAndRenamed)
+{
+    // Given
+    writeRules("* T unit=F:C round=1 clamp=-40:85 rename=TEMP\n"
+               "* P unit=hPa:kPa round=2\n");
+    wolkabout::ReadingTransformer transformer;
+    ASSERT_TRUE(transformer.loadRules(RULE_FILE_PATH));
+    std::string reference = "T";
+    std::string payload;
+
+    // When
+    const auto result = transformer.transform("DEVICE_KEY", reference, "{\"data\":\"70.5\",\"utc\":2}", payload);
+
+    // Then
+    ASSERT_EQ(result, wolkabout::ReadingTransformer::Result::TRANSFORMED);
+    ASSERT_EQ(reference, "TEMP");
+    ASSERT_EQ(payload, "{\"data\":\"21.4\",\"utc\":2}");
+
+    reference = "P";
+    ASSERT_EQ(transformer.transform("DEVICE_KEY", reference, "{\"data\":\"1013\"}", payload),
+              wolkabout::ReadingTransformer::Result::TRANSFORMED);
+    ASSERT_EQ(payload, "{\"data\":\"101.3\"}");
+}
+
+TEST_F(ReadingTransformer, Given_DeviceRule_When_ReadingIsTransformed_Then_DeviceRuleTakesPrecedence)
+{
+    // Given
+    writeRules("* T scale=10\n"
+               "DEVICE_KEY T drop\n");
+    wolkabout::ReadingTransformer transformer;
+    ASSERT_TRUE(transformer.loadRules(RULE_FILE_PATH));
+    std::string reference = "T";
+    std::string payload;
+
+    // Then
+    ASSERT_EQ(transformer.transform("DEVICE_KEY", reference, "{\"data\":\"1\"}", payload),
+              wolkabout::ReadingTransformer::Result::DROPPED);
+    ASSERT_EQ(transformer.transform("OTHER_KEY", reference, "{\"data\":\"1\"}", payload),
+              wolkabout::ReadingTransformer::Result::TRANSFORMED);
+    ASSERT_EQ(payload, "{\"data\":\"10\"}");
+    reference = "P";
+    ASSERT_EQ(transformer.transform("OTHER_KEY", reference, "{\"data\":\"1\"}", payload),
+              wolkabout::ReadingTransformer::Result::UNCHANGED);
+}
+
+TEST_F(ReadingTransformer, Given_NonNumericReading_When_RuleRenamesAndScales_Then_ReadingIsOnlyRenamed)
+{
+    // Given
+    writeRules("* S scale=2 rename=STATE\n"
+               "* M scale=2\n");
+    wolkabout::ReadingTransformer transformer;
+    ASSERT_TRUE(transformer.loadRules(RULE_FILE_PATH));
+    std::string reference = "S";
+    std::string payload;
+
+    // When
+    const auto result = transformer.transform("DEVICE_KEY", reference, "{\"data\":\"ON\"}", payload);
+
+    // Then
+    ASSERT_EQ(result, wolkabout::ReadingTransformer::Result::TRANSFORMED);
+    ASSERT_EQ(reference, "STATE");
+    ASSERT_EQ(payload, "{\"data\":\"ON\"}");
+
+    reference = "M";
+    ASSERT_EQ(transformer.transform("DEVICE_KEY", reference, "{\"data\":\"ON\"}", payload),
+              wolkabout::ReadingTransformer::Result::UNCHANGED);
+}
+
+TEST_F(ReadingTransformer, Given_InvalidRuleFile_When_Loaded_Then_PreviousRulesAreKept)
+{
+    // Given
+    writeRules("* T scale=2\n");
+    wolkabout::ReadingTransformer transformer;
+    ASSERT_TRUE(transformer.loadRules(RULE_FILE_PATH));
+
+    // When
+    for (const std::string line : {"* T\n", "* T scale=x\n", "* T unit=C:bar\n", "* T round=1.5\n", "* T invert\n"})
+    {
+        writeRules(line);
+        ASSERT_FALSE(transformer.loadRules(RULE_FILE_PATH)) << line;
+    }
+
+    // Then
+    std::string reference = "T";
+    std::string payload;
+    ASSERT_EQ(transformer.transform("DEVICE_KEY", reference, "{\"data\":\"3\"}", payload),
+              wolkabout::ReadingTransformer::Result::TRANSFORMED);
+    ASSERT_EQ(payload, "{\"data\":\"6\"}");
+    ASSERT_FALSE(transformer.loadRules("tests/missing/rules.txt"));
+}
@@ -0,0 +1,123 @@
+#include "utilities/ReconnectScheduler.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+class ReconnectScheduler : public ::testing::Test
+{
+public:
+    bool waitFor(const std::atomic_int& counter, int value)
+    {
+        for (int i = 0; i < 100 && counter != value; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+
+        return counter == value;
+    }
+
+    wolkabout::Executor executor;
+};
+}    // namespace
+
+TEST_F(ReconnectScheduler, Given_FailingConnection_When_Started_Then_AttemptsAreRetriedUntilConnected)
+{
+    // Given
+    std::atomic_int attempts{0};
+    std::atomic_int connected{0};
+    wolkabout::ReconnectScheduler scheduler{executor,
+                                            [&] { return ++attempts == 3; },
+                                            [&] { ++connected; },
+                                            "test",
+                                            std::chrono::milliseconds{10},
+                                            std::chrono::milliseconds{20}};
+
+    // When
+    scheduler.start();
+    scheduler.start();
+
+    // Then
+    ASSERT_TRUE(waitFor(connected, 1));
+    ASSERT_EQ(attempts, 3);
+    ASSERT_FALSE(scheduler.isRunning());
+}
+
+TEST_F(ReconnectScheduler, Given_FailingConnection_When_Stopped_Then_NoMoreAttemptsAreMade)
+{
+    // Given
+    std::atomic_int attempts{0};
+    wolkabout::ReconnectScheduler scheduler{executor,
+                                            [&] {
+                                                ++attempts;
+                                                return false;
+                                            },
+                                            [] {},
+                                            "test",
+                                            std::chrono::milliseconds{10},
+                                            std::chrono::milliseconds{10}};
+    scheduler.start();
+    ASSERT_TRUE(waitFor(attempts, 2));
+
+    // When
+    scheduler.stop();
+    const int attemptsAtStop = attempts;
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+
+    // Then
+    ASSERT_FALSE(scheduler.isRunning());
+    ASSERT_EQ(attempts, attemptsAtStop);
+}
+
+TEST_F(ReconnectScheduler, Given_ConnectionLostBeforeStablePeriod_When_Started_Then_ReconnectIsDelayed)
+{
+    // Given
+    std::atomic_int attempts{0};
+    std::atomic_int connected{0};
+    wolkabout::ReconnectScheduler scheduler{executor,
+                                            [&] {
+                                                ++attempts;
+                                                return true;
+                                            },
+                                            [&] { ++connected; },
+                                            "test",
+                                            std::chrono::milliseconds{200},
+                                            std::chrono::milliseconds{400},
+                                            std::chrono::seconds{10}};
+    scheduler.start();
+    ASSERT_TRUE(waitFor(connected, 1));
+
+    // When
+    scheduler.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+
+    // Then
+    ASSERT_EQ(attempts, 1);
+    ASSERT_TRUE(waitFor(connected, 2));
+    ASSERT_EQ(attempts, 2);
+}
+
+TEST_F(ReconnectScheduler, Given_StablePeriodIsReset_When_ConnectionIsLost_Then_ReconnectIsImmediate)
+{
+    // Given
+    std::atomic_int connected{0};
+    wolkabout::ReconnectScheduler scheduler{executor,
+                                            [] { return true; },
+                                            [&] { ++connected; },
+                                            "test",
+                                            std::chrono::seconds{5},
+                                            std::chrono::seconds{10},
+                                            std::chrono::seconds{10}};
+    scheduler.start();
+    ASSERT_TRUE(waitFor(connected, 1));
+
+    // When
+    scheduler.setBackoff(std::chrono::milliseconds{10}, std::chrono::milliseconds{20}, std::chrono::milliseconds{0});
+    scheduler.start();
+
+    // Then
+    ASSERT_TRUE(waitFor(connected, 2));
+}
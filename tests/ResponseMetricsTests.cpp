@@ -0,0 +1,42 @@
+#include "utilities/ResponseMetrics.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <string>
+
+namespace
+{
+class ResponseMetrics : public ::testing::Test
+{
+public:
+    wolkabout::MetricsRegistry& registry = wolkabout::MetricsRegistry::getInstance();
+};
+}    // namespace
+
+TEST_F(ResponseMetrics, Given_RequestChannels_When_ClassIsExtracted_Then_MessageTypeLevelIsReturned)
+{
+    // Then
+    ASSERT_EQ(wolkabout::ResponseMetrics::requestClass("d2p/register_subdevice_request/g/GATEWAY/d/DEVICE"),
+              "register_subdevice_request");
+    ASSERT_EQ(wolkabout::ResponseMetrics::requestClass("d2p/update_gateway_request"), "update_gateway_request");
+    ASSERT_EQ(wolkabout::ResponseMetrics::requestClass("ping"), "ping");
+    ASSERT_EQ(wolkabout::ResponseMetrics::requestClass(""), "unknown");
+}
+
+TEST_F(ResponseMetrics, Given_ResponsesAfterRetries_When_Recorded_Then_LatencyAndRetryCountsAreExposed)
+{
+    // Given
+    auto& metrics = wolkabout::ResponseMetrics::forRequestChannel("d2p/test_request/g/GATEWAY");
+
+    // When
+    metrics.record(std::chrono::milliseconds{20}, 0);
+    metrics.record(std::chrono::milliseconds{40}, 1);
+    metrics.record(std::chrono::milliseconds{60}, 9);
+
+    // Then
+    ASSERT_EQ(&metrics, &wolkabout::ResponseMetrics::forRequestChannel("d2p/test_request/g/OTHER"));
+    ASSERT_EQ(registry.histogram("wolkgateway_response_test_request_latency_seconds").count(), 3u);
+    ASSERT_EQ(registry.counter("wolkgateway_response_test_request_retries_0_total").value(), 1u);
+    ASSERT_EQ(registry.counter("wolkgateway_response_test_request_retries_1_total").value(), 1u);
+    ASSERT_EQ(registry.counter("wolkgateway_response_test_request_retries_5_total").value(), 1u);
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/DeviceReferences.h"
+#include "repository/RoutingSnapshot.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+class RoutingSnapshot : public ::testing::Test
+{
+public:
+    void SetUp() override { std::ofstream{DATABASE_PATH} << "database"; }
+
+    void TearDown() override
+    {
+        std::remove(SNAPSHOT_PATH);
+        std::remove(DATABASE_PATH);
+    }
+
+    static std::shared_ptr<const wolkabout::DeviceReferences> makeReferences()
+    {
+        return std::make_shared<const wolkabout::DeviceReferences>(
+          std::unordered_map<std::string, double>{{"T", 100}, {"P", 0}}, std::unordered_set<std::string>{"HIGH"},
+          std::unordered_set<std::string>{"SW", "SL"}, wolkabout::DeviceReferences::PayloadEncoding::MESSAGE_PACK);
+    }
+
+    static constexpr const char* SNAPSHOT_PATH = "testsRoutingSnapshot.bin";
+    static constexpr const char* DATABASE_PATH = "testsRoutingSnapshotDatabase.db";
+};
+}    // namespace
+
+TEST_F(RoutingSnapshot, Given_WrittenSnapshot_When_Loaded_Then_DevicesShareReferences)
+{
+    // Given
+    const auto references = makeReferences();
+    ASSERT_TRUE(wolkabout::RoutingSnapshot::write(SNAPSHOT_PATH, DATABASE_PATH,
+                                                  {{"DEVICE_KEY1", references}, {"DEVICE_KEY2", references}}));
+
+    // When
+    wolkabout::RoutingSnapshot::Devices devices;
+    ASSERT_TRUE(wolkabout::RoutingSnapshot::load(SNAPSHOT_PATH, DATABASE_PATH, devices));
+
+    // Then
+    ASSERT_EQ(devices.size(), 2u);
+    ASSERT_EQ(devices[0].first, "DEVICE_KEY1");
+    ASSERT_EQ(devices[1].first, "DEVICE_KEY2");
+    ASSERT_EQ(devices[0].second, devices[1].second);
+
+    const auto& loaded = *devices[0].second;
+    ASSERT_DOUBLE_EQ(loaded.getSensorRange("T"), 100);
+    ASSERT_TRUE(loaded.hasSensor("P"));
+    ASSERT_TRUE(loaded.hasAlarm("HIGH"));
+    ASSERT_TRUE(loaded.hasActuator("SW"));
+    ASSERT_TRUE(loaded.hasActuator("SL"));
+    ASSERT_FALSE(loaded.hasActuator("T"));
+    ASSERT_EQ(loaded.getPayloadEncoding(), wolkabout::DeviceReferences::PayloadEncoding::MESSAGE_PACK);
+}
+
+TEST_F(RoutingSnapshot, Given_WrittenSnapshot_When_DatabaseIsReplaced_Then_SnapshotIsStale)
+{
+    // Given
+    ASSERT_TRUE(wolkabout::RoutingSnapshot::write(SNAPSHOT_PATH, DATABASE_PATH, {{"DEVICE_KEY", makeReferences()}}));
+
+    // When
+    const std::string replacement = std::string{DATABASE_PATH} + ".new";
+    std::ofstream{replacement} << "database";
+    ASSERT_EQ(std::rename(replacement.c_str(), DATABASE_PATH), 0);
+
+    // Then
+    wolkabout::RoutingSnapshot::Devices devices;
+    ASSERT_FALSE(wolkabout::RoutingSnapshot::load(SNAPSHOT_PATH, DATABASE_PATH, devices));
+    ASSERT_TRUE(devices.empty());
+}
+
+TEST_F(RoutingSnapshot, Given_TruncatedSnapshot_When_Loaded_Then_LoadingFails)
+{
+    // Given
+    ASSERT_TRUE(wolkabout::RoutingSnapshot::write(SNAPSHOT_PATH, DATABASE_PATH, {{"DEVICE_KEY", makeReferences()}}));
+    std::string content;
+    {
+        std::ifstream file{SNAPSHOT_PATH, std::ios::binary};
+        content.assign(std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{});
+    }
+
+    // When
+    std::ofstream{SNAPSHOT_PATH, std::ios::binary | std::ios::trunc} << content.substr(0, content.size() - 1);
+
+    // Then
+    wolkabout::RoutingSnapshot::Devices devices;
+    ASSERT_FALSE(wolkabout::RoutingSnapshot::load(SNAPSHOT_PATH, DATABASE_PATH, devices));
+    ASSERT_FALSE(wolkabout::RoutingSnapshot::load("tests/missing/snapshot.bin", DATABASE_PATH, devices));
+}
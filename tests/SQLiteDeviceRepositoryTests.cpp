@@ -0,0 +1,259 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/DetailedDevice.h"
+#include "model/DeviceReferences.h"
+#include "repository/SQLiteDeviceRepository.h"
+
+#include "Poco/Data/Session.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class SQLiteDeviceRepository : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        deviceRepository = std::unique_ptr<wolkabout::SQLiteDeviceRepository>(
+          new wolkabout::SQLiteDeviceRepository(DEVICE_REPOSITORY_PATH, true, true));
+    }
+
+    void TearDown() override
+    {
+        deviceRepository.reset();
+        remove(DEVICE_REPOSITORY_PATH);
+        remove((std::string(DEVICE_REPOSITORY_PATH) + "-wal").c_str());
+        remove((std::string(DEVICE_REPOSITORY_PATH) + "-shm").c_str());
+    }
+
+    static wolkabout::DetailedDevice makeDevice(const std::string& key, const std::string& sensorReference)
+    {
+        return wolkabout::DetailedDevice(
+          "Device", key,
+          wolkabout::DeviceTemplate{
+            {},
+            {wolkabout::SensorTemplate{"", sensorReference, wolkabout::DataType::NUMERIC, "", {0}, {100}}},
+            {},
+            {},
+            "",
+            {},
+            {},
+            {}});
+    }
+
+    std::unique_ptr<wolkabout::SQLiteDeviceRepository> deviceRepository;
+
+    static constexpr const char* DEVICE_REPOSITORY_PATH = "testsSQLiteDeviceRepository.db";
+};
+}    // namespace
+
+TEST_F(SQLiteDeviceRepository, Given_ListOfDevices_When_SavedAtOnce_Then_AllDevicesAreInRepository)
+{
+    // Given
+    std::vector<wolkabout::DetailedDevice> devices;
+    for (int i = 0; i < 10; ++i)
+    {
+        devices.push_back(makeDevice("DEVICE_" + std::to_string(i), i % 2 == 0 ? "T" : "P"));
+    }
+
+    // When
+    deviceRepository->saveAll(devices);
+
+    // Then
+    ASSERT_EQ(deviceRepository->findAllDeviceKeys()->size(), 10u);
+    for (const auto& device : devices)
+    {
+        auto savedDevice = deviceRepository->findByDeviceKey(device.getKey());
+        ASSERT_NE(savedDevice, nullptr);
+        ASSERT_TRUE(*savedDevice == device);
+    }
+}
+
+TEST_F(SQLiteDeviceRepository, Given_DeviceThatCanNotBeSaved_When_SavedAtOnceWithOthers_Then_OthersAreSaved)
+{
+    // Given
+    Poco::Data::Session session{"SQLite", DEVICE_REPOSITORY_PATH};
+    session << "CREATE TRIGGER reject_device BEFORE INSERT ON device WHEN NEW.key='REJECTED' "
+               "BEGIN SELECT RAISE(ABORT, 'rejected'); END;",
+      Poco::Data::Keywords::now;
+
+    // When
+    deviceRepository->saveAll({makeDevice("DEVICE_1", "T"), makeDevice("REJECTED", "T"), makeDevice("DEVICE_2", "P")});
+
+    // Then
+    ASSERT_NE(deviceRepository->findByDeviceKey("DEVICE_1"), nullptr);
+    ASSERT_NE(deviceRepository->findByDeviceKey("DEVICE_2"), nullptr);
+    ASSERT_EQ(deviceRepository->findByDeviceKey("REJECTED"), nullptr);
+    ASSERT_EQ(deviceRepository->findAllDeviceKeys()->size(), 2u);
+}
+
+TEST_F(SQLiteDeviceRepository, Given_SavedDevice_When_SavedAgainWithDifferentTemplate_Then_DeviceIsUpdated)
+{
+    // Given
+    deviceRepository->save(makeDevice("DEVICE_KEY", "T"));
+
+    // When
+    deviceRepository->saveAll({makeDevice("DEVICE_KEY", "P")});
+
+    // Then
+    auto savedDevice = deviceRepository->findByDeviceKey("DEVICE_KEY");
+    ASSERT_NE(savedDevice, nullptr);
+    ASSERT_TRUE(savedDevice->getTemplate().hasSensorTemplateWithReference("P"));
+    ASSERT_FALSE(savedDevice->getTemplate().hasSensorTemplateWithReference("T"));
+}
+
+TEST_F(SQLiteDeviceRepository, Given_SavedDevices_When_AllAreRemoved_Then_RepositoryIsEmpty)
+{
+    // Given
+    deviceRepository->saveAll({makeDevice("DEVICE_1", "T"), makeDevice("DEVICE_2", "T")});
+
+    // When
+    deviceRepository->removeAll();
+
+    // Then
+    ASSERT_TRUE(deviceRepository->findAllDeviceKeys()->empty());
+    ASSERT_FALSE(deviceRepository->containsDeviceWithKey("DEVICE_1"));
+}
+
+TEST_F(SQLiteDeviceRepository, Given_DevicesSharingTemplate_When_OneIsRemoved_Then_OtherKeepsTemplate)
+{
+    // Given
+    deviceRepository->saveAll({makeDevice("DEVICE_1", "T"), makeDevice("DEVICE_2", "T")});
+    ASSERT_NE(deviceRepository->findByDeviceKey("DEVICE_1"), nullptr);
+
+    // When
+    deviceRepository->remove("DEVICE_1");
+
+    // Then
+    auto savedDevice = deviceRepository->findByDeviceKey("DEVICE_2");
+    ASSERT_NE(savedDevice, nullptr);
+    ASSERT_TRUE(*savedDevice == makeDevice("DEVICE_2", "T"));
+    ASSERT_EQ(deviceRepository->findByDeviceKey("DEVICE_1"), nullptr);
+}
+
+TEST_F(SQLiteDeviceRepository, Given_DevicesSharingTemplate_When_ReferencesAreFound_Then_ReferencesAreShared)
+{
+    // Given
+    deviceRepository->saveAll({makeDevice("DEVICE_1", "T"), makeDevice("DEVICE_2", "T"), makeDevice("DEVICE_3", "P")});
+
+    // When
+    const auto first = deviceRepository->findReferencesByDeviceKey("DEVICE_1");
+    const auto second = deviceRepository->findReferencesByDeviceKey("DEVICE_2");
+    const auto third = deviceRepository->findReferencesByDeviceKey("DEVICE_3");
+
+    // Then
+    ASSERT_NE(first, nullptr);
+    ASSERT_EQ(first, second);
+    ASSERT_TRUE(first->hasSensor("T"));
+
+    ASSERT_NE(third, nullptr);
+    ASSERT_TRUE(third->hasSensor("P"));
+    ASSERT_FALSE(third->hasSensor("T"));
+
+    ASSERT_EQ(deviceRepository->findReferencesByDeviceKey("DEVICE_4"), nullptr);
+}
+
+TEST_F(SQLiteDeviceRepository, Given_FoundReferences_When_DeviceIsSavedWithDifferentTemplate_Then_NewReferencesAreFound)
+{
+    // Given
+    deviceRepository->save(makeDevice("DEVICE_KEY", "T"));
+    ASSERT_TRUE(deviceRepository->findReferencesByDeviceKey("DEVICE_KEY")->hasSensor("T"));
+
+    // When
+    deviceRepository->save(makeDevice("DEVICE_KEY", "P"));
+
+    // Then
+    const auto references = deviceRepository->findReferencesByDeviceKey("DEVICE_KEY");
+    ASSERT_NE(references, nullptr);
+    ASSERT_TRUE(references->hasSensor("P"));
+    ASSERT_FALSE(references->hasSensor("T"));
+}
+
+TEST_F(SQLiteDeviceRepository, Given_SavedDevice_When_TemplateHashIsFound_Then_HashEqualsTemplateDigest)
+{
+    // Given
+    const auto device = makeDevice("DEVICE_KEY", "T");
+    deviceRepository->save(device);
+
+    // When
+    const auto hash = deviceRepository->findTemplateHash("DEVICE_KEY");
+
+    // Then
+    ASSERT_EQ(hash, wolkabout::SQLiteDeviceRepository::calculateSha256(device.getTemplate()));
+
+    deviceRepository->remove("DEVICE_KEY");
+    ASSERT_TRUE(deviceRepository->findTemplateHash("DEVICE_KEY").empty());
+}
+
+TEST_F(SQLiteDeviceRepository, Given_SavedDevices_When_RepositoryIsReopened_Then_SharedTemplatesAreLoaded)
+{
+    // Given
+    deviceRepository->saveAll({makeDevice("DEVICE_1", "T"), makeDevice("DEVICE_2", "T"), makeDevice("DEVICE_3", "P")});
+    deviceRepository->save(makeDevice("DEVICE_1", "T"));
+
+    // When
+    deviceRepository.reset(new wolkabout::SQLiteDeviceRepository(DEVICE_REPOSITORY_PATH, true, true));
+
+    // Then
+    ASSERT_EQ(deviceRepository->findAllDeviceKeys()->size(), 3u);
+    ASSERT_TRUE(*deviceRepository->findByDeviceKey("DEVICE_1") == makeDevice("DEVICE_1", "T"));
+    ASSERT_TRUE(*deviceRepository->findByDeviceKey("DEVICE_2") == makeDevice("DEVICE_2", "T"));
+    ASSERT_TRUE(*deviceRepository->findByDeviceKey("DEVICE_3") == makeDevice("DEVICE_3", "P"));
+}
+
+TEST_F(SQLiteDeviceRepository, Given_ReaderSessions_When_DevicesAreLookedUpConcurrently_Then_SavedDevicesAreFound)
+{
+    // Given
+    deviceRepository.reset(new wolkabout::SQLiteDeviceRepository(DEVICE_REPOSITORY_PATH, true, true, 2));
+    deviceRepository->saveAll({makeDevice("DEVICE_1", "T"), makeDevice("DEVICE_2", "P")});
+
+    // When
+    std::atomic_int found{0};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&] {
+            for (int j = 0; j < 25; ++j)
+            {
+                if (deviceRepository->containsDeviceWithKey("DEVICE_1") &&
+                    *deviceRepository->findByDeviceKey("DEVICE_2") == makeDevice("DEVICE_2", "P"))
+                {
+                    ++found;
+                }
+            }
+        });
+    }
+
+    deviceRepository->save(makeDevice("DEVICE_3", "T"));
+
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    // Then
+    ASSERT_EQ(found, 100);
+    ASSERT_EQ(deviceRepository->findAllDeviceKeys()->size(), 3u);
+    ASSERT_TRUE(*deviceRepository->findByDeviceKey("DEVICE_3") == makeDevice("DEVICE_3", "T"));
+}
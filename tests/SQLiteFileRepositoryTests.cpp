@@ -0,0 +1,95 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "repository/SQLiteFileRepository.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class SQLiteFileRepository : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        fileRepository = std::unique_ptr<wolkabout::SQLiteFileRepository>(
+          new wolkabout::SQLiteFileRepository(FILE_REPOSITORY_PATH));
+    }
+
+    void TearDown() override
+    {
+        fileRepository.reset();
+        remove(FILE_REPOSITORY_PATH);
+    }
+
+    std::unique_ptr<wolkabout::SQLiteFileRepository> fileRepository;
+
+    static constexpr const char* FILE_REPOSITORY_PATH = "testsFileRepository.db";
+};
+}    // namespace
+
+TEST_F(SQLiteFileRepository, Given_StoredFiles_When_FileInfoByHashIsRequested_Then_FileWithSameContentIsReturned)
+{
+    // Given
+    fileRepository->store(wolkabout::FileInfo{"firmware-a.bin", "hashA", "./firmware-a.bin"});
+    fileRepository->store(wolkabout::FileInfo{"firmware-b.bin", "hashB", "./firmware-b.bin"});
+
+    // When
+    auto info = fileRepository->getFileInfoByHash("hashB");
+
+    // Then
+    ASSERT_NE(info, nullptr);
+    ASSERT_EQ(info->name, "firmware-b.bin");
+    ASSERT_EQ(info->path, "./firmware-b.bin");
+    ASSERT_EQ(fileRepository->getFileInfoByHash("hashC"), nullptr);
+}
+
+TEST_F(SQLiteFileRepository, Given_StoredFiles_When_OldestFileIsTouched_Then_ItIsLastInLeastRecentlyUsedOrder)
+{
+    // Given
+    fileRepository->store(wolkabout::FileInfo{"first", "hash1", "./first"});
+    fileRepository->store(wolkabout::FileInfo{"second", "hash2", "./second"});
+    fileRepository->store(wolkabout::FileInfo{"third", "hash3", "./third"});
+
+    // When
+    fileRepository->touch("first");
+
+    // Then
+    auto fileNames = fileRepository->getFileNamesByLastUse();
+    ASSERT_NE(fileNames, nullptr);
+    ASSERT_EQ(*fileNames, (std::vector<std::string>{"second", "third", "first"}));
+}
+
+TEST_F(SQLiteFileRepository, Given_TouchedFile_When_RepositoryIsReopened_Then_LeastRecentlyUsedOrderIsKept)
+{
+    // Given
+    fileRepository->store(wolkabout::FileInfo{"first", "hash1", "./first"});
+    fileRepository->store(wolkabout::FileInfo{"second", "hash2", "./second"});
+    fileRepository->touch("first");
+
+    // When
+    fileRepository.reset(new wolkabout::SQLiteFileRepository(FILE_REPOSITORY_PATH));
+    fileRepository->store(wolkabout::FileInfo{"third", "hash3", "./third"});
+
+    // Then
+    auto fileNames = fileRepository->getFileNamesByLastUse();
+    ASSERT_NE(fileNames, nullptr);
+    ASSERT_EQ(*fileNames, (std::vector<std::string>{"second", "first", "third"}));
+}
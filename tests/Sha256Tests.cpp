@@ -0,0 +1,84 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/Sha256.h"
+#include "utilities/ByteUtils.h"
+#include "utilities/FileSystemUtils.h"
+
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <string>
+
+namespace
+{
+const char* FILE_PATH = "./sha256TestFile";
+
+// SHA-256 of "abc", from FIPS 180-2
+const wolkabout::ByteArray ABC_HASH{0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40,
+                                    0xde, 0x5d, 0xae, 0x22, 0x23, 0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17,
+                                    0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad};
+
+class Sha256 : public ::testing::Test
+{
+public:
+    void TearDown() override { std::remove(FILE_PATH); }
+};
+}    // namespace
+
+TEST_F(Sha256, Given_DataInParts_When_Digested_Then_HashEqualsHashOfWholeData)
+{
+    // Given
+    wolkabout::Sha256 sha256;
+
+    // When
+    sha256.update(wolkabout::ByteUtils::toByteArray("a"));
+    sha256.update(wolkabout::ByteUtils::toByteArray("bc"));
+
+    // Then
+    ASSERT_EQ(sha256.digest(), ABC_HASH);
+}
+
+TEST_F(Sha256, Given_Data_When_HashedAtOnce_Then_HashEqualsKnownHash)
+{
+    // When
+    const auto hash = wolkabout::Sha256::hash(wolkabout::ByteUtils::toByteArray("abc"));
+
+    // Then
+    ASSERT_EQ(hash, ABC_HASH);
+}
+
+TEST_F(Sha256, Given_File_When_Hashed_Then_HashEqualsHashOfContent)
+{
+    // Given
+    ASSERT_TRUE(wolkabout::FileSystemUtils::createBinaryFileWithContent(FILE_PATH,
+                                                                        wolkabout::ByteUtils::toByteArray("abc")));
+
+    // When
+    wolkabout::ByteArray hash;
+    ASSERT_TRUE(wolkabout::Sha256::hashFile(FILE_PATH, hash));
+
+    // Then
+    ASSERT_EQ(hash, ABC_HASH);
+}
+
+TEST_F(Sha256, Given_MissingFile_When_Hashed_Then_FalseIsReturned)
+{
+    // Given
+    wolkabout::ByteArray hash;
+
+    // Then
+    ASSERT_FALSE(wolkabout::Sha256::hashFile("./missingSha256TestFile", hash));
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "connectivity/ShardConnectivityService.h"
+#include "MockConnectivityService.h"
+#include "model/Message.h"
+#include "utilities/DeviceShard.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class ListenedConnectivityService : public MockConnectivityService
+{
+public:
+    std::shared_ptr<wolkabout::ConnectivityServiceListener> listener() const { return m_listener.lock(); }
+};
+
+class RecordingListener : public wolkabout::ConnectivityServiceListener
+{
+public:
+    void messageReceived(const std::string& channel, const std::string&) override { channels.push_back(channel); }
+    void connectionLost() override {}
+    std::vector<std::string> getChannels() const override { return {"d2p/sensor_reading/d/+/r/+"}; }
+
+    std::vector<std::string> channels;
+};
+
+class ShardConnectivityService : public ::testing::Test
+{
+public:
+    void make(bool routed)
+    {
+        mock = new ListenedConnectivityService();
+        service.reset(new wolkabout::ShardConnectivityService(std::unique_ptr<wolkabout::ConnectivityService>(mock),
+                                                              wolkabout::DeviceShard{1, 2}, routed));
+        listener = std::make_shared<RecordingListener>();
+        service->setListener(listener);
+    }
+
+    static std::string keyOfShard(std::size_t shard)
+    {
+        for (int i = 0;; ++i)
+        {
+            const std::string key = "device" + std::to_string(i);
+            if (wolkabout::DeviceShard::of(key, 2) == shard)
+            {
+                return key;
+            }
+        }
+    }
+
+    ListenedConnectivityService* mock = nullptr;
+    std::unique_ptr<wolkabout::ShardConnectivityService> service;
+    std::shared_ptr<RecordingListener> listener;
+};
+}    // namespace
+
+TEST_F(ShardConnectivityService, Given_RoutedShard_When_MessagesArrive_Then_PrefixIsRemovedAndOtherShardsAreDropped)
+{
+    // Given
+    make(true);
+    const auto own = "d2p/sensor_reading/d/" + keyOfShard(1) + "/r/T";
+    const auto other = "d2p/sensor_reading/d/" + keyOfShard(0) + "/r/T";
+
+    // When
+    mock->listener()->messageReceived("shard/1/" + own, "{}");
+    mock->listener()->messageReceived("shard/1/" + other, "{}");
+    mock->listener()->messageReceived(own, "{}");
+
+    // Then
+    ASSERT_EQ(mock->listener()->getChannels(), (std::vector<std::string>{"shard/1/d2p/sensor_reading/d/+/r/+"}));
+    ASSERT_EQ(listener->channels, (std::vector<std::string>{own}));
+}
+
+TEST_F(ShardConnectivityService, Given_UnroutedShard_When_MessagesArrive_Then_OnlyMessagesOfShardDevicesArePassed)
+{
+    // Given
+    make(false);
+    const auto own = "p2d/actuator_set/g/gateway/d/" + keyOfShard(1) + "/r/SW";
+    const auto other = "p2d/actuator_set/g/gateway/d/" + keyOfShard(0) + "/r/SW";
+
+    // When
+    mock->listener()->messageReceived(own, "{}");
+    mock->listener()->messageReceived(other, "{}");
+    mock->listener()->messageReceived("p2d/actuator_set/g/gateway/r/SW", "{}");
+
+    // Then
+    ASSERT_EQ(mock->listener()->getChannels(), (std::vector<std::string>{"d2p/sensor_reading/d/+/r/+"}));
+    ASSERT_EQ(listener->channels, (std::vector<std::string>{own}));
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "connectivity/ShardRouter.h"
+#include "MockConnectivityService.h"
+#include "model/Message.h"
+#include "utilities/DeviceShard.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using ::testing::_;
+using ::testing::Invoke;
+
+namespace
+{
+class ListenedConnectivityService : public MockConnectivityService
+{
+public:
+    std::shared_ptr<wolkabout::ConnectivityServiceListener> listener() const { return m_listener.lock(); }
+};
+
+class ShardRouter : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        mock = new ListenedConnectivityService();
+        ON_CALL(*mock, publish(_, _)).WillByDefault(Invoke([this](std::shared_ptr<wolkabout::Message> message, bool) {
+            std::lock_guard<std::mutex> lg{lock};
+            published.push_back(message->getChannel());
+            condition.notify_all();
+            return true;
+        }));
+        EXPECT_CALL(*mock, publish(_, _)).Times(::testing::AnyNumber());
+
+        router.reset(new wolkabout::ShardRouter(std::unique_ptr<wolkabout::ConnectivityService>(mock),
+                                                {"d2p/sensor_reading/d/+/r/+", "d2p/subdevice_registration_request/#"},
+                                                3));
+    }
+
+    bool waitForPublished(std::size_t count)
+    {
+        std::unique_lock<std::mutex> locker{lock};
+        return condition.wait_for(locker, std::chrono::seconds{5}, [&] { return published.size() >= count; });
+    }
+
+    ListenedConnectivityService* mock = nullptr;
+    std::unique_ptr<wolkabout::ShardRouter> router;
+
+    std::mutex lock;
+    std::condition_variable condition;
+    std::vector<std::string> published;
+};
+}    // namespace
+
+TEST_F(ShardRouter, Given_MessagesOfDevices_When_Received_Then_TheyAreRepublishedToOwningShardsInOrder)
+{
+    // Given
+    std::vector<std::string> channels;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 20; ++i)
+    {
+        const std::string key = "device" + std::to_string(i);
+        channels.push_back("d2p/sensor_reading/d/" + key + "/r/T");
+        expected.push_back(wolkabout::DeviceShard::channelPrefix(wolkabout::DeviceShard::of(key, 3)) +
+                           channels.back());
+    }
+
+    // When
+    for (const auto& channel : channels)
+    {
+        mock->listener()->messageReceived(channel, "{}");
+    }
+    mock->listener()->messageReceived("shard/2/d2p/sensor_reading/d/device1/r/T", "{}");
+    mock->listener()->messageReceived("d2p/subdevice_registration_request/g/gateway", "{}");
+    expected.push_back("shard/0/d2p/subdevice_registration_request/g/gateway");
+
+    // Then
+    ASSERT_TRUE(waitForPublished(expected.size()));
+    std::lock_guard<std::mutex> lg{lock};
+    ASSERT_EQ(published, expected);
+    ASSERT_EQ(mock->listener()->getChannels().size(), 2u);
+}
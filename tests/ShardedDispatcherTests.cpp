@@ -0,0 +1,109 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/ShardedDispatcher.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class ShardedDispatcher : public ::testing::Test
+{
+public:
+    bool waitFor(const std::atomic_int& counter, int value)
+    {
+        for (int i = 0; i < 200 && counter != value; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{10});
+        }
+
+        return counter == value;
+    }
+};
+}    // namespace
+
+TEST_F(ShardedDispatcher, Given_TasksForSeveralKeys_When_Dispatched_Then_TasksOfEachKeyRunInOrder)
+{
+    // Given
+    wolkabout::ShardedDispatcher dispatcher{4};
+
+    std::mutex lock;
+    std::map<std::string, std::vector<int>> executed;
+    std::atomic_int counter{0};
+
+    // When
+    for (int i = 0; i < 1000; ++i)
+    {
+        const std::string key = "device" + std::to_string(i % 10);
+        dispatcher.dispatch(key, [&, key, i] {
+            {
+                std::lock_guard<std::mutex> locker{lock};
+                executed[key].push_back(i);
+            }
+            ++counter;
+        });
+    }
+
+    // Then
+    ASSERT_TRUE(waitFor(counter, 1000));
+    for (const auto& kvp : executed)
+    {
+        ASSERT_EQ(kvp.second.size(), 100u);
+        ASSERT_TRUE(std::is_sorted(kvp.second.begin(), kvp.second.end()));
+    }
+}
+
+TEST_F(ShardedDispatcher, Given_BlockedKey_When_OtherKeysAreDispatched_Then_TheyAreNotHeldBack)
+{
+    // Given
+    wolkabout::ShardedDispatcher dispatcher{2, 2};
+
+    std::atomic_bool release{false};
+    std::atomic_int others{0};
+
+    const std::string blocked = "blocked";
+    dispatcher.dispatch(blocked, [&] {
+        while (!release)
+        {
+            std::this_thread::yield();
+        }
+    });
+
+    // When
+    int expected = 0;
+    for (int i = 0; i < 100; ++i)
+    {
+        const std::string key = "device" + std::to_string(i);
+        if (std::hash<std::string>{}(key) % 2 != std::hash<std::string>{}(blocked) % 2)
+        {
+            dispatcher.dispatch(key, [&] { ++others; });
+            ++expected;
+        }
+    }
+
+    // Then
+    ASSERT_TRUE(waitFor(others, expected));
+
+    release = true;
+}
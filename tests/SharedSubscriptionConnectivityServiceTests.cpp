@@ -0,0 +1,122 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "connectivity/SharedSubscriptionConnectivityService.h"
+#include "MockConnectivityService.h"
+#include "model/Message.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace
+{
+class ListenedConnectivityService : public MockConnectivityService
+{
+public:
+    std::shared_ptr<wolkabout::ConnectivityServiceListener> listener() const { return m_listener.lock(); }
+};
+
+class RecordingListener : public wolkabout::ConnectivityServiceListener
+{
+public:
+    void messageReceived(const std::string& channel, const std::string&) override { channels.push_back(channel); }
+    void connectionLost() override { ++lostConnections; }
+    std::vector<std::string> getChannels() const override { return {"d2p/sensor_reading/d/+/r/+", "d2p/events/#"}; }
+
+    std::vector<std::string> channels;
+    int lostConnections = 0;
+};
+
+class SharedSubscriptionConnectivityService : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        std::vector<std::unique_ptr<wolkabout::ConnectivityService>> connections;
+        for (int i = 0; i < 2; ++i)
+        {
+            auto connection = new ListenedConnectivityService();
+            mocks.push_back(connection);
+            connections.emplace_back(connection);
+        }
+
+        service.reset(new wolkabout::SharedSubscriptionConnectivityService(std::move(connections), "gateway"));
+        listener = std::make_shared<RecordingListener>();
+        service->setListener(listener);
+    }
+
+    std::vector<ListenedConnectivityService*> mocks;
+    std::unique_ptr<wolkabout::SharedSubscriptionConnectivityService> service;
+    std::shared_ptr<RecordingListener> listener;
+};
+}    // namespace
+
+TEST_F(SharedSubscriptionConnectivityService, Given_Listener_When_ChannelsAreRequested_Then_SharedFiltersAreReturned)
+{
+    // When
+    const auto channels = mocks.at(1)->listener()->getChannels();
+
+    // Then
+    ASSERT_EQ(channels, (std::vector<std::string>{"$share/gateway/d2p/sensor_reading/d/+/r/+",
+                                                  "$share/gateway/d2p/events/#"}));
+}
+
+TEST_F(SharedSubscriptionConnectivityService, Given_MessagesOnEachConnection_When_Received_Then_ListenerGetsAllOfThem)
+{
+    // When
+    mocks.at(0)->listener()->messageReceived("d2p/events/d/device1/r/A", "{}");
+    mocks.at(1)->listener()->messageReceived("d2p/events/d/device2/r/A", "{}");
+    mocks.at(1)->listener()->connectionLost();
+
+    // Then
+    ASSERT_EQ(listener->channels, (std::vector<std::string>{"d2p/events/d/device1/r/A", "d2p/events/d/device2/r/A"}));
+    ASSERT_EQ(listener->lostConnections, 1);
+}
+
+TEST_F(SharedSubscriptionConnectivityService, Given_OneConnectionIsDown_When_Connect_Then_OnlyThatConnectionConnects)
+{
+    // Given
+    EXPECT_CALL(*mocks.at(0), isConnected()).WillRepeatedly(testing::Return(true));
+    EXPECT_CALL(*mocks.at(1), isConnected()).WillOnce(testing::Return(false)).WillRepeatedly(testing::Return(true));
+    EXPECT_CALL(*mocks.at(0), connect()).Times(0);
+    EXPECT_CALL(*mocks.at(1), connect()).WillOnce(testing::Return(true));
+
+    // When
+    const bool connected = service->connect();
+
+    // Then
+    ASSERT_TRUE(connected);
+    ASSERT_TRUE(service->isConnected());
+}
+
+TEST_F(SharedSubscriptionConnectivityService, Given_FirstConnectionIsDown_When_Publish_Then_SecondConnectionIsUsed)
+{
+    // Given
+    EXPECT_CALL(*mocks.at(0), isConnected()).WillRepeatedly(testing::Return(false));
+    EXPECT_CALL(*mocks.at(1), isConnected()).WillRepeatedly(testing::Return(true));
+    EXPECT_CALL(*mocks.at(0), publish(testing::_, testing::_)).Times(0);
+    EXPECT_CALL(*mocks.at(1), publish(testing::_, testing::_)).WillOnce(testing::Return(true));
+
+    // When
+    const bool published = service->publish(std::make_shared<wolkabout::Message>("content", "p2d/channel"));
+
+    // Then
+    ASSERT_TRUE(published);
+}
@@ -158,3 +158,41 @@ TEST_F(JsonGatewayStatusProtocol, Given_StatusResponseMessage_When_StatusRespons
     ASSERT_TRUE(response);
     ASSERT_EQ(response->getStatus(), wolkabout::DeviceStatus::Status::CONNECTED);
 }
+
+TEST_F(JsonGatewayStatusProtocol, Given_StatusUpdateWithExtraFields_When_UpdateIsCreated_Then_ExtraFieldsAreIgnored)
+{
+    // Given
+    const std::string jsonPayload = R"({"timestamp": 1546300800, "details": {"battery": [90, 85]}, "state": "SLEEP"})";
+    const std::string channel = "d2p/subdevice_status_update/d/DEVICE_KEY";
+    const auto message = std::make_shared<wolkabout::Message>(jsonPayload, channel);
+
+    // When
+    const auto update = protocol->makeDeviceStatusUpdate(*message);
+
+    // Then
+    ASSERT_TRUE(update);
+    ASSERT_EQ(update->getStatus(), wolkabout::DeviceStatus::Status::SLEEP);
+}
+
+TEST_F(JsonGatewayStatusProtocol, Given_MalformedStatusMessage_When_StatusResponseIsCreated_Then_NoResponseIsCreated)
+{
+    // Given
+    const std::string channel = "d2p/subdevice_status_response/d/DEVICE_KEY";
+    const auto missingState = std::make_shared<wolkabout::Message>(R"({"status":"CONNECTED"})", channel);
+    const auto truncated = std::make_shared<wolkabout::Message>(R"({"state":"CONNECTED")", channel);
+
+    // Then
+    ASSERT_FALSE(protocol->makeDeviceStatusResponse(*missingState));
+    ASSERT_FALSE(protocol->makeDeviceStatusResponse(*truncated));
+}
+
+TEST_F(JsonGatewayStatusProtocol, Given_ArrayOfKeys_When_KeysAreExtracted_Then_AllKeysAreReturned)
+{
+    // When
+    const auto keys = protocol->extractDeviceKeysFromContent(R"(["KEY1", "KEY2"])");
+    const auto invalid = protocol->extractDeviceKeysFromContent(R"({"keys": ["KEY1"]})");
+
+    // Then
+    ASSERT_EQ(keys, (std::vector<std::string>{"KEY1", "KEY2"}));
+    ASSERT_TRUE(invalid.empty());
+}
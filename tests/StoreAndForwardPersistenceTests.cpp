@@ -0,0 +1,145 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "persistence/StoreAndForwardPersistence.h"
+#include "model/Message.h"
+#include "persistence/inmemory/GatewayInMemoryPersistence.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class StoreAndForwardPersistence : public ::testing::Test
+{
+public:
+    void create(std::size_t liveCapacity, std::size_t liveWeight,
+                std::chrono::milliseconds dedupWindow = std::chrono::milliseconds{0})
+    {
+        persistence.reset(new wolkabout::StoreAndForwardPersistence(
+          std::unique_ptr<wolkabout::GatewayPersistence>(new wolkabout::GatewayInMemoryPersistence()), liveCapacity,
+          liveWeight, dedupWindow, [](const wolkabout::Message& message) {
+              return message.getChannel().compare(0, 19, "d2p/sensor_reading/") == 0;
+          }));
+    }
+
+    bool push(const std::string& content, const std::string& channel = "channel")
+    {
+        return persistence->push(std::make_shared<wolkabout::Message>(content, channel));
+    }
+
+    static std::string contents(const std::vector<std::shared_ptr<wolkabout::Message>>& messages)
+    {
+        std::string joined;
+        for (const auto& message : messages)
+        {
+            joined += message->getContent();
+        }
+
+        return joined;
+    }
+
+    std::unique_ptr<wolkabout::StoreAndForwardPersistence> persistence;
+};
+}    // namespace
+
+TEST_F(StoreAndForwardPersistence, Given_BacklogOverLiveCapacity_When_Drained_Then_NewestMessagesGoFirst)
+{
+    // Given
+    create(2, 2);
+    for (const auto& content : {"a", "b", "c", "d", "e"})
+    {
+        ASSERT_TRUE(push(content));
+    }
+
+    // When
+    const auto batch = persistence->frontBatch(10);
+
+    // Then
+    ASSERT_EQ(contents(batch), "deabc");
+    ASSERT_EQ(persistence->popBatch(batch.size()), batch.size());
+    ASSERT_TRUE(persistence->empty());
+}
+
+TEST_F(StoreAndForwardPersistence, Given_LiveAndBackfillMessages_When_Drained_Then_TheyAreInterleavedByWeight)
+{
+    // Given
+    create(2, 1);
+    for (const auto& content : {"a", "b", "c", "d"})
+    {
+        ASSERT_TRUE(push(content));
+    }
+
+    // When
+    const auto first = persistence->frontBatch(1);
+    ASSERT_EQ(persistence->popBatch(1), 1u);
+    const auto rest = persistence->frontBatch(3);
+
+    // Then
+    ASSERT_EQ(contents(first), "c");
+    ASSERT_EQ(contents(rest), "adb");
+}
+
+TEST_F(StoreAndForwardPersistence, Given_DedupWindow_When_DuplicateIsPushed_Then_ItIsRejectedUntilWindowPasses)
+{
+    // Given
+    create(10, 1, std::chrono::milliseconds{50});
+    ASSERT_TRUE(push(R"({"utc":1,"data":"5"})", "d2p/sensor_reading/d/device1/r/T"));
+
+    // Then
+    ASSERT_FALSE(push(R"({"utc":1,"data":"5"})", "d2p/sensor_reading/d/device1/r/T"));
+    ASSERT_TRUE(push(R"({"utc":1,"data":"5"})", "d2p/sensor_reading/d/device2/r/T"));
+    ASSERT_TRUE(push(R"({"utc":2,"data":"5"})", "d2p/sensor_reading/d/device1/r/T"));
+
+    // When
+    std::this_thread::sleep_for(std::chrono::milliseconds{100});
+
+    // Then
+    ASSERT_TRUE(push(R"({"utc":1,"data":"5"})", "d2p/sensor_reading/d/device1/r/T"));
+}
+
+TEST_F(StoreAndForwardPersistence, Given_DedupWindow_When_RepeatedMessageHasNoTime_Then_ItIsKept)
+{
+    // Given
+    create(10, 1, std::chrono::milliseconds{1000});
+
+    // Then
+    ASSERT_TRUE(push(R"({"data":"5"})", "d2p/sensor_reading/d/device1/r/T"));
+    ASSERT_TRUE(push(R"({"data":"5"})", "d2p/sensor_reading/d/device1/r/T"));
+    ASSERT_TRUE(push(R"([{"utc":1,"data":"5"},{"data":"6"}])", "d2p/sensor_reading/d/device1/r/T"));
+    ASSERT_TRUE(push(R"([{"utc":1,"data":"5"},{"data":"6"}])", "d2p/sensor_reading/d/device1/r/T"));
+    ASSERT_TRUE(push(R"({"utc":1,"data":"ON"})", "d2p/events/d/device1/r/A"));
+    ASSERT_TRUE(push(R"({"utc":1,"data":"ON"})", "d2p/events/d/device1/r/A"));
+}
+
+TEST_F(StoreAndForwardPersistence, Given_HandedOutMessage_When_CapacityIsExceeded_Then_HandedOutMessageIsPopped)
+{
+    // Given
+    create(1, 1);
+    ASSERT_TRUE(push("a"));
+    ASSERT_EQ(contents(persistence->frontBatch(1)), "a");
+
+    // When
+    ASSERT_TRUE(push("b"));
+    ASSERT_EQ(persistence->popBatch(1), 1u);
+
+    // Then
+    ASSERT_EQ(persistence->front()->getContent(), "b");
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/TimerWheel.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class TimerWheel : public ::testing::Test
+{
+public:
+    void record(int value)
+    {
+        std::lock_guard<std::mutex> locker{lock};
+        fired.push_back(value);
+    }
+
+    std::vector<int> getFired()
+    {
+        std::lock_guard<std::mutex> locker{lock};
+        return fired;
+    }
+
+    std::mutex lock;
+    std::vector<int> fired;
+};
+}    // namespace
+
+TEST_F(TimerWheel, Given_ScheduledTimeouts_When_TheyExpire_Then_CallbacksAreInvokedInOrder)
+{
+    // Given
+    wolkabout::TimerWheel wheel{std::chrono::milliseconds{1}};
+    wheel.schedule(std::chrono::milliseconds{90}, [&] { record(3); });
+    wheel.schedule(std::chrono::milliseconds{10}, [&] { record(1); });
+    wheel.schedule(std::chrono::milliseconds{40}, [&] { record(2); });
+
+    // When
+    std::this_thread::sleep_for(std::chrono::milliseconds{300});
+
+    // Then
+    ASSERT_EQ(getFired(), (std::vector<int>{1, 2, 3}));
+    ASSERT_EQ(wheel.size(), 0u);
+}
+
+TEST_F(TimerWheel, Given_ScheduledTimeout_When_Cancelled_Then_CallbackIsNotInvoked)
+{
+    // Given
+    wolkabout::TimerWheel wheel{std::chrono::milliseconds{1}};
+    const auto id = wheel.schedule(std::chrono::milliseconds{50}, [&] { record(1); });
+    wheel.schedule(std::chrono::milliseconds{70}, [&] { record(2); });
+
+    // When
+    ASSERT_TRUE(wheel.cancel(id));
+
+    // Then
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+    ASSERT_FALSE(wheel.cancel(id));
+    ASSERT_EQ(getFired(), (std::vector<int>{2}));
+}
+
+TEST_F(TimerWheel, Given_TimeoutBeyondFirstLevel_When_ItExpires_Then_CallbackIsInvokedOnTime)
+{
+    // Given
+    wolkabout::TimerWheel wheel{std::chrono::milliseconds{1}};
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<long long> elapsed{0};
+
+    // When
+    wheel.schedule(std::chrono::milliseconds{200}, [&] {
+        elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start)
+                    .count();
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds{400});
+
+    // Then
+    ASSERT_GE(elapsed, 200);
+    ASSERT_LT(elapsed, 300);
+}
+
+TEST_F(TimerWheel, Given_Callback_When_ItSchedulesAnotherTimeout_Then_BothAreInvoked)
+{
+    // Given
+    wolkabout::TimerWheel wheel{std::chrono::milliseconds{1}};
+
+    // When
+    wheel.schedule(std::chrono::milliseconds{10}, [&] {
+        record(1);
+        wheel.schedule(std::chrono::milliseconds{10}, [&] { record(2); });
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds{200});
+
+    // Then
+    ASSERT_EQ(getFired(), (std::vector<int>{1, 2}));
+}
@@ -0,0 +1,134 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/TopicTrie.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+namespace
+{
+class TopicTrie : public ::testing::Test
+{
+public:
+    wolkabout::TopicTrie<std::string> trie;
+};
+}    // namespace
+
+TEST_F(TopicTrie, Given_ExactFilter_When_TopicMatches_Then_ValueIsReturned)
+{
+    // Given
+    trie.insert("d2p/sensor_reading/d/device1/r/T", "exact");
+
+    // When
+    const auto* value = trie.match("d2p/sensor_reading/d/device1/r/T");
+
+    // Then
+    ASSERT_NE(value, nullptr);
+    ASSERT_EQ(*value, "exact");
+    ASSERT_EQ(trie.match("d2p/sensor_reading/d/device1/r/P"), nullptr);
+}
+
+TEST_F(TopicTrie, Given_SingleLevelWildcard_When_TopicHasAnyLevel_Then_ValueIsReturned)
+{
+    // Given
+    trie.insert("d2p/sensor_reading/d/+/r/T", "single");
+
+    // When
+    const auto* value = trie.match("d2p/sensor_reading/d/device1/r/T");
+
+    // Then
+    ASSERT_NE(value, nullptr);
+    ASSERT_EQ(*value, "single");
+    ASSERT_EQ(trie.match("d2p/sensor_reading/d/device1/extra/r/T"), nullptr);
+}
+
+TEST_F(TopicTrie, Given_MultiLevelWildcard_When_TopicIsDeeper_Then_ValueIsReturned)
+{
+    // Given
+    trie.insert("d2p/sensor_reading/d/+/r/#", "multi");
+
+    // Then
+    ASSERT_NE(trie.match("d2p/sensor_reading/d/device1/r/T"), nullptr);
+    ASSERT_NE(trie.match("d2p/sensor_reading/d/device1/r/T/extra"), nullptr);
+    ASSERT_NE(trie.match("d2p/sensor_reading/d/device1/r"), nullptr);
+    ASSERT_EQ(trie.match("d2p/events/d/device1/r/T"), nullptr);
+}
+
+TEST_F(TopicTrie, Given_OverlappingFilters_When_TopicMatchesSeveral_Then_LexicographicallySmallestFilterWins)
+{
+    // Given
+    trie.insert("p2d/actuator_set/g/+/r/#", "wildcard");
+    trie.insert("p2d/actuator_set/g/gateway/r/#", "exact");
+    trie.insert("p2d/#", "root");
+
+    // When
+    const auto* value = trie.match("p2d/actuator_set/g/gateway/r/SW");
+    const auto values = trie.matchAll("p2d/actuator_set/g/gateway/r/SW");
+
+    // Then
+    ASSERT_NE(value, nullptr);
+    ASSERT_EQ(*value, "root");
+    ASSERT_EQ(values, (std::vector<std::string>{"root", "wildcard", "exact"}));
+}
+
+TEST_F(TopicTrie, Given_InsertedFilter_When_Removed_Then_TopicNoLongerMatches)
+{
+    // Given
+    trie.insert("d2p/events/d/+/r/#", "events");
+    trie.insert("d2p/events/d/device1/r/#", "device1");
+    ASSERT_EQ(trie.size(), 2u);
+
+    // When
+    ASSERT_TRUE(trie.remove("d2p/events/d/+/r/#"));
+
+    // Then
+    ASSERT_FALSE(trie.remove("d2p/events/d/+/r/#"));
+    ASSERT_EQ(trie.size(), 1u);
+    ASSERT_EQ(trie.match("d2p/events/d/device2/r/A"), nullptr);
+    ASSERT_NE(trie.match("d2p/events/d/device1/r/A"), nullptr);
+}
+
+TEST_F(TopicTrie, Given_SameFilterInsertedTwice_When_Matched_Then_LatestValueIsReturned)
+{
+    // Given
+    trie.insert("d2p/events/d/+/r/#", "first");
+    trie.insert("d2p/events/d/+/r/#", "second");
+
+    // When
+    const auto* value = trie.match("d2p/events/d/device1/r/A");
+
+    // Then
+    ASSERT_EQ(trie.size(), 1u);
+    ASSERT_NE(value, nullptr);
+    ASSERT_EQ(*value, "second");
+}
+
+TEST_F(TopicTrie, Given_CopiedTrie_When_OriginalIsModified_Then_CopyIsUnchanged)
+{
+    // Given
+    trie.insert("p2d/actuator_set/g/+/r/#", "actuator");
+    wolkabout::TopicTrie<std::string> copy{trie};
+
+    // When
+    trie.remove("p2d/actuator_set/g/+/r/#");
+    trie.insert("p2d/configuration_set/g/+", "configuration");
+
+    // Then
+    ASSERT_EQ(copy.size(), 1u);
+    ASSERT_NE(copy.match("p2d/actuator_set/g/gateway/r/SW"), nullptr);
+    ASSERT_EQ(copy.match("p2d/configuration_set/g/gateway"), nullptr);
+}
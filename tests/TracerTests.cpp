@@ -0,0 +1,132 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "model/Message.h"
+#include "utilities/Tracer.h"
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <iterator>
+#include <string>
+
+namespace
+{
+class Tracer : public ::testing::Test
+{
+public:
+    void TearDown() override { wolkabout::Tracer::getInstance().configure(0); }
+
+    static std::string read(const std::string& path)
+    {
+        std::ifstream file{path};
+        return std::string{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    const std::string traceFile = "tracer_test_trace.json";
+};
+}    // namespace
+
+TEST_F(Tracer, Given_SamplingOneInThree_When_MessagesAreSampled_Then_EveryThirdGetsTraceId)
+{
+    // Given
+    auto& tracer = wolkabout::Tracer::getInstance();
+    tracer.configure(3);
+
+    // When
+    const auto first = tracer.sample();
+    const auto second = tracer.sample();
+    const auto third = tracer.sample();
+    const auto fourth = tracer.sample();
+
+    // Then
+    ASSERT_EQ(1, (first != 0) + (second != 0) + (third != 0));
+    ASSERT_EQ(first != 0, fourth != 0);
+}
+
+TEST_F(Tracer, Given_DisabledTracing_When_MessageIsSampled_Then_ItIsNotTraced)
+{
+    // Given
+    auto& tracer = wolkabout::Tracer::getInstance();
+    tracer.configure(0);
+
+    // Then
+    ASSERT_FALSE(tracer.enabled());
+    ASSERT_EQ(tracer.sample(), 0u);
+}
+
+TEST_F(Tracer, Given_TraceScope_When_SpanIsRecorded_Then_ItIsWrittenWithTraceId)
+{
+    // Given
+    auto& tracer = wolkabout::Tracer::getInstance();
+    tracer.configure(1);
+    const auto traceId = tracer.sample();
+
+    // When
+    {
+        wolkabout::TraceScope scope{traceId};
+        ASSERT_EQ(wolkabout::Tracer::current(), traceId);
+        wolkabout::TraceSpan span{"stage"};
+    }
+    ASSERT_EQ(wolkabout::Tracer::current(), 0u);
+    ASSERT_TRUE(tracer.dump(traceFile));
+
+    // Then
+    const auto trace = read(traceFile);
+    std::remove(traceFile.c_str());
+    ASSERT_NE(trace.find("\"traceEvents\":[{\"name\":\"stage\""), std::string::npos);
+    ASSERT_NE(trace.find("\"ph\":\"X\""), std::string::npos);
+    ASSERT_NE(trace.find("\"args\":{\"trace\":" + std::to_string(traceId) + "}"), std::string::npos);
+}
+
+TEST_F(Tracer, Given_FullRingBuffer_When_SpanIsRecorded_Then_OldestSpanIsOverwritten)
+{
+    // Given
+    auto& tracer = wolkabout::Tracer::getInstance();
+    tracer.configure(1, 2);
+    const auto now = wolkabout::Tracer::Clock::now();
+    tracer.record("first", 1, now, now);
+    tracer.record("second", 1, now, now);
+
+    // When
+    tracer.record("third", 1, now, now);
+    ASSERT_TRUE(tracer.dump(traceFile));
+
+    // Then
+    const auto trace = read(traceFile);
+    std::remove(traceFile.c_str());
+    ASSERT_EQ(trace.find("first"), std::string::npos);
+    ASSERT_LT(trace.find("second"), trace.find("third"));
+}
+
+TEST_F(Tracer, Given_BoundMessage_When_Taken_Then_TraceIsHandedOverOnce)
+{
+    // Given
+    auto& tracer = wolkabout::Tracer::getInstance();
+    tracer.configure(1);
+    const wolkabout::Message message{"content", "channel"};
+    tracer.bind(message, 7);
+
+    // When
+    wolkabout::Tracer::Clock::time_point boundAt;
+    const auto traceId = tracer.take(message, boundAt);
+
+    // Then
+    ASSERT_EQ(traceId, 7u);
+    ASSERT_LE(boundAt, wolkabout::Tracer::Clock::now());
+    ASSERT_EQ(tracer.take(message, boundAt), 0u);
+}
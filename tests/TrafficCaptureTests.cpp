@@ -0,0 +1,125 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "utilities/TrafficCapture.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+
+namespace
+{
+class TrafficCapture : public ::testing::Test
+{
+public:
+    void TearDown() override { std::remove(CAPTURE_PATH); }
+
+    static constexpr const char* CAPTURE_PATH = "./trafficCaptureTest.wgtc";
+};
+}    // namespace
+
+TEST_F(TrafficCapture, Given_RecordedMessages_When_Read_Then_RecordsAreReturnedInOrder)
+{
+    // Given
+    {
+        wolkabout::TrafficCaptureWriter writer{CAPTURE_PATH};
+        ASSERT_TRUE(writer.isOpen());
+
+        writer.record(wolkabout::TrafficCapture::Side::DEVICE, "d2p/sensor_reading/d/device1/r/T", "{\"data\":\"1\"}");
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        writer.record(wolkabout::TrafficCapture::Side::PLATFORM, "p2d/actuator_set/g/gateway/d/device1/r/SW",
+                      "{\"value\":\"true\"}");
+        writer.record(wolkabout::TrafficCapture::Side::DEVICE, "d2p/sensor_reading/d/device1/r/T", "");
+
+        ASSERT_EQ(writer.getRecordCount(), 3u);
+    }
+
+    // When
+    wolkabout::TrafficCaptureReader reader{CAPTURE_PATH};
+    wolkabout::TrafficCapture::Record first, second, third, end;
+
+    // Then
+    ASSERT_TRUE(reader.isValid());
+    ASSERT_TRUE(reader.next(first));
+    ASSERT_TRUE(reader.next(second));
+    ASSERT_TRUE(reader.next(third));
+    ASSERT_FALSE(reader.next(end));
+
+    ASSERT_EQ(first.side, wolkabout::TrafficCapture::Side::DEVICE);
+    ASSERT_EQ(first.channel, "d2p/sensor_reading/d/device1/r/T");
+    ASSERT_EQ(first.payload, "{\"data\":\"1\"}");
+
+    ASSERT_EQ(second.side, wolkabout::TrafficCapture::Side::PLATFORM);
+    ASSERT_EQ(second.channel, "p2d/actuator_set/g/gateway/d/device1/r/SW");
+    ASSERT_EQ(second.payload, "{\"value\":\"true\"}");
+    ASSERT_GE((second.offset - first.offset).count(), 5000);
+
+    ASSERT_EQ(third.channel, first.channel);
+    ASSERT_TRUE(third.payload.empty());
+    ASSERT_GE(third.offset, second.offset);
+}
+
+TEST_F(TrafficCapture, Given_TruncatedCapture_When_Read_Then_CompleteRecordsAreReturned)
+{
+    // Given
+    {
+        wolkabout::TrafficCaptureWriter writer{CAPTURE_PATH};
+        writer.record(wolkabout::TrafficCapture::Side::DEVICE, "d2p/events/d/device1/r/A", "first");
+        writer.record(wolkabout::TrafficCapture::Side::DEVICE, "d2p/events/d/device1/r/A", "second");
+    }
+
+    std::string content;
+    {
+        std::ifstream file{CAPTURE_PATH, std::ios::binary};
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    {
+        std::ofstream file{CAPTURE_PATH, std::ios::binary | std::ios::trunc};
+        file.write(content.data(), static_cast<std::streamsize>(content.size() - 2));
+    }
+
+    // When
+    wolkabout::TrafficCaptureReader reader{CAPTURE_PATH};
+    wolkabout::TrafficCapture::Record record;
+
+    // Then
+    ASSERT_TRUE(reader.isValid());
+    ASSERT_TRUE(reader.next(record));
+    ASSERT_EQ(record.payload, "first");
+    ASSERT_FALSE(reader.next(record));
+}
+
+TEST_F(TrafficCapture, Given_FileWithoutMagic_When_Opened_Then_ReaderIsNotValid)
+{
+    // Given
+    {
+        std::ofstream file{CAPTURE_PATH, std::ios::binary | std::ios::trunc};
+        file << "not a capture";
+    }
+
+    // When
+    wolkabout::TrafficCaptureReader reader{CAPTURE_PATH};
+    wolkabout::TrafficCapture::Record record;
+
+    // Then
+    ASSERT_FALSE(reader.isValid());
+    ASSERT_FALSE(reader.next(record));
+}
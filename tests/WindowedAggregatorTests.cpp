@@ -0,0 +1,140 @@
+#include "service/WindowedAggregator.h"
+#include "utilities/Executor.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+class WindowedAggregator : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        aggregator.reset(new wolkabout::WindowedAggregator(executor));
+        aggregator->setListener([this](const std::string& deviceKey, const std::string& channel,
+                                       const std::string& payload) {
+            std::lock_guard<std::mutex> lg{lock};
+            // time of close is not deterministic, only data is compared
+            readings.push_back(deviceKey + " " + channel + " " + payload.substr(payload.find("\"data\"")));
+            condition.notify_all();
+        });
+    }
+
+    void TearDown() override
+    {
+        aggregator.reset();
+        std::remove(RULE_FILE_PATH);
+    }
+
+    void loadRules(const std::string& rules)
+    {
+        {
+            std::ofstream file{RULE_FILE_PATH};
+            file << rules;
+        }
+
+        ASSERT_TRUE(aggregator->loadRules(RULE_FILE_PATH));
+    }
+
+    std::vector<std::string> waitForReadings(std::size_t count)
+    {
+        std::unique_lock<std::mutex> ul{lock};
+        condition.wait_for(ul, std::chrono::seconds{2}, [&] { return readings.size() >= count; });
+        return readings;
+    }
+
+    wolkabout::Executor executor{1};
+    std::unique_ptr<wolkabout::WindowedAggregator> aggregator;
+
+    std::mutex lock;
+    std::condition_variable condition;
+    std::vector<std::string> readings;
+
+    static constexpr const char* RULE_FILE_PATH = "testsWindowedAggregationRules.txt";
+    static constexpr const char* CHANNEL = "d2p/sensor_reading/d/DEVICE_KEY/r/VIB";
+};
+}    // namespace
+
+TEST_F(WindowedAggregator, Given_Rule_When_WindowIsFlushed_Then_StatisticsArePublished)
+{
+    // Given
+    loadRules("# device reference window statistics\n"
+              "* VIB 60000 min=VIB_MIN max=VIB_MAX avg=VIB rms=VIB_RMS\n");
+
+    // When
+    for (int i = 0; i < 100; ++i)
+    {
+        ASSERT_TRUE(aggregator->accept("DEVICE_KEY", "VIB", CHANNEL,
+                                       "{\"utc\":1,\"data\":\"" + std::to_string(i % 2 ? 3 : -3) + "," +
+                                         std::to_string(i) + "\"}"));
+    }
+    ASSERT_TRUE(aggregator->accept("DEVICE_KEY", "VIB", CHANNEL, "[{\"data\":\"3,100\"},{\"data\":\"-3,101\"}]"));
+    aggregator->flush();
+
+    // Then
+    ASSERT_EQ(waitForReadings(4),
+              (std::vector<std::string>{"DEVICE_KEY d2p/sensor_reading/d/DEVICE_KEY/r/VIB_MIN \"data\":\"-3,0\"}",
+                                        "DEVICE_KEY d2p/sensor_reading/d/DEVICE_KEY/r/VIB_MAX \"data\":\"3,101\"}",
+                                        "DEVICE_KEY d2p/sensor_reading/d/DEVICE_KEY/r/VIB \"data\":\"0,50.5\"}",
+                                        "DEVICE_KEY d2p/sensor_reading/d/DEVICE_KEY/r/VIB_RMS \"data\":\"3,"
+                                        "58.456536560650484\"}"}));
+}
+
+TEST_F(WindowedAggregator, Given_Rule_When_WindowElapses_Then_StatisticsArePublished)
+{
+    // Given
+    loadRules("DEVICE_KEY VIB 20 max=VIB_MAX\n");
+    ASSERT_TRUE(aggregator->accept("DEVICE_KEY", "VIB", CHANNEL, "{\"data\":\"1\"}"));
+    ASSERT_TRUE(aggregator->accept("DEVICE_KEY", "VIB", CHANNEL, "{\"data\":\"2.5\"}"));
+
+    // When
+    const auto published = waitForReadings(1);
+
+    // Then
+    ASSERT_EQ(published,
+              (std::vector<std::string>{"DEVICE_KEY d2p/sensor_reading/d/DEVICE_KEY/r/VIB_MAX \"data\":\"2.5\"}"}));
+
+    ASSERT_TRUE(aggregator->accept("DEVICE_KEY", "VIB", CHANNEL, "{\"data\":\"7\"}"));
+    ASSERT_EQ(waitForReadings(2).back(), "DEVICE_KEY d2p/sensor_reading/d/DEVICE_KEY/r/VIB_MAX \"data\":\"7\"}");
+}
+
+TEST_F(WindowedAggregator, Given_Rule_When_ReadingHasNoRuleOrIsNotNumeric_Then_ReadingIsNotAggregated)
+{
+    // Given
+    loadRules("OTHER_KEY VIB 1000 avg=VIB\n"
+              "* T 1000 avg=T\n");
+
+    // Then
+    ASSERT_FALSE(aggregator->accept("DEVICE_KEY", "VIB", CHANNEL, "{\"data\":\"1\"}"));
+    ASSERT_FALSE(aggregator->accept("DEVICE_KEY", "T", "d2p/sensor_reading/d/DEVICE_KEY/r/T", "{\"data\":\"ON\"}"));
+    ASSERT_FALSE(aggregator->accept("DEVICE_KEY", "T", "d2p/sensor_reading/d/DEVICE_KEY/r/T", "{\"utc\":1}"));
+    ASSERT_FALSE(aggregator->accept("DEVICE_KEY", "T", "d2p/sensor_reading/d/DEVICE_KEY/r/T",
+                                    "[{\"data\":\"1,2\"},{\"data\":\"1\"}]"));
+
+    aggregator->flush();
+    ASSERT_TRUE(readings.empty());
+}
+
+TEST_F(WindowedAggregator, Given_InvalidRuleFile_When_Loaded_Then_LoadingFails)
+{
+    for (const std::string line : {"* VIB 1000\n", "* VIB 0 avg=VIB\n", "* VIB 1000 median=VIB\n", "* VIB 1000 avg=\n",
+                                    "* VIB 1000 avg=A/B\n"})
+    {
+        {
+            std::ofstream file{RULE_FILE_PATH};
+            file << line;
+        }
+
+        ASSERT_FALSE(aggregator->loadRules(RULE_FILE_PATH)) << line;
+    }
+
+    ASSERT_FALSE(aggregator->loadRules("tests/missing/rules.txt"));
+}
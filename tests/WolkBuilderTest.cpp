@@ -8,6 +8,7 @@
 #include "model/SubdeviceManagement.h"
 
 #include <gtest/gtest.h>
+#include <stdexcept>
 
 namespace
 {
@@ -50,3 +51,17 @@ TEST_F(WolkBuilder, GivenPlatformManagesSubdevices_When_ConstructingWolkInstance
     // Then
     ASSERT_EQ(nullptr, wolk->m_subdeviceRegistrationService);
 }
+
+TEST_F(WolkBuilder, GivenPerformanceProfileWithoutPacketData_When_ConstructingWolkInstance_Then_ExceptionIsThrown)
+{
+    // Given
+    wolkabout::GatewayDevice device(GATEWAY_KEY, GATEWAY_PASSWORD, wolkabout::SubdeviceManagement::GATEWAY);
+    auto profile = wolkabout::PerformanceProfile::constrainedEdge();
+    profile.maxFilePacketSize = 64;
+
+    wolkabout::WolkBuilder builder = wolkabout::Wolk::newBuilder(device);
+    builder.performanceProfile(profile);
+
+    // Then
+    ASSERT_THROW(builder.build(), std::logic_error);
+}
@@ -39,6 +39,8 @@
 #include "service/KeepAliveService.h"
 #include "service/PublishingService.h"
 #include "service/SubdeviceRegistrationService.h"
+#include "utilities/Executor.h"
+#include "utilities/ReconnectScheduler.h"
 
 #include <memory>
 #include <protocol/json/JsonStatusProtocol.h>
@@ -135,10 +137,17 @@ public:
 
         wolk = std::unique_ptr<wolkabout::Wolk>(
           new wolkabout::Wolk(wolkabout::GatewayDevice{GATEWAY_KEY, "password", control, true, true}));
+        wolk->m_executor.reset(new wolkabout::Executor());
         wolk->m_platformConnectivityService.reset(platformConnectivityService);
         wolk->m_deviceConnectivityService.reset(deviceConnectivityService);
         wolk->m_platformPublisher.reset(new Publisher(*platformConnectivityService, nullptr));
         wolk->m_devicePublisher.reset(new Publisher(*deviceConnectivityService, nullptr));
+        wolk->m_platformReconnectScheduler.reset(new wolkabout::ReconnectScheduler(
+          *wolk->m_executor, [this] { return wolk->m_platformConnectivityService->connect(); },
+          [this] { wolk->platformConnected(); }, "platform"));
+        wolk->m_deviceReconnectScheduler.reset(new wolkabout::ReconnectScheduler(
+          *wolk->m_executor, [this] { return wolk->m_deviceConnectivityService->connect(); },
+          [this] { wolk->devicesConnected(); }, "devices"));
         wolk->m_inboundPlatformMessageHandler.reset(new GatewayInboundPlatformMessageHandler());
         wolk->m_inboundDeviceMessageHandler.reset(new GatewayInboundDeviceMessageHandler());
 
@@ -163,17 +172,20 @@ public:
                               *wolk->m_platformPublisher, *wolk->m_devicePublisher);
         wolk->m_dataService.reset(dataService);
 
-        gatewayUpdateService = new MockGatewayUpdateService(GATEWAY_KEY, *deviceRegistrationProtocol,
-                                                            *wolk->m_deviceRepository, *wolk->m_platformPublisher);
+        gatewayUpdateService =
+          new MockGatewayUpdateService(GATEWAY_KEY, *deviceRegistrationProtocol, *wolk->m_deviceRepository,
+                                       *wolk->m_platformPublisher, *wolk->m_executor);
         wolk->m_gatewayUpdateService.reset(gatewayUpdateService);
 
-        fileDownloadService = new MockFileDownloadService(GATEWAY_KEY, *fileDownloadProtocol, "",
-                                                          *wolk->m_platformPublisher, *wolk->m_fileRepository);
+        fileDownloadService =
+          new MockFileDownloadService(GATEWAY_KEY, *fileDownloadProtocol, "", *wolk->m_platformPublisher,
+                                      *wolk->m_fileRepository, *wolk->m_executor);
         wolk->m_fileDownloadService.reset(fileDownloadService);
 
         firmwareUpdateService =
           new MockFirmwareUpdateService(GATEWAY_KEY, *firmwareUpdateProtocol, *gatewayFirmwareUpdateProtocol,
-                                        *wolk->m_fileRepository, *wolk->m_platformPublisher, *wolk->m_devicePublisher);
+                                        *wolk->m_fileRepository, *wolk->m_platformPublisher, *wolk->m_devicePublisher,
+                                        *wolk->m_executor);
         wolk->m_firmwareUpdateService.reset(firmwareUpdateService);
 
         keepAliveService =
@@ -182,7 +194,7 @@ public:
 
         subdeviceRegistrationService = new MockSubdeviceRegistrationService(
           GATEWAY_KEY, *deviceRegistrationProtocol, *gatewayRegistrationProtocol, *wolk->m_deviceRepository,
-          *wolk->m_platformPublisher, *wolk->m_devicePublisher);
+          *wolk->m_platformPublisher, *wolk->m_devicePublisher, *wolk->m_executor);
         wolk->m_subdeviceRegistrationService.reset(subdeviceRegistrationService);
     }
 
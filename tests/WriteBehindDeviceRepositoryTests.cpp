@@ -0,0 +1,155 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "model/DetailedDevice.h"
+#include "model/DeviceReferences.h"
+#include "model/DeviceTemplate.h"
+#include "model/SensorTemplate.h"
+#include "repository/SQLiteDeviceRepository.h"
+#include "repository/WriteBehindDeviceRepository.h"
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class WriteBehindDeviceRepository : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        deviceRepository =
+          std::unique_ptr<wolkabout::WriteBehindDeviceRepository>(new wolkabout::WriteBehindDeviceRepository(
+            std::unique_ptr<wolkabout::DeviceRepository>(new wolkabout::SQLiteDeviceRepository(DEVICE_REPOSITORY_PATH)),
+            COMMIT_DELAY));
+    }
+
+    void TearDown() override
+    {
+        deviceRepository.reset();
+        remove(DEVICE_REPOSITORY_PATH);
+    }
+
+    static wolkabout::DetailedDevice makeDevice(const std::string& deviceKey)
+    {
+        wolkabout::DeviceTemplate deviceTemplate;
+        deviceTemplate.addSensor(
+          wolkabout::SensorTemplate("Temperature", "T", wolkabout::DataType::NUMERIC, "", {0}, {100}));
+        return wolkabout::DetailedDevice("Device name", deviceKey, deviceTemplate);
+    }
+
+    static std::unique_ptr<wolkabout::DetailedDevice> readCommitted(const std::string& deviceKey)
+    {
+        wolkabout::SQLiteDeviceRepository committed{DEVICE_REPOSITORY_PATH};
+        return committed.findByDeviceKey(deviceKey);
+    }
+
+    std::vector<std::string> sortedDeviceKeys()
+    {
+        auto deviceKeys = *deviceRepository->findAllDeviceKeys();
+        std::sort(deviceKeys.begin(), deviceKeys.end());
+        return deviceKeys;
+    }
+
+    std::unique_ptr<wolkabout::WriteBehindDeviceRepository> deviceRepository;
+
+    static constexpr const char* DEVICE_REPOSITORY_PATH = "testsWriteBehindDeviceRepository.db";
+
+    // long enough that nothing is committed during a test unless flushed
+    const std::chrono::milliseconds COMMIT_DELAY{60000};
+};
+}    // namespace
+
+TEST_F(WriteBehindDeviceRepository, Given_QueuedSave_When_DeviceIsLookedUp_Then_QueuedDeviceIsReturned)
+{
+    // Given
+    deviceRepository->save(makeDevice("DEVICE_1"));
+
+    // When
+    auto device = deviceRepository->findByDeviceKey("DEVICE_1");
+
+    // Then
+    ASSERT_NE(device, nullptr);
+    ASSERT_EQ(device->getName(), "Device name");
+    ASSERT_TRUE(deviceRepository->containsDeviceWithKey("DEVICE_1"));
+
+    auto references = deviceRepository->findReferencesByDeviceKey("DEVICE_1");
+    ASSERT_NE(references, nullptr);
+    ASSERT_TRUE(references->hasSensor("T"));
+
+    ASSERT_EQ(sortedDeviceKeys(), (std::vector<std::string>{"DEVICE_1"}));
+    ASSERT_EQ(readCommitted("DEVICE_1"), nullptr);
+}
+
+TEST_F(WriteBehindDeviceRepository, Given_CommittedDevice_When_RemovalIsQueued_Then_DeviceIsNoLongerFound)
+{
+    // Given
+    deviceRepository->save(makeDevice("DEVICE_1"));
+    deviceRepository->save(makeDevice("DEVICE_2"));
+    deviceRepository->flush();
+
+    // When
+    deviceRepository->remove("DEVICE_1");
+
+    // Then
+    ASSERT_EQ(deviceRepository->findByDeviceKey("DEVICE_1"), nullptr);
+    ASSERT_EQ(deviceRepository->findReferencesByDeviceKey("DEVICE_1"), nullptr);
+    ASSERT_FALSE(deviceRepository->containsDeviceWithKey("DEVICE_1"));
+    ASSERT_TRUE(deviceRepository->findTemplateHash("DEVICE_1").empty());
+    ASSERT_EQ(sortedDeviceKeys(), (std::vector<std::string>{"DEVICE_2"}));
+    ASSERT_NE(readCommitted("DEVICE_1"), nullptr);
+}
+
+TEST_F(WriteBehindDeviceRepository, Given_CommittedDevice_When_SavedAgain_Then_KeyIsListedOnce)
+{
+    // Given
+    deviceRepository->save(makeDevice("DEVICE_1"));
+    deviceRepository->save(makeDevice("DEVICE_2"));
+    deviceRepository->flush();
+
+    // When
+    deviceRepository->save(makeDevice("DEVICE_2"));
+    deviceRepository->save(makeDevice("DEVICE_3"));
+
+    // Then
+    ASSERT_EQ(sortedDeviceKeys(), (std::vector<std::string>{"DEVICE_1", "DEVICE_2", "DEVICE_3"}));
+
+    deviceRepository->flush();
+    ASSERT_EQ(sortedDeviceKeys(), (std::vector<std::string>{"DEVICE_1", "DEVICE_2", "DEVICE_3"}));
+}
+
+TEST_F(WriteBehindDeviceRepository, Given_QueuedAndCommittedDevices_When_AllAreRemoved_Then_NoDeviceIsFound)
+{
+    // Given
+    deviceRepository->save(makeDevice("DEVICE_1"));
+    deviceRepository->flush();
+    deviceRepository->save(makeDevice("DEVICE_2"));
+
+    // When
+    deviceRepository->removeAll();
+
+    // Then
+    ASSERT_EQ(deviceRepository->findByDeviceKey("DEVICE_1"), nullptr);
+    ASSERT_EQ(deviceRepository->findByDeviceKey("DEVICE_2"), nullptr);
+    ASSERT_TRUE(deviceRepository->findAllDeviceKeys()->empty());
+    ASSERT_EQ(readCommitted("DEVICE_1"), nullptr);
+    ASSERT_EQ(readCommitted("DEVICE_2"), nullptr);
+}
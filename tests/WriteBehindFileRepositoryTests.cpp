@@ -0,0 +1,137 @@
+/*
+ * Copyright 2019 WolkAbout Technology s.r.o.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "repository/SQLiteFileRepository.h"
+#include "repository/WriteBehindFileRepository.h"
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+class WriteBehindFileRepository : public ::testing::Test
+{
+public:
+    void SetUp() override
+    {
+        fileRepository = std::unique_ptr<wolkabout::WriteBehindFileRepository>(new wolkabout::WriteBehindFileRepository(
+          std::unique_ptr<wolkabout::FileRepository>(new wolkabout::SQLiteFileRepository(FILE_REPOSITORY_PATH)),
+          COMMIT_DELAY));
+    }
+
+    void TearDown() override
+    {
+        fileRepository.reset();
+        remove(FILE_REPOSITORY_PATH);
+    }
+
+    static std::unique_ptr<wolkabout::FileInfo> readCommitted(const std::string& fileName)
+    {
+        wolkabout::SQLiteFileRepository committed{FILE_REPOSITORY_PATH};
+        return committed.getFileInfo(fileName);
+    }
+
+    std::unique_ptr<wolkabout::WriteBehindFileRepository> fileRepository;
+
+    static constexpr const char* FILE_REPOSITORY_PATH = "testsWriteBehindFileRepository.db";
+
+    // long enough that nothing is committed during a test unless flushed
+    const std::chrono::milliseconds COMMIT_DELAY{60000};
+};
+}    // namespace
+
+TEST_F(WriteBehindFileRepository, Given_QueuedStore_When_FileIsLookedUp_Then_QueuedInfoIsReturned)
+{
+    // Given
+    fileRepository->store(wolkabout::FileInfo{"firmware.bin", "hash", "./firmware.bin"});
+
+    // When
+    auto info = fileRepository->getFileInfo("firmware.bin");
+
+    // Then
+    ASSERT_NE(info, nullptr);
+    ASSERT_EQ(info->path, "./firmware.bin");
+    ASSERT_TRUE(fileRepository->containsInfoForFile("firmware.bin"));
+    ASSERT_EQ(*fileRepository->getAllFileNames(), (std::vector<std::string>{"firmware.bin"}));
+    ASSERT_EQ(readCommitted("firmware.bin"), nullptr);
+}
+
+TEST_F(WriteBehindFileRepository, Given_CommittedFile_When_RemovalIsQueued_Then_FileIsNoLongerFound)
+{
+    // Given
+    fileRepository->store(wolkabout::FileInfo{"first", "hash1", "./first"});
+    fileRepository->store(wolkabout::FileInfo{"second", "hash2", "./second"});
+    fileRepository->flush();
+
+    // When
+    fileRepository->remove("first");
+
+    // Then
+    ASSERT_EQ(fileRepository->getFileInfo("first"), nullptr);
+    ASSERT_FALSE(fileRepository->containsInfoForFile("first"));
+    ASSERT_EQ(*fileRepository->getAllFileNames(), (std::vector<std::string>{"second"}));
+    ASSERT_NE(readCommitted("first"), nullptr);
+}
+
+TEST_F(WriteBehindFileRepository, Given_FileStoredSeveralTimes_When_Flushed_Then_LatestInfoIsCommitted)
+{
+    // Given
+    fileRepository->store(wolkabout::FileInfo{"firmware.bin", "hash1", "./v1/firmware.bin"});
+    fileRepository->store(wolkabout::FileInfo{"firmware.bin", "hash2", "./v2/firmware.bin"});
+
+    // When
+    fileRepository->flush();
+
+    // Then
+    auto info = readCommitted("firmware.bin");
+    ASSERT_NE(info, nullptr);
+    ASSERT_EQ(info->hash, "hash2");
+    ASSERT_EQ(info->path, "./v2/firmware.bin");
+}
+
+TEST_F(WriteBehindFileRepository, Given_QueuedWrites_When_RepositoryIsDestroyed_Then_WritesAreCommitted)
+{
+    // Given
+    fileRepository->store(wolkabout::FileInfo{"first", "hash1", "./first"});
+    fileRepository->store(wolkabout::FileInfo{"second", "hash2", "./second"});
+    fileRepository->remove("second");
+
+    // When
+    fileRepository.reset();
+
+    // Then
+    ASSERT_NE(readCommitted("first"), nullptr);
+    ASSERT_EQ(readCommitted("second"), nullptr);
+}
+
+TEST_F(WriteBehindFileRepository, Given_QueuedStore_When_FileIsLookedUpByHash_Then_StoreIsCommittedFirst)
+{
+    // Given
+    fileRepository->store(wolkabout::FileInfo{"firmware.bin", "hash", "./firmware.bin"});
+
+    // When
+    auto info = fileRepository->getFileInfoByHash("hash");
+
+    // Then
+    ASSERT_NE(info, nullptr);
+    ASSERT_EQ(info->name, "firmware.bin");
+    ASSERT_NE(readCommitted("firmware.bin"), nullptr);
+}